@@ -0,0 +1,53 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef BENCHMARK_PLAYER_HPP
+#define BENCHMARK_PLAYER_HPP
+
+#include "LongTimeAction.hpp"
+#include "Player.hpp"
+#include "World.hpp"
+#include "netinterface/NetInterface.hpp"
+
+#include <ctime>
+#include <memory>
+#include <string>
+
+// a logged in player without database and socket, what is sent to it goes to the sink of its connection
+class BenchmarkPlayer : public Player {
+public:
+    BenchmarkPlayer(TYPE_OF_CHARACTER_ID id, const position &pos, std::shared_ptr<NetInterface> connection) {
+        setId(id);
+        setName("bot " + std::to_string(id));
+        setAlive(true);
+        setPosition(pos);
+        Connection = std::move(connection);
+        ltAction = std::make_unique<LongTimeAction>(this, World::get());
+        keepAlive();
+    }
+
+    // what the keep alive command of the client does, it also holds off saving
+    void keepAlive() {
+        time(&lastkeepalive);
+        lastsavetime = lastkeepalive;
+    }
+
+    [[nodiscard]] auto to_string() const -> std::string override { return getName(); }
+};
+
+#endif
@@ -0,0 +1,111 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BenchmarkWorld.hpp"
+#include "Character.hpp"
+#include "CharacterContainer.hpp"
+
+#include <benchmark/benchmark.h>
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr Coordinate areaSize = 1000;
+
+class BenchmarkCharacter : public Character {
+public:
+    BenchmarkCharacter(TYPE_OF_CHARACTER_ID id, const position &pos) : id(id), pos(pos) {}
+
+    [[nodiscard]] auto getId() const -> TYPE_OF_CHARACTER_ID override { return id; }
+    [[nodiscard]] auto getType() const -> unsigned short override { return monster; }
+    [[nodiscard]] auto getPosition() const -> const position & override { return pos; }
+    [[nodiscard]] auto to_string() const -> std::string override { return "benchmark character"; }
+
+private:
+    TYPE_OF_CHARACTER_ID id;
+    position pos;
+};
+
+// the given number of characters spread over a square of areaSize fields on one level
+class Population {
+public:
+    explicit Population(size_t count) {
+        std::mt19937 random(count);
+        std::uniform_int_distribution<Coordinate> coordinate(0, areaSize - 1);
+
+        for (size_t i = 0; i < count; ++i) {
+            characters.emplace_back(static_cast<TYPE_OF_CHARACTER_ID>(i + 1),
+                                    position(coordinate(random), coordinate(random), 0));
+            container.insert(&characters.back());
+        }
+    }
+
+    CharacterContainer<Character> container;
+
+private:
+    BenchmarkWorld world;
+    std::deque<BenchmarkCharacter> characters;
+};
+
+void rangeQuery(benchmark::State &state) {
+    Population population(static_cast<size_t>(state.range(0)));
+    const Range range{static_cast<Coordinate>(state.range(1))};
+    std::mt19937 random(0);
+    std::uniform_int_distribution<Coordinate> coordinate(0, areaSize - 1);
+    std::vector<Character *> found;
+
+    for (auto _ : state) {
+        found.clear();
+        population.container.findAllCharactersInRangeOf(position(coordinate(random), coordinate(random), 0), range,
+                                                        found);
+        benchmark::DoNotOptimize(found.data());
+    }
+}
+
+void screenQuery(benchmark::State &state) {
+    Population population(static_cast<size_t>(state.range(0)));
+    std::mt19937 random(0);
+    std::uniform_int_distribution<Coordinate> coordinate(0, areaSize - 1);
+    std::vector<Character *> found;
+
+    for (auto _ : state) {
+        found.clear();
+        population.container.findAllCharactersInScreen(position(coordinate(random), coordinate(random), 0), found);
+        benchmark::DoNotOptimize(found.data());
+    }
+}
+
+void findById(benchmark::State &state) {
+    const auto count = static_cast<TYPE_OF_CHARACTER_ID>(state.range(0));
+    Population population(count);
+    TYPE_OF_CHARACTER_ID id = 0;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(population.container.find(id % count + 1));
+        ++id;
+    }
+}
+
+} // namespace
+
+// characters on the area and radius of the query
+BENCHMARK(rangeQuery)->ArgsProduct({{100, 1000, 10000, 100000}, {2, 8, 20}});
+BENCHMARK(screenQuery)->Arg(100)->Arg(1000)->Arg(10000)->Arg(100000);
+BENCHMARK(findById)->Arg(1000)->Arg(100000);
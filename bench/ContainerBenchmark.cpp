@@ -0,0 +1,92 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BenchmarkWorld.hpp"
+#include "Container.hpp"
+#include "Item.hpp"
+
+#include <benchmark/benchmark.h>
+#include <vector>
+
+namespace {
+
+constexpr TYPE_OF_CONTAINERSLOTS slots = 100;
+constexpr Item::id_type firstItem = 100;
+
+class BenchmarkContainer : public Container {
+public:
+    BenchmarkContainer() : Container(0) {}
+
+    [[nodiscard]] auto getSlotCount() const -> TYPE_OF_CONTAINERSLOTS override { return slots; }
+};
+
+// fills the container with the given number of stacks of different items
+void fill(BenchmarkContainer &container, int64_t stacks) {
+    for (int64_t i = 0; i < stacks; ++i) {
+        container.InsertItem(Item(static_cast<Item::id_type>(firstItem + i), 1, 0), false);
+    }
+}
+
+void countItemCached(benchmark::State &state) {
+    const BenchmarkWorld world;
+    BenchmarkContainer container;
+    fill(container, state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(container.countItem(firstItem));
+    }
+}
+
+// each count follows a change of the content, so the totals are rebuilt
+void countItemAfterChange(benchmark::State &state) {
+    const BenchmarkWorld world;
+    BenchmarkContainer container;
+    fill(container, state.range(0));
+
+    for (auto _ : state) {
+        container.increaseAtPos(0, 0);
+        benchmark::DoNotOptimize(container.countItem(firstItem));
+    }
+}
+
+void copyItems(benchmark::State &state) {
+    std::vector<Item> items;
+
+    for (Item::id_type id = 0; id < slots; ++id) {
+        items.emplace_back(id, 1, 0);
+
+        if (state.range(0) != 0) {
+            items.back().setData("description", "a benchmark item with data");
+        }
+    }
+
+    for (auto _ : state) {
+        std::vector<Item> copy(items);
+        benchmark::DoNotOptimize(copy.data());
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * slots);
+}
+
+} // namespace
+
+// stacks in the container
+BENCHMARK(countItemCached)->Arg(10)->Arg(100);
+BENCHMARK(countItemAfterChange)->Arg(10)->Arg(100);
+// whether the items carry data
+BENCHMARK(copyItems)->Arg(0)->Arg(1);
@@ -0,0 +1,531 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BenchmarkPlayer.hpp"
+#include "BenchmarkWorld.hpp"
+#include "Config.hpp"
+#include "MonitoringClients.hpp"
+#include "PlayerSnapshot.hpp"
+#include "constants.hpp"
+#include "data/Data.hpp"
+#include "db/ConnectionManager.hpp"
+#include "db/PreparedQuery.hpp"
+#include "db/SchemaHelper.hpp"
+
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Times the save and load paths of players against the database of the server configuration ILLARION_CONFIG, which
+// has to be a disposable instance set up from setup/illarion.sql. The benchmark replaces its own account there by
+// ILLARION_DB_CHARACTERS characters (default 200) with inventories, depots, skills and effects, and adds the items,
+// skills and effects they refer to unless they exist. Each thread works on its own share of the characters.
+
+namespace {
+
+using Database::PreparedQuery;
+
+// the account and characters of the benchmark take the ids from here on
+constexpr TYPE_OF_CHARACTER_ID firstId = 1'900'000'000;
+constexpr TYPE_OF_CHARACTER_ID defaultCharacters = 200;
+
+constexpr TYPE_OF_ITEM_ID bag = 60000;
+constexpr TYPE_OF_ITEM_ID itemKinds = 200;
+constexpr TYPE_OF_CONTAINERSLOTS containerSlots = 100;
+constexpr TYPE_OF_SKILL_ID firstSkill = 200;
+constexpr int skillCount = 40;
+constexpr uint16_t firstEffect = 30000;
+constexpr int effectCount = 8;
+constexpr int effectValues = 4;
+
+// line 1 is the backpack, its contents follow the body, then the depots with a bag each
+constexpr int bodyLines = MAX_BODY_ITEMS + MAX_BELT_SLOTS;
+constexpr int backpackItems = 40;
+constexpr uint32_t firstDepot = 1;
+constexpr int depots = 3;
+constexpr int depotItems = 60;
+constexpr int depotBagItems = 30;
+constexpr int firstDepotLine = bodyLines + backpackItems + 1;
+constexpr int depotLines = depotItems + depotBagItems;
+
+const position nowhere(0, 0, 0);
+
+auto characterCount() -> TYPE_OF_CHARACTER_ID {
+    const char *characters = std::getenv("ILLARION_DB_CHARACTERS");
+    return characters != nullptr ? std::stoul(characters) : defaultCharacters;
+}
+
+template <typename... Args>
+void execute(const Database::PConnection &connection, const std::string &name, const std::string &statement,
+             const Args &...args) {
+    const PreparedQuery query("benchmark_" + name, statement);
+    query.execute(connection, args...);
+}
+
+// rows the characters refer to, left alone where they exist
+void generateReferences(const Database::PConnection &connection) {
+    using std::to_string;
+    const auto series = [](int first, int last) {
+        return " FROM generate_series(" + to_string(first) + ", " + to_string(last) + ") id";
+    };
+
+    execute(connection, "races",
+            "INSERT INTO {server}.race_types (rt_race_id, rt_type_id) VALUES (0, 0) ON CONFLICT DO NOTHING");
+    execute(connection, "items",
+            "INSERT INTO {server}.items (itm_id, itm_volume, itm_weight, itm_objectafterrot, itm_maxstack, itm_name) "
+            "SELECT id, 100, 50, id, 250, 'benchmarkItem'" +
+                    series(bag, bag + itemKinds) + " UNION ALL SELECT " + to_string(DEPOTITEM) + ", 0, 0, " +
+                    to_string(DEPOTITEM) + ", 1, 'depot' ON CONFLICT DO NOTHING");
+    execute(connection, "containers",
+            "INSERT INTO {server}.container (con_itemid, con_slots) VALUES (" + to_string(bag) + ", " +
+                    to_string(containerSlots) + "), (" + to_string(DEPOTITEM) + ", " + to_string(containerSlots) +
+                    ") ON CONFLICT DO NOTHING");
+    execute(connection, "skill_groups",
+            "INSERT INTO {server}.skillgroups (skg_group_id, skg_name_german, skg_name_english) VALUES (" +
+                    to_string(firstSkill) + ", 'Benchmark', 'Benchmark') ON CONFLICT DO NOTHING");
+    execute(connection, "skills",
+            "INSERT INTO {server}.skills (skl_skill_id, skl_group_id, skl_name, skl_name_german, skl_name_english) "
+            "SELECT id, " +
+                    to_string(firstSkill) + ", 'bench' || id, 'Benchmark ' || id, 'Benchmark ' || id" +
+                    series(firstSkill, firstSkill + skillCount - 1) + " ON CONFLICT DO NOTHING");
+    execute(connection, "effects",
+            "INSERT INTO {server}.longtimeeffects (lte_effectid, lte_effectname, lte_scriptname) "
+            "SELECT id, 'benchmark' || id, 'benchmark'" +
+                    series(firstEffect, firstEffect + effectCount - 1) + " ON CONFLICT DO NOTHING");
+}
+
+// the characters and everything they own go with the account, which is replaced
+void generateCharacters(const Database::PConnection &connection, TYPE_OF_CHARACTER_ID characters) {
+    using std::to_string;
+    const auto &accounts = Database::SchemaHelper::getAccountSchema();
+    // $1 is the first id, n counts the characters from 0
+    const std::string playerId = "$1::integer + n";
+    const std::string players = " FROM generate_series(0, $2::integer - 1) n";
+    const auto series = [](const std::string &name, int first, int last) {
+        return ", generate_series(" + to_string(first) + ", " + to_string(last) + ") " + name;
+    };
+    const auto item = [](const std::string &line) {
+        return to_string(bag + 1) + " + (n + " + line + ") % " + to_string(itemKinds);
+    };
+    const std::string depotBag = to_string(firstDepotLine) + " + depot * " + to_string(depotLines);
+
+    execute(connection, "account_removal", "DELETE FROM " + accounts + ".account WHERE acc_id = $1::integer",
+            firstId);
+    execute(connection, "account",
+            "INSERT INTO " + accounts + ".account (acc_id, acc_login, acc_lastip) "
+            "VALUES ($1::integer, 'benchmark', '127.0.0.1')",
+            firstId);
+    execute(connection, "chars",
+            "INSERT INTO {server}.chars (chr_accid, chr_playerid, chr_status, chr_race, chr_sex, chr_name) "
+            "SELECT $1::integer, " +
+                    playerId + ", 0, 0, 0, 'Benchmark ' || n" + players,
+            firstId, characters);
+    execute(connection, "player",
+            "INSERT INTO {server}.player (ply_playerid, ply_age, ply_faceto) SELECT " + playerId + ", 20, n % 8" +
+                    players,
+            firstId, characters);
+    execute(connection, "player_skills",
+            "INSERT INTO {server}.playerskills (psk_playerid, psk_skill_id, psk_value, psk_minor) SELECT " +
+                    playerId + ", " + to_string(firstSkill) + " + skill, (n + skill) % 101, (n * skill) % 10000" +
+                    players + series("skill", 0, skillCount - 1),
+            firstId, characters);
+    execute(connection, "body",
+            "INSERT INTO {server}.playeritems (pit_playerid, pit_linenumber, pit_itemid, pit_number, pit_wear) "
+            "SELECT " +
+                    playerId + ", line, CASE WHEN line = 1 THEN " + to_string(bag) + " ELSE " + item("line") +
+                    " END, 1, 100 + line" + players + series("line", 1, bodyLines),
+            firstId, characters);
+    execute(connection, "backpack",
+            "INSERT INTO {server}.playeritems (pit_playerid, pit_linenumber, pit_in_container, pit_itemid, pit_number, "
+            "pit_wear, pit_containerslot) SELECT " +
+                    playerId + ", " + to_string(bodyLines + 1) + " + slot, 1, " + item("slot") +
+                    ", 1 + slot % 20, 50, slot" + players + series("slot", 0, backpackItems - 1),
+            firstId, characters);
+    execute(connection, "depots",
+            "INSERT INTO {server}.playeritems (pit_playerid, pit_linenumber, pit_depot, pit_itemid, pit_number, "
+            "pit_wear, pit_containerslot) SELECT " +
+                    playerId + ", " + depotBag + " + slot, " + to_string(firstDepot) + " + depot, CASE WHEN slot = 0 " +
+                    "THEN " + to_string(bag) + " ELSE " + item("slot") + " END, 1 + slot % 100, 200, slot" + players +
+                    series("depot", 0, depots - 1) + series("slot", 0, depotItems - 1),
+            firstId, characters);
+    execute(connection, "depot_bags",
+            "INSERT INTO {server}.playeritems (pit_playerid, pit_linenumber, pit_in_container, pit_itemid, pit_number, "
+            "pit_wear, pit_containerslot) SELECT " +
+                    playerId + ", " + depotBag + " + " + to_string(depotItems) + " + slot, " + depotBag + ", " +
+                    item("slot") + ", 1, 200, slot" + players + series("depot", 0, depots - 1) +
+                    series("slot", 0, depotBagItems - 1),
+            firstId, characters);
+    execute(connection, "item_data",
+            "INSERT INTO {server}.playeritem_datavalues (idv_playerid, idv_linenumber, idv_key, idv_value) "
+            "SELECT pit_playerid, pit_linenumber, datakey, datakey || ' of ' || pit_playerid "
+            "FROM {server}.playeritems CROSS JOIN (VALUES ('descriptionEn'), ('craftedBy')) datakeys (datakey) "
+            "WHERE pit_playerid BETWEEN $1::integer AND $1::integer + $2::integer - 1 AND pit_linenumber % 4 = 0",
+            firstId, characters);
+    execute(connection, "player_effects",
+            "INSERT INTO {server}.playerlteffects (plte_playerid, plte_effectid, plte_nextcalled, plte_numbercalled) "
+            "SELECT " +
+                    playerId + ", " + to_string(firstEffect) + " + effect, 10 + effect * 10, n % 100" + players +
+                    series("effect", 0, effectCount - 1),
+            firstId, characters);
+    execute(connection, "player_effect_values",
+            "INSERT INTO {server}.playerlteffectvalues (pev_playerid, pev_effectid, pev_name, pev_value) SELECT " +
+                    playerId + ", " + to_string(firstEffect) + " + effect, 'value' || value, n + value" + players +
+                    series("effect", 0, effectCount - 1) + series("value", 1, effectValues),
+            firstId, characters);
+}
+
+auto reloadTable(Table &table) -> bool {
+    if (!table.reloadBuffer()) {
+        return false;
+    }
+
+    table.activateBuffer();
+    return true;
+}
+
+auto prepareDatabase() -> bool {
+    const char *config = std::getenv("ILLARION_CONFIG");
+
+    if (config == nullptr || !Config::load(config)) {
+        return false;
+    }
+
+    Database::SchemaHelper::setSchemata();
+    Database::ConnectionManager::getInstance().setupManager();
+
+    try {
+        auto connection = Database::ConnectionManager::getInstance().getConnection();
+        connection->beginTransaction();
+        generateReferences(connection);
+        generateCharacters(connection, characterCount());
+        connection->commitTransaction();
+    } catch (std::exception &e) {
+        std::cerr << "generating the characters failed: " << e.what() << std::endl;
+        return false;
+    }
+
+    return reloadTable(Data::skills()) && reloadTable(Data::items()) && reloadTable(Data::containerItems()) &&
+           Data::scriptVariables().reloadBuffer();
+}
+
+auto databaseReady(benchmark::State &state) -> bool {
+    static const bool ready = prepareDatabase();
+
+    if (!ready) {
+        state.SkipWithError("ILLARION_CONFIG has to name the configuration of a disposable database");
+        return false;
+    }
+
+    if (characterCount() < static_cast<TYPE_OF_CHARACTER_ID>(state.threads())) {
+        state.SkipWithError("every thread needs characters of its own");
+        return false;
+    }
+
+    return true;
+}
+
+auto world() -> BenchmarkWorld & {
+    static BenchmarkWorld world;
+    static std::once_flag monitoring;
+    std::call_once(monitoring, [] { world.monitoringClientList = std::make_unique<MonitoringClients>(); });
+    return world;
+}
+
+// the characters of the calling thread
+auto shareOf(const benchmark::State &state) -> std::pair<TYPE_OF_CHARACTER_ID, TYPE_OF_CHARACTER_ID> {
+    const auto share = characterCount() / static_cast<TYPE_OF_CHARACTER_ID>(state.threads());
+    return {firstId + share * state.thread_index(), share};
+}
+
+class StoredPlayer : public BenchmarkPlayer {
+public:
+    // sending to the offline connection is a no-op
+    StoredPlayer(TYPE_OF_CHARACTER_ID id, boost::asio::io_service &io)
+            : BenchmarkPlayer(id, nowhere, std::make_shared<NetInterface>(io)) {}
+
+    // what login does besides sending, the depots are loaded as well since they usually are by the end of a session
+    auto loadAll() -> bool {
+        if (!load()) {
+            return false;
+        }
+
+        for (uint32_t depot = firstDepot; depot < firstDepot + depots; ++depot) {
+            loadDepot(depot);
+        }
+
+        return true;
+    }
+
+    // a step and a changed stack in the belt, what differs between two saves of a player walking around
+    void play(int64_t step) {
+        setPosition(position(static_cast<Coordinate>(step % 100), 0, 0));
+        items.at(MAX_BODY_ITEMS).setNumber(static_cast<Item::number_type>(1 + step % 20));
+    }
+};
+
+// loaded players with the snapshot last saved for each
+class SavedPlayers {
+public:
+    explicit SavedPlayers(const benchmark::State &state) {
+        const auto [first, count] = shareOf(state);
+
+        for (auto id = first; id < first + count; ++id) {
+            auto &player = players.emplace_back(std::make_unique<StoredPlayer>(id, io));
+
+            if (!player->loadAll()) {
+                return;
+            }
+
+            {
+                // long time effects are loaded on the game thread only
+                static std::mutex effectsMutex;
+                std::lock_guard<std::mutex> lock(effectsMutex);
+                player->effects.load();
+            }
+
+            auto &snapshot = snapshots.emplace_back(player->snapshot());
+
+            if (!snapshot.save(nullptr)) {
+                return;
+            }
+        }
+
+        complete = !players.empty();
+    }
+
+    boost::asio::io_service io;
+    std::vector<std::unique_ptr<StoredPlayer>> players;
+    std::vector<PlayerSnapshot> snapshots;
+    bool complete = false;
+};
+
+// waits for pooled connections during the run, reported by the first thread which sees all threads
+class PoolCounters {
+public:
+    explicit PoolCounters(const benchmark::State &state) : first(state.thread_index() == 0) {
+        if (first) {
+            before = Database::ConnectionManager::getInstance().getStats();
+        }
+    }
+
+    void report(benchmark::State &state) const {
+        if (!first) {
+            return;
+        }
+
+        const auto after = Database::ConnectionManager::getInstance().getStats();
+        const auto waits = static_cast<double>(after.waits - before.waits);
+        const auto waitTime = std::chrono::duration<double>(after.waitTime - before.waitTime).count();
+        state.counters["pool_waits"] = waits;
+        state.counters["pool_wait_s"] = waitTime;
+        state.counters["pool_overflows"] = static_cast<double>(after.overflows - before.overflows);
+    }
+
+private:
+    bool first;
+    Database::ConnectionManager::PoolStats before;
+};
+
+void playerLoad(benchmark::State &state) {
+    if (!databaseReady(state)) {
+        return;
+    }
+
+    world();
+    boost::asio::io_service io;
+    const auto [first, count] = shareOf(state);
+    TYPE_OF_CHARACTER_ID next = 0;
+    const PoolCounters pool(state);
+
+    for (auto _ : state) {
+        StoredPlayer player(first + next, io);
+
+        if (!player.loadAll()) {
+            state.SkipWithError("loading the player failed");
+            break;
+        }
+
+        next = (next + 1) % count;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    pool.report(state);
+}
+
+// range(0) selects complete saves, without a previous snapshot, over saves of the changes
+void playerSave(benchmark::State &state) {
+    if (!databaseReady(state)) {
+        return;
+    }
+
+    world();
+    SavedPlayers saved(state);
+
+    if (!saved.complete) {
+        state.SkipWithError("loading or saving the players failed");
+        return;
+    }
+
+    const bool complete = state.range(0) != 0;
+    size_t next = 0;
+    const PoolCounters pool(state);
+
+    for (auto _ : state) {
+        auto &player = *saved.players[next];
+        player.play(state.iterations());
+        auto snapshot = player.snapshot();
+
+        if (!snapshot.save(complete ? nullptr : &saved.snapshots[next])) {
+            state.SkipWithError("saving the player failed");
+            break;
+        }
+
+        saved.snapshots[next] = std::move(snapshot);
+        next = (next + 1) % saved.players.size();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    pool.report(state);
+}
+
+void effectsLoad(benchmark::State &state) {
+    if (!databaseReady(state)) {
+        return;
+    }
+
+    world();
+    boost::asio::io_service io;
+    const auto [first, count] = shareOf(state);
+    TYPE_OF_CHARACTER_ID next = 0;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto player = std::make_unique<StoredPlayer>(first + next, io);
+        state.ResumeTiming();
+
+        if (!player->effects.load()) {
+            state.SkipWithError("loading the effects failed");
+            break;
+        }
+
+        state.PauseTiming();
+        player.reset();
+        next = (next + 1) % count;
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+// saves of players whose effects changed only
+void effectsSave(benchmark::State &state) {
+    if (!databaseReady(state)) {
+        return;
+    }
+
+    world();
+    SavedPlayers saved(state);
+
+    if (!saved.complete) {
+        state.SkipWithError("loading or saving the players failed");
+        return;
+    }
+
+    size_t next = 0;
+    const PoolCounters pool(state);
+
+    for (auto _ : state) {
+        auto snapshot = saved.snapshots[next];
+
+        for (auto &effect : snapshot.effects) {
+            ++effect.calls;
+            effect.nextCalled += 10;
+
+            for (auto &[name, value] : effect.values) {
+                ++value;
+            }
+        }
+
+        if (!snapshot.save(&saved.snapshots[next])) {
+            state.SkipWithError("saving the effects failed");
+            break;
+        }
+
+        saved.snapshots[next] = std::move(snapshot);
+        next = (next + 1) % saved.snapshots.size();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    pool.report(state);
+}
+
+// the first thread changes range(0) script variables and saves them, the others save players meanwhile
+void scriptVariablesSave(benchmark::State &state) {
+    if (!databaseReady(state)) {
+        return;
+    }
+
+    world();
+
+    if (state.thread_index() != 0) {
+        SavedPlayers saved(state);
+        size_t next = 0;
+
+        for (auto _ : state) {
+            if (saved.complete) {
+                saved.snapshots[next].save(nullptr);
+                next = (next + 1) % saved.snapshots.size();
+            }
+        }
+
+        return;
+    }
+
+    auto &variables = Data::scriptVariables();
+    const auto count = state.range(0);
+    int32_t round = 0;
+    const PoolCounters pool(state);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+
+        for (int64_t i = 0; i < count; ++i) {
+            variables.set("benchmark.variable." + std::to_string(i), round);
+        }
+
+        ++round;
+        state.ResumeTiming();
+        variables.save();
+    }
+
+    state.SetItemsProcessed(state.iterations() * count);
+    pool.report(state);
+}
+
+} // namespace
+
+BENCHMARK(playerLoad)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(playerSave)->ArgName("complete")->Arg(0)->Arg(1)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(effectsLoad)->UseRealTime();
+BENCHMARK(effectsSave)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(scriptVariablesSave)->Arg(10)->Arg(1000)->Arg(10000)->Threads(1)->Threads(8)->UseRealTime();
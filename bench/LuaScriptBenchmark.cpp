@@ -0,0 +1,191 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BenchmarkPlayer.hpp"
+#include "BenchmarkWorld.hpp"
+#include "Config.hpp"
+#include "character_ptr.hpp"
+#include "map/Field.hpp"
+#include "script/LuaScript.hpp"
+
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Calls entrypoints of the content scripts with a synthetic player and item. ILLARION_LUA_CALLS lists them as
+// module:entrypoint separated by commas, e.g. item.id_2_drink:UseItem, each is called with (player, item, 0), which
+// fits the item entrypoints, extra arguments are ignored by Lua. The scripts are found in the scriptdir of the server
+// configuration ILLARION_CONFIG, or else in ./script/. ILLARION_LUA_ITEM sets the id of the item.
+
+namespace {
+
+// garbage collection is held back during the calls and done every so many calls, timed on its own
+constexpr int64_t callsPerCollection = 1000;
+constexpr uint16_t mapSize = 100;
+constexpr uint16_t grass = 6;
+const position playerPosition(mapSize / 2, mapSize / 2, 0);
+
+class BenchmarkScript : public LuaScript {
+public:
+    explicit BenchmarkScript(const std::string &module) : LuaScript(module) {}
+
+    template <typename... Args> void call(const std::string &entrypoint, const Args &...args) {
+        callEntrypoint(entrypoint, args...);
+    }
+};
+
+// counts the allocations of the Lua state while it exists
+class AllocationCounter {
+public:
+    explicit AllocationCounter(lua_State *state) : state(state) {
+        original = lua_getallocf(state, &originalData);
+        lua_setallocf(state, &AllocationCounter::allocate, this);
+    }
+
+    AllocationCounter(const AllocationCounter &) = delete;
+    auto operator=(const AllocationCounter &) -> AllocationCounter & = delete;
+    AllocationCounter(AllocationCounter &&) = delete;
+    auto operator=(AllocationCounter &&) -> AllocationCounter & = delete;
+    ~AllocationCounter() { lua_setallocf(state, original, originalData); }
+
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+
+private:
+    static auto allocate(void *counterPointer, void *memory, size_t oldSize, size_t newSize) -> void * {
+        auto &counter = *static_cast<AllocationCounter *>(counterPointer);
+
+        // without memory the old size is the type of the new object
+        if (memory == nullptr) {
+            ++counter.allocations;
+            counter.bytes += newSize;
+        } else if (newSize > oldSize) {
+            ++counter.allocations;
+            counter.bytes += newSize - oldSize;
+        }
+
+        return counter.original(counter.originalData, memory, oldSize, newSize);
+    }
+
+    lua_State *state;
+    lua_Alloc original;
+    void *originalData = nullptr;
+};
+
+void call(benchmark::State &state, const std::string &module, const std::string &entrypoint) {
+    if (const char *config = std::getenv("ILLARION_CONFIG"); config != nullptr && !Config::load(config)) {
+        state.SkipWithError("ILLARION_CONFIG could not be read");
+        return;
+    }
+
+    BenchmarkWorld world;
+    world.createMap("lua_benchmark", position(0, 0, 0), mapSize, mapSize, grass);
+    boost::asio::io_service io;
+    auto connection = std::make_shared<NetInterface>(io);
+    connection->online = true;
+    connection->setSink([](const BasicServerCommand & /*command*/) {});
+    BenchmarkPlayer player(1, playerPosition, connection);
+    world.fieldAt(playerPosition).setPlayer();
+    world.Players.insert(&player);
+
+    std::unique_ptr<BenchmarkScript> script;
+
+    try {
+        script = std::make_unique<BenchmarkScript>(module);
+    } catch (ScriptException &e) {
+        state.SkipWithError(e.what());
+        return;
+    }
+
+    if (!script->existsEntrypoint(entrypoint)) {
+        state.SkipWithError("the module has no such entrypoint");
+        return;
+    }
+
+    ScriptItem item;
+    const char *itemId = std::getenv("ILLARION_LUA_ITEM");
+    item.setId(itemId != nullptr ? static_cast<TYPE_OF_ITEM_ID>(std::stoul(itemId)) : 1);
+    item.setNumber(1);
+    item.type = ScriptItem::it_field;
+    item.pos = playerPosition;
+    const character_ptr user(&player);
+    const unsigned char noLongTimeAction = LTS_NOLTACTION;
+
+    lua_State *luaState = LuaScript::getLuaState();
+    lua_gc(luaState, LUA_GCCOLLECT, 0);
+    lua_gc(luaState, LUA_GCSTOP, 0);
+    std::chrono::nanoseconds collection{0};
+    int64_t calls = 0;
+    AllocationCounter counter(luaState);
+
+    for (auto _ : state) {
+        script->call(entrypoint, user, item, noLongTimeAction);
+
+        if (++calls % callsPerCollection == 0) {
+            state.PauseTiming();
+            const auto start = std::chrono::steady_clock::now();
+            lua_gc(luaState, LUA_GCCOLLECT, 0);
+            collection += std::chrono::steady_clock::now() - start;
+            state.ResumeTiming();
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    lua_gc(luaState, LUA_GCCOLLECT, 0);
+    collection += std::chrono::steady_clock::now() - start;
+    lua_gc(luaState, LUA_GCRESTART, 0);
+
+    const auto average = benchmark::Counter::kAvgIterations;
+    state.counters["lua_allocations"] = benchmark::Counter(static_cast<double>(counter.allocations), average);
+    state.counters["lua_bytes"] = benchmark::Counter(static_cast<double>(counter.bytes), average);
+    state.counters["gc_s"] = benchmark::Counter(std::chrono::duration<double>(collection).count(), average);
+    world.Players.clear();
+}
+
+auto registerCalls() -> bool {
+    const char *calls = std::getenv("ILLARION_LUA_CALLS");
+
+    if (calls == nullptr) {
+        return false;
+    }
+
+    std::istringstream list(calls);
+    std::string entry;
+
+    while (std::getline(list, entry, ',')) {
+        const auto separator = entry.find(':');
+
+        if (separator == std::string::npos) {
+            continue;
+        }
+
+        const auto module = entry.substr(0, separator);
+        const auto entrypoint = entry.substr(separator + 1);
+        benchmark::RegisterBenchmark(("lua/" + entry).c_str(), call, module, entrypoint);
+    }
+
+    return true;
+}
+
+const bool registered = registerCalls();
+
+} // namespace
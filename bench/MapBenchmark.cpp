@@ -0,0 +1,119 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BenchmarkWorld.hpp"
+#include "HugePages.hpp"
+#include "map/Field.hpp"
+#include "map/WorldMap.hpp"
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint16_t mapSize = 500;
+constexpr uint16_t mapsPerSide = 4;
+constexpr uint16_t grass = 6;
+constexpr size_t positionCount = 4096;
+
+// four times four adjacent maps on one level
+class Maps {
+public:
+    Maps() {
+        for (uint16_t x = 0; x < mapsPerSide; ++x) {
+            for (uint16_t y = 0; y < mapsPerSide; ++y) {
+                const position origin(static_cast<Coordinate>(x * mapSize), static_cast<Coordinate>(y * mapSize), 0);
+                worldMap.createMap("benchmark_" + std::to_string(x) + "_" + std::to_string(y), origin, mapSize,
+                                   mapSize, grass);
+            }
+        }
+
+        std::mt19937 random(0);
+        std::uniform_int_distribution<Coordinate> coordinate(0, mapSize * mapsPerSide - 1);
+
+        for (size_t i = 0; i < positionCount; ++i) {
+            positions.emplace_back(coordinate(random), coordinate(random), 0);
+        }
+    }
+
+    BenchmarkWorld world;
+    map::WorldMap worldMap;
+    std::vector<position> positions;
+};
+
+void worldMapAt(benchmark::State &state) {
+    const Maps maps;
+    size_t i = 0;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(&maps.worldMap.at(maps.positions[i++ % positionCount]));
+    }
+}
+
+// random access as above with the fields allocated in the given huge_pages mode, see Config
+void worldMapAtWithHugePages(benchmark::State &state, const std::string &mode) {
+    if (!hugepages::configure(mode)) {
+        state.SkipWithError("unknown huge page mode");
+        return;
+    }
+
+    const Maps maps;
+    hugepages::configure("off");
+    size_t i = 0;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(&maps.worldMap.at(maps.positions[i++ % positionCount]));
+    }
+}
+
+void movementCost(benchmark::State &state) {
+    const Maps maps;
+    size_t i = 0;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(maps.worldMap.at(maps.positions[i++ % positionCount]).getMovementCost());
+    }
+}
+
+// a walk over neighbouring fields, the access pattern of path finding
+void movementCostNearby(benchmark::State &state) {
+    const Maps maps;
+    const position start(mapSize - 10, mapSize - 10, 0);
+    constexpr Coordinate side = 20;
+
+    for (auto _ : state) {
+        for (Coordinate x = 0; x < side; ++x) {
+            for (Coordinate y = 0; y < side; ++y) {
+                const position pos(static_cast<Coordinate>(start.x + x), static_cast<Coordinate>(start.y + y), 0);
+                benchmark::DoNotOptimize(maps.worldMap.at(pos).getMovementCost());
+            }
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * side * side);
+}
+
+} // namespace
+
+BENCHMARK(worldMapAt);
+BENCHMARK_CAPTURE(worldMapAtWithHugePages, transparent, std::string("transparent"));
+BENCHMARK_CAPTURE(worldMapAtWithHugePages, reserved, std::string("reserved"));
+BENCHMARK(movementCost);
+BENCHMARK(movementCostNearby);
@@ -0,0 +1,229 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BenchmarkWorld.hpp"
+#include "Config.hpp"
+#include "constants.hpp"
+#include "map/Field.hpp"
+#include "map/WorldMap.hpp"
+
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <sys/resource.h>
+
+// Times the import of editor maps, loading the saved maps and saving them again on synthetic map sets of range(0)
+// square maps with range(1) fields per side, laid out in a grid on level 0. The sets are generated below
+// ILLARION_MAP_DIR, or else the temporary directory, and kept there for later runs; delete them after changing the
+// generator. The peak resident set size is that of the process so far, run one benchmark at a time with
+// --benchmark_filter to get it for a single set.
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// one item on every so many fields, one in so many items has data and a warp on so many fields
+constexpr int fieldsPerItem = 6;
+constexpr int itemsPerData = 8;
+constexpr int fieldsPerWarp = 2000;
+constexpr uint16_t tileKinds = 30;
+constexpr uint16_t musicKinds = 4;
+constexpr TYPE_OF_ITEM_ID firstItem = 1;
+constexpr TYPE_OF_ITEM_ID itemKinds = 3000;
+
+class MapSet {
+public:
+    MapSet(int64_t maps, int64_t size)
+            : maps(static_cast<int>(maps)), size(static_cast<uint16_t>(size)),
+              side(static_cast<int>(std::ceil(std::sqrt(static_cast<double>(maps))))),
+              dataDir(root() / (std::to_string(maps) + "x" + std::to_string(size))) {
+        const auto importDir = dataDir / MAPDIR / "import";
+
+        if (!fs::exists(importDir / "complete")) {
+            fs::remove_all(dataDir);
+            fs::create_directories(importDir);
+            generate(importDir);
+            std::ofstream(importDir / "complete");
+        }
+
+        std::ofstream(configFile()) << "datadir " << dataDir.string() << "/\n";
+    }
+
+    // the set becomes the data directory of the server
+    [[nodiscard]] auto activate() const -> bool { return Config::load(configFile().string()); }
+
+    [[nodiscard]] auto fields() const -> int64_t { return static_cast<int64_t>(maps) * size * size; }
+
+    // makes every map dirty, so that all of them are saved
+    void touch(map::WorldMap &worldMap) const {
+        for (int i = 0; i < maps; ++i) {
+            worldMap.at(origin(i));
+        }
+    }
+
+private:
+    int maps;
+    uint16_t size;
+    int side;
+    fs::path dataDir;
+
+    static auto root() -> fs::path {
+        const char *dir = std::getenv("ILLARION_MAP_DIR");
+        return dir != nullptr ? fs::path(dir) : fs::temp_directory_path() / "illarion-map-benchmark";
+    }
+
+    [[nodiscard]] auto configFile() const -> fs::path { return dataDir / "benchmark.conf"; }
+
+    [[nodiscard]] auto origin(int map) const -> position {
+        return {static_cast<Coordinate>(map % side * size), static_cast<Coordinate>(map / side * size), 0};
+    }
+
+    void generate(const fs::path &importDir) const {
+        std::mt19937 random(static_cast<std::mt19937::result_type>(maps * size));
+        std::uniform_int_distribution<uint16_t> tile(1, tileKinds);
+        std::uniform_int_distribution<uint16_t> music(0, musicKinds - 1);
+        std::uniform_int_distribution<TYPE_OF_ITEM_ID> item(firstItem, firstItem + itemKinds - 1);
+        std::uniform_int_distribution<uint16_t> quality(111, 999);
+        std::uniform_int_distribution<int> field(0, size * size - 1);
+        std::uniform_int_distribution<int> target(0, side * size - 1);
+
+        for (int map = 0; map < maps; ++map) {
+            const auto name = importDir / ("benchmark_" + std::to_string(map));
+            const auto pos = origin(map);
+
+            std::ofstream tiles(name.string() + ".tiles.txt");
+            tiles << "# synthetic map " << map << "\nV: 2\nL: " << pos.z << "\nX: " << pos.x << "\nY: " << pos.y
+                  << "\nW: " << size << "\nH: " << size << '\n';
+
+            for (uint16_t x = 0; x < size; ++x) {
+                for (uint16_t y = 0; y < size; ++y) {
+                    tiles << x << ';' << y << ';' << tile(random) << ';' << music(random) << '\n';
+                }
+            }
+
+            std::ofstream items(name.string() + ".items.txt");
+            const int itemCount = size * size / fieldsPerItem;
+
+            for (int i = 0; i < itemCount; ++i) {
+                const auto at = field(random);
+                items << at / size << ';' << at % size << ';' << item(random) << ';' << quality(random);
+
+                if (i % itemsPerData == 0) {
+                    items << ";descriptionEn=item " << i << ";descriptionDe=Gegenstand " << i;
+                }
+
+                items << '\n';
+            }
+
+            std::ofstream warps(name.string() + ".warps.txt");
+            const int warpCount = size * size / fieldsPerWarp;
+
+            for (int i = 0; i < warpCount; ++i) {
+                const auto at = field(random);
+                warps << at / size << ';' << at % size << ';' << target(random) << ';' << target(random) << ";0\n";
+            }
+        }
+    }
+};
+
+void reportMemory(benchmark::State &state, const map::WorldMap &worldMap, const MapSet &set) {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    // kilobytes on Linux
+    state.counters["peak_rss_mb"] = static_cast<double>(usage.ru_maxrss) / 1024;
+    state.counters["heap_mb"] = static_cast<double>(worldMap.memoryUsage()) / (1024 * 1024);
+    state.counters["mapped_mb"] = static_cast<double>(worldMap.mappedBytes()) / (1024 * 1024);
+    state.SetItemsProcessed(state.iterations() * set.fields());
+}
+
+// includes the save that follows every import
+void importFromEditor(benchmark::State &state) {
+    const MapSet set(state.range(0), state.range(1));
+
+    if (!set.activate()) {
+        state.SkipWithError("could not load the configuration of the map set");
+        return;
+    }
+
+    BenchmarkWorld world;
+    map::WorldMap worldMap;
+
+    for (auto _ : state) {
+        if (!worldMap.importFromEditor()) {
+            state.SkipWithError("importing the map set failed");
+            break;
+        }
+    }
+
+    reportMemory(state, worldMap, set);
+}
+
+void loadFromDisk(benchmark::State &state) {
+    const MapSet set(state.range(0), state.range(1));
+    BenchmarkWorld world;
+    map::WorldMap worldMap;
+
+    if (!set.activate() || !worldMap.importFromEditor()) {
+        state.SkipWithError("importing the map set failed");
+        return;
+    }
+
+    for (auto _ : state) {
+        if (!worldMap.loadMapsFromDisk()) {
+            state.SkipWithError("loading the map set failed");
+            break;
+        }
+    }
+
+    reportMemory(state, worldMap, set);
+}
+
+void saveToDisk(benchmark::State &state) {
+    const MapSet set(state.range(0), state.range(1));
+    BenchmarkWorld world;
+    map::WorldMap worldMap;
+
+    if (!set.activate() || !worldMap.importFromEditor()) {
+        state.SkipWithError("importing the map set failed");
+        return;
+    }
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        set.touch(worldMap);
+        state.ResumeTiming();
+        worldMap.saveToDisk();
+    }
+
+    reportMemory(state, worldMap, set);
+}
+
+void mapSets(benchmark::internal::Benchmark *benchmark) {
+    benchmark->ArgNames({"maps", "size"})->ArgsProduct({{4, 16}, {250, 1000}});
+    benchmark->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+} // namespace
+
+BENCHMARK(importFromEditor)->Apply(mapSets);
+BENCHMARK(loadFromDisk)->Apply(mapSets);
+BENCHMARK(saveToDisk)->Apply(mapSets);
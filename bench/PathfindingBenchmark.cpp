@@ -0,0 +1,362 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BenchmarkPlayer.hpp"
+#include "BenchmarkWorld.hpp"
+#include "Config.hpp"
+#include "a_star.hpp"
+#include "constants.hpp"
+#include "data/Data.hpp"
+#include "db/ConnectionManager.hpp"
+#include "db/SchemaHelper.hpp"
+#include "hpa_star.hpp"
+#include "map/Field.hpp"
+#include "path_cache.hpp"
+
+#include <array>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <list>
+#include <memory>
+#include <new>
+#include <random>
+#include <vector>
+
+// Runs the searches of a corpus of start and goal pairs on a synthetic map: short routes on open ground, routes
+// through a maze of walls, goals walled in and long routes beyond the search budget. The terrain searches see the map
+// through a lookup and need nothing else. The searches on the world map need the tiles table of the database of the
+// server configuration ILLARION_CONFIG for a walkable and a blocking tile. Every iteration is one search, the counters
+// are per search.
+
+namespace {
+std::atomic<uint64_t> allocations{0};
+} // namespace
+
+// counts every allocation of the process, the searches read the difference
+auto operator new(size_t size) -> void * {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void *memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, size_t /*size*/) noexcept { std::free(memory); }
+
+namespace {
+
+constexpr Coordinate mapSize = 512;
+// the open ground lies west of this column, the maze east of it
+constexpr Coordinate mazeBorder = mapSize / 2;
+constexpr Coordinate mazeRowSpacing = 4;
+constexpr Coordinate mazeGapSpacing = 32;
+constexpr Coordinate boxSpacing = 32;
+constexpr Coordinate boxRadius = 2;
+constexpr size_t searchesPerCorpus = 64;
+
+enum class Corpus { open, maze, unreachable, beyondBudget };
+
+struct Search {
+    position start;
+    position goal;
+};
+
+class CorpusMap {
+public:
+    CorpusMap() : blocked(size_t(mapSize) * mapSize) {
+        for (Coordinate y = 0; y < mapSize; ++y) {
+            block(mazeBorder, y);
+        }
+
+        for (Coordinate y = mazeRowSpacing; y < mapSize; y += mazeRowSpacing) {
+            const Coordinate offset = (y / mazeRowSpacing) % 2 * (mazeGapSpacing / 2);
+
+            for (Coordinate x = mazeBorder + 1; x < mapSize; ++x) {
+                if ((x - mazeBorder + offset) % mazeGapSpacing != 0) {
+                    block(x, y);
+                }
+            }
+        }
+
+        for (const auto &centre : boxes()) {
+            for (Coordinate d = -boxRadius; d <= boxRadius; ++d) {
+                block(centre.x + d, centre.y - boxRadius);
+                block(centre.x + d, centre.y + boxRadius);
+                block(centre.x - boxRadius, centre.y + d);
+                block(centre.x + boxRadius, centre.y + d);
+            }
+        }
+    }
+
+    [[nodiscard]] auto isBlocked(const position &pos) const -> bool {
+        return pos.z != 0 || pos.x < 0 || pos.y < 0 || pos.x >= mapSize || pos.y >= mapSize ||
+               blocked[index(pos.x, pos.y)];
+    }
+
+    [[nodiscard]] auto lookup() const -> pathfinding::TerrainLookup {
+        return [this](const position &pos) -> pathfinding::Terrain { return {!isBlocked(pos), 1}; };
+    }
+
+    // the walled in centres of the boxes on the open ground
+    [[nodiscard]] static auto boxes() -> std::vector<position> {
+        std::vector<position> centres;
+
+        for (Coordinate x = boxSpacing; x < mazeBorder - boxSpacing / 2; x += boxSpacing) {
+            for (Coordinate y = boxSpacing; y < mapSize - boxSpacing / 2; y += boxSpacing) {
+                centres.emplace_back(x, y, 0);
+            }
+        }
+
+        return centres;
+    }
+
+    [[nodiscard]] auto corpus(Corpus kind) const -> std::vector<Search> {
+        std::mt19937 random(static_cast<std::mt19937::result_type>(kind));
+        std::vector<Search> searches;
+
+        while (searches.size() < searchesPerCorpus) {
+            const auto search = draw(kind, random);
+
+            if (!isBlocked(search.start) && (kind == Corpus::unreachable || !isBlocked(search.goal))) {
+                searches.push_back(search);
+            }
+        }
+
+        return searches;
+    }
+
+    void build(World &world, TYPE_OF_TILE_ID ground, TYPE_OF_TILE_ID wall) const {
+        world.createMap("pathfinding", {0, 0, 0}, mapSize, mapSize, ground);
+
+        for (Coordinate x = 0; x < mapSize; ++x) {
+            for (Coordinate y = 0; y < mapSize; ++y) {
+                if (blocked[index(x, y)]) {
+                    world.fieldAt({x, y, 0}).setTileId(wall);
+                }
+            }
+        }
+    }
+
+private:
+    std::vector<bool> blocked;
+
+    [[nodiscard]] static auto index(Coordinate x, Coordinate y) -> size_t { return size_t(y) * mapSize + size_t(x); }
+
+    void block(Coordinate x, Coordinate y) { blocked[index(x, y)] = true; }
+
+    static auto draw(Corpus kind, std::mt19937 &random) -> Search {
+        using Uniform = std::uniform_int_distribution<Coordinate>;
+        Uniform openX(0, mazeBorder - 1);
+        Uniform anyY(0, mapSize - 1);
+
+        switch (kind) {
+        case Corpus::open: {
+            // stays west of the maze
+            const position start(Uniform(40, mazeBorder - 41)(random), anyY(random), 0);
+            Uniform offset(-40, 40);
+            return {start, {Coordinate(start.x + offset(random)), Coordinate(start.y + offset(random)), 0}};
+        }
+        case Corpus::maze: {
+            Uniform mazeX(mazeBorder + 1, mapSize - 1);
+            Uniform rows(1, 3);
+            const position start(mazeX(random), anyY(random), 0);
+            const Coordinate y = start.y + rows(random) * mazeRowSpacing * (start.y < mapSize / 2 ? 1 : -1);
+            return {start, {mazeX(random), y, 0}};
+        }
+        case Corpus::unreachable: {
+            const auto centres = boxes();
+            const auto &goal = centres[std::uniform_int_distribution<size_t>(0, centres.size() - 1)(random)];
+            Uniform offset(-30, 30);
+            return {{Coordinate(goal.x + offset(random)), Coordinate(goal.y + offset(random)), 0}, goal};
+        }
+        case Corpus::beyondBudget: {
+            // some are even too far apart to be searched at all
+            Uniform distance(150, 500);
+            const position start(openX(random), Uniform(0, 10)(random), 0);
+            return {start, {openX(random), Coordinate(start.y + distance(random)), 0}};
+        }
+        }
+
+        return {};
+    }
+};
+
+const CorpusMap corpusMap;
+
+constexpr std::array<const char *, 4> corpusNames = {"open", "maze", "unreachable", "beyond budget"};
+
+// a walkable tile and one which blocks the path, taken from the tiles table
+auto findTiles(TYPE_OF_TILE_ID &ground, TYPE_OF_TILE_ID &wall) -> bool {
+    bool foundGround = false;
+    bool foundWall = false;
+
+    for (const auto &[id, tile] : Data::tiles()) {
+        if ((tile.flags & FLAG_BLOCKPATH) != 0) {
+            wall = id;
+            foundWall = true;
+        } else if (tile.walkingCost > 0) {
+            ground = id;
+            foundGround = true;
+        }
+    }
+
+    return foundGround && foundWall;
+}
+
+auto prepareWorld() -> World * {
+    const char *config = std::getenv("ILLARION_CONFIG");
+
+    if (config == nullptr || !Config::load(config)) {
+        return nullptr;
+    }
+
+    Database::SchemaHelper::setSchemata();
+    Database::ConnectionManager::getInstance().setupManager();
+
+    if (!Data::tiles().reloadBuffer()) {
+        return nullptr;
+    }
+
+    Data::tiles().activateBuffer();
+    TYPE_OF_TILE_ID ground = 0;
+    TYPE_OF_TILE_ID wall = 0;
+
+    if (!findTiles(ground, wall)) {
+        return nullptr;
+    }
+
+    static BenchmarkWorld world;
+    corpusMap.build(world, ground, wall);
+    return &world;
+}
+
+auto worldReady(benchmark::State &state) -> bool {
+    static const World *const world = prepareWorld();
+
+    if (world == nullptr) {
+        state.SkipWithError("ILLARION_CONFIG has to name a configuration whose database holds the tiles");
+        return false;
+    }
+
+    return true;
+}
+
+// runs one search of the corpus per iteration and reports what the searches cost
+template <typename Find> void searchCorpus(benchmark::State &state, Find &&find) {
+    const auto kind = static_cast<Corpus>(state.range(0));
+    const auto searches = corpusMap.corpus(kind);
+    std::list<direction> steps;
+    size_t next = 0;
+    uint64_t found = 0;
+    uint64_t stepCount = 0;
+    uint64_t searchAllocations = 0;
+    const auto expandedBefore = pathfinding::expanded_nodes();
+
+    for (auto _ : state) {
+        const auto &search = searches[next++ % searches.size()];
+        const auto allocationsBefore = allocations.load(std::memory_order_relaxed);
+
+        if (find(search, steps)) {
+            ++found;
+            stepCount += steps.size();
+        }
+
+        searchAllocations += allocations.load(std::memory_order_relaxed) - allocationsBefore;
+    }
+
+    const auto expanded = pathfinding::expanded_nodes() - expandedBefore;
+    constexpr auto average = benchmark::Counter::kAvgIterations;
+    state.counters["nodes_expanded"] = benchmark::Counter(static_cast<double>(expanded), average);
+    state.counters["found"] = benchmark::Counter(static_cast<double>(found), average);
+    state.counters["steps"] = benchmark::Counter(static_cast<double>(stepCount), average);
+    state.counters["allocations"] = benchmark::Counter(static_cast<double>(searchAllocations), average);
+    state.SetLabel(corpusNames[state.range(0)]);
+}
+
+void aStarOnTerrain(benchmark::State &state) {
+    const auto lookup = corpusMap.lookup();
+    searchCorpus(state, [&lookup](const Search &search, std::list<direction> &steps) {
+        return pathfinding::a_star(search.start, search.goal, steps, lookup);
+    });
+}
+
+void aStarOnWorld(benchmark::State &state) {
+    if (!worldReady(state)) {
+        return;
+    }
+
+    searchCorpus(state, [](const Search &search, std::list<direction> &steps) {
+        return pathfinding::a_star(search.start, search.goal, steps);
+    });
+}
+
+void hpaStarOnWorld(benchmark::State &state) {
+    if (!worldReady(state)) {
+        return;
+    }
+
+    searchCorpus(state, [](const Search &search, std::list<direction> &steps) {
+        return pathfinding::hpa_star(search.start, search.goal, steps);
+    });
+}
+
+// a player moved to the start of every search
+class Walker : public BenchmarkPlayer {
+public:
+    Walker() : BenchmarkPlayer(1, {0, 0, 0}, nullptr) {}
+
+    using BenchmarkPlayer::setPosition;
+};
+
+// the step list monsters and NPCs ask for, with range(1) set the path cache is emptied before every search
+void stepList(benchmark::State &state) {
+    if (!worldReady(state)) {
+        return;
+    }
+
+    const bool cold = state.range(1) != 0;
+    Walker walker;
+
+    searchCorpus(state, [&walker, cold](const Search &search, std::list<direction> &steps) {
+        if (cold) {
+            pathfinding::forget_path(search.start, search.goal);
+        }
+
+        walker.setPosition(search.start);
+        return walker.getStepList(search.goal, steps);
+    });
+}
+
+void corpora(benchmark::internal::Benchmark *benchmark) {
+    benchmark->ArgName("corpus")->DenseRange(0, static_cast<int>(corpusNames.size()) - 1);
+}
+
+void cacheStates(benchmark::internal::Benchmark *benchmark) {
+    benchmark->ArgNames({"corpus", "cold"})->ArgsProduct({{0, 1, 2, 3}, {0, 1}});
+}
+
+} // namespace
+
+BENCHMARK(aStarOnTerrain)->Apply(corpora);
+BENCHMARK(aStarOnWorld)->Apply(corpora);
+BENCHMARK(hpaStarOnWorld)->Apply(corpora);
+BENCHMARK(stepList)->Apply(cacheStates);
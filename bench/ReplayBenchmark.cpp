@@ -0,0 +1,231 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BenchmarkPlayer.hpp"
+#include "BenchmarkWorld.hpp"
+#include "Config.hpp"
+#include "MonitoringClients.hpp"
+#include "Random.hpp"
+#include "map/Field.hpp"
+#include "netinterface/CommandFactory.hpp"
+#include "netinterface/SessionRecording.hpp"
+#include "tuningConstants.hpp"
+
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+constexpr uint16_t grass = 6;
+// fields around the logins that are part of the synthetic map
+constexpr Coordinate margin = 100;
+
+// Replays a recording of SessionRecorder in real time. The world is the map snapshot of the server configured by
+// ILLARION_CONFIG without the persistent fields of the database, or else plain maps around the recorded logins.
+class Replay {
+public:
+    explicit Replay(const SessionRecording &recording) : recording(recording) {
+        world.monitoringClientList = std::make_unique<MonitoringClients>();
+
+        if (const char *config = std::getenv("ILLARION_CONFIG"); config != nullptr && Config::load(config)) {
+            try {
+                world.Load();
+            } catch (std::exception &) {
+            }
+        } else {
+            createMaps();
+        }
+
+        Random::seed(recording.seed);
+    }
+
+    // replays everything recorded up to the given time since the start of the replay
+    void replayUntil(std::chrono::milliseconds time) {
+        for (; next != recording.records.end() && next->time <= time; ++next) {
+            switch (next->kind) {
+            case SessionRecording::login:
+                login(*next);
+                break;
+            case SessionRecording::command:
+                command(*next);
+                break;
+            case SessionRecording::logout:
+                logout(next->player);
+                break;
+            }
+        }
+
+        // keep alives are recorded, but saving continues on its own
+        for (auto &[id, player] : players) {
+            player->keepAlive();
+        }
+    }
+
+    [[nodiscard]] auto finished() const -> bool { return next == recording.records.end(); }
+
+    BenchmarkWorld world;
+
+private:
+    void createMaps() {
+        std::map<Coordinate, std::pair<position, position>> levels;
+
+        for (const auto &record : recording.records) {
+            if (record.kind != SessionRecording::login) {
+                continue;
+            }
+
+            auto [level, inserted] = levels.try_emplace(record.pos.z, record.pos, record.pos);
+            auto &[low, high] = level->second;
+            low.x = std::min(low.x, record.pos.x);
+            low.y = std::min(low.y, record.pos.y);
+            high.x = std::max(high.x, record.pos.x);
+            high.y = std::max(high.y, record.pos.y);
+        }
+
+        for (const auto &[z, bounds] : levels) {
+            const auto &[low, high] = bounds;
+            const position origin(static_cast<Coordinate>(low.x - margin), static_cast<Coordinate>(low.y - margin), z);
+            world.createMap("replay_" + std::to_string(z), origin, static_cast<uint16_t>(high.x - low.x + 2 * margin),
+                            static_cast<uint16_t>(high.y - low.y + 2 * margin), grass);
+        }
+    }
+
+    void login(const SessionRecording::Record &record) {
+        try {
+            auto &field = world.fieldAt(record.pos);
+            auto connection = std::make_shared<NetInterface>(io);
+            connection->online = true;
+            connection->setSink([](const BasicServerCommand & /*command*/) {});
+            auto &player = players[record.player];
+            player = std::make_unique<BenchmarkPlayer>(record.player, record.pos, connection);
+            field.setPlayer();
+            world.Players.insert(player.get());
+            world.Observers.add(player.get());
+        } catch (FieldNotFound &) {
+        }
+    }
+
+    void command(const SessionRecording::Record &record) {
+        const auto player = players.find(record.player);
+        auto command = CommandFactory::getCommand(record.definition);
+
+        if (player == players.end() || !command) {
+            return;
+        }
+
+        command->setHeaderData(static_cast<uint16_t>(record.payload.size()), 0);
+        command->msg_data() = record.payload;
+
+        try {
+            command->decodeData();
+        } catch (OverflowException &) {
+            return;
+        }
+
+        command->setReceivedTime();
+        player->second->receiveCommand(command);
+    }
+
+    void logout(TYPE_OF_CHARACTER_ID id) {
+        const auto player = players.find(id);
+
+        if (player == players.end()) {
+            return;
+        }
+
+        const auto pos = player->second->getPosition();
+
+        try {
+            world.fieldAt(pos).removePlayer();
+        } catch (FieldNotFound &) {
+        }
+
+        world.Players.erase(id);
+        world.Observers.remove(player->second.get());
+        world.sendRemoveCharToVisiblePlayers(id, pos);
+        players.erase(player);
+    }
+
+    const SessionRecording &recording;
+    std::vector<SessionRecording::Record>::const_iterator next = recording.records.begin();
+    boost::asio::io_service io;
+    std::unordered_map<TYPE_OF_CHARACTER_ID, std::unique_ptr<BenchmarkPlayer>> players;
+};
+
+// one iteration replays the recording given by ILLARION_REPLAY, timed by the ticks during the replay
+void replay(benchmark::State &state) {
+    const char *path = std::getenv("ILLARION_REPLAY");
+
+    if (path == nullptr) {
+        state.SkipWithError("ILLARION_REPLAY has to name a session recording");
+        return;
+    }
+
+    const auto recording = SessionRecording::read(path);
+
+    if (!recording) {
+        state.SkipWithError("ILLARION_REPLAY is no session recording");
+        return;
+    }
+
+    using Seconds = std::chrono::duration<double>;
+    Seconds players{0};
+    Seconds commands{0};
+    Seconds monsters{0};
+    Seconds npcs{0};
+    int64_t ticks = 0;
+
+    for (auto _ : state) {
+        Replay replay(*recording);
+        const auto start = std::chrono::steady_clock::now();
+        Seconds total{0};
+
+        for (auto tick = start; !replay.finished(); tick += std::chrono::milliseconds(MIN_AP_UPDATE)) {
+            std::this_thread::sleep_until(tick);
+            replay.replayUntil(std::chrono::duration_cast<std::chrono::milliseconds>(tick - start));
+            replay.world.turntheworld();
+            replay.world.checkPlayerImmediateCommands();
+
+            const auto &times = replay.world.getLastTickTimes();
+            total += times.total;
+            players += times.players;
+            commands += times.commands;
+            monsters += times.monsters;
+            npcs += times.npcs;
+            ++ticks;
+        }
+
+        state.SetIterationTime(total.count());
+    }
+
+    const auto perTick = [ticks](Seconds time) { return ticks > 0 ? time.count() / static_cast<double>(ticks) : 0; };
+    state.counters["ticks"] = static_cast<double>(ticks);
+    state.counters["players_s"] = perTick(players);
+    state.counters["commands_s"] = perTick(commands);
+    state.counters["monsters_s"] = perTick(monsters);
+    state.counters["npcs_s"] = perTick(npcs);
+}
+
+} // namespace
+
+BENCHMARK(replay)->Iterations(1)->UseManualTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,296 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BenchmarkWorld.hpp"
+#include "Config.hpp"
+#include "Scheduler.hpp"
+#include "data/ScheduledScriptsTable.hpp"
+#include "script/LuaScheduledScript.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Stresses the game loop scheduler and the scheduled scripts: the cost of inserting tasks into a scheduler holding
+// range(0) tasks, also from several threads at once, the lateness of dispatched tasks against their deadlines while
+// other threads keep adding one-shot tasks, and the cycles of the scheduled scripts table. Deadlines are rounded up to
+// the millisecond ticks of the scheduler, so up to a millisecond of lateness is inherent.
+
+namespace {
+
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+using Scheduler = ClockBasedScheduler<Clock>;
+
+constexpr std::array<std::chrono::milliseconds, 6> intervals = {5ms, 10ms, 50ms, 100ms, 250ms, 1000ms};
+constexpr auto longestOneshotDelay = 100ms;
+// one-shot tasks an adding thread adds per millisecond
+constexpr int addsPerMillisecond = 2;
+// inserted tasks are cancelled again in batches of this size, to keep the scheduler at its size
+constexpr size_t cancelBatch = 4096;
+constexpr auto dispatchTimeout = 10ms;
+
+// lateness of dispatched tasks, only written by the dispatching thread
+class Lateness {
+public:
+    void record(Clock::time_point due) { samples.push_back(Clock::now() - due); }
+
+    void report(benchmark::State &state) {
+        if (samples.empty()) {
+            return;
+        }
+
+        std::sort(samples.begin(), samples.end());
+        const auto microseconds = [](Clock::duration duration) {
+            return std::chrono::duration<double, std::micro>(duration).count();
+        };
+        Clock::duration total{0};
+
+        for (const auto sample : samples) {
+            total += sample;
+        }
+
+        state.counters["late_mean_us"] = microseconds(total / samples.size());
+        state.counters["late_p99_us"] = microseconds(samples[samples.size() * 99 / 100]);
+        state.counters["late_max_us"] = microseconds(samples.back());
+        state.counters["dispatched"] = static_cast<double>(samples.size());
+    }
+
+private:
+    std::vector<Clock::duration> samples;
+};
+
+// a recurring task, knows when it is due next
+struct Timer {
+    Clock::time_point due;
+    Clock::duration interval;
+};
+
+// adds recurring tasks with mixed intervals and first deadlines spread over the interval
+void addRecurringTasks(Scheduler &scheduler, std::vector<Timer> &timers, Lateness *lateness) {
+    std::mt19937 random(static_cast<std::mt19937::result_type>(timers.size()));
+    const auto now = Clock::now();
+
+    for (auto &timer : timers) {
+        timer.interval = intervals[random() % intervals.size()];
+        timer.due = now + std::chrono::milliseconds(random() % timer.interval.count() + 1);
+        scheduler.addRecurringTask(
+                [&timer, lateness] {
+                    if (lateness != nullptr) {
+                        lateness->record(timer.due);
+                    }
+
+                    timer.due += timer.interval;
+                },
+                timer.interval, timer.due, "benchmark recurring");
+    }
+}
+
+// one insertion per iteration into a scheduler shared by all threads
+void addTask(benchmark::State &state) {
+    static std::unique_ptr<Scheduler> scheduler;
+    static std::vector<Timer> timers;
+
+    if (state.thread_index() == 0) {
+        scheduler = std::make_unique<Scheduler>();
+        timers = std::vector<Timer>(static_cast<size_t>(state.range(0)));
+        addRecurringTasks(*scheduler, timers, nullptr);
+    }
+
+    // the other threads wait for the first one to set up the scheduler before their first iteration
+    std::mt19937 random(static_cast<std::mt19937::result_type>(state.thread_index()));
+    std::uniform_int_distribution<int> delay(1, longestOneshotDelay.count());
+    std::vector<TaskHandle> handles;
+    handles.reserve(cancelBatch);
+
+    for (auto _ : state) {
+        const auto wait = std::chrono::milliseconds(delay(random));
+        handles.push_back(scheduler->addOneshotTask([] {}, wait, "benchmark oneshot"));
+
+        if (handles.size() == cancelBatch) {
+            state.PauseTiming();
+
+            for (const auto handle : handles) {
+                scheduler->cancel(handle);
+            }
+
+            handles.clear();
+            state.ResumeTiming();
+        }
+    }
+
+    for (const auto handle : handles) {
+        scheduler->cancel(handle);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index() == 0) {
+        state.counters["tasks"] = static_cast<double>(scheduler->taskCount());
+    }
+}
+
+// adds one-shot tasks from its own thread until stopped, timing every addition
+class Adder {
+public:
+    Adder(Scheduler &scheduler, Lateness &lateness, unsigned seed)
+            : thread([this, &scheduler, &lateness, seed] { run(scheduler, lateness, seed); }) {}
+
+    Adder(const Adder &) = delete;
+    auto operator=(const Adder &) -> Adder & = delete;
+    Adder(Adder &&) = delete;
+    auto operator=(Adder &&) -> Adder & = delete;
+
+    ~Adder() {
+        running = false;
+        thread.join();
+    }
+
+    static inline std::atomic<uint64_t> adds{0};
+    static inline std::atomic<uint64_t> addNanoseconds{0};
+    static inline std::atomic<uint64_t> longestAddNanoseconds{0};
+
+private:
+    std::atomic<bool> running{true};
+    std::thread thread;
+
+    void run(Scheduler &scheduler, Lateness &lateness, unsigned seed) {
+        std::mt19937 random(seed);
+        std::uniform_int_distribution<int> delay(1, longestOneshotDelay.count());
+        auto next = Clock::now();
+
+        while (running) {
+            for (int i = 0; i < addsPerMillisecond; ++i) {
+                const auto wait = std::chrono::milliseconds(delay(random));
+                const auto start = Clock::now();
+                const auto due = start + wait;
+                scheduler.addOneshotTask([&lateness, due] { lateness.record(due); }, wait, "benchmark oneshot");
+                const auto took = static_cast<uint64_t>((Clock::now() - start) / 1ns);
+                adds.fetch_add(1, std::memory_order_relaxed);
+                addNanoseconds.fetch_add(took, std::memory_order_relaxed);
+                auto longest = longestAddNanoseconds.load(std::memory_order_relaxed);
+
+                while (took > longest && !longestAddNanoseconds.compare_exchange_weak(longest, took)) {
+                }
+            }
+
+            next += 1ms;
+            std::this_thread::sleep_until(next);
+        }
+    }
+};
+
+// the game loop dispatching range(0) recurring tasks while range(1) threads add one-shot tasks, one run_once per
+// iteration
+void dispatch(benchmark::State &state) {
+    Scheduler scheduler;
+    Lateness lateness;
+    std::vector<Timer> timers(static_cast<size_t>(state.range(0)));
+    addRecurringTasks(scheduler, timers, &lateness);
+    Adder::adds = 0;
+    Adder::addNanoseconds = 0;
+    Adder::longestAddNanoseconds = 0;
+
+    {
+        std::vector<std::unique_ptr<Adder>> adders;
+
+        for (int64_t i = 0; i < state.range(1); ++i) {
+            adders.push_back(std::make_unique<Adder>(scheduler, lateness, static_cast<unsigned>(i)));
+        }
+
+        for (auto _ : state) {
+            scheduler.run_once(dispatchTimeout);
+        }
+    }
+
+    // the adders are stopped, the lateness is no longer written
+    lateness.report(state);
+
+    if (const auto adds = Adder::adds.load(); adds > 0) {
+        state.counters["add_mean_ns"] = static_cast<double>(Adder::addNanoseconds.load()) / static_cast<double>(adds);
+        state.counters["add_max_us"] = static_cast<double>(Adder::longestAddNanoseconds.load()) / 1000;
+    }
+}
+
+// the scheduled scripts the server runs every cycle, a shared Lua module with an empty function stands in for them
+void scheduledScripts(benchmark::State &state) {
+    const auto scriptDir = fs::temp_directory_path() / "illarion-scheduler-benchmark";
+    fs::create_directories(scriptDir / "scheduled");
+    std::ofstream(scriptDir / "scheduled" / "benchmark.lua") << "local M = {}\nfunction M.cycle() end\nreturn M\n";
+    const auto configFile = scriptDir / "benchmark.conf";
+    std::ofstream(configFile) << "scriptdir " << scriptDir.string() << "/\n";
+
+    if (!Config::load(configFile.string())) {
+        state.SkipWithError("could not load the configuration of the scripts");
+        return;
+    }
+
+    BenchmarkWorld world;
+    std::shared_ptr<LuaScheduledScript> script;
+
+    try {
+        script = std::make_shared<LuaScheduledScript>("scheduled.benchmark");
+    } catch (ScriptException &e) {
+        state.SkipWithError(e.what());
+        return;
+    }
+
+    // without a database the table starts out empty
+    ScheduledScriptsTable table;
+    std::mt19937 random(0);
+
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        const auto minCycles = static_cast<uint32_t>(intervals[random() % intervals.size()].count() / 5);
+        ScriptData data(minCycles, minCycles * 2, static_cast<uint32_t>(random() % minCycles), 0, "cycle",
+                        "scheduled.benchmark");
+        data.scriptptr = script;
+        table.addData(std::move(data));
+    }
+
+    size_t carriedOver = 0;
+
+    for (auto _ : state) {
+        table.nextCycle();
+        carriedOver += table.getCarriedOver();
+    }
+
+    uint64_t calls = 0;
+
+    for (const auto &data : table.getScripts()) {
+        calls += data.calls;
+    }
+
+    constexpr auto average = benchmark::Counter::kAvgIterations;
+    state.counters["calls"] = benchmark::Counter(static_cast<double>(calls), average);
+    state.counters["carried_over"] = benchmark::Counter(static_cast<double>(carriedOver), average);
+}
+
+} // namespace
+
+BENCHMARK(addTask)->ArgName("tasks")->Arg(1000)->Arg(10000)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(dispatch)->ArgNames({"tasks", "adders"})->ArgsProduct({{1000, 10000}, {0, 1, 4}})->UseRealTime();
+BENCHMARK(scheduledScripts)->ArgName("scripts")->Arg(100)->Arg(1000)->Arg(5000);
@@ -0,0 +1,65 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Character.hpp"
+#include "netinterface/protocol/ServerCommands.hpp"
+
+#include <benchmark/benchmark.h>
+#include <string>
+
+namespace {
+
+constexpr unsigned char benchmarkCommand = 0x42;
+
+void encodeFields(benchmark::State &state) {
+    for (auto _ : state) {
+        BasicServerCommand command(benchmarkCommand);
+        command.addFields(int32_t{-2}, int16_t{-300}, uint8_t{7}, std::string("hello"), Colour(1, 2, 3));
+        command.addHeader();
+        benchmark::DoNotOptimize(command.cmdData().data());
+    }
+}
+
+void encodeMoveAck(benchmark::State &state) {
+    const position pos(-5, 12, 3);
+
+    for (auto _ : state) {
+        MoveAckTC command(0xFE000001, pos, NORMALMOVE, Character::actionPointUnit);
+        command.addHeader();
+        benchmark::DoNotOptimize(command.cmdData().data());
+    }
+}
+
+// text of the given length
+void encodeSay(benchmark::State &state) {
+    const std::string text(static_cast<size_t>(state.range(0)), 'a');
+
+    for (auto _ : state) {
+        SayTC command(position(1, 2, 3), text);
+        command.addHeader();
+        benchmark::DoNotOptimize(command.cmdData().data());
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+} // namespace
+
+BENCHMARK(encodeFields);
+BENCHMARK(encodeMoveAck);
+BENCHMARK(encodeSay)->Arg(16)->Arg(255)->Arg(4000);
@@ -0,0 +1,69 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "data/StructTable.hpp"
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+namespace {
+
+constexpr size_t lookupCount = 4096;
+
+template <typename IdType> class BenchmarkTable : public StructTable<IdType, int> {
+public:
+    void add(IdType id, int value) { this->emplace(id, value); }
+
+protected:
+    [[nodiscard]] auto getTableName() const -> std::string override { return "benchmark"; }
+    auto getColumnNames() -> std::vector<std::string> override { return {}; }
+    auto assignId(const TableRow & /*row*/) -> IdType override { return {}; }
+    auto assignTable(const TableRow & /*row*/) -> int override { return 0; }
+};
+
+// the given number of entries with ids spread by the given factor, a factor of one gives dense ids
+void find(benchmark::State &state) {
+    const auto entries = static_cast<int32_t>(state.range(0));
+    const auto spread = static_cast<int32_t>(state.range(1));
+    BenchmarkTable<int32_t> table;
+
+    for (int32_t i = 0; i < entries; ++i) {
+        table.add(i * spread, i);
+    }
+
+    table.activateBuffer();
+
+    std::mt19937 random(0);
+    std::uniform_int_distribution<int32_t> id(0, entries * spread);
+    std::vector<int32_t> ids(lookupCount);
+
+    for (auto &lookup : ids) {
+        lookup = id(random);
+    }
+
+    size_t i = 0;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(table.find(ids[i++ % lookupCount]));
+    }
+}
+
+} // namespace
+
+BENCHMARK(find)->ArgsProduct({{100, 10000}, {1, 1000}});
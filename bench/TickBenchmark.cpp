@@ -0,0 +1,246 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "BenchmarkPlayer.hpp"
+#include "BenchmarkWorld.hpp"
+#include "Monster.hpp"
+#include "MonitoringClients.hpp"
+#include "NPC.hpp"
+#include "data/MonsterTable.hpp"
+#include "map/Field.hpp"
+#include "netinterface/NetInterface.hpp"
+#include "netinterface/protocol/ClientCommands.hpp"
+#include "tuningConstants.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <thread>
+#include <vector>
+
+extern std::unique_ptr<MonsterTable> monsterDescriptions;
+
+namespace {
+std::atomic<uint64_t> allocations{0};
+} // namespace
+
+// counts every allocation of the process, the ticks read the difference
+auto operator new(size_t size) -> void * {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void *memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, size_t /*size*/) noexcept { std::free(memory); }
+
+namespace {
+
+constexpr uint16_t mapSize = 500;
+constexpr uint16_t grass = 6;
+constexpr TYPE_OF_CHARACTER_ID monsterType = 1;
+// a quarter of the fields of the town are taken
+constexpr size_t fieldsPerCharacter = 4;
+constexpr int warmUpTicks = 2;
+
+// the given number of players, monsters and npcs on the fields around the centre of one map
+class Town {
+public:
+    Town(size_t players, size_t monsters, size_t npcs) {
+        world.monitoringClientList = std::make_unique<MonitoringClients>();
+        world.createMap("benchmark", position(0, 0, 0), mapSize, mapSize, grass);
+
+        MonsterStruct description;
+        description.nameEn = "benchmark rat";
+        description.hitpoints = MAXHPS;
+        monsterDescriptions = std::make_unique<MonsterTable>(MonsterTable::TABLE{{monsterType, description}});
+
+        const auto fields = positions(players + monsters + npcs);
+        auto field = fields.begin();
+
+        for (size_t i = 0; i < players; ++i, ++field) {
+            auto connection = std::make_shared<NetInterface>(io);
+            connection->online = true;
+            connection->setSink([this](const BasicServerCommand &command) {
+                ++sentCommands;
+                sentBytes += command.getLength();
+            });
+
+            auto &player = bots.emplace_back(
+                    std::make_unique<BenchmarkPlayer>(static_cast<TYPE_OF_CHARACTER_ID>(i + 1), *field, connection));
+            world.fieldAt(*field).setPlayer();
+            world.Players.insert(player.get());
+            world.Observers.add(player.get());
+        }
+
+        for (size_t i = 0; i < monsters; ++i, ++field) {
+            world.createMonster(monsterType, *field, 0);
+        }
+
+        for (size_t i = 0; i < npcs; ++i, ++field) {
+            auto &npc = npcList.emplace_back(std::make_unique<NPC>(DYNNPC_BASE, "benchmark npc", 0, *field,
+                                                                    Character::north, false, Character::male,
+                                                                    Character::appearance{}));
+            world.Npc.insert(npc.get());
+        }
+    }
+
+    Town(const Town &) = delete;
+    auto operator=(const Town &) -> Town & = delete;
+    Town(Town &&) = delete;
+    auto operator=(Town &&) -> Town & = delete;
+
+    ~Town() {
+        world.Monsters.for_each([](Monster *monster) { delete monster; });
+        world.Monsters.clear();
+        world.Npc.clear();
+
+        for (const auto &player : bots) {
+            world.Observers.remove(player.get());
+        }
+
+        world.Players.clear();
+        monsterDescriptions.reset();
+    }
+
+    // every bot walks back and forth and turns now and then, like a crowd idling in town
+    void sendBotCommands(int tick) {
+        const bool turning = tick % 4 == 3;
+        const auto dir = static_cast<unsigned char>(tick % 8 < 4 ? dir_east : dir_west);
+
+        for (const auto &player : bots) {
+            player->keepAlive();
+            ClientCommandPointer command;
+
+            if (turning) {
+                command = makeClientCommand<PlayerSpinTS>();
+                command->setHeaderData(1, 0);
+                command->msg_data() = {static_cast<unsigned char>((dir + 2) % 8)};
+            } else {
+                const auto id = static_cast<uint32_t>(player->getId());
+                command = makeClientCommand<CharMoveTS>();
+                command->setHeaderData(6, 0);
+                command->msg_data() = {static_cast<unsigned char>(id >> 24), static_cast<unsigned char>(id >> 16),
+                                       static_cast<unsigned char>(id >> 8), static_cast<unsigned char>(id), dir,
+                                       NORMALMOVE};
+            }
+
+            command->decodeData();
+            command->setReceivedTime();
+            player->receiveCommand(command);
+        }
+    }
+
+    BenchmarkWorld world;
+    uint64_t sentCommands = 0;
+    uint64_t sentBytes = 0;
+
+private:
+    // distinct positions in a square around the centre of the map, big enough for all characters
+    static auto positions(size_t count) -> std::vector<position> {
+        const auto side = std::max<Coordinate>(
+                1, static_cast<Coordinate>(std::ceil(std::sqrt(static_cast<double>(count * fieldsPerCharacter)))));
+        const auto start = static_cast<Coordinate>((mapSize - side) / 2);
+        std::vector<position> result;
+
+        for (Coordinate x = 0; x < side; ++x) {
+            for (Coordinate y = 0; y < side; ++y) {
+                result.emplace_back(static_cast<Coordinate>(start + x), static_cast<Coordinate>(start + y), 0);
+            }
+        }
+
+        std::shuffle(result.begin(), result.end(), std::mt19937(0));
+        result.resize(count);
+        return result;
+    }
+
+    boost::asio::io_service io;
+    std::vector<std::unique_ptr<BenchmarkPlayer>> bots;
+    std::vector<std::unique_ptr<NPC>> npcList;
+};
+
+// turntheworld hands out the action points of the time passed since the last tick
+void waitForNextTick() { std::this_thread::sleep_for(std::chrono::milliseconds(MIN_AP_UPDATE)); }
+
+// one iteration is one tick of the given number of players, monsters and npcs, timed by the tick itself
+void tick(benchmark::State &state) {
+    Town town(static_cast<size_t>(state.range(0)), static_cast<size_t>(state.range(1)),
+              static_cast<size_t>(state.range(2)));
+
+    for (int i = 0; i < warmUpTicks; ++i) {
+        waitForNextTick();
+        town.world.turntheworld();
+    }
+
+    using Seconds = std::chrono::duration<double>;
+    Seconds players{0};
+    Seconds commands{0};
+    Seconds monsters{0};
+    Seconds npcs{0};
+    uint64_t tickAllocations = 0;
+    const auto sentCommands = town.sentCommands;
+    const auto sentBytes = town.sentBytes;
+    int tickNumber = 0;
+
+    for (auto _ : state) {
+        town.sendBotCommands(tickNumber++);
+        waitForNextTick();
+
+        const auto allocationsBefore = allocations.load(std::memory_order_relaxed);
+        town.world.turntheworld();
+        tickAllocations += allocations.load(std::memory_order_relaxed) - allocationsBefore;
+
+        const auto &times = town.world.getLastTickTimes();
+        state.SetIterationTime(Seconds(times.total).count());
+        players += times.players;
+        commands += times.commands;
+        monsters += times.monsters;
+        npcs += times.npcs;
+    }
+
+    const auto average = benchmark::Counter::kAvgIterations;
+    state.counters["players_s"] = benchmark::Counter(players.count(), average);
+    state.counters["commands_s"] = benchmark::Counter(commands.count(), average);
+    state.counters["monsters_s"] = benchmark::Counter(monsters.count(), average);
+    state.counters["npcs_s"] = benchmark::Counter(npcs.count(), average);
+    state.counters["allocations"] = benchmark::Counter(static_cast<double>(tickAllocations), average);
+    const auto commandsOfTicks = static_cast<double>(town.sentCommands - sentCommands);
+    state.counters["sent_commands"] = benchmark::Counter(commandsOfTicks, average);
+    state.counters["sent_bytes"] = benchmark::Counter(static_cast<double>(town.sentBytes - sentBytes), average);
+}
+
+} // namespace
+
+// players, monsters and npcs per run, the last run is a crowded town
+BENCHMARK(tick)
+        ->ArgNames({"players", "monsters", "npcs"})
+        ->Args({0, 1000, 100})
+        ->Args({100, 200, 50})
+        ->Args({500, 200, 50})
+        ->Iterations(50)
+        ->UseManualTime()
+        ->Unit(benchmark::kMillisecond);
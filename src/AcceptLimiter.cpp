@@ -0,0 +1,95 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AcceptLimiter.hpp"
+
+#include <algorithm>
+
+AcceptLimiter::AcceptLimiter(double globalRate, double addressRate, double addressBurst)
+        : globalRate(globalRate), addressRate(addressRate), addressBurst(std::max(addressBurst, 1.0)),
+          global{std::max(globalRate, 1.0), Clock::now()}, pruned(Clock::now()) {}
+
+void AcceptLimiter::Bucket::refill(double rate, double burst, Clock::time_point now) {
+    const std::chrono::duration<double> elapsed = now - refilled;
+
+    if (elapsed.count() > 0) {
+        tokens = std::min(burst, tokens + elapsed.count() * rate);
+        refilled = now;
+    }
+}
+
+auto AcceptLimiter::allow(const std::string &address, Clock::time_point now) -> bool {
+    prune(now);
+    Bucket *addressBucket = nullptr;
+
+    if (addressRate > 0) {
+        auto [it, inserted] = addresses.try_emplace(address, Bucket{addressBurst, now});
+        addressBucket = &it->second;
+        addressBucket->refill(addressRate, addressBurst, now);
+
+        if (addressBucket->tokens < 1) {
+            addressRejections.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    if (globalRate > 0) {
+        // one second worth of connections may arrive at once
+        global.refill(globalRate, std::max(globalRate, 1.0), now);
+
+        if (global.tokens < 1) {
+            globalRejections.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        global.tokens -= 1;
+    }
+
+    if (addressBucket != nullptr) {
+        addressBucket->tokens -= 1;
+    }
+
+    return true;
+}
+
+void AcceptLimiter::prune(Clock::time_point now) {
+    if (now - pruned < pruneInterval) {
+        return;
+    }
+
+    pruned = now;
+
+    // a refilled bucket behaves like a new one, so the map only holds recently active addresses
+    for (auto it = addresses.begin(); it != addresses.end();) {
+        it->second.refill(addressRate, addressBurst, now);
+
+        if (it->second.tokens >= addressBurst) {
+            it = addresses.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+auto AcceptLimiter::rejectedGlobally() const -> uint64_t { return globalRejections.load(std::memory_order_relaxed); }
+
+auto AcceptLimiter::rejectedPerAddress() const -> uint64_t {
+    return addressRejections.load(std::memory_order_relaxed);
+}
+
+auto AcceptLimiter::trackedAddresses() const -> size_t { return addresses.size(); }
@@ -0,0 +1,65 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ACCEPT_LIMITER_HPP
+#define ACCEPT_LIMITER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// token buckets limiting new connections globally and per address, a rate of 0 means unlimited;
+// not thread safe, calls to allow have to be serialized, e.g. by keeping one accept outstanding
+class AcceptLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    AcceptLimiter(double globalRate, double addressRate, double addressBurst);
+
+    // takes a token from both buckets if both have one
+    auto allow(const std::string &address, Clock::time_point now) -> bool;
+
+    [[nodiscard]] auto rejectedGlobally() const -> uint64_t;
+    [[nodiscard]] auto rejectedPerAddress() const -> uint64_t;
+    [[nodiscard]] auto trackedAddresses() const -> size_t;
+
+private:
+    struct Bucket {
+        double tokens;
+        Clock::time_point refilled;
+
+        void refill(double rate, double burst, Clock::time_point now);
+    };
+
+    static constexpr std::chrono::seconds pruneInterval{60};
+
+    double globalRate;
+    double addressRate;
+    double addressBurst;
+    Bucket global;
+    std::unordered_map<std::string, Bucket> addresses;
+    Clock::time_point pruned;
+    std::atomic<uint64_t> globalRejections{0};
+    std::atomic<uint64_t> addressRejections{0};
+
+    void prune(Clock::time_point now);
+};
+
+#endif
@@ -27,7 +27,6 @@
 #include "Player.hpp"
 #include "Random.hpp"
 #include "World.hpp"
-#include "a_star.hpp"
 #include "character_ptr.hpp"
 #include "constants.hpp"
 #include "data/Data.hpp"
@@ -36,13 +35,16 @@
 #include "map/Field.hpp"
 #include "netinterface/protocol/BBIWIServerCommands.hpp"
 #include "netinterface/protocol/ServerCommands.hpp"
+#include "path_cache.hpp"
 #include "script/server.hpp"
 
 #include <algorithm>
+#include <cassert>
 #include <cmath>
 #include <limits>
 #include <map>
 #include <range/v3/all.hpp>
+#include <utility>
 
 extern std::unique_ptr<RaceTypeTable> raceTypes;
 
@@ -127,7 +129,7 @@ auto Character::getFrontalPosition() const -> position {
 }
 
 auto Character::getStepList(const position &goal, std::list<direction> &steps) const -> bool {
-    return pathfinding::a_star(pos, goal, steps);
+    return pathfinding::cached_path(pos, goal, steps);
 }
 
 auto Character::getNextStepDir(const position &goal, direction &dir) const -> bool {
@@ -223,6 +225,16 @@ void Character::increaseFightPoints(int fp) { setFightPoints(fightPoints + fp);
 
 auto Character::canFight() const -> bool { return fightPoints >= getMinFightPoints(); }
 
+void Character::setOnRoute(bool onr) {
+    _is_on_route = onr;
+
+    if (onr) {
+        _world->wakeCreature(*this);
+    } else {
+        waypoints.setObserved(true);
+    }
+}
+
 auto Character::getSpeed() const -> double { return speed; }
 
 void Character::setSpeed(double spd) { speed = spd; }
@@ -546,8 +558,11 @@ auto Character::swapAtPos(unsigned char pos, TYPE_OF_ITEM_ID newid, int newQuali
     return false;
 }
 
-void Character::ageInventory() {
-    for (auto &item : items) {
+auto Character::ageItems() -> InventoryAgeing {
+    InventoryAgeing ageing;
+
+    for (size_t slot = 0; slot < items.size(); ++slot) {
+        auto &item = items.at(slot);
         auto itemId = item.getId();
 
         if (itemId != 0) {
@@ -555,6 +570,8 @@ void Character::ageInventory() {
 
             if (itemStruct.isValid() && itemStruct.rotsInInventory) {
                 if (!item.survivesAgeing()) {
+                    ageing.slots.set(slot);
+
                     if (itemId != itemStruct.ObjectAfterRot) {
                         item.setId(itemStruct.ObjectAfterRot);
 
@@ -580,6 +597,8 @@ void Character::ageInventory() {
             depot.second->doAge(true);
         }
     }
+
+    return ageing;
 }
 
 void Character::setAlive(bool t) { alive = t; }
@@ -589,7 +608,7 @@ auto Character::attack(Character *target) -> bool {
         if (!actionRunning()) {
             if (target->isAlive()) {
                 if (target->getType() == player) {
-                    auto *pl = dynamic_cast<Player *>(target);
+                    auto *pl = static_cast<Player *>(target);
                     pl->ltAction->actionDisturbed(this);
                 }
 
@@ -636,21 +655,21 @@ auto Character::getSkillName(TYPE_OF_SKILL_ID s) const -> std::string {
 }
 
 auto Character::getSkill(TYPE_OF_SKILL_ID s) const -> unsigned short int {
-    auto iterator = skills.find(s);
+    const auto *value = skills.find(s);
 
-    if (iterator == skills.end()) {
+    if (value == nullptr) {
         return 0;
     }
-    return (*iterator).second.major;
+    return value->major;
 }
 
 auto Character::getMinorSkill(TYPE_OF_SKILL_ID s) const -> unsigned short int {
-    auto iterator = skills.find(s);
+    const auto *value = skills.find(s);
 
-    if (iterator == skills.end()) {
+    if (value == nullptr) {
         return 0;
     }
-    return (*iterator).second.minor;
+    return value->minor;
 }
 
 void Character::setSkinColour(const Colour &c) {
@@ -777,14 +796,39 @@ auto Character::saveBaseAttributes() -> bool { return false; }
 void Character::handleAttributeChange(Character::attributeIndex attribute) {
     if (attribute == Character::hitpoints) {
         setAlive(getAttribute(hitpoints) > 0);
+        markAttributeChanged(hitpoints);
+
+        if (!isAlive()) {
+            _world->wakeCreature(*this);
+        }
+    }
+}
+
+void Character::markAttributeChanged(attributeIndex attribute) {
+    static_assert(ATTRIBUTECOUNT <= std::numeric_limits<decltype(changedAttributes)>::digits);
+
+    if (changedAttributes == 0) {
+        _world->attributesChanged(*this);
+    }
+
+    changedAttributes |= 1U << attribute;
+}
+
+void Character::flushAttributeUpdates() {
+    if (const auto changed = std::exchange(changedAttributes, 0); changed != 0) {
+        sendAttributeUpdates(changed);
+    }
+}
+
+void Character::sendAttributeUpdates(uint32_t changed) {
+    if ((changed & (1U << hitpoints)) != 0) {
         _world->sendHealthToAllVisiblePlayers(this, getAttribute(hitpoints));
     }
 }
 
 auto Character::isBaseAttribValid(const std::string &name, Attribute::attribute_t value) const -> bool {
     try {
-        Character::attributeIndex attribute = attributeMap.at(name);
-        return isBaseAttributeValid(attribute, value);
+        return isBaseAttribValid(attributeMap.at(name), value);
     } catch (...) {
         return false;
     }
@@ -792,8 +836,7 @@ auto Character::isBaseAttribValid(const std::string &name, Attribute::attribute_
 
 auto Character::setBaseAttrib(const std::string &name, Attribute::attribute_t value) -> bool {
     try {
-        Character::attributeIndex attribute = attributeMap.at(name);
-        return setBaseAttribute(attribute, value);
+        return setBaseAttrib(attributeMap.at(name), value);
     } catch (...) {
         return false;
     }
@@ -801,16 +844,14 @@ auto Character::setBaseAttrib(const std::string &name, Attribute::attribute_t va
 
 void Character::setAttrib(const std::string &name, Attribute::attribute_t value) {
     try {
-        Character::attributeIndex attribute = attributeMap.at(name);
-        setAttribute(attribute, value);
+        setAttrib(attributeMap.at(name), value);
     } catch (...) {
     }
 }
 
 auto Character::getBaseAttrib(const std::string &name) const -> Attribute::attribute_t {
     try {
-        Character::attributeIndex attribute = attributeMap.at(name);
-        return getBaseAttribute(attribute);
+        return getBaseAttrib(attributeMap.at(name));
     } catch (...) {
         return 0;
     }
@@ -818,47 +859,62 @@ auto Character::getBaseAttrib(const std::string &name) const -> Attribute::attri
 
 auto Character::increaseBaseAttrib(const std::string &name, int amount) -> bool {
     try {
-        Character::attributeIndex attribute = attributeMap.at(name);
-        return increaseBaseAttribute(attribute, amount);
+        return increaseBaseAttrib(attributeMap.at(name), amount);
     } catch (...) {
         return false;
     }
 }
 
 auto Character::increaseAttrib(const std::string &name, int amount) -> Attribute::attribute_t {
-    if (name == "sex") {
-        return getAttribute(Character::sex);
-    }
-
     try {
-        Character::attributeIndex attribute = attributeMap.at(name);
-        return increaseAttribute(attribute, amount);
+        return increaseAttrib(attributeMap.at(name), amount);
     } catch (...) {
     }
 
     return 0;
 }
 
-auto Character::setSkill(TYPE_OF_SKILL_ID skill, int major, int minor) -> int {
-    if (!Data::skills().exists(skill)) {
-        return 0;
+auto Character::isBaseAttribValid(attributeIndex attribute, Attribute::attribute_t value) const -> bool {
+    return isAttribute(attribute) && isBaseAttributeValid(attribute, value);
+}
+
+auto Character::setBaseAttrib(attributeIndex attribute, Attribute::attribute_t value) -> bool {
+    return isAttribute(attribute) && setBaseAttribute(attribute, value);
+}
+
+void Character::setAttrib(attributeIndex attribute, Attribute::attribute_t value) {
+    if (isAttribute(attribute)) {
+        setAttribute(attribute, value);
     }
+}
 
-    auto iterator = skills.find(skill);
-    {
-        if (iterator == skills.end()) {
-            skillvalue sv;
-            sv.major = major;
-            sv.minor = minor;
-            skills[skill] = sv;
-            return sv.major;
-        }
-        iterator->second.major = major;
+auto Character::getBaseAttrib(attributeIndex attribute) const -> Attribute::attribute_t {
+    return isAttribute(attribute) ? getBaseAttribute(attribute) : 0;
+}
+
+auto Character::increaseBaseAttrib(attributeIndex attribute, int amount) -> bool {
+    return isAttribute(attribute) && increaseBaseAttribute(attribute, amount);
+}
+
+auto Character::increaseAttrib(attributeIndex attribute, int amount) -> Attribute::attribute_t {
+    if (attribute == sex) {
+        return getAttribute(sex);
+    }
+
+    return isAttribute(attribute) ? increaseAttribute(attribute, amount) : 0;
+}
 
-        iterator->second.minor = minor;
+auto Character::isAttribute(attributeIndex attribute) -> bool { return attribute >= 0 && attribute < ATTRIBUTECOUNT; }
 
-        return iterator->second.major;
+auto Character::setSkill(TYPE_OF_SKILL_ID skill, int major, int minor) -> int {
+    if (!Data::skills().exists(skill)) {
+        return 0;
     }
+
+    skillvalue sv;
+    sv.major = major;
+    sv.minor = minor;
+    return skills.set(skill, sv).major;
 }
 
 auto Character::increaseSkill(TYPE_OF_SKILL_ID skill, int amount) -> int {
@@ -866,9 +922,9 @@ auto Character::increaseSkill(TYPE_OF_SKILL_ID skill, int amount) -> int {
         return 0;
     }
 
-    auto iterator = skills.find(skill);
+    auto *value = skills.find(skill);
 
-    if (iterator == skills.end()) {
+    if (value == nullptr) {
         skillvalue sv;
 
         if (amount <= 0) {
@@ -881,24 +937,24 @@ auto Character::increaseSkill(TYPE_OF_SKILL_ID skill, int amount) -> int {
             sv.major = amount;
         }
 
-        skills[skill] = sv;
+        skills.set(skill, sv);
         return sv.major;
     }
-    int temp = iterator->second.major + amount;
+    int temp = value->major + amount;
 
     if (temp <= 0) {
-        iterator->second.major = 0;
-
-        skills.erase(iterator); // L�chen des Eintrags wenn value <= 0
+        skills.erase(skill); // delete if value <= 0
+        return 0;
+    }
 
-    } else if (temp > maximumMajorSkill) {
-        iterator->second.major = maximumMajorSkill;
+    if (temp > maximumMajorSkill) {
+        value->major = maximumMajorSkill;
 
     } else {
-        iterator->second.major = temp;
+        value->major = temp;
     }
 
-    return (iterator->second.major);
+    return value->major;
 }
 
 auto Character::increaseMinorSkill(TYPE_OF_SKILL_ID skill, int amount) -> int {
@@ -906,9 +962,9 @@ auto Character::increaseMinorSkill(TYPE_OF_SKILL_ID skill, int amount) -> int {
         return 0;
     }
 
-    auto iterator = skills.find(skill);
+    auto *value = skills.find(skill);
 
-    if (iterator == skills.end()) {
+    if (value == nullptr) {
         skillvalue sv;
 
         if (amount <= 0) {
@@ -926,44 +982,38 @@ auto Character::increaseMinorSkill(TYPE_OF_SKILL_ID skill, int amount) -> int {
             sv.major++;
         }
 
-        skills[skill] = sv;
+        skills.set(skill, sv);
         return (sv.major);
     }
-    int temp = iterator->second.minor + amount;
+    int temp = value->minor + amount;
 
     if (temp <= 0) {
-        iterator->second.minor = 0;
+        value->minor = 0;
 
-        iterator->second.major--;
+        value->major--;
 
-        if (iterator->second.major == 0) {
-            skills.erase(iterator); // delete if major == 0
+        if (value->major == 0) {
+            skills.erase(skill); // delete if major == 0
+            return 0;
         }
 
     } else if (temp >= maximumMinorSkill) {
-        iterator->second.minor = 0;
+        value->minor = 0;
 
-        iterator->second.major++;
+        value->major++;
 
-        if (iterator->second.major > maximumMajorSkill) {
-            iterator->second.major = maximumMajorSkill;
+        if (value->major > maximumMajorSkill) {
+            value->major = maximumMajorSkill;
         }
 
     } else {
-        iterator->second.minor = temp;
+        value->minor = temp;
     }
 
-    return (iterator->second.major);
+    return value->major;
 }
 
-auto Character::getSkillValue(TYPE_OF_SKILL_ID s) const -> const skillvalue * {
-    auto it = skills.find(s);
-
-    if (it == skills.end()) {
-        return nullptr;
-    }
-    return &(it->second);
-}
+auto Character::getSkillValue(TYPE_OF_SKILL_ID s) const -> const skillvalue * { return skills.find(s); }
 
 void Character::learn(TYPE_OF_SKILL_ID skill, uint32_t actionPoints, uint8_t opponent) {
     if (!Data::skills().exists(skill)) {
@@ -1020,14 +1070,64 @@ auto Character::maxLoadWeight() const -> unsigned short int {
     return getAttribute(Character::strength) * carryWeightPerStrength + minimumCarryWeight;
 }
 
-auto Character::LoadWeight() const -> int {
-    int load = 0;
+auto Character::ItemSlots::sumWeight() const -> int {
+    int weight = 0;
 
     // alle Items bis auf den Rucksack
-    for (int i = 1; i < MAX_BODY_ITEMS + MAX_BELT_SLOTS; ++i) {
-        load += items.at(i).getWeight();
+    for (size_t i = 1; i < slots.size(); ++i) {
+        weight += slots[i].getWeight();
+    }
+
+    return weight;
+}
+
+auto Character::ItemSlots::weight() const -> int {
+    if (!cachedWeight) {
+        cachedWeight = sumWeight();
     }
 
+    assert(*cachedWeight == sumWeight());
+    return *cachedWeight;
+}
+
+auto Character::ItemSlots::lookUpEquipment() const -> Equipment {
+    Equipment equipment;
+    equipment.weaponGeneration = Data::weaponItems().getGeneration();
+    equipment.armorGeneration = Data::armorItems().getGeneration();
+
+    for (size_t i = 1; i < MAX_BODY_ITEMS; ++i) {
+        const auto id = slots[i].getId();
+
+        if (id == 0) {
+            continue;
+        }
+
+        equipment.weapons[i] = Data::weaponItems().find(id);
+
+        if (const auto *armor = Data::armorItems().find(id); armor != nullptr) {
+            equipment.armors[i] = armor;
+            equipment.punctureArmor += armor->PunctureArmor;
+            equipment.strokeArmor += armor->StrokeArmor;
+            equipment.thrustArmor += armor->ThrustArmor;
+            equipment.magicDisturbance += armor->MagicDisturbance;
+        }
+    }
+
+    return equipment;
+}
+
+auto Character::ItemSlots::equipment() const -> const Equipment & {
+    if (!cachedEquipment || cachedEquipment->weaponGeneration != Data::weaponItems().getGeneration() ||
+        cachedEquipment->armorGeneration != Data::armorItems().getGeneration()) {
+        cachedEquipment = lookUpEquipment();
+    }
+
+    return *cachedEquipment;
+}
+
+auto Character::LoadWeight() const -> int {
+    int load = items.weight();
+
     // Rucksack
     load += weightContainer(items.at(0).getId(), 1, backPackContents);
 
@@ -1257,7 +1357,7 @@ auto Character::move(direction dir, bool active) -> bool {
             // check if there are teleporters or other special flags on this field
             World::checkFieldAfterMove(this, newField);
 
-            World::triggerFieldMove(this, true);
+            World::triggerFieldMove(this, true, newField);
 
             return true;
         }
@@ -1330,6 +1430,7 @@ void Character::teachMagic(unsigned char type, unsigned char flag) {
 }
 
 auto Character::Warp(const position &newPos) -> bool {
+    waypoints.setObserved(true);
     position oldpos = pos;
 
     try {
@@ -1346,6 +1447,7 @@ auto Character::Warp(const position &newPos) -> bool {
 }
 
 auto Character::forceWarp(const position &newPos) -> bool {
+    waypoints.setObserved(true);
     position oldpos = pos;
 
     try {
@@ -1446,7 +1548,8 @@ auto Character::getItemList(TYPE_OF_ITEM_ID id) -> std::vector<ScriptItem> {
 
 auto Character::GetBackPack() const -> Container * { return backPackContents; }
 
-auto Character::GetDepot(uint32_t depotid) const -> Container * {
+auto Character::GetDepot(uint32_t depotid) -> Container * {
+    loadDepot(depotid + 1);
     auto it = depotContents.find(depotid + 1);
 
     if (it == depotContents.end()) {
@@ -1455,6 +1558,16 @@ auto Character::GetDepot(uint32_t depotid) const -> Container * {
     return it->second;
 }
 
+auto Character::depotMemoryUsage() const -> size_t {
+    size_t bytes = 0;
+
+    for (const auto &[id, depot] : depotContents) {
+        bytes += depot->memoryUsage();
+    }
+
+    return bytes;
+}
+
 auto Character::idleTime() const -> uint32_t {
     // Nothing to do here, overloaded in Player
     return 0;
@@ -1503,10 +1616,10 @@ void Character::updateAppearanceForPlayer(Player *target, bool always) {
 
 void Character::updateAppearanceForAll(bool always) {
     if (!isinvisible) {
-        for (const auto &player : World::get()->Players.findAllCharactersInScreen(pos)) {
+        World::get()->Observers.forEachObserverOf(pos, [this, always](Player *player) {
             ServerCommandPointer cmd = std::make_shared<AppearanceTC>(this, player);
             player->sendCharAppearance(id, cmd, always);
-        }
+        });
     }
 }
 
@@ -1520,9 +1633,7 @@ void Character::performAnimation(uint8_t animID) {
     if (!isinvisible) {
         ServerCommandPointer cmd = std::make_shared<AnimationTC>(id, animID);
 
-        for (const auto &player : World::get()->Players.findAllCharactersInScreen(pos)) {
-            player->Connection->addCommand(cmd);
-        }
+        World::get()->Observers.forEachObserverOf(pos, [&cmd](Player *player) { player->Connection->addCommand(cmd); });
     }
 }
 
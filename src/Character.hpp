@@ -24,6 +24,8 @@
 #include "ItemLookAt.hpp"
 #include "Language.hpp"
 #include "LongTimeCharacterEffects.hpp"
+#include "SkillSet.hpp"
+#include "SlotMap.hpp"
 #include "TableStructs.hpp"
 #include "WaypointList.hpp"
 #include "constants.hpp"
@@ -35,8 +37,10 @@
 #include "tuningConstants.hpp"
 
 #include <array>
+#include <bitset>
 #include <fstream>
 #include <map>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
@@ -52,11 +56,6 @@ enum magic_type { MAGE = 0, PRIEST = 1, BARD = 2, DRUID = 3 };
 
 class NoLootFound : public std::exception {};
 
-struct SkillValue {
-    int major = 0;
-    int minor = 0;
-};
-
 class Character {
 public:
     struct appearance {
@@ -182,10 +181,14 @@ public:
 
     inline virtual void setMagicType(magic_type newMagType) { magic.type = newMagType; }
 
-    void setOnRoute(bool onr) { _is_on_route = onr; }
+    void setOnRoute(bool onr);
 
     auto getOnRoute() const -> bool { return _is_on_route; }
 
+    // handle into the world container holding the character, set by the container
+    [[nodiscard]] auto getHandle() const -> SlotHandle { return handle; }
+    void setHandle(SlotHandle newHandle) { handle = newHandle; }
+
     virtual auto getPlayerLanguage() const -> Language { return Language::english; }
 
     inline auto getMagicFlags(unsigned char type) const -> unsigned long int {
@@ -259,9 +262,32 @@ public:
     virtual auto increaseAtPos(unsigned char pos, int count) -> int;
     virtual auto createAtPos(unsigned char pos, TYPE_OF_ITEM_ID newid, int count) -> int;
     virtual auto swapAtPos(unsigned char pos, TYPE_OF_ITEM_ID newid, int newQuality = 0) -> bool;
+
+    // item changes between begin and end send their inventory, backpack and load updates once, when the outermost
+    // batch ends
+    virtual void beginItemBatch() {}
+    virtual void endItemBatch() {}
+
+    class ItemBatch {
+    public:
+        explicit ItemBatch(Character &character) : character(character) { character.beginItemBatch(); }
+        ItemBatch(const ItemBatch &) = delete;
+        auto operator=(const ItemBatch &) -> ItemBatch & = delete;
+        ItemBatch(ItemBatch &&) = delete;
+        auto operator=(ItemBatch &&) -> ItemBatch & = delete;
+        ~ItemBatch() { character.endItemBatch(); }
+
+    private:
+        Character &character;
+    };
+
     virtual auto GetItemAt(unsigned char itempos) -> ScriptItem;
     virtual auto GetBackPack() const -> Container *;
-    auto GetDepot(uint32_t depotid) const -> Container *;
+    auto GetDepot(uint32_t depotid) -> Container *;
+    // brings the depot into depotContents for characters that load their depots on first use
+    virtual void loadDepot(uint32_t depotid) {}
+    // estimated heap bytes of the loaded depots
+    [[nodiscard]] auto depotMemoryUsage() const -> size_t;
     auto getItemList(TYPE_OF_ITEM_ID id) -> std::vector<ScriptItem>;
 
     virtual auto getSkillName(TYPE_OF_SKILL_ID s) const -> std::string;
@@ -291,12 +317,21 @@ public:
     auto getMaxAttributePoints() const -> uint16_t;
     virtual auto saveBaseAttributes() -> bool;
     virtual void handleAttributeChange(Character::attributeIndex attribute);
+    // sends one update for each attribute changed since the last call, see World::flushAttributeUpdates
+    void flushAttributeUpdates();
     auto isBaseAttribValid(const std::string &name, Attribute::attribute_t value) const -> bool;
     auto setBaseAttrib(const std::string &name, Attribute::attribute_t value) -> bool;
     void setAttrib(const std::string &name, Attribute::attribute_t value);
     auto getBaseAttrib(const std::string &name) const -> Attribute::attribute_t;
     auto increaseBaseAttrib(const std::string &name, int amount) -> bool;
     auto increaseAttrib(const std::string &name, int amount) -> Attribute::attribute_t;
+    // script variants of the above taking the attribute constants, indices out of range are ignored
+    auto isBaseAttribValid(attributeIndex attribute, Attribute::attribute_t value) const -> bool;
+    auto setBaseAttrib(attributeIndex attribute, Attribute::attribute_t value) -> bool;
+    void setAttrib(attributeIndex attribute, Attribute::attribute_t value);
+    auto getBaseAttrib(attributeIndex attribute) const -> Attribute::attribute_t;
+    auto increaseBaseAttrib(attributeIndex attribute, int amount) -> bool;
+    auto increaseAttrib(attributeIndex attribute, int amount) -> Attribute::attribute_t;
 
     virtual auto increaseSkill(TYPE_OF_SKILL_ID skill, int amount) -> int;
     virtual auto increaseMinorSkill(TYPE_OF_SKILL_ID skill, int amount) -> int;
@@ -321,6 +356,7 @@ public:
     virtual auto move(direction dir, bool active = true) -> bool;
 
     virtual auto getNextStepDir(const position &goal, direction &dir) const -> bool;
+    // steps of long routes only lead part of the way, a new list is needed once they are walked
     auto getStepList(const position &goal, std::list<direction> &steps) const -> bool;
 
     virtual auto Warp(const position &newPos) -> bool;
@@ -347,7 +383,7 @@ public:
 
     virtual void performAnimation(uint8_t animID);
 
-    using SKILLMAP = std::map<TYPE_OF_SKILL_ID, skillvalue>;
+    using SKILLMAP = SkillSet;
 
     auto GetMovement() const -> movement_type;
     void SetMovement(movement_type tmovement);
@@ -360,12 +396,69 @@ public:
 
     SKILLMAP skills;
 
+    // table entries of the equipped items, nullptr where an item is no weapon or no armor
+    struct Equipment {
+        std::array<const WeaponStruct *, MAX_BODY_ITEMS> weapons{};
+        std::array<const ArmorStruct *, MAX_BODY_ITEMS> armors{};
+        // sums over all armor worn
+        int punctureArmor = 0;
+        int strokeArmor = 0;
+        int thrustArmor = 0;
+        int magicDisturbance = 0;
+        uint32_t weaponGeneration = 0;
+        uint32_t armorGeneration = 0;
+    };
+
+    // the slots behave like a std::array, every non-const access drops the cached weight and equipment
+    class ItemSlots {
+    public:
+        using Slots = std::array<Item, MAX_BODY_ITEMS + MAX_BELT_SLOTS>;
+
+        auto at(size_t pos) -> Item & {
+            invalidate();
+            return slots.at(pos);
+        }
+        [[nodiscard]] auto at(size_t pos) const -> const Item & { return slots.at(pos); }
+        auto operator[](size_t pos) -> Item & {
+            invalidate();
+            return slots[pos];
+        }
+        auto operator[](size_t pos) const -> const Item & { return slots[pos]; }
+
+        auto begin() -> Slots::iterator {
+            invalidate();
+            return slots.begin();
+        }
+        auto end() -> Slots::iterator { return slots.end(); }
+        [[nodiscard]] auto begin() const -> Slots::const_iterator { return slots.begin(); }
+        [[nodiscard]] auto end() const -> Slots::const_iterator { return slots.end(); }
+        [[nodiscard]] static constexpr auto size() -> size_t { return MAX_BODY_ITEMS + MAX_BELT_SLOTS; }
+
+        // weight of all slots but the backpack, a debug build checks the cached value against the slots
+        [[nodiscard]] auto weight() const -> int;
+        // looked up again after a change of the slots or a reload of the weapon or armor table, safe to call
+        // concurrently for distinct characters
+        [[nodiscard]] auto equipment() const -> const Equipment &;
+
+    private:
+        Slots slots{};
+        mutable std::optional<int> cachedWeight;
+        mutable std::optional<Equipment> cachedEquipment;
+
+        void invalidate() {
+            cachedWeight.reset();
+            cachedEquipment.reset();
+        }
+        [[nodiscard]] auto sumWeight() const -> int;
+        [[nodiscard]] auto lookUpEquipment() const -> Equipment;
+    };
+
     /**
      * array for the items of the character
      * 0 = backpack, 1 to MAX_BODY_ITEMS - 1: equipped items
      * MAX_BODY_ITEMS - 1 to MAX_BODY_ITEMS + MAX_BELT_SLOTS - 1: items in the belt
      */
-    std::array<Item, MAX_BODY_ITEMS + MAX_BELT_SLOTS> items = {};
+    ItemSlots items;
 
     Container *backPackContents{nullptr};
 
@@ -376,7 +469,16 @@ public:
      */
     std::map<uint32_t, Container *> depotContents;
 
-    virtual void ageInventory();
+    // slots changed by ageItems
+    struct InventoryAgeing {
+        std::bitset<MAX_BODY_ITEMS + MAX_BELT_SLOTS> slots;
+    };
+
+    void ageInventory() { inventoryAged(ageItems()); }
+    // ageing of the inventory, backpack and depots alone, safe to run concurrently for distinct characters
+    auto ageItems() -> InventoryAgeing;
+    // sends what ageItems changed to the client, game thread only
+    virtual void inventoryAged(const InventoryAgeing &ageing) {}
 
     inline auto isAlive() const -> bool { return alive; }
 
@@ -390,6 +492,7 @@ public:
 
     auto maxLoadWeight() const -> unsigned short int;
     auto LoadWeight() const -> int;
+    [[nodiscard]] auto getEquipment() const -> const Equipment & { return items.equipment(); }
     auto relativeLoad() const -> double;
 
     enum class LoadLevel { unburdened, burdened, overtaxed };
@@ -436,6 +539,9 @@ public:
     virtual auto getLoot() const -> const MonsterStruct::loottype &;
 
 protected:
+    // moves characters along their routes without entering fields while nobody watches
+    friend class WaypointList;
+
     struct RaceStruct {
         std::string racename;
         unsigned short int points;
@@ -471,6 +577,7 @@ protected:
     void setMagicFlags(magic_type type, uint64_t flags);
 
     bool _is_on_route = false;
+    SlotHandle handle;
     int poisonvalue = 0;
     int mental_capacity = 0;
     World *_world;
@@ -481,6 +588,11 @@ protected:
     virtual auto getMoveTime(const map::Field &targetField, bool diagonalMove, bool running) const
             -> TYPE_OF_WALKINGCOST;
 
+    // the update is sent by flushAttributeUpdates, so repeated changes within a tick cost a single one
+    void markAttributeChanged(attributeIndex attribute);
+    // changed holds a bit for each attribute index
+    virtual void sendAttributeUpdates(uint32_t changed);
+
     auto canTalk(talk_type tt) const -> bool;
     static /*consteval*/ auto talkCost(talk_type tt) -> int;
     void logTalk(talk_type tt, const std::string &message) const;
@@ -489,10 +601,13 @@ protected:
     appearance _appearance;
 
 private:
+    static auto isAttribute(attributeIndex attribute) -> bool;
+
     TYPE_OF_CHARACTER_ID id = 0;
     std::string name;
     movement_type _movement = movement_type::walk;
     std::vector<Attribute> attributes;
+    uint32_t changedAttributes = 0;
     bool alive = true;
     int actionPoints = NP_MAX_AP;
     int fightPoints = NP_MAX_FP;
@@ -23,25 +23,71 @@
 #include "Player.hpp"
 #include "globals.hpp"
 
-#include <cmath>
-#include <map>
-#include <range/v3/all.hpp>
+#include <algorithm>
 #include <unordered_map>
 
-template <class T> auto CharacterContainer<T>::getPosition(TYPE_OF_CHARACTER_ID id, position &pos) -> bool {
-    auto i = container.find(id);
-    if (i != container.end()) {
-        pos = (i->second)->getPosition();
-        return true;
+template <class T>
+auto CharacterContainer<T>::cellKey(Coordinate cellX, Coordinate cellY, Coordinate z) -> cell_key_type {
+    constexpr auto zShift = 32;
+    constexpr auto xShift = 16;
+    return (static_cast<cell_key_type>(static_cast<uint16_t>(z)) << zShift) |
+           (static_cast<cell_key_type>(static_cast<uint16_t>(cellX)) << xShift) | static_cast<uint16_t>(cellY);
+}
+
+template <class T> auto CharacterContainer<T>::cellOf(const position &pos) -> cell_key_type {
+    return cellKey(pos.x >> cellBits, pos.y >> cellBits, pos.z);
+}
+
+template <class T> void CharacterContainer<T>::addToGrid(pointer p, const position &pos) {
+    auto &cell = grid[cellOf(pos)];
+    cell.characters.push_back(p);
+    cell.x.push_back(static_cast<int16_t>(pos.x));
+    cell.y.push_back(static_cast<int16_t>(pos.y));
+    cell.z.push_back(static_cast<int16_t>(pos.z));
+}
+
+template <class T> void CharacterContainer<T>::removeFromGrid(pointer p, const position &pos) {
+    const auto cell = grid.find(cellOf(pos));
+
+    if (cell == grid.end()) {
+        return;
+    }
+
+    auto &[characters, x, y, z] = cell->second;
+    const auto it = std::find(characters.begin(), characters.end(), p);
+
+    if (it != characters.end()) {
+        const auto index = it - characters.begin();
+        characters[index] = characters.back();
+        x[index] = x.back();
+        y[index] = y.back();
+        z[index] = z.back();
+        characters.pop_back();
+        x.pop_back();
+        y.pop_back();
+        z.pop_back();
     }
-    return false;
 }
 
 template <class T>
-auto CharacterContainer<T>::projection_x_axis(const position &pos, int r) const
-        -> iterator_range<typename CharacterContainer<T>::position_to_id_type::const_iterator> {
-    return {{position_to_id.upper_bound(position(pos.x - r - 1, 0, 0)),
-             position_to_id.upper_bound(position(pos.x + r + 1, 0, 0))}};
+void CharacterContainer<T>::filterBox(const Cell &cell, size_t first, size_t count, const position &pos,
+                                      Coordinate radius, Coordinate zRadius, uint8_t *hits) {
+    // branch free over the lanes, so the compiler can vectorise it
+    const int16_t *x = cell.x.data() + first;
+    const int16_t *y = cell.y.data() + first;
+    const int16_t *z = cell.z.data() + first;
+    const int centerX = pos.x;
+    const int centerY = pos.y;
+    const int centerZ = pos.z;
+    const int xyRadius = radius;
+    const int levelRadius = zRadius;
+
+    for (size_t i = 0; i < count; ++i) {
+        const int dx = std::abs(x[i] - centerX);
+        const int dy = std::abs(y[i] - centerY);
+        const int dz = std::abs(z[i] - centerZ);
+        hits[i] = static_cast<uint8_t>((dx <= xyRadius) & (dy <= xyRadius) & (dz <= levelRadius));
+    }
 }
 
 template <class T> auto CharacterContainer<T>::find(const std::string &name) const -> pointer {
@@ -51,13 +97,10 @@ template <class T> auto CharacterContainer<T>::find(const std::string &name) con
         return find(id);
     }
 
-    using namespace ranges;
-    auto namesMatch = [&name](pointer character) { return comparestrings_nocase(character->getName(), name); };
-    auto characters = container | view::values;
-    auto result = find_if(characters, namesMatch);
+    const auto it = names.find(fold_case(name));
 
-    if (result != characters.end()) {
-        return *result;
+    if (it != names.end()) {
+        return it->second;
     }
 
     return nullptr;
@@ -67,96 +110,140 @@ template <class T> auto CharacterContainer<T>::find(TYPE_OF_CHARACTER_ID id) con
     const auto it = container.find(id);
 
     if (it != container.end()) {
-        return it->second;
+        return it->second.character;
     }
 
     return nullptr;
 }
 
+template <class T> auto CharacterContainer<T>::find(SlotHandle handle) const -> pointer {
+    const auto *character = characters.get(handle);
+    return character != nullptr ? *character : nullptr;
+}
+
 template <class T> auto CharacterContainer<T>::find(const position &pos) const -> pointer {
-    const auto i = position_to_id.find(pos);
+    const auto cell = grid.find(cellOf(pos));
 
-    if (i != position_to_id.end()) {
-        return find(i->second);
+    if (cell != grid.end()) {
+        const auto &[characters, x, y, z] = cell->second;
+
+        for (size_t i = 0; i < characters.size(); ++i) {
+            if (x[i] == pos.x && y[i] == pos.y && z[i] == pos.z) {
+                return characters[i];
+            }
+        }
     }
+
     return nullptr;
 }
 
 template <class T> void CharacterContainer<T>::update(pointer p, const position &newPosition) {
-    const auto id = p->getId();
-
-    if (!find(id)) {
+    // the handle spares the lookup by id on every step
+    if (find(p->getHandle()) != p) {
         return;
     }
 
     const auto &oldPosition = p->getPosition();
-    const auto range = position_to_id.equal_range(oldPosition);
+    const auto cell = grid.find(cellOf(oldPosition));
 
-    for (auto it = range.first; it != range.second; ++it) {
-        if (it->second == id) {
-            position_to_id.erase(it);
-            position_to_id.insert(std::make_pair(newPosition, id));
+    if (cell != grid.end() && cellOf(newPosition) == cell->first) {
+        auto &[characters, x, y, z] = cell->second;
+        const auto it = std::find(characters.begin(), characters.end(), p);
+
+        if (it != characters.end()) {
+            const auto index = it - characters.begin();
+            x[index] = static_cast<int16_t>(newPosition.x);
+            y[index] = static_cast<int16_t>(newPosition.y);
+            z[index] = static_cast<int16_t>(newPosition.z);
             return;
         }
     }
+
+    removeFromGrid(p, oldPosition);
+    addToGrid(p, newPosition);
 }
 
 template <class T> auto CharacterContainer<T>::erase(TYPE_OF_CHARACTER_ID id) -> bool {
-    position pos{};
+    const auto it = container.find(id);
+
+    if (it == container.end()) {
+        return false;
+    }
 
-    if (getPosition(id, pos)) {
-        const auto range = position_to_id.equal_range(pos);
+    auto *character = it->second.character;
+    removeFromGrid(character, character->getPosition());
+    const auto namesakes = names.equal_range(fold_case(character->getName()));
 
-        for (auto it = range.first; it != range.second; ++it) {
-            if (it->second == id) {
-                position_to_id.erase(it);
-                break;
-            }
+    for (auto namesake = namesakes.first; namesake != namesakes.second; ++namesake) {
+        if (namesake->second == character) {
+            names.erase(namesake);
+            break;
         }
     }
 
-    return container.erase(id) > 0;
+    characters.erase(it->second.handle);
+    awake.erase(it->second.awakeHandle);
+    dormant.erase(id);
+    character->setHandle({});
+    container.erase(it);
+    return true;
+}
+
+template <class T> auto CharacterContainer<T>::sleep(TYPE_OF_CHARACTER_ID id, uint32_t tick) -> pointer {
+    const auto it = container.find(id);
+
+    if (it == container.end() || !awake.erase(it->second.awakeHandle)) {
+        return nullptr;
+    }
+
+    it->second.awakeHandle = {};
+    dormant.emplace(id, tick);
+    return it->second.character;
+}
+
+template <class T> auto CharacterContainer<T>::wake(TYPE_OF_CHARACTER_ID id) -> pointer {
+    if (dormant.erase(id) == 0) {
+        return nullptr;
+    }
+
+    auto &entry = container.at(id);
+    entry.awakeHandle = awake.insert(entry.character);
+    return entry.character;
+}
+
+template <class T> auto CharacterContainer<T>::findDormancy(TYPE_OF_CHARACTER_ID id) -> uint32_t * {
+    const auto it = dormant.find(id);
+    return it == dormant.end() ? nullptr : &it->second;
+}
+
+template <class T>
+void CharacterContainer<T>::findDormantInRangeOf(const position &pos, Coordinate radius,
+                                                 std::vector<TYPE_OF_CHARACTER_ID> &result) const {
+    if (dormant.empty()) {
+        return;
+    }
+
+    forEachInBox(pos, radius, 0, [this, &result](pointer character) {
+        const auto id = character->getId();
+
+        if (dormant.count(id) > 0) {
+            result.push_back(id);
+        }
+    });
 }
 
 template <class T>
 auto CharacterContainer<T>::findAllCharactersInRangeOf(const position &pos, const Range &range) const
         -> std::vector<pointer> {
     std::vector<pointer> temp;
-    auto candidates = projection_x_axis(pos, range.radius);
-
-    for (auto &c : candidates) {
-        const position &p = c.first;
-        TYPE_OF_CHARACTER_ID id = c.second;
-        short int dx = p.x - pos.x;
-        short int dy = p.y - pos.y;
-        short int dz = p.z - pos.z;
-
-        if (std::abs(dx) <= range.radius && std::abs(dy) <= range.radius && -range.zRadius <= dz &&
-            dz <= range.zRadius) {
-            if (auto *character = find(id)) {
-                temp.push_back(character);
-            }
-        }
-    }
-
+    findAllCharactersInRangeOf(pos, range, temp);
     return temp;
 }
 
 template <class T>
 auto CharacterContainer<T>::findAllCharactersInScreen(const position &pos) const -> std::vector<pointer> {
     std::vector<pointer> temp;
-    auto candidates = projection_x_axis(pos, MAX_SCREEN_RANGE);
-
-    for (auto &c : candidates) {
-        TYPE_OF_CHARACTER_ID id = c.second;
-
-        if (auto *character = find(id)) {
-            if (character->isInScreen(pos)) {
-                temp.push_back(character);
-            }
-        }
-    }
-
+    findAllCharactersInScreen(pos, temp);
     return temp;
 }
 
@@ -164,28 +251,27 @@ template <class T>
 auto CharacterContainer<T>::findAllAliveCharactersInRangeOf(const position &pos, const Range &range) const
         -> std::vector<pointer> {
     std::vector<pointer> temp;
-    auto candidates = projection_x_axis(pos, range.radius);
-
-    for (auto &c : candidates) {
-        const position &p = c.first;
-        TYPE_OF_CHARACTER_ID id = c.second;
-        short int dx = p.x - pos.x;
-        short int dy = p.y - pos.y;
-        short int dz = p.z - pos.z;
-
-        if (std::abs(dx) <= range.radius && std::abs(dy) <= range.radius && -range.zRadius <= dz &&
-            dz <= range.zRadius) {
-            if (auto *character = find(id)) {
-                if (character->isAlive()) {
-                    temp.push_back(character);
-                }
-            }
-        }
-    }
-
+    findAllAliveCharactersInRangeOf(pos, range, temp);
     return temp;
 }
 
+template <class T>
+void CharacterContainer<T>::findAllCharactersInRangeOf(const position &pos, const Range &range,
+                                                       std::vector<pointer> &result) const {
+    forEachCharacterInRangeOf(pos, range, [&result](pointer character) { result.push_back(character); });
+}
+
+template <class T>
+void CharacterContainer<T>::findAllCharactersInScreen(const position &pos, std::vector<pointer> &result) const {
+    forEachCharacterInScreen(pos, [&result](pointer character) { result.push_back(character); });
+}
+
+template <class T>
+void CharacterContainer<T>::findAllAliveCharactersInRangeOf(const position &pos, const Range &range,
+                                                            std::vector<pointer> &result) const {
+    forEachAliveCharacterInRangeOf(pos, range, [&result](pointer character) { result.push_back(character); });
+}
+
 template class CharacterContainer<Character>;
 template class CharacterContainer<Player>;
 template class CharacterContainer<Monster>;
@@ -19,10 +19,15 @@
 #ifndef CHARACTERCONTAINER_HPP
 #define CHARACTERCONTAINER_HPP
 
+#include "MemoryUsage.hpp"
+#include "SlotMap.hpp"
 #include "constants.hpp"
 #include "globals.hpp"
 #include "utility.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <unordered_map>
@@ -35,54 +40,212 @@ public:
 private:
     using for_each_type = std::function<void(pointer)>;
     using for_each_member_type = void (T::*)();
-    using container_type = std::unordered_map<TYPE_OF_CHARACTER_ID, pointer>;
-    using position_to_id_type = std::multimap<position, TYPE_OF_CHARACTER_ID, PositionComparison>;
-    position_to_id_type position_to_id;
+    using cell_key_type = uint64_t;
+
+    struct Entry {
+        pointer character;
+        SlotHandle handle;
+        // invalid while the character is dormant
+        SlotHandle awakeHandle;
+    };
+
+    using container_type = std::unordered_map<TYPE_OF_CHARACTER_ID, Entry>;
+
+    // characters of a cell with their positions stored as packed lanes, so distance filters run over plain arrays
+    struct Cell {
+        std::vector<pointer> characters;
+        std::vector<int16_t> x;
+        std::vector<int16_t> y;
+        std::vector<int16_t> z;
+    };
+
+    using grid_type = std::unordered_map<cell_key_type, Cell>;
+    using name_index_type = std::unordered_multimap<std::string, pointer>;
+    using dormant_type = std::unordered_map<TYPE_OF_CHARACTER_ID, uint32_t>;
+
+    // characters are bucketed into square cells of 2^cellBits fields per level
+    static constexpr int cellBits = 4;
+    // lanes are filtered in blocks of this many characters
+    static constexpr size_t filterBlock = 64;
+
+    grid_type grid;
+    // dense storage for_each iterates, handles are what character_ptr validates against
+    SlotMap<pointer> characters;
+    // entries by id
     container_type container;
+    // keyed by fold_case of the name, names are not unique for monsters and npcs
+    name_index_type names;
+    // characters for_each_awake visits, without the dormant ones
+    SlotMap<pointer> awake;
+    // dormant characters mapped to the tick they fell asleep at
+    dormant_type dormant;
 
-    auto getPosition(TYPE_OF_CHARACTER_ID id, position &pos) -> bool;
-    [[nodiscard]] auto projection_x_axis(const position &pos, int r) const
-            -> iterator_range<position_to_id_type::const_iterator>;
+    static auto cellKey(Coordinate cellX, Coordinate cellY, Coordinate z) -> cell_key_type;
+    static auto cellOf(const position &pos) -> cell_key_type;
+    void addToGrid(pointer p, const position &pos);
+    void removeFromGrid(pointer p, const position &pos);
+    // sets hits[i] for the characters first + i of cell, i < count, that lie within the box
+    static void filterBox(const Cell &cell, size_t first, size_t count, const position &pos, Coordinate radius,
+                          Coordinate zRadius, uint8_t *hits);
+    // calls visit for every character within radius in x and y and within zRadius in z
+    template <class Visitor>
+    void forEachInBox(const position &pos, Coordinate radius, Coordinate zRadius, Visitor &&visit) const;
 
 public:
     [[nodiscard]] auto empty() const -> bool { return container.empty(); }
 
     auto size() const -> decltype(container.size()) { return container.size(); }
 
+    // estimated heap bytes of the indexes, without the characters themselves
+    [[nodiscard]] auto memoryUsage() const -> size_t {
+        auto bytes = characters.memoryUsage() + awake.memoryUsage() + memory::ofHashed(container) +
+                     memory::ofHashed(grid) + memory::ofHashed(names) + memory::ofHashed(dormant);
+
+        for (const auto &[key, cell] : grid) {
+            bytes += memory::of(cell.characters) + memory::of(cell.x) + memory::of(cell.y) + memory::of(cell.z);
+        }
+
+        for (const auto &[name, character] : names) {
+            bytes += memory::of(name);
+        }
+
+        return bytes;
+    }
+
     void insert(pointer p) {
         const auto id = p->getId();
 
         if (!find(id)) {
-            container.emplace(id, p);
-            position_to_id.insert(std::make_pair(p->getPosition(), id));
+            const auto handle = characters.insert(p);
+            container.emplace(id, Entry{p, handle, awake.insert(p)});
+            p->setHandle(handle);
+            addToGrid(p, p->getPosition());
+            names.emplace(fold_case(p->getName()), p);
         }
     }
 
     auto find(const std::string &name) const -> pointer;
     auto find(TYPE_OF_CHARACTER_ID id) const -> pointer;
     auto find(const position &pos) const -> pointer;
+    // O(1), nullptr if the character the handle was taken from left this container
+    auto find(SlotHandle handle) const -> pointer;
     void update(pointer p, const position &newPosition);
     auto erase(TYPE_OF_CHARACTER_ID id) -> bool;
     void clear() {
+        characters.clear();
         container.clear();
-        position_to_id.clear();
+        grid.clear();
+        names.clear();
+        awake.clear();
+        dormant.clear();
     }
 
+    // dormant characters are left out by for_each_awake until woken, both return nullptr if there was nothing to do
+    auto sleep(TYPE_OF_CHARACTER_ID id, uint32_t tick) -> pointer;
+    auto wake(TYPE_OF_CHARACTER_ID id) -> pointer;
+    // the tick a dormant character fell asleep at, nullptr if it is awake or unknown
+    auto findDormancy(TYPE_OF_CHARACTER_ID id) -> uint32_t *;
+    // appends the dormant characters within radius in x and y and on the level of pos
+    void findDormantInRangeOf(const position &pos, Coordinate radius, std::vector<TYPE_OF_CHARACTER_ID> &result) const;
+
     auto findAllCharactersInRangeOf(const position &pos, const Range &range) const -> std::vector<pointer>;
     auto findAllCharactersInScreen(const position &pos) const -> std::vector<pointer>;
     auto findAllAliveCharactersInRangeOf(const position &pos, const Range &range) const -> std::vector<pointer>;
 
+    // these append to result, so callers can reuse one buffer
+    void findAllCharactersInRangeOf(const position &pos, const Range &range, std::vector<pointer> &result) const;
+    void findAllCharactersInScreen(const position &pos, std::vector<pointer> &result) const;
+    void findAllAliveCharactersInRangeOf(const position &pos, const Range &range, std::vector<pointer> &result) const;
+
+    // visitors must not insert, erase or move characters of this container
+    template <class Visitor>
+    void forEachCharacterInRangeOf(const position &pos, const Range &range, Visitor &&visit) const;
+    template <class Visitor> void forEachCharacterInScreen(const position &pos, Visitor &&visit) const;
+    template <class Visitor>
+    void forEachAliveCharacterInRangeOf(const position &pos, const Range &range, Visitor &&visit) const;
+
     void for_each(const for_each_type &function) const {
-        for (const auto &key_value : container) {
-            function(key_value.second);
+        for (auto *character : characters) {
+            function(character);
         }
     }
 
     void for_each(const for_each_member_type &function) const {
-        for (const auto &key_value : container) {
-            (key_value.second->*function)();
+        for (auto *character : characters) {
+            (character->*function)();
+        }
+    }
+
+    // function must not sleep or wake characters
+    void for_each_awake(const for_each_type &function) const {
+        for (auto *character : awake) {
+            function(character);
         }
     }
 };
 
+template <class T>
+template <class Visitor>
+void CharacterContainer<T>::forEachInBox(const position &pos, Coordinate radius, Coordinate zRadius,
+                                         Visitor &&visit) const {
+    std::array<uint8_t, filterBlock> hits{};
+    const Coordinate firstX = (pos.x - radius) >> cellBits;
+    const Coordinate lastX = (pos.x + radius) >> cellBits;
+    const Coordinate firstY = (pos.y - radius) >> cellBits;
+    const Coordinate lastY = (pos.y + radius) >> cellBits;
+
+    for (Coordinate z = pos.z - zRadius; z <= pos.z + zRadius; ++z) {
+        for (Coordinate x = firstX; x <= lastX; ++x) {
+            for (Coordinate y = firstY; y <= lastY; ++y) {
+                const auto cell = grid.find(cellKey(x, y, z));
+
+                if (cell == grid.end()) {
+                    continue;
+                }
+
+                const auto &characters = cell->second.characters;
+
+                for (size_t first = 0; first < characters.size(); first += filterBlock) {
+                    const auto count = std::min(filterBlock, characters.size() - first);
+                    filterBox(cell->second, first, count, pos, radius, zRadius, hits.data());
+
+                    for (size_t i = 0; i < count; ++i) {
+                        if (hits[i] != 0) {
+                            visit(characters[first + i]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <class T>
+template <class Visitor>
+void CharacterContainer<T>::forEachCharacterInRangeOf(const position &pos, const Range &range,
+                                                      Visitor &&visit) const {
+    forEachInBox(pos, range.radius, range.zRadius, visit);
+}
+
+template <class T>
+template <class Visitor>
+void CharacterContainer<T>::forEachCharacterInScreen(const position &pos, Visitor &&visit) const {
+    forEachInBox(pos, MAX_SCREEN_RANGE, RANGEUP, [&pos, &visit](pointer character) {
+        if (character->isInScreen(pos)) {
+            visit(character);
+        }
+    });
+}
+
+template <class T>
+template <class Visitor>
+void CharacterContainer<T>::forEachAliveCharacterInRangeOf(const position &pos, const Range &range,
+                                                           Visitor &&visit) const {
+    forEachCharacterInRangeOf(pos, range, [&visit](pointer character) {
+        if (character->isAlive()) {
+            visit(character);
+        }
+    });
+}
+
 #endif
@@ -0,0 +1,92 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "CommandTable.hpp"
+
+namespace {
+constexpr int seedsPerSize = 64;
+
+auto hash(std::string_view name, uint64_t seed) -> uint64_t {
+    // FNV-1a followed by a splitmix64 finaliser, so that the seed changes every slot
+    constexpr uint64_t offset = 0xcbf29ce484222325ULL;
+    constexpr uint64_t prime = 0x100000001b3ULL;
+    uint64_t value = offset ^ seed;
+
+    for (const char c : name) {
+        value = (value ^ static_cast<unsigned char>(c)) * prime;
+    }
+
+    value = (value ^ (value >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27U)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31U);
+}
+} // namespace
+
+auto CommandTable::operator[](const std::string &name) -> CommandType & {
+    slots.clear();
+    return commands[name];
+}
+
+void CommandTable::build() {
+    slots.clear();
+
+    if (commands.empty()) {
+        return;
+    }
+
+    size_t size = 1;
+
+    while (size < 2 * commands.size()) {
+        size *= 2;
+    }
+
+    for (;; size *= 2) {
+        for (seed = 0; seed < seedsPerSize; ++seed) {
+            slots.assign(size, nullptr);
+            bool collides = false;
+
+            for (const auto &entry : commands) {
+                auto &slot = slots[slotOf(entry.first)];
+
+                if (slot != nullptr) {
+                    collides = true;
+                    break;
+                }
+
+                slot = &entry;
+            }
+
+            if (!collides) {
+                return;
+            }
+        }
+    }
+}
+
+auto CommandTable::find(std::string_view name) const -> const CommandType * {
+    if (slots.empty()) {
+        const auto it = commands.find(name);
+        return it != commands.end() ? &it->second : nullptr;
+    }
+
+    const auto *entry = slots[slotOf(name)];
+    return entry != nullptr && entry->first == name ? &entry->second : nullptr;
+}
+
+auto CommandTable::slotOf(std::string_view name) const -> size_t { return hash(name, seed) & (slots.size() - 1); }
@@ -0,0 +1,58 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef COMMAND_TABLE_HPP
+#define COMMAND_TABLE_HPP
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class Player;
+class World;
+
+/**
+ * a class for holding gm or player commands
+ */
+using CommandType = std::function<bool(World *, Player *, const std::string &)>;
+
+// Chat commands by name. After build, a lookup costs one hash and at most one comparison, since the index is sized
+// and seeded so that no two names share a slot.
+class CommandTable {
+public:
+    // adds the command if it is missing, the index has to be built again afterwards
+    auto operator[](const std::string &name) -> CommandType &;
+    void build();
+    [[nodiscard]] auto find(std::string_view name) const -> const CommandType *;
+
+private:
+    using Entry = std::map<std::string, CommandType, std::less<>>::value_type;
+
+    // references into a map stay valid while commands are added, so aliases can be assigned from other commands
+    std::map<std::string, CommandType, std::less<>> commands;
+    std::vector<const Entry *> slots;
+    uint64_t seed = 0;
+
+    [[nodiscard]] auto slotOf(std::string_view name) const -> size_t;
+};
+
+#endif
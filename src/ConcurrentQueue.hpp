@@ -0,0 +1,139 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef CONCURRENT_QUEUE_HPP
+#define CONCURRENT_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Unbounded FIFO queue for handing items between threads. Items live in a ring buffer that only grows, so pushing
+// does not allocate once the queue has reached its working size. Consumers can poll or block until items arrive.
+template <class T> class ConcurrentQueue {
+public:
+    void push(T item) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (count == ring.size()) {
+                grow();
+            }
+
+            ring[(head + count) % ring.size()] = std::move(item);
+            ++count;
+        }
+
+        available.notify_one();
+    }
+
+    // returns false right away if there is nothing to take
+    auto tryPop(T &item) -> bool {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (count == 0) {
+            return false;
+        }
+
+        item = take();
+        return true;
+    }
+
+    // blocks until there is an item, returns false once the queue is closed and empty
+    auto pop(T &item) -> bool {
+        std::unique_lock<std::mutex> lock(mutex);
+        available.wait(lock, [this] { return count > 0 || closed; });
+
+        if (count == 0) {
+            return false;
+        }
+
+        item = take();
+        return true;
+    }
+
+    // blocks like pop, then appends all queued items to items at once
+    auto drain(std::vector<T> &items) -> bool {
+        std::unique_lock<std::mutex> lock(mutex);
+        available.wait(lock, [this] { return count > 0 || closed; });
+
+        if (count == 0) {
+            return false;
+        }
+
+        items.reserve(items.size() + count);
+
+        while (count > 0) {
+            items.push_back(take());
+        }
+
+        return true;
+    }
+
+    // wakes all waiting consumers, they still get what is left in the queue
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+
+        available.notify_all();
+    }
+
+    [[nodiscard]] auto empty() const -> bool {
+        std::lock_guard<std::mutex> lock(mutex);
+        return count == 0;
+    }
+
+    [[nodiscard]] auto size() const -> size_t {
+        std::lock_guard<std::mutex> lock(mutex);
+        return count;
+    }
+
+private:
+    static constexpr size_t initialCapacity = 16;
+
+    mutable std::mutex mutex;
+    std::condition_variable available;
+    std::vector<T> ring;
+    size_t head = 0;
+    size_t count = 0;
+    bool closed = false;
+
+    auto take() -> T {
+        T item = std::exchange(ring[head], T{});
+        head = (head + 1) % ring.size();
+        --count;
+        return item;
+    }
+
+    void grow() {
+        std::vector<T> larger(ring.empty() ? initialCapacity : 2 * ring.size());
+
+        for (size_t i = 0; i < count; ++i) {
+            larger[i] = std::move(ring[(head + i) % ring.size()]);
+        }
+
+        ring = std::move(larger);
+        head = 0;
+    }
+};
+
+#endif
@@ -82,8 +82,90 @@ public:
 
     const ConfigEntry<std::string> datadir{"datadir", "./data/"};
     const ConfigEntry<std::string> scriptdir{"scriptdir", "./script/"};
+    // least important priority per facility, e.g. Script=debug,Chat=warning, limited by the compiled LOG_FLOOR
+    const ConfigEntry<std::string> log_levels{"log_levels", ""};
 
     const ConfigEntry<uint16_t> port{"port", 3012};
+    // HTTP port serving metrics in the Prometheus format, 0 turns the endpoint off
+    const ConfigEntry<uint16_t> metrics_port{"metrics_port", 0};
+    // threads running socket reads and writes
+    const ConfigEntry<uint16_t> io_threads{"io_threads", 1};
+    // cores the threads of each kind may run on, like 2 or 0-3,8; empty leaves them to the scheduler. Database threads
+    // include the player save thread, worker threads are those of pathfinding and background map saves
+    const ConfigEntry<std::string> game_thread_cores{"game_thread_cores", ""};
+    const ConfigEntry<std::string> io_thread_cores{"io_thread_cores", ""};
+    const ConfigEntry<std::string> database_thread_cores{"database_thread_cores", ""};
+    const ConfigEntry<std::string> login_thread_cores{"login_thread_cores", ""};
+    const ConfigEntry<std::string> worker_thread_cores{"worker_thread_cores", ""};
+    // allocates the world on the NUMA node of the game thread even if the server runs under an interleave policy,
+    // best together with game_thread_cores on the cores of a single node
+    const ConfigEntry<bool> numa_local_world{"numa_local_world", false};
+    // huge pages for the fields of the maps: off, transparent, or reserved to take them from the pool set aside with
+    // vm.nr_hugepages, falling back to transparent ones once it is used up
+    const ConfigEntry<std::string> huge_pages{"huge_pages", "off"};
+    // queued commands are written together up to this many bytes
+    const ConfigEntry<uint32_t> send_batch_bytes{"send_batch_bytes", 65536};
+    // hold back commands until the end of the game loop tick, so each tick needs one write per client
+    const ConfigEntry<bool> send_once_per_tick{"send_once_per_tick", false};
+    // beyond this many queued bytes effects are dropped, beyond four times as many the client is disconnected
+    const ConfigEntry<uint32_t> send_queue_bytes{"send_queue_bytes", 1048576};
+    // clients asking for it get commands of at least this many bytes deflated, 0 turns compression off
+    const ConfigEntry<uint16_t> compression_threshold{"compression_threshold", 1024};
+    // acceptors bound to the port with SO_REUSEPORT, so that the kernel spreads new connections over them
+    const ConfigEntry<uint16_t> acceptors{"acceptors", 1};
+    // new connections accepted per second in total and per address, 0 means unlimited
+    const ConfigEntry<uint16_t> accept_per_second{"accept_per_second", 50};
+    const ConfigEntry<uint16_t> accept_per_second_per_ip{"accept_per_second_per_ip", 1};
+    // connections an address may open at once before accept_per_second_per_ip applies
+    const ConfigEntry<uint16_t> accept_burst_per_ip{"accept_burst_per_ip", 5};
+    // seconds a new connection has to send its login command
+    const ConfigEntry<uint16_t> login_timeout{"login_timeout", 100};
+    // threads loading the characters of logging in players from the database
+    const ConfigEntry<uint16_t> login_threads{"login_threads", 4};
+    // seconds a disconnected player stays loaded to resume the session on reconnect, 0 logs out right away
+    const ConfigEntry<uint16_t> session_resume_grace{"session_resume_grace", 0};
+
+    // milliseconds a game loop tick may take before low priority work like NPCs and ageing is deferred
+    const ConfigEntry<uint16_t> tick_budget{"tick_budget", 50};
+    const ConfigEntry<bool> shed_overload{"shed_overload", true};
+    // milliseconds after which a tick's trace is written to trace_dir, at most once a minute, 0 turns this off
+    const ConfigEntry<uint16_t> trace_slow_tick{"trace_slow_tick", 0};
+    const ConfigEntry<std::string> trace_dir{"trace_dir", "./"};
+    // seconds without a game loop round until the stacks of the game thread are logged, 0 turns this off
+    const ConfigEntry<uint16_t> watchdog_threshold{"watchdog_threshold", 10};
+    const ConfigEntry<bool> watchdog_monitoring{"watchdog_monitoring", true};
+    // stack samples of the game thread per second for !profile, 0 leaves the sampling profiler off until started
+    const ConfigEntry<uint16_t> profile_frequency{"profile_frequency", 0};
+    // file the client commands of all players are recorded to for replays, chat included, empty turns this off
+    const ConfigEntry<std::string> session_recording{"session_recording", ""};
+    // long time effects called per tick over all characters, those due beyond it wait for the next tick
+    const ConfigEntry<uint16_t> long_time_effect_budget{"long_time_effect_budget", 2000};
+    // threads searching the paths of monsters and NPCs, 0 searches on the game thread
+    const ConfigEntry<uint16_t> pathfinding_threads{"pathfinding_threads", 1};
+    // publishes a read-only copy of the terrain near players and of all character positions after every tick, which
+    // worker threads can read without locks
+    const ConfigEntry<bool> world_view{"world_view", false};
+    // seconds between logs of the memory pools of monsters and NPCs, 0 turns the log off
+    const ConfigEntry<uint32_t> object_pool_log_interval{"object_pool_log_interval", 3600};
+    // look-ats of items without their own script cached per item state and language, 0 turns the cache off
+    const ConfigEntry<uint32_t> look_at_cache_size{"look_at_cache_size", 10000};
+    // look-ats a player may have scripts run for per second, beyond it only cached results are sent, 0 is unlimited
+    const ConfigEntry<uint16_t> look_at_scripts_per_second{"look_at_scripts_per_second", 20};
+    // milliseconds a Lua call may run before it is aborted, 0 lets calls run as long as they like
+    const ConfigEntry<uint16_t> lua_call_budget{"lua_call_budget", 1000};
+    // seconds between logs of the Lua scripts taking the most time, 0 turns the log off
+    const ConfigEntry<uint32_t> lua_profile_interval{"lua_profile_interval", 3600};
+    // "incremental" or "generational", the latter only where the Lua version has it
+    const ConfigEntry<std::string> lua_gc_mode{"lua_gc_mode", "incremental"};
+    // percent the heap grows before a new incremental cycle starts, and collection speed relative to allocation
+    const ConfigEntry<uint16_t> lua_gc_pause{"lua_gc_pause", 200};
+    const ConfigEntry<uint16_t> lua_gc_stepmul{"lua_gc_stepmul", 200};
+    // directory keeping compiled scripts across restarts, empty keeps them in memory only
+    const ConfigEntry<std::string> lua_bytecode_cache{"lua_bytecode_cache", ""};
+    // seconds between checks for changed script files, which are then reloaded on their own; 0 turns it off
+    const ConfigEntry<uint32_t> script_reload_interval{"script_reload_interval", 0};
+    // seconds between background writes of changed script variables, 0 writes them at shutdown only
+    const ConfigEntry<uint32_t> script_variables_save_interval{"script_variables_save_interval", 60};
 
     const ConfigEntry<std::string> postgres_db{"postgres_db", "illarion"};
     const ConfigEntry<std::string> postgres_user{"postgres_user", "illarion"};
@@ -92,6 +174,20 @@ public:
     const ConfigEntry<uint16_t> postgres_port{"postgres_port", 5432};
     const ConfigEntry<std::string> postgres_schema_server{"postgres_schema_server", "server"};
     const ConfigEntry<std::string> postgres_schema_account{"postgres_schema_account", "accounts"};
+    // connections kept open for reuse, and milliseconds a checkout waits before opening one beyond that
+    const ConfigEntry<uint16_t> postgres_pool_size{"postgres_pool_size", 8};
+    const ConfigEntry<uint16_t> postgres_pool_wait{"postgres_pool_wait", 2000};
+    // seconds between logs of the pool usage, 0 turns the log off
+    const ConfigEntry<uint32_t> postgres_pool_log_interval{"postgres_pool_log_interval", 3600};
+    // read replica for queries which may lag behind the primary, like table reloads; an empty host turns it off,
+    // user, password and database are those of the primary
+    const ConfigEntry<std::string> postgres_replica_host{"postgres_replica_host", ""};
+    const ConfigEntry<uint16_t> postgres_replica_port{"postgres_replica_port", 5432};
+    const ConfigEntry<uint16_t> postgres_replica_pool_size{"postgres_replica_pool_size", 4};
+    // workers running queued reads, queued writes always have a single ordered writer
+    const ConfigEntry<uint16_t> postgres_async_readers{"postgres_async_readers", 2};
+    // directory keeping data tables across restarts, refetched only when their checksum changed; empty turns it off
+    const ConfigEntry<std::string> table_cache_dir{"table_cache_dir", ""};
 
     const ConfigEntry<int16_t> debug{"debug", 0};
 
@@ -100,6 +196,28 @@ public:
     const ConfigEntry<int16_t> playerstart_y{"playerstart_y", 0};
     const ConfigEntry<int16_t> playerstart_z{"playerstart_z", 0};
 
+    const ConfigEntry<bool> background_map_save{"background_map_save", false};
+    // seconds between saves of the changed maps while the server runs, so a restart after a crash loses little and
+    // need not import the maps again; 0 saves them only on shutdown and by command
+    const ConfigEntry<uint32_t> map_checkpoint_interval{"map_checkpoint_interval", 0};
+    // directory receiving a consistent copy of the maps and script variables every backup_interval seconds, written
+    // in the background; online players are saved to the database at the same time. Empty turns backups off
+    const ConfigEntry<std::string> backup_dir{"backup_dir", ""};
+    const ConfigEntry<uint32_t> backup_interval{"backup_interval", 3600};
+    // levels whose maps are loaded, separated by commas, empty loads all; servers with a datadir of their own can
+    // share the world by levels this way, players logging in on a level of another server start at playerstart
+    const ConfigEntry<std::string> shard_levels{"shard_levels", ""};
+    // clients keep map stripes they have received, so unchanged stripes are not resent on movement
+    const ConfigEntry<bool> map_delta_updates{"map_delta_updates", false};
+    // clients understand MultiMoveTC, so the moves a player sees within a tick are sent as one command
+    const ConfigEntry<bool> multi_move_updates{"multi_move_updates", false};
+    // of characters further away than this many fields, which are not fighting the player, only the latest move is
+    // sent every far_update_interval milliseconds and the client interpolates; 0 sends every move
+    const ConfigEntry<uint16_t> far_update_radius{"far_update_radius", 0};
+    // clients read the compact layout of the commands in CommandEncoding
+    const ConfigEntry<bool> compact_protocol{"compact_protocol", false};
+    const ConfigEntry<uint16_t> far_update_interval{"far_update_interval", 500};
+
 private:
     static std::unique_ptr<Config> _instance;
 };
@@ -18,11 +18,15 @@
 
 #include "Container.hpp"
 
+#include "MemoryUsage.hpp"
 #include "World.hpp"
 #include "constants.hpp"
 #include "data/Data.hpp"
 #include "stream.hpp"
 
+#include <algorithm>
+#include <utility>
+
 Container::Container(Item::id_type itemId) : itemId(itemId) {}
 
 Container::~Container() {
@@ -51,6 +55,7 @@ auto Container::mergeItem(Item item) -> Item::number_type {
                 if (number != item.getNumber()) {
                     item.setNumber(number);
                     selectedItem.setMinQuality(item);
+                    contentChanged();
                 }
             }
 
@@ -106,6 +111,7 @@ auto Container::InsertItem(Item item, TYPE_OF_CONTAINERSLOTS pos) -> bool {
                     if (temp <= maxStack) {
                         selectedItem.setMinQuality(item);
                         selectedItem.setNumber(temp);
+                        contentChanged();
                         return true;
                     }
                     if (items.size() < getSlotCount()) {
@@ -114,6 +120,7 @@ auto Container::InsertItem(Item item, TYPE_OF_CONTAINERSLOTS pos) -> bool {
                         selectedItem.setMinQuality(item);
 
                         selectedItem.setNumber(maxStack);
+                        contentChanged();
 
                         insertIntoFirstFreeSlot(item);
 
@@ -122,7 +129,7 @@ auto Container::InsertItem(Item item, TYPE_OF_CONTAINERSLOTS pos) -> bool {
                 }
             }
         } else if (items.size() < getSlotCount()) {
-            items.insert(ITEMMAP::value_type(pos, item));
+            putItem(pos, item);
             return true;
         }
     }
@@ -149,9 +156,8 @@ auto Container::InsertContainer(const Item &item, Container *cc, TYPE_OF_CONTAIN
         if (iterat != items.end()) {
             return InsertContainer(item, cc);
         }
-        items.insert(ITEMMAP::value_type(pos, titem));
-
-        containers.insert(CONTAINERMAP::value_type(pos, cc));
+        putItem(pos, titem);
+        putContainer(pos, cc);
 
         World::get()->sendContainerSlotChange(this, pos);
 
@@ -182,44 +188,33 @@ auto Container::TakeItemNr(TYPE_OF_CONTAINERSLOTS nr, Item &item, Container *&cc
 
     if (it != items.end()) {
         Item &selectedItem = it->second;
-        item = selectedItem;
 
-        if (item.isContainer()) {
-            items.erase(nr);
-            auto iterat = containers.find(nr);
+        if (selectedItem.isContainer()) {
+            item = std::move(selectedItem);
+            items.erase(it);
+            cc = takeContainer(nr);
 
-            if (iterat != containers.end()) {
-                cc = (*iterat).second;
-                containers.erase(iterat);
-            } else {
+            if (cc == nullptr) {
                 cc = new Container(item.getId());
             }
 
+            contentChanged();
             return true;
         }
         cc = nullptr;
+        const Item::number_type taken = selectedItem.isStackable() && count > 1 ? count : 1;
 
-        if (item.isStackable() && count > 1) {
-            if (selectedItem.getNumber() > count) {
-                selectedItem.setNumber(selectedItem.getNumber() - count);
-
-                item.setNumber(count);
-
-            } else {
-                items.erase(nr);
-            }
-
+        // only a part of the stack needs a copy
+        if (selectedItem.getNumber() > taken) {
+            item = selectedItem;
+            item.setNumber(taken);
+            selectedItem.setNumber(selectedItem.getNumber() - taken);
         } else {
-            if (selectedItem.getNumber() > 1) {
-                selectedItem.setNumber(selectedItem.getNumber() - 1);
-
-                item.setNumber(1);
-
-            } else {
-                items.erase(nr);
-            }
+            item = std::move(selectedItem);
+            items.erase(it);
         }
 
+        contentChanged();
         return true;
     }
     items.erase(nr);
@@ -361,6 +356,8 @@ auto Container::increaseAtPos(unsigned char pos, int count) -> int {
 
         auto maxStack = item.getMaxStack();
 
+        contentChanged();
+
         if (temp > maxStack) {
             item.setNumber(maxStack);
 
@@ -387,6 +384,7 @@ auto Container::changeItem(ScriptItem &item) -> bool {
     if (it != items.end()) {
         if (!it->second.isContainer()) {
             it->second = item.cloneItem();
+            contentChanged();
             return true;
         }
     }
@@ -407,6 +405,7 @@ auto Container::swapAtPos(unsigned char pos, Item::id_type newid, Item::quality_
                 item.setQuality(newQuality);
             }
 
+            contentChanged();
             return true;
         }
     }
@@ -414,7 +413,7 @@ auto Container::swapAtPos(unsigned char pos, Item::id_type newid, Item::quality_
     return false;
 }
 
-void Container::Save(std::ofstream &where) const {
+void Container::Save(std::ostream &where) const {
     MAXCOUNTTYPE size = items.size();
     writeToStream(where, size);
 
@@ -436,7 +435,7 @@ void Container::Save(std::ofstream &where) const {
     }
 }
 
-void Container::Load(std::ifstream &where) {
+void Container::Load(std::istream &where) {
     if (!containers.empty()) {
         for (auto &container : containers) {
             delete container.second;
@@ -446,6 +445,7 @@ void Container::Load(std::ifstream &where) {
 
     items.clear();
     containers.clear();
+    contentChanged();
 
     MAXCOUNTTYPE size = 0;
     readFromStream(where, size);
@@ -470,12 +470,22 @@ void Container::Load(std::ifstream &where) {
 }
 
 auto Container::countItem(Item::id_type itemid, script_data_exchangemap const *data) const -> int {
+    if (data == nullptr) {
+        const auto &counts = getTotals(0).counts;
+        const auto count = counts.find(itemid);
+        return count != counts.end() ? count->second : 0;
+    }
+
+    if (!holds(itemid)) {
+        return 0;
+    }
+
     int temp = 0;
 
     for (const auto &it : items) {
         const Item &item = it.second;
 
-        if (item.getId() == itemid && (data == nullptr || item.hasData(*data))) {
+        if (item.getId() == itemid && item.hasData(*data)) {
             temp = temp + item.getNumber();
         }
 
@@ -491,43 +501,82 @@ auto Container::countItem(Item::id_type itemid, script_data_exchangemap const *d
     return temp;
 }
 
-auto Container::weight() -> int { return recursiveWeight(0); }
+auto Container::weight() -> int { return static_cast<int>(getTotals(0).weight); }
 
-auto Container::recursiveWeight(int rekt) -> int {
-    int temprekt = rekt + 1;
+auto Container::holds(Item::id_type itemid) const -> bool {
+    const auto &counts = getTotals(0).counts;
+    const auto count = counts.find(itemid);
+    return count != counts.end() && count->second > 0;
+}
 
-    if (rekt > maximumRecursionDepth) {
+auto Container::memoryUsage(int depth) const -> size_t {
+    if (depth > maximumRecursionDepth) {
         throw RecursionException();
     }
 
-    uint32_t temp = 0;
+    auto bytes = sizeof(Container) + items.memoryUsage() + containers.memoryUsage();
 
-    for (auto &it : items) {
-        Item &item = it.second;
+    if (totals) {
+        bytes += memory::ofHashed(totals->counts);
+    }
+
+    for (const auto &[slot, item] : items) {
+        bytes += item.memoryUsage();
+    }
+
+    for (const auto &[slot, container] : containers) {
+        bytes += container->memoryUsage(depth + 1);
+    }
+
+    return bytes;
+}
+
+auto Container::getTotals(int depth) const -> const Totals & {
+    if (totals) {
+        return *totals;
+    }
 
+    if (depth > maximumRecursionDepth) {
+        throw RecursionException();
+    }
+
+    Totals sum;
+    uint32_t weight = 0;
+
+    for (const auto &[slot, item] : items) {
         const auto &itemStruct = Data::items()[item.getId()];
+        sum.counts[item.getId()] += item.getNumber();
 
         if (item.isContainer()) {
-            auto iterat = containers.find(it.first);
+            auto iterat = containers.find(slot);
 
             if (iterat != containers.end()) {
-                temp += iterat->second->recursiveWeight(temprekt);
+                const auto &inner = iterat->second->getTotals(depth + 1);
+                weight += inner.weight;
+
+                for (const auto &[id, count] : inner.counts) {
+                    sum.counts[id] += count;
+                }
             }
 
-            temp += itemStruct.Weight;
+            weight += itemStruct.Weight;
         } else {
-            temp += (itemStruct.Weight * item.getNumber());
+            weight += (itemStruct.Weight * item.getNumber());
         }
     }
 
-    if (temp > MAXWEIGHT) {
-        return MAXWEIGHT;
-    }
-    return temp;
+    sum.weight = std::min<uint32_t>(weight, MAXWEIGHT);
+    totals = std::move(sum);
+    return *totals;
 }
 
 auto Container::eraseItem(Item::id_type itemid, Item::number_type count, script_data_exchangemap const *data) -> int {
     int temp = count;
+    bool erased = false;
+
+    if (!holds(itemid)) {
+        return temp;
+    }
 
     auto it = items.begin();
 
@@ -543,6 +592,8 @@ auto Container::eraseItem(Item::id_type itemid, Item::number_type count, script_
 
             ++it;
         } else if ((item.getId() == itemid && (data == nullptr || item.hasData(*data))) && (temp > 0)) {
+            erased = true;
+
             if (temp >= item.getNumber()) {
                 temp = temp - item.getNumber();
                 it = items.erase(it);
@@ -557,10 +608,16 @@ auto Container::eraseItem(Item::id_type itemid, Item::number_type count, script_
         }
     }
 
+    if (erased) {
+        contentChanged();
+    }
+
     return temp;
 }
 
 void Container::doAge(bool inventory) {
+    bool changed = false;
+
     if (!items.empty()) {
         auto it = items.begin();
 
@@ -571,6 +628,8 @@ void Container::doAge(bool inventory) {
 
             if (!inventory || itemStruct.rotsInInventory) {
                 if (!item.survivesAgeing()) {
+                    changed = true;
+
                     if (item.getId() != itemStruct.ObjectAfterRot) {
                         item.setId(itemStruct.ObjectAfterRot);
 
@@ -583,11 +642,7 @@ void Container::doAge(bool inventory) {
                         ++it;
                     } else {
                         if (item.isContainer()) {
-                            auto iterat = containers.find(it->first);
-
-                            if (iterat != containers.end()) {
-                                containers.erase(iterat);
-                            }
+                            takeContainer(it->first);
                         }
 
                         it = items.erase(it);
@@ -601,6 +656,10 @@ void Container::doAge(bool inventory) {
         }
     }
 
+    if (changed) {
+        contentChanged();
+    }
+
     if (!containers.empty()) {
         for (auto &container : containers) {
             container.second->doAge(inventory);
@@ -625,7 +684,7 @@ void Container::insertIntoFirstFreeSlot(Item &item) {
     TYPE_OF_CONTAINERSLOTS slotCount = getSlotCount();
 
     if (freeSlot < slotCount) {
-        items.insert(ITEMMAP::value_type(freeSlot, item));
+        putItem(freeSlot, item);
         World::get()->sendContainerSlotChange(this, freeSlot);
     }
 }
@@ -635,19 +694,47 @@ void Container::insertIntoFirstFreeSlot(Item &item, Container *container) {
     TYPE_OF_CONTAINERSLOTS slotCount = getSlotCount();
 
     if (freeSlot < slotCount) {
-        items.insert(ITEMMAP::value_type(freeSlot, item));
-        containers.insert(CONTAINERMAP::value_type(freeSlot, container));
+        putItem(freeSlot, item);
+        putContainer(freeSlot, container);
         World::get()->sendContainerSlotChange(this, freeSlot);
     }
 }
 
 auto Container::getFirstFreeSlot() const -> TYPE_OF_CONTAINERSLOTS {
-    TYPE_OF_CONTAINERSLOTS slotCount = getSlotCount();
-    TYPE_OF_CONTAINERSLOTS i = 0;
+    return static_cast<TYPE_OF_CONTAINERSLOTS>(items.firstFree(getSlotCount()));
+}
+
+void Container::putItem(TYPE_OF_CONTAINERSLOTS slot, const Item &item) {
+    items.reserve(getSlotCount());
+    items.insert(ITEMMAP::value_type(slot, item));
+    contentChanged();
+}
+
+void Container::putContainer(TYPE_OF_CONTAINERSLOTS slot, Container *container) {
+    containers.reserve(getSlotCount());
 
-    while (i < slotCount && items.find(i) != items.end()) {
-        ++i;
+    if (containers.insert(CONTAINERMAP::value_type(slot, container)).second) {
+        container->parent = this;
+        contentChanged();
+    }
+}
+
+auto Container::takeContainer(TYPE_OF_CONTAINERSLOTS slot) -> Container * {
+    auto iterat = containers.find(slot);
+
+    if (iterat == containers.end()) {
+        return nullptr;
     }
 
-    return i;
+    auto *container = iterat->second;
+    containers.erase(iterat);
+    container->parent = nullptr;
+    contentChanged();
+    return container;
+}
+
+void Container::contentChanged() {
+    for (auto *container = this; container != nullptr && container->totals; container = container->parent) {
+        container->totals.reset();
+    }
 }
@@ -20,11 +20,13 @@
 #define CONTAINER_HPP
 
 #include "Item.hpp"
+#include "SlotArray.hpp"
 #include "TableStructs.hpp"
 
 #include <fstream>
 #include <iostream>
-#include <map>
+#include <optional>
+#include <unordered_map>
 
 class ItemTable;
 
@@ -32,8 +34,8 @@ class RecursionException : public std::exception {};
 
 class Container {
 public:
-    using ITEMMAP = std::map<TYPE_OF_CONTAINERSLOTS, Item>;
-    using CONTAINERMAP = std::map<TYPE_OF_CONTAINERSLOTS, Container *>;
+    using ITEMMAP = SlotArray<Item>;
+    using CONTAINERMAP = SlotArray<Container *>;
 
     explicit Container(Item::id_type itemId);
     Container(const Container &) = delete;
@@ -52,8 +54,8 @@ public:
     auto InsertItem(Item item, TYPE_OF_CONTAINERSLOTS /*pos*/) -> bool;
     auto InsertItem(const Item &item) -> bool;
 
-    void Save(std::ofstream &where) const;
-    void Load(std::ifstream &where);
+    void Save(std::ostream &where) const;
+    void Load(std::istream &where);
 
     void doAge(bool inventory = false);
     void resetWear();
@@ -87,16 +89,35 @@ public:
 
     [[nodiscard]] inline auto isDepot() const -> bool { return itemId == DEPOTITEM; }
 
+    // estimated heap bytes of the container and its content including nested containers
+    [[nodiscard]] auto memoryUsage() const -> size_t { return memoryUsage(0); }
+
 private:
     static constexpr auto maximumRecursionDepth = 100;
 
+    // weight and item counts of the whole content including nested containers
+    struct Totals {
+        uint32_t weight = 0;
+        std::unordered_map<Item::id_type, int> counts;
+    };
+
     void insertIntoFirstFreeSlot(Item &item);
     void insertIntoFirstFreeSlot(Item &item, Container *container);
-    auto recursiveWeight(int rekt) -> int;
+    void putItem(TYPE_OF_CONTAINERSLOTS slot, const Item &item);
+    void putContainer(TYPE_OF_CONTAINERSLOTS slot, Container *container);
+    auto takeContainer(TYPE_OF_CONTAINERSLOTS slot) -> Container *;
+    void contentChanged();
+    // whether the content or any nested container holds the item, lets filtered scans skip whole subtrees
+    [[nodiscard]] auto holds(Item::id_type itemid) const -> bool;
+    auto getTotals(int depth) const -> const Totals &;
+    [[nodiscard]] auto memoryUsage(int depth) const -> size_t;
 
     Item::id_type itemId{};
     ITEMMAP items;
     CONTAINERMAP containers;
+    Container *parent = nullptr;
+    // rebuilt on demand, dropped here and in all enclosing containers whenever the content changes
+    mutable std::optional<Totals> totals;
 };
 
 #endif
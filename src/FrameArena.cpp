@@ -0,0 +1,95 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "FrameArena.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace frame {
+
+namespace {
+
+// enough for the scratch lists of a busy tick, a tick needing more makes the arena grow
+constexpr size_t initialBytes = 256 * 1024;
+
+// heap memory for blocks beyond the buffer of the arena, counted to size the next buffer
+class Overflow : public std::pmr::memory_resource {
+public:
+    [[nodiscard]] auto takeBytes() -> size_t { return std::exchange(bytes, 0); }
+
+private:
+    size_t bytes = 0;
+
+    auto do_allocate(size_t size, size_t alignment) -> void * override {
+        bytes += size;
+        return std::pmr::new_delete_resource()->allocate(size, alignment);
+    }
+
+    void do_deallocate(void *pointer, size_t size, size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(pointer, size, alignment);
+    }
+
+    [[nodiscard]] auto do_is_equal(const std::pmr::memory_resource &other) const noexcept -> bool override {
+        return this == &other;
+    }
+};
+
+class Arena {
+public:
+    Arena() { allocateBuffer(initialBytes); }
+
+    auto get() -> std::pmr::memory_resource * { return &*resource; }
+
+    void reset() {
+        resource->release();
+
+        if (const auto overflowBytes = overflow.takeBytes(); overflowBytes > 0) {
+            allocateBuffer(capacity + overflowBytes);
+        }
+    }
+
+private:
+    Overflow overflow;
+    size_t capacity = 0;
+    std::unique_ptr<std::byte[]> buffer;
+    std::optional<std::pmr::monotonic_buffer_resource> resource;
+
+    void allocateBuffer(size_t bytes) {
+        resource.reset();
+        capacity = bytes;
+        buffer = std::make_unique<std::byte[]>(capacity);
+        resource.emplace(buffer.get(), capacity, &overflow);
+    }
+};
+
+auto threadArena() -> Arena & {
+    thread_local Arena arena;
+    return arena;
+}
+
+} // namespace
+
+auto arena() -> std::pmr::memory_resource * { return threadArena().get(); }
+
+void resetArena() { threadArena().reset(); }
+
+} // namespace frame
@@ -0,0 +1,41 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef FRAME_ARENA_HPP
+#define FRAME_ARENA_HPP
+
+#include <memory_resource>
+#include <vector>
+
+// Memory for scratch containers that do not outlive the current tick, handed out by bumping a pointer and given back
+// all at once by resetArena at the end of the tick. Each thread has an arena of its own, only the game thread
+// resets it, so lists filled on worker threads must not use it.
+namespace frame {
+
+[[nodiscard]] auto arena() -> std::pmr::memory_resource *;
+// invalidates everything allocated from the arena of this thread, which grows once a tick has outrun it
+void resetArena();
+
+template <typename T> using vector = std::pmr::vector<T>;
+
+template <typename T> [[nodiscard]] auto makeVector() -> vector<T> { return vector<T>(arena()); }
+
+} // namespace frame
+
+#endif
@@ -0,0 +1,101 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "HugePages.hpp"
+
+#include <atomic>
+#include <sys/mman.h>
+
+namespace hugepages {
+
+namespace {
+
+enum class Mode { off, transparent, reserved };
+
+// the default size on x86-64 and most aarch64 kernels
+constexpr size_t hugePageSize = 2 * 1024 * 1024;
+
+std::atomic<Mode> currentMode = Mode::off;
+
+auto mappedSize(size_t bytes) -> size_t { return (bytes + hugePageSize - 1) / hugePageSize * hugePageSize; }
+
+auto map(size_t bytes, int flags) -> void * {
+    void *pointer = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    return pointer != MAP_FAILED ? pointer : nullptr;
+}
+
+} // namespace
+
+auto configure(const std::string &mode) -> bool {
+    if (mode == "off") {
+        currentMode = Mode::off;
+    } else if (mode == "transparent") {
+        currentMode = Mode::transparent;
+    } else if (mode == "reserved") {
+        currentMode = Mode::reserved;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+auto allocate(size_t bytes) -> void * {
+    if (bytes < hugePageSize) {
+        return ::operator new(bytes);
+    }
+
+    // the mode only decides how a block is mapped, so that blocks stay valid when it changes
+    const auto size = mappedSize(bytes);
+    const auto mode = currentMode.load();
+    void *pointer = nullptr;
+
+#ifdef MAP_HUGETLB
+    if (mode == Mode::reserved) {
+        pointer = map(size, MAP_HUGETLB);
+    }
+#endif
+
+    if (pointer == nullptr) {
+        pointer = map(size, 0);
+
+        if (pointer == nullptr) {
+            throw std::bad_alloc();
+        }
+
+#ifdef MADV_HUGEPAGE
+        if (mode != Mode::off) {
+            // only advice, a kernel without transparent huge pages keeps serving small pages
+            madvise(pointer, size, MADV_HUGEPAGE);
+        }
+#endif
+    }
+
+    return pointer;
+}
+
+void deallocate(void *pointer, size_t bytes) noexcept {
+    if (bytes < hugePageSize) {
+        ::operator delete(pointer);
+    } else {
+        munmap(pointer, mappedSize(bytes));
+    }
+}
+
+} // namespace hugepages
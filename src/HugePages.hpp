@@ -0,0 +1,59 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef HUGE_PAGES_HPP
+#define HUGE_PAGES_HPP
+
+#include <cstddef>
+#include <new>
+#include <string>
+
+// Large, long-lived arrays such as the fields of the maps, allocated so that the kernel can back them with huge pages
+// and the game thread takes fewer TLB misses walking them. The mode is that of the huge_pages option, see Config.
+namespace hugepages {
+
+// off, transparent for transparent huge pages or reserved for the huge page pool, which falls back to transparent
+// huge pages while the pool is exhausted; returns false for an unknown mode and leaves the current one
+auto configure(const std::string &mode) -> bool;
+
+// blocks below the size of a huge page come from the heap, larger ones are mapped on their own
+[[nodiscard]] auto allocate(size_t bytes) -> void *;
+void deallocate(void *pointer, size_t bytes) noexcept;
+
+template <typename T> class Allocator {
+public:
+    using value_type = T;
+
+    Allocator() noexcept = default;
+    template <typename U> explicit Allocator(const Allocator<U> & /*other*/) noexcept {}
+
+    [[nodiscard]] auto allocate(size_t count) -> T * {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "mapped blocks are only aligned like the heap");
+        return static_cast<T *>(hugepages::allocate(count * sizeof(T)));
+    }
+
+    void deallocate(T *pointer, size_t count) noexcept { hugepages::deallocate(pointer, count * sizeof(T)); }
+
+    template <typename U> auto operator==(const Allocator<U> & /*other*/) const noexcept -> bool { return true; }
+    template <typename U> auto operator!=(const Allocator<U> & /*other*/) const noexcept -> bool { return false; }
+};
+
+} // namespace hugepages
+
+#endif
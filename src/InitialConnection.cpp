@@ -20,58 +20,176 @@
 
 #include "Config.hpp"
 #include "Logger.hpp"
+#include "ThreadAffinity.hpp"
 #include "netinterface/NetInterface.hpp"
 
+#include <algorithm>
 #include <memory>
+#include <string>
 #include <thread>
 
 auto InitialConnection::create() -> std::shared_ptr<InitialConnection> {
-    std::shared_ptr<InitialConnection> ptr(new InitialConnection());
-    std::thread servicethread([shared_this = ptr->shared_from_this()] { shared_this->run_service(); });
-    servicethread.detach();
+    const size_t threads = std::max<uint16_t>(Config::instance().io_threads, 1);
+    std::shared_ptr<InitialConnection> ptr(new InitialConnection(threads));
+    ptr->listen();
+
+    for (size_t thread = 0; thread < threads; ++thread) {
+        std::thread servicethread([shared_this = ptr->shared_from_this(), thread] {
+            affinity::pinCurrentThread(Config::instance().io_thread_cores(), "io");
+            shared_this->run_service(thread);
+        });
+        servicethread.detach();
+    }
+
     return ptr;
 }
 
+InitialConnection::InitialConnection(size_t threads)
+        : handlerCounts(threads),
+          acceptLimiter(Config::instance().accept_per_second, Config::instance().accept_per_second_per_ip,
+                        Config::instance().accept_burst_per_ip) {}
+
 auto InitialConnection::getNewPlayers() -> NewPlayerVector & { return newPlayers; }
 
-void InitialConnection::run_service() {
+auto InitialConnection::getThreadCount() const -> size_t { return handlerCounts.size(); }
+
+auto InitialConnection::getHandlerCounts() const -> std::vector<uint64_t> {
+    std::vector<uint64_t> counts;
+    counts.reserve(handlerCounts.size());
+
+    for (const auto &count : handlerCounts) {
+        counts.push_back(count.load(std::memory_order_relaxed));
+    }
+
+    return counts;
+}
+
+auto InitialConnection::getRejectedConnections() const -> uint64_t {
+    return acceptLimiter.rejectedGlobally() + acceptLimiter.rejectedPerAddress();
+}
+
+auto InitialConnection::getLoginTimeouts() const -> uint64_t { return loginTimeouts.load(std::memory_order_relaxed); }
+
+namespace {
+#if defined(BOOST_ASIO_HAS_IO_URING) && defined(BOOST_ASIO_DISABLE_EPOLL)
+constexpr auto ioBackend = "io_uring";
+#else
+constexpr auto ioBackend = "epoll";
+#endif
+} // namespace
+
+void InitialConnection::listen() {
     try {
         using boost::asio::ip::tcp;
 
+        using ReusePort = boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+
         int port = Config::instance().port;
+        const size_t acceptorCount = std::max<uint16_t>(Config::instance().acceptors, 1);
 
         auto endpoint = tcp::endpoint(tcp::v4(), port);
-        acceptor = std::make_unique<tcp::acceptor>(io_service, endpoint);
-        auto newConnection = std::make_shared<NetInterface>(io_service);
-        acceptor->async_accept(newConnection->getSocket(),
-                               [shared_this = shared_from_this(), newConnection](auto &&PH1) {
-                                   shared_this->accept_connection(newConnection, PH1);
-                               });
-        Logger::info(LogFacility::Other) << "Starting the io service." << Log::end;
-        io_service.run();
+
+        for (size_t i = 0; i < acceptorCount; ++i) {
+            auto &acceptor = acceptors.emplace_back(std::make_unique<tcp::acceptor>(io_service));
+            acceptor->open(endpoint.protocol());
+            acceptor->set_option(tcp::acceptor::reuse_address(true));
+
+            if (acceptorCount > 1) {
+                acceptor->set_option(ReusePort(true));
+            }
+
+            acceptor->bind(endpoint);
+            acceptor->listen();
+            accept_next(*acceptor);
+        }
+
+        scheduleLoadReport();
+        Logger::info(LogFacility::Other) << "Starting the io service with " << getThreadCount() << " threads and "
+                                         << acceptorCount << " acceptors on " << ioBackend << "." << Log::end;
     } catch (const boost::system::system_error &e) {
         Logger::critical(LogFacility::Other) << "Failed to start io service: " << e.what() << Log::end;
         std::exit(EXIT_FAILURE);
     }
 }
 
-void InitialConnection::accept_connection(const std::shared_ptr<NetInterface> &connection,
+void InitialConnection::run_service(size_t thread) {
+    // run_one instead of run to count the handlers of this thread
+    auto &count = handlerCounts[thread];
+
+    while (io_service.run_one() > 0) {
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void InitialConnection::scheduleLoadReport() {
+    loadReportTimer.expires_after(loadReportInterval);
+    loadReportTimer.async_wait([shared_this = shared_from_this()](const boost::system::error_code &error) {
+        if (error) {
+            return;
+        }
+
+        std::string counts;
+
+        for (const auto count : shared_this->getHandlerCounts()) {
+            counts += " " + std::to_string(count);
+        }
+
+        Logger::info(LogFacility::Other) << "io service handlers per thread:" << counts << Log::end;
+        Logger::info(LogFacility::Other) << "connections rejected globally: "
+                                         << shared_this->acceptLimiter.rejectedGlobally()
+                                         << ", per address: " << shared_this->acceptLimiter.rejectedPerAddress()
+                                         << ", login timeouts: " << shared_this->getLoginTimeouts() << Log::end;
+        shared_this->scheduleLoadReport();
+    });
+}
+
+void InitialConnection::accept_connection(boost::asio::ip::tcp::acceptor &acceptor,
+                                          const std::shared_ptr<NetInterface> &connection,
                                           const boost::system::error_code &error) {
     if (!error) {
-        if (connection->activate()) {
-            newPlayers.push_back(connection);
-        } else {
-            Logger::error(LogFacility::Other) << "Error while activating connection!" << Log::end;
+        if (admit(connection)) {
+            connection->awaitLogin(
+                    [shared_this = shared_from_this()](const std::shared_ptr<NetInterface> &loggedIn) {
+                        shared_this->newPlayers.push(loggedIn);
+                    },
+                    [shared_this = shared_from_this()] {
+                        shared_this->loginTimeouts.fetch_add(1, std::memory_order_relaxed);
+                    });
+
+            if (!connection->activate()) {
+                Logger::error(LogFacility::Other) << "Error while activating connection!" << Log::end;
+            }
         }
 
-        auto newConnection = std::make_shared<NetInterface>(io_service);
-        acceptor->async_accept(newConnection->getSocket(),
-                               [shared_this = shared_from_this(), newConnection](auto &&PH1) {
-                                   shared_this->accept_connection(newConnection, PH1);
-                               });
+        accept_next(acceptor);
     } else {
         Logger::error(LogFacility::Other) << "Could not accept connection: " << error.message() << Log::end;
     }
 }
 
+void InitialConnection::accept_next(boost::asio::ip::tcp::acceptor &acceptor) {
+    auto newConnection = std::make_shared<NetInterface>(io_service);
+    acceptor.async_accept(newConnection->getSocket(),
+                          [shared_this = shared_from_this(), &acceptor, newConnection](auto &&PH1) {
+                              shared_this->accept_connection(acceptor, newConnection, PH1);
+                          });
+}
+
+auto InitialConnection::admit(const std::shared_ptr<NetInterface> &connection) -> bool {
+    auto &socket = connection->getSocket();
+    boost::system::error_code error;
+    const auto endpoint = socket.remote_endpoint(error);
+
+    if (!error) {
+        const std::lock_guard<std::mutex> lock(limiterMutex);
+
+        if (acceptLimiter.allow(endpoint.address().to_string(), AcceptLimiter::Clock::now())) {
+            return true;
+        }
+    }
+
+    socket.close(error);
+    return false;
+}
+
 InitialConnection::~InitialConnection() { io_service.stop(); }
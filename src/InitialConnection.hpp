@@ -19,16 +19,23 @@
 #ifndef InitialConnection_HPP
 #define InitialConnection_HPP
 
-#include "thread_safe_vector.hpp"
+#include "AcceptLimiter.hpp"
+#include "ConcurrentQueue.hpp"
 
+#include <atomic>
 #include <boost/asio.hpp>
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 class NetInterface;
 
 class InitialConnection : public std::enable_shared_from_this<InitialConnection> {
 public:
-    using NewPlayerVector = thread_safe_vector<std::shared_ptr<NetInterface>>;
+    // connections whose login command arrived
+    using NewPlayerVector = ConcurrentQueue<std::shared_ptr<NetInterface>>;
 
     static auto create() -> std::shared_ptr<InitialConnection>;
     ~InitialConnection();
@@ -39,14 +46,35 @@ public:
 
     auto getNewPlayers() -> NewPlayerVector &;
 
+    [[nodiscard]] auto getThreadCount() const -> size_t;
+    // number of handlers each I/O thread has run so far
+    [[nodiscard]] auto getHandlerCounts() const -> std::vector<uint64_t>;
+    // connections closed by the accept limiter
+    [[nodiscard]] auto getRejectedConnections() const -> uint64_t;
+    // connections closed for not sending the login command in time
+    [[nodiscard]] auto getLoginTimeouts() const -> uint64_t;
+
 private:
-    InitialConnection() = default;
-    void run_service();
+    static constexpr std::chrono::minutes loadReportInterval{10};
+
+    explicit InitialConnection(size_t threads);
+    void listen();
+    void run_service(size_t thread);
+    void scheduleLoadReport();
 
     boost::asio::io_service io_service;
-    std::unique_ptr<boost::asio::ip::tcp::acceptor> acceptor = nullptr;
+    std::vector<std::unique_ptr<boost::asio::ip::tcp::acceptor>> acceptors;
+    boost::asio::steady_timer loadReportTimer{io_service};
+    std::vector<std::atomic<uint64_t>> handlerCounts;
+    // each acceptor has an accept outstanding, their handlers take turns at the limiter
+    std::mutex limiterMutex;
+    AcceptLimiter acceptLimiter;
+    std::atomic<uint64_t> loginTimeouts{0};
 
-    void accept_connection(const std::shared_ptr<NetInterface> &connection, const boost::system::error_code &error);
+    void accept_connection(boost::asio::ip::tcp::acceptor &acceptor, const std::shared_ptr<NetInterface> &connection,
+                           const boost::system::error_code &error);
+    void accept_next(boost::asio::ip::tcp::acceptor &acceptor);
+    auto admit(const std::shared_ptr<NetInterface> &connection) -> bool;
 
     NewPlayerVector newPlayers;
 };
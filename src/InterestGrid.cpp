@@ -0,0 +1,177 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "InterestGrid.hpp"
+
+#include "Player.hpp"
+#include "constants.hpp"
+
+#include <algorithm>
+
+auto InterestGrid::Area::contains(Coordinate x, Coordinate y, Coordinate z) const -> bool {
+    return firstX <= x && x <= lastX && firstY <= y && y <= lastY && firstZ <= z && z <= lastZ;
+}
+
+auto InterestGrid::Area::operator==(const Area &other) const -> bool {
+    return firstX == other.firstX && lastX == other.lastX && firstY == other.firstY && lastY == other.lastY &&
+           firstZ == other.firstZ && lastZ == other.lastZ;
+}
+
+void InterestGrid::add(Player *observer) {
+    if (subscriptions.count(observer) == 0) {
+        const auto subscription = subscriptionOf(observer, observer->getPosition());
+        subscribe(observer, subscription, Subscription{});
+        subscriptions.emplace(observer, subscription);
+    }
+}
+
+void InterestGrid::update(Player *observer, const position &newPosition) { move(observer, newPosition); }
+
+void InterestGrid::refresh(Player *observer) { move(observer, observer->getPosition()); }
+
+void InterestGrid::remove(Player *observer) {
+    const auto it = subscriptions.find(observer);
+
+    if (it != subscriptions.end()) {
+        unsubscribe(observer, it->second, Subscription{});
+        subscriptions.erase(it);
+    }
+}
+
+void InterestGrid::clear() {
+    subscribers.clear();
+    playersInActivationRange.clear();
+    subscriptions.clear();
+    activatedCells.clear();
+}
+
+auto InterestGrid::isPlayerNear(const position &pos) const -> bool {
+    return playersInActivationRange.count(cellKey(pos.x >> cellBits, pos.y >> cellBits, pos.z)) > 0;
+}
+
+auto InterestGrid::takeActivatedCells() -> std::vector<position> {
+    std::vector<position> cells;
+    cells.swap(activatedCells);
+    return cells;
+}
+
+auto InterestGrid::cellKey(Coordinate cellX, Coordinate cellY, Coordinate z) -> cell_key_type {
+    constexpr auto zShift = 32;
+    constexpr auto xShift = 16;
+    return (static_cast<cell_key_type>(static_cast<uint16_t>(z)) << zShift) |
+           (static_cast<cell_key_type>(static_cast<uint16_t>(cellX)) << xShift) | static_cast<uint16_t>(cellY);
+}
+
+auto InterestGrid::cellOrigin(cell_key_type key) -> position {
+    constexpr auto zShift = 32;
+    constexpr auto xShift = 16;
+    const auto cellX = static_cast<int16_t>(static_cast<uint16_t>(key >> xShift));
+    const auto cellY = static_cast<int16_t>(static_cast<uint16_t>(key));
+    const auto z = static_cast<int16_t>(static_cast<uint16_t>(key >> zShift));
+    return {Coordinate(cellX * cellSize), Coordinate(cellY * cellSize), z};
+}
+
+auto InterestGrid::areaOf(const position &pos, Coordinate range) -> Area {
+    // matches Character::isInScreen and the default Range, which limit the distance in z by RANGEUP
+    Area area;
+    area.firstX = (pos.x - range) >> cellBits;
+    area.lastX = (pos.x + range) >> cellBits;
+    area.firstY = (pos.y - range) >> cellBits;
+    area.lastY = (pos.y + range) >> cellBits;
+    area.firstZ = pos.z - RANGEUP;
+    area.lastZ = pos.z + RANGEUP;
+    return area;
+}
+
+auto InterestGrid::subscriptionOf(const Player *observer, const position &pos) -> Subscription {
+    return {areaOf(pos, observer->getScreenRange()), areaOf(pos, MAX_ACT_RANGE)};
+}
+
+auto InterestGrid::sees(const Player *observer, const position &pos) -> bool { return observer->isInScreen(pos); }
+
+template <class F> void InterestGrid::forEachCell(const Area &area, const Area &except, F &&f) {
+    for (auto z = area.firstZ; z <= area.lastZ; ++z) {
+        for (auto x = area.firstX; x <= area.lastX; ++x) {
+            for (auto y = area.firstY; y <= area.lastY; ++y) {
+                if (!except.contains(x, y, z)) {
+                    f(x, y, z);
+                }
+            }
+        }
+    }
+}
+
+void InterestGrid::move(Player *observer, const position &pos) {
+    const auto it = subscriptions.find(observer);
+
+    if (it == subscriptions.end()) {
+        return;
+    }
+
+    const auto subscription = subscriptionOf(observer, pos);
+
+    if (subscription.screen == it->second.screen && subscription.activation == it->second.activation) {
+        return;
+    }
+
+    unsubscribe(observer, it->second, subscription);
+    subscribe(observer, subscription, it->second);
+    it->second = subscription;
+}
+
+void InterestGrid::subscribe(Player *observer, const Subscription &subscription, const Subscription &except) {
+    forEachCell(subscription.screen, except.screen, [this, observer](Coordinate x, Coordinate y, Coordinate z) {
+        subscribers[cellKey(x, y, z)].push_back(observer);
+    });
+
+    forEachCell(subscription.activation, except.activation, [this](Coordinate x, Coordinate y, Coordinate z) {
+        if (++playersInActivationRange[cellKey(x, y, z)] == 1) {
+            activatedCells.emplace_back(x * cellSize, y * cellSize, z);
+        }
+    });
+}
+
+void InterestGrid::unsubscribe(Player *observer, const Subscription &subscription, const Subscription &except) {
+    forEachCell(subscription.screen, except.screen, [this, observer](Coordinate x, Coordinate y, Coordinate z) {
+        const auto cell = subscribers.find(cellKey(x, y, z));
+
+        if (cell == subscribers.end()) {
+            return;
+        }
+
+        auto &observers = cell->second;
+        const auto it = std::find(observers.begin(), observers.end(), observer);
+
+        if (it != observers.end()) {
+            *it = observers.back();
+            observers.pop_back();
+        }
+
+        if (observers.empty()) {
+            subscribers.erase(cell);
+        }
+    });
+
+    forEachCell(subscription.activation, except.activation, [this](Coordinate x, Coordinate y, Coordinate z) {
+        const auto cell = playersInActivationRange.find(cellKey(x, y, z));
+
+        if (cell != playersInActivationRange.end() && --cell->second == 0) {
+            playersInActivationRange.erase(cell);
+        }
+    });
+}
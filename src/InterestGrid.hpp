@@ -0,0 +1,113 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INTEREST_GRID_HPP
+#define INTEREST_GRID_HPP
+
+#include "globals.hpp"
+#include "types.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class Player;
+
+// Subscribes every player to the grid cells its screen covers, so broadcasts about a position only need to look at
+// the subscribers of that position's cell. It also counts for every cell the players within activation range, which
+// tells creatures whether they need to act. Both change only when a player crosses a cell border.
+class InterestGrid {
+public:
+    // edge length of a cell in fields
+    static constexpr Coordinate cellSize = 16;
+
+    void add(Player *observer);
+    // call before the position of observer changes
+    void update(Player *observer, const position &newPosition);
+    // call after the screen range of observer changed
+    void refresh(Player *observer);
+    void remove(Player *observer);
+    void clear();
+
+    // whether a player is within MAX_ACT_RANGE of pos, coarse by up to a cell, i.e. it may also be a bit further
+    [[nodiscard]] auto isPlayerNear(const position &pos) const -> bool;
+    // hands out the origins of all cells that got a player within activation range since the last call
+    auto takeActivatedCells() -> std::vector<position>;
+
+    // visits the origins of all cells with a player within activation range
+    template <class Visitor> void forEachActiveCell(Visitor &&visit) const {
+        for (const auto &cell : playersInActivationRange) {
+            visit(cellOrigin(cell.first));
+        }
+    }
+
+    // visits all observers having pos in screen, visitors must not add, remove or move observers
+    template <class Visitor> void forEachObserverOf(const position &pos, Visitor &&visit) const {
+        const auto cell = subscribers.find(cellKey(pos.x >> cellBits, pos.y >> cellBits, pos.z));
+
+        if (cell != subscribers.end()) {
+            for (auto *observer : cell->second) {
+                if (sees(observer, pos)) {
+                    visit(observer);
+                }
+            }
+        }
+    }
+
+private:
+    using cell_key_type = uint64_t;
+
+    static constexpr int cellBits = 4;
+    static_assert(1 << cellBits == cellSize);
+
+    // inclusive cell coordinates covered by a screen
+    struct Area {
+        Coordinate firstX = 0;
+        Coordinate lastX = -1;
+        Coordinate firstY = 0;
+        Coordinate lastY = -1;
+        Coordinate firstZ = 0;
+        Coordinate lastZ = -1;
+
+        [[nodiscard]] auto contains(Coordinate x, Coordinate y, Coordinate z) const -> bool;
+        auto operator==(const Area &other) const -> bool;
+    };
+
+    struct Subscription {
+        Area screen;
+        Area activation;
+    };
+
+    std::unordered_map<cell_key_type, std::vector<Player *>> subscribers;
+    std::unordered_map<cell_key_type, uint16_t> playersInActivationRange;
+    std::unordered_map<Player *, Subscription> subscriptions;
+    std::vector<position> activatedCells;
+
+    static auto cellKey(Coordinate cellX, Coordinate cellY, Coordinate z) -> cell_key_type;
+    static auto cellOrigin(cell_key_type key) -> position;
+    static auto areaOf(const position &pos, Coordinate range) -> Area;
+    static auto subscriptionOf(const Player *observer, const position &pos) -> Subscription;
+    static auto sees(const Player *observer, const position &pos) -> bool;
+    // calls f with the coordinates of every cell in area but not in except
+    template <class F> static void forEachCell(const Area &area, const Area &except, F &&f);
+    void move(Player *observer, const position &pos);
+    void subscribe(Player *observer, const Subscription &subscription, const Subscription &except);
+    void unsubscribe(Player *observer, const Subscription &subscription, const Subscription &except);
+};
+
+#endif
@@ -74,7 +74,7 @@ auto Item::operator==(const Item &rhs) const -> bool {
 }
 
 Item::Item(id_type id, number_type number, wear_type wear, quality_type quality, const script_data_exchangemap &datamap)
-        : id(id), number(number), wear(wear), quality(quality), datamap(1) {
+        : id(id), number(number), wear(wear), quality(quality) {
     setData(&datamap);
 }
 
@@ -127,15 +127,15 @@ auto Item::hasData(const script_data_exchangemap &datamap) const -> bool {
 auto Item::hasNoData() const -> bool { return datamap.empty(); }
 
 auto Item::getData(const std::string &key) const -> std::string {
-    if (datamap.find(key) != datamap.end()) {
-        return datamap.at(key);
+    if (const auto *value = datamap.find(key); value != nullptr) {
+        return *value;
     }
     return "";
 }
 
 void Item::setData(const std::string &key, const std::string &value) {
     if (value.length() > 0) {
-        datamap[key] = value;
+        datamap.set(key, value);
     } else {
         datamap.erase(key);
     }
@@ -171,7 +171,7 @@ void Item::resetWear() {
     }
 }
 
-void Item::save(std::ofstream &obj) const {
+void Item::save(std::ostream &obj) const {
     writeToStream(obj, id);
     writeToStream(obj, number);
     writeToStream(obj, wear);
@@ -189,7 +189,7 @@ void Item::save(std::ofstream &obj) const {
     }
 }
 
-void Item::load(std::ifstream &obj) {
+void Item::load(std::istream &obj) {
     readFromStream(obj, id);
     readFromStream(obj, number);
     readFromStream(obj, wear);
@@ -206,7 +206,7 @@ void Item::load(std::ifstream &obj) {
         readFromStream(obj, key.data(), sz1);
         std::string value(sz2, '\0');
         readFromStream(obj, value.data(), sz2);
-        datamap[key] = value;
+        datamap.set(key, value);
     }
 }
 
@@ -21,12 +21,12 @@
 #ifndef ITEM_HPP
 #define ITEM_HPP
 
+#include "ItemData.hpp"
 #include "character_ptr.hpp"
 #include "globals.hpp"
 #include "types.hpp"
 
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 class Character;
@@ -39,7 +39,7 @@ public:
     using number_type = uint16_t;
     using wear_type = uint8_t;
     using quality_type = uint16_t;
-    using datamap_type = std::unordered_map<std::string, std::string>;
+    using datamap_type = ItemData;
 
     static constexpr TYPE_OF_VOLUME LARGE_ITEM_VOLUME = 5000;
     static constexpr wear_type PERMANENT_WEAR = 255;
@@ -49,7 +49,7 @@ public:
 
     Item() = default;
     Item(id_type id, number_type number, wear_type wear, quality_type quality = defaultQuality)
-            : id(id), number(number), wear(wear), quality(quality), datamap(1) {}
+            : id(id), number(number), wear(wear), quality(quality) {}
     Item(id_type id, number_type number, wear_type wear, quality_type quality, const script_data_exchangemap &datamap);
 
     inline auto getId() const -> id_type { return id; }
@@ -74,22 +74,23 @@ public:
     auto getData(const std::string &key) const -> std::string;
     void setData(const std::string &key, const std::string &value);
     void setData(const std::string &key, int32_t value);
-    inline auto getDataBegin() const -> datamap_type::const_iterator { return datamap.cbegin(); }
-    inline auto getDataEnd() const -> datamap_type::const_iterator { return datamap.cend(); }
+    inline auto getDataBegin() const -> datamap_type::const_iterator { return datamap.begin(); }
+    inline auto getDataEnd() const -> datamap_type::const_iterator { return datamap.end(); }
     inline auto equalData(script_data_exchangemap const *data) const -> bool {
         Item item;
         item.setData(data);
         return equalData(item);
     }
     inline auto equalData(const Item &item) const -> bool { return datamap == item.datamap; }
+    [[nodiscard]] inline auto memoryUsage() const -> size_t { return datamap.memoryUsage(); }
 
     auto getDepot() const -> uint16_t;
 
     void reset();
     void resetWear();
 
-    void save(std::ofstream &obj) const;
-    void load(std::ifstream &obj);
+    void save(std::ostream &obj) const;
+    void load(std::istream &obj);
 
     auto survivesAgeing() -> bool;
     auto isContainer() const -> bool;
@@ -110,7 +111,7 @@ private:
     number_type number{0};
     wear_type wear{0};
     quality_type quality{defaultQuality};
-    datamap_type datamap{1};
+    datamap_type datamap;
 };
 
 class ScriptItem : public Item {
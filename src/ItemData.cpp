@@ -0,0 +1,83 @@
+/*
+ * illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of illarionserver.
+ *
+ * illarionserver is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * illarionserver is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ItemData.hpp"
+
+#include <algorithm>
+
+auto ItemData::lowerBound(Key key) const -> Entries::const_iterator {
+    return std::lower_bound(entries.cbegin(), entries.cend(), key,
+                            [](const Entry &entry, Key key) { return entry.key < key; });
+}
+
+auto ItemData::find(Key key) const -> const std::string * {
+    const auto entry = lowerBound(key);
+
+    if (entry != entries.cend() && entry->key == key) {
+        return &entry->value;
+    }
+
+    return nullptr;
+}
+
+auto ItemData::find(const std::string &key) const -> const std::string * {
+    if (entries.empty()) {
+        return nullptr;
+    }
+
+    // a key that was never interned is set on no item
+    const auto symbol = SymbolTable::get().find(key);
+    return symbol ? find(*symbol) : nullptr;
+}
+
+void ItemData::set(Key key, const std::string &value) {
+    const auto entry = entries.begin() + (lowerBound(key) - entries.cbegin());
+
+    if (entry != entries.end() && entry->key == key) {
+        entry->value = value;
+    } else {
+        entries.insert(entry, {key, value});
+    }
+}
+
+void ItemData::set(const std::string &key, const std::string &value) { set(SymbolTable::get().intern(key), value); }
+
+void ItemData::erase(Key key) {
+    const auto entry = lowerBound(key);
+
+    if (entry != entries.cend() && entry->key == key) {
+        entries.erase(entry);
+    }
+
+    if (entries.empty()) {
+        // give the memory back, items without data are the common case
+        entries.shrink_to_fit();
+    }
+}
+
+void ItemData::erase(const std::string &key) {
+    if (entries.empty()) {
+        return;
+    }
+
+    if (const auto symbol = SymbolTable::get().find(key)) {
+        erase(*symbol);
+    }
+}
@@ -0,0 +1,121 @@
+/*
+ * illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of illarionserver.
+ *
+ * illarionserver is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * illarionserver is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ITEM_DATA_HPP
+#define ITEM_DATA_HPP
+
+#include "MemoryUsage.hpp"
+#include "SymbolTable.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Key value pairs of an item, kept sorted by key in a flat vector. Most items have no data and then own no heap
+// memory at all, the few others mostly carry one to three entries, where comparing keys beats hashing them.
+// Keys come from a small set and are interned in the SymbolTable, values are stored as they are.
+class ItemData {
+public:
+    using Key = SymbolTable::Id;
+
+private:
+    struct Entry {
+        Key key;
+        std::string value;
+
+        auto operator==(const Entry &other) const -> bool { return key == other.key && value == other.value; }
+    };
+
+    using Entries = std::vector<Entry>;
+
+public:
+    // iterates over pairs of key and value texts
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<std::string, std::string>;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::pair<const std::string &, const std::string &>;
+
+        struct pointer {
+            reference pair;
+            auto operator->() const -> const reference * { return &pair; }
+        };
+
+        const_iterator() = default;
+        explicit const_iterator(Entries::const_iterator entry) : entry(entry) {}
+
+        auto operator*() const -> reference { return {SymbolTable::get().text(entry->key), entry->value}; }
+        auto operator->() const -> pointer { return {**this}; }
+
+        auto operator++() -> const_iterator & {
+            ++entry;
+            return *this;
+        }
+
+        auto operator++(int) -> const_iterator {
+            auto previous = *this;
+            ++entry;
+            return previous;
+        }
+
+        auto operator==(const const_iterator &other) const -> bool { return entry == other.entry; }
+        auto operator!=(const const_iterator &other) const -> bool { return entry != other.entry; }
+
+    private:
+        Entries::const_iterator entry;
+    };
+
+    [[nodiscard]] auto empty() const -> bool { return entries.empty(); }
+    [[nodiscard]] auto size() const -> size_t { return entries.size(); }
+    [[nodiscard]] auto begin() const -> const_iterator { return const_iterator(entries.cbegin()); }
+    [[nodiscard]] auto end() const -> const_iterator { return const_iterator(entries.cend()); }
+
+    // nullptr if the key is not set
+    [[nodiscard]] auto find(Key key) const -> const std::string *;
+    [[nodiscard]] auto find(const std::string &key) const -> const std::string *;
+    void set(Key key, const std::string &value);
+    void set(const std::string &key, const std::string &value);
+    void erase(Key key);
+    void erase(const std::string &key);
+    void clear() { entries.clear(); }
+    // estimated heap bytes, see MemoryUsage.hpp
+    [[nodiscard]] auto memoryUsage() const -> size_t {
+        size_t bytes = memory::of(entries);
+
+        for (const auto &entry : entries) {
+            bytes += memory::of(entry.value);
+        }
+
+        return bytes;
+    }
+
+    auto operator==(const ItemData &other) const -> bool { return entries == other.entries; }
+    auto operator!=(const ItemData &other) const -> bool { return !(*this == other); }
+
+private:
+    Entries entries;
+
+    [[nodiscard]] auto lowerBound(Key key) const -> Entries::const_iterator;
+};
+
+#endif
@@ -0,0 +1,127 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "KeywordMatcher.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <queue>
+
+namespace {
+constexpr uint32_t noNode = 0;
+
+auto fold(char c) -> char { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); }
+} // namespace
+
+KeywordMatcher::KeywordMatcher(const std::vector<std::string> &keywords) {
+    for (const auto &keyword : keywords) {
+        insert(keyword);
+    }
+
+    link();
+}
+
+auto KeywordMatcher::matches(std::string_view text) const -> bool {
+    if (empty()) {
+        return false;
+    }
+
+    NodeIndex node = 0;
+
+    for (const char c : text) {
+        node = step(node, fold(c));
+
+        if (nodes[node].accepts) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// the root is never a child, so it marks a missing edge
+auto KeywordMatcher::child(NodeIndex node, char c) const -> NodeIndex {
+    const auto &next = nodes[node].next;
+    const auto edge = std::lower_bound(next.begin(), next.end(), c,
+                                       [](const auto &entry, char value) { return entry.first < value; });
+    return edge != next.end() && edge->first == c ? edge->second : noNode;
+}
+
+auto KeywordMatcher::step(NodeIndex node, char c) const -> NodeIndex {
+    while (true) {
+        if (const auto next = child(node, c); next != noNode) {
+            return next;
+        }
+
+        if (node == 0) {
+            return 0;
+        }
+
+        node = nodes[node].fail;
+    }
+}
+
+void KeywordMatcher::insert(std::string_view keyword) {
+    // an empty keyword would match every text, which is what having no keywords means already
+    if (keyword.empty()) {
+        return;
+    }
+
+    NodeIndex node = 0;
+
+    for (const char raw : keyword) {
+        const char c = fold(raw);
+        auto next = child(node, c);
+
+        if (next == noNode) {
+            next = static_cast<NodeIndex>(nodes.size());
+            nodes.emplace_back();
+            auto &edges = nodes[node].next;
+            const auto at = std::lower_bound(edges.begin(), edges.end(), c,
+                                             [](const auto &entry, char value) { return entry.first < value; });
+            edges.insert(at, {c, next});
+        }
+
+        node = next;
+    }
+
+    nodes[node].accepts = true;
+}
+
+void KeywordMatcher::link() {
+    std::queue<NodeIndex> pending;
+
+    for (const auto &[c, next] : nodes[0].next) {
+        nodes[next].fail = 0;
+        pending.push(next);
+    }
+
+    while (!pending.empty()) {
+        const auto node = pending.front();
+        pending.pop();
+
+        for (const auto &[c, next] : nodes[node].next) {
+            const auto fail = step(nodes[node].fail, c);
+            nodes[next].fail = fail;
+            // a keyword ending inside a longer one still counts
+            nodes[next].accepts = nodes[next].accepts || nodes[fail].accepts;
+            pending.push(next);
+        }
+    }
+}
@@ -0,0 +1,57 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef KEYWORD_MATCHER_HPP
+#define KEYWORD_MATCHER_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Finds whether any of a set of keywords occurs in a text, ignoring ASCII case, in a single pass over the text
+// (Aho-Corasick automaton).
+class KeywordMatcher {
+public:
+    KeywordMatcher() = default;
+    explicit KeywordMatcher(const std::vector<std::string> &keywords);
+
+    [[nodiscard]] auto matches(std::string_view text) const -> bool;
+    [[nodiscard]] auto empty() const -> bool { return nodes.size() <= 1; }
+
+private:
+    using NodeIndex = uint32_t;
+
+    struct Node {
+        // sorted by character
+        std::vector<std::pair<char, NodeIndex>> next;
+        NodeIndex fail = 0;
+        bool accepts = false;
+    };
+
+    std::vector<Node> nodes{1};
+
+    [[nodiscard]] auto child(NodeIndex node, char c) const -> NodeIndex;
+    [[nodiscard]] auto step(NodeIndex node, char c) const -> NodeIndex;
+    void insert(std::string_view keyword);
+    void link();
+};
+
+#endif
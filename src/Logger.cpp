@@ -20,34 +20,312 @@
 
 #include "constants.hpp"
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <map>
+#include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
-LogType<LogPriority::EMERGENCY>::type Logger::emergency;
-LogType<LogPriority::ALERT>::type Logger::alert;
-LogType<LogPriority::CRITICAL>::type Logger::critical;
-LogType<LogPriority::ERROR>::type Logger::error;
-LogType<LogPriority::WARNING>::type Logger::warn;
-LogType<LogPriority::NOTICE>::type Logger::notice;
-LogType<LogPriority::INFO>::type Logger::info;
-LogType<LogPriority::DEBUG>::type Logger::debug;
+thread_local LogType<LogPriority::EMERGENCY>::type Logger::emergency;
+thread_local LogType<LogPriority::ALERT>::type Logger::alert;
+thread_local LogType<LogPriority::CRITICAL>::type Logger::critical;
+thread_local LogType<LogPriority::ERROR>::type Logger::error;
+thread_local LogType<LogPriority::WARNING>::type Logger::warn;
+thread_local LogType<LogPriority::NOTICE>::type Logger::notice;
+thread_local LogType<LogPriority::INFO>::type Logger::info;
+thread_local LogType<LogPriority::DEBUG>::type Logger::debug;
 
-void log_message(LogPriority priority, LogFacility facility, const std::string &message) {
+namespace {
+
+struct Entry {
+    LogPriority priority = LogPriority::INFO;
+    LogFacility facility = LogFacility::Other;
+    std::string message;
+};
+
+// Bounded queue for any number of producers and one consumer. Each slot's sequence tells whether it is free for
+// the producer at that position or filled for the consumer, so neither side takes a lock.
+class EntryRing {
+public:
+    EntryRing() : slots(capacity) {
+        for (size_t i = 0; i < capacity; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // leaves entry untouched if the ring is full
+    auto push(Entry &entry) -> bool {
+        auto position = tail.load(std::memory_order_relaxed);
+
+        while (true) {
+            auto &slot = slots[position % capacity];
+            const auto sequence = slot.sequence.load(std::memory_order_acquire);
+
+            if (sequence == position) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    slot.entry = std::move(entry);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (sequence < position) {
+                return false;
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    auto pop(Entry &entry) -> bool {
+        auto &slot = slots[head % capacity];
+
+        if (slot.sequence.load(std::memory_order_acquire) != head + 1) {
+            return false;
+        }
+
+        entry = std::move(slot.entry);
+        slot.sequence.store(head + capacity, std::memory_order_release);
+        ++head;
+        return true;
+    }
+
+private:
+    static constexpr size_t capacity = 8192;
+
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        Entry entry;
+    };
+
+    std::vector<Slot> slots;
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) size_t head = 0;
+};
+
+// messages of lower importance than warnings a facility may log per second, the rest is counted and reported
+constexpr auto messagesPerSecond = [] {
+    std::array<uint32_t, logFacilityCount> limits{};
+
+    for (auto &limit : limits) {
+        limit = 1000;
+    }
+
+    limits[logFacilityIndex(LogFacility::Player)] = 500;
+    limits[logFacilityIndex(LogFacility::Chat)] = 200;
+    return limits;
+}();
+
+constexpr auto writeInterval = std::chrono::milliseconds(20);
+
+auto priorityNames() -> const std::map<LogPriority, std::string> & {
+    static const std::map<LogPriority, std::string> names{
+            {LogPriority::EMERGENCY, "emerg"}, {LogPriority::ALERT, "alert"},     {LogPriority::CRITICAL, "crit"},
+            {LogPriority::ERROR, "err"},       {LogPriority::WARNING, "warning"}, {LogPriority::NOTICE, "notice"},
+            {LogPriority::INFO, "info"},       {LogPriority::DEBUG, "debug"}};
+    return names;
+}
+
+auto facilityNames() -> const std::map<LogFacility, std::string> & {
+    static const std::map<LogFacility, std::string> names{
+            {LogFacility::Database, "Database"}, {LogFacility::World, "World"}, {LogFacility::Script, "Script"},
+            {LogFacility::Player, "Player"},     {LogFacility::Chat, "Chat"},   {LogFacility::Admin, "Admin"},
+            {LogFacility::Other, "Other"}};
+    return names;
+}
+
+template <typename Key>
+auto findByName(const std::map<Key, std::string> &names, const std::string &name) -> const Key * {
+    for (const auto &[key, keyName] : names) {
+        if (keyName == name) {
+            return &key;
+        }
+    }
+
+    return nullptr;
+}
+
+void write(const Entry &entry) {
     if constexpr (useSysLog) {
         // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
-        syslog(static_cast<int>(priority) | static_cast<int>(facility), "%s", message.c_str());
+        syslog(static_cast<int>(entry.priority) | static_cast<int>(entry.facility), "%s", entry.message.c_str());
     } else {
-        static const std::map<LogPriority, std::string> priorityText{
-                {LogPriority::EMERGENCY, "emerg"}, {LogPriority::ALERT, "alert"},     {LogPriority::CRITICAL, "crit"},
-                {LogPriority::ERROR, "err"},       {LogPriority::WARNING, "warning"}, {LogPriority::NOTICE, "notice"},
-                {LogPriority::INFO, "info"},       {LogPriority::DEBUG, "debug"}};
+        std::cout << facilityNames().at(entry.facility) << " (" << priorityNames().at(entry.priority)
+                  << "): " << entry.message << '\n';
+    }
+}
+
+// Writes log messages on its own thread, so logging threads only format their message and queue it. Warnings and
+// more severe messages are never rate limited or dropped, if the ring is full they are written synchronously.
+class LogWriter {
+public:
+    // never destroyed, messages logged by static destructors are written synchronously after stop
+    static auto get() -> LogWriter & {
+        static auto *writer = new LogWriter();
+        return *writer;
+    }
 
-        static const std::map<LogFacility, std::string> facilityText{
-                {LogFacility::Database, "Database"}, {LogFacility::World, "World"}, {LogFacility::Script, "Script"},
-                {LogFacility::Player, "Player"},     {LogFacility::Chat, "Chat"},   {LogFacility::Admin, "Admin"},
-                {LogFacility::Other, "Other"}};
+    void submit(LogPriority priority, LogFacility facility, std::string message) {
+        const bool severe = static_cast<int>(priority) <= LOG_WARNING;
 
-        std::cout << facilityText.at(facility) << " (" << priorityText.at(priority) << "): " << message << std::endl;
+        if (!severe && !admit(facility)) {
+            return;
+        }
+
+        enqueue({priority, facility, std::move(message)}, severe);
     }
+
+    void stop() {
+        running.store(false, std::memory_order_release);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (stopping) {
+                return;
+            }
+
+            stopping = true;
+        }
+
+        wake.notify_one();
+
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+private:
+    struct RateLimit {
+        std::atomic<int64_t> second{0};
+        std::atomic<uint32_t> count{0};
+        std::atomic<uint32_t> suppressed{0};
+    };
+
+    EntryRing ring;
+    std::array<RateLimit, logFacilityCount> rateLimits{};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> running{true};
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread worker;
+
+    LogWriter() : worker([this] { run(); }) { std::atexit([] { Logger::stop(); }); }
+
+    // counts the message against the facility's limit, messages suppressed in the last second are reported with the
+    // first message of a new one
+    auto admit(LogFacility facility) -> bool {
+        const auto index = logFacilityIndex(facility);
+        auto &limit = rateLimits[index];
+        const auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                                 std::chrono::steady_clock::now().time_since_epoch())
+                                 .count();
+        auto second = limit.second.load(std::memory_order_relaxed);
+
+        if (second != now && limit.second.compare_exchange_strong(second, now, std::memory_order_relaxed)) {
+            limit.count.store(0, std::memory_order_relaxed);
+
+            if (const auto suppressed = limit.suppressed.exchange(0, std::memory_order_relaxed); suppressed > 0) {
+                enqueue({LogPriority::NOTICE, facility,
+                         std::to_string(suppressed) + " messages suppressed by the rate limit"},
+                        false);
+            }
+        }
+
+        if (limit.count.fetch_add(1, std::memory_order_relaxed) < messagesPerSecond[index]) {
+            return true;
+        }
+
+        limit.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    void enqueue(Entry entry, bool severe) {
+        if (running.load(std::memory_order_acquire) && ring.push(entry)) {
+            return;
+        }
+
+        if (severe || !running.load(std::memory_order_acquire)) {
+            write(entry);
+        } else {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void drain() {
+        Entry entry;
+
+        while (ring.pop(entry)) {
+            write(entry);
+        }
+
+        if (const auto lost = dropped.exchange(0, std::memory_order_relaxed); lost > 0) {
+            write({LogPriority::WARNING, LogFacility::Other,
+                   std::to_string(lost) + " log messages dropped, the log queue was full"});
+        }
+
+        if constexpr (!useSysLog) {
+            std::cout.flush();
+        }
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (!stopping) {
+            lock.unlock();
+            drain();
+            lock.lock();
+            wake.wait_for(lock, writeInterval, [this] { return stopping; });
+        }
+
+        lock.unlock();
+        drain();
+    }
+};
+
+} // namespace
+
+void log_message(LogPriority priority, LogFacility facility, std::string message) {
+    LogWriter::get().submit(priority, facility, std::move(message));
+}
+
+void Logger::setLevel(LogFacility facility, LogPriority priority) {
+    logLevels[logFacilityIndex(facility)].store(static_cast<int>(priority), std::memory_order_relaxed);
+}
+
+auto Logger::setLevels(const std::string &levels) -> bool {
+    std::istringstream stream(levels);
+    std::string entry;
+    bool understood = true;
+
+    while (std::getline(stream, entry, ',')) {
+        const auto separator = entry.find('=');
+
+        if (separator == std::string::npos) {
+            understood = understood && entry.empty();
+            continue;
+        }
+
+        const auto *facility = findByName(facilityNames(), entry.substr(0, separator));
+        const auto *priority = findByName(priorityNames(), entry.substr(separator + 1));
+
+        if (facility == nullptr || priority == nullptr) {
+            understood = false;
+            continue;
+        }
+
+        setLevel(*facility, *priority);
+    }
+
+    return understood;
 }
+
+void Logger::stop() { LogWriter::get().stop(); }
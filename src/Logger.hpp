@@ -19,8 +19,12 @@
 #ifndef LOGGER_HPP
 #define LOGGER_HPP
 
+#include <array>
+#include <atomic>
+#include <iomanip>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <syslog.h>
 #include <type_traits>
 
@@ -45,19 +49,48 @@ enum class LogPriority {
     DEBUG = LOG_DEBUG
 };
 
-constexpr auto isLogEnabled(LogPriority priority) -> bool { return priority != LogPriority::DEBUG; }
+// least important priority compiled in, staging builds can pass -DLOG_FLOOR=LOG_DEBUG
+#ifndef LOG_FLOOR
+#define LOG_FLOOR LOG_INFO
+#endif
+
+constexpr auto isLogEnabled(LogPriority priority) -> bool { return static_cast<int>(priority) <= LOG_FLOOR; }
+
+constexpr auto logFacilityCount = 8;
+
+constexpr auto logFacilityIndex(LogFacility facility) -> size_t {
+    return static_cast<size_t>((static_cast<int>(facility) - LOG_LOCAL0) >> 3);
+}
+
+// least important priority logged per facility, changed at runtime with Logger::setLevel
+inline std::array<std::atomic<int>, logFacilityCount> logLevels{LOG_DEBUG, LOG_DEBUG, LOG_DEBUG, LOG_DEBUG,
+                                                                LOG_DEBUG, LOG_DEBUG, LOG_DEBUG, LOG_DEBUG};
 
-void log_message(LogPriority priority, LogFacility facility, const std::string &message);
+inline auto isLogEnabled(LogPriority priority, LogFacility facility) -> bool {
+    return static_cast<int>(priority) <= logLevels[logFacilityIndex(facility)].load(std::memory_order_relaxed);
+}
+
+// queues the message for the background writer, which writes it to syslog or stdout
+void log_message(LogPriority priority, LogFacility facility, std::string message);
 
 namespace Log {
 class end_t {};
 static const end_t end __attribute__((unused));
+
+// appended as key=value, strings are quoted
+template <typename T> struct Field {
+    const char *key;
+    const T &value;
+};
+
+template <typename T> auto field(const char *key, const T &value) -> Field<T> { return {key, value}; }
 } // namespace Log
 
 class NullStream {
 public:
     inline constexpr NullStream() = default;
     inline auto operator()(LogFacility facility) const -> const NullStream & { return *this; }
+    [[nodiscard]] static constexpr auto enabled(LogFacility /*unused*/) -> bool { return false; }
 
     template <typename T> inline auto operator<<(const T & /*unused*/) const -> const NullStream & { return *this; }
 };
@@ -66,27 +99,54 @@ template <LogPriority priority> class LogStream {
 public:
     inline auto operator()(LogFacility facility) -> LogStream & {
         _facility = facility;
+        _enabled = isLogEnabled(priority, facility);
         return *this;
     }
 
+    [[nodiscard]] static auto enabled(LogFacility facility) -> bool { return isLogEnabled(priority, facility); }
+
     inline LogStream() = default;
     template <typename T> inline auto operator<<(const T &data) -> LogStream & {
         static_assert(!std::is_pointer<T>::value || std::is_same<T, const char *>::value ||
                               std::is_same<T, char *>::value,
                       "Logger cannot log pointers!");
-        _ss << data;
+
+        if (_enabled) {
+            _ss << data;
+        }
+
+        return *this;
+    }
+
+    template <typename T> inline auto operator<<(const Log::Field<T> &field) -> LogStream & {
+        if (!_enabled) {
+            return *this;
+        }
+
+        _ss << ' ' << field.key << '=';
+
+        if constexpr (std::is_convertible_v<const T &, std::string_view>) {
+            _ss << std::quoted(std::string_view(field.value));
+        } else {
+            *this << field.value;
+        }
+
         return *this;
     }
 
     auto operator<<(const Log::end_t & /*unused*/) -> LogStream & {
-        log_message(priority, _facility, _ss.str());
-        _ss.str({});
+        if (_enabled) {
+            log_message(priority, _facility, _ss.str());
+            _ss.str({});
+        }
+
         return *this;
     }
 
 private:
     std::stringstream _ss;
     LogFacility _facility = LogFacility::Other;
+    bool _enabled = true;
 };
 
 template <LogPriority priority> class LogType {
@@ -94,16 +154,31 @@ public:
     using type = std::conditional_t<isLogEnabled(priority), LogStream<priority>, NullStream>;
 };
 
+// streams are per thread, log statements of concurrent threads must not share a buffer
 class Logger {
 public:
-    static LogType<LogPriority::EMERGENCY>::type emergency;
-    static LogType<LogPriority::ALERT>::type alert;
-    static LogType<LogPriority::CRITICAL>::type critical;
-    static LogType<LogPriority::ERROR>::type error;
-    static LogType<LogPriority::WARNING>::type warn;
-    static LogType<LogPriority::NOTICE>::type notice;
-    static LogType<LogPriority::INFO>::type info;
-    static LogType<LogPriority::DEBUG>::type debug;
+    static thread_local LogType<LogPriority::EMERGENCY>::type emergency;
+    static thread_local LogType<LogPriority::ALERT>::type alert;
+    static thread_local LogType<LogPriority::CRITICAL>::type critical;
+    static thread_local LogType<LogPriority::ERROR>::type error;
+    static thread_local LogType<LogPriority::WARNING>::type warn;
+    static thread_local LogType<LogPriority::NOTICE>::type notice;
+    static thread_local LogType<LogPriority::INFO>::type info;
+    static thread_local LogType<LogPriority::DEBUG>::type debug;
+
+    static void setLevel(LogFacility facility, LogPriority priority);
+    // applies a list like "Script=debug,Chat=warning", returns false if an entry was not understood
+    static auto setLevels(const std::string &levels) -> bool;
+
+    // writes all queued messages and terminates the writer, later messages are written synchronously
+    static void stop();
 };
 
+// skips evaluating the streamed arguments if the message would be discarded anyway:
+// LOG(debug, LogFacility::World) << expensive() << Log::end;
+#define LOG(stream, facility)                                                                                          \
+    if (!Logger::stream.enabled(facility)) {                                                                           \
+    } else                                                                                                             \
+        Logger::stream(facility)
+
 #endif
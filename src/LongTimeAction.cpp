@@ -45,51 +45,43 @@ void LongTimeAction::setLastAction(std::shared_ptr<LuaScript> script, const SouT
     }
 }
 
-auto LongTimeAction::checkAction() -> bool {
-    if (_actionrunning) {
-        // check if timetowaittimer is initialized and if we hit the next time
-        if (_timetowaitTimer && _timetowaitTimer->intervalExceeded()) {
-            successAction();
-            return true;
-        }
+LongTimeAction::~LongTimeAction() { cancelTimers(); }
 
-        if ((_redoaniTimer) && (_redoaniTimer->intervalExceeded()) && (_ani != 0)) {
-            _world->gfx(_ani, _owner->getPosition());
-        }
+void LongTimeAction::cancelTimers() {
+    if (_world == nullptr) {
+        return;
+    }
 
-        if ((_redosoundTimer) && (_redosoundTimer->intervalExceeded()) && (_sound != 0)) {
-            _world->makeSound(_sound, _owner->getPosition());
+    for (auto *handle : {&_completion, &_animation, &_redoSound}) {
+        if (handle->isValid()) {
+            _world->scheduler.cancel(*handle);
+            *handle = {};
         }
     }
-
-    return false;
 }
 
 void LongTimeAction::startLongTimeAction(unsigned short int timetowait, unsigned short int ani,
                                          unsigned short int redoani, unsigned short int sound,
                                          unsigned short int redosound) {
+    cancelTimers();
     _actionrunning = true;
     _ani = ani;
     _sound = sound;
     constexpr auto dsToMsFactor = 100;
     using std::chrono::milliseconds;
 
-    _timetowaitTimer = std::make_unique<Timer>(milliseconds(timetowait * dsToMsFactor));
-
-    if (_redoaniTimer) {
-        _redoaniTimer.reset();
-    }
+    _completion = _world->scheduler.addOneshotTask([this] { successAction(); },
+                                                   milliseconds(timetowait * dsToMsFactor), "long_time_action");
 
     if (_ani != 0 && redoani != 0) {
-        _redoaniTimer = std::make_unique<Timer>(milliseconds(redoani * dsToMsFactor));
-    }
-
-    if (_redosoundTimer) {
-        _redosoundTimer.reset();
+        _animation = _world->scheduler.addRecurringTask([this] { _world->gfx(_ani, _owner->getPosition()); },
+                                                        milliseconds(redoani * dsToMsFactor), "long_time_action_gfx");
     }
 
     if (_sound != 0 && redosound != 0) {
-        _redosoundTimer = std::make_unique<Timer>(milliseconds(redosound * dsToMsFactor));
+        _redoSound =
+                _world->scheduler.addRecurringTask([this] { _world->makeSound(_sound, _owner->getPosition()); },
+                                                   milliseconds(redosound * dsToMsFactor), "long_time_action_sound");
     }
 
     if (_sound != 0) {
@@ -217,9 +209,7 @@ void LongTimeAction::abortAction() {
 
     _actionrunning = false;
     _script.reset();
-    _redoaniTimer.reset();
-    _redosoundTimer.reset();
-    _timetowaitTimer.reset();
+    cancelTimers();
     _ani = 0;
     _sound = 0;
 }
@@ -229,6 +219,8 @@ void LongTimeAction::successAction() {
 
     if (_actionrunning) {
         _actionrunning = false;
+        // before the script, which may start the next action
+        cancelTimers();
 
         if (_at == ACTION_CRAFT) {
             if (_source.Type == LUA_DIALOG) {
@@ -282,9 +274,7 @@ void LongTimeAction::successAction() {
 
     if (!_actionrunning) {
         _script.reset();
-        _redoaniTimer.reset();
-        _redosoundTimer.reset();
-        _timetowaitTimer.reset();
+        cancelTimers();
         _ani = 0;
         _sound = 0;
     }
@@ -20,7 +20,7 @@
 #define CLONGTIMEACTION_HPP
 
 #include "Item.hpp"
-#include "Timer.hpp"
+#include "Scheduler.hpp"
 #include "script/LuaScript.hpp"
 
 #include <memory>
@@ -72,6 +72,11 @@ public:
      *@param world the gameworld
      */
     LongTimeAction(Player *player, World *world);
+    LongTimeAction(const LongTimeAction &) = delete;
+    auto operator=(const LongTimeAction &) -> LongTimeAction & = delete;
+    LongTimeAction(LongTimeAction &&) = delete;
+    auto operator=(LongTimeAction &&) -> LongTimeAction & = delete;
+    ~LongTimeAction();
 
     /**
      *sets the last action to the new values so the script can called correctly
@@ -132,10 +137,10 @@ public:
     void successAction();
 
     /**
-     *checks the last Action of the player if its maybe succseful
-     *@return true if the action was successfully performed
+     *drops the pending success, animation and sound without calling any script, needed before the owner leaves the
+     *game thread
      */
-    auto checkAction() -> bool;
+    void cancelTimers();
 
     /**
      *checks if currently an action is running or not
@@ -154,12 +159,9 @@ private:
 
     bool _actionrunning = false; /**< boolean value, if true there is currently a action running*/
 
-    std::unique_ptr<Timer> _timetowaitTimer =
-            nullptr; /**< timer which determines how many ms the action has to wait until it is sucessful*/
-    std::unique_ptr<Timer> _redoaniTimer =
-            nullptr; /**< timer which determines after how many ms the animation is shown again*/
-    std::unique_ptr<Timer> _redosoundTimer =
-            nullptr; /**< timer which determines how many ms the sound is played again.*/
+    TaskHandle _completion; /**< world scheduler task which makes the action sucessful*/
+    TaskHandle _animation;  /**< world scheduler task which shows the animation again*/
+    TaskHandle _redoSound;  /**< world scheduler task which plays the sound again*/
 
     ActionType _at = ACTION_USE; /**< type of the action @see ActionType*/
 
@@ -22,18 +22,23 @@
 
 #include "LongTimeEffect.hpp"
 #include "Player.hpp"
+#include "World.hpp"
 #include "data/Data.hpp"
 #include "db/Connection.hpp"
 #include "db/ConnectionManager.hpp"
-#include "db/DeleteQuery.hpp"
 #include "db/Result.hpp"
-#include "db/SelectQuery.hpp"
+#include "db/PreparedQuery.hpp"
 
 #include <algorithm>
 #include <range/v3/all.hpp>
 #include <string>
 
-LongTimeCharacterEffects::LongTimeCharacterEffects(Character *owner) : owner(owner), time(0) {}
+int32_t LongTimeCharacterEffects::time = 0;
+std::priority_queue<LongTimeCharacterEffects::DueCharacter, std::vector<LongTimeCharacterEffects::DueCharacter>,
+                    std::greater<>>
+        LongTimeCharacterEffects::dueCharacters;
+
+LongTimeCharacterEffects::LongTimeCharacterEffects(Character *owner) : owner(owner) {}
 
 auto LongTimeCharacterEffects::find(uint16_t effectid, LongTimeEffect *&effect) const -> bool {
     using namespace ranges;
@@ -87,6 +92,7 @@ void LongTimeCharacterEffects::addEffect(std::unique_ptr<LongTimeEffect> effect)
         effect->firstAdd();
         effects.push_back(std::move(effect));
         std::push_heap(effects.begin(), effects.end(), LongTimeEffect::priority);
+        schedule();
     } else {
         const auto &script = Data::longTimeEffects().script(effect->getEffectId());
 
@@ -150,12 +156,10 @@ auto LongTimeCharacterEffects::removeEffect(LongTimeEffect *effect) -> bool {
     return false;
 }
 
-void LongTimeCharacterEffects::checkEffects() {
-    ++time;
-    constexpr auto scriptLimit = 200;
+auto LongTimeCharacterEffects::checkEffects(int limit) -> int {
     int emexit = 0;
 
-    while (!effects.empty() && (emexit < scriptLimit) && (effects.front()->getExecutionTime() <= time)) {
+    while (!effects.empty() && (emexit < limit) && (effects.front()->getExecutionTime() <= time)) {
         ++emexit;
         std::pop_heap(effects.begin(), effects.end(), LongTimeEffect::priority);
         std::unique_ptr<LongTimeEffect> effect = std::move(effects.back());
@@ -171,52 +175,57 @@ void LongTimeCharacterEffects::checkEffects() {
             }
         }
     }
-}
 
-auto LongTimeCharacterEffects::save() -> bool {
-    using namespace Database;
+    return emexit;
+}
 
-    if ((owner != nullptr) && owner->getType() != Character::player) {
-        return false;
+void LongTimeCharacterEffects::schedule() {
+    if (effects.empty()) {
+        return;
     }
 
-    auto *player = dynamic_cast<Player *>(owner);
+    // effects added during a tick are called on the next one at the earliest
+    const auto due = std::max(effects.front()->getExecutionTime(), time + 1);
 
-    if (owner == nullptr) {
-        return false;
+    if (!scheduled || due < *scheduled) {
+        dueCharacters.push({due, owner->getId(), owner->getHandle()});
+        scheduled = due;
     }
+}
 
-    PConnection connection = ConnectionManager::getInstance().getConnection();
-    connection->beginTransaction();
+void LongTimeCharacterEffects::checkDueEffects(int budget) {
+    ++time;
 
-    try {
-        {
-            DeleteQuery query(connection);
-            query.addEqualCondition<TYPE_OF_CHARACTER_ID>("playerlteffects", "plte_playerid", player->getId());
-            query.setServerTable("playerlteffects");
-            query.execute();
+    while (!dueCharacters.empty() && dueCharacters.top().time <= time && budget > 0) {
+        const auto due = dueCharacters.top();
+        dueCharacters.pop();
+        auto *character = World::get()->findCharacterByHandle(due.id, due.handle);
+
+        if (character == nullptr || character->effects.scheduled != due.time) {
+            continue;
         }
-        {
-            DeleteQuery query(connection);
-            query.addEqualCondition<TYPE_OF_CHARACTER_ID>("playerlteffectvalues", "pev_playerid", player->getId());
-            query.setServerTable("playerlteffectvalues");
-            query.execute();
+
+        auto &characterEffects = character->effects;
+        characterEffects.scheduled.reset();
+
+        // dead creatures do not suffer effects until they are revived
+        if (character->isAlive() || character->getType() == Character::player) {
+            budget -= characterEffects.checkEffects(std::min(budget, scriptLimit));
         }
-        connection->commitTransaction();
-    } catch (std::exception &e) {
-        Logger::error(LogFacility::Database)
-                << "Error while saving long time effects for " << player->to_string() << ": " << e.what() << Log::end;
-        connection->rollbackTransaction();
-        return false;
+
+        characterEffects.schedule();
     }
+}
 
-    bool allok = true;
+auto LongTimeCharacterEffects::snapshot() const -> std::vector<PlayerSnapshot::EffectRow> {
+    std::vector<PlayerSnapshot::EffectRow> rows;
+    rows.reserve(effects.size());
 
-    for (auto &effect : effects) {
-        allok and_eq effect->save(player->getId(), time);
+    for (const auto &effect : effects) {
+        rows.push_back(effect->snapshot(time));
     }
 
-    return allok;
+    return rows;
 }
 
 auto LongTimeCharacterEffects::load() -> bool {
@@ -226,20 +235,16 @@ auto LongTimeCharacterEffects::load() -> bool {
         return false;
     }
 
-    auto *player = dynamic_cast<Player *>(owner);
+    auto *player = static_cast<Player *>(owner);
 
     PConnection connection = ConnectionManager::getInstance().getConnection();
 
     try {
-        SelectQuery query(connection);
-        query.addColumn("playerlteffects", "plte_effectid");
-        query.addColumn("playerlteffects", "plte_nextcalled");
-        query.addColumn("playerlteffects", "plte_numbercalled");
-        query.addEqualCondition<TYPE_OF_CHARACTER_ID>("playerlteffects", "plte_playerid", player->getId());
-        query.addServerTable("playerlteffects");
-        query.addOrderBy("playerlteffects", "plte_nextcalled", SelectQuery::ASC);
-
-        Result results = query.execute();
+        static const PreparedQuery query("load_long_time_effects",
+                                         "SELECT plte_effectid, plte_nextcalled, plte_numbercalled "
+                                         "FROM {server}.playerlteffects WHERE plte_playerid = $1 "
+                                         "ORDER BY plte_nextcalled ASC");
+        Result results = query.execute(connection, player->getId());
 
         if (!results.empty()) {
             for (const auto &row : results) {
@@ -250,15 +255,10 @@ auto LongTimeCharacterEffects::load() -> bool {
                 effect->firstAdd();
                 effect->setNumberOfCalls(row["plte_numberCalled"].as<uint32_t>());
 
-                SelectQuery valuesQuery(connection);
-                valuesQuery.addColumn("playerlteffectvalues", "pev_name");
-                valuesQuery.addColumn("playerlteffectvalues", "pev_value");
-                valuesQuery.addEqualCondition<TYPE_OF_CHARACTER_ID>("playerlteffectvalues", "pev_playerid",
-                                                                    player->getId());
-                valuesQuery.addEqualCondition<uint16_t>("playerlteffectvalues", "pev_effectid", effectId);
-                valuesQuery.addServerTable("playerlteffectvalues");
-
-                Result valuesResults = valuesQuery.execute();
+                static const PreparedQuery valuesQuery("load_long_time_effect_values",
+                                                       "SELECT pev_name, pev_value FROM {server}.playerlteffectvalues "
+                                                       "WHERE pev_playerid = $1 AND pev_effectid = $2");
+                Result valuesResults = valuesQuery.execute(connection, player->getId(), effectId);
 
                 if (!valuesResults.empty()) {
                     for (const auto &valueRow : valuesResults) {
@@ -277,6 +277,7 @@ auto LongTimeCharacterEffects::load() -> bool {
         }
 
         std::make_heap(effects.begin(), effects.end(), LongTimeEffect::priority);
+        schedule();
 
         return true;
     } catch (std::exception &e) {
@@ -22,8 +22,13 @@
 #define LONGTIMECHARACTEREFFECTS_HPP_
 
 #include "LongTimeEffect.hpp"
+#include "SlotMap.hpp"
+#include "types.hpp"
 
+#include <functional>
 #include <memory>
+#include <optional>
+#include <queue>
 #include <string>
 #include <vector>
 
@@ -41,17 +46,40 @@ public:
     auto removeEffect(const std::string &name) -> bool;
     auto removeEffect(LongTimeEffect *effect) -> bool;
 
-    void checkEffects();
-    auto save() -> bool;
+    [[nodiscard]] auto snapshot() const -> std::vector<PlayerSnapshot::EffectRow>;
     auto load() -> bool;
 
+    // advances the effect clock by one tick and calls the effects due of all characters, at most budget of them;
+    // whoever has effects due beyond that is served first on the next tick
+    static void checkDueEffects(int budget);
+
 private:
+    // the earliest effect of a character is due at time
+    struct DueCharacter {
+        int32_t time;
+        TYPE_OF_CHARACTER_ID id;
+        SlotHandle handle;
+
+        auto operator>(const DueCharacter &other) const -> bool { return time > other.time; }
+    };
+
+    static constexpr auto scriptLimit = 200;
+
+    // ticks since server start, all execution times refer to it
+    static int32_t time;
+    // characters with effects, entries superseded by an earlier one or left by removed characters are skipped
+    static std::priority_queue<DueCharacter, std::vector<DueCharacter>, std::greater<>> dueCharacters;
+
+    auto checkEffects(int limit) -> int;
+    // queues the owner for its earliest effect, unless it is queued for that already
+    void schedule();
+
     using EFFECTS = std::vector<std::unique_ptr<LongTimeEffect>>;
     EFFECTS effects;
 
     Character *owner;
 
-    int32_t time;
+    std::optional<int32_t> scheduled;
 };
 
 #endif
@@ -21,6 +21,8 @@
 #ifndef LONGTIMEEFFECT_HPP
 #define LONGTIMEEFFECT_HPP
 
+#include "PlayerSnapshot.hpp"
+
 #include <string>
 #include <unordered_map>
 
@@ -37,7 +39,8 @@ public:
     auto findValue(const std::string &name, uint32_t &ret) -> bool;
 
     auto callEffect(Character *target) -> bool;
-    auto save(uint32_t playerid, int32_t currentTime) -> bool;
+    // currentTime is the effect time of the owner
+    [[nodiscard]] auto snapshot(int32_t currentTime) const -> PlayerSnapshot::EffectRow;
 
     auto isFirstAdd() const -> bool { return firstadd; }
     void firstAdd() { firstadd = false; }
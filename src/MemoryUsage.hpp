@@ -0,0 +1,55 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MEMORY_USAGE_HPP
+#define MEMORY_USAGE_HPP
+
+#include <climits>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Rough heap footprint of standard containers for the memory accounting, excluding what the elements own
+// themselves. Node sizes assume the layouts of libstdc++.
+namespace memory {
+
+constexpr size_t treeNodeOverhead = 4 * sizeof(void *);
+constexpr size_t hashNodeOverhead = 2 * sizeof(void *);
+constexpr size_t smallStringCapacity = 15;
+
+template <typename T, typename Allocator> auto of(const std::vector<T, Allocator> &vector) -> size_t {
+    return vector.capacity() * sizeof(T);
+}
+
+inline auto of(const std::vector<bool> &vector) -> size_t { return vector.capacity() / CHAR_BIT; }
+
+inline auto of(const std::string &text) -> size_t {
+    return text.capacity() > smallStringCapacity ? text.capacity() + 1 : 0;
+}
+
+template <typename Map> auto ofHashed(const Map &map) -> size_t {
+    return map.bucket_count() * sizeof(void *) + map.size() * (sizeof(typename Map::value_type) + hashNodeOverhead);
+}
+
+template <typename Map> auto ofTree(const Map &map) -> size_t {
+    return map.size() * (sizeof(typename Map::value_type) + treeNodeOverhead);
+}
+
+} // namespace memory
+
+#endif
@@ -0,0 +1,156 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Metrics.hpp"
+
+#include "Logger.hpp"
+
+#include <boost/asio.hpp>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace metrics {
+
+auto Registry::exposition() const -> std::string {
+    std::string out;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (const auto &[name, family] : families) {
+        if (family.metrics.empty()) {
+            continue;
+        }
+
+        out += "# HELP " + name + ' ' + family.help + '\n';
+        out += "# TYPE " + name + ' ' + family.metrics.begin()->second->type() + '\n';
+
+        for (const auto &[labels, metric] : family.metrics) {
+            metric->expose(out, name, labels);
+        }
+    }
+
+    return out;
+}
+
+namespace {
+
+// answers every request on a connection with the exposition and closes it, scrapes are rare and small
+class Exporter {
+public:
+    static auto get() -> Exporter & {
+        static Exporter exporter;
+        return exporter;
+    }
+
+    Exporter(const Exporter &) = delete;
+    auto operator=(const Exporter &) -> Exporter & = delete;
+    Exporter(Exporter &&) = delete;
+    auto operator=(Exporter &&) -> Exporter & = delete;
+    ~Exporter() { stop(); }
+
+    void start(uint16_t port) {
+        if (port == 0 || acceptor) {
+            return;
+        }
+
+        try {
+            using boost::asio::ip::tcp;
+            acceptor = std::make_unique<tcp::acceptor>(io_service, tcp::endpoint(tcp::v4(), port));
+            accept_next();
+            worker = std::thread([this] { io_service.run(); });
+            Logger::info(LogFacility::Other) << "Serving metrics on port " << port << Log::end;
+        } catch (const boost::system::system_error &e) {
+            acceptor.reset();
+            Logger::error(LogFacility::Other) << "Failed to serve metrics on port " << port << ": " << e.what()
+                                              << Log::end;
+        }
+    }
+
+    void stop() {
+        io_service.stop();
+
+        if (worker.joinable()) {
+            worker.join();
+        }
+
+        acceptor.reset();
+    }
+
+private:
+    static constexpr size_t maxRequestSize = 8192;
+
+    struct Session {
+        explicit Session(boost::asio::io_service &io_service) : socket(io_service), request(maxRequestSize) {}
+
+        boost::asio::ip::tcp::socket socket;
+        boost::asio::streambuf request;
+        std::string response;
+    };
+
+    boost::asio::io_service io_service;
+    std::unique_ptr<boost::asio::ip::tcp::acceptor> acceptor;
+    std::thread worker;
+
+    Exporter() = default;
+
+    void accept_next() {
+        auto session = std::make_shared<Session>(io_service);
+        acceptor->async_accept(session->socket, [this, session](const boost::system::error_code &error) {
+            if (error == boost::asio::error::operation_aborted) {
+                return;
+            }
+
+            if (!error) {
+                respond(session);
+            }
+
+            accept_next();
+        });
+    }
+
+    static void respond(const std::shared_ptr<Session> &session) {
+        boost::asio::async_read_until(
+                session->socket, session->request, "\r\n\r\n",
+                [session](const boost::system::error_code &error, size_t /*bytes_transferred*/) {
+                    if (error) {
+                        return;
+                    }
+
+                    const auto body = Registry::get().exposition();
+                    session->response = "HTTP/1.0 200 OK\r\n"
+                                        "Content-Type: text/plain; version=0.0.4\r\n"
+                                        "Content-Length: " +
+                                        std::to_string(body.size()) + "\r\n\r\n" + body;
+                    boost::asio::async_write(session->socket, boost::asio::buffer(session->response),
+                                             [session](const boost::system::error_code & /*error*/,
+                                                       size_t /*bytes_transferred*/) {
+                                                 boost::system::error_code ignored;
+                                                 session->socket.shutdown(
+                                                         boost::asio::ip::tcp::socket::shutdown_both, ignored);
+                                             });
+                });
+    }
+};
+
+} // namespace
+
+void startExporter(uint16_t port) { Exporter::get().start(port); }
+
+void stopExporter() { Exporter::get().stop(); }
+
+} // namespace metrics
@@ -0,0 +1,269 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Counters, gauges and histograms for monitoring. Updating a metric is a relaxed atomic operation, only registering
+// one takes a lock, so call sites look their metrics up once and keep the reference.
+namespace metrics {
+
+class Metric {
+public:
+    Metric() = default;
+    Metric(const Metric &) = delete;
+    auto operator=(const Metric &) -> Metric & = delete;
+    Metric(Metric &&) = delete;
+    auto operator=(Metric &&) -> Metric & = delete;
+    virtual ~Metric() = default;
+
+    [[nodiscard]] virtual auto type() const -> const char * = 0;
+    // appends the samples in the Prometheus text format, labels are given without braces
+    virtual void expose(std::string &out, const std::string &name, const std::string &labels) const = 0;
+
+protected:
+    static void sample(std::string &out, const std::string &name, const std::string &labels, const std::string &value) {
+        out += name;
+
+        if (!labels.empty()) {
+            out += '{' + labels + '}';
+        }
+
+        out += ' ' + value + '\n';
+    }
+};
+
+class Counter : public Metric {
+public:
+    void increment(uint64_t amount = 1) { value.fetch_add(amount, std::memory_order_relaxed); }
+    [[nodiscard]] auto get() const -> uint64_t { return value.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] auto type() const -> const char * override { return "counter"; }
+    void expose(std::string &out, const std::string &name, const std::string &labels) const override {
+        sample(out, name, labels, std::to_string(get()));
+    }
+
+private:
+    std::atomic<uint64_t> value{0};
+};
+
+class Gauge : public Metric {
+public:
+    void set(int64_t newValue) { value.store(newValue, std::memory_order_relaxed); }
+    void add(int64_t amount) { value.fetch_add(amount, std::memory_order_relaxed); }
+    [[nodiscard]] auto get() const -> int64_t { return value.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] auto type() const -> const char * override { return "gauge"; }
+    void expose(std::string &out, const std::string &name, const std::string &labels) const override {
+        sample(out, name, labels, std::to_string(get()));
+    }
+
+private:
+    std::atomic<int64_t> value{0};
+};
+
+// durations counted into buckets with fixed upper bounds
+class Histogram : public Metric {
+public:
+    using Bounds = std::vector<std::chrono::nanoseconds>;
+
+    explicit Histogram(Bounds bounds) : bounds(std::move(bounds)), buckets(this->bounds.size() + 1) {}
+
+    void observe(std::chrono::nanoseconds duration) {
+        size_t bucket = 0;
+
+        while (bucket < bounds.size() && duration > bounds[bucket]) {
+            ++bucket;
+        }
+
+        buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0)), std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] auto count() const -> uint64_t {
+        uint64_t count = 0;
+
+        for (const auto &bucket : buckets) {
+            count += bucket.load(std::memory_order_relaxed);
+        }
+
+        return count;
+    }
+
+    [[nodiscard]] auto total() const -> std::chrono::nanoseconds {
+        return std::chrono::nanoseconds(static_cast<int64_t>(sum.load(std::memory_order_relaxed)));
+    }
+
+    // upper bound of the bucket holding the given fraction of the observations, the largest bound if it lies beyond
+    [[nodiscard]] auto quantile(double fraction) const -> std::chrono::nanoseconds {
+        const auto observed = count();
+
+        if (observed == 0 || bounds.empty()) {
+            return std::chrono::nanoseconds::zero();
+        }
+
+        const auto exactRank = std::ceil(fraction * static_cast<double>(observed));
+        const auto rank = std::max<uint64_t>(static_cast<uint64_t>(exactRank), 1);
+        uint64_t seen = 0;
+
+        for (size_t bucket = 0; bucket < bounds.size(); ++bucket) {
+            seen += buckets[bucket].load(std::memory_order_relaxed);
+
+            if (seen >= rank) {
+                return bounds[bucket];
+            }
+        }
+
+        return bounds.back();
+    }
+
+    [[nodiscard]] auto type() const -> const char * override { return "histogram"; }
+    void expose(std::string &out, const std::string &name, const std::string &labels) const override {
+        const auto prefix = labels.empty() ? std::string() : labels + ',';
+        uint64_t count = 0;
+
+        for (size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+            count += buckets[bucket].load(std::memory_order_relaxed);
+            const auto bound = bucket < bounds.size() ? seconds(bounds[bucket]) : std::string("+Inf");
+            sample(out, name + "_bucket", prefix + "le=\"" + bound + '"', std::to_string(count));
+        }
+
+        sample(out, name + "_sum", labels, seconds(total()));
+        sample(out, name + "_count", labels, std::to_string(count));
+    }
+
+private:
+    Bounds bounds;
+    std::vector<std::atomic<uint64_t>> buckets;
+    std::atomic<uint64_t> sum{0}; // nanoseconds
+
+    static auto seconds(std::chrono::nanoseconds duration) -> std::string {
+        return std::to_string(std::chrono::duration<double>(duration).count());
+    }
+};
+
+// from 100 microseconds to 5 seconds
+inline auto durationBounds() -> const Histogram::Bounds & {
+    using std::chrono::microseconds;
+    using std::chrono::milliseconds;
+    static const Histogram::Bounds bounds{microseconds(100), microseconds(250), microseconds(500), milliseconds(1),
+                                          milliseconds(2),   milliseconds(5),   milliseconds(10),  milliseconds(25),
+                                          milliseconds(50),  milliseconds(100), milliseconds(250), milliseconds(500),
+                                          milliseconds(1000), milliseconds(2500), milliseconds(5000)};
+    return bounds;
+}
+
+// observes the lifetime of the scope
+class Timer {
+public:
+    explicit Timer(Histogram &histogram) : histogram(histogram) {}
+    Timer(const Timer &) = delete;
+    auto operator=(const Timer &) -> Timer & = delete;
+    Timer(Timer &&) = delete;
+    auto operator=(Timer &&) -> Timer & = delete;
+    ~Timer() { histogram.observe(std::chrono::steady_clock::now() - start); }
+
+private:
+    Histogram &histogram;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+};
+
+class Registry {
+public:
+    static auto get() -> Registry & {
+        static Registry registry;
+        return registry;
+    }
+
+    // the same name and labels always give the same metric, labels look like type="say",lane="chat"
+    auto counter(const std::string &name, const std::string &help, const std::string &labels = {}) -> Counter & {
+        return find<Counter>(name, help, labels);
+    }
+
+    auto gauge(const std::string &name, const std::string &help, const std::string &labels = {}) -> Gauge & {
+        return find<Gauge>(name, help, labels);
+    }
+
+    auto histogram(const std::string &name, const std::string &help, const std::string &labels = {},
+                   const Histogram::Bounds &bounds = durationBounds()) -> Histogram & {
+        return find<Histogram>(name, help, labels, bounds);
+    }
+
+    // all metrics in the Prometheus text exposition format
+    [[nodiscard]] auto exposition() const -> std::string;
+
+private:
+    struct Family {
+        std::string help;
+        std::map<std::string, std::unique_ptr<Metric>> metrics;
+    };
+
+    mutable std::mutex mutex;
+    std::map<std::string, Family> families;
+
+    Registry() = default;
+
+    template <typename Type, typename... Args>
+    auto find(const std::string &name, const std::string &help, const std::string &labels, const Args &...args)
+            -> Type & {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto &family = families[name];
+        auto found = family.metrics.find(labels);
+
+        if (found == family.metrics.end()) {
+            auto created = std::make_unique<Type>(args...);
+
+            if (family.metrics.empty()) {
+                family.help = help;
+            } else if (std::string(family.metrics.begin()->second->type()) != created->type()) {
+                throw std::logic_error("metric " + name + " was registered with another type");
+            }
+
+            found = family.metrics.emplace(labels, std::move(created)).first;
+        }
+
+        auto *typed = dynamic_cast<Type *>(found->second.get());
+
+        if (typed == nullptr) {
+            throw std::logic_error("metric " + name + " was registered with another type");
+        }
+
+        return *typed;
+    }
+};
+
+// serves the registry over HTTP on its own thread for Prometheus to scrape, port 0 serves nothing
+void startExporter(uint16_t port);
+void stopExporter();
+
+} // namespace metrics
+
+#endif
@@ -20,12 +20,17 @@
 
 #include "Character.hpp"
 #include "Logger.hpp"
+#include "Metrics.hpp"
 #include "Player.hpp"
 #include "PlayerManager.hpp"
+#include "TickClock.hpp"
 #include "World.hpp"
 #include "netinterface/NetInterface.hpp"
 #include "netinterface/protocol/BBIWIClientCommands.hpp"
 #include "netinterface/protocol/BBIWIServerCommands.hpp"
+#include "tuningConstants.hpp"
+
+#include <sstream>
 
 MonitoringClients::MonitoringClients() : _world(World::get()) {}
 
@@ -41,46 +46,114 @@ void MonitoringClients::clientConnect(Player *player) {
     _world->Players.for_each([&](Player *p) {
         ServerCommandPointer cmd = std::make_shared<BBPlayerTC>(p->getId(), p->getName(), p->getPosition());
         player->Connection->addCommand(cmd);
-        cmd = std::make_shared<BBSendAttribTC>(p->getId(), "hitpoints", p->increaseAttrib("hitpoints", 0));
+        cmd = std::make_shared<BBSendAttribTC>(p->getId(), "hitpoints", p->increaseAttrib(Character::hitpoints, 0));
         player->Connection->addCommand(cmd);
-        cmd = std::make_shared<BBSendAttribTC>(p->getId(), "mana", p->increaseAttrib("mana", 0));
+        cmd = std::make_shared<BBSendAttribTC>(p->getId(), "mana", p->increaseAttrib(Character::mana, 0));
         player->Connection->addCommand(cmd);
-        cmd = std::make_shared<BBSendAttribTC>(p->getId(), "foodlevel", p->increaseAttrib("foodlevel", 0));
+        cmd = std::make_shared<BBSendAttribTC>(p->getId(), "foodlevel", p->increaseAttrib(Character::foodlevel, 0));
         player->Connection->addCommand(cmd);
     });
 }
 
-void MonitoringClients::sendCommand(const ServerCommandPointer &command) const {
+void MonitoringClients::sendCommand(const ServerCommandPointer &command) {
+    std::lock_guard<std::mutex> lock(eventMutex);
+
+    // states queued before a login or logout must not be updated by states queued after it
+    if (const auto kind = command->getDefinitionByte(); kind == BB_PLAYER_TC || kind == BB_LOGOUT_TC) {
+        stateEvents.clear();
+    }
+
+    events.push_back(command);
+}
+
+void MonitoringClients::sendState(uint64_t key, const ServerCommandPointer &command) {
+    std::lock_guard<std::mutex> lock(eventMutex);
+    const auto [state, inserted] = stateEvents.try_emplace(key, events.size());
+
+    if (inserted) {
+        events.push_back(command);
+    } else {
+        events[state->second] = command;
+    }
+}
+
+void MonitoringClients::flush() const {
     for (const auto &client : client_list) {
-        client->Connection->addCommand(command);
+        client->Connection->flush();
     }
 }
 
 void MonitoringClients::CheckClients() {
-    for (auto it = client_list.begin(); it != client_list.end(); ++it) {
-        time_t thetime = 0;
-        time(&thetime);
-
-        if ((*it)->Connection->online) {
-            time_t tempkeepalive = 0;
-            time(&tempkeepalive);
-            const long timeSinceLastKeepAlive = tempkeepalive - (*it)->lastkeepalive;
+    const time_t now = TickClock::wallNow();
+
+    for (auto it = client_list.begin(); it != client_list.end();) {
+        Player *client = *it;
+
+        if (client->Connection->online) {
+            const long timeSinceLastKeepAlive = now - client->lastkeepalive;
             const long timeout = 20;
 
             // check if we have a timeout
             if ((timeSinceLastKeepAlive >= 0) && (timeSinceLastKeepAlive < timeout)) {
-                (*it)->workoutCommands();
+                client->workoutCommands();
             } else {
                 // timeout so we have to disconnect
-                Logger::info(LogFacility::Admin) << "BBIWI Client timed out: " << (*it)->to_string() << Log::end;
-                (*it)->Connection->closeConnection();
+                Logger::info(LogFacility::Admin) << "BBIWI Client timed out: " << client->to_string() << Log::end;
+                client->Connection->closeConnection();
             }
+
+            ++it;
         } else {
-            PlayerManager::get().getLogOutPlayers().push_back(*it);
+            PlayerManager::get().addLogOutPlayer(client);
             it = client_list.erase(it);
-            --it;
         }
+    }
 
-        time(&thetime);
+    publish();
+}
+
+void MonitoringClients::publish() {
+    if (client_list.empty()) {
+        std::lock_guard<std::mutex> lock(eventMutex);
+        events.clear();
+        stateEvents.clear();
+        return;
+    }
+
+    if (const auto now = std::chrono::steady_clock::now(); now >= nextSnapshot) {
+        nextSnapshot = now + monitoringSnapshotInterval;
+        queueSnapshot();
+    }
+
+    std::vector<ServerCommandPointer> batch;
+
+    {
+        std::lock_guard<std::mutex> lock(eventMutex);
+        batch.swap(events);
+        stateEvents.clear();
     }
+
+    for (const auto &command : batch) {
+        // encoded here once, the clients share the buffer
+        command->addHeader();
+
+        for (const auto &client : client_list) {
+            client->Connection->addCommand(command);
+        }
+    }
+}
+
+void MonitoringClients::queueSnapshot() {
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+    auto &registry = metrics::Registry::get();
+    const auto &ticks = registry.histogram("illarion_tick_duration_seconds", "Game ticks that did work");
+
+    std::stringstream message;
+    message << "players " << registry.gauge("illarion_players_online", "Players logged in").get() << ", monsters "
+            << registry.gauge("illarion_monsters", "Monsters on the map").get() << ", npcs "
+            << registry.gauge("illarion_npcs", "NPCs on the map").get() << ", lua heap "
+            << registry.gauge("illarion_lua_heap_kilobytes", "Lua heap after the last tick").get()
+            << "kB, tick p99 since start " << duration_cast<milliseconds>(ticks.quantile(0.99)).count() << "ms";
+    sendCommand(std::make_shared<BBMessageTC>(message.str(), 0));
 }
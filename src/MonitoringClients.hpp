@@ -20,8 +20,13 @@
 #define CMONITORINGCLIENTS
 
 #include "netinterface/BasicServerCommand.hpp"
+#include "types.hpp"
 
+#include <chrono>
 #include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 class World;
 class Player;
@@ -41,18 +46,47 @@ public:
     void clientConnect(Player *player);
 
     /**
-     * sends a new Command to all the connected clients
+     * queues an event for all the connected clients, events are sent in batches by CheckClients
+     * and each event is encoded only once for all clients, safe to call from any thread
      * @param command the command which should be sended
      */
-    void sendCommand(const ServerCommandPointer &command) const;
+    void sendCommand(const ServerCommandPointer &command);
 
     /**
-     * function which checks if new commands from clients are arrived and handels them
+     * queues an event that replaces an unsent one with the same key,
+     * for states like positions or attributes where only the latest value matters
+     * @param key the state the event updates, see stateKey
+     * @param command the command which should be sended
+     */
+    void sendState(uint64_t key, const ServerCommandPointer &command);
+
+    static constexpr auto stateKey(TYPE_OF_CHARACTER_ID id, unsigned char kind, uint16_t detail = 0) -> uint64_t {
+        constexpr auto idShift = 32;
+        constexpr auto kindShift = 16;
+        return uint64_t{id} << idShift | uint64_t{kind} << kindShift | detail;
+    }
+
+    /**
+     * writes the commands queued for the clients
+     */
+    void flush() const;
+
+    /**
+     * function which checks if new commands from clients are arrived and handels them,
+     * then sends the batch of events queued since the last check
      */
     void CheckClients();
 
 private:
+    void publish();
+    void queueSnapshot();
+
     std::list<Player *> client_list;
     World *_world; /*< pointer to the gameworld*/
+
+    std::mutex eventMutex;
+    std::vector<ServerCommandPointer> events;
+    std::unordered_map<uint64_t, size_t> stateEvents; /*< index in events of the unsent event per state key*/
+    std::chrono::steady_clock::time_point nextSnapshot;
 };
 #endif
@@ -19,11 +19,13 @@
 #include "Monster.hpp"
 
 #include "Config.hpp"
+#include "ObjectPool.hpp"
 #include "Random.hpp"
 #include "WaypointList.hpp"
 #include "World.hpp"
 #include "data/MonsterTable.hpp"
 #include "data/RaceTypeTable.hpp"
+#include "flow_field.hpp"
 #include "script/LuaMonsterScript.hpp"
 #include "tuningConstants.hpp"
 
@@ -35,6 +37,30 @@ extern std::unique_ptr<RaceTypeTable> raceTypes;
 
 uint32_t Monster::counter = 0;
 
+namespace {
+auto monsterPool() -> ObjectPool & {
+    static ObjectPool pool("monsters", sizeof(Monster));
+    return pool;
+}
+} // namespace
+
+auto Monster::operator new(size_t size) -> void * {
+    if (size != sizeof(Monster)) {
+        return ::operator new(size);
+    }
+
+    return monsterPool().allocate();
+}
+
+void Monster::operator delete(void *pointer, size_t size) noexcept {
+    if (size != sizeof(Monster)) {
+        ::operator delete(pointer);
+        return;
+    }
+
+    monsterPool().deallocate(pointer);
+}
+
 Monster::Monster(const TYPE_OF_CHARACTER_ID &type, const position &newpos, SpawnPoint *spawnpoint)
         : lastTargetPosition(position(0, 0, 0)), spawn(spawnpoint), monstertype(type) {
     setId(MONSTER_BASE + counter++ % (NPC_BASE - MONSTER_BASE));
@@ -53,6 +79,13 @@ auto Monster::getLoot() const -> const MonsterStruct::loottype & {
 }
 
 void Monster::performStep(position targetpos) {
+    // monsters chasing the same target share one field of directions towards it
+    if (direction dir{}; pathfinding::flow_direction(getPosition(), targetpos, dir) && move(dir)) {
+        // a later search has to start over from the new position
+        waypoints.clear();
+        return;
+    }
+
     position currentTarget{};
     bool hasTarget = waypoints.getNextWaypoint(currentTarget);
 
@@ -179,8 +212,8 @@ auto Monster::attack(Character *target) -> bool {
 }
 
 void Monster::heal() {
-    increaseAttrib("hitpoints", monsterSelfHealAmount);
-    increaseAttrib("mana", monsterSelfHealAmount);
+    increaseAttrib(Character::hitpoints, monsterSelfHealAmount);
+    increaseAttrib(Character::mana, monsterSelfHealAmount);
 }
 
 void Monster::receiveText(talk_type tt, const std::string &message, Character *cc) {
@@ -108,6 +108,10 @@ public:
      */
     void performStep(position targetpos);
 
+    // monsters are allocated from an ObjectPool, classes derived from Monster use the global heap
+    static auto operator new(size_t size) -> void *;
+    static void operator delete(void *pointer, size_t size) noexcept;
+
     ~Monster() override;
     Monster(const Monster &) = delete;
     auto operator=(const Monster &) -> Monster & = delete;
@@ -0,0 +1,98 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MPSC_QUEUE_HPP
+#define MPSC_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Bounded lock-free queue for any number of producer threads and a single consumer thread.
+// Every cell carries a sequence number telling whether it is free for the producer of that round or filled for the
+// consumer, so neither side ever waits for the other.
+template <class T, size_t capacity> class MpscQueue {
+    static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "capacity has to be a power of two");
+
+public:
+    MpscQueue() {
+        for (size_t i = 0; i < capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    auto operator=(const MpscQueue &) -> MpscQueue & = delete;
+    MpscQueue(MpscQueue &&) = delete;
+    auto operator=(MpscQueue &&) -> MpscQueue & = delete;
+    ~MpscQueue() = default;
+
+    // returns false if the queue is full
+    auto push(T value) -> bool {
+        auto position = tail.load(std::memory_order_relaxed);
+
+        while (true) {
+            auto &cell = cells[position & mask];
+            const auto sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+            if (difference == 0) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // consumer thread only, returns false if there is nothing to take
+    auto pop(T &value) -> bool {
+        auto &cell = cells[head & mask];
+
+        if (cell.sequence.load(std::memory_order_acquire) != head + 1) {
+            return false;
+        }
+
+        value = std::exchange(cell.value, T{});
+        cell.sequence.store(head + capacity, std::memory_order_release);
+        ++head;
+        return true;
+    }
+
+private:
+    static constexpr size_t mask = capacity - 1;
+    static constexpr size_t cacheLine = 64;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value{};
+    };
+
+    std::array<Cell, capacity> cells;
+    alignas(cacheLine) std::atomic<size_t> tail{0};
+    alignas(cacheLine) size_t head = 0;
+};
+
+#endif
@@ -18,6 +18,7 @@
 
 #include "NPC.hpp"
 
+#include "ObjectPool.hpp"
 #include "World.hpp"
 #include "db/ConnectionManager.hpp"
 #include "map/Field.hpp"
@@ -57,10 +58,34 @@ NPC::NPC(TYPE_OF_CHARACTER_ID id, const std::string &name, TYPE_OF_RACE_ID race,
     setAttribute(Character::hitpoints, MAXHPS);
 }
 
+namespace {
+auto npcPool() -> ObjectPool & {
+    static ObjectPool pool("NPCs", sizeof(NPC));
+    return pool;
+}
+} // namespace
+
+auto NPC::operator new(size_t size) -> void * {
+    if (size != sizeof(NPC)) {
+        return ::operator new(size);
+    }
+
+    return npcPool().allocate();
+}
+
+void NPC::operator delete(void *pointer, size_t size) noexcept {
+    if (size != sizeof(NPC)) {
+        ::operator delete(pointer);
+        return;
+    }
+
+    npcPool().deallocate(pointer);
+}
+
 NPC::~NPC() = default;
 
 void NPC::receiveText(talk_type tt, const std::string &message, Character *cc) {
-    if (_script && cc != this && _script->existsEntrypoint("receiveText")) {
+    if (_script && cc != this && _script->existsEntrypoint("receiveText") && _script->hearsText(message)) {
         // since we have a script, we tell it we got a message
         _script->receiveText(tt, message, cc);
     }
@@ -64,6 +64,10 @@ public:
     // testing constructor
     NPC() = default;
 
+    // NPCs are allocated from an ObjectPool, classes derived from NPC use the global heap
+    static auto operator new(size_t size) -> void *;
+    static void operator delete(void *pointer, size_t size) noexcept;
+
     ~NPC() override;
     NPC(const NPC &) = delete;
     auto operator=(const NPC &) -> NPC & = delete;
@@ -22,43 +22,133 @@
 #include "map/Field.hpp"
 
 #include <algorithm>
+#include <array>
+#include <climits>
+#include <functional>
 #include <iostream>
+#include <utility>
 
 void NewClientView::fillStripe(position pos, stripedirection dir, Coordinate length) {
+    const auto key = stripeKey(pos, dir, length);
+
+    if (const auto cached = cachedStripes.find(key); cached != cachedStripes.end() && isCurrent(cached->second)) {
+        viewPosition = pos;
+        stripedir = dir;
+        maxtiles = length;
+        exists = true;
+        currentStripe = &cached->second;
+        return;
+    }
+
     clearStripe();
+
+    if (cachedStripes.size() >= maxCachedStripes) {
+        cachedStripes.clear();
+    }
+
+    auto &stripe = cachedStripes[key];
+    buildStripe(std::as_const(*World::get()), pos, dir, length, stripe);
     viewPosition = pos;
     stripedir = dir;
-    readFields(length);
+    maxtiles = length;
+    exists = true;
+    currentStripe = &stripe;
+}
+
+auto NewClientView::getStripe() const -> const Stripe & {
+    static const Stripe noStripe;
+    return currentStripe != nullptr ? *currentStripe : noStripe;
 }
 
 void NewClientView::clearStripe() {
-    std::fill(std::begin(mapStripe), std::end(mapStripe), nullptr);
     exists = false;
     viewPosition.x = 0;
     viewPosition.y = 0;
     viewPosition.z = 0;
     maxtiles = 0;
+    currentStripe = nullptr;
 }
 
-void NewClientView::readFields(Coordinate length) {
-    position pos = viewPosition;
-    Coordinate x_inc = (stripedir == dir_right) ? 1 : -1;
-    maxtiles = length;
-    exists = true;
+auto NewClientView::stripeKey(const position &pos, stripedirection dir, Coordinate length) -> uint64_t {
+    constexpr auto xShift = 48;
+    constexpr auto yShift = 32;
+    constexpr auto zShift = 16;
+    constexpr auto dirShift = 8;
+    return (static_cast<uint64_t>(static_cast<uint16_t>(pos.x)) << xShift) |
+           (static_cast<uint64_t>(static_cast<uint16_t>(pos.y)) << yShift) |
+           (static_cast<uint64_t>(static_cast<uint16_t>(pos.z)) << zShift) |
+           (static_cast<uint64_t>(dir) << dirShift) | static_cast<uint8_t>(length);
+}
+
+auto NewClientView::isCurrent(const Stripe &stripe) -> bool {
+    const auto &versions = map::ChunkVersions::get();
+    return std::all_of(stripe.chunks.begin(), stripe.chunks.end(),
+                       [&versions](const auto &chunk) { return versions.of(chunk.first) == chunk.second; });
+}
+
+void NewClientView::buildStripe(const World &world, const position &pos, stripedirection dir,
+                                Coordinate length, Stripe &stripe) {
+    const auto &versions = map::ChunkVersions::get();
+    length = std::clamp<Coordinate>(length, 0, mapStripeLength);
+    stripe.start = pos;
+    stripe.dir = dir;
+    stripe.length = length;
+    stripe.key = stripeKey(pos, dir, length);
+    stripe.fingerprint = stripe.key;
+    stripe.chunks.clear();
+    stripe.payload.clear();
+
+    auto addUnsignedChar = [&stripe](unsigned char data) { stripe.payload.push_back(static_cast<char>(data)); };
+    auto addShortInt = [&addUnsignedChar](short int data) {
+        addUnsignedChar(data >> CHAR_BIT);
+        addUnsignedChar(data & UCHAR_MAX);
+    };
+
+    addUnsignedChar(static_cast<uint8_t>(length));
+
+    position fieldPos = pos;
+    const Coordinate x_inc = (dir == dir_right) ? 1 : -1;
+    std::array<const map::Field *, mapStripeLength> fields{};
+    world.fieldsAlong(pos, x_inc, length, fields.data());
 
     for (Coordinate i = 0; i < length; ++i) {
-        try {
-            map::Field &field = World::get()->fieldAt(pos);
+        const auto chunk = map::ChunkVersions::chunkKey(fieldPos);
+
+        if (stripe.chunks.empty() || stripe.chunks.back().first != chunk) {
+            const auto version = versions.of(chunk);
+            stripe.chunks.emplace_back(chunk, version);
+            // boost::hash_combine
+            stripe.fingerprint ^= std::hash<uint64_t>{}(chunk ^ (version << 1U)) + 0x9e3779b97f4a7c15ULL +
+                                  (stripe.fingerprint << 6U) + (stripe.fingerprint >> 2U);
+        }
+
+        const map::Field *field = fields[i];
+
+        if (field != nullptr && (!field->isTransparent() || field->itemCount() > 0)) {
+            addShortInt(field->getTileCode());
+            addUnsignedChar(field->getMovementCost());
+            addShortInt(field->getMusicId());
+            addUnsignedChar(static_cast<unsigned char>(field->itemCount()));
+
+            for (const auto &item : field->getItemStack()) {
+                addShortInt(item.getId());
 
-            if (!field.isTransparent() || field.itemCount() > 0) {
-                mapStripe[i] = &field;
+                if (item.isContainer()) {
+                    addShortInt(1);
+                } else {
+                    addShortInt(item.getNumber());
+                }
             }
-        } catch (FieldNotFound &) {
+        } else {
+            addShortInt(-1);
+            addUnsignedChar(0);
+            addShortInt(0);
+            addUnsignedChar(0);
         }
 
         // increase x due to perspective
-        pos.x += x_inc;
+        fieldPos.x += x_inc;
         // increase y due to perspective
-        ++pos.y;
+        ++fieldPos.y;
     }
 }
@@ -20,15 +20,18 @@
 #define NEWCLIENTVIEW_HPP_
 
 #include "globals.hpp"
+#include "map/ChunkVersions.hpp"
 #include "types.hpp"
 
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 constexpr Coordinate MAP_DIMENSION = 17; // map extends into all 4 directions for this number of tiles
 constexpr Coordinate MAP_DOWN_EXTRA = 3; // extra downwards extension
 
 // forward declarations
-namespace map {
-class Field;
-}
+class World;
 
 /**
  * class which holds isometric view specific data
@@ -41,15 +44,33 @@ public:
     enum stripedirection { dir_right, dir_down };
 
     static constexpr Coordinate mapStripeLength = 100;
+
     /**
-     * defines one mapstripe
+     * one encoded stripe, owned by whoever builds it
      */
-    using MAPSTRIPE = std::array<map::Field *, mapStripeLength>;
+    struct Stripe {
+        position start{};
+        stripedirection dir{dir_right};
+        Coordinate length{0};
+        // identifies the stripe by starting position, direction and length
+        uint64_t key = 0;
+        // changes whenever a field covered by the stripe changes
+        uint64_t fingerprint = 0;
+        std::vector<std::pair<map::ChunkVersions::ChunkKey, map::ChunkVersions::Version>> chunks;
+        std::vector<char> payload;
+    };
 
     /**
-     * stores the pointers to the fields inside a specific mapstripe
+     * encodes a stripe from the fields of world into stripe, touching no other state so that stripes can be built on
+     * several threads at once as long as world does not change meanwhile
+     * @param world the world the fields are read from
+     * @param pos the starting position of the stripe
+     * @param dir the direction in which the stripe looks
+     * @param length number of tiles to be read, at most mapStripeLength
+     * @param stripe receives the encoded stripe, its buffers are reused
      */
-    MAPSTRIPE mapStripe{nullptr};
+    static void buildStripe(const World &world, const position &pos, stripedirection dir,
+                            Coordinate length, Stripe &stripe);
 
     /**
      * returns the initial position of this stripe
@@ -76,11 +97,17 @@ public:
     [[nodiscard]] auto getStripeDirection() const -> stripedirection { return stripedir; }
 
     /**
-     * fills the stripe with the specific isometric data
+     * the current stripe as sent to clients
+     * @return the current stripe, empty if there is none
+     */
+    [[nodiscard]] auto getStripe() const -> const Stripe &;
+
+    /**
+     * fills the stripe with the specific isometric data, reusing the encoding of an earlier identical stripe if no
+     * field it covers has changed since
      * @param pos the starting position of the stripe
      * @param dir the direction in which the stipe looks
      * @param length number of tiles to be read
-     * @param maps the maps from which we want to calculate the stripes
      */
     void fillStripe(position pos, stripedirection dir, Coordinate length);
 
@@ -90,12 +117,20 @@ public:
     void clearStripe();
 
 private:
+    static constexpr size_t maxCachedStripes = 4096;
+
     /**
-     * reads all fields for the current stripe on a specific map from startingpos towards direction stripedir
-     * @param length number of tiles to be read
-     * @param maps the map vector from which we want to read the fields
+     * encoded stripes by starting position, direction and length
+     */
+    std::unordered_map<uint64_t, Stripe> cachedStripes;
+
+    /**
+     * the cache entry holding the current stripe
      */
-    void readFields(Coordinate length);
+    const Stripe *currentStripe = nullptr;
+
+    [[nodiscard]] static auto stripeKey(const position &pos, stripedirection dir, Coordinate length) -> uint64_t;
+    [[nodiscard]] static auto isCurrent(const Stripe &stripe) -> bool;
 
     /**
      * the starting position of the current view
@@ -0,0 +1,88 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ObjectPool.hpp"
+
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <new>
+
+ObjectPool::ObjectPool(std::string name, size_t slotSize, size_t slotsPerSlab)
+        : name(std::move(name)),
+          slotSize(std::max((slotSize + alignof(std::max_align_t) - 1) / alignof(std::max_align_t), size_t{1}) *
+                   alignof(std::max_align_t)),
+          slotsPerSlab(std::max(slotsPerSlab, size_t{1})) {
+    stats.slotSize = this->slotSize;
+    pools().push_back(this);
+}
+
+ObjectPool::~ObjectPool() {
+    auto &all = pools();
+    all.erase(std::remove(all.begin(), all.end(), this), all.end());
+}
+
+auto ObjectPool::allocate() -> void * {
+    void *slot = nullptr;
+
+    if (freeSlots != nullptr) {
+        slot = freeSlots;
+        freeSlots = freeSlots->next;
+        ++stats.reuses;
+    } else {
+        if (untouched == 0) {
+            // new[] of bytes is aligned for any fundamental type, slot sizes are multiples of that alignment
+            slabs.push_back(std::make_unique<std::byte[]>(slotSize * slotsPerSlab));
+            untouched = slotsPerSlab;
+            stats.slabs = slabs.size();
+        }
+
+        slot = slabs.back().get() + slotSize * (slotsPerSlab - untouched);
+        --untouched;
+    }
+
+    ++stats.allocations;
+    ++stats.inUse;
+    stats.peak = std::max(stats.peak, stats.inUse);
+    return slot;
+}
+
+void ObjectPool::deallocate(void *slot) noexcept {
+    if (slot == nullptr) {
+        return;
+    }
+
+    freeSlots = new (slot) FreeSlot{freeSlots};
+    --stats.inUse;
+}
+
+void ObjectPool::logStats() {
+    for (const auto *pool : pools()) {
+        const auto &current = pool->stats;
+        Logger::info(LogFacility::Other) << "object pool " << pool->name << ": " << current.inUse << " in use, "
+                                         << current.peak << " peak, " << current.slabs << " slabs of "
+                                         << pool->slotsPerSlab << " x " << current.slotSize << " bytes, "
+                                         << current.allocations << " allocations, " << current.reuses << " reuses"
+                                         << Log::end;
+    }
+}
+
+auto ObjectPool::pools() -> std::vector<ObjectPool *> & {
+    static std::vector<ObjectPool *> all;
+    return all;
+}
@@ -0,0 +1,75 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef OBJECT_POOL_HPP
+#define OBJECT_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Memory for objects of one size, carved from slabs that are kept for reuse so characters coming and going all the
+// time neither churn the allocator nor fragment the heap of a long running server. Game thread only.
+class ObjectPool {
+public:
+    struct Stats {
+        size_t slotSize = 0;
+        size_t slabs = 0;
+        size_t inUse = 0;
+        size_t peak = 0;
+        uint64_t allocations = 0;
+        // allocations served by a slot released before
+        uint64_t reuses = 0;
+    };
+
+    ObjectPool(std::string name, size_t slotSize, size_t slotsPerSlab = defaultSlotsPerSlab);
+    ObjectPool(const ObjectPool &) = delete;
+    auto operator=(const ObjectPool &) -> ObjectPool & = delete;
+    ObjectPool(ObjectPool &&) = delete;
+    auto operator=(ObjectPool &&) -> ObjectPool & = delete;
+    ~ObjectPool();
+
+    auto allocate() -> void *;
+    void deallocate(void *slot) noexcept;
+
+    [[nodiscard]] auto getName() const -> const std::string & { return name; }
+    [[nodiscard]] auto getStats() const -> const Stats & { return stats; }
+    static void logStats();
+
+private:
+    static constexpr size_t defaultSlotsPerSlab = 64;
+
+    struct FreeSlot {
+        FreeSlot *next;
+    };
+
+    std::string name;
+    size_t slotSize;
+    size_t slotsPerSlab;
+    std::vector<std::unique_ptr<std::byte[]>> slabs;
+    FreeSlot *freeSlots = nullptr;
+    // slots of the newest slab never handed out yet
+    size_t untouched = 0;
+    Stats stats;
+
+    static auto pools() -> std::vector<ObjectPool *> &;
+};
+
+#endif
@@ -0,0 +1,59 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// calls task(i) for every i < count, spread over all available cores with at least minPerWorker calls per worker;
+// task must be safe to call concurrently for distinct indices
+template <typename Task> void runInParallel(size_t count, const Task &task, size_t minPerWorker = 1) {
+    const size_t cores = std::max(1U, std::thread::hardware_concurrency());
+    const size_t workerCount = std::min(cores, count / std::max<size_t>(minPerWorker, 1));
+
+    if (workerCount <= 1) {
+        for (size_t index = 0; index < count; ++index) {
+            task(index);
+        }
+
+        return;
+    }
+
+    std::atomic<size_t> next = 0;
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount);
+
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back([&next, count, &task] {
+            for (auto index = next++; index < count; index = next++) {
+                task(index);
+            }
+        });
+    }
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+#endif
@@ -25,17 +25,16 @@
 #include "PlayerManager.hpp"
 #include "Random.hpp"
 #include "Showcase.hpp"
+#include "TickClock.hpp"
 #include "World.hpp"
 #include "data/ContainerObjectTable.hpp"
 #include "data/Data.hpp"
 #include "db/Connection.hpp"
 #include "db/ConnectionManager.hpp"
-#include "db/DeleteQuery.hpp"
-#include "db/InsertQuery.hpp"
+#include "db/PreparedQuery.hpp"
 #include "db/Result.hpp"
 #include "db/SchemaHelper.hpp"
 #include "db/SelectQuery.hpp"
-#include "db/UpdateQuery.hpp"
 #include "dialog/CraftingDialog.hpp"
 #include "dialog/InputDialog.hpp"
 #include "dialog/MerchantDialog.hpp"
@@ -50,6 +49,7 @@
 #include "script/server.hpp"
 #include "tuningConstants.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <range/v3/all.hpp>
 #include <sstream>
@@ -200,6 +200,20 @@ void Player::login() {
     Connection->activate(this);
 }
 
+void Player::resume(std::shared_ptr<NetInterface> newConnection) {
+    Connection = std::move(newConnection);
+    last_ip = Connection->getIPAdress();
+
+    // the time until the disconnect was saved on suspension, the grace period does not count
+    onlinetime += lastsavetime - logintime;
+    time(&logintime);
+    time(&lastsavetime);
+    time(&lastaction);
+    time(&lastkeepalive);
+
+    Connection->activate(this);
+}
+
 auto Player::getScreenRange() const -> Coordinate {
     return (screenwidth > screenheight) ? 2 * screenwidth : 2 * screenheight;
 }
@@ -249,7 +263,7 @@ void Player::openShowcase(Container *container, const ScriptItem &item, bool car
             showcaseId = showcaseCounter;
         }
 
-        showcases[showcaseId] = std::make_unique<Showcase>(container, carry);
+        showcases[showcaseId] = std::make_unique<Showcase>(this, container, carry);
         const auto lookAt = item.getLookAt(this);
         ServerCommandPointer cmd = std::make_shared<UpdateShowcaseTC>(showcaseId, lookAt, container->getSlotCount(),
                                                                       container->getItems());
@@ -286,6 +300,28 @@ void Player::updateShowcaseSlot(Container *container, TYPE_OF_CONTAINERSLOTS slo
     }
 }
 
+auto Player::mayRunLookAtScript() -> bool {
+    const auto limit = Config::instance().look_at_scripts_per_second();
+
+    if (limit == 0) {
+        return true;
+    }
+
+    const auto now = TickClock::now();
+
+    if (now - lookAtSecond >= std::chrono::seconds(1)) {
+        lookAtSecond = now;
+        lookAtScriptsThisSecond = 0;
+    }
+
+    if (lookAtScriptsThisSecond >= limit) {
+        return false;
+    }
+
+    ++lookAtScriptsThisSecond;
+    return true;
+}
+
 auto Player::isShowcaseOpen(uint8_t showcase) const -> bool { return showcases.find(showcase) != showcases.cend(); }
 
 auto Player::isShowcaseOpen(Container *container) const -> bool {
@@ -411,10 +447,10 @@ auto Player::lookIntoContainerOnField(direction dir) -> bool {
 
         if (field.viewItemOnStack(item)) {
             if (item.getId() != DEPOTITEM && item.isContainer()) {
-                auto it = field.containers.find(item.getNumber());
+                auto *container = field.getContainer(item.getNumber());
 
-                if (it != field.containers.end()) {
-                    openShowcase(it->second, static_cast<ScriptItem>(item), false);
+                if (container != nullptr) {
+                    openShowcase(container, static_cast<ScriptItem>(item), false);
                     return true;
                 }
             } else {
@@ -445,6 +481,11 @@ auto Player::lookIntoContainerOnField(direction dir) -> bool {
 void Player::sendCharacters() { _world->sendAllVisibleCharactersToPlayer(this, true); }
 
 void Player::sendCharacterItemAtPos(unsigned char cpos) {
+    if (itemBatchDepth > 0 && cpos < batchedSlots.size()) {
+        batchedSlots.set(cpos);
+        return;
+    }
+
     if (cpos < (MAX_BELT_SLOTS + MAX_BODY_ITEMS)) {
         // gltiger Wert
         ServerCommandPointer cmd =
@@ -458,37 +499,19 @@ void Player::sendWeather(WeatherStruct weather) {
     Connection->addCommand(cmd);
 }
 
-void Player::ageInventory() {
-    for (unsigned char i = 0; i < MAX_BELT_SLOTS + MAX_BODY_ITEMS; ++i) {
-        if (items.at(i).getId() != 0) {
-            const auto &itemStruct = Data::items()[items.at(i).getId()];
-
-            if (itemStruct.rotsInInventory) {
-                if (!items.at(i).survivesAgeing()) {
-                    if (items.at(i).getId() != itemStruct.ObjectAfterRot) {
-                        items.at(i).setId(itemStruct.ObjectAfterRot);
-
-                        const auto &afterRotItemStruct = Data::items()[itemStruct.ObjectAfterRot];
-
-                        if (afterRotItemStruct.isValid()) {
-                            items.at(i).setWear(afterRotItemStruct.AgeingSpeed);
-                        }
-
-                        sendCharacterItemAtPos(i);
-                    } else {
-                        items.at(i).reset();
-                        sendCharacterItemAtPos(i);
-                    }
-
-                    // The personal light might have changed!
-                    updateAppearanceForAll(true);
-                }
-            }
+void Player::inventoryAged(const InventoryAgeing &ageing) {
+    for (unsigned char i = 0; i < ageing.slots.size(); ++i) {
+        if (ageing.slots.test(i)) {
+            sendCharacterItemAtPos(i);
         }
     }
 
+    if (ageing.slots.any()) {
+        // The personal light might have changed!
+        updateAppearanceForAll(true);
+    }
+
     if ((items.at(BACKPACK).getId() != 0) && (backPackContents != nullptr)) {
-        backPackContents->doAge(true);
         updateBackPackView();
     }
 
@@ -496,11 +519,14 @@ void Player::ageInventory() {
         const auto &depot = depotMapEntry.second;
 
         if (depot != nullptr) {
-            depot->doAge(true);
             updateShowcase(depot);
         }
     }
 
+    if (!unloadedDepots.empty()) {
+        ++inventoryAgeings;
+    }
+
     checkBurden();
 }
 
@@ -631,16 +657,42 @@ auto Player::swapAtPos(unsigned char pos, TYPE_OF_ITEM_ID newid, int newQuality)
 }
 
 void Player::updateBackPackView() {
-    if (backPackContents != nullptr) {
+    if (itemBatchDepth > 0) {
+        batchedBackPack = true;
+    } else if (backPackContents != nullptr) {
         updateShowcase(backPackContents);
     }
 }
 
+void Player::beginItemBatch() { ++itemBatchDepth; }
+
+void Player::endItemBatch() {
+    if (itemBatchDepth == 0 || --itemBatchDepth > 0) {
+        return;
+    }
+
+    for (unsigned char pos = 0; pos < batchedSlots.size(); ++pos) {
+        if (batchedSlots.test(pos)) {
+            sendCharacterItemAtPos(pos);
+        }
+    }
+
+    batchedSlots.reset();
+
+    if (std::exchange(batchedBackPack, false)) {
+        updateBackPackView();
+    }
+
+    if (std::exchange(batchedBurden, false)) {
+        checkBurden();
+    }
+}
+
 void Player::sendSkill(TYPE_OF_SKILL_ID skill, int major, int minor) {
     ServerCommandPointer cmd = std::make_shared<UpdateSkillTC>(skill, major, minor);
     Connection->addCommand(cmd);
     cmd = std::make_shared<BBSendSkillTC>(getId(), skill, major, minor);
-    _world->monitoringClientList->sendCommand(cmd);
+    _world->monitoringClientList->sendState(MonitoringClients::stateKey(getId(), BB_SENDSKILL_TC, skill), cmd);
 }
 
 void Player::sendAllSkills() {
@@ -660,19 +712,11 @@ void Player::sendMagicFlags(int type) {
 
 auto Player::saveBaseAttributes() -> bool {
     if (getBaseAttributeSum() != getMaxAttributePoints()) {
-        Database::SelectQuery query;
-        query.addColumn("player", "ply_strength");
-        query.addColumn("player", "ply_dexterity");
-        query.addColumn("player", "ply_constitution");
-        query.addColumn("player", "ply_agility");
-        query.addColumn("player", "ply_intelligence");
-        query.addColumn("player", "ply_perception");
-        query.addColumn("player", "ply_willpower");
-        query.addColumn("player", "ply_essence");
-        query.addEqualCondition<TYPE_OF_CHARACTER_ID>("player", "ply_playerid", getId());
-        query.addServerTable("player");
-
-        auto result = query.execute();
+        static const Database::PreparedQuery query(
+                "load_base_attributes",
+                "SELECT ply_strength, ply_dexterity, ply_constitution, ply_agility, ply_intelligence, "
+                "ply_perception, ply_willpower, ply_essence FROM {server}.player WHERE ply_playerid = $1");
+        auto result = query.execute(Database::ConnectionManager::getInstance().getConnection(), getId());
 
         if (result.empty()) {
             throw LogoutException(NOCHARACTERFOUND);
@@ -692,18 +736,16 @@ auto Player::saveBaseAttributes() -> bool {
         return false;
     }
 
-    Database::UpdateQuery query;
-    query.addAssignColumn<uint16_t>("ply_agility", getBaseAttribute(Character::agility));
-    query.addAssignColumn<uint16_t>("ply_constitution", getBaseAttribute(Character::constitution));
-    query.addAssignColumn<uint16_t>("ply_dexterity", getBaseAttribute(Character::dexterity));
-    query.addAssignColumn<uint16_t>("ply_essence", getBaseAttribute(Character::essence));
-    query.addAssignColumn<uint16_t>("ply_intelligence", getBaseAttribute(Character::intelligence));
-    query.addAssignColumn<uint16_t>("ply_perception", getBaseAttribute(Character::perception));
-    query.addAssignColumn<uint16_t>("ply_strength", getBaseAttribute(Character::strength));
-    query.addAssignColumn<uint16_t>("ply_willpower", getBaseAttribute(Character::willpower));
-    query.addEqualCondition<TYPE_OF_CHARACTER_ID>("player", "ply_playerid", getId());
-    query.addServerTable("player");
-    query.execute();
+    static const Database::PreparedQuery query(
+            "save_base_attributes",
+            "UPDATE {server}.player SET ply_agility = $1, ply_constitution = $2, ply_dexterity = $3, ply_essence = $4, "
+            "ply_intelligence = $5, ply_perception = $6, ply_strength = $7, ply_willpower = $8 "
+            "WHERE ply_playerid = $9");
+    query.execute(Database::ConnectionManager::getInstance().getConnection(), getBaseAttribute(Character::agility),
+                  getBaseAttribute(Character::constitution), getBaseAttribute(Character::dexterity),
+                  getBaseAttribute(Character::essence), getBaseAttribute(Character::intelligence),
+                  getBaseAttribute(Character::perception), getBaseAttribute(Character::strength),
+                  getBaseAttribute(Character::willpower), getId());
 
     return true;
 }
@@ -717,18 +759,28 @@ void Player::sendAttrib(Character::attributeIndex attribute) {
     }
 
     ServerCommandPointer cmd = std::make_shared<BBSendAttribTC>(getId(), attributeStringMap[attribute], value);
-    _world->monitoringClientList->sendCommand(cmd);
+    _world->monitoringClientList->sendState(MonitoringClients::stateKey(getId(), BB_SENDATTRIB_TC, attribute), cmd);
 }
 
 void Player::handleAttributeChange(Character::attributeIndex attribute) {
     Character::handleAttributeChange(attribute);
-    sendAttrib(attribute);
+    markAttributeChanged(attribute);
 
     if (attribute == Character::strength) {
         checkBurden();
     }
 }
 
+void Player::sendAttributeUpdates(uint32_t changed) {
+    Character::sendAttributeUpdates(changed);
+
+    for (int attribute = 0; attribute < ATTRIBUTECOUNT; ++attribute) {
+        if ((changed & (1U << attribute)) != 0) {
+            sendAttrib(static_cast<attributeIndex>(attribute));
+        }
+    }
+}
+
 void Player::startMusic(short int title) {
     ServerCommandPointer cmd = std::make_shared<MusicTC>(title);
     Connection->addCommand(cmd);
@@ -1010,6 +1062,52 @@ void Player::check_logindata() {
     }
 }
 
+namespace {
+// depot items and everything in their containers, for the depots matching the condition
+auto depotLinesOf(const std::string &depotCondition) -> std::string {
+    return "WITH RECURSIVE depot_lines (line, depot) AS (SELECT pit_linenumber, pit_depot FROM {server}.playeritems "
+           "WHERE pit_playerid = $1 AND " +
+           depotCondition +
+           " UNION ALL SELECT items.pit_linenumber, depot_lines.depot FROM {server}.playeritems items "
+           "JOIN depot_lines ON items.pit_in_container = depot_lines.line WHERE items.pit_playerid = $1) ";
+}
+
+const std::string itemColumns = "SELECT pit_linenumber, pit_in_container, pit_depot, pit_itemid, pit_wear, pit_number, "
+                                "pit_quality, pit_containerslot ";
+
+struct StoredItem {
+    uint16_t line;
+    uint16_t container;
+    uint32_t depot;
+    Item item;
+    TYPE_OF_CONTAINERSLOTS slot;
+};
+
+// both results ordered by line number
+auto storedItemsOf(const Database::Result &itemRows, const Database::Result &dataRows) -> std::vector<StoredItem> {
+    std::vector<StoredItem> stored;
+    stored.reserve(itemRows.size());
+    auto dataRow = dataRows.begin();
+
+    for (const auto &row : itemRows) {
+        const auto line = row["pit_linenumber"].as<uint16_t>();
+        Item item(row["pit_itemid"].as<Item::id_type>(), row["pit_number"].as<Item::number_type>(),
+                  (Item::wear_type)(row["pit_wear"].as<uint16_t>()), row["pit_quality"].as<Item::quality_type>());
+
+        for (; dataRow != dataRows.end() && (*dataRow)["idv_linenumber"].as<uint16_t>() <= line; ++dataRow) {
+            if ((*dataRow)["idv_linenumber"].as<uint16_t>() == line) {
+                item.setData((*dataRow)["idv_key"].as<std::string>(), (*dataRow)["idv_value"].as<std::string>());
+            }
+        }
+
+        stored.push_back({line, row["pit_in_container"].as<uint16_t>(), row["pit_depot"].as<uint32_t>(), item,
+                          row["pit_containerslot"].as<TYPE_OF_CONTAINERSLOTS>()});
+    }
+
+    return stored;
+}
+} // namespace
+
 struct container_struct {
     Container *container;
     unsigned int id;
@@ -1019,284 +1117,138 @@ struct container_struct {
             : container(cc), id(aboveid), depotid(depot) {}
 };
 
-auto Player::save() noexcept -> bool {
-    using namespace Database;
+auto Player::snapshot() -> PlayerSnapshot {
+    PlayerSnapshot snapshot;
+    snapshot.id = getId();
+    snapshot.description = to_string();
+    snapshot.knownPlayers = knownPlayers;
+    snapshot.namedPlayers = namedPlayers;
 
-    Logger::info(LogFacility::Player) << "Saving " << to_string() << Log::end;
+    time(&lastsavetime);
+    snapshot.status = status;
+    snapshot.lastIp = last_ip;
+    snapshot.onlineTime = onlinetime + lastsavetime - logintime;
+    snapshot.saveTime = lastsavetime;
+    snapshot.statusTime = statustime;
+    snapshot.statusGm = statusgm;
+    snapshot.statusReason = statusreason;
+
+    auto &player = snapshot.player;
+    player.x = getPosition().x;
+    player.y = getPosition().y;
+    player.z = getPosition().z;
+    player.faceTo = (uint16_t)getFaceTo();
+    player.hitpoints = getAttribute(Character::hitpoints);
+    player.mana = getAttribute(Character::mana);
+    player.foodlevel = getAttribute(Character::foodlevel);
+    player.lifestate = isAlive() ? 1 : 0;
+    player.magicType = (uint32_t)getMagicType();
+    player.magicFlags = {getMagicFlags(MAGE), getMagicFlags(PRIEST), getMagicFlags(BARD), getMagicFlags(DRUID)};
+    player.poison = poisonvalue;
+    player.mentalCapacity = mental_capacity;
+    player.hair = _appearance.hairtype;
+    player.beard = _appearance.beardtype;
+    player.hairColour = {_appearance.hair.red, _appearance.hair.green, _appearance.hair.blue, _appearance.hair.alpha};
+    player.skinColour = {_appearance.skin.red, _appearance.skin.green, _appearance.skin.blue, _appearance.skin.alpha};
 
-    PConnection connection = ConnectionManager::getInstance().getConnection();
+    for (const auto &skill : skills) {
+        snapshot.skills.emplace(skill.first, std::pair<uint16_t, uint16_t>(skill.second.major, skill.second.minor));
+    }
 
-    try {
-        connection->beginTransaction();
+    const auto itemRow = [](const Item &item, int16_t container, int32_t depot, TYPE_OF_CONTAINERSLOTS slot) {
+        return PlayerSnapshot::ItemRow{container, depot, item.getId(), item.getWear(), item.getNumber(),
+                                       item.getQuality(), slot, {}};
+    };
 
-        {
-            DeleteQuery introductionQuery(connection);
-            introductionQuery.addEqualCondition<TYPE_OF_CHARACTER_ID>("introduction", "intro_player", getId());
-            introductionQuery.addServerTable("introduction");
-            introductionQuery.execute();
-        }
+    int linenumber = 0;
 
-        {
-            InsertQuery introductionQuery(connection);
-            const InsertQuery::columnIndex playerColumn = introductionQuery.addColumn("intro_player");
-            const InsertQuery::columnIndex knownPlayerColumn = introductionQuery.addColumn("intro_known_player");
-            introductionQuery.addServerTable("introduction");
-
-            for (const auto player : knownPlayers) {
-                introductionQuery.addValue<TYPE_OF_CHARACTER_ID>(playerColumn, getId());
-                introductionQuery.addValue<TYPE_OF_CHARACTER_ID>(knownPlayerColumn, player);
-            }
+    // items directly on the body, empty slots still take a line
+    for (int thisItemSlot = 0; thisItemSlot < MAX_BODY_ITEMS + MAX_BELT_SLOTS; ++thisItemSlot) {
+        ++linenumber;
+        const auto &item = items.at(thisItemSlot);
 
-            introductionQuery.execute();
+        if (item.getId() == 0) {
+            continue;
         }
 
-        {
-            DeleteQuery namingQuery(connection);
-            namingQuery.addEqualCondition<TYPE_OF_CHARACTER_ID>("naming", "name_player", getId());
-            namingQuery.addServerTable("naming");
-            namingQuery.execute();
-        }
+        auto row = itemRow(item, 0, 0, 0);
 
-        {
-            InsertQuery namingQuery(connection);
-            const InsertQuery::columnIndex playerColumn = namingQuery.addColumn("name_player");
-            const InsertQuery::columnIndex namedPlayerColumn = namingQuery.addColumn("name_named_player");
-            const InsertQuery::columnIndex playerNameColumn = namingQuery.addColumn("name_player_name");
-            namingQuery.addServerTable("naming");
-
-            for (const auto &playerAndName : namedPlayers) {
-                namingQuery.addValue<TYPE_OF_CHARACTER_ID>(playerColumn, getId());
-                namingQuery.addValue<TYPE_OF_CHARACTER_ID>(namedPlayerColumn, playerAndName.first);
-                namingQuery.addValue<std::string>(playerNameColumn, playerAndName.second);
+        for (auto it = item.getDataBegin(); it != item.getDataEnd(); ++it) {
+            if (it->second.length() > 0) {
+                row.data.insert(*it);
             }
-
-            namingQuery.execute();
         }
 
-        time(&lastsavetime);
-        {
-            UpdateQuery query(connection);
-            query.addAssignColumn<uint16_t>("chr_status", (uint16_t)status);
-            query.addAssignColumn<std::string>("chr_lastip", last_ip);
-            query.addAssignColumn<uint32_t>("chr_onlinetime", onlinetime + lastsavetime - logintime);
-            query.addAssignColumn<time_t>("chr_lastsavetime", lastsavetime);
-
-            if (status != 0) {
-                query.addAssignColumn<time_t>("chr_statustime", statustime);
-                query.addAssignColumn<TYPE_OF_CHARACTER_ID>("chr_statusgm", statusgm);
-                query.addAssignColumn<std::string>("chr_statusreason", statusreason);
-            } else {
-                query.addAssignColumnNull("chr_statustime");
-                query.addAssignColumnNull("chr_statusgm");
-                query.addAssignColumnNull("chr_statusreason");
-            }
+        snapshot.items.emplace(linenumber, std::move(row));
+    }
 
-            query.addEqualCondition<TYPE_OF_CHARACTER_ID>("chars", "chr_playerid", getId());
-            query.setServerTable("chars");
+    std::list<container_struct> containers;
 
-            query.execute();
-        }
+    if (items.at(BACKPACK).getId() != 0 && (backPackContents != nullptr)) {
+        containers.emplace_back(backPackContents, BACKPACK + 1);
+    }
 
-        {
-            UpdateQuery query(connection);
-            query.addAssignColumn<int32_t>("ply_posx", getPosition().x);
-            query.addAssignColumn<int32_t>("ply_posy", getPosition().y);
-            query.addAssignColumn<int32_t>("ply_posz", getPosition().z);
-            query.addAssignColumn<uint16_t>("ply_faceto", (uint16_t)getFaceTo());
-            query.addAssignColumn<uint16_t>("ply_hitpoints", getAttribute(Character::hitpoints));
-            query.addAssignColumn<uint16_t>("ply_mana", getAttribute(Character::mana));
-            query.addAssignColumn<uint32_t>("ply_foodlevel", getAttribute(Character::foodlevel));
-            query.addAssignColumn<uint32_t>("ply_lifestate", isAlive() ? 1 : 0);
-            query.addAssignColumn<uint32_t>("ply_magictype", (uint32_t)getMagicType());
-            query.addAssignColumn<uint64_t>("ply_magicflagsmage", getMagicFlags(MAGE));
-            query.addAssignColumn<uint64_t>("ply_magicflagspriest", getMagicFlags(PRIEST));
-            query.addAssignColumn<uint64_t>("ply_magicflagsbard", getMagicFlags(BARD));
-            query.addAssignColumn<uint64_t>("ply_magicflagsdruid", getMagicFlags(DRUID));
-            query.addAssignColumn<uint16_t>("ply_poison", poisonvalue);
-            query.addAssignColumn<uint32_t>("ply_mental_capacity", mental_capacity);
-            query.addAssignColumn<uint16_t>("ply_hair", _appearance.hairtype);
-            query.addAssignColumn<uint16_t>("ply_beard", _appearance.beardtype);
-            query.addAssignColumn<uint16_t>("ply_hairred", _appearance.hair.red);
-            query.addAssignColumn<uint16_t>("ply_hairgreen", _appearance.hair.green);
-            query.addAssignColumn<uint16_t>("ply_hairblue", _appearance.hair.blue);
-            query.addAssignColumn<uint16_t>("ply_hairalpha", _appearance.hair.alpha);
-            query.addAssignColumn<uint16_t>("ply_skinred", _appearance.skin.red);
-            query.addAssignColumn<uint16_t>("ply_skingreen", _appearance.skin.green);
-            query.addAssignColumn<uint16_t>("ply_skinblue", _appearance.skin.blue);
-            query.addAssignColumn<uint16_t>("ply_skinalpha", _appearance.skin.alpha);
-            query.addEqualCondition<TYPE_OF_CHARACTER_ID>("player", "ply_playerid", getId());
-            query.addServerTable("player");
-            query.execute();
-        }
+    for (const auto &[depot, lines] : unloadedDepots) {
+        snapshot.reservedLines.insert(lines.begin(), lines.end());
+    }
 
-        {
-            DeleteQuery query(connection);
-            query.addEqualCondition<TYPE_OF_CHARACTER_ID>("playerskills", "psk_playerid", getId());
-            query.setServerTable("playerskills");
-            query.execute();
-        }
-
-        if (!skills.empty()) {
-            InsertQuery query(connection);
-            const InsertQuery::columnIndex playerIdColumn = query.addColumn("psk_playerid");
-            const InsertQuery::columnIndex skillIdColumn = query.addColumn("psk_skill_id");
-            const InsertQuery::columnIndex valueColumn = query.addColumn("psk_value");
-            const InsertQuery::columnIndex minorColumn = query.addColumn("psk_minor");
-
-            // now store the skills
-            for (const auto &skill : skills) {
-                query.addValue<uint16_t>(skillIdColumn, skill.first);
-                query.addValue<uint16_t>(valueColumn, (uint16_t)skill.second.major);
-                query.addValue<uint16_t>(minorColumn, (uint16_t)skill.second.minor);
-            }
+    snapshot.releasedLines = releasedItemLines;
 
-            query.addValues<TYPE_OF_CHARACTER_ID>(playerIdColumn, getId(), InsertQuery::FILL);
-            query.addServerTable("playerskills");
-            query.execute();
-        }
+    // lines of unloaded depots are still taken in the database
+    const auto nextLine = [&snapshot](int32_t line) {
+        do {
+            ++line;
+        } while (snapshot.reservedLines.count(line) > 0);
 
-        {
-            DeleteQuery query(connection);
-            query.addEqualCondition<TYPE_OF_CHARACTER_ID>("playeritems", "pit_playerid", getId());
-            query.setServerTable("playeritems");
-            query.execute();
-        }
+        return line;
+    };
 
-        {
-            DeleteQuery query(connection);
-            query.addEqualCondition<TYPE_OF_CHARACTER_ID>("playeritem_datavalues", "idv_playerid", getId());
-            query.setServerTable("playeritem_datavalues");
-            query.execute();
-        }
+    ranges::transform(depotContents, ranges::back_inserter(containers),
+                      [](const auto &depot) { return container_struct(depot.second, 0, depot.first); });
 
-        {
-            std::list<container_struct> containers;
+    // contents of backpack and depots, with nested containers after their parents
+    while (!containers.empty()) {
+        const container_struct &currentContainerStruct = containers.front();
+        Container &currentContainer = *currentContainerStruct.container;
 
-            // add backpack to containerlist
-            if (items.at(BACKPACK).getId() != 0 && (backPackContents != nullptr)) {
-                containers.emplace_back(backPackContents, BACKPACK + 1);
-            }
+        for (const auto &slotAndItem : currentContainer.getItems()) {
+            const Item &item = slotAndItem.second;
+            auto row = itemRow(item, (int16_t)currentContainerStruct.id, (int32_t)currentContainerStruct.depotid,
+                               slotAndItem.first);
+            row.data.insert(item.getDataBegin(), item.getDataEnd());
+            linenumber = nextLine(linenumber);
+            snapshot.items.emplace(linenumber, std::move(row));
 
-            // add depot to containerlist
-            ranges::transform(depotContents, ranges::back_inserter(containers),
-                              [](const auto &depot) { return container_struct(depot.second, 0, depot.first); });
-
-            InsertQuery itemsQuery(connection);
-            const InsertQuery::columnIndex itemsPlyIdColumn = itemsQuery.addColumn("pit_playerid");
-            const InsertQuery::columnIndex itemsLineColumn = itemsQuery.addColumn("pit_linenumber");
-            const InsertQuery::columnIndex itemsContainerColumn = itemsQuery.addColumn("pit_in_container");
-            const InsertQuery::columnIndex itemsDepotColumn = itemsQuery.addColumn("pit_depot");
-            const InsertQuery::columnIndex itemsItmIdColumn = itemsQuery.addColumn("pit_itemid");
-            const InsertQuery::columnIndex itemsWearColumn = itemsQuery.addColumn("pit_wear");
-            const InsertQuery::columnIndex itemsNumberColumn = itemsQuery.addColumn("pit_number");
-            const InsertQuery::columnIndex itemsQualColumn = itemsQuery.addColumn("pit_quality");
-            const InsertQuery::columnIndex itemsSlotColumn = itemsQuery.addColumn("pit_containerslot");
-            itemsQuery.setServerTable("playeritems");
-
-            InsertQuery dataQuery(connection);
-            const InsertQuery::columnIndex dataPlyIdColumn = dataQuery.addColumn("idv_playerid");
-            const InsertQuery::columnIndex dataLineColumn = dataQuery.addColumn("idv_linenumber");
-            const InsertQuery::columnIndex dataKeyColumn = dataQuery.addColumn("idv_key");
-            const InsertQuery::columnIndex dataValueColumn = dataQuery.addColumn("idv_value");
-            dataQuery.setServerTable("playeritem_datavalues");
-
-            int linenumber = 0;
-
-            // save all items directly on the body...
-            for (int thisItemSlot = 0; thisItemSlot < MAX_BODY_ITEMS + MAX_BELT_SLOTS; ++thisItemSlot) {
-                ++linenumber;
-
-                // if there is no item on this place, do not save it
-                if (items.at(thisItemSlot).getId() == 0) {
-                    continue;
-                }
+            if (item.isContainer()) {
+                const auto &containedContainers = currentContainer.getContainers();
+                auto iterat = containedContainers.find(slotAndItem.first);
 
-                itemsQuery.addValue<int32_t>(itemsLineColumn, linenumber);
-                itemsQuery.addValue<int16_t>(itemsContainerColumn, 0);
-                itemsQuery.addValue<int32_t>(itemsDepotColumn, 0);
-                itemsQuery.addValue<TYPE_OF_ITEM_ID>(itemsItmIdColumn, items.at(thisItemSlot).getId());
-                itemsQuery.addValue<uint16_t>(itemsWearColumn, items.at(thisItemSlot).getWear());
-                itemsQuery.addValue<uint16_t>(itemsNumberColumn, items.at(thisItemSlot).getNumber());
-                itemsQuery.addValue<uint16_t>(itemsQualColumn, items.at(thisItemSlot).getQuality());
-                itemsQuery.addValue<TYPE_OF_CONTAINERSLOTS>(itemsSlotColumn, 0);
-
-                for (auto it = items.at(thisItemSlot).getDataBegin(); it != items.at(thisItemSlot).getDataEnd(); ++it) {
-                    if (it->second.length() > 0) {
-                        dataQuery.addValue<int32_t>(dataLineColumn, linenumber);
-                        dataQuery.addValue<std::string>(dataKeyColumn, it->first);
-                        dataQuery.addValue<std::string>(dataValueColumn, it->second);
-                    }
+                if (iterat != containedContainers.end()) {
+                    containers.emplace_back(iterat->second, linenumber);
                 }
             }
-
-            // add backpack contents...
-            while (!containers.empty()) {
-                // get container to save...
-                container_struct &currentContainerStruct = containers.front();
-                Container &currentContainer = *currentContainerStruct.container;
-                auto containedItems = currentContainer.getItems();
-
-                for (const auto &slotAndItem : containedItems) {
-                    const Item &item = slotAndItem.second;
-                    itemsQuery.addValue<int32_t>(itemsLineColumn, ++linenumber);
-                    itemsQuery.addValue<int16_t>(itemsContainerColumn, (int16_t)currentContainerStruct.id);
-                    itemsQuery.addValue<int32_t>(itemsDepotColumn, (int32_t)currentContainerStruct.depotid);
-                    itemsQuery.addValue<TYPE_OF_ITEM_ID>(itemsItmIdColumn, item.getId());
-                    itemsQuery.addValue<uint16_t>(itemsWearColumn, item.getWear());
-                    itemsQuery.addValue<uint16_t>(itemsNumberColumn, item.getNumber());
-                    itemsQuery.addValue<uint16_t>(itemsQualColumn, item.getQuality());
-                    itemsQuery.addValue<TYPE_OF_CONTAINERSLOTS>(itemsSlotColumn, slotAndItem.first);
-
-                    for (auto it = item.getDataBegin(); it != item.getDataEnd(); ++it) {
-                        dataQuery.addValue<int32_t>(dataLineColumn, linenumber);
-                        dataQuery.addValue<std::string>(dataKeyColumn, it->first);
-                        dataQuery.addValue<std::string>(dataValueColumn, it->second);
-                    }
-
-                    // if it is a container, add it to the list of containers to save...
-                    if (item.isContainer()) {
-                        auto containedContainers = currentContainer.getContainers();
-                        auto iterat = containedContainers.find(slotAndItem.first);
-
-                        if (iterat != containedContainers.end()) {
-                            containers.emplace_back(iterat->second, linenumber);
-                        }
-                    }
-                }
-
-                containers.pop_front();
-            }
-
-            itemsQuery.addValues(itemsPlyIdColumn, getId(), InsertQuery::FILL);
-            dataQuery.addValues(dataPlyIdColumn, getId(), InsertQuery::FILL);
-
-            itemsQuery.execute();
-            dataQuery.execute();
         }
 
-        connection->commitTransaction();
+        containers.pop_front();
+    }
 
-        if (!effects.save()) {
-            Logger::error(LogFacility::Player) << "error while saving lteffects for " << to_string() << Log::end;
-        }
+    snapshot.effects = effects.snapshot();
+    snapshot.quests.reserve(quests.size());
 
-        return true;
-    } catch (std::exception &e) {
-        Logger::error(LogFacility::Player) << "Playersave caught exception: " << e.what() << Log::end;
-        connection->rollbackTransaction();
-        return false;
+    for (auto &[quest, progress] : quests) {
+        snapshot.quests.push_back({quest, progress.progress, progress.time, progress.dirty});
+        progress.dirty = false;
     }
+
+    return snapshot;
 }
 
 auto Player::loadGMFlags() noexcept -> bool {
     try {
         using namespace Database;
-        SelectQuery query;
-        query.addColumn("gms", "gm_rights_server");
-        query.addEqualCondition<TYPE_OF_CHARACTER_ID>("gms", "gm_charid", getId());
-        query.addServerTable("gms");
-
-        Result results = query.execute();
+        static const PreparedQuery query("load_gm_flags",
+                                         "SELECT gm_rights_server FROM {server}.gms WHERE gm_charid = $1");
+        Result results = query.execute(ConnectionManager::getInstance().getConnection(), getId());
 
         if (results.empty()) {
             setAdmin(0);
@@ -1314,7 +1266,6 @@ auto Player::loadGMFlags() noexcept -> bool {
 }
 
 auto Player::load() noexcept -> bool {
-    std::map<int, Container *> depots;
     std::map<int, Container *> containers;
     std::map<int, Container *>::iterator it;
 
@@ -1325,60 +1276,60 @@ auto Player::load() noexcept -> bool {
 
     try {
         {
-            SelectQuery query;
-            query.addColumn("questprogress", "qpg_questid");
-            query.addColumn("questprogress", "qpg_progress");
-            query.addColumn("questprogress", "qpg_time");
-            query.addEqualCondition<TYPE_OF_CHARACTER_ID>("questprogress", "qpg_userid", getId());
-            query.addServerTable("questprogress");
-
-            Result results = query.execute();
+            static const PreparedQuery query(
+                    "load_quest_progress",
+                    "SELECT qpg_questid, qpg_progress, qpg_time FROM {server}.questprogress WHERE qpg_userid = $1");
+            Result results = query.execute(connection, getId());
 
             for (const auto &row : results) {
                 const auto questId = row["qpg_questid"].as<TYPE_OF_QUEST_ID>();
                 const auto questStatus = row["qpg_progress"].as<TYPE_OF_QUESTSTATUS>(0);
                 const auto questTime = row["qpg_time"].as<int>();
-                quests[questId] = std::make_pair(questStatus, questTime);
+                quests[questId] = {questStatus, questTime};
             }
         }
 
         {
-            SelectQuery query;
-            query.addColumn("introduction", "intro_known_player");
-            query.addEqualCondition<TYPE_OF_CHARACTER_ID>("introduction", "intro_player", getId());
-            query.addServerTable("introduction");
+            static const PreparedQuery query("load_introductions",
+                                             "SELECT intro_known_player FROM {server}.introduction "
+                                             "WHERE intro_player = $1");
+            Result results = query.execute(connection, getId());
 
-            Result results = query.execute();
+            knownPlayers.clear();
+            knownPlayers.reserve(results.size());
 
             for (const auto &row : results) {
-                knownPlayers.insert(row["intro_known_player"].as<TYPE_OF_CHARACTER_ID>());
+                knownPlayers.push_back(row["intro_known_player"].as<TYPE_OF_CHARACTER_ID>());
             }
+
+            std::sort(knownPlayers.begin(), knownPlayers.end());
+            knownPlayers.erase(std::unique(knownPlayers.begin(), knownPlayers.end()), knownPlayers.end());
         }
 
         {
-            SelectQuery query;
-            query.addColumn("naming", "name_named_player");
-            query.addColumn("naming", "name_player_name");
-            query.addEqualCondition<TYPE_OF_CHARACTER_ID>("naming", "name_player", getId());
-            query.addServerTable("naming");
+            static const PreparedQuery query("load_names",
+                                             "SELECT name_named_player, name_player_name FROM {server}.naming "
+                                             "WHERE name_player = $1");
+            Result results = query.execute(connection, getId());
 
-            Result results = query.execute();
+            namedPlayers.clear();
+            namedPlayers.reserve(results.size());
 
             for (const auto &row : results) {
-                namedPlayers.emplace(row["name_named_player"].as<TYPE_OF_CHARACTER_ID>(),
-                                     row["name_player_name"].as<std::string>());
+                namedPlayers.emplace_back(row["name_named_player"].as<TYPE_OF_CHARACTER_ID>(),
+                                          row["name_player_name"].as<std::string>());
             }
+
+            // the table's key keeps the players unique
+            std::sort(namedPlayers.begin(), namedPlayers.end(),
+                      [](const auto &a, const auto &b) { return a.first < b.first; });
         }
 
         {
-            SelectQuery query;
-            query.addColumn("playerskills", "psk_skill_id");
-            query.addColumn("playerskills", "psk_value");
-            query.addColumn("playerskills", "psk_minor");
-            query.addEqualCondition<TYPE_OF_CHARACTER_ID>("playerskills", "psk_playerid", getId());
-            query.addServerTable("playerskills");
-
-            Result results = query.execute();
+            static const PreparedQuery query(
+                    "load_skills",
+                    "SELECT psk_skill_id, psk_value, psk_minor FROM {server}.playerskills WHERE psk_playerid = $1");
+            Result results = query.execute(connection, getId());
 
             if (!results.empty()) {
                 for (const auto &row : results) {
@@ -1390,112 +1341,36 @@ auto Player::load() noexcept -> bool {
             }
         }
 
-        // load data values
-        std::vector<uint16_t> ditemlinenumber;
-        std::vector<std::string> key;
-        std::vector<std::string> value;
+        // depots stay in the database until they are used
         {
-            SelectQuery query;
-            query.addColumn("playeritem_datavalues", "idv_linenumber");
-            query.addColumn("playeritem_datavalues", "idv_key");
-            query.addColumn("playeritem_datavalues", "idv_value");
-            query.addEqualCondition<TYPE_OF_CHARACTER_ID>("playeritem_datavalues", "idv_playerid", getId());
-            query.addOrderBy("playeritem_datavalues", "idv_linenumber", SelectQuery::ASC);
-            query.addServerTable("playeritem_datavalues");
-
-            Result results = query.execute();
+            static const PreparedQuery query("load_depot_lines",
+                                             depotLinesOf("pit_depot <> 0") + "SELECT line, depot FROM depot_lines");
+            Result results = query.execute(connection, getId());
 
             for (const auto &row : results) {
-                ditemlinenumber.push_back(row["idv_linenumber"].as<uint16_t>());
-                key.push_back(row["idv_key"].as<std::string>());
-                value.push_back(row["idv_value"].as<std::string>());
+                unloadedDepots[row["depot"].as<uint32_t>()].push_back(row["line"].as<int32_t>());
             }
         }
-        size_t dataRows = ditemlinenumber.size();
 
         // load inventory
-        std::vector<uint16_t> itemlinenumber;
-        std::vector<uint16_t> itemincontainer;
-        std::vector<uint32_t> itemdepot;
-        std::vector<Item::id_type> itemid;
-        std::vector<Item::wear_type> itemwear;
-        std::vector<Item::number_type> itemnumber;
-        std::vector<Item::quality_type> itemquality;
-        std::vector<TYPE_OF_CONTAINERSLOTS> itemcontainerslot;
-        {
-            SelectQuery query;
-            query.addColumn("playeritems", "pit_linenumber");
-            query.addColumn("playeritems", "pit_in_container");
-            query.addColumn("playeritems", "pit_depot");
-            query.addColumn("playeritems", "pit_itemid");
-            query.addColumn("playeritems", "pit_wear");
-            query.addColumn("playeritems", "pit_number");
-            query.addColumn("playeritems", "pit_quality");
-            query.addColumn("playeritems", "pit_containerslot");
-            query.addEqualCondition<TYPE_OF_CHARACTER_ID>("playeritems", "pit_playerid", getId());
-            query.addOrderBy("playeritems", "pit_linenumber", SelectQuery::ASC);
-            query.addServerTable("playeritems");
-
-            Result results = query.execute();
-
-            for (const auto &row : results) {
-                itemlinenumber.push_back(row["pit_linenumber"].as<uint16_t>());
-                itemincontainer.push_back(row["pit_in_container"].as<uint16_t>());
-                itemdepot.push_back(row["pit_depot"].as<uint32_t>());
-                itemid.push_back(row["pit_itemid"].as<Item::id_type>());
-                itemwear.push_back((Item::wear_type)(row["pit_wear"].as<uint16_t>()));
-                itemnumber.push_back(row["pit_number"].as<Item::number_type>());
-                itemquality.push_back(row["pit_quality"].as<Item::quality_type>());
-                itemcontainerslot.push_back(row["pit_containerslot"].as<TYPE_OF_CONTAINERSLOTS>());
-            }
-        }
-        size_t itemRows = itemlinenumber.size();
-
-        // load depots
-        std::vector<uint32_t> depotid;
-        {
-            SelectQuery query;
-            query.setDistinct(true);
-            query.addColumn("playeritems", "pit_depot");
-            query.addEqualCondition<TYPE_OF_CHARACTER_ID>("playeritems", "pit_playerid", getId());
-            query.addServerTable("playeritems");
-
-            Result results = query.execute();
-
-            ranges::for_each(results, [&depotid](const ResultTuple &row) {
-                depotid.push_back(row["pit_depot"].as<uint32_t>());
-            });
-        }
-
-        size_t depotRows = depotid.size();
-
-        for (size_t i = 0; i < depotRows; ++i) {
-            if (depotid[i] != 0) {
-                depotContents[depotid[i]] = new Container(DEPOTITEM);
-                depots[depotid[i]] = depotContents[depotid[i]];
-            }
-        }
-
-        unsigned int curdatalinenumber = 0;
-
-        for (unsigned int tuple = 0; tuple < itemRows; ++tuple) {
-            unsigned int tempincont = itemincontainer[tuple];
-            unsigned int tempdepot = itemdepot[tuple];
-            unsigned int linenumber = itemlinenumber[tuple];
-
-            Item tempi(itemid[tuple], itemnumber[tuple], itemwear[tuple], itemquality[tuple]);
-
-            while (curdatalinenumber < dataRows && ditemlinenumber[curdatalinenumber] == linenumber) {
-                tempi.setData(key[curdatalinenumber], value[curdatalinenumber]);
-                curdatalinenumber++;
-            }
-
-            // item is in a depot?
-            if ((tempdepot != 0) && (it = depots.find(tempdepot)) == depots.end()) {
-                // serious error occured! player data corrupted!
-                Logger::error(LogFacility::Player) << to_string() << " has invalid depot contents!" << Log::end;
-                throw std::exception();
-            }
+        static const PreparedQuery itemsQuery(
+                "load_items", depotLinesOf("pit_depot <> 0") + itemColumns +
+                                      "FROM {server}.playeritems WHERE pit_playerid = $1 "
+                                      "AND pit_linenumber NOT IN (SELECT line FROM depot_lines) "
+                                      "ORDER BY pit_linenumber ASC");
+        static const PreparedQuery dataQuery("load_item_data",
+                                             depotLinesOf("pit_depot <> 0") +
+                                                     "SELECT idv_linenumber, idv_key, idv_value "
+                                                     "FROM {server}.playeritem_datavalues WHERE idv_playerid = $1 "
+                                                     "AND idv_linenumber NOT IN (SELECT line FROM depot_lines) "
+                                                     "ORDER BY idv_linenumber ASC");
+        const auto storedItems =
+                storedItemsOf(itemsQuery.execute(connection, getId()), dataQuery.execute(connection, getId()));
+
+        for (const auto &stored : storedItems) {
+            const unsigned int tempincont = stored.container;
+            const unsigned int linenumber = stored.line;
+            const Item &tempi = stored.item;
 
             // item is in a container?
             if ((tempincont != 0) && (it = containers.find(tempincont)) == containers.end()) {
@@ -1504,8 +1379,7 @@ auto Player::load() noexcept -> bool {
                 throw std::exception();
             }
 
-            if ((((tempincont == 0) && (tempdepot == 0)) && linenumber > MAX_BODY_ITEMS + MAX_BELT_SLOTS) ||
-                ((tempincont != 0) && (tempdepot != 0))) {
+            if (((tempincont == 0) && linenumber > MAX_BODY_ITEMS + MAX_BELT_SLOTS) || stored.depot != 0) {
                 // serious error occured! player data corrupted!
                 Logger::error(LogFacility::Player) << to_string() << " has invalid items!" << Log::end;
                 throw std::exception();
@@ -1515,10 +1389,9 @@ auto Player::load() noexcept -> bool {
                 auto *tempc = new Container(tempi.getId());
 
                 if (linenumber > MAX_BODY_ITEMS + MAX_BELT_SLOTS) {
-                    if (!it->second->InsertContainer(tempi, tempc, itemcontainerslot[tuple])) {
+                    if (!it->second->InsertContainer(tempi, tempc, stored.slot)) {
                         Logger::error(LogFacility::Player)
                                 << to_string() << " insert Container wasn't sucessful!" << Log::end;
-                    } else {
                     }
                 } else {
                     items.at(linenumber - 1) = tempi;
@@ -1527,7 +1400,7 @@ auto Player::load() noexcept -> bool {
                 containers[linenumber] = tempc;
             } else {
                 if (linenumber >= MAX_BODY_ITEMS + MAX_BELT_SLOTS + 1) {
-                    it->second->InsertItem(tempi, itemcontainerslot[tuple]);
+                    it->second->InsertItem(tempi, stored.slot);
                 } else {
                     items.at(linenumber - 1) = tempi;
                 }
@@ -1539,14 +1412,6 @@ auto Player::load() noexcept -> bool {
         } else {
             backPackContents = nullptr;
         }
-
-        for (const auto &depot : depots) {
-            auto depotIt = depotContents.find(depot.first);
-
-            if (depotIt != depotContents.end()) {
-                depotIt->second = depot.second;
-            }
-        }
     } catch (std::exception &e) {
         Logger::error(LogFacility::Player) << "Exception on loading player: " << e.what() << Log::end;
         dataOK = false;
@@ -1554,20 +1419,13 @@ auto Player::load() noexcept -> bool {
 
     if (!dataOK) {
         std::map<int, Container *>::reverse_iterator rit;
-        std::map<uint32_t, Container *>::reverse_iterator rit2;
 
         // clean up...
         for (rit = containers.rbegin(); rit != containers.rend(); ++rit) {
             delete rit->second;
         }
 
-        for (rit = depots.rbegin(); rit != depots.rend(); ++rit) {
-            delete rit->second;
-        }
-
-        for (rit2 = depotContents.rbegin(); rit2 != depotContents.rend(); ++rit2) {
-            delete rit2->second;
-        }
+        unloadedDepots.clear();
 
         backPackContents = nullptr;
     }
@@ -1628,35 +1486,44 @@ void Player::turn(const position &pos) {
 }
 
 void Player::receiveText(talk_type tt, const std::string &message, Character *cc) {
-    ServerCommandPointer cmd = std::make_shared<SayTC>(cc->getPosition(), message);
+    Connection->addCommand(talkCommand(tt, cc->getPosition(), message));
+}
 
+auto Player::talkCommand(talk_type tt, const position &pos, const std::string &message) -> ServerCommandPointer {
     switch (tt) {
-    case tt_say:
-        Connection->addCommand(cmd);
-        break;
-
     case tt_whisper:
-        cmd = std::make_shared<WhisperTC>(cc->getPosition(), message);
-        Connection->addCommand(cmd);
-        break;
+        return std::make_shared<WhisperTC>(pos, message);
 
     case tt_yell:
-        cmd = std::make_shared<ShoutTC>(cc->getPosition(), message);
-        Connection->addCommand(cmd);
-        break;
+        return std::make_shared<ShoutTC>(pos, message);
+
+    default:
+        return std::make_shared<SayTC>(pos, message);
     }
 }
 
 auto Player::knows(Player *player) const -> bool {
-    return this == player || knownPlayers.find(player->getId()) != knownPlayers.cend();
+    return this == player || std::binary_search(knownPlayers.cbegin(), knownPlayers.cend(), player->getId());
 }
 
 void Player::getToKnow(Player *player) {
-    if (!knows(player)) {
-        knownPlayers.insert(player->getId());
+    if (this == player) {
+        return;
+    }
+
+    const auto id = player->getId();
+    const auto known = std::lower_bound(knownPlayers.begin(), knownPlayers.end(), id);
+
+    if (known == knownPlayers.end() || *known != id) {
+        knownPlayers.insert(known, id);
     }
 }
 
+auto Player::findName(TYPE_OF_CHARACTER_ID playerId) const -> PlayerSnapshot::NamedPlayers::const_iterator {
+    return std::lower_bound(namedPlayers.cbegin(), namedPlayers.cend(), playerId,
+                            [](const auto &named, TYPE_OF_CHARACTER_ID id) { return named.first < id; });
+}
+
 void Player::introducePlayer(Player *player) {
     getToKnow(player);
 
@@ -1668,18 +1535,25 @@ void Player::namePlayer(TYPE_OF_CHARACTER_ID playerId, const std::string &name)
     const Character *character = World::get()->findCharacter(playerId);
 
     if (character->getType() == player && this->getId() != playerId) {
+        const auto named = namedPlayers.begin() + (findName(playerId) - namedPlayers.cbegin());
+        const bool exists = named != namedPlayers.end() && named->first == playerId;
+
         if (name.length() > 0) {
-            namedPlayers[playerId] = name;
-        } else {
-            namedPlayers.erase(playerId);
+            if (exists) {
+                named->second = name;
+            } else {
+                namedPlayers.emplace(named, playerId, name);
+            }
+        } else if (exists) {
+            namedPlayers.erase(named);
         }
     }
 }
 
 auto Player::getCustomNameOf(Player *player) const -> std::string {
-    const auto it = namedPlayers.find(player->getId());
+    const auto it = findName(player->getId());
 
-    if (it != namedPlayers.cend()) {
+    if (it != namedPlayers.cend() && it->first == player->getId()) {
         return it->second;
     }
     return {};
@@ -1742,6 +1616,12 @@ void Player::inform(const std::string &german, const std::string &english, infor
 
 void Player::checkBurden() {
     loadLevel = loadFactor();
+
+    if (itemBatchDepth > 0) {
+        batchedBurden = true;
+        return;
+    }
+
     auto cmd = std::make_shared<UpdateLoadTC>(LoadWeight(), maxLoadWeight());
     Connection->addCommand(cmd);
 }
@@ -1758,8 +1638,7 @@ auto Player::moveToPossible(const map::Field &field) const -> bool {
 
 auto Player::move(direction dir, uint8_t mode) -> bool {
     using std::chrono::milliseconds;
-    using std::chrono::steady_clock;
-    auto now = steady_clock::now();
+    auto now = TickClock::now();
 
     if (now + milliseconds(MAX_WALK_COST) < reachingTargetField) {
         auto cmd = std::make_shared<MoveAckTC>(getId(), getPosition(), STILLMOVING, 0);
@@ -1862,9 +1741,9 @@ auto Player::move(direction dir, uint8_t mode) -> bool {
 
                 World::checkFieldAfterMove(this, newField);
 
-                World::triggerFieldMove(this, true);
+                World::triggerFieldMove(this, true, newField);
                 ServerCommandPointer cmd = std::make_shared<BBPlayerMoveTC>(getId(), getPosition());
-                _world->monitoringClientList->sendCommand(cmd);
+                _world->monitoringClientList->sendState(MonitoringClients::stateKey(getId(), BB_PLAYERMOVE_TC), cmd);
 
                 if (mode != RUNNING || j == 1) {
                     return true;
@@ -1929,11 +1808,12 @@ void Player::handleWarp() {
     visibleChars.clear();
     _world->sendAllVisibleCharactersToPlayer(this, true);
     cmd = std::make_shared<BBPlayerMoveTC>(getId(), getPosition());
-    _world->monitoringClientList->sendCommand(cmd);
+    _world->monitoringClientList->sendState(MonitoringClients::stateKey(getId(), BB_PLAYERMOVE_TC), cmd);
 }
 
 void Player::openDepot(const ScriptItem &item) {
     const auto depotid = item.getDepot();
+    loadDepot(depotid);
 
     if (depotContents.find(depotid) != depotContents.end()) {
         if (depotContents[depotid] != nullptr) {
@@ -1945,75 +1825,95 @@ void Player::openDepot(const ScriptItem &item) {
     }
 }
 
-void Player::changeQualityAt(unsigned char pos, int amount) {
-    Character::changeQualityAt(pos, amount);
-    sendCharacterItemAtPos(pos);
-    sendCharacterItemAtPos(LEFT_TOOL);
-    sendCharacterItemAtPos(RIGHT_TOOL);
-}
-
-auto Player::hasGMRight(gm_rights right) const -> bool { return ((right & admin) == static_cast<uint32_t>(right)); }
+void Player::loadDepot(uint32_t depotid) {
+    const auto unloaded = unloadedDepots.find(depotid);
 
-void Player::setQuestProgress(TYPE_OF_QUEST_ID questid, TYPE_OF_QUESTSTATUS progress) {
-    if (questWriteLock) {
-        LuaScript::writeDebugMsg("Setting quest progress is not allowed in quest entrypoint!");
+    if (unloaded == unloadedDepots.end()) {
         return;
     }
 
-    questWriteLock = true;
     using namespace Database;
-    PConnection connection = ConnectionManager::getInstance().getConnection();
-    int timeNow = int(time(nullptr));
+    static const PreparedQuery itemsQuery("load_depot_items",
+                                          depotLinesOf("pit_depot = $2") + itemColumns +
+                                                  "FROM {server}.playeritems JOIN depot_lines ON pit_linenumber = line "
+                                                  "WHERE pit_playerid = $1 ORDER BY pit_linenumber ASC");
+    static const PreparedQuery dataQuery(
+            "load_depot_item_data",
+            depotLinesOf("pit_depot = $2") +
+                    "SELECT idv_linenumber, idv_key, idv_value FROM {server}.playeritem_datavalues "
+                    "JOIN depot_lines ON idv_linenumber = line WHERE idv_playerid = $1 ORDER BY idv_linenumber ASC");
+
+    std::vector<StoredItem> storedItems;
 
     try {
-        connection->beginTransaction();
+        auto connection = ConnectionManager::getInstance().getConnection();
+        storedItems = storedItemsOf(itemsQuery.execute(connection, getId(), depotid),
+                                    dataQuery.execute(connection, getId(), depotid));
+    } catch (std::exception &e) {
+        // the depot stays unloaded and reserved, a later access retries
+        Logger::error(LogFacility::Player)
+                << "Exception on loading depot " << depotid << " of " << to_string() << ": " << e.what() << Log::end;
+        return;
+    }
+
+    auto *depot = new Container(DEPOTITEM);
+    std::map<int, Container *> containers;
 
-        SelectQuery query(connection);
-        query.addColumn("questprogress", "qpg_progress");
-        query.addEqualCondition<TYPE_OF_CHARACTER_ID>("questprogress", "qpg_userid", getId());
-        query.addEqualCondition<TYPE_OF_QUEST_ID>("questprogress", "qpg_questid", questid);
-        query.addServerTable("questprogress");
+    for (const auto &stored : storedItems) {
+        Container *parent = depot;
 
-        Result results = query.execute();
+        if (stored.depot == 0) {
+            const auto it = containers.find(stored.container);
 
-        // TODO: Save player from dedicated thread only, see PlayerManager
-        // save();
+            if (it == containers.end()) {
+                Logger::error(LogFacility::Player) << to_string() << " has invalid depot contents 2!" << Log::end;
+                continue;
+            }
 
-        if (results.empty()) {
-            InsertQuery insQuery;
-            const InsertQuery::columnIndex userColumn = insQuery.addColumn("qpg_userid");
-            const InsertQuery::columnIndex questColumn = insQuery.addColumn("qpg_questid");
-            const InsertQuery::columnIndex progressColumn = insQuery.addColumn("qpg_progress");
-            const InsertQuery::columnIndex timeColumn = insQuery.addColumn("qpg_time");
-            insQuery.addServerTable("questprogress");
-
-            insQuery.addValue<TYPE_OF_CHARACTER_ID>(userColumn, getId());
-            insQuery.addValue<TYPE_OF_QUEST_ID>(questColumn, questid);
-            insQuery.addValue<TYPE_OF_QUESTSTATUS>(progressColumn, progress);
-            insQuery.addValue<int>(timeColumn, timeNow);
-
-            insQuery.execute();
-        } else {
-            UpdateQuery updQuery;
-            updQuery.addAssignColumn<TYPE_OF_QUESTSTATUS>("qpg_progress", progress);
-            updQuery.addAssignColumn<int>("qpg_time", timeNow);
-            updQuery.addEqualCondition<TYPE_OF_CHARACTER_ID>("questprogress", "qpg_userid", getId());
-            updQuery.addEqualCondition<TYPE_OF_QUEST_ID>("questprogress", "qpg_questid", questid);
-            updQuery.setServerTable("questprogress");
+            parent = it->second;
+        }
+
+        if (stored.item.isContainer()) {
+            auto *container = new Container(stored.item.getId());
 
-            updQuery.execute();
+            if (parent->InsertContainer(stored.item, container, stored.slot)) {
+                containers[stored.line] = container;
+            } else {
+                Logger::error(LogFacility::Player) << to_string() << " insert Container wasn't sucessful!" << Log::end;
+                delete container;
+            }
+        } else {
+            parent->InsertItem(stored.item, stored.slot);
         }
+    }
 
-        connection->commitTransaction();
-    } catch (std::exception &e) {
-        Logger::error(LogFacility::Script)
-                << "Setting quest progress failed for " << to_string() << ": " << e.what() << Log::end;
-        connection->rollbackTransaction();
-        questWriteLock = false;
+    for (uint32_t i = 0; i < inventoryAgeings; ++i) {
+        depot->doAge(true);
+    }
+
+    depotContents[depotid] = depot;
+    releasedItemLines.insert(unloaded->second.begin(), unloaded->second.end());
+    unloadedDepots.erase(unloaded);
+}
+
+void Player::changeQualityAt(unsigned char pos, int amount) {
+    Character::changeQualityAt(pos, amount);
+    sendCharacterItemAtPos(pos);
+    sendCharacterItemAtPos(LEFT_TOOL);
+    sendCharacterItemAtPos(RIGHT_TOOL);
+}
+
+auto Player::hasGMRight(gm_rights right) const -> bool { return ((right & admin) == static_cast<uint32_t>(right)); }
+
+void Player::setQuestProgress(TYPE_OF_QUEST_ID questid, TYPE_OF_QUESTSTATUS progress) {
+    if (questWriteLock) {
+        LuaScript::writeDebugMsg("Setting quest progress is not allowed in quest entrypoint!");
         return;
     }
 
-    quests[questid] = std::make_pair(progress, timeNow);
+    questWriteLock = true;
+    // written with the next save
+    quests[questid] = {progress, int(time(nullptr)), true};
     sendQuestProgress(questid, progress);
     questWriteLock = false;
 }
@@ -2073,7 +1973,7 @@ void Player::sendQuestProgress(TYPE_OF_QUEST_ID questId, TYPE_OF_QUESTSTATUS pro
 void Player::sendCompleteQuestProgress() {
     for (const auto &quest : quests) {
         TYPE_OF_QUEST_ID questId = quest.first;
-        TYPE_OF_QUESTSTATUS progress = quest.second.first;
+        TYPE_OF_QUESTSTATUS progress = quest.second.progress;
         sendQuestProgress(questId, progress);
     }
 }
@@ -2082,8 +1982,8 @@ auto Player::getQuestProgress(TYPE_OF_QUEST_ID questid, int &time) const -> TYPE
     const auto it = quests.find(questid);
 
     if (it != quests.end()) {
-        time = it->second.second;
-        return it->second.first;
+        time = it->second.time;
+        return it->second.progress;
     }
     time = 0;
 
@@ -2142,9 +2042,7 @@ void Player::sendRelativeArea(Coordinate zoffs) {
         for (Coordinate i = 0; i <= (MAP_DIMENSION + MAP_DOWN_EXTRA + e) * 2; ++i) {
             world->clientview.fillStripe(position(x, y, z), NewClientView::dir_right, MAP_DIMENSION + 1 - (i % 2));
 
-            if (world->clientview.getExists()) {
-                Connection->addCommand(std::make_shared<MapStripeTC>(position(x, y, z), NewClientView::dir_right));
-            }
+            sendViewStripe(world->clientview.getStripe());
 
             if (i % 2 == 0) {
                 y += 1;
@@ -2171,9 +2069,7 @@ void Player::sendRelativeArea(Coordinate zoffs) {
         for (Coordinate i = 0; i <= (2 * screenheight + MAP_DOWN_EXTRA + e) * 2; ++i) {
             world->clientview.fillStripe(position(x, y, z), NewClientView::dir_right, 2 * screenwidth + 1 - (i % 2));
 
-            if (world->clientview.getExists()) {
-                Connection->addCommand(std::make_shared<MapStripeTC>(position(x, y, z), NewClientView::dir_right));
-            }
+            sendViewStripe(world->clientview.getStripe());
 
             if (i % 2 == 0) {
                 y += 1;
@@ -2185,6 +2081,8 @@ void Player::sendRelativeArea(Coordinate zoffs) {
 }
 
 void Player::sendFullMap() {
+    heldStripes.clear();
+
     for (Coordinate i = -2; i <= 2; ++i) {
         sendRelativeArea(i);
     }
@@ -2266,10 +2164,7 @@ void Player::sendDirStripe(viewdir direction, bool extraStripeForDiagonalMove) {
 
             view->fillStripe(position(x - z * 3 + e, y + z * 3 - e, pos.z + z), dir, length + l);
 
-            if (view->getExists()) {
-                Connection->addCommand(
-                        std::make_shared<MapStripeTC>(position(x - z * 3 + e, y + z * 3 - e, pos.z + z), dir));
-            }
+            sendViewStripe(view->getStripe());
         }
     } else {
         // dynamic view
@@ -2344,12 +2239,32 @@ void Player::sendDirStripe(viewdir direction, bool extraStripeForDiagonalMove) {
 
             view->fillStripe(position(x - z * 3 + e, y + z * 3 - e, pos.z + z), dir, length + l);
 
-            if (view->getExists()) {
-                Connection->addCommand(
-                        std::make_shared<MapStripeTC>(position(x - z * 3 + e, y + z * 3 - e, pos.z + z), dir));
-            }
+            sendViewStripe(view->getStripe());
+        }
+    }
+}
+
+void Player::sendViewStripe(const NewClientView::Stripe &stripe) {
+    if (stripe.payload.empty()) {
+        return;
+    }
+
+    if (Config::instance().map_delta_updates) {
+        if (heldStripes.size() >= maxHeldStripes) {
+            heldStripes.clear();
+        }
+
+        const auto fingerprint = stripe.fingerprint;
+        auto [heldStripe, isNew] = heldStripes.try_emplace(stripe.key, fingerprint);
+
+        if (!isNew && heldStripe->second == fingerprint) {
+            return;
         }
+
+        heldStripe->second = fingerprint;
     }
+
+    Connection->addCommand(std::make_shared<MapStripeTC>(stripe, getPosition(), commandEncoding()));
 }
 
 void Player::sendStepStripes(direction dir) {
@@ -2412,16 +2327,16 @@ void Player::sendField(const position &pos) {
     view.fillStripe(pos, NewClientView::dir_right, 1);
 
     if (view.getExists()) {
-        Connection->addCommand(std::make_shared<MapStripeTC>(pos, NewClientView::dir_right));
+        Connection->addCommand(std::make_shared<MapStripeTC>(view.getStripe(), getPosition(), commandEncoding()));
     }
 }
 
-auto Player::idleTime() const -> uint32_t {
-    time_t now = 0;
-    time(&now);
-    return now - lastaction;
+auto Player::commandEncoding() -> CommandEncoding {
+    return Config::instance().compact_protocol ? CommandEncoding::compact : CommandEncoding::standard;
 }
 
+auto Player::idleTime() const -> uint32_t { return TickClock::wallNow() - lastaction; }
+
 void Player::sendBook(uint16_t bookID) {
     ServerCommandPointer cmd = std::make_shared<BookTC>(bookID);
     Connection->addCommand(cmd);
@@ -2462,19 +2377,95 @@ void Player::sendCharDescription(TYPE_OF_CHARACTER_ID id, const std::string &des
 }
 
 void Player::sendCharAppearance(TYPE_OF_CHARACTER_ID id, const ServerCommandPointer &appearance, bool always) {
+    const auto visible = std::lower_bound(visibleChars.begin(), visibleChars.end(), id);
+    const bool appeared = visible == visibleChars.end() || *visible != id;
+
+    if (appeared) {
+        visibleChars.insert(visible, id);
+    }
+
     // send appearance always or only if the char in question just appeared
-    if (always || visibleChars.insert(id).second) {
+    if (always || appeared) {
         Connection->addCommand(appearance);
     }
 }
 
 void Player::sendCharRemove(TYPE_OF_CHARACTER_ID id, const ServerCommandPointer &removechar) {
     if (this->getId() != id) {
-        visibleChars.erase(id);
+        if (const auto visible = std::lower_bound(visibleChars.begin(), visibleChars.end(), id);
+            visible != visibleChars.end() && *visible == id) {
+            visibleChars.erase(visible);
+        }
+
+        // a move of a character out of sight must not follow its removal
+        const auto ofCharacter = [id](const MultiMoveTC::Move &move) { return move.id == id; };
+        queuedMoves.erase(std::remove_if(queuedMoves.begin(), queuedMoves.end(), ofCharacter), queuedMoves.end());
+        farMoves.erase(std::remove_if(farMoves.begin(), farMoves.end(), ofCharacter), farMoves.end());
         Connection->addCommand(removechar);
     }
 }
 
+auto Player::queueCharacterMove(const MultiMoveTC::Move &move, bool far) -> bool {
+    const auto ofCharacter = [&move](const MultiMoveTC::Move &other) { return other.id == move.id; };
+    const auto farMove = std::find_if(farMoves.begin(), farMoves.end(), ofCharacter);
+
+    if (far) {
+        if (farMove != farMoves.end()) {
+            *farMove = move;
+            return true;
+        }
+    } else if (farMove != farMoves.end()) {
+        // the deferred move is stale now
+        farMoves.erase(farMove);
+    } else if (!Config::instance().multi_move_updates) {
+        return false;
+    }
+
+    if (queuedMoves.empty() && farMoves.empty()) {
+        _world->characterMovesQueued(*this);
+    }
+
+    (far ? farMoves : queuedMoves).push_back(move);
+    return true;
+}
+
+void Player::flushCharacterMoves() {
+    const auto now = TickClock::now();
+
+    if (!farMoves.empty() && now >= farMovesDue) {
+        queuedMoves.insert(queuedMoves.end(), farMoves.begin(), farMoves.end());
+        farMoves.clear();
+        farMovesDue = now + std::chrono::milliseconds(Config::instance().far_update_interval);
+    }
+
+    const auto &origin = getPosition();
+
+    if (Config::instance().multi_move_updates && queuedMoves.size() > 1 &&
+        std::all_of(queuedMoves.begin(), queuedMoves.end(),
+                    [&origin](const auto &move) { return MultiMoveTC::fits(origin, move.pos); })) {
+        const auto encoding = commandEncoding();
+
+        if (encoding == CommandEncoding::compact) {
+            // short id differences, the moves of one character keep their order
+            std::stable_sort(queuedMoves.begin(), queuedMoves.end(),
+                             [](const auto &move, const auto &other) { return move.id < other.id; });
+        }
+
+        Connection->addCommand(std::make_shared<MultiMoveTC>(origin, queuedMoves, encoding));
+    } else {
+        for (const auto &move : queuedMoves) {
+            Connection->addCommand(std::make_shared<MoveAckTC>(move.id, move.pos, move.mode, move.duration));
+        }
+    }
+
+    queuedMoves.clear();
+
+    // far moves not yet due keep the player on the list
+    if (!farMoves.empty()) {
+        _world->characterMovesQueued(*this);
+    }
+}
+
 void Player::requestInputDialog(InputDialog *inputDialog) { requestDialog<InputDialog, InputDialogTC>(inputDialog); }
 
 void Player::executeInputDialog(unsigned int dialogId, bool success, const std::string &input) {
@@ -2490,7 +2481,7 @@ void Player::executeInputDialog(unsigned int dialogId, bool success, const std::
         LuaScript::executeDialogCallback(*inputDialog);
     }
 
-    dialogs.erase(dialogId);
+    dialogs.close(dialogId);
 }
 
 void Player::requestMessageDialog(MessageDialog *messageDialog) {
@@ -2504,7 +2495,7 @@ void Player::executeMessageDialog(unsigned int dialogId) {
         LuaScript::executeDialogCallback(*messageDialog);
     }
 
-    dialogs.erase(dialogId);
+    dialogs.close(dialogId);
 }
 
 void Player::requestMerchantDialog(MerchantDialog *merchantDialog) {
@@ -2523,7 +2514,7 @@ void Player::executeMerchantDialogAbort(unsigned int dialogId) {
         LuaScript::executeDialogCallback(*merchantDialog);
     }
 
-    dialogs.erase(dialogId);
+    dialogs.close(dialogId);
 }
 
 void Player::executeMerchantDialogBuy(unsigned int dialogId, MerchantDialog::index_type index,
@@ -2564,6 +2555,7 @@ void Player::executeMerchantDialogSell(unsigned int dialogId, uint8_t location,
         }
 
         merchantDialog->setSaleItem(item);
+        const ItemBatch batch(*this);
         LuaScript::executeDialogCallback(*merchantDialog);
     }
 }
@@ -2599,7 +2591,7 @@ void Player::executeSelectionDialog(unsigned int dialogId, bool success, Selecti
         LuaScript::executeDialogCallback(*selectionDialog);
     }
 
-    dialogs.erase(dialogId);
+    dialogs.close(dialogId);
 }
 
 void Player::requestCraftingDialog(CraftingDialog *craftingDialog) {
@@ -2614,7 +2606,7 @@ void Player::executeCraftingDialogAbort(unsigned int dialogId) {
         LuaScript::executeDialogCallback(*craftingDialog);
     }
 
-    dialogs.erase(dialogId);
+    dialogs.close(dialogId);
 }
 
 void Player::executeCraftingDialogCraft(unsigned int dialogId, uint8_t craftIndex, uint8_t craftAmount) {
@@ -2643,7 +2635,13 @@ void Player::executeCraftingDialogCraftingComplete(unsigned int dialogId) {
 
     if (craftingDialog) {
         craftingDialog->setResult(CraftingDialog::playerCraftingComplete);
-        bool renewProductList = LuaScript::executeDialogCallback<bool>(*craftingDialog);
+        bool renewProductList = false;
+
+        {
+            // ingredients and products change many slots at once
+            const ItemBatch batch(*this);
+            renewProductList = LuaScript::executeDialogCallback<bool>(*craftingDialog);
+        }
 
         ServerCommandPointer cmd = std::make_shared<CraftingDialogCraftingCompleteTC>(dialogId);
         Connection->addCommand(cmd);
@@ -2729,28 +2727,30 @@ void Player::startCrafting(uint8_t stillToCraft, uint16_t craftingTime, uint16_t
     Connection->addCommand(cmd);
 }
 
-void Player::invalidateDialogs() {
-    for (const auto &dialog : dialogs) {
-        if (dialog.second) {
-            ServerCommandPointer cmd = std::make_shared<CloseDialogTC>(dialog.first);
-            Connection->addCommand(cmd);
-        }
+auto Player::openDialog(std::shared_ptr<Dialog> dialog) -> DialogTable::Id {
+    const auto opened = dialogs.open(std::move(dialog));
+
+    if (opened.expired) {
+        Connection->addCommand(std::make_shared<CloseDialogTC>(opened.expiredId));
     }
 
-    dialogs.clear();
+    return opened.id;
+}
+
+void Player::invalidateDialogs() {
+    // releases the Lua callbacks, which must not outlive their Lua state
+    for (const auto dialogId : dialogs.closeIf([](const Dialog & /*dialog*/) { return true; })) {
+        Connection->addCommand(std::make_shared<CloseDialogTC>(dialogId));
+    }
 }
 
 void Player::closeDialogsOnMove() {
-    for (auto it = dialogs.begin(); it != dialogs.end();) {
-        if (it->second && it->second->closeOnMove()) {
-            ServerCommandPointer cmd = std::make_shared<CloseDialogTC>(it->first);
-            Connection->addCommand(cmd);
-            it = dialogs.erase(it);
-        } else if (!it->second) {
-            it = dialogs.erase(it);
-        } else {
-            ++it;
-        }
+    if (dialogs.size() == 0) {
+        return;
+    }
+
+    for (const auto dialogId : dialogs.closeIf([](const Dialog &dialog) { return dialog.closeOnMove(); })) {
+        Connection->addCommand(std::make_shared<CloseDialogTC>(dialogId));
     }
 }
 
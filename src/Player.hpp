@@ -21,20 +21,29 @@
 
 #include "Character.hpp"
 #include "Item.hpp"
+#include "MpscQueue.hpp"
+#include "NewClientView.hpp"
+#include "PlayerSnapshot.hpp"
 #include "Showcase.hpp"
+#include "dialog/DialogTable.hpp"
 #include "dialog/MerchantDialog.hpp"
 #include "dialog/SelectionDialog.hpp"
 #include "netinterface/BasicServerCommand.hpp"
 #include "netinterface/NetInterface.hpp"
+#include "netinterface/protocol/ServerCommands.hpp"
 #include "script/LuaScript.hpp"
 
+#include <atomic>
+#include <bitset>
 #include <chrono>
+#include <map>
 #include <memory>
 #include <queue>
 #include <set>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 struct WeatherStruct;
 class Dialog;
@@ -87,6 +96,8 @@ public:
     auto to_string() const -> std::string override;
 
     void workoutCommands();
+    // queueing and performing time per command id, split into immediate and AP gated commands, one line per id
+    static auto commandLatencies() -> std::vector<std::string>;
     void checkFightMode();
 
     std::shared_ptr<NetInterface> Connection;
@@ -135,13 +146,27 @@ public:
     auto getScreenRange() const -> Coordinate override;
 
 private:
-    std::set<uint32_t> visibleChars;
-    std::unordered_set<TYPE_OF_CHARACTER_ID> knownPlayers;
-    std::unordered_map<TYPE_OF_CHARACTER_ID, std::string> namedPlayers;
+    // sorted, a player sees few enough characters for a flat vector to beat a tree
+    std::vector<TYPE_OF_CHARACTER_ID> visibleChars;
+    std::vector<MultiMoveTC::Move> queuedMoves;
+    // latest move of each far character, sent once farMovesDue has passed
+    std::vector<MultiMoveTC::Move> farMoves;
+    std::chrono::steady_clock::time_point farMovesDue{};
+    PlayerSnapshot::KnownPlayers knownPlayers;
+    PlayerSnapshot::NamedPlayers namedPlayers;
+    // first name of playerId or later
+    [[nodiscard]] auto findName(TYPE_OF_CHARACTER_ID playerId) const -> PlayerSnapshot::NamedPlayers::const_iterator;
+    // stripe key to fingerprint of the stripes this client holds, see map_delta_updates
+    std::unordered_map<uint64_t, uint64_t> heldStripes;
+    static constexpr size_t maxHeldStripes = 2048;
+    // handed over by the io threads, the game thread sorts them into the lists below
+    static constexpr size_t maxReceivedCommands = 256;
+    MpscQueue<ClientCommandPointer, maxReceivedCommands> receivedCommands;
     using CLIENTCOMMANDLIST = std::queue<ClientCommandPointer>;
     CLIENTCOMMANDLIST immediateCommands;
     CLIENTCOMMANDLIST queuedCommands;
-    std::mutex commandMutex;
+    // whether this player is announced to World for having commands to work out
+    std::atomic_bool commandsAnnounced{false};
 
 public:
     void receiveCommand(const ClientCommandPointer &cmd);
@@ -164,6 +189,11 @@ public:
     // removes a Char from sight
     void sendCharRemove(TYPE_OF_CHARACTER_ID id, const ServerCommandPointer &removechar);
 
+    // takes a move of another character for flushCharacterMoves if multi_move_updates is set or the character is
+    // far, see far_update_radius; returns false if the move is to be sent right away
+    auto queueCharacterMove(const MultiMoveTC::Move &move, bool far) -> bool;
+    void flushCharacterMoves();
+
     /**
      *a long time needed action for the player
      */
@@ -230,14 +260,17 @@ public:
     // testing constructor
     Player() = default;
 
+    // attaches the connection of a reconnecting client to a suspended player
+    void resume(std::shared_ptr<NetInterface> newConnection);
+
     //! check if username/password is ok
     void check_logindata();
 
     // Checks if a Player has a special GM right
     auto hasGMRight(gm_rights right) const -> bool;
 
-    //! save char to db
-    auto save() noexcept -> bool;
+    // copies the persistent state for the save thread and marks it saved, game thread only unless logged out
+    auto snapshot() -> PlayerSnapshot;
 
     //! load data from db
     // \param no_attributes don't load contents of table "player"
@@ -266,6 +299,11 @@ public:
      */
     void sendDirStripe(viewdir direction, bool extraStripeForDiagonalMove);
 
+    /**
+     * sends a stripe, unless the client still holds it unchanged
+     */
+    void sendViewStripe(const NewClientView::Stripe &stripe);
+
     void sendStepStripes(direction dir);
 
     void sendField(const position &pos);
@@ -293,6 +331,8 @@ public:
     void closeAllShowcasesOfMapContainers();
     void closeAllShowcases();
     void lookIntoShowcaseContainer(uint8_t showcase, unsigned char pos);
+    // counts a look-at that would run a script, false once the player exceeds look_at_scripts_per_second
+    auto mayRunLookAtScript() -> bool;
     auto lookIntoBackPack() -> bool;
     auto lookIntoContainerOnField(direction dir) -> bool;
 
@@ -330,7 +370,7 @@ public:
      */
     void sendWeather(WeatherStruct weather);
 
-    void ageInventory() override;
+    void inventoryAged(const InventoryAgeing &ageing) override;
 
     auto createItem(Item::id_type id, Item::number_type number, Item::quality_type quality,
                     script_data_exchangemap const *data) -> int override;
@@ -368,6 +408,9 @@ public:
     //! schickt ein Update der Ansicht des Rucksackinhalts an den Client
     void updateBackPackView();
 
+    void beginItemBatch() override;
+    void endItemBatch() override;
+
     //! sendet alle Namen der Skills des Player mit den entsprechenden Typen/Werten an den Client
     void sendAllSkills();
 
@@ -432,6 +475,8 @@ public:
 
     // player heard something
     void receiveText(talk_type tt, const std::string &message, Character *cc) override;
+    // what players hear, one command serves all players hearing the same text
+    static auto talkCommand(talk_type tt, const position &pos, const std::string &message) -> ServerCommandPointer;
 
     auto knows(Player *player) const -> bool;
     void getToKnow(Player *player);
@@ -450,6 +495,7 @@ public:
     auto forceWarp(const position &newPos) -> bool override;
 
     void openDepot(const ScriptItem &item);
+    void loadDepot(uint32_t depotid) override;
 
     void setQuestProgress(TYPE_OF_QUEST_ID questid, TYPE_OF_QUESTSTATUS progress) override;
     void sendAvailableQuests();
@@ -460,34 +506,21 @@ public:
 private:
     void handleWarp();
 
-    static constexpr auto dialogLimit = 100;
-
     template <class DialogType, class DialogCommandType> void requestDialog(DialogType *dialog) {
         if (dialog == nullptr) {
             LuaScript::triggerScriptError("Dialog must not be nil!");
         }
 
-        if (dialogs.size() < dialogLimit) {
-            unsigned int dialogId = dialogCounter;
-
-            while (dialogs.find(dialogId) != dialogs.end()) {
-                ++dialogId;
-            }
-
-            dialogs[dialogId] = std::make_shared<DialogType>(*dialog);
-            ServerCommandPointer cmd = std::make_shared<DialogCommandType>(*dialog, dialogId);
-            Connection->addCommand(cmd);
-        } else {
-            inform("ERROR: Unable to open more than 100 dialogs.");
-        }
+        const auto dialogId = openDialog(std::make_shared<DialogType>(*dialog));
+        ServerCommandPointer cmd = std::make_shared<DialogCommandType>(*dialog, dialogId);
+        Connection->addCommand(cmd);
     }
 
+    // closes the oldest dialog on the client if it had to expire to make room
+    auto openDialog(std::shared_ptr<Dialog> dialog) -> DialogTable::Id;
+
     template <class DialogType> auto getDialog(unsigned int dialogId) const -> std::shared_ptr<DialogType> {
-        try {
-            return std::dynamic_pointer_cast<DialogType>(dialogs.at(dialogId));
-        } catch (std::out_of_range &e) {
-            return std::shared_ptr<DialogType>();
-        }
+        return std::dynamic_pointer_cast<DialogType>(dialogs.get(dialogId));
     }
 
 public:
@@ -524,11 +557,17 @@ public:
     void logAdmin(const std::string &message) override;
 
 private:
+    void sendAttributeUpdates(uint32_t changed) override;
+    [[nodiscard]] static auto commandEncoding() -> CommandEncoding;
+
     void startCrafting(uint8_t stillToCraft, uint16_t craftingTime, uint16_t sfx, uint16_t sfxDuration,
                        uint32_t dialogId);
 
     Language _player_language{};
 
+    std::chrono::steady_clock::time_point lookAtSecond{};
+    uint16_t lookAtScriptsThisSecond = 0;
+
     // Status of the player, Okay, waiting authroization, jailed, banned, etc..
     unsigned char status{};
 
@@ -555,6 +594,12 @@ private:
 
     LoadLevel loadLevel = LoadLevel::unburdened;
 
+    // updates held back by an item batch
+    int itemBatchDepth = 0;
+    std::bitset<MAX_BELT_SLOTS + MAX_BODY_ITEMS> batchedSlots;
+    bool batchedBackPack = false;
+    bool batchedBurden = false;
+
     bool monitoringClient{};
 
     const uint8_t BACKPACK_SHOWCASE = 0;
@@ -562,13 +607,24 @@ private:
     using ShowcaseMap = std::unordered_map<uint8_t, std::unique_ptr<Showcase>>;
     ShowcaseMap showcases;
 
-    unsigned int dialogCounter{};
-    using DialogMap = std::unordered_map<unsigned int, std::shared_ptr<Dialog>>;
-    DialogMap dialogs;
+    DialogTable dialogs;
+
+    struct QuestProgress {
+        TYPE_OF_QUESTSTATUS progress = 0;
+        int time = 0;
+        // not saved yet
+        bool dirty = false;
+    };
 
-    using QuestStatusTimePair = std::pair<TYPE_OF_QUESTSTATUS, int>;
-    using QuestMap = std::unordered_map<TYPE_OF_QUEST_ID, QuestStatusTimePair>;
+    using QuestMap = std::unordered_map<TYPE_OF_QUEST_ID, QuestProgress>;
     QuestMap quests;
+
+    // item lines of the depots left in the database at login, by depot id, until the depot is first used
+    std::map<uint32_t, std::vector<int32_t>> unloadedDepots;
+    // lines the database held for depots that were loaded since login
+    std::set<int32_t> releasedItemLines;
+    // ageings the unloaded depots missed, caught up when one is loaded
+    uint32_t inventoryAgeings{};
 };
 
 #endif
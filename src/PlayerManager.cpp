@@ -23,20 +23,22 @@
 #include "LongTimeAction.hpp"
 #include "MonitoringClients.hpp"
 #include "Player.hpp"
+#include "ThreadAffinity.hpp"
 #include "World.hpp"
 #include "main_help.hpp"
 #include "netinterface/protocol/BBIWIServerCommands.hpp"
 #include "netinterface/protocol/ClientCommands.hpp"
 #include "netinterface/protocol/ServerCommands.hpp"
 #include "script/LuaLogoutScript.hpp"
+#include "tuningConstants.hpp"
 
-#include <chrono>
+#include <algorithm>
 #include <memory>
-#include <range/v3/all.hpp>
+#include <vector>
 
 std::unique_ptr<PlayerManager> PlayerManager::instance = nullptr;
 std::mutex PlayerManager::mut;
-std::mutex PlayerManager::reloadmutex;
+std::shared_mutex PlayerManager::reloadmutex;
 
 auto PlayerManager::get() -> PlayerManager & {
     if (!instance) {
@@ -46,21 +48,108 @@ auto PlayerManager::get() -> PlayerManager & {
     return *instance;
 }
 
-void PlayerManager::activate() {
-    running = true;
+void PlayerManager::startLogins() {
+    const auto loginThreads = std::max<uint16_t>(Config::instance().login_threads, 1);
 
-    login_thread = std::make_unique<std::thread>(loginLoop, this);
-    save_thread = std::make_unique<std::thread>(playerSaveLoop, this);
+    for (uint16_t i = 0; i < loginThreads; ++i) {
+        login_threads.emplace_back(loginLoop, this);
+    }
+}
+
+void PlayerManager::activate() { save_thread = std::make_unique<std::thread>(playerSaveLoop, this); }
+
+void PlayerManager::openLogins() {
+    std::lock_guard<std::mutex> lock(mut);
+    loginsOpen = true;
+    Logger::info(LogFacility::Player) << "logins open, " << waitingLogins.size() << " waiting" << Log::end;
+}
+
+void PlayerManager::admitWaitingLogins() {
+    std::vector<std::shared_ptr<NetInterface>> batch;
+
+    {
+        std::lock_guard<std::mutex> lock(mut);
+
+        // the next batch waits until the game thread has taken in the previous one
+        if (!loginsOpen || waitingLogins.empty() || admittedInFlight > 0 || !loggedInPlayers.empty()) {
+            return;
+        }
+
+        while (batch.size() < static_cast<size_t>(MAXPLAYERSPROCESSED) && !waitingLogins.empty()) {
+            auto connection = std::move(waitingLogins.front());
+            waitingLogins.pop_front();
+
+            if (connection->online) {
+                admittedLogins.insert(connection.get());
+                batch.push_back(std::move(connection));
+            }
+        }
+
+        admittedInFlight = batch.size();
+        sendQueuePositions();
+    }
+
+    for (auto &connection : batch) {
+        incon->getNewPlayers().push(std::move(connection));
+    }
+}
+
+auto PlayerManager::holdLogin(const std::shared_ptr<NetInterface> &connection) -> bool {
+    std::lock_guard<std::mutex> lock(mut);
+
+    if (loginsOpen && waitingLogins.empty()) {
+        return false;
+    }
+
+    checkLogin(connection);
+    waitingLogins.push_back(connection);
+    Logger::debug(LogFacility::Player) << "login from " << connection->getIPAdress() << " waits at position "
+                                       << waitingLogins.size() << Log::end;
+    connection->addCommand(std::make_shared<InformTC>(
+            Character::informServer, "The server is starting, you are number " +
+                                             std::to_string(waitingLogins.size()) + " in the queue."));
+    return true;
+}
+
+auto PlayerManager::takeAdmitted(const std::shared_ptr<NetInterface> &connection) -> bool {
+    std::lock_guard<std::mutex> lock(mut);
+
+    return admittedLogins.erase(connection.get()) > 0;
+}
+
+void PlayerManager::sendQueuePositions() const {
+    size_t position = 0;
+
+    for (const auto &connection : waitingLogins) {
+        connection->addCommand(std::make_shared<InformTC>(
+                Character::informServer, "The server is starting, you are number " + std::to_string(++position) +
+                                                 " in the queue."));
+    }
 }
 
 void PlayerManager::stop() {
-    running = false;
+    Logger::info(LogFacility::Other) << "Waiting for login threads to terminate ..." << Log::end;
+    incon->getNewPlayers().close();
+
+    for (auto &thread : login_threads) {
+        thread.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mut);
 
-    Logger::info(LogFacility::Other) << "Waiting for login thread to terminate ..." << Log::end;
-    login_thread->join();
+        for (const auto &connection : waitingLogins) {
+            connection->shutdownSend(std::make_shared<LogOutTC>(SERVERSHUTDOWN));
+        }
+
+        waitingLogins.clear();
+    }
 
-    Logger::info(LogFacility::Other) << "Waiting for player save thread to terminate ..." << Log::end;
-    save_thread->join();
+    if (save_thread) {
+        Logger::info(LogFacility::Other) << "Waiting for player save thread to terminate ..." << Log::end;
+        saveJobs.close();
+        save_thread->join();
+    }
 
     Logger::info(LogFacility::Other) << "Player manager terminated!" << Log::end;
 }
@@ -68,9 +157,86 @@ void PlayerManager::stop() {
 auto PlayerManager::findPlayer(const std::string &name) const -> bool {
     std::lock_guard<std::mutex> lock(mut);
 
-    using namespace ranges;
-    auto hasThisName = [&name](const auto &player) { return player->getName() == name; };
-    return any_of(loggedOutPlayers, hasThisName);
+    return loggedOutNames.count(name) > 0;
+}
+
+void PlayerManager::addLogOutPlayer(Player *player) {
+    player->ltAction->cancelTimers();
+    std::lock_guard<std::mutex> lock(mut);
+    loggedOutNames.insert(player->getName());
+    saveJobs.push({player, nullptr});
+}
+
+void PlayerManager::savePlayer(Player &player) {
+    saveJobs.push({nullptr, std::make_unique<PlayerSnapshot>(player.snapshot())});
+}
+
+void PlayerManager::suspendPlayer(Player *player) {
+    player->ltAction->abortAction();
+    player->closeAllShowcases();
+    savePlayer(*player);
+    const time_t expires = time(nullptr) + Config::instance().session_resume_grace;
+
+    std::lock_guard<std::mutex> lock(mut);
+    suspendedSessions.insert_or_assign(player->getName(), SuspendedSession{player, expires});
+}
+
+void PlayerManager::expireSessions(time_t now) {
+    std::lock_guard<std::mutex> lock(mut);
+
+    for (auto session = suspendedSessions.begin(); session != suspendedSessions.end();) {
+        if (session->second.expires < now) {
+            Logger::info(LogFacility::Player) << "session of " << *session->second.player << " expired" << Log::end;
+            // queued under the same lock, so that no login loads the player before the save is done
+            loggedOutNames.insert(session->first);
+            saveJobs.push({session->second.player, nullptr});
+            session = suspendedSessions.erase(session);
+        } else {
+            ++session;
+        }
+    }
+}
+
+auto PlayerManager::resumeSession(const std::string &name, const std::string &password,
+                                  const std::shared_ptr<NetInterface> &connection) -> Player * {
+    Player *player = nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(mut);
+        const auto session = suspendedSessions.find(name);
+
+        if (session == suspendedSessions.end()) {
+            return nullptr;
+        }
+
+        player = session->second.player;
+
+        // the password of the suspended session stands in for the database check
+        if (player->pw != password) {
+            throw Player::LogoutException(WRONGPWD);
+        }
+
+        if (!player->hasGMRight(gmr_allowlogin) && !World::get()->isLoginAllowed()) {
+            throw Player::LogoutException(SERVERSHUTDOWN);
+        }
+
+        suspendedSessions.erase(session);
+    }
+
+    Logger::info(LogFacility::Player) << "session of " << *player << " resumed" << Log::end;
+    player->resume(connection);
+    return player;
+}
+
+auto PlayerManager::claimLogin(const std::string &name) -> bool {
+    std::lock_guard<std::mutex> lock(mut);
+
+    return loggingInNames.insert(name).second;
+}
+
+void PlayerManager::releaseLogin(const std::string &name) {
+    std::lock_guard<std::mutex> lock(mut);
+    loggingInNames.erase(name);
 }
 
 void PlayerManager::setLoginLogout(bool val) {
@@ -82,82 +248,34 @@ void PlayerManager::setLoginLogout(bool val) {
 }
 
 void PlayerManager::loginLoop(PlayerManager *pmanager) {
+    affinity::pinCurrentThread(Config::instance().login_thread_cores(), "login");
+
     try {
         auto &newplayers = pmanager->incon->getNewPlayers();
         pmanager->threadOk = true;
+        std::shared_ptr<NetInterface> Connection;
+
+        // every login thread wakes up for the next connection whose login command arrived, until the queue is closed
+        while (newplayers.pop(Connection)) {
+            if (Connection) {
+                // held logins come back here once admitted, they must not queue up again
+                const bool admitted = pmanager->takeAdmitted(Connection);
 
-        while (pmanager->running) {
-            // loop must be steered by counter so we parse every connection only one time bevor we getting to the other
-            // loop
-            int curconn = newplayers.size();
-            unsigned short acceptVersion = Config::instance().clientversion;
-
-            for (int i = 0; i < curconn; ++i) {
-                auto Connection = newplayers.pop_front();
-
-                if (Connection) {
-                    try {
-                        if (!Connection->online) {
-                            throw Player::LogoutException(UNSTABLECONNECTION);
-                        }
-
-                        auto loginData = Connection->getLoginData();
-                        if (loginData != nullptr) {
-                            unsigned short int clientversion = loginData->getClientVersion();
-                            if (clientversion == BBIWIClientVersion) {
-                                // TODO handle login for BBIWI Clients...
-                            } else if (clientversion != acceptVersion) {
-                                Logger::error(LogFacility::Player)
-                                        << loginData->getLoginName() << " tried to login with an old client (version "
-                                        << clientversion << ") but version " << acceptVersion << " is required"
-                                        << Log::end;
-                                throw Player::LogoutException(OLDCLIENT);
-                            }
-
-                            // TODO is this check really necessary?
-                            if (loginData->getLoginName().empty() || loginData->getPassword().empty()) {
-                                throw Player::LogoutException(WRONGPWD);
-                            }
-
-                            // player already online?
-                            if ((World::get()->Players.find(loginData->getLoginName()) != nullptr) ||
-                                PlayerManager::get().findPlayer(loginData->getLoginName())) {
-                                Logger::alert(LogFacility::Player)
-                                        << loginData->getLoginName()
-                                        << " tried to login twice from ip: " << Connection->getIPAdress() << Log::end;
-                                throw Player::LogoutException(DOUBLEPLAYER);
-                            }
-
-                            Player *newPlayer = nullptr;
-                            {
-                                std::lock_guard<std::mutex> lock(reloadmutex);
-                                newPlayer = new Player(Connection);
-                            }
-
-                            pmanager->loggedInPlayers.push_back(newPlayer);
-                            World::get()->scheduler.signalNewPlayerAction();
-
-                            Connection.reset();
-                        } else {
-                            if (Connection->nextInactive()) {
-                                throw Player::LogoutException(UNSTABLECONNECTION);
-                            }
-
-                            newplayers.push_back(Connection);
-                            Connection.reset();
-                        }
-                    } catch (Player::LogoutException &e) {
-                        ServerCommandPointer cmd = std::make_shared<LogOutTC>(e.getReason());
-                        Connection->shutdownSend(cmd);
+                try {
+                    if (admitted || !pmanager->holdLogin(Connection)) {
+                        loginPlayer(pmanager, Connection);
                     }
-                } else {
-                    Connection.reset();
+                } catch (Player::LogoutException &e) {
+                    Connection->shutdownSend(std::make_shared<LogOutTC>(e.getReason()));
                 }
 
-            } // get new players
+                // the last of a batch lets the game thread admit the next one
+                if (admitted && --pmanager->admittedInFlight == 0) {
+                    World::get()->scheduler.signal();
+                }
+            }
 
-            using namespace std::chrono_literals;
-            std::this_thread::sleep_for(100ms);
+            Connection.reset();
         }
     } catch (std::exception &e) {
     } catch (...) {
@@ -165,40 +283,117 @@ void PlayerManager::loginLoop(PlayerManager *pmanager) {
     }
 }
 
+void PlayerManager::checkLogin(const std::shared_ptr<NetInterface> &Connection) {
+    unsigned short acceptVersion = Config::instance().clientversion;
+
+    if (!Connection->online) {
+        throw Player::LogoutException(UNSTABLECONNECTION);
+    }
+
+    auto loginData = Connection->getLoginData();
+    unsigned short int clientversion = loginData->getClientVersion();
+    if (clientversion == BBIWIClientVersion) {
+        // TODO handle login for BBIWI Clients...
+    } else if (clientversion != acceptVersion) {
+        Logger::error(LogFacility::Player)
+                << loginData->getLoginName() << " tried to login with an old client (version " << clientversion
+                << ") but version " << acceptVersion << " is required" << Log::end;
+        throw Player::LogoutException(OLDCLIENT);
+    }
+
+    // TODO is this check really necessary?
+    if (loginData->getLoginName().empty() || loginData->getPassword().empty()) {
+        throw Player::LogoutException(WRONGPWD);
+    }
+}
+
+void PlayerManager::loginPlayer(PlayerManager *pmanager, const std::shared_ptr<NetInterface> &Connection) {
+    try {
+        checkLogin(Connection);
+        auto loginData = Connection->getLoginData();
+        const auto &name = loginData->getLoginName();
+
+        // player already online or being loaded by another login thread?
+        if ((World::get()->Players.find(name) != nullptr) || PlayerManager::get().findPlayer(name) ||
+            !pmanager->claimLogin(name)) {
+            Logger::alert(LogFacility::Player)
+                    << name << " tried to login twice from ip: " << Connection->getIPAdress() << Log::end;
+            throw Player::LogoutException(DOUBLEPLAYER);
+        }
+
+        try {
+            Player *newPlayer = pmanager->resumeSession(name, loginData->getPassword(), Connection);
+
+            if (newPlayer == nullptr) {
+                std::shared_lock<std::shared_mutex> lock(reloadmutex);
+                newPlayer = new Player(Connection);
+            }
+
+            pmanager->loggedInPlayers.push(newPlayer);
+        } catch (...) {
+            pmanager->releaseLogin(name);
+            throw;
+        }
+
+        pmanager->releaseLogin(name);
+        World::get()->scheduler.signal();
+    } catch (Player::LogoutException &e) {
+        ServerCommandPointer cmd = std::make_shared<LogOutTC>(e.getReason());
+        Connection->shutdownSend(cmd);
+    }
+}
+
 void PlayerManager::playerSaveLoop(PlayerManager *pmanager) {
+    affinity::pinCurrentThread(Config::instance().database_thread_cores(), "database");
+
     try {
         World *world = World::get();
         pmanager->threadOk = true;
-        Player *tmpPl = nullptr;
-
-        while (pmanager->running || !pmanager->loggedOutPlayers.empty()) {
-            if (!pmanager->loggedOutPlayers.empty()) {
-                while (!pmanager->loggedOutPlayers.empty()) {
-                    tmpPl = pmanager->loggedOutPlayers.front();
-
-                    if (!tmpPl->isMonitoringClient()) {
-                        {
-                            std::lock_guard<std::mutex> lock(reloadmutex);
-                            tmpPl->save();
-                        }
-                        tmpPl->Connection->closeConnection();
-                        ServerCommandPointer cmd = std::make_shared<BBLogOutTC>(tmpPl->getId());
-                        world->monitoringClientList->sendCommand(cmd);
-                        delete tmpPl;
-                        tmpPl = nullptr;
-                    } else {
-                        tmpPl->Connection->closeConnection();
-                        delete tmpPl;
-                        tmpPl = nullptr;
+        std::vector<SaveJob> jobs;
+        std::unordered_map<TYPE_OF_CHARACTER_ID, size_t> latestJobs;
+
+        // wakes up for every batch of save jobs, until the queue is closed and empty
+        while (pmanager->saveJobs.drain(jobs)) {
+            // a later job for the same player makes an earlier snapshot obsolete
+            for (size_t i = 0; i < jobs.size(); ++i) {
+                latestJobs[jobs[i].snapshot ? jobs[i].snapshot->id : jobs[i].loggedOut->getId()] = i;
+            }
+
+            for (size_t i = 0; i < jobs.size(); ++i) {
+                if (auto &snapshot = jobs[i].snapshot) {
+                    if (latestJobs[snapshot->id] == i) {
+                        pmanager->saveSnapshot(std::move(*snapshot));
                     }
 
-                    std::lock_guard<std::mutex> lock(mut);
-                    pmanager->loggedOutPlayers.pop_front();
+                    continue;
+                }
+
+                auto *tmpPl = jobs[i].loggedOut;
+                const auto name = tmpPl->getName();
+
+                if (!tmpPl->isMonitoringClient()) {
+                    PlayerSnapshot snapshot;
+                    {
+                        std::shared_lock<std::shared_mutex> lock(reloadmutex);
+                        snapshot = tmpPl->snapshot();
+                    }
+                    pmanager->saveSnapshot(std::move(snapshot));
+                    pmanager->savedSnapshots.erase(tmpPl->getId());
+                    tmpPl->Connection->closeConnection();
+                    ServerCommandPointer cmd = std::make_shared<BBLogOutTC>(tmpPl->getId());
+                    world->monitoringClientList->sendCommand(cmd);
+                    delete tmpPl;
+                } else {
+                    tmpPl->Connection->closeConnection();
+                    delete tmpPl;
                 }
+
+                std::lock_guard<std::mutex> lock(mut);
+                pmanager->loggedOutNames.erase(pmanager->loggedOutNames.find(name));
             }
 
-            using namespace std::chrono_literals;
-            std::this_thread::sleep_for(100ms);
+            jobs.clear();
+            latestJobs.clear();
         }
 
     } catch (std::exception &e) {
@@ -206,3 +401,15 @@ void PlayerManager::playerSaveLoop(PlayerManager *pmanager) {
         throw;
     }
 }
+
+void PlayerManager::saveSnapshot(PlayerSnapshot snapshot) {
+    const auto saved = savedSnapshots.find(snapshot.id);
+    const PlayerSnapshot *previous = saved != savedSnapshots.end() ? &saved->second : nullptr;
+
+    if (snapshot.save(previous)) {
+        savedSnapshots.insert_or_assign(snapshot.id, std::move(snapshot));
+    } else {
+        // the database state is unknown, so the next save writes everything
+        savedSnapshots.erase(snapshot.id);
+    }
+}
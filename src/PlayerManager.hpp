@@ -19,21 +19,38 @@
 #ifndef PLAYERMANAGER_HPP
 #define PLAYERMANAGER_HPP
 
+#include "ConcurrentQueue.hpp"
 #include "InitialConnection.hpp"
-#include "thread_safe_vector.hpp"
+#include "PlayerSnapshot.hpp"
 
 #include <atomic>
+#include <ctime>
+#include <deque>
+#include <limits>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <string>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
+class NetInterface;
 class Player;
 
 class PlayerManager {
 public:
     static auto get() -> PlayerManager &;
 
+    // starts the login threads, logins are held in the warmup queue until openLogins
+    void startLogins();
+    // starts the save thread, needs the world
     void activate();
+    // admits held logins through admitWaitingLogins and new ones right away once the queue has emptied
+    void openLogins();
+    // hands the next batch of held logins to the login threads once the previous one is in, game thread only
+    void admitWaitingLogins();
     void stop();
 
     [[nodiscard]] auto threadOK() const -> bool { return threadOk; }
@@ -42,29 +59,49 @@ public:
 
     static void setLoginLogout(bool val);
 
-    using TPLAYERVECTOR = thread_safe_vector<Player *>;
+    using TPLAYERVECTOR = ConcurrentQueue<Player *>;
 
-    auto getLogOutPlayers() -> TPLAYERVECTOR & { return loggedOutPlayers; }
+    // queues player for saving and deletion
+    void addLogOutPlayer(Player *player);
+    // queues the current state of a player who stays online for saving, game thread only
+    void savePlayer(Player &player);
+    // keeps a disconnected player loaded for session_resume_grace seconds, game thread only
+    void suspendPlayer(Player *player);
+    // queues the suspended players whose grace ended before now for saving and deletion, all by default
+    void expireSessions(time_t now = std::numeric_limits<time_t>::max());
     auto getLogInPlayers() -> TPLAYERVECTOR & { return loggedInPlayers; }
 
 private:
     static std::unique_ptr<PlayerManager> instance;
 
     /**
-     * loop which is threaded to get new connections
+     * loop run by each login thread to get new connections
      * create players, or storing data and deleting old connections
      */
     static void loginLoop(PlayerManager *pmanager);
+    static void loginPlayer(PlayerManager *pmanager, const std::shared_ptr<NetInterface> &connection);
+    // rejects logins which cannot succeed without loading anything
+    static void checkLogin(const std::shared_ptr<NetInterface> &connection);
+    // queues a login while the server is starting or earlier logins still wait, returns whether it was held
+    auto holdLogin(const std::shared_ptr<NetInterface> &connection) -> bool;
+    // whether the connection was handed over by admitWaitingLogins
+    auto takeAdmitted(const std::shared_ptr<NetInterface> &connection) -> bool;
+    // tells every held login its place in the queue, needs mut
+    void sendQueuePositions() const;
     static void playerSaveLoop(PlayerManager *pmanager);
+    void saveSnapshot(PlayerSnapshot snapshot);
     static std::mutex mut;
 
-    // Mutex der gesetzt wird beim reloaden. (Als multi read single write lock)
-    static std::mutex reloadmutex;
+    // shared by logins and saves, held exclusively while reloading
+    static std::shared_mutex reloadmutex;
 
-    /**
-     * true if the thread is running
-     */
-    std::atomic_bool running = false;
+    // reserves a name for one login thread at a time
+    auto claimLogin(const std::string &name) -> bool;
+    void releaseLogin(const std::string &name);
+
+    // hands a suspended player to a new connection with the same credentials, nullptr if none is suspended
+    auto resumeSession(const std::string &name, const std::string &password,
+                       const std::shared_ptr<NetInterface> &connection) -> Player *;
 
     /**
      * if false the thread was exited correctly
@@ -76,10 +113,56 @@ private:
      */
     // CInitialConnection::TVECTORPLAYER shutdownConnections;
 
+    struct SaveJob {
+        // player who is not on the main map anymore, to be saved and deleted
+        Player *loggedOut = nullptr;
+        // otherwise a player still online
+        std::unique_ptr<PlayerSnapshot> snapshot;
+    };
+
+    ConcurrentQueue<SaveJob> saveJobs;
+
     /**
-     * player which are not on the main map anymore
+     * last snapshot written for each online player, only used by the save thread
      */
-    TPLAYERVECTOR loggedOutPlayers;
+    std::unordered_map<TYPE_OF_CHARACTER_ID, PlayerSnapshot> savedSnapshots;
+
+    /**
+     * names of the logged out players in saveJobs, guarded by mut
+     */
+    std::unordered_multiset<std::string> loggedOutNames;
+
+    /**
+     * names of the players currently loaded by a login thread, guarded by mut
+     */
+    std::unordered_set<std::string> loggingInNames;
+
+    struct SuspendedSession {
+        Player *player = nullptr;
+        time_t expires = 0;
+    };
+
+    /**
+     * disconnected players waiting for a reconnect by name, guarded by mut
+     */
+    std::unordered_map<std::string, SuspendedSession> suspendedSessions;
+
+    /**
+     * logins in order of arrival held while the server starts, guarded by mut
+     */
+    std::deque<std::shared_ptr<NetInterface>> waitingLogins;
+
+    /**
+     * held logins handed to the login threads and not yet picked up, guarded by mut
+     */
+    std::unordered_set<const NetInterface *> admittedLogins;
+
+    /**
+     * admitted logins which are not loaded yet
+     */
+    std::atomic<size_t> admittedInFlight = 0;
+
+    bool loginsOpen = false; // guarded by mut
 
     /**
      * players which are logged in and correctly loaded
@@ -91,7 +174,7 @@ private:
      */
     std::shared_ptr<InitialConnection> incon = InitialConnection::create();
 
-    std::unique_ptr<std::thread> login_thread = nullptr;
+    std::vector<std::thread> login_threads;
     std::unique_ptr<std::thread> save_thread = nullptr;
 };
 
@@ -0,0 +1,491 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "PlayerSnapshot.hpp"
+
+#include "Logger.hpp"
+#include "db/Connection.hpp"
+#include "db/ConnectionManager.hpp"
+#include "db/DeleteQuery.hpp"
+#include "db/InsertQuery.hpp"
+#include "db/PreparedQuery.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using namespace Database;
+
+template <typename Key> auto keyOf(const Key &key) -> const Key & { return key; }
+
+template <typename Key, typename Value> auto keyOf(const std::pair<Key, Value> &entry) -> const Key & {
+    return entry.first;
+}
+
+template <typename Key> struct Changes {
+    std::vector<std::remove_const_t<Key>> removed;
+    // added or altered
+    std::vector<std::remove_const_t<Key>> changed;
+};
+
+// without previous rows every row counts as changed
+template <typename Rows>
+auto changesOf(const Rows &current, const Rows *previous) -> Changes<typename Rows::key_type> {
+    Changes<typename Rows::key_type> changes;
+
+    for (const auto &row : current) {
+        if (previous == nullptr) {
+            changes.changed.push_back(keyOf(row));
+            continue;
+        }
+
+        const auto other = previous->find(keyOf(row));
+
+        if (other == previous->end() || !(*other == row)) {
+            changes.changed.push_back(keyOf(row));
+        }
+    }
+
+    if (previous != nullptr) {
+        for (const auto &row : *previous) {
+            if (current.count(keyOf(row)) == 0) {
+                changes.removed.push_back(keyOf(row));
+            }
+        }
+    }
+
+    return changes;
+}
+
+// the same for rows sorted by key, merged in one pass
+template <typename Row>
+auto changesOf(const std::vector<Row> &current, const std::vector<Row> *previous)
+        -> Changes<std::decay_t<decltype(keyOf(current.front()))>> {
+    Changes<std::decay_t<decltype(keyOf(current.front()))>> changes;
+
+    if (previous == nullptr) {
+        for (const auto &row : current) {
+            changes.changed.push_back(keyOf(row));
+        }
+
+        return changes;
+    }
+
+    auto now = current.begin();
+    auto before = previous->begin();
+
+    while (now != current.end() || before != previous->end()) {
+        if (before == previous->end() || (now != current.end() && keyOf(*now) < keyOf(*before))) {
+            changes.changed.push_back(keyOf(*now++));
+        } else if (now == current.end() || keyOf(*before) < keyOf(*now)) {
+            changes.removed.push_back(keyOf(*before++));
+        } else {
+            if (!(*now == *before)) {
+                changes.changed.push_back(keyOf(*now));
+            }
+
+            ++now;
+            ++before;
+        }
+    }
+
+    return changes;
+}
+
+// removes all rows of the player without keys, otherwise only those with the given keys
+template <typename Key>
+void deleteRows(const PConnection &connection, const std::string &table, const std::string &playerColumn,
+                TYPE_OF_CHARACTER_ID player, const std::string &keyColumn, const std::vector<Key> *keys) {
+    if (keys != nullptr && keys->empty()) {
+        return;
+    }
+
+    DeleteQuery query(connection);
+    query.addEqualCondition<TYPE_OF_CHARACTER_ID>(table, playerColumn, player);
+
+    if (keys != nullptr) {
+        query.addInCondition<Key>(table, keyColumn, *keys);
+    }
+
+    query.setServerTable(table);
+    query.execute();
+}
+
+// removes all rows of the player except those with the given keys
+template <typename Key>
+void deleteRowsExcept(const PConnection &connection, const std::string &table, const std::string &playerColumn,
+                      TYPE_OF_CHARACTER_ID player, const std::string &keyColumn, const std::set<Key> &kept) {
+    DeleteQuery query(connection);
+    query.addEqualCondition<TYPE_OF_CHARACTER_ID>(table, playerColumn, player);
+
+    if (!kept.empty()) {
+        query.addNotInCondition<Key>(table, keyColumn, std::vector<Key>(kept.begin(), kept.end()));
+    }
+
+    query.setServerTable(table);
+    query.execute();
+}
+
+void saveIntroductions(const PConnection &connection, const PlayerSnapshot &snapshot,
+                       const PlayerSnapshot *previous) {
+    const auto changes = changesOf(snapshot.knownPlayers, previous ? &previous->knownPlayers : nullptr);
+    deleteRows(connection, "introduction", "intro_player", snapshot.id, "intro_known_player",
+               previous ? &changes.removed : nullptr);
+
+    InsertQuery query(connection);
+    const InsertQuery::columnIndex playerColumn = query.addColumn("intro_player");
+    const InsertQuery::columnIndex knownPlayerColumn = query.addColumn("intro_known_player");
+    query.addServerTable("introduction");
+    query.addValues<TYPE_OF_CHARACTER_ID>(knownPlayerColumn, changes.changed);
+    query.addValues<TYPE_OF_CHARACTER_ID>(playerColumn, snapshot.id, InsertQuery::FILL);
+    query.updateOnConflict({"intro_player", "intro_known_player"}, {});
+    query.execute();
+}
+
+void saveNames(const PConnection &connection, const PlayerSnapshot &snapshot, const PlayerSnapshot *previous) {
+    const auto changes = changesOf(snapshot.namedPlayers, previous ? &previous->namedPlayers : nullptr);
+    deleteRows(connection, "naming", "name_player", snapshot.id, "name_named_player",
+               previous ? &changes.removed : nullptr);
+
+    InsertQuery query(connection);
+    const InsertQuery::columnIndex playerColumn = query.addColumn("name_player");
+    const InsertQuery::columnIndex namedPlayerColumn = query.addColumn("name_named_player");
+    const InsertQuery::columnIndex playerNameColumn = query.addColumn("name_player_name");
+    query.addServerTable("naming");
+
+    // changes come in the order of the names
+    auto name = snapshot.namedPlayers.begin();
+
+    for (const auto namedPlayer : changes.changed) {
+        while (name->first != namedPlayer) {
+            ++name;
+        }
+
+        query.addValue<TYPE_OF_CHARACTER_ID>(namedPlayerColumn, namedPlayer);
+        query.addValue<std::string>(playerNameColumn, name->second);
+    }
+
+    query.addValues<TYPE_OF_CHARACTER_ID>(playerColumn, snapshot.id, InsertQuery::FILL);
+    query.updateOnConflict({"name_player", "name_named_player"}, {"name_player_name"});
+    query.execute();
+}
+
+void saveCharacter(const PConnection &connection, const PlayerSnapshot &snapshot) {
+    if (snapshot.status != 0) {
+        static const PreparedQuery query("save_character_status",
+                                         "UPDATE {server}.chars SET chr_status = $1, chr_lastip = $2, "
+                                         "chr_onlinetime = $3, chr_lastsavetime = $4, chr_statustime = $5, "
+                                         "chr_statusgm = $6, chr_statusreason = $7 WHERE chr_playerid = $8");
+        query.execute(connection, snapshot.status, snapshot.lastIp, snapshot.onlineTime, snapshot.saveTime,
+                      snapshot.statusTime, snapshot.statusGm, snapshot.statusReason, snapshot.id);
+    } else {
+        static const PreparedQuery query("save_character",
+                                         "UPDATE {server}.chars SET chr_status = $1, chr_lastip = $2, "
+                                         "chr_onlinetime = $3, chr_lastsavetime = $4, chr_statustime = NULL, "
+                                         "chr_statusgm = NULL, chr_statusreason = NULL WHERE chr_playerid = $5");
+        query.execute(connection, snapshot.status, snapshot.lastIp, snapshot.onlineTime, snapshot.saveTime,
+                      snapshot.id);
+    }
+}
+
+void savePlayer(const PConnection &connection, const PlayerSnapshot &snapshot) {
+    static const PreparedQuery query(
+            "save_player",
+            "UPDATE {server}.player SET ply_posx = $1, ply_posy = $2, ply_posz = $3, ply_faceto = $4, "
+            "ply_hitpoints = $5, ply_mana = $6, ply_foodlevel = $7, ply_lifestate = $8, ply_magictype = $9, "
+            "ply_magicflagsmage = $10, ply_magicflagspriest = $11, ply_magicflagsbard = $12, "
+            "ply_magicflagsdruid = $13, ply_poison = $14, ply_mental_capacity = $15, ply_hair = $16, "
+            "ply_beard = $17, ply_hairred = $18, ply_hairgreen = $19, ply_hairblue = $20, ply_hairalpha = $21, "
+            "ply_skinred = $22, ply_skingreen = $23, ply_skinblue = $24, ply_skinalpha = $25 "
+            "WHERE ply_playerid = $26");
+    const auto &player = snapshot.player;
+    query.execute(connection, player.x, player.y, player.z, player.faceTo, player.hitpoints, player.mana,
+                  player.foodlevel, player.lifestate, player.magicType, player.magicFlags[0], player.magicFlags[1],
+                  player.magicFlags[2], player.magicFlags[3], player.poison, player.mentalCapacity, player.hair,
+                  player.beard, player.hairColour[0], player.hairColour[1], player.hairColour[2],
+                  player.hairColour[3], player.skinColour[0], player.skinColour[1], player.skinColour[2],
+                  player.skinColour[3], snapshot.id);
+}
+
+void saveSkills(const PConnection &connection, const PlayerSnapshot &snapshot, const PlayerSnapshot *previous) {
+    const auto changes = changesOf(snapshot.skills, previous ? &previous->skills : nullptr);
+    // quoted as numbers, not as characters
+    const std::vector<uint16_t> removed(changes.removed.begin(), changes.removed.end());
+    deleteRows(connection, "playerskills", "psk_playerid", snapshot.id, "psk_skill_id", previous ? &removed : nullptr);
+
+    InsertQuery query(connection);
+    const InsertQuery::columnIndex playerIdColumn = query.addColumn("psk_playerid");
+    const InsertQuery::columnIndex skillIdColumn = query.addColumn("psk_skill_id");
+    const InsertQuery::columnIndex valueColumn = query.addColumn("psk_value");
+    const InsertQuery::columnIndex minorColumn = query.addColumn("psk_minor");
+
+    for (const auto skill : changes.changed) {
+        const auto &[major, minor] = snapshot.skills.at(skill);
+        query.addValue<uint16_t>(skillIdColumn, skill);
+        query.addValue<uint16_t>(valueColumn, major);
+        query.addValue<uint16_t>(minorColumn, minor);
+    }
+
+    query.addValues<TYPE_OF_CHARACTER_ID>(playerIdColumn, snapshot.id, InsertQuery::FILL);
+    query.addServerTable("playerskills");
+    query.updateOnConflict({"psk_playerid", "psk_skill_id"}, {"psk_value", "psk_minor"});
+    query.execute();
+}
+
+// progress is never removed, only set to 0
+void saveQuests(const PConnection &connection, const PlayerSnapshot &snapshot, const PlayerSnapshot *previous) {
+    InsertQuery query(connection);
+    const InsertQuery::columnIndex userIdColumn = query.addColumn("qpg_userid");
+    const InsertQuery::columnIndex questIdColumn = query.addColumn("qpg_questid");
+    const InsertQuery::columnIndex progressColumn = query.addColumn("qpg_progress");
+    const InsertQuery::columnIndex timeColumn = query.addColumn("qpg_time");
+
+    for (const auto &quest : snapshot.quests) {
+        if (previous == nullptr || quest.changed) {
+            query.addValue<TYPE_OF_QUEST_ID>(questIdColumn, quest.quest);
+            query.addValue<TYPE_OF_QUESTSTATUS>(progressColumn, quest.progress);
+            query.addValue<int32_t>(timeColumn, quest.time);
+        }
+    }
+
+    query.addValues<TYPE_OF_CHARACTER_ID>(userIdColumn, snapshot.id, InsertQuery::FILL);
+    query.addServerTable("questprogress");
+    query.updateOnConflict({"qpg_userid", "qpg_questid"}, {"qpg_progress", "qpg_time"});
+    query.execute();
+}
+
+void saveItems(const PConnection &connection, const PlayerSnapshot &snapshot, const PlayerSnapshot *previous) {
+    const auto changes = changesOf(snapshot.items, previous ? &previous->items : nullptr);
+
+    if (previous == nullptr) {
+        deleteRowsExcept(connection, "playeritem_datavalues", "idv_playerid", snapshot.id, "idv_linenumber",
+                         snapshot.reservedLines);
+        deleteRowsExcept(connection, "playeritems", "pit_playerid", snapshot.id, "pit_linenumber",
+                         snapshot.reservedLines);
+    } else {
+        std::vector<int32_t> replacedData = changes.removed;
+        std::vector<int32_t> removedItems = changes.removed;
+
+        for (const auto line : changes.changed) {
+            if (previous->items.count(line) > 0) {
+                replacedData.push_back(line);
+            }
+        }
+
+        // rows of a loaded depot are cleaned up by the first save after it was loaded
+        for (const auto line : snapshot.releasedLines) {
+            if (previous->releasedLines.count(line) == 0) {
+                replacedData.push_back(line);
+
+                if (snapshot.items.count(line) == 0) {
+                    removedItems.push_back(line);
+                }
+            }
+        }
+
+        deleteRows(connection, "playeritem_datavalues", "idv_playerid", snapshot.id, "idv_linenumber", &replacedData);
+        deleteRows(connection, "playeritems", "pit_playerid", snapshot.id, "pit_linenumber", &removedItems);
+    }
+
+    InsertQuery itemsQuery(connection);
+    const InsertQuery::columnIndex itemsPlyIdColumn = itemsQuery.addColumn("pit_playerid");
+    const InsertQuery::columnIndex itemsLineColumn = itemsQuery.addColumn("pit_linenumber");
+    const InsertQuery::columnIndex itemsContainerColumn = itemsQuery.addColumn("pit_in_container");
+    const InsertQuery::columnIndex itemsDepotColumn = itemsQuery.addColumn("pit_depot");
+    const InsertQuery::columnIndex itemsItmIdColumn = itemsQuery.addColumn("pit_itemid");
+    const InsertQuery::columnIndex itemsWearColumn = itemsQuery.addColumn("pit_wear");
+    const InsertQuery::columnIndex itemsNumberColumn = itemsQuery.addColumn("pit_number");
+    const InsertQuery::columnIndex itemsQualColumn = itemsQuery.addColumn("pit_quality");
+    const InsertQuery::columnIndex itemsSlotColumn = itemsQuery.addColumn("pit_containerslot");
+    itemsQuery.setServerTable("playeritems");
+    itemsQuery.updateOnConflict({"pit_playerid", "pit_linenumber"},
+                                {"pit_in_container", "pit_depot", "pit_itemid", "pit_wear", "pit_number",
+                                 "pit_quality", "pit_containerslot"});
+
+    InsertQuery dataQuery(connection);
+    const InsertQuery::columnIndex dataPlyIdColumn = dataQuery.addColumn("idv_playerid");
+    const InsertQuery::columnIndex dataLineColumn = dataQuery.addColumn("idv_linenumber");
+    const InsertQuery::columnIndex dataKeyColumn = dataQuery.addColumn("idv_key");
+    const InsertQuery::columnIndex dataValueColumn = dataQuery.addColumn("idv_value");
+    dataQuery.setServerTable("playeritem_datavalues");
+
+    for (const auto line : changes.changed) {
+        const auto &item = snapshot.items.at(line);
+        itemsQuery.addValue<int32_t>(itemsLineColumn, line);
+        itemsQuery.addValue<int16_t>(itemsContainerColumn, item.container);
+        itemsQuery.addValue<int32_t>(itemsDepotColumn, item.depot);
+        itemsQuery.addValue<TYPE_OF_ITEM_ID>(itemsItmIdColumn, item.item);
+        itemsQuery.addValue<uint16_t>(itemsWearColumn, item.wear);
+        itemsQuery.addValue<uint16_t>(itemsNumberColumn, item.number);
+        itemsQuery.addValue<uint16_t>(itemsQualColumn, item.quality);
+        itemsQuery.addValue<TYPE_OF_CONTAINERSLOTS>(itemsSlotColumn, item.slot);
+
+        for (const auto &[key, value] : item.data) {
+            dataQuery.addValue<int32_t>(dataLineColumn, line);
+            dataQuery.addValue<std::string>(dataKeyColumn, key);
+            dataQuery.addValue<std::string>(dataValueColumn, value);
+        }
+    }
+
+    itemsQuery.addValues(itemsPlyIdColumn, snapshot.id, InsertQuery::FILL);
+    dataQuery.addValues(dataPlyIdColumn, snapshot.id, InsertQuery::FILL);
+
+    itemsQuery.execute();
+    dataQuery.execute();
+}
+
+using EffectRows = std::map<uint16_t, std::pair<int32_t, uint32_t>>;
+using EffectValues = std::map<std::pair<uint16_t, std::string>, uint32_t>;
+
+auto effectRowsOf(const PlayerSnapshot &snapshot) -> EffectRows {
+    EffectRows rows;
+
+    for (const auto &effect : snapshot.effects) {
+        rows.emplace(effect.effect, std::make_pair(effect.nextCalled, effect.calls));
+    }
+
+    return rows;
+}
+
+auto effectValuesOf(const PlayerSnapshot &snapshot) -> EffectValues {
+    EffectValues values;
+
+    for (const auto &effect : snapshot.effects) {
+        for (const auto &[name, value] : effect.values) {
+            values.emplace(std::make_pair(effect.effect, name), value);
+        }
+    }
+
+    return values;
+}
+
+// the remaining time of running effects changes with every save, their values mostly stay the same
+void saveEffects(const PConnection &connection, const PlayerSnapshot &snapshot, const PlayerSnapshot *previous) {
+    const auto rows = effectRowsOf(snapshot);
+    const auto values = effectValuesOf(snapshot);
+    const auto previousRows = previous ? effectRowsOf(*previous) : EffectRows{};
+    const auto previousValues = previous ? effectValuesOf(*previous) : EffectValues{};
+    const auto rowChanges = changesOf(rows, previous ? &previousRows : nullptr);
+    const auto valueChanges = changesOf(values, previous ? &previousValues : nullptr);
+
+    // values of removed effects go with them
+    deleteRows(connection, "playerlteffects", "plte_playerid", snapshot.id, "plte_effectid",
+               previous ? &rowChanges.removed : nullptr);
+
+    if (previous == nullptr) {
+        deleteRows<uint16_t>(connection, "playerlteffectvalues", "pev_playerid", snapshot.id, "", nullptr);
+    }
+
+    for (const auto &[effect, name] : valueChanges.removed) {
+        if (rows.count(effect) > 0) {
+            DeleteQuery query(connection);
+            query.addEqualCondition<TYPE_OF_CHARACTER_ID>("playerlteffectvalues", "pev_playerid", snapshot.id);
+            query.addEqualCondition<uint16_t>("playerlteffectvalues", "pev_effectid", effect);
+            query.addEqualCondition<std::string>("playerlteffectvalues", "pev_name", name);
+            query.setServerTable("playerlteffectvalues");
+            query.execute();
+        }
+    }
+
+    InsertQuery effectsQuery(connection);
+    effectsQuery.setServerTable("playerlteffects");
+    const InsertQuery::columnIndex userColumn = effectsQuery.addColumn("plte_playerid");
+    const InsertQuery::columnIndex effectColumn = effectsQuery.addColumn("plte_effectid");
+    const InsertQuery::columnIndex nextCalledColumn = effectsQuery.addColumn("plte_nextcalled");
+    const InsertQuery::columnIndex numberCalledColumn = effectsQuery.addColumn("plte_numbercalled");
+    effectsQuery.updateOnConflict({"plte_playerid", "plte_effectid"}, {"plte_nextcalled", "plte_numbercalled"});
+
+    for (const auto effect : rowChanges.changed) {
+        const auto &[nextCalled, calls] = rows.at(effect);
+        effectsQuery.addValue(effectColumn, effect);
+        effectsQuery.addValue(nextCalledColumn, nextCalled);
+        effectsQuery.addValue(numberCalledColumn, calls);
+    }
+
+    InsertQuery valuesQuery(connection);
+    valuesQuery.setServerTable("playerlteffectvalues");
+    const InsertQuery::columnIndex valueUserColumn = valuesQuery.addColumn("pev_playerid");
+    const InsertQuery::columnIndex valueEffectColumn = valuesQuery.addColumn("pev_effectid");
+    const InsertQuery::columnIndex nameColumn = valuesQuery.addColumn("pev_name");
+    const InsertQuery::columnIndex valueColumn = valuesQuery.addColumn("pev_value");
+    valuesQuery.updateOnConflict({"pev_playerid", "pev_effectid", "pev_name"}, {"pev_value"});
+
+    for (const auto &key : valueChanges.changed) {
+        valuesQuery.addValue(valueEffectColumn, key.first);
+        valuesQuery.addValue(nameColumn, key.second);
+        valuesQuery.addValue(valueColumn, values.at(key));
+    }
+
+    effectsQuery.addValues(userColumn, snapshot.id, InsertQuery::FILL);
+    valuesQuery.addValues(valueUserColumn, snapshot.id, InsertQuery::FILL);
+
+    effectsQuery.execute();
+    valuesQuery.execute();
+}
+
+} // namespace
+
+auto PlayerSnapshot::PlayerRow::operator==(const PlayerRow &other) const -> bool {
+    return std::tie(x, y, z, faceTo, hitpoints, mana, foodlevel, lifestate, magicType, magicFlags, poison,
+                    mentalCapacity, hair, beard, hairColour, skinColour) ==
+           std::tie(other.x, other.y, other.z, other.faceTo, other.hitpoints, other.mana, other.foodlevel,
+                    other.lifestate, other.magicType, other.magicFlags, other.poison, other.mentalCapacity,
+                    other.hair, other.beard, other.hairColour, other.skinColour);
+}
+
+auto PlayerSnapshot::ItemRow::operator==(const ItemRow &other) const -> bool {
+    return std::tie(container, depot, item, wear, number, quality, slot, data) ==
+           std::tie(other.container, other.depot, other.item, other.wear, other.number, other.quality, other.slot,
+                    other.data);
+}
+
+auto PlayerSnapshot::save(const PlayerSnapshot *previous) const noexcept -> bool {
+    Logger::info(LogFacility::Player) << "Saving " << description << (previous ? "" : " completely") << Log::end;
+
+    PConnection connection = ConnectionManager::getInstance().getConnection();
+
+    try {
+        connection->beginTransaction();
+
+        saveIntroductions(connection, *this, previous);
+        saveNames(connection, *this, previous);
+        saveCharacter(connection, *this);
+
+        if (previous == nullptr || !(player == previous->player)) {
+            savePlayer(connection, *this);
+        }
+
+        saveSkills(connection, *this, previous);
+        saveItems(connection, *this, previous);
+        saveEffects(connection, *this, previous);
+        saveQuests(connection, *this, previous);
+
+        connection->commitTransaction();
+        return true;
+    } catch (std::exception &e) {
+        Logger::error(LogFacility::Player) << "Playersave caught exception: " << e.what() << Log::end;
+        connection->rollbackTransaction();
+        return false;
+    }
+}
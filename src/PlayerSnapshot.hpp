@@ -0,0 +1,123 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PLAYER_SNAPSHOT_HPP
+#define PLAYER_SNAPSHOT_HPP
+
+#include "types.hpp"
+
+#include <array>
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// persistent state of a player, copied on the game thread so that the save thread can write it
+struct PlayerSnapshot {
+    struct PlayerRow {
+        int32_t x = 0;
+        int32_t y = 0;
+        int32_t z = 0;
+        uint16_t faceTo = 0;
+        uint16_t hitpoints = 0;
+        uint16_t mana = 0;
+        uint32_t foodlevel = 0;
+        uint32_t lifestate = 0;
+        uint32_t magicType = 0;
+        // mage, priest, bard, druid
+        std::array<uint64_t, 4> magicFlags{};
+        uint16_t poison = 0;
+        uint32_t mentalCapacity = 0;
+        uint16_t hair = 0;
+        uint16_t beard = 0;
+        // red, green, blue, alpha
+        std::array<uint16_t, 4> hairColour{};
+        std::array<uint16_t, 4> skinColour{};
+
+        auto operator==(const PlayerRow &other) const -> bool;
+    };
+
+    struct ItemRow {
+        int16_t container = 0;
+        int32_t depot = 0;
+        TYPE_OF_ITEM_ID item = 0;
+        uint16_t wear = 0;
+        uint16_t number = 0;
+        uint16_t quality = 0;
+        TYPE_OF_CONTAINERSLOTS slot = 0;
+        std::map<std::string, std::string> data;
+
+        auto operator==(const ItemRow &other) const -> bool;
+    };
+
+    struct QuestRow {
+        TYPE_OF_QUEST_ID quest = 0;
+        TYPE_OF_QUESTSTATUS progress = 0;
+        int32_t time = 0;
+        // set since the last snapshot
+        bool changed = false;
+    };
+
+    struct EffectRow {
+        uint16_t effect = 0;
+        int32_t nextCalled = 0;
+        uint32_t calls = 0;
+        std::unordered_map<std::string, uint32_t> values;
+    };
+
+    TYPE_OF_CHARACTER_ID id = 0;
+    std::string description;
+
+    // both sorted by player, so that saves can compare them in a single pass
+    using KnownPlayers = std::vector<TYPE_OF_CHARACTER_ID>;
+    using NamedPlayers = std::vector<std::pair<TYPE_OF_CHARACTER_ID, std::string>>;
+
+    KnownPlayers knownPlayers;
+    NamedPlayers namedPlayers;
+
+    uint16_t status = 0;
+    std::string lastIp;
+    uint32_t onlineTime = 0;
+    time_t saveTime = 0;
+    time_t statusTime = 0;
+    TYPE_OF_CHARACTER_ID statusGm = 0;
+    std::string statusReason;
+
+    PlayerRow player;
+    // major and minor value by skill
+    std::map<TYPE_OF_SKILL_ID, std::pair<uint16_t, uint16_t>> skills;
+    // by line number
+    std::map<int32_t, ItemRow> items;
+    // lines of depots left in the database, never written
+    std::set<int32_t> reservedLines;
+    // former lines of depots loaded since login, their rows are removed unless items took them over
+    std::set<int32_t> releasedLines;
+    std::vector<EffectRow> effects;
+    // all quests, only changed ones are written unless the save replaces all rows
+    std::vector<QuestRow> quests;
+
+    // writes the snapshot in one transaction, without a previous snapshot all rows are replaced, otherwise only rows
+    // differing from the previous snapshot, which has to be what was saved last
+    auto save(const PlayerSnapshot *previous) const noexcept -> bool;
+};
+
+#endif
@@ -16,29 +16,108 @@
 //  You should have received a copy of the GNU Affero General Public License
 //  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
 
+#include "Logger.hpp"
+#include "Metrics.hpp"
 #include "Player.hpp"
 #include "World.hpp"
 #include "netinterface/NetInterface.hpp"
 #include "netinterface/protocol/ClientCommands.hpp"
 #include "tuningConstants.hpp"
 
+#include <array>
+#include <climits>
+#include <sstream>
+
+namespace {
+
+// commands without AP costs are performed right away, the others wait in queuedCommands for enough AP
+enum CommandLane : size_t { immediateLane, gatedLane, laneCount };
+constexpr std::array<const char *, laneCount> laneNames{"immediate", "gated"};
+
+struct CommandLatency {
+    metrics::Histogram *queued = nullptr;
+    metrics::Histogram *performed = nullptr;
+};
+
+// registered when a command id is first performed on the game thread, the only thread working out commands
+std::array<std::array<CommandLatency, UCHAR_MAX + 1>, laneCount> latencies{};
+
+auto latencyOf(CommandLane lane, unsigned char id) -> CommandLatency & {
+    auto &latency = latencies[lane][id];
+
+    if (latency.queued == nullptr) {
+        auto &registry = metrics::Registry::get();
+        const auto labels = "id=\"" + std::to_string(id) + "\",lane=\"" + laneNames[lane] + '"';
+        latency.queued = &registry.histogram("illarion_client_command_queued_seconds",
+                                             "Time from receiving a client command until it is performed", labels);
+        latency.performed = &registry.histogram("illarion_client_command_perform_seconds",
+                                                "Time taken to perform a client command", labels);
+    }
+
+    return latency;
+}
+
+void perform(const ClientCommandPointer &cmd, Player *player, CommandLane lane) {
+    auto &latency = latencyOf(lane, cmd->getDefinitionByte());
+    const auto start = std::chrono::steady_clock::now();
+    latency.queued->observe(start - cmd->getIncomingTime());
+    cmd->performAction(player);
+    latency.performed->observe(std::chrono::steady_clock::now() - start);
+}
+
+} // namespace
+
 void Player::workoutCommands() {
-    std::unique_lock<std::mutex> lock(commandMutex);
+    // clearing before taking the commands makes receiveCommand announce anything that arrives after this point
+    commandsAnnounced.exchange(false, std::memory_order_acq_rel);
+    ClientCommandPointer received;
+
+    while (receivedCommands.pop(received)) {
+        if (received->getMinAP() == 0) {
+            immediateCommands.push(std::move(received));
+        } else {
+            queuedCommands.push(std::move(received));
+        }
+    }
+
     while (!immediateCommands.empty()) {
-        ClientCommandPointer cmd = immediateCommands.front();
+        ClientCommandPointer cmd = std::move(immediateCommands.front());
         immediateCommands.pop();
-        lock.unlock();
-        cmd->performAction(this);
-        lock.lock();
+        perform(cmd, this, immediateLane);
     }
 
     while (!queuedCommands.empty() && queuedCommands.front()->getMinAP() <= getActionPoints()) {
-        ClientCommandPointer cmd = queuedCommands.front();
+        ClientCommandPointer cmd = std::move(queuedCommands.front());
         queuedCommands.pop();
-        lock.unlock();
-        cmd->performAction(this);
-        lock.lock();
+        perform(cmd, this, gatedLane);
+    }
+}
+
+auto Player::commandLatencies() -> std::vector<std::string> {
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    std::vector<std::string> lines;
+
+    for (size_t lane = 0; lane < laneCount; ++lane) {
+        for (size_t id = 0; id < latencies[lane].size(); ++id) {
+            const auto &latency = latencies[lane][id];
+
+            if (latency.queued == nullptr || latency.queued->count() == 0) {
+                continue;
+            }
+
+            const auto count = latency.queued->count();
+            std::stringstream line;
+            line << laneNames[lane] << " command " << id << ": " << count << " performed, queued "
+                 << duration_cast<microseconds>(latency.queued->total()).count() / count << " us mean, "
+                 << duration_cast<microseconds>(latency.queued->quantile(0.99)).count() << " us p99, performing "
+                 << duration_cast<microseconds>(latency.performed->total()).count() / count << " us mean, "
+                 << duration_cast<microseconds>(latency.performed->quantile(0.99)).count() << " us p99";
+            lines.push_back(line.str());
+        }
     }
+
+    return lines;
 }
 
 void Player::checkFightMode() {
@@ -49,23 +128,17 @@ void Player::checkFightMode() {
 }
 
 void Player::receiveCommand(const ClientCommandPointer &cmd) {
-    bool notify = false;
-    {
-        std::unique_lock<std::mutex> lock(commandMutex);
-        if (cmd->getMinAP() == 0) {
-            immediateCommands.push(cmd);
-            notify = true;
-        } else {
-            if (getActionPoints() > cmd->getMinAP() && queuedCommands.empty()) {
-                notify = true;
-            }
-
-            queuedCommands.push(cmd);
-        }
+    if (!receivedCommands.push(cmd)) {
+        Logger::warn(LogFacility::Player) << "Closing connection to " << Connection->getIPAdress() << ", more than "
+                                          << maxReceivedCommands << " commands are waiting" << Log::end;
+        Connection->closeConnection();
+        return;
     }
 
-    if (notify) {
+    const bool canActNow = cmd->getMinAP() == 0 || getActionPoints() > cmd->getMinAP();
+
+    if (canActNow && !commandsAnnounced.exchange(true, std::memory_order_acq_rel)) {
         World::get()->addPlayerImmediateActionQueue(this);
-        World::get()->scheduler.signalNewPlayerAction();
+        World::get()->scheduler.signal();
     }
 }
@@ -18,14 +18,83 @@
 
 #include "Random.hpp"
 
-std::mt19937 Random::rng;
+#include <atomic>
 
-auto Random::uniform() -> double {
-    std::uniform_real_distribution<double> uniform(0, 1);
-    return uniform(rng);
+namespace {
+
+// the default seed of std::mt19937, which Random used before
+constexpr uint64_t defaultSeed = 5489;
+std::atomic<uint64_t> masterSeed{defaultSeed};
+// bumped by every seed, so that the other threads derive their streams again
+std::atomic<uint32_t> seedGeneration{0};
+std::atomic<uint64_t> nextStream{1};
+
+struct ThreadStream {
+    Random::Engine engine;
+    uint32_t generation = UINT32_MAX;
+};
+
+thread_local ThreadStream threadStream;
+
+auto splitmix(uint64_t &x) -> uint64_t {
+    auto z = (x += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+// the 53 high bits give every double in [0, 1) the same chance
+auto toUnit(uint64_t bits) -> double {
+    constexpr double step = 1.0 / (uint64_t{1} << 53);
+    return static_cast<double>(bits >> 11) * step;
+}
+
+} // namespace
+
+Random::Engine::Engine(uint64_t seed, uint64_t stream) {
+    auto x = seed;
+    auto mixedStream = stream;
+    x ^= splitmix(mixedStream);
+
+    for (auto &word : state) {
+        word = splitmix(x);
+    }
+}
+
+void Random::seed(uint64_t value) {
+    masterSeed = value;
+    nextStream = 1;
+    threadStream.generation = ++seedGeneration;
+    threadStream.engine = Engine(value, 0);
+}
+
+auto Random::split(uint64_t stream) -> Engine { return {masterSeed, stream}; }
+
+auto Random::engine() -> Engine & {
+    auto &stream = threadStream;
+
+    if (const auto generation = seedGeneration.load(); stream.generation != generation) {
+        stream.engine = Engine(masterSeed, nextStream++);
+        stream.generation = generation;
+    }
+
+    return stream.engine;
 }
 
+auto Random::uniform() -> double { return toUnit(engine()()); }
+
 auto Random::normal(double mean, double sd) -> double {
     std::normal_distribution<double> norm(mean, sd);
-    return norm(rng);
+    return norm(engine());
+}
+
+auto Random::uniformBatch(size_t count) -> std::vector<double> {
+    auto &rng = engine();
+    std::vector<double> result(count);
+
+    for (auto &number : result) {
+        number = toUnit(rng());
+    }
+
+    return result;
 }
@@ -19,20 +19,87 @@
 #ifndef RANDOM_HPP
 #define RANDOM_HPP
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <random>
 #include <sstream>
 #include <stdexcept>
 #include <type_traits>
+#include <vector>
 
+// every thread draws from a stream of its own, derived from the master seed: the thread calling seed gets stream 0,
+// the others get the following streams in the order they first draw a number
 class Random {
-private:
-    static std::mt19937 rng;
-
 public:
+    // xoshiro256**, see https://prng.di.unimi.it
+    class Engine {
+    public:
+        using result_type = uint64_t;
+
+        Engine() : Engine(0, 0) {}
+        Engine(uint64_t seed, uint64_t stream);
+
+        static constexpr auto min() -> result_type { return 0; }
+        static constexpr auto max() -> result_type { return UINT64_MAX; }
+
+        auto operator()() -> result_type {
+            const auto result = rotl(state[1] * 5, 7) * 9;
+            const auto t = state[1] << 17;
+            state[2] ^= state[0];
+            state[3] ^= state[1];
+            state[1] ^= state[2];
+            state[0] ^= state[3];
+            state[2] ^= t;
+            state[3] = rotl(state[3], 45);
+            return result;
+        }
+
+    private:
+        std::array<uint64_t, 4> state{};
+
+        static constexpr auto rotl(uint64_t x, int k) -> uint64_t { return (x << k) | (x >> (64 - k)); }
+    };
+
+    // makes the following numbers reproducible, e.g. for replaying recorded sessions
+    static void seed(uint64_t value);
+    // a stream independent of the calling thread, for work that has to be reproducible wherever it runs
+    [[nodiscard]] static auto split(uint64_t stream) -> Engine;
+    // the stream of the calling thread
+    static auto engine() -> Engine &;
+
     static auto uniform() -> double;
     static auto normal(double mean, double sd) -> double;
 
     template <class IntType> static auto uniform(IntType min, IntType max) -> IntType {
+        checkRange(min, max);
+        std::uniform_int_distribution<IntType> uniform(min, max);
+        return uniform(engine());
+    }
+
+    template <class IntType> static auto uniform(IntType count) -> IntType {
+        static_assert(std::is_unsigned_v<IntType>);
+        return uniform(IntType{0}, count - 1);
+    }
+
+    // count numbers at once, e.g. for loot rolls or spawn positions
+    static auto uniformBatch(size_t count) -> std::vector<double>;
+
+    template <class IntType> static auto uniformBatch(IntType min, IntType max, size_t count) -> std::vector<IntType> {
+        checkRange(min, max);
+        std::uniform_int_distribution<IntType> uniform(min, max);
+        auto &rng = engine();
+        std::vector<IntType> result(count);
+
+        for (auto &number : result) {
+            number = uniform(rng);
+        }
+
+        return result;
+    }
+
+private:
+    template <class IntType> static void checkRange(IntType min, IntType max) {
         static_assert(std::is_same_v<IntType, short> || std::is_same_v<IntType, int> || std::is_same_v<IntType, long> ||
                       std::is_same_v<IntType, long long> || std::is_same_v<IntType, unsigned short> ||
                       std::is_same_v<IntType, unsigned int> || std::is_same_v<IntType, unsigned long> ||
@@ -42,14 +109,6 @@ public:
             error << "Random::uniform: Invalid arguments, min(" << min << ") > max(" << max << ")";
             throw std::invalid_argument(error.str());
         }
-
-        std::uniform_int_distribution<IntType> uniform(min, max);
-        return uniform(rng);
-    }
-
-    template <class IntType> static auto uniform(IntType count) -> IntType {
-        static_assert(std::is_unsigned_v<IntType>);
-        return uniform(IntType{0}, count - 1);
     }
 };
 
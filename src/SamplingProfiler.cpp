@@ -0,0 +1,195 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "SamplingProfiler.hpp"
+
+#include "script/LuaWatchdog.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <execinfo.h>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr int sampleSignal = SIGPROF;
+constexpr int maxFrames = 48;
+// the signal handler and the signal trampoline
+constexpr int skippedFrames = 2;
+// the most recent samples are kept, about three minutes at 100 samples per second
+constexpr size_t capacity = 1U << 14U;
+
+struct Sample {
+    const char *task = nullptr;
+    const LuaProfiler::Entry *script = nullptr;
+    int depth = 0;
+    std::array<void *, maxFrames> frames{};
+};
+
+// written by the signal handler on the profiled thread, read there as well while the handler is paused
+std::array<Sample, capacity> samples;
+std::atomic<size_t> taken{0};
+std::atomic<bool> paused{false};
+
+void takeSample(int /*signal*/) {
+    if (paused.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    const int savedErrno = errno;
+    const auto index = taken.load(std::memory_order_relaxed);
+    auto &sample = samples[index % capacity];
+    sample.depth = backtrace(sample.frames.data(), maxFrames);
+    sample.task = SamplingProfiler::Task::running();
+    sample.script = LuaWatchdog::running();
+    taken.store(index + 1, std::memory_order_release);
+    errno = savedErrno;
+}
+
+// backtrace_symbols gives "module(symbol+offset) [address]"
+auto functionName(const char *symbol) -> std::string {
+    const std::string line(symbol);
+    const auto open = line.find('(');
+    const auto plus = line.find('+', open);
+
+    if (open == std::string::npos || plus == std::string::npos || plus == open + 1) {
+        const auto slash = line.rfind('/', open);
+        const auto start = slash == std::string::npos ? 0 : slash + 1;
+        return "[" + line.substr(start, open == std::string::npos ? std::string::npos : open - start) + "]";
+    }
+
+    const auto mangled = line.substr(open + 1, plus - open - 1);
+    int status = 0;
+    std::unique_ptr<char, decltype(&std::free)> demangled(
+            abi::__cxa_demangle(mangled.c_str(), nullptr, nullptr, &status), &std::free);
+    return status == 0 && demangled ? std::string(demangled.get()) : mangled;
+}
+
+} // namespace
+
+auto SamplingProfiler::get() -> SamplingProfiler & {
+    static SamplingProfiler profiler;
+    return profiler;
+}
+
+void SamplingProfiler::start(uint16_t frequency) {
+    stop();
+
+    if (frequency == 0) {
+        return;
+    }
+
+    // the first backtrace loads libgcc, which must not happen inside the signal handler
+    std::array<void *, maxFrames> frames{};
+    backtrace(frames.data(), maxFrames);
+
+    struct sigaction action {};
+    action.sa_handler = takeSample;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(sampleSignal, &action, nullptr);
+
+    this->frequency = frequency;
+    target = pthread_self();
+    stopping = false;
+    sampler = std::thread([this] { run(); });
+}
+
+void SamplingProfiler::stop() {
+    if (!sampler.joinable()) {
+        return;
+    }
+
+    stopping = true;
+    sampler.join();
+    frequency = 0;
+}
+
+void SamplingProfiler::run() {
+    constexpr std::chrono::microseconds second = std::chrono::seconds(1);
+    const auto interval = second / frequency;
+
+    while (!stopping) {
+        std::this_thread::sleep_for(interval);
+        pthread_kill(target, sampleSignal);
+    }
+}
+
+auto SamplingProfiler::dump(const std::string &path) -> bool {
+    paused = true;
+    const auto count = std::min(taken.load(std::memory_order_acquire), capacity);
+
+    std::unordered_map<void *, std::string> names;
+
+    for (size_t i = 0; i < count; ++i) {
+        for (int frame = skippedFrames; frame < samples[i].depth; ++frame) {
+            names.try_emplace(samples[i].frames[frame]);
+        }
+    }
+
+    std::vector<void *> addresses;
+    addresses.reserve(names.size());
+
+    for (const auto &[address, name] : names) {
+        addresses.push_back(address);
+    }
+
+    std::unique_ptr<char *, decltype(&std::free)> symbols(
+            backtrace_symbols(addresses.data(), static_cast<int>(addresses.size())), &std::free);
+
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        names[addresses[i]] = symbols ? functionName(symbols.get()[i]) : "??";
+    }
+
+    std::map<std::string, uint64_t> folded;
+
+    for (size_t i = 0; i < count; ++i) {
+        const auto &sample = samples[i];
+        std::string stack = sample.task != nullptr ? sample.task : "main_loop";
+
+        if (sample.script != nullptr) {
+            stack += ";lua:" + sample.script->getScript() + "." + sample.script->getEntrypoint();
+        }
+
+        for (int frame = sample.depth - 1; frame >= skippedFrames; --frame) {
+            stack += ';' + names[sample.frames[frame]];
+        }
+
+        ++folded[stack];
+    }
+
+    taken = 0;
+    paused = false;
+
+    std::ofstream out(path);
+
+    for (const auto &[stack, samplesOfStack] : folded) {
+        out << stack << ' ' << samplesOfStack << '\n';
+    }
+
+    return static_cast<bool>(out);
+}
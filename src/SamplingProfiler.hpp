@@ -0,0 +1,71 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SAMPLING_PROFILER_HPP
+#define SAMPLING_PROFILER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <pthread.h>
+#include <string>
+#include <thread>
+
+// Samples the native stack of the game thread with SIGPROF, sent by a thread of its own at a fixed frequency. Each
+// sample is tagged with the running scheduler task and the outermost Lua entrypoint. Stacks are stored as raw
+// addresses and only symbolized when the samples are written as folded stacks for flame graphs.
+class SamplingProfiler {
+public:
+    static auto get() -> SamplingProfiler &;
+
+    // names what the game thread is doing for the samples taken in its lifetime, the name has to outlive the profile
+    class Task {
+    public:
+        explicit Task(const char *name) : previous(current) { current = name; }
+        Task(const Task &) = delete;
+        auto operator=(const Task &) -> Task & = delete;
+        Task(Task &&) = delete;
+        auto operator=(Task &&) -> Task & = delete;
+        ~Task() { current = previous; }
+
+        [[nodiscard]] static auto running() -> const char * { return current; }
+
+    private:
+        const char *previous;
+        static inline const char *current = nullptr;
+    };
+
+    // samples the calling thread the given number of times per second, restarts a running profiler
+    void start(uint16_t frequency);
+    void stop();
+    [[nodiscard]] auto getFrequency() const -> uint16_t { return frequency; }
+    // writes the samples taken so far as folded stacks and drops them, calling thread only; false if the file could
+    // not be written
+    auto dump(const std::string &path) -> bool;
+
+private:
+    SamplingProfiler() = default;
+
+    void run();
+
+    uint16_t frequency = 0;
+    pthread_t target{};
+    std::atomic<bool> stopping{false};
+    std::thread sampler;
+};
+
+#endif
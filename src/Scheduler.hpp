@@ -19,55 +19,122 @@
 #ifndef SCHEDULER_HPP
 #define SCHEDULER_HPP
 
+#include "Metrics.hpp"
+#include "SamplingProfiler.hpp"
+#include "TickClock.hpp"
+#include "Tracer.hpp"
+
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <condition_variable>
-#include <memory>
+#include <cstdint>
+#include <functional>
+#include <limits>
 #include <mutex>
-#include <queue>
 #include <string>
-
-template <typename clock_type> class Task {
-public:
-    Task(std::function<void()> task, typename clock_type::time_point start_point, std::chrono::nanoseconds interval,
-         std::string name);
-
-    inline auto operator<(const Task &other) const -> bool { return other._next < _next; }
-
-    auto run() -> bool;
-
-    [[nodiscard]] inline auto getName() const -> std::string { return _name; }
-
-    [[nodiscard]] inline auto getNextTime() const -> typename clock_type::time_point { return _next; }
-
-private:
-    std::function<void()> _task;
-
-    typename clock_type::time_point _next;
-    std::chrono::nanoseconds _interval;
-    std::string _name;
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// names of tasks are stored once, tasks only keep a pointer
+inline auto internTaskName(const std::string &name) -> const std::string * {
+    static std::mutex mutex;
+    static std::unordered_set<std::string> names;
+    std::lock_guard<std::mutex> lock(mutex);
+    return &*names.insert(name).first;
+}
+
+// refers to a task of a ClockBasedScheduler, stays invalid once the task finished or was cancelled
+struct TaskHandle {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    [[nodiscard]] auto isValid() const -> bool { return index != UINT32_MAX; }
 };
 
+// hierarchical timing wheel with millisecond ticks: inserting and cancelling takes constant time, each level covers
+// 256 times the span of the level below, four levels reach about 49 days and later tasks wait in the last level
 template <typename clock_type> class ClockBasedScheduler {
 public:
-    void addOneshotTask(std::function<void()> task, std::chrono::nanoseconds delay, const std::string &taskname);
-    void addRecurringTask(std::function<void()> task, std::chrono::nanoseconds interval, const std::string &taskname,
-                          bool start_immediately = false);
-    void addRecurringTask(std::function<void()> task, std::chrono::nanoseconds interval,
-                          typename clock_type::time_point first_time, const std::string &taskname);
-    void signalNewPlayerAction();
-
+    explicit ClockBasedScheduler(typename clock_type::time_point epoch = clock_type::now());
+
+    auto addOneshotTask(std::function<void()> task, std::chrono::nanoseconds delay, const std::string &taskname)
+            -> TaskHandle;
+    auto addRecurringTask(std::function<void()> task, std::chrono::nanoseconds interval, const std::string &taskname,
+                          bool start_immediately = false) -> TaskHandle;
+    auto addRecurringTask(std::function<void()> task, std::chrono::nanoseconds interval,
+                          typename clock_type::time_point first_time, const std::string &taskname) -> TaskHandle;
+    // returns false if the task already finished or was cancelled
+    auto cancel(TaskHandle handle) -> bool;
+    // moves the next run of the task, recurring tasks keep their interval afterwards
+    auto reschedule(TaskHandle handle, std::chrono::nanoseconds delay) -> bool;
+    [[nodiscard]] auto getName(TaskHandle handle) const -> std::string;
+    [[nodiscard]] auto taskCount() const -> size_t;
+    // time until the next task is due, max if there is none
+    [[nodiscard]] auto getNextTaskTime() const -> std::chrono::nanoseconds;
+    // wakes run_once for work that is not a task, like player commands or logins, safe to call from any thread
+    void signal();
+
+    // waits until a task is due, the scheduler is signalled or max_timeout passed, then runs all due tasks; tasks
+    // added meanwhile by other threads shorten the wait and signals sent before the wait are not lost
     void run_once(std::chrono::nanoseconds max_timeout);
 
 private:
-    auto getNextTaskTime() -> std::chrono::nanoseconds;
+    using tick_t = uint64_t;
+    static constexpr std::chrono::milliseconds tickLength{1};
+    static constexpr int slotBits = 8;
+    static constexpr size_t slotCount = 1U << slotBits;
+    static constexpr size_t levelCount = 4;
+    static constexpr uint32_t none = UINT32_MAX;
+
+    struct Node {
+        std::function<void()> task;
+        typename clock_type::time_point next;
+        std::chrono::nanoseconds interval{0};
+        const std::string *name = nullptr;
+        uint32_t generation = 0;
+        uint32_t previous = none;
+        uint32_t following = none;
+        // slot list the node is linked into, none while it runs or is free
+        uint32_t slot = none;
+        bool active = false;
+        // set when rescheduled while running, so the interval is not added on top
+        bool rescheduled = false;
+    };
+
+    using wheel_t = std::array<std::array<uint32_t, slotCount>, levelCount>;
+
+    auto add(std::function<void()> task, typename clock_type::time_point start, std::chrono::nanoseconds interval,
+             const std::string &taskname) -> TaskHandle;
+    [[nodiscard]] auto find(TaskHandle handle) const -> const Node *;
+    [[nodiscard]] auto tickOf(typename clock_type::time_point time) const -> tick_t;
+    [[nodiscard]] auto timeOf(tick_t tick) const -> typename clock_type::time_point;
+    // links into the slot of the due tick, but not before earliest
+    void link(uint32_t index, tick_t earliest);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    void cascade(size_t level);
     void execute_tasks();
-
-    std::mutex _new_action_signal_mutex;
-    std::condition_variable _new_action_available_cond;
-
-    using task_container_t = std::priority_queue<Task<std::chrono::steady_clock>>;
-    task_container_t _tasks;
-    std::mutex _container_mutex;
+    // ends the current wait of run_once if a task was added to run before it ends
+    void wakeBefore(typename clock_type::time_point time);
+
+    // guards _signalled and _wait_until, taken before _container_mutex if both are needed
+    std::mutex _signal_mutex;
+    std::condition_variable _signal_cond;
+    bool _signalled = false;
+    // end of the current wait of run_once, min outside of waits
+    typename clock_type::time_point _wait_until = clock_type::time_point::min();
+
+    typename clock_type::time_point _epoch;
+    // all ticks up to this one were processed
+    tick_t _current = 0;
+    std::vector<Node> _nodes;
+    std::vector<uint32_t> _free;
+    // heads of the slot lists of indices into _nodes, slot ids of nodes are level * slotCount + slot
+    wheel_t _wheel;
+    size_t _count = 0;
+    mutable std::mutex _container_mutex;
 };
 
 #include "Scheduler.tcc"
@@ -1,7 +1,3 @@
-#include <utility>
-
-
-
 //  illarionserver - server for the game Illarion
 //  Copyright 2011 Illarion e.V.
 //
@@ -20,93 +16,359 @@
 //  You should have received a copy of the GNU Affero General Public License
 //  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
 
-template<typename clock_type>
-Task<clock_type>::Task(std::function<void()> task, typename clock_type::time_point start_point, std::chrono::nanoseconds interval, std::string  name) : _task(std::move(task)), _next(start_point), _interval(interval), _name(std::move(name)) { }
+template <typename clock_type>
+ClockBasedScheduler<clock_type>::ClockBasedScheduler(typename clock_type::time_point epoch) : _epoch(epoch) {
+    for (auto &level : _wheel) {
+        level.fill(none);
+    }
+}
+
+template <typename clock_type>
+auto ClockBasedScheduler<clock_type>::addOneshotTask(std::function<void()> task, std::chrono::nanoseconds delay,
+                                                     const std::string &taskname) -> TaskHandle {
+    const auto start_time = clock_type::now() + std::chrono::duration_cast<typename clock_type::duration>(delay);
+    return add(std::move(task), start_time, std::chrono::nanoseconds::zero(), taskname);
+}
+
+template <typename clock_type>
+auto ClockBasedScheduler<clock_type>::addRecurringTask(std::function<void()> task, std::chrono::nanoseconds interval,
+                                                       const std::string &taskname, bool start_immediately)
+        -> TaskHandle {
+    auto start_time = clock_type::now();
+
+    if (!start_immediately) {
+        start_time += std::chrono::duration_cast<typename clock_type::duration>(interval);
+    }
+
+    return add(std::move(task), start_time, interval, taskname);
+}
+
+template <typename clock_type>
+auto ClockBasedScheduler<clock_type>::addRecurringTask(std::function<void()> task, std::chrono::nanoseconds interval,
+                                                       typename clock_type::time_point first_time,
+                                                       const std::string &taskname) -> TaskHandle {
+    return add(std::move(task), first_time, interval, taskname);
+}
+
+template <typename clock_type>
+auto ClockBasedScheduler<clock_type>::add(std::function<void()> task, typename clock_type::time_point start,
+                                          std::chrono::nanoseconds interval, const std::string &taskname)
+        -> TaskHandle {
+    const auto *name = internTaskName(taskname);
+    std::unique_lock<std::mutex> lock(_container_mutex);
+    uint32_t index = 0;
+
+    if (_free.empty()) {
+        index = static_cast<uint32_t>(_nodes.size());
+        _nodes.emplace_back();
+    } else {
+        index = _free.back();
+        _free.pop_back();
+    }
+
+    auto &node = _nodes[index];
+    node.task = std::move(task);
+    node.next = start;
+    node.interval = interval;
+    node.name = name;
+    node.active = true;
+    node.rescheduled = false;
+    link(index, _current + 1);
+    ++_count;
+    const TaskHandle handle{index, node.generation};
+    lock.unlock();
+
+    wakeBefore(start);
+    return handle;
+}
+
+template <typename clock_type> auto ClockBasedScheduler<clock_type>::cancel(TaskHandle handle) -> bool {
+    std::lock_guard<std::mutex> lock(_container_mutex);
+
+    if (find(handle) == nullptr) {
+        return false;
+    }
+
+    auto &node = _nodes[handle.index];
+
+    if (node.slot == none) {
+        // running right now, released once it returns
+        node.active = false;
+    } else {
+        unlink(handle.index);
+        release(handle.index);
+        --_count;
+    }
+
+    return true;
+}
+
+template <typename clock_type>
+auto ClockBasedScheduler<clock_type>::reschedule(TaskHandle handle, std::chrono::nanoseconds delay) -> bool {
+    const auto next = clock_type::now() + std::chrono::duration_cast<typename clock_type::duration>(delay);
+
+    {
+        std::lock_guard<std::mutex> lock(_container_mutex);
+
+        if (find(handle) == nullptr) {
+            return false;
+        }
+
+        auto &node = _nodes[handle.index];
+        node.next = next;
+
+        if (node.slot == none) {
+            node.rescheduled = true;
+        } else {
+            unlink(handle.index);
+            link(handle.index, _current + 1);
+        }
+    }
+
+    wakeBefore(next);
+    return true;
+}
+
+template <typename clock_type> auto ClockBasedScheduler<clock_type>::getName(TaskHandle handle) const -> std::string {
+    std::lock_guard<std::mutex> lock(_container_mutex);
+    const auto *node = find(handle);
+    return node != nullptr ? *node->name : std::string();
+}
+
+template <typename clock_type> auto ClockBasedScheduler<clock_type>::taskCount() const -> size_t {
+    std::lock_guard<std::mutex> lock(_container_mutex);
+    return _count;
+}
+
+template <typename clock_type> void ClockBasedScheduler<clock_type>::signal() {
+    {
+        std::lock_guard<std::mutex> lock(_signal_mutex);
+        _signalled = true;
+    }
+
+    _signal_cond.notify_all();
+}
+
+template <typename clock_type>
+void ClockBasedScheduler<clock_type>::wakeBefore(typename clock_type::time_point time) {
+    {
+        std::lock_guard<std::mutex> lock(_signal_mutex);
 
-template<typename clock_type>
-auto Task<clock_type>::run() -> bool {
-	_task();
+        // outside of a wait the next run_once looks up the deadline anyway
+        if (time >= _wait_until) {
+            return;
+        }
 
-	if (_interval > std::chrono::nanoseconds::zero()) {
-		_next += std::chrono::duration_cast<typename clock_type::duration>(_interval);
-		return true;
-	}
+        _signalled = true;
+    }
 
-	return false;
+    _signal_cond.notify_all();
 }
 
-template<typename clock_type>
-void ClockBasedScheduler<clock_type>::addOneshotTask(std::function<void()> task, std::chrono::nanoseconds delay, const std::string& taskname) {
-	std::unique_lock<std::mutex> lock(_container_mutex);
-	typename clock_type::time_point start_time = clock_type::now() + std::chrono::duration_cast<typename clock_type::duration>(delay);
-	_tasks.emplace(task, start_time, std::chrono::nanoseconds::zero(), taskname);
+template <typename clock_type> void ClockBasedScheduler<clock_type>::run_once(std::chrono::nanoseconds max_timeout) {
+    {
+        // the next task is looked up under the signal lock, so tasks added after the lookup see the deadline
+        std::unique_lock<std::mutex> lock(_signal_mutex);
+        const auto wait = std::min(getNextTaskTime(), max_timeout);
+
+        if (wait > std::chrono::nanoseconds::zero()) {
+            _wait_until = clock_type::now() + std::chrono::duration_cast<typename clock_type::duration>(wait);
+            _signal_cond.wait_for(lock, wait, [this] { return _signalled; });
+            _wait_until = clock_type::time_point::min();
+        }
+
+        _signalled = false;
+    }
+
+    execute_tasks();
 }
 
-template<typename clock_type>
-void ClockBasedScheduler<clock_type>::addRecurringTask(std::function<void()> task, std::chrono::nanoseconds interval, const std::string& taskname, bool start_immediately) {
-	std::unique_lock<std::mutex> lock(_container_mutex);
-	typename clock_type::time_point start_time = clock_type::now();
-	if (!start_immediately) {
-		start_time += std::chrono::duration_cast<typename clock_type::duration>(interval);
+template <typename clock_type> auto ClockBasedScheduler<clock_type>::find(TaskHandle handle) const -> const Node * {
+    if (handle.index >= _nodes.size()) {
+        return nullptr;
+    }
+
+    const auto &node = _nodes[handle.index];
+
+    if (!node.active || node.generation != handle.generation) {
+        return nullptr;
     }
 
-	_tasks.emplace(task, start_time, interval, taskname);
+    return &node;
 }
 
-template<typename clock_type>
-void ClockBasedScheduler<clock_type>::addRecurringTask(std::function<void()> task, std::chrono::nanoseconds interval, typename clock_type::time_point first_time, const std::string& taskname) {
-	std::unique_lock<std::mutex> lock(_container_mutex);
-	_tasks.emplace(task, first_time, interval, taskname);
+template <typename clock_type>
+auto ClockBasedScheduler<clock_type>::tickOf(typename clock_type::time_point time) const -> tick_t {
+    if (time <= _epoch) {
+        return 0;
+    }
+
+    constexpr auto length = std::chrono::nanoseconds(tickLength).count();
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(time - _epoch).count();
+    return (elapsed + length - 1) / length;
 }
 
-template<typename clock_type>
-void ClockBasedScheduler<clock_type>::signalNewPlayerAction() {
-	std::unique_lock<std::mutex> lock(_new_action_signal_mutex);
-	_new_action_available_cond.notify_all();
+template <typename clock_type>
+auto ClockBasedScheduler<clock_type>::timeOf(tick_t tick) const -> typename clock_type::time_point {
+    return _epoch + std::chrono::duration_cast<typename clock_type::duration>(tickLength * tick);
 }
 
-template<typename clock_type>
-void ClockBasedScheduler<clock_type>::run_once(std::chrono::nanoseconds max_timeout) {
-	auto next_action_time = getNextTaskTime();
-	if (next_action_time > max_timeout) {
-		next_action_time = max_timeout;
+template <typename clock_type> void ClockBasedScheduler<clock_type>::link(uint32_t index, tick_t earliest) {
+    auto &node = _nodes[index];
+    const tick_t due = std::max(tickOf(node.next), earliest);
+    const auto distance = [this, due](size_t level) {
+        return (due >> (slotBits * level)) - (_current >> (slotBits * level));
+    };
+    size_t level = 0;
 
+    while (level + 1 < levelCount && distance(level) >= slotCount) {
+        ++level;
     }
 
-	{
-		std::unique_lock<std::mutex> lock(_new_action_signal_mutex);
-		_new_action_available_cond.wait_for(lock, next_action_time);
-	}
+    size_t slot = (due >> (slotBits * level)) % slotCount;
 
-	execute_tasks();
+    if (distance(level) >= slotCount) {
+        // beyond the last level, wait in its furthest slot and get linked again from there
+        slot = ((_current >> (slotBits * level)) + slotCount - 1) % slotCount;
+    }
+
+    auto &head = _wheel[level][slot];
+    node.previous = none;
+    node.following = head;
+
+    if (head != none) {
+        _nodes[head].previous = index;
+    }
+
+    head = index;
+    node.slot = static_cast<uint32_t>(level * slotCount + slot);
 }
 
-template<typename clock_type>
-auto ClockBasedScheduler<clock_type>::getNextTaskTime() -> std::chrono::nanoseconds {
-	std::unique_lock<std::mutex> lock(_container_mutex);
-	if (_tasks.empty()) {
-		return std::chrono::nanoseconds::max();
+template <typename clock_type> void ClockBasedScheduler<clock_type>::unlink(uint32_t index) {
+    auto &node = _nodes[index];
+
+    if (node.previous != none) {
+        _nodes[node.previous].following = node.following;
+    } else {
+        _wheel[node.slot / slotCount][node.slot % slotCount] = node.following;
     }
 
-	return _tasks.top().getNextTime() - clock_type::now();
+    if (node.following != none) {
+        _nodes[node.following].previous = node.previous;
+    }
+
+    node.previous = none;
+    node.following = none;
+    node.slot = none;
+}
+
+template <typename clock_type> void ClockBasedScheduler<clock_type>::release(uint32_t index) {
+    auto &node = _nodes[index];
+    node.task = nullptr;
+    node.active = false;
+    ++node.generation;
+    _free.push_back(index);
 }
 
-template<typename clock_type>
-void ClockBasedScheduler<clock_type>::execute_tasks() {
-	auto now = clock_type::now();
+template <typename clock_type> void ClockBasedScheduler<clock_type>::cascade(size_t level) {
+    auto index = std::exchange(_wheel[level][(_current >> (slotBits * level)) % slotCount], none);
 
-	std::unique_lock<std::mutex> lock(_container_mutex);
-	while (!_tasks.empty() && now >= _tasks.top().getNextTime()) {
-		auto task = _tasks.top();
-		_tasks.pop();
-		lock.unlock();
+    while (index != none) {
+        auto &node = _nodes[index];
+        const auto following = node.following;
+        node.slot = none;
+        link(index, _current);
+        index = following;
+    }
+}
 
-		bool runResult = task.run();
+template <typename clock_type> auto ClockBasedScheduler<clock_type>::getNextTaskTime() const -> std::chrono::nanoseconds {
+    std::unique_lock<std::mutex> lock(_container_mutex);
 
-		lock.lock();
-		if (runResult) {
-			_tasks.push(task);
+    if (_count == 0) {
+        return std::chrono::nanoseconds::max();
+    }
+
+    auto next = std::numeric_limits<tick_t>::max();
+
+    // the first occupied slot of each level, higher levels count from when they are cascaded
+    for (size_t level = 0; level < levelCount; ++level) {
+        const auto position = _current >> (slotBits * level);
+
+        for (size_t distance = 1; distance < slotCount; ++distance) {
+            if (_wheel[level][(position + distance) % slotCount] != none) {
+                next = std::min(next, (position + distance) << (slotBits * level));
+                break;
+            }
         }
-	}
+    }
+
+    if (next == std::numeric_limits<tick_t>::max()) {
+        // only running tasks are left
+        return std::chrono::nanoseconds::max();
+    }
+
+    return timeOf(next) - clock_type::now();
 }
 
+template <typename clock_type> void ClockBasedScheduler<clock_type>::execute_tasks() {
+    const auto now = clock_type::now();
+    const auto target = now > _epoch ? static_cast<tick_t>((now - _epoch) / tickLength) : 0;
+
+    std::unique_lock<std::mutex> lock(_container_mutex);
+
+    while (_current < target) {
+        if (_count == 0) {
+            _current = target;
+            break;
+        }
+
+        ++_current;
+
+        for (size_t level = levelCount - 1; level > 0; --level) {
+            if (_current % (tick_t(1) << (slotBits * level)) == 0) {
+                cascade(level);
+            }
+        }
+
+        auto &slot = _wheel[0][_current % slotCount];
+
+        while (slot != none) {
+            const auto index = slot;
+            unlink(index);
+            auto task = std::move(_nodes[index].task);
+            const auto *name = _nodes[index].name;
+            lock.unlock();
+
+            {
+                static auto &taskDuration = metrics::Registry::get().histogram(
+                        "illarion_scheduler_task_duration_seconds", "Tasks run by the game loop scheduler");
+                const metrics::Timer timer(taskDuration);
+                const Tracer::Zone zone(name != nullptr ? name->c_str() : "task");
+                const SamplingProfiler::Task profiled(name != nullptr ? name->c_str() : "task");
+                TickClock::update();
+                task();
+            }
+
+            lock.lock();
+            auto &node = _nodes[index];
+            node.task = std::move(task);
+
+            if (!node.active) {
+                // cancelled while running
+                release(index);
+                --_count;
+            } else if (node.rescheduled || node.interval > std::chrono::nanoseconds::zero()) {
+                if (!node.rescheduled) {
+                    node.next += std::chrono::duration_cast<typename clock_type::duration>(node.interval);
+                }
+
+                node.rescheduled = false;
+                link(index, _current + 1);
+            } else {
+                release(index);
+                --_count;
+            }
+        }
+    }
+}
@@ -18,7 +18,39 @@
 
 #include "Showcase.hpp"
 
-Showcase::Showcase(Container *container, bool carry) : openContainer(container), isInInventory(carry) {}
+#include <algorithm>
+
+std::unordered_map<const Container *, std::vector<Player *>> Showcase::viewers;
+
+Showcase::Showcase(Player *viewer, Container *container, bool carry)
+        : viewer(viewer), openContainer(container), isInInventory(carry) {
+    viewers[openContainer].push_back(viewer);
+}
+
+Showcase::~Showcase() {
+    const auto it = viewers.find(openContainer);
+
+    if (it == viewers.end()) {
+        return;
+    }
+
+    auto &players = it->second;
+    players.erase(std::find(players.begin(), players.end(), viewer));
+
+    if (players.empty()) {
+        viewers.erase(it);
+    }
+}
+
+auto Showcase::viewersOf(const Container *container) -> std::vector<Player *> {
+    const auto it = viewers.find(container);
+
+    if (it == viewers.end()) {
+        return {};
+    }
+
+    return it->second;
+}
 
 auto Showcase::contains(Container *container) const -> bool { return openContainer == container; }
 
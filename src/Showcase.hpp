@@ -19,17 +19,32 @@
 #ifndef SHOWCASE_HPP
 #define SHOWCASE_HPP
 
+#include <unordered_map>
+#include <vector>
+
 class Container;
+class Player;
 
 class Showcase {
 public:
-    Showcase(Container *container, bool carry);
+    Showcase(Player *viewer, Container *container, bool carry);
+    Showcase(const Showcase &) = delete;
+    auto operator=(const Showcase &) -> Showcase & = delete;
+    Showcase(Showcase &&) = delete;
+    auto operator=(Showcase &&) -> Showcase & = delete;
+    ~Showcase();
 
     [[nodiscard]] auto inInventory() const -> bool;
     [[nodiscard]] auto getContainer() const -> Container *;
     auto contains(Container *container) const -> bool;
 
+    // players with a showcase of the container open, copied since closing showcases alters the index
+    [[nodiscard]] static auto viewersOf(const Container *container) -> std::vector<Player *>;
+
 private:
+    static std::unordered_map<const Container *, std::vector<Player *>> viewers;
+
+    Player *viewer;
     Container *openContainer;
     bool isInInventory;
 };
@@ -0,0 +1,126 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SKILL_SET_HPP
+#define SKILL_SET_HPP
+
+#include "types.hpp"
+
+#include <bitset>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+struct SkillValue {
+    int major = 0;
+    int minor = 0;
+};
+
+// Skills of a character indexed directly by skill id. Ids are small, so the values sit in a vector grown up to the
+// highest id learned, and one bit per id tells which skills the character has.
+class SkillSet {
+public:
+    using key_type = TYPE_OF_SKILL_ID;
+
+    // iterates over pairs of skill id and value in id order
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<key_type, SkillValue>;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::pair<key_type, const SkillValue &>;
+
+        struct pointer {
+            reference pair;
+            auto operator->() const -> const reference * { return &pair; }
+        };
+
+        const_iterator() = default;
+        const_iterator(const SkillSet *skills, size_t id) : skills(skills), id(skills->nextLearned(id)) {}
+
+        auto operator*() const -> reference { return {static_cast<key_type>(id), skills->values[id]}; }
+        auto operator->() const -> pointer { return {**this}; }
+
+        auto operator++() -> const_iterator & {
+            id = skills->nextLearned(id + 1);
+            return *this;
+        }
+
+        auto operator++(int) -> const_iterator {
+            auto previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        auto operator==(const const_iterator &other) const -> bool { return id == other.id; }
+        auto operator!=(const const_iterator &other) const -> bool { return id != other.id; }
+
+    private:
+        const SkillSet *skills = nullptr;
+        size_t id = 0;
+    };
+
+    [[nodiscard]] auto begin() const -> const_iterator { return {this, 0}; }
+    [[nodiscard]] auto end() const -> const_iterator { return {this, values.size()}; }
+
+    [[nodiscard]] auto size() const -> size_t { return learned.count(); }
+    [[nodiscard]] auto empty() const -> bool { return learned.none(); }
+
+    // nullptr if the skill was not learned
+    [[nodiscard]] auto find(key_type id) const -> const SkillValue * { return learned[id] ? &values[id] : nullptr; }
+    auto find(key_type id) -> SkillValue * { return learned[id] ? &values[id] : nullptr; }
+
+    auto set(key_type id, const SkillValue &value) -> SkillValue & {
+        if (id >= values.size()) {
+            values.resize(size_t(id) + 1);
+        }
+
+        learned.set(id);
+        return values[id] = value;
+    }
+
+    void erase(key_type id) {
+        if (learned[id]) {
+            learned.reset(id);
+            values[id] = {};
+        }
+    }
+
+    void clear() {
+        values.clear();
+        learned.reset();
+    }
+
+private:
+    static constexpr size_t idCount = size_t(std::numeric_limits<key_type>::max()) + 1;
+
+    [[nodiscard]] auto nextLearned(size_t id) const -> size_t {
+        while (id < values.size() && !learned[id]) {
+            ++id;
+        }
+
+        return id;
+    }
+
+    std::vector<SkillValue> values;
+    std::bitset<idCount> learned;
+};
+
+#endif
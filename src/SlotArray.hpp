@@ -0,0 +1,216 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SLOT_ARRAY_HPP
+#define SLOT_ARRAY_HPP
+
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+// Values indexed by container slot, stored flat with one bit per occupied slot. It mimics the part of the std::map
+// interface containers need, so iteration still runs in slot order and yields pairs of slot and value.
+template <typename T> class SlotArray {
+public:
+    using key_type = TYPE_OF_CONTAINERSLOTS;
+    using mapped_type = T;
+    using value_type = std::pair<key_type, T>;
+    using size_type = std::size_t;
+
+    template <typename Array, typename Value> class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = SlotArray::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value *;
+        using reference = Value &;
+
+        Iterator() = default;
+        Iterator(Array *array, size_type slot) : array(array), slot(slot) {}
+
+        template <typename OtherArray, typename OtherValue>
+        Iterator(const Iterator<OtherArray, OtherValue> &other) // NOLINT(google-explicit-constructor)
+                : array(other.array), slot(other.slot) {}
+
+        auto operator*() const -> reference { return array->slots[slot]; }
+        auto operator->() const -> pointer { return &array->slots[slot]; }
+
+        auto operator++() -> Iterator & {
+            slot = array->nextOccupied(slot + 1);
+            return *this;
+        }
+
+        auto operator++(int) -> Iterator {
+            auto previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        auto operator==(const Iterator &other) const -> bool { return slot == other.slot; }
+        auto operator!=(const Iterator &other) const -> bool { return slot != other.slot; }
+
+    private:
+        friend class SlotArray;
+        template <typename, typename> friend class Iterator;
+
+        Array *array = nullptr;
+        size_type slot = 0;
+    };
+
+    using iterator = Iterator<SlotArray, value_type>;
+    using const_iterator = Iterator<const SlotArray, const value_type>;
+
+    [[nodiscard]] auto begin() -> iterator { return {this, nextOccupied(0)}; }
+    [[nodiscard]] auto end() -> iterator { return {this, slots.size()}; }
+    [[nodiscard]] auto begin() const -> const_iterator { return {this, nextOccupied(0)}; }
+    [[nodiscard]] auto end() const -> const_iterator { return {this, slots.size()}; }
+    [[nodiscard]] auto cbegin() const -> const_iterator { return begin(); }
+    [[nodiscard]] auto cend() const -> const_iterator { return end(); }
+
+    [[nodiscard]] auto size() const -> size_type { return occupied; }
+    [[nodiscard]] auto empty() const -> bool { return occupied == 0; }
+    // heap bytes of the slots, without what the values own
+    [[nodiscard]] auto memoryUsage() const -> size_t {
+        return slots.capacity() * sizeof(value_type) + bits.capacity() * sizeof(Word);
+    }
+
+    [[nodiscard]] auto contains(key_type slot) const -> bool {
+        return slot < slots.size() && (bits[slot / wordBits] & bit(slot)) != 0;
+    }
+
+    [[nodiscard]] auto find(key_type slot) -> iterator { return {this, contains(slot) ? slot : slots.size()}; }
+
+    [[nodiscard]] auto find(key_type slot) const -> const_iterator {
+        return {this, contains(slot) ? slot : slots.size()};
+    }
+
+    // lowest slot below limit that holds no value, limit if there is none
+    [[nodiscard]] auto firstFree(size_type limit) const -> size_type {
+        for (size_type word = 0; word < bits.size() && word * wordBits < limit; ++word) {
+            if (const auto freeBits = ~bits[word]; freeBits != 0) {
+                const auto slot = word * wordBits + lowestBit(freeBits);
+                return slot < limit ? slot : limit;
+            }
+        }
+
+        const auto slot = bits.size() * wordBits;
+        return slot < limit ? slot : limit;
+    }
+
+    // makes room for the given number of slots up front, so later inserts do not reallocate
+    void reserve(size_type capacity) {
+        if (capacity > slots.size()) {
+            const auto first = slots.size();
+            slots.resize(capacity);
+
+            for (auto slot = first; slot < capacity; ++slot) {
+                slots[slot].first = static_cast<key_type>(slot);
+            }
+
+            bits.resize((capacity + wordBits - 1) / wordBits, 0);
+        }
+    }
+
+    auto insert(const value_type &value) -> std::pair<iterator, bool> {
+        const auto slot = value.first;
+
+        if (contains(slot)) {
+            return {{this, slot}, false};
+        }
+
+        reserve(size_type(slot) + 1);
+        slots[slot].second = value.second;
+        bits[slot / wordBits] |= bit(slot);
+        ++occupied;
+        return {{this, slot}, true};
+    }
+
+    auto erase(key_type slot) -> size_type {
+        if (!contains(slot)) {
+            return 0;
+        }
+
+        slots[slot].second = T{};
+        bits[slot / wordBits] &= ~bit(slot);
+        --occupied;
+        return 1;
+    }
+
+    auto erase(const_iterator position) -> iterator {
+        const auto next = nextOccupied(position.slot + 1);
+        erase(static_cast<key_type>(position.slot));
+        return {this, next};
+    }
+
+    void clear() {
+        for (auto &slot : slots) {
+            slot.second = T{};
+        }
+
+        bits.assign(bits.size(), 0);
+        occupied = 0;
+    }
+
+private:
+    using Word = uint64_t;
+    static constexpr size_type wordBits = 64;
+
+    static constexpr auto bit(size_type slot) -> Word { return Word(1) << (slot % wordBits); }
+
+    static auto lowestBit(Word word) -> size_type {
+        size_type index = 0;
+
+        while ((word & 1) == 0) {
+            word >>= 1;
+            ++index;
+        }
+
+        return index;
+    }
+
+    // first occupied slot at or after the given one, the capacity if there is none
+    [[nodiscard]] auto nextOccupied(size_type slot) const -> size_type {
+        auto word = slot / wordBits;
+
+        if (word >= bits.size()) {
+            return slots.size();
+        }
+
+        auto remaining = bits[word] & (~Word(0) << (slot % wordBits));
+
+        while (remaining == 0) {
+            if (++word == bits.size()) {
+                return slots.size();
+            }
+
+            remaining = bits[word];
+        }
+
+        return word * wordBits + lowestBit(remaining);
+    }
+
+    std::vector<value_type> slots;
+    std::vector<Word> bits;
+    size_type occupied = 0;
+};
+
+#endif
@@ -0,0 +1,139 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SLOT_MAP_HPP
+#define SLOT_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// refers to a value of a SlotMap, a default constructed handle never refers to anything
+struct SlotHandle {
+    uint32_t index = 0;
+    uint32_t generation = 0;
+};
+
+// Keeps values densely packed for iteration and hands out handles that stay valid until the value is erased.
+// Lookups by handle are an index plus a generation compare, erasing moves the last value into the gap.
+template <class T> class SlotMap {
+public:
+    using iterator = typename std::vector<T>::iterator;
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    auto insert(T value) -> SlotHandle {
+        uint32_t index = 0;
+
+        if (freeSlots.empty()) {
+            index = static_cast<uint32_t>(slots.size());
+            slots.emplace_back();
+        } else {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+
+        auto &slot = slots[index];
+        slot.value = static_cast<uint32_t>(values.size());
+        values.push_back(std::move(value));
+        owners.push_back(index);
+        return {index, slot.generation};
+    }
+
+    auto erase(SlotHandle handle) -> bool {
+        if (!contains(handle)) {
+            return false;
+        }
+
+        const auto gap = slots[handle.index].value;
+
+        if (gap + 1 != values.size()) {
+            values[gap] = std::move(values.back());
+            owners[gap] = owners.back();
+            slots[owners[gap]].value = gap;
+        }
+
+        values.pop_back();
+        owners.pop_back();
+        release(handle.index);
+        return true;
+    }
+
+    [[nodiscard]] auto contains(SlotHandle handle) const -> bool {
+        return handle.index < slots.size() && slots[handle.index].generation == handle.generation &&
+               slots[handle.index].value != unused;
+    }
+
+    // nullptr if handle does not refer to a value (anymore)
+    [[nodiscard]] auto get(SlotHandle handle) const -> const T * {
+        return contains(handle) ? &values[slots[handle.index].value] : nullptr;
+    }
+
+    auto get(SlotHandle handle) -> T * { return contains(handle) ? &values[slots[handle.index].value] : nullptr; }
+
+    void clear() {
+        for (const auto index : owners) {
+            release(index);
+        }
+
+        values.clear();
+        owners.clear();
+    }
+
+    [[nodiscard]] auto size() const -> size_t { return values.size(); }
+    [[nodiscard]] auto empty() const -> bool { return values.empty(); }
+    // heap bytes of the map, without what the values own
+    [[nodiscard]] auto memoryUsage() const -> size_t {
+        return slots.capacity() * sizeof(Slot) + (freeSlots.capacity() + owners.capacity()) * sizeof(uint32_t) +
+               values.capacity() * sizeof(T);
+    }
+
+    auto begin() -> iterator { return values.begin(); }
+    auto end() -> iterator { return values.end(); }
+    [[nodiscard]] auto begin() const -> const_iterator { return values.begin(); }
+    [[nodiscard]] auto end() const -> const_iterator { return values.end(); }
+
+private:
+    static constexpr auto unused = std::numeric_limits<uint32_t>::max();
+
+    struct Slot {
+        // handles of earlier values of this slot carry older generations, 0 is left to default handles
+        uint32_t generation = 1;
+        uint32_t value = unused;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::vector<T> values;
+    // slot index of every value
+    std::vector<uint32_t> owners;
+
+    void release(uint32_t index) {
+        auto &slot = slots[index];
+        slot.value = unused;
+
+        if (++slot.generation == 0) {
+            slot.generation = 1;
+        }
+
+        freeSlots.push_back(index);
+    }
+};
+
+#endif
@@ -0,0 +1,187 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef SMALL_VECTOR_HPP
+#define SMALL_VECTOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+// Vector keeping up to N elements in place, so that short sequences need no heap memory. Only the operations the
+// server uses are provided; like std::vector, growing or erasing invalidates iterators.
+template <typename T, size_t N> class SmallVector {
+    static_assert(N > 0, "a small vector needs room for at least one element in place");
+
+public:
+    using value_type = T;
+    using size_type = uint32_t;
+    using iterator = T *;
+    using const_iterator = const T *;
+
+    SmallVector() = default;
+    SmallVector(const SmallVector &other) { assign(other.begin(), other.end()); }
+    auto operator=(const SmallVector &other) -> SmallVector & {
+        if (this != &other) {
+            clear();
+            assign(other.begin(), other.end());
+        }
+
+        return *this;
+    }
+    SmallVector(SmallVector &&other) noexcept { take(std::move(other)); }
+    auto operator=(SmallVector &&other) noexcept -> SmallVector & {
+        if (this != &other) {
+            clear();
+            release();
+            take(std::move(other));
+        }
+
+        return *this;
+    }
+    ~SmallVector() {
+        clear();
+        release();
+    }
+
+    [[nodiscard]] auto begin() -> iterator { return data(); }
+    [[nodiscard]] auto end() -> iterator { return data() + count; }
+    [[nodiscard]] auto begin() const -> const_iterator { return data(); }
+    [[nodiscard]] auto end() const -> const_iterator { return data() + count; }
+
+    [[nodiscard]] auto size() const -> size_type { return count; }
+    [[nodiscard]] auto empty() const -> bool { return count == 0; }
+    [[nodiscard]] auto capacity() const -> size_type { return reserved; }
+    // whether the elements are kept in place, i.e. no heap memory is held
+    [[nodiscard]] auto isInline() const -> bool { return reserved == N; }
+
+    auto operator[](size_type pos) -> T & { return data()[pos]; }
+    auto operator[](size_type pos) const -> const T & { return data()[pos]; }
+    auto at(size_type pos) -> T & {
+        check(pos);
+        return data()[pos];
+    }
+    [[nodiscard]] auto at(size_type pos) const -> const T & {
+        check(pos);
+        return data()[pos];
+    }
+    auto back() -> T & { return data()[count - 1]; }
+    [[nodiscard]] auto back() const -> const T & { return data()[count - 1]; }
+
+    void push_back(const T &value) { emplace_back(value); }
+    void push_back(T &&value) { emplace_back(std::move(value)); }
+
+    template <typename... Args> auto emplace_back(Args &&...args) -> T & {
+        if (count == reserved) {
+            // constructed before moving, args may refer to an element
+            T value(std::forward<Args>(args)...);
+            grow();
+            return *new (data() + count++) T(std::move(value));
+        }
+
+        return *new (data() + count++) T(std::forward<Args>(args)...);
+    }
+
+    void pop_back() { data()[--count].~T(); }
+
+    auto erase(const_iterator position) -> iterator {
+        auto *target = begin() + (position - begin());
+        std::move(target + 1, end(), target);
+        pop_back();
+        return target;
+    }
+
+    void clear() {
+        std::destroy(begin(), end());
+        count = 0;
+    }
+
+private:
+    union Storage {
+        Storage() {}
+        ~Storage() {}
+
+        T inPlace[N];
+        T *heap;
+    } storage;
+
+    size_type count = 0;
+    size_type reserved = N;
+
+    [[nodiscard]] auto data() -> T * { return isInline() ? storage.inPlace : storage.heap; }
+    [[nodiscard]] auto data() const -> const T * { return isInline() ? storage.inPlace : storage.heap; }
+
+    void check(size_type pos) const {
+        if (pos >= count) {
+            throw std::out_of_range("SmallVector index out of range");
+        }
+    }
+
+    template <typename Iterator> void assign(Iterator first, Iterator last) {
+        for (; first != last; ++first) {
+            emplace_back(*first);
+        }
+    }
+
+    void grow() {
+        const auto newCapacity = static_cast<size_type>(2 * reserved);
+        auto *elements = std::allocator<T>().allocate(newCapacity);
+        std::uninitialized_move(begin(), end(), elements);
+        std::destroy(begin(), end());
+        release();
+        storage.heap = elements;
+        reserved = newCapacity;
+    }
+
+    // gives back heap memory, the elements must have been destroyed already
+    void release() {
+        if (!isInline()) {
+            std::allocator<T>().deallocate(storage.heap, reserved);
+            reserved = N;
+        }
+    }
+
+    void take(SmallVector &&other) noexcept {
+        if (other.isInline()) {
+            std::uninitialized_move(other.begin(), other.end(), storage.inPlace);
+            count = other.count;
+            other.clear();
+        } else {
+            storage.heap = other.storage.heap;
+            count = other.count;
+            reserved = other.reserved;
+            other.count = 0;
+            other.reserved = N;
+        }
+    }
+};
+
+namespace memory {
+
+template <typename T, size_t N> auto of(const SmallVector<T, N> &vector) -> size_t {
+    return vector.isInline() ? 0 : vector.capacity() * sizeof(T);
+}
+
+} // namespace memory
+
+#endif
@@ -28,6 +28,7 @@
 #include "db/SelectQuery.hpp"
 #include "map/Field.hpp"
 
+#include <algorithm>
 #include <boost/cstdint.hpp>
 #include <range/v3/all.hpp>
 
@@ -35,8 +36,7 @@
 SpawnPoint::SpawnPoint(const position &pos, Coordinate Range, Coordinate Spawnrange, uint16_t Min_Spawntime,
                        uint16_t Max_Spawntime, bool Spawnall)
         : world(World::get()), spawnpos(pos), range(Range), spawnrange(Spawnrange), min_spawntime(Min_Spawntime),
-          max_spawntime(Max_Spawntime), nextspawntime(Random::uniform(Min_Spawntime, Max_Spawntime)),
-          spawnall(Spawnall) {}
+          max_spawntime(Max_Spawntime), spawnall(Spawnall) {}
 
 //! add new Monstertyp to SpawnList...
 void SpawnPoint::addMonster(TYPE_OF_CHARACTER_ID type, int count) {
@@ -57,50 +57,46 @@ void SpawnPoint::addMonster(TYPE_OF_CHARACTER_ID type, int count) {
 
 //! do spawns if possible...
 void SpawnPoint::spawn() {
-    if (nextspawntime == 0) {
-        // set new spawntime
-        nextspawntime = Random::uniform(min_spawntime, max_spawntime);
+    armed = false;
 
-        // do we want monsters to spawn?
-        if (!World::get()->isSpawnEnabled()) {
-            return;
-        }
-
-        // check all monstertyps...
-        for (auto &spawn : SpawnTypes) {
-            // less monster spawned than we need?
-            int num = spawn.max_count - spawn.akt_count;
-            if (num > 0) {
-                try {
-                    // spawn some new baddies :)
-                    if (!spawnall) {
-                        num = Random::uniform(1, num);
-                    }
+    // check all monstertyps...
+    for (auto &spawn : SpawnTypes) {
+        // less monster spawned than we need?
+        int num = spawn.max_count - spawn.akt_count;
+        if (num > 0) {
+            try {
+                // spawn some new baddies :)
+                if (!spawnall) {
+                    num = Random::uniform(1, num);
+                }
 
-                    for (int i = 0; i < num; ++i) {
-                        // set the new spawnpos in the range of the spawnrange around the spawnpoint
-                        const position tempPos(
-                                (spawnpos.x - spawnrange) + Random::uniform(Coordinate{0}, 2 * spawnrange),
-                                (spawnpos.y - spawnrange) + Random::uniform(Coordinate{0}, 2 * spawnrange), spawnpos.z);
-
-                        // end of setting the new spawnpos
-                        try {
-                            map::Field &field = world->walkableFieldNear(tempPos);
-                            auto *newmonster = new Monster(spawn.typ, field.getPosition(), this);
-                            ++spawn.akt_count;
-                            world->newMonsters.push_back(newmonster);
-                            field.setPlayer();
-                            world->sendCharacterMoveToAllVisiblePlayers(newmonster, NORMALMOVE, 4);
-                        } catch (FieldNotFound &) {
-                        }
+                for (int i = 0; i < num; ++i) {
+                    try {
+                        map::Field &field = spawnField();
+                        auto *newmonster = new Monster(spawn.typ, field.getPosition(), this);
+                        ++spawn.akt_count;
+                        world->addNewMonster(newmonster);
+                        field.setPlayer();
+                        world->sendCharacterMoveToAllVisiblePlayers(newmonster, NORMALMOVE, 4);
+                    } catch (FieldNotFound &) {
                     }
-                } catch (Monster::unknownIDException &) {
-                    Logger::error(LogFacility::Other) << "Could not create unknown monster " << spawn.typ << Log::end;
                 }
+            } catch (Monster::unknownIDException &) {
+                Logger::error(LogFacility::Other) << "Could not create unknown monster " << spawn.typ << Log::end;
             }
         }
-    } else {
-        --nextspawntime;
+
+        if (spawn.akt_count < spawn.max_count) {
+            arm();
+        }
+    }
+}
+
+void SpawnPoint::arm() {
+    if (!armed) {
+        armed = true;
+        // a spawn time of n cycles means spawning on the n+1th cycle from now
+        world->scheduleSpawn(*this, Random::uniform(min_spawntime, max_spawntime) + 1);
     }
 }
 
@@ -110,6 +106,75 @@ void SpawnPoint::dead(TYPE_OF_CHARACTER_ID type) {
             spawn.akt_count--;
         }
     }
+
+    arm();
+}
+
+auto SpawnPoint::isSpawnAreaCurrent() const -> bool {
+    if (spawnAreaChunks.empty()) {
+        return false;
+    }
+
+    const auto &versions = map::ChunkVersions::get();
+
+    return std::all_of(spawnAreaChunks.begin(), spawnAreaChunks.end(),
+                       [&versions](const ChunkStamp &chunk) { return versions.of(chunk.first) == chunk.second; });
+}
+
+void SpawnPoint::buildSpawnArea() {
+    spawnArea.clear();
+    spawnAreaChunks.clear();
+
+    const auto &versions = map::ChunkVersions::get();
+    constexpr auto chunkSize = 1 << map::ChunkVersions::chunkBits;
+    const auto minX = spawnpos.x - spawnrange;
+    const auto maxX = spawnpos.x + spawnrange;
+    const auto minY = spawnpos.y - spawnrange;
+    const auto maxY = spawnpos.y + spawnrange;
+
+    // stamped before reading the fields so a change while building invalidates the area
+    for (auto chunkX = minX >> map::ChunkVersions::chunkBits; chunkX <= maxX >> map::ChunkVersions::chunkBits;
+         ++chunkX) {
+        for (auto chunkY = minY >> map::ChunkVersions::chunkBits; chunkY <= maxY >> map::ChunkVersions::chunkBits;
+             ++chunkY) {
+            const position corner(chunkX * chunkSize, chunkY * chunkSize, spawnpos.z);
+            const auto key = map::ChunkVersions::chunkKey(corner);
+            spawnAreaChunks.emplace_back(key, versions.of(key));
+        }
+    }
+
+    for (auto x = minX; x <= maxX; ++x) {
+        for (auto y = minY; y <= maxY; ++y) {
+            const position pos(x, y, spawnpos.z);
+
+            try {
+                if (world->fieldAt(pos).isWalkable()) {
+                    spawnArea.push_back(pos);
+                }
+            } catch (FieldNotFound &) {
+            }
+        }
+    }
+}
+
+auto SpawnPoint::spawnField() -> map::Field & {
+    if (!isSpawnAreaCurrent()) {
+        buildSpawnArea();
+    }
+
+    // walkable fields may still be occupied by characters, which do not change the chunk versions
+    for (int attempt = 0; attempt < placementAttempts && !spawnArea.empty(); ++attempt) {
+        auto &field = world->fieldAt(spawnArea[Random::uniform(spawnArea.size())]);
+
+        if (field.moveToPossible()) {
+            return field;
+        }
+    }
+
+    // crowded or no walkable field in range, the search around a random position reaches beyond the spawnrange
+    const position tempPos((spawnpos.x - spawnrange) + Random::uniform(Coordinate{0}, 2 * spawnrange),
+                           (spawnpos.y - spawnrange) + Random::uniform(Coordinate{0}, 2 * spawnrange), spawnpos.z);
+    return world->walkableFieldNear(tempPos);
 }
 
 auto SpawnPoint::load(const int &id) -> bool {
@@ -22,8 +22,15 @@
 #define SPAWNPOINT_HPP
 
 #include "globals.hpp"
+#include "map/ChunkVersions.hpp"
 
 #include <list>
+#include <utility>
+#include <vector>
+
+namespace map {
+class Field;
+}
 
 // just declare a class named World...
 class World;
@@ -40,8 +47,12 @@ public:
     //! load spawnpoints from database
     auto load(const int &id) -> bool;
 
+    //! spawns the missing monsters and rearms itself if some could not be placed
     void spawn();
 
+    //! schedules the next spawn unless one is scheduled already
+    void arm();
+
     //! callback called by dying monsters belonging to spawnpoint
     void dead(TYPE_OF_CHARACTER_ID type);
 
@@ -67,8 +78,8 @@ private:
     uint16_t min_spawntime;
     uint16_t max_spawntime;
 
-    // the number of cycles until the next spawn
-    uint16_t nextspawntime;
+    // whether the world has a spawn scheduled for this point
+    bool armed = false;
 
     // should be all monsters respawned in every cycle
     bool spawnall;
@@ -81,7 +92,17 @@ private:
 
     std::list<struct SpawnEntryStruct> SpawnTypes;
 
+    using ChunkStamp = std::pair<map::ChunkVersions::ChunkKey, map::ChunkVersions::Version>;
+    // walkable fields within the spawnrange, valid while the chunks they lie in are unchanged
+    std::vector<position> spawnArea;
+    std::vector<ChunkStamp> spawnAreaChunks;
+
+    [[nodiscard]] auto isSpawnAreaCurrent() const -> bool;
+    void buildSpawnArea();
+    auto spawnField() -> map::Field &;
+
     static constexpr Coordinate defaultWalkRange = 20;
+    static constexpr int placementAttempts = 8;
 };
 
 #endif
@@ -0,0 +1,141 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "StartupGraph.hpp"
+
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+void StartupGraph::add(std::string name, const std::vector<std::string> &dependencies, Task task) {
+    Stage stage{std::move(name), {}, std::move(task)};
+
+    for (const auto &dependency : dependencies) {
+        const auto found = std::find_if(stages.begin(), stages.end(),
+                                        [&dependency](const Stage &added) { return added.name == dependency; });
+
+        if (found == stages.end()) {
+            throw std::logic_error("startup stage " + stage.name + " depends on unknown stage " + dependency);
+        }
+
+        stage.dependencies.push_back(found - stages.begin());
+    }
+
+    stages.push_back(std::move(stage));
+}
+
+auto StartupGraph::run() -> bool {
+    if (stages.empty()) {
+        return true;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const size_t workerCount = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, stages.size());
+    std::vector<std::thread> workers;
+    workers.reserve(workerCount);
+
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back([this] { work(); });
+    }
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    const auto total = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+    Logger::info(LogFacility::Other) << "startup took " << total.count() << "ms" << Log::end;
+
+    return std::all_of(stages.begin(), stages.end(),
+                       [](const Stage &stage) { return stage.state == State::succeeded; });
+}
+
+void StartupGraph::work() {
+    using Clock = std::chrono::steady_clock;
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        size_t index = stages.size();
+        stageDone.wait(lock, [this, &index] {
+            index = takeReady();
+            return index < stages.size() || !anyWaiting();
+        });
+
+        if (index == stages.size()) {
+            return;
+        }
+
+        // stages are not added while running, so the reference stays valid without the lock
+        auto &stage = stages[index];
+        lock.unlock();
+
+        const auto start = Clock::now();
+        bool succeeded = false;
+
+        try {
+            succeeded = stage.task();
+        } catch (std::exception &e) {
+            Logger::error(LogFacility::Other) << "startup stage " << stage.name << " failed: " << e.what() << Log::end;
+        }
+
+        const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+        Logger::info(LogFacility::Other) << "startup stage " << stage.name << (succeeded ? " took " : " failed after ")
+                                         << duration.count() << "ms" << Log::end;
+
+        lock.lock();
+        stage.state = succeeded ? State::succeeded : State::failed;
+        completed.push_back({stage.name, duration, succeeded});
+        stageDone.notify_all();
+    }
+}
+
+auto StartupGraph::takeReady() -> size_t {
+    // dependencies come before their dependents, so a single pass carries a failure through the graph
+    for (size_t index = 0; index < stages.size(); ++index) {
+        auto &stage = stages[index];
+
+        if (stage.state != State::waiting) {
+            continue;
+        }
+
+        const auto &dependencies = stage.dependencies;
+
+        if (std::any_of(dependencies.begin(), dependencies.end(),
+                        [this](size_t dependency) { return stages[dependency].state == State::failed; })) {
+            stage.state = State::failed;
+            Logger::error(LogFacility::Other) << "startup stage " << stage.name << " skipped" << Log::end;
+            continue;
+        }
+
+        if (std::all_of(dependencies.begin(), dependencies.end(),
+                        [this](size_t dependency) { return stages[dependency].state == State::succeeded; })) {
+            stage.state = State::running;
+            return index;
+        }
+    }
+
+    return stages.size();
+}
+
+auto StartupGraph::anyWaiting() const -> bool {
+    return std::any_of(stages.begin(), stages.end(), [](const Stage &stage) { return stage.state == State::waiting; });
+}
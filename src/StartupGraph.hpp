@@ -0,0 +1,73 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef STARTUP_GRAPH_HPP
+#define STARTUP_GRAPH_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Runs the stages of the server startup on a small pool of threads, each as soon as the stages it depends on have
+// succeeded, and records how long every stage took.
+class StartupGraph {
+public:
+    using Task = std::function<bool()>;
+
+    struct Timing {
+        std::string stage;
+        std::chrono::milliseconds duration{};
+        bool succeeded = false;
+    };
+
+    // a stage can only depend on stages added before it, which keeps the graph free of cycles
+    void add(std::string name, const std::vector<std::string> &dependencies, Task task);
+
+    // stages depending on a failed stage are skipped, returns whether every stage succeeded
+    auto run() -> bool;
+
+    // in order of completion, skipped stages have none
+    [[nodiscard]] auto timings() const -> const std::vector<Timing> & { return completed; }
+
+private:
+    enum class State { waiting, running, succeeded, failed };
+
+    struct Stage {
+        std::string name;
+        std::vector<size_t> dependencies;
+        Task task;
+        State state = State::waiting;
+    };
+
+    std::vector<Stage> stages;
+    std::vector<Timing> completed;
+    std::mutex mutex;
+    std::condition_variable stageDone;
+
+    void work();
+    // marks the next ready stage as running, skipping those after a failure; stages.size() if none is ready
+    auto takeReady() -> size_t;
+    [[nodiscard]] auto anyWaiting() const -> bool;
+};
+
+#endif
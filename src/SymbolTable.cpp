@@ -0,0 +1,78 @@
+/*
+ * illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of illarionserver.
+ *
+ * illarionserver is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * illarionserver is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SymbolTable.hpp"
+
+#include <mutex>
+#include <stdexcept>
+
+auto SymbolTable::get() -> SymbolTable & {
+    static SymbolTable table;
+    return table;
+}
+
+auto SymbolTable::intern(const std::string &text) -> Id {
+    if (const auto id = find(text)) {
+        return *id;
+    }
+
+    std::unique_lock lock(mutex);
+
+    if (const auto existing = ids.find(text); existing != ids.end()) {
+        return existing->second;
+    }
+
+    const auto chunk = next >> chunkBits;
+
+    if (chunk >= maxChunks) {
+        throw std::length_error("symbol table is full");
+    }
+
+    if (!owned[chunk]) {
+        owned[chunk] = std::make_unique<Chunk>();
+        chunks[chunk].store(owned[chunk].get(), std::memory_order_release);
+    }
+
+    auto &stored = (*owned[chunk])[next & (chunkSize - 1)];
+    stored = text;
+    ids.emplace(stored, next);
+    return next++;
+}
+
+auto SymbolTable::find(const std::string &text) const -> std::optional<Id> {
+    std::shared_lock lock(mutex);
+
+    if (const auto existing = ids.find(text); existing != ids.end()) {
+        return existing->second;
+    }
+
+    return std::nullopt;
+}
+
+auto SymbolTable::text(Id id) const -> const std::string & {
+    // ids are only handed out after their text is stored, whoever got hold of one may read it
+    const auto *chunk = chunks[id >> chunkBits].load(std::memory_order_acquire);
+    return (*chunk)[id & (chunkSize - 1)];
+}
+
+auto SymbolTable::size() const -> size_t {
+    std::shared_lock lock(mutex);
+    return next;
+}
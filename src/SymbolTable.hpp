@@ -0,0 +1,64 @@
+/*
+ * illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of illarionserver.
+ *
+ * illarionserver is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * illarionserver is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SYMBOL_TABLE_HPP
+#define SYMBOL_TABLE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Strings interned for the lifetime of the server, each known by a 32-bit id so that comparing and hashing them is
+// an integer operation. Symbols are never released, so only strings from a small set belong here, like the keys of
+// item data. Safe to use from any thread.
+class SymbolTable {
+public:
+    using Id = uint32_t;
+
+    static auto get() -> SymbolTable &;
+
+    auto intern(const std::string &text) -> Id;
+    // the id of an interned string, without interning it
+    [[nodiscard]] auto find(const std::string &text) const -> std::optional<Id>;
+    [[nodiscard]] auto text(Id id) const -> const std::string &;
+    [[nodiscard]] auto size() const -> size_t;
+
+private:
+    static constexpr size_t chunkBits = 12;
+    static constexpr size_t chunkSize = 1U << chunkBits;
+    static constexpr size_t maxChunks = 1024;
+
+    using Chunk = std::array<std::string, chunkSize>;
+
+    // chunks never move once published, so text needs no lock
+    std::array<std::atomic<Chunk *>, maxChunks> chunks{};
+    std::array<std::unique_ptr<Chunk>, maxChunks> owned;
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string_view, Id> ids;
+    Id next = 0;
+};
+
+#endif
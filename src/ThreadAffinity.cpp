@@ -0,0 +1,102 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ThreadAffinity.hpp"
+
+#include "Logger.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace affinity {
+
+auto parseCores(const std::string &list) -> std::optional<std::vector<unsigned int>> {
+    std::vector<unsigned int> cores;
+    std::istringstream ranges(list);
+    std::string range;
+
+    while (std::getline(ranges, range, ',')) {
+        unsigned int first = 0;
+        unsigned int last = 0;
+        char dash = 0;
+        std::istringstream stream(range);
+
+        if (!(stream >> first)) {
+            return std::nullopt;
+        }
+
+        last = first;
+
+        if (stream >> dash && (dash != '-' || !(stream >> last) || last < first)) {
+            return std::nullopt;
+        }
+
+        if (!stream.eof() || last >= CPU_SETSIZE) {
+            return std::nullopt;
+        }
+
+        for (auto core = first; core <= last; ++core) {
+            cores.push_back(core);
+        }
+    }
+
+    return cores;
+}
+
+void pinCurrentThread(const std::string &cores, const std::string &role) {
+    if (cores.empty()) {
+        return;
+    }
+
+    const auto parsed = parseCores(cores);
+
+    if (!parsed || parsed->empty()) {
+        Logger::error(LogFacility::Other) << "invalid core list for " << role << " threads: " << cores << Log::end;
+        return;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    for (const auto core : *parsed) {
+        CPU_SET(core, &set);
+    }
+
+    if (const int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); error != 0) {
+        Logger::error(LogFacility::Other) << "could not pin " << role << " thread to cores " << cores << ": "
+                                          << std::strerror(error) << Log::end;
+        return;
+    }
+
+    Logger::info(LogFacility::Other) << role << " thread pinned to cores " << cores << Log::end;
+}
+
+void preferLocalMemory() {
+    if (syscall(SYS_set_mempolicy, MPOL_LOCAL, nullptr, 0) != 0) {
+        Logger::error(LogFacility::Other) << "could not set a local memory policy: " << std::strerror(errno)
+                                          << Log::end;
+    }
+}
+
+} // namespace affinity
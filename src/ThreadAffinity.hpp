@@ -0,0 +1,38 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef THREAD_AFFINITY_HPP
+#define THREAD_AFFINITY_HPP
+
+#include <optional>
+#include <string>
+#include <vector>
+
+// Pins server threads to the core sets of the *_thread_cores options, see Config
+namespace affinity {
+
+// cores of a list like 0-3,8, nothing if the list is malformed
+auto parseCores(const std::string &list) -> std::optional<std::vector<unsigned int>>;
+// restricts the calling thread to cores, an empty list leaves it to the scheduler; role names the thread in logs
+void pinCurrentThread(const std::string &cores, const std::string &role);
+// allocates the memory the calling thread touches first on its own NUMA node, overriding e.g. numactl --interleave
+void preferLocalMemory();
+
+} // namespace affinity
+
+#endif
@@ -0,0 +1,44 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "TickClock.hpp"
+
+namespace {
+
+auto readClock(clockid_t id) -> timespec {
+    timespec time{};
+    clock_gettime(id, &time);
+    return time;
+}
+
+// the kernel's coarse clock counts from the same start as steady_clock, which reads CLOCK_MONOTONIC
+auto coarseSteady() -> TickClock::clock::rep {
+    const auto time = readClock(CLOCK_MONOTONIC_COARSE);
+    const auto sinceStart = std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+    return std::chrono::duration_cast<TickClock::clock::duration>(sinceStart).count();
+}
+
+} // namespace
+
+std::atomic<TickClock::clock::rep> TickClock::steadyTicks{coarseSteady()};
+std::atomic<time_t> TickClock::wallSeconds{readClock(CLOCK_REALTIME_COARSE).tv_sec};
+
+void TickClock::update() {
+    steadyTicks.store(coarseSteady(), std::memory_order_relaxed);
+    wallSeconds.store(readClock(CLOCK_REALTIME_COARSE).tv_sec, std::memory_order_relaxed);
+}
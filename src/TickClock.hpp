@@ -0,0 +1,46 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TICK_CLOCK_HPP
+#define TICK_CLOCK_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+
+// the time taken once before every scheduler task, so that all gameplay checks within the task cost no clock call
+// and agree with each other; the coarse clocks lag behind by at most a few milliseconds
+class TickClock {
+public:
+    using clock = std::chrono::steady_clock;
+
+    // reads CLOCK_MONOTONIC_COARSE and CLOCK_REALTIME_COARSE
+    static void update();
+    [[nodiscard]] static auto now() -> clock::time_point {
+        return clock::time_point(clock::duration(steadyTicks.load(std::memory_order_relaxed)));
+    }
+    // seconds since the epoch, like time()
+    [[nodiscard]] static auto wallNow() -> time_t { return wallSeconds.load(std::memory_order_relaxed); }
+
+private:
+    static std::atomic<clock::rep> steadyTicks;
+    static std::atomic<time_t> wallSeconds;
+};
+
+#endif
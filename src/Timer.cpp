@@ -18,10 +18,12 @@
 
 #include "Timer.hpp"
 
-Timer::Timer(duration interval) : lastIntervalExceeded(clock::now()), interval(interval) {}
+#include "TickClock.hpp"
+
+Timer::Timer(duration interval) : lastIntervalExceeded(TickClock::now()), interval(interval) {}
 
 auto Timer::intervalExceeded() -> bool {
-    auto now = clock::now();
+    auto now = TickClock::now();
     auto timePassed = now - lastIntervalExceeded;
 
     if (timePassed >= interval) {
@@ -23,6 +23,7 @@
 
 class Timer {
 public:
+    // reads the TickClock, so the interval is only checked against the start of the current task
     using clock = std::chrono::steady_clock;
     using timePoint = clock::time_point;
     using duration = clock::duration;
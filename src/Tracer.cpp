@@ -0,0 +1,93 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Tracer.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+namespace {
+
+void writeEscaped(std::ostream &out, const char *text) {
+    for (; *text != '\0'; ++text) {
+        if (*text == '"' || *text == '\\') {
+            out << '\\';
+        }
+
+        out << *text;
+    }
+}
+
+} // namespace
+
+auto Tracer::get() -> Tracer & {
+    static Tracer tracer;
+    return tracer;
+}
+
+void Tracer::record(const char *name, Clock::time_point start, Clock::time_point end) {
+    auto &event = events[next];
+    event.name = name;
+    event.start = start;
+    event.duration = end - start;
+
+    if (++next == capacity) {
+        next = 0;
+        wrapped = true;
+    }
+}
+
+auto Tracer::dump(const std::string &path) const -> bool {
+    std::ofstream out(path);
+
+    if (!out) {
+        return false;
+    }
+
+    using std::chrono::duration;
+    using Microseconds = duration<double, std::micro>;
+    const auto first = wrapped ? next : 0;
+    const auto count = wrapped ? capacity : next;
+    // zones are stored as they end, so an enclosing zone comes after the ones it contains
+    auto epoch = Clock::time_point::max();
+
+    for (size_t i = 0; i < count; ++i) {
+        epoch = std::min(epoch, events[i].start);
+    }
+
+    bool separate = false;
+
+    out << R"({"displayTimeUnit":"ms","traceEvents":[)";
+
+    for (size_t i = 0; i < count; ++i) {
+        const auto &event = events[(first + i) % capacity];
+
+        if (separate) {
+            out << ',';
+        }
+
+        separate = true;
+        out << R"({"ph":"X","pid":1,"tid":1,"name":")";
+        writeEscaped(out, event.name);
+        out << R"(","ts":)" << Microseconds(event.start - epoch).count()
+            << R"(,"dur":)" << Microseconds(event.duration).count() << '}';
+    }
+
+    out << "]}\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,71 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TRACER_HPP
+#define TRACER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scoped zones of the game thread, kept in a ring of the most recent ones that can be written in the Chrome trace
+// event format for chrome://tracing or Perfetto. Recording a zone costs two clock reads and a store, so the zones
+// stay on in production. Like Lua, the tracer is used by the game thread only.
+class Tracer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static auto get() -> Tracer &;
+
+    // records its lifetime, the name has to outlive the trace, e.g. a literal or an interned task name
+    class Zone {
+    public:
+        explicit Zone(const char *name) : name(name) {}
+        Zone(const Zone &) = delete;
+        auto operator=(const Zone &) -> Zone & = delete;
+        Zone(Zone &&) = delete;
+        auto operator=(Zone &&) -> Zone & = delete;
+        ~Zone() { Tracer::get().record(name, start, Clock::now()); }
+
+    private:
+        const char *name;
+        Clock::time_point start = Clock::now();
+    };
+
+    void record(const char *name, Clock::time_point start, Clock::time_point end);
+    // writes the recorded zones as JSON, returns false if the file could not be written
+    auto dump(const std::string &path) const -> bool;
+
+private:
+    static constexpr size_t capacity = 1U << 16U;
+
+    struct Event {
+        const char *name = nullptr;
+        Clock::time_point start;
+        std::chrono::nanoseconds duration{0};
+    };
+
+    std::vector<Event> events = std::vector<Event>(capacity);
+    size_t next = 0;
+    bool wrapped = false;
+
+    Tracer() = default;
+};
+
+#endif
@@ -0,0 +1,224 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Watchdog.hpp"
+
+#include "Logger.hpp"
+#include "MonitoringClients.hpp"
+#include "World.hpp"
+#include "netinterface/protocol/BBIWIServerCommands.hpp"
+#include "script/LuaScript.hpp"
+#include "script/LuaWatchdog.hpp"
+
+#include <algorithm>
+#include <array>
+#include <csignal>
+#include <cstdlib>
+#include <execinfo.h>
+#include <memory>
+#include <sstream>
+
+extern "C" {
+#include <lauxlib.h>
+}
+
+namespace {
+
+constexpr int captureSignal = SIGUSR2;
+constexpr int maxFrames = 64;
+// time the game thread gets to answer the signal and to reach its next Lua instruction
+constexpr auto captureWait = std::chrono::milliseconds(500);
+constexpr auto pollInterval = std::chrono::milliseconds(10);
+
+// written by the signal handler and the Lua hook on the game thread, read by the watchdog thread
+std::array<void *, maxFrames> frames{};
+std::atomic<int> frameCount{-1};
+std::atomic<bool> tracebackRequested{false};
+std::atomic<bool> tracebackReady{false};
+std::mutex tracebackMutex;
+std::string traceback;
+
+void captureTraceback(lua_State *state, lua_Debug * /*debug*/) {
+    luaL_traceback(state, state, nullptr, 0);
+
+    {
+        std::lock_guard<std::mutex> lock(tracebackMutex);
+        traceback = lua_tostring(state, -1);
+    }
+
+    lua_pop(state, 1);
+    LuaWatchdog::install(state);
+    tracebackReady = true;
+}
+
+// only async-signal-safe work here, the traceback is taken by a hook once Lua executes its next instruction
+void captureStack(int /*signal*/) {
+    const int count = backtrace(frames.data(), maxFrames);
+
+    if (auto *state = LuaScript::getLuaState(); state != nullptr) {
+        tracebackRequested = true;
+        lua_sethook(state, captureTraceback, LUA_MASKCOUNT, 1);
+    }
+
+    frameCount = count;
+}
+
+template <typename Predicate> auto waitFor(Predicate done) -> bool {
+    for (auto waited = Watchdog::Clock::duration::zero(); waited < captureWait; waited += pollInterval) {
+        if (done()) {
+            return true;
+        }
+
+        std::this_thread::sleep_for(pollInterval);
+    }
+
+    return done();
+}
+
+} // namespace
+
+auto Watchdog::get() -> Watchdog & {
+    static Watchdog watchdog;
+    return watchdog;
+}
+
+void Watchdog::start(std::chrono::seconds threshold, bool notifyMonitoring) {
+    if (threshold.count() <= 0 || worker.joinable()) {
+        return;
+    }
+
+    this->threshold = threshold;
+    this->notifyMonitoring = notifyMonitoring;
+    watched = pthread_self();
+    lastBeat = Clock::now().time_since_epoch().count();
+
+    // the first backtrace loads libgcc, which must not happen inside the signal handler
+    backtrace(frames.data(), maxFrames);
+
+    struct sigaction action {};
+    action.sa_handler = captureStack;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(captureSignal, &action, nullptr);
+
+    stopping = false;
+    worker = std::thread([this] { run(); });
+    Logger::info(LogFacility::Other) << "watchdog reports game loop stalls over " << threshold.count() << "s"
+                                     << Log::end;
+}
+
+void Watchdog::heartbeat() {
+    lastBeat.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+
+    if (reportPending.load(std::memory_order_relaxed) && reportPending.exchange(false)) {
+        std::string message;
+
+        {
+            std::lock_guard<std::mutex> lock(reportMutex);
+            message.swap(pendingReport);
+        }
+
+        if (auto *world = World::get(); world != nullptr && world->monitoringClientList) {
+            world->monitoringClientList->sendCommand(std::make_shared<BBMessageTC>(message, 2));
+        }
+    }
+}
+
+void Watchdog::stop() {
+    if (!worker.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    wake.notify_one();
+    worker.join();
+    signal(captureSignal, SIG_DFL);
+}
+
+void Watchdog::run() {
+    const auto checkInterval = std::max<Clock::duration>(threshold / 4, std::chrono::seconds(1));
+    Clock::rep reportedBeat = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (!wake.wait_for(lock, checkInterval, [this] { return stopping; })) {
+        const auto beat = lastBeat.load(std::memory_order_relaxed);
+        const auto stalled = Clock::now().time_since_epoch() - Clock::duration(beat);
+
+        // one report per stall, the next one needs a heartbeat in between
+        if (stalled < threshold || beat == reportedBeat) {
+            continue;
+        }
+
+        reportedBeat = beat;
+        lock.unlock();
+        report(stalled);
+        lock.lock();
+    }
+}
+
+void Watchdog::report(Clock::duration stalled) {
+    frameCount = -1;
+    tracebackRequested = false;
+    tracebackReady = false;
+
+    // read without synchronisation, the game thread is stuck and at worst this names the previous script
+    std::string script = "none";
+
+    if (auto *world = World::get(); world != nullptr && world->getCurrentScript() != nullptr) {
+        script = world->getCurrentScript()->getFileName();
+    }
+
+    std::ostringstream out;
+    out << "game loop stalled for " << std::chrono::duration_cast<std::chrono::seconds>(stalled).count()
+        << "s, current script: " << script;
+
+    if (pthread_kill(watched, captureSignal) != 0 || !waitFor([] { return frameCount >= 0; })) {
+        out << "\nnative stack: not captured";
+    } else {
+        const int count = frameCount;
+        std::unique_ptr<char *, decltype(&std::free)> symbols(backtrace_symbols(frames.data(), count), &std::free);
+        out << "\nnative stack:";
+
+        // the first frames are the signal handler itself
+        for (int i = 2; i < count; ++i) {
+            out << "\n  " << (symbols ? symbols.get()[i] : "?");
+        }
+
+        if (!tracebackRequested) {
+            out << "\nLua traceback: no Lua state";
+        } else if (waitFor([] { return tracebackReady.load(); })) {
+            std::lock_guard<std::mutex> lock(tracebackMutex);
+            out << "\nLua " << traceback;
+        } else {
+            out << "\nLua traceback: game thread is not executing Lua";
+        }
+    }
+
+    const auto message = out.str();
+    Logger::critical(LogFacility::Other) << message << Log::end;
+
+    if (notifyMonitoring) {
+        std::lock_guard<std::mutex> lock(reportMutex);
+        pendingReport = message;
+        reportPending = true;
+    }
+}
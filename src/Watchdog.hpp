@@ -0,0 +1,66 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef WATCHDOG_HPP
+#define WATCHDOG_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <pthread.h>
+#include <string>
+#include <thread>
+
+// Watches the heartbeat of the game loop from a thread of its own. When the loop stalls beyond the threshold, the
+// native stack of the game thread and, if it is running Lua at the time, the Lua traceback are captured and logged
+// once per stall, so hangs in production can be diagnosed without attaching a debugger.
+class Watchdog {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static auto get() -> Watchdog &;
+
+    // watches the calling thread, a threshold of zero leaves the watchdog off
+    void start(std::chrono::seconds threshold, bool notifyMonitoring);
+    // called by the watched thread once per loop, also passes finished reports on to the monitoring clients
+    void heartbeat();
+    void stop();
+
+private:
+    Watchdog() = default;
+
+    void run();
+    void report(Clock::duration stalled);
+
+    std::chrono::seconds threshold{0};
+    bool notifyMonitoring = false;
+    pthread_t watched{};
+    std::atomic<Clock::rep> lastBeat{0};
+
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    std::mutex reportMutex;
+    std::string pendingReport;
+    std::atomic<bool> reportPending{false};
+};
+
+#endif
@@ -20,6 +20,13 @@
 
 #include "Logger.hpp"
 #include "World.hpp"
+#include "character_ptr.hpp"
+#include "hpa_star.hpp"
+#include "path_cache.hpp"
+#include "path_service.hpp"
+
+#include <algorithm>
+#include <utility>
 
 WaypointList::WaypointList(Character *movechar) : _movechar(movechar) {}
 
@@ -59,22 +66,175 @@ auto WaypointList::recalcStepList() -> bool {
         return false;
     }
 
+    if (pathfinding::PathService::isEnabled()) {
+        requestPath(positions.front());
+        return true;
+    }
+
     steplist.clear();
     _movechar->getStepList(positions.front(), steplist);
     return (!steplist.empty());
 }
 
+void WaypointList::requestPath(const position &goal) {
+    const auto &start = _movechar->getPosition();
+
+    if (waitingForPath && requestedStart == start && requestedGoal == goal) {
+        return;
+    }
+
+    std::list<direction> steps;
+
+    if (pathfinding::lookup_path(start, goal, steps)) {
+        steplist = std::move(steps);
+        waitingForPath = false;
+        return;
+    }
+
+    position target;
+
+    if (!pathfinding::route_target(start, goal, target)) {
+        steplist.clear();
+        pathFailed = true;
+        return;
+    }
+
+    const auto request = ++pathRequests;
+    waitingForPath = true;
+    requestedStart = start;
+    requestedGoal = goal;
+
+    // the character may be gone when the result arrives
+    pathfinding::PathService::get().request(
+            start, target,
+            [character = character_ptr(_movechar), request, start, goal](bool found,
+                                                                          const std::list<direction> &steps) {
+                if (Character *movechar = character.get(); movechar != nullptr) {
+                    movechar->waypoints.pathFound(request, start, goal, found, steps);
+                }
+            });
+}
+
+void WaypointList::pathFound(uint32_t request, const position &start, const position &goal, bool found,
+                             const std::list<direction> &steps) {
+    const bool latest = request == pathRequests;
+
+    if (latest) {
+        waitingForPath = false;
+    }
+
+    if (found) {
+        pathfinding::remember_path(start, goal, steps);
+    }
+
+    // steps from elsewhere are of no use, the character moved on while they were searched
+    if (!(_movechar->getPosition() == start)) {
+        return;
+    }
+
+    if (found) {
+        steplist = steps;
+    } else if (latest) {
+        steplist.clear();
+        pathFailed = true;
+    }
+}
+
 auto WaypointList::makeMove() -> bool {
+    if (pathFailed) {
+        pathFailed = false;
+        return false;
+    }
+
     if (steplist.empty()) {
+        if (waitingForPath) {
+            // idle until the search is done
+            return true;
+        }
+
         if (!recalcStepList()) {
             return false;
         }
+
+        if (steplist.empty()) {
+            return !std::exchange(pathFailed, false);
+        }
+    }
+
+    if (!observed) {
+        moveUnobserved();
+        return true;
     }
 
+    const auto actionPoints = _movechar->getActionPoints();
+
     if (!_movechar->move(steplist.front())) {
-        return steplist.size() > 1 && recalcStepList();
+        // characters in the way are not noticed by the path cache
+        if (!positions.empty()) {
+            pathfinding::forget_path(_movechar->getPosition(), positions.front());
+        }
+
+        if (steplist.size() <= 1) {
+            return false;
+        }
+
+        steplist.clear();
+        return recalcStepList();
     }
 
+    stepCost = std::max(actionPoints - _movechar->getActionPoints(), 1);
     steplist.pop_front();
     return true;
 }
+
+void WaypointList::moveUnobserved() {
+    auto pos = _movechar->getPosition();
+    pos.move(steplist.front());
+    lastUnobservedStep = steplist.front();
+    steplist.pop_front();
+    _movechar->setPosition(pos);
+    _movechar->increaseActionPoints(-stepCost);
+}
+
+void WaypointList::setObserved(bool observed) {
+    if (observed == this->observed) {
+        return;
+    }
+
+    auto *world = World::get();
+
+    if (!observed) {
+        // the cost of a step is only known once one was taken on the fields
+        if (stepCost == 0) {
+            return;
+        }
+
+        try {
+            world->fieldAt(_movechar->getPosition()).removeChar();
+        } catch (FieldNotFound &) {
+        }
+
+        this->observed = false;
+        return;
+    }
+
+    this->observed = true;
+    const auto logical = _movechar->getPosition();
+
+    try {
+        // someone may have stepped onto the field in the meantime
+        auto &field = world->walkableFieldNear(logical);
+        field.setChar();
+
+        if (!(field.getPosition() == logical)) {
+            _movechar->setPosition(field.getPosition());
+            world->sendCharacterWarpToAllVisiblePlayers(_movechar, logical, PUSH);
+            steplist.clear();
+        }
+    } catch (FieldNotFound &) {
+    }
+
+    if (lastUnobservedStep != dir_none) {
+        _movechar->turn(std::exchange(lastUnobservedStep, dir_none));
+    }
+}
@@ -35,12 +35,33 @@ public:
     auto getNextWaypoint(position &pos) const -> bool;
     void clear();
     auto makeMove() -> bool;
+    // with a path service the steps may arrive later, until then the previous steps are kept
     auto recalcStepList() -> bool;
+    // an unobserved character follows its steps by its position alone, without entering the fields on the way or
+    // telling anyone; it is put back onto a field when observed again
+    void setObserved(bool observed);
+    [[nodiscard]] auto isObserved() const -> bool { return observed; }
 
 private:
     std::list<position> positions;
     Character *_movechar;
     std::list<direction> steplist;
+    // requests sent to the path service, only the latest one is waited for
+    uint32_t pathRequests = 0;
+    bool waitingForPath = false;
+    bool pathFailed = false;
+    position requestedStart{};
+    position requestedGoal{};
+    bool observed = true;
+    // action points the last step on the fields took, charged for unobserved steps; 0 until one was taken
+    int stepCost = 0;
+    direction lastUnobservedStep = dir_none;
+
+    void moveUnobserved();
+
     auto checkPosition() -> bool;
+    void requestPath(const position &goal);
+    void pathFound(uint32_t request, const position &start, const position &goal, bool found,
+                   const std::list<direction> &steps);
 };
 #endif
@@ -21,15 +21,23 @@
 #include "World.hpp"
 
 #include "Config.hpp"
+#include "FrameArena.hpp"
 #include "Logger.hpp"
 #include "LongTimeAction.hpp"
+#include "LongTimeCharacterEffects.hpp"
+#include "Metrics.hpp"
 #include "Monster.hpp"
 #include "NPC.hpp"
+#include "ObjectPool.hpp"
 #include "Player.hpp"
+#include "Parallel.hpp"
 #include "PlayerManager.hpp"
 #include "Random.hpp"
 #include "TableStructs.hpp"
+#include "TickClock.hpp"
+#include "Tracer.hpp"
 #include "WaypointList.hpp"
+#include "WorldView.hpp"
 #include "data/Data.hpp"
 #include "data/MonsterTable.hpp"
 #include "data/NPCTable.hpp"
@@ -37,24 +45,57 @@
 #include "data/SkillTable.hpp"
 #include "data/TilesTable.hpp"
 #include "data/WeaponObjectTable.hpp"
+#include "db/ConnectionManager.hpp"
 #include "db/Result.hpp"
 #include "db/SelectQuery.hpp"
 #include "netinterface/BasicCommand.hpp"
 #include "netinterface/NetInterface.hpp"
+#include "netinterface/SessionRecording.hpp"
 #include "netinterface/protocol/ServerCommands.hpp"
+#include "path_service.hpp"
+#include "script/LuaCollector.hpp"
 #include "script/LuaNPCScript.hpp"
+#include "script/LuaProfiler.hpp"
 #include "script/server.hpp"
 #include "tuningConstants.hpp"
 
 #include <algorithm>
 #include <cmath>
 #include <iterator>
+#include <map>
 #include <memory>
-#include <regex>
+#include <string_view>
 
-extern ScheduledScriptsTable *scheduledScripts;
+extern std::unique_ptr<ScheduledScriptsTable> scheduledScripts;
 extern MonsterTable *monsterDescriptions;
 
+namespace {
+
+auto &tickDuration = metrics::Registry::get().histogram("illarion_tick_duration_seconds", "Game ticks that did work");
+auto &playersOnline = metrics::Registry::get().gauge("illarion_players_online", "Players logged in");
+auto &monstersOnline = metrics::Registry::get().gauge("illarion_monsters", "Monsters on the map");
+auto &npcsOnline = metrics::Registry::get().gauge("illarion_npcs", "NPCs on the map");
+auto &luaHeap = metrics::Registry::get().gauge("illarion_lua_heap_kilobytes", "Lua heap after the last tick");
+auto &queuedSendBytes =
+        metrics::Registry::get().gauge("illarion_send_queue_bytes", "Bytes queued for clients and not yet written");
+
+// range of the weapon in the right hand, else in the left hand, else melee
+auto weaponRange(const Character &character) -> uint16_t {
+    const auto &weapons = character.getEquipment().weapons;
+
+    if (const auto *right = weapons[RIGHT_TOOL]; right != nullptr) {
+        return right->Range;
+    }
+
+    if (const auto *left = weapons[LEFT_TOOL]; left != nullptr) {
+        return left->Range;
+    }
+
+    return 1;
+}
+
+} // namespace
+
 World *World::_self;
 
 auto World::create() -> World * {
@@ -96,21 +137,142 @@ void World::turntheworld() {
 
     ap = static_cast<int>(elapsed / MIN_AP_UPDATE - usedAP);
 
+    if (std::exchange(traceDumpDue, false)) {
+        const auto file = dumpTrace("slow_tick");
+
+        if (!file.empty()) {
+            Logger::warn(LogFacility::World) << "trace of a slow tick written to " << file << Log::end;
+        }
+    }
+
     if (ap > 0) {
         usedAP += ap;
 
+        const std::chrono::milliseconds budget{Config::instance().tick_budget};
+        const bool shedding = Config::instance().shed_overload;
+        TickTimes times;
+        auto phaseStart = now;
+
+        const auto endPhase = [&phaseStart](std::chrono::nanoseconds &time, const char *name) {
+            const auto end = std::chrono::steady_clock::now();
+            time += end - phaseStart;
+            Tracer::get().record(name, phaseStart, end);
+            phaseStart = end;
+        };
+
         checkPlayers();
+        // effects are called for sleeping creatures too, so they need not be woken for them
+        LongTimeCharacterEffects::checkDueEffects(Config::instance().long_time_effect_budget);
+        endPhase(times.players, "players");
+        // commands of players should not wait behind creature AI
+        checkPlayerImmediateCommands();
+        endPhase(times.commands, "commands");
+
+        times.idleMonstersShed = shedding && (overloaded || phaseStart - now > budget / 2);
+        shedIdleMonsters = times.idleMonstersShed;
+        pathfinding::PathService::get().deliver();
         checkMonsters();
-        checkNPC();
+        endPhase(times.monsters, "monsters");
+        checkPlayerImmediateCommands();
+        endPhase(times.commands, "commands");
+
+        times.npcsDeferred = shedding && phaseStart - now > budget && deferredNpcTicks < maxDeferrals;
+
+        if (times.npcsDeferred) {
+            ++deferredNpcTicks;
+            deferredNpcAP += ap;
+        } else {
+            ap += std::exchange(deferredNpcAP, 0);
+            checkNPC();
+            endPhase(times.npcs, "npcs");
+        }
+
+        if (Config::instance().world_view) {
+            WorldView::publish(*this);
+            endPhase(times.worldView, "world_view");
+        }
+
+        times.total = phaseStart - now;
+        times.luaCollection = LuaCollector::get().takeStepTime();
+        times.luaHeapKilobytes = LuaCollector::heapKilobytes(LuaScript::getLuaState());
+        tickDuration.observe(times.total);
+        playersOnline.set(static_cast<int64_t>(Players.size()));
+        monstersOnline.set(static_cast<int64_t>(Monsters.size()));
+        npcsOnline.set(static_cast<int64_t>(Npc.size()));
+        luaHeap.set(static_cast<int64_t>(times.luaHeapKilobytes));
+        overloaded = times.total > budget;
+        lastTickTimes = times;
+
+        const std::chrono::milliseconds slowTick{Config::instance().trace_slow_tick};
+
+        if (slowTick.count() > 0 && times.total > slowTick && phaseStart - lastTraceDump >= traceDumpInterval) {
+            lastTraceDump = phaseStart;
+            traceDumpDue = true;
+        }
+
+        if (overloaded && phaseStart - lastOverloadLog >= overloadLogInterval) {
+            lastOverloadLog = phaseStart;
+            Logger::warn(LogFacility::World)
+                    << "tick took " << duration_cast<milliseconds>(times.total).count() << "ms, players "
+                    << duration_cast<milliseconds>(times.players).count() << "ms, commands "
+                    << duration_cast<milliseconds>(times.commands).count() << "ms, monsters "
+                    << duration_cast<milliseconds>(times.monsters).count() << "ms, npcs "
+                    << duration_cast<milliseconds>(times.npcs).count() << "ms, lua heap " << times.luaHeapKilobytes
+                    << "kB, lua collection before the tick "
+                    << duration_cast<milliseconds>(times.luaCollection).count() << "ms" << Log::end;
+        }
+    }
+
+    flushAttributeUpdates();
+    flushCharacterMoves();
+
+    if (Config::instance().send_once_per_tick) {
+        const Tracer::Zone zone("flush");
+        Players.for_each([](Player *player) { player->Connection->flush(); });
+        monitoringClientList->flush();
+    }
+
+    frame::resetArena();
+}
+
+auto World::estimateMemory() const -> std::vector<std::pair<std::string, size_t>> {
+    constexpr size_t bytesPerKilobyte = 1024;
+    size_t players = Players.memoryUsage() + Players.size() * sizeof(Player);
+    size_t depots = 0;
+
+    Players.for_each([&players, &depots](Player *player) {
+        if (const auto *backpack = player->GetBackPack(); backpack != nullptr) {
+            players += backpack->memoryUsage();
+        }
+
+        depots += player->depotMemoryUsage();
+    });
+
+    const std::vector<std::pair<std::string, size_t>> usage{
+            {"maps", maps.memoryUsage()},
+            {"map_snapshots", maps.mappedBytes()},
+            {"players", players},
+            {"depots", depots},
+            {"monsters", Monsters.memoryUsage() + Monsters.size() * sizeof(Monster)},
+            {"npcs", Npc.memoryUsage() + Npc.size() * sizeof(NPC)},
+            {"send_queues", static_cast<size_t>(std::max<int64_t>(queuedSendBytes.get(), 0))},
+            {"tables", Data::memoryUsage()},
+            {"lua", LuaCollector::heapKilobytes(LuaScript::getLuaState()) * bytesPerKilobyte}};
+
+    for (const auto &[owner, bytes] : usage) {
+        metrics::Registry::get()
+                .gauge("illarion_memory_bytes", "Estimated bytes held per owner", "owner=\"" + owner + '"')
+                .set(static_cast<int64_t>(bytes));
     }
+
+    return usage;
 }
 
 void World::checkPlayers() {
-    time_t now = 0;
-    time(&now);
+    const time_t now = TickClock::wallNow();
     bool savedOnePlayer = false;
 
-    std::vector<Player *> lostPlayers;
+    auto lostPlayers = frame::makeVector<Player *>();
 
     Players.for_each([now, &savedOnePlayer, &lostPlayers, this](Player *playerPointer) {
         Player &player = *playerPointer;
@@ -123,12 +285,10 @@ void World::checkPlayers() {
                 player.increaseFightPoints(ap);
                 player.workoutCommands();
                 player.checkFightMode();
-                player.ltAction->checkAction();
-                player.effects.checkEffects();
                 auto timeSinceSave = now - player.lastsavetime;
 
                 if (!savedOnePlayer && timeSinceSave >= PLAYER_SAVE_INTERVAL) {
-                    player.save();
+                    PlayerManager::get().savePlayer(player);
                     savedOnePlayer = true;
                 }
             }
@@ -152,40 +312,47 @@ void World::checkPlayers() {
 
             script::server::logout().onLogout(playerPointer);
 
-            PlayerManager::get().getLogOutPlayers().push_back(playerPointer);
+            if (Config::instance().session_resume_grace > 0) {
+                PlayerManager::get().suspendPlayer(playerPointer);
+            } else {
+                PlayerManager::get().addLogOutPlayer(playerPointer);
+            }
+
             sendRemoveCharToVisiblePlayers(player.getId(), pos);
             lostPlayers.push_back(playerPointer);
         }
     });
 
+    std::vector<TYPE_OF_CHARACTER_ID> lostIds;
+
     for (const auto &player : lostPlayers) {
+        lostIds.push_back(player->getId());
+        SessionRecorder::get().logout(player->getId());
         Players.erase(player->getId());
+        Observers.remove(player);
     }
 
-    if (!lostPlayers.empty()) {
-        updatePlayerList();
+    if (!lostIds.empty()) {
+        removeFromPlayerList(lostIds);
     }
+
+    PlayerManager::get().expireSessions(now);
 }
 
 void World::checkPlayerImmediateCommands() {
-    std::unique_lock<std::mutex> lock(immediatePlayerCommandsMutex);
-    while (!immediatePlayerCommands.empty()) {
-        auto *player = immediatePlayerCommands.front();
-        immediatePlayerCommands.pop();
-        lock.unlock();
+    TYPE_OF_CHARACTER_ID id = 0;
+
+    // looked up by id, a player may have logged out since the announcement
+    while (immediatePlayerCommands.pop(id)) {
+        auto *player = Players.find(id);
 
-        if (player->Connection->online) {
+        if (player != nullptr && player->Connection->online) {
             player->workoutCommands();
         }
-
-        lock.lock();
     }
 }
 
-void World::addPlayerImmediateActionQueue(Player *player) {
-    std::unique_lock<std::mutex> lock(immediatePlayerCommandsMutex);
-    immediatePlayerCommands.push(player);
-}
+void World::addPlayerImmediateActionQueue(Player *player) { immediatePlayerCommands.push(player->getId()); }
 
 void World::invalidatePlayerDialogs() const { Players.for_each(&Player::invalidateDialogs); }
 
@@ -197,6 +364,7 @@ auto World::initRespawns() -> bool {
     });
 
     SpawnList.clear();
+    dueSpawns = {};
 
     // read spawnpoints from db
 
@@ -225,6 +393,7 @@ auto World::initRespawns() -> bool {
                 Logger::debug(LogFacility::World) << "load spawnpoint " << spawnId << ":" << Log::end;
                 newSpawn.load(spawnId);
                 SpawnList.push_back(newSpawn);
+                SpawnList.back().arm();
                 Logger::debug(LogFacility::World) << "added spawnpoint " << pos << Log::end;
             }
 
@@ -240,16 +409,86 @@ auto World::initRespawns() -> bool {
 }
 
 auto World::isPlayerNearby(const Character &character) const -> bool {
-    const auto players = getPlayersInRangeOf(character.getPosition(), MAX_ACT_RANGE);
-    return !players.empty();
+    return Observers.isPlayerNear(character.getPosition());
+}
+
+void World::wakeCreature(Character &creature) {
+    uint32_t *since = nullptr;
+
+    switch (creature.getType()) {
+    case Character::player:
+        return;
+    case Character::monster:
+        since = Monsters.findDormancy(creature.getId());
+        break;
+    case Character::npc:
+        since = Npc.findDormancy(creature.getId());
+        break;
+    }
+
+    if (since != nullptr) {
+        catchUp(creature, *since);
+        creaturesToWake.push_back(creature.getId());
+    }
+}
+
+void World::wakeCreatures() {
+    std::vector<TYPE_OF_CHARACTER_ID> ids;
+    ids.swap(creaturesToWake);
+    constexpr Coordinate halfCell = InterestGrid::cellSize / 2;
+
+    for (const auto &cell : Observers.takeActivatedCells()) {
+        const position centre(cell.x + halfCell - 1, cell.y + halfCell - 1, cell.z);
+        Monsters.findDormantInRangeOf(centre, halfCell, ids);
+        Npc.findDormantInRangeOf(centre, halfCell, ids);
+    }
+
+    for (const auto id : ids) {
+        wake(Monsters, id);
+        wake(Npc, id);
+    }
+}
+
+template <class T> void World::sleep(CharacterContainer<T> &creatures, TYPE_OF_CHARACTER_ID id) {
+    creatures.sleep(id, creatureTick);
+}
+
+template <class T> void World::wake(CharacterContainer<T> &creatures, TYPE_OF_CHARACTER_ID id) {
+    auto *since = creatures.findDormancy(id);
+
+    if (since != nullptr) {
+        catchUp(*creatures.find(id), *since);
+        creatures.wake(id);
+    }
+}
+
+void World::catchUp(Character &creature, uint32_t &since) const {
+    // creatures sleep with full action points, one loop grants at least one fight point
+    const auto skipped = static_cast<int32_t>(creatureTick - since);
+
+    if (creature.getType() == Character::monster) {
+        creature.increaseFightPoints(skipped);
+    }
+
+    since = creatureTick;
+}
+
+void World::scheduleSpawn(SpawnPoint &spawn, uint32_t cycles) { dueSpawns.emplace(spawnCycle + cycles, &spawn); }
+
+void World::spawnDueMonsters() {
+    ++spawnCycle;
+
+    while (!dueSpawns.empty() && dueSpawns.top().first <= spawnCycle) {
+        auto *spawn = dueSpawns.top().second;
+        dueSpawns.pop();
+        spawn->spawn();
+    }
 }
 
 void World::checkMonsters() {
     if (monstertimer.intervalExceeded()) {
         if (isSpawnEnabled()) {
-            for (auto &spawn : SpawnList) {
-                spawn.spawn();
-            }
+            spawnDueMonsters();
         } else {
             Logger::info(LogFacility::World) << "World::checkMonsters() spawning disabled!" << Log::end;
         }
@@ -259,18 +498,56 @@ void World::checkMonsters() {
         --ap;
     }
 
-    std::vector<Monster *> deadMonsters;
+    wakeCreatures();
+    ++creatureTick;
+
+    auto deadMonsters = frame::makeVector<Monster *>();
+    auto dormantMonsters = frame::makeVector<TYPE_OF_CHARACTER_ID>();
+
+    awakeMonsters.clear();
+    Monsters.for_each_awake([this](Monster *monster) { awakeMonsters.push_back(monster); });
+    monsterPerceptions.resize(awakeMonsters.size());
+
+    // perceiving only reads the world; scripts and everything that changes the world run below on this thread, one
+    // monster after the other in container order, so outcomes do not depend on the number of workers
+    runInParallel(
+            awakeMonsters.size(), [this](size_t i) { perceive(*awakeMonsters[i], monsterPerceptions[i]); },
+            minMonstersPerWorker);
+    chooseTargetsInBatches();
+
+    // a choice made in the batch stands as long as it is still a candidate, otherwise the monster is asked alone
+    const auto chooseTarget = [](Monster *monster, const MonsterStruct &monStruct,
+                                 const std::vector<Character *> &candidates, bool batched,
+                                 Character *choice) -> Character * {
+        if (batched &&
+            (choice == nullptr || std::find(candidates.begin(), candidates.end(), choice) != candidates.end())) {
+            return choice;
+        }
+
+        Character *target = nullptr;
+
+        if (!monStruct.script || !monStruct.script->setTarget(monster, candidates, target)) {
+            target = script::server::fighting().setTarget(monster, candidates);
+        }
+
+        return target;
+    };
 
-    Monsters.for_each([this, &deadMonsters](Monster *monsterPointer) {
+    const auto act = [this, &chooseTarget, &deadMonsters, &dormantMonsters](Monster *monsterPointer,
+                                                                             MonsterPerception &perception) {
         Monster &monster = *monsterPointer;
+        const auto &targetsInReach = perception.targetsInReach;
+        const auto &targetsInView = perception.targetsInView;
 
         if (monster.isAlive()) {
             monster.increaseActionPoints(ap);
             monster.increaseFightPoints(ap);
-            monster.effects.checkEffects();
 
             if (monster.canAct()) {
-                if (!isPlayerNearby(monster) && !monster.getOnRoute()) {
+                refresh(monster, perception);
+
+                if (!perception.playerNearby && !monster.getOnRoute()) {
+                    dormantMonsters.push_back(monster.getId());
                     return;
                 }
 
@@ -282,25 +559,10 @@ void World::checkMonsters() {
                         monster.lastTargetSeen = false;
                     }
 
-                    Item itl = monster.GetItemAt(LEFT_TOOL).cloneItem();
-                    Item itr = monster.GetItemAt(RIGHT_TOOL).cloneItem();
-
-                    uint16_t range = 1;
-
-                    if (Data::weaponItems().exists(itr.getId())) {
-                        range = Data::weaponItems()[itr.getId()].Range;
-                    } else if (Data::weaponItems().exists(itl.getId())) {
-                        range = Data::weaponItems()[itl.getId()].Range;
-                    }
-
-                    const auto temp = getTargetsInRange(monster.getPosition(), range);
                     bool has_attacked = false;
-                    Character *target = nullptr;
-
-                    if ((!temp.empty()) && monster.canAttack()) {
-                        if (!monStruct.script || !monStruct.script->setTarget(monsterPointer, temp, target)) {
-                            target = script::server::fighting().setTarget(monsterPointer, temp);
-                        }
+                    if ((!targetsInReach.empty()) && monster.canAttack()) {
+                        Character *target = chooseTarget(monsterPointer, monStruct, targetsInReach,
+                                                         perception.batched, perception.choice.inReach);
 
                         if (target != nullptr) {
                             monster.enemyid = target->getId();
@@ -330,17 +592,13 @@ void World::checkMonsters() {
                     }
 
                     if (!has_attacked) {
-                        const auto targets = getTargetsInRange(monster.getPosition(), MONSTERVIEWRANGE);
+                        refresh(monster, perception);
 
                         bool canMakeRandomStep = true;
 
-                        if ((!targets.empty()) && (monster.canAttack())) {
-                            Character *targetChar = nullptr;
-
-                            if (!monStruct.script ||
-                                !monStruct.script->setTarget(monsterPointer, targets, targetChar)) {
-                                targetChar = script::server::fighting().setTarget(monsterPointer, targets);
-                            }
+                        if ((!targetsInView.empty()) && (monster.canAttack())) {
+                            Character *targetChar = chooseTarget(monsterPointer, monStruct, targetsInView,
+                                                                 perception.batched, perception.choice.inView);
 
                             if (targetChar != nullptr) {
                                 monster.lastTargetSeen = true;
@@ -365,7 +623,8 @@ void World::checkMonsters() {
                             monster.performStep(monster.lastTargetPosition);
                         }
 
-                        if (canMakeRandomStep) {
+                        // idle wandering is the first thing to go when the tick is overloaded
+                        if (canMakeRandomStep && !shedIdleMonsters) {
                             bool makesRandomStep = Random::uniform() < randomMonsterMoveProbability;
 
                             bool hasDefinition = monsterDescriptions->exists(monster.getMonsterType());
@@ -463,25 +722,10 @@ void World::checkMonsters() {
                         }
                     }
                 } else {
-                    Item itl = monster.GetItemAt(LEFT_TOOL).cloneItem();
-                    Item itr = monster.GetItemAt(RIGHT_TOOL).cloneItem();
-
-                    uint16_t range = 1;
-
-                    if (Data::weaponItems().exists(itr.getId())) {
-                        range = Data::weaponItems()[itr.getId()].Range;
-                    } else if (Data::weaponItems().exists(itl.getId())) {
-                        range = Data::weaponItems()[itl.getId()].Range;
-                    }
-
-                    const auto temp = getTargetsInRange(monster.getPosition(), range);
 
-                    if (!temp.empty()) {
-                        Character *target = nullptr;
-
-                        if (!monStruct.script || !monStruct.script->setTarget(monsterPointer, temp, target)) {
-                            target = script::server::fighting().setTarget(monsterPointer, temp);
-                        }
+                    if (!targetsInReach.empty()) {
+                        Character *target = chooseTarget(monsterPointer, monStruct, targetsInReach,
+                                                         perception.batched, perception.choice.inReach);
 
                         if (target != nullptr) {
                             if (foundMonster && monStruct.script) {
@@ -493,14 +737,11 @@ void World::checkMonsters() {
                         }
                     }
 
-                    const auto temp2 = getTargetsInRange(monster.getPosition(), MONSTERVIEWRANGE);
-
-                    if (!temp2.empty()) {
-                        Character *target = nullptr;
+                    refresh(monster, perception);
 
-                        if (!monStruct.script || !monStruct.script->setTarget(monsterPointer, temp2, target)) {
-                            target = script::server::fighting().setTarget(monsterPointer, temp2);
-                        }
+                    if (!targetsInView.empty()) {
+                        Character *target = chooseTarget(monsterPointer, monStruct, targetsInView,
+                                                         perception.batched, perception.choice.inView);
 
                         if (target != nullptr) {
                             if (foundMonster && monStruct.script) {
@@ -524,12 +765,20 @@ void World::checkMonsters() {
         } else {
             deadMonsters.push_back(monsterPointer);
         }
-    });
+    };
+
+    for (size_t i = 0; i < awakeMonsters.size(); ++i) {
+        act(awakeMonsters[i], monsterPerceptions[i]);
+    }
 
     for (const auto &monster : deadMonsters) {
         killMonster(monster->getId());
     }
 
+    for (const auto id : dormantMonsters) {
+        sleep(Monsters, id);
+    }
+
     for (auto &monster : newMonsters) {
         Monsters.insert(monster);
 
@@ -545,34 +794,154 @@ void World::checkMonsters() {
     }
 
     newMonsters.clear();
+    newMonstersById.clear();
 }
 
 auto World::getTargetsInRange(const position &pos, int radius) const -> std::vector<Character *> {
+    std::vector<Character *> targets;
+    getTargetsInRange(pos, radius, targets);
+    return targets;
+}
+
+void World::getTargetsInRange(const position &pos, int radius, std::vector<Character *> &targets) const {
     Range range;
     range.radius = radius;
     range.zRadius = 0;
-    const auto players = Players.findAllAliveCharactersInRangeOf(pos, range);
-    const auto monsters = Monsters.findAllAliveCharactersInRangeOf(pos, range);
-    std::vector<Character *> targets;
-    targets.insert(targets.end(), players.begin(), players.end());
-    std::remove_copy_if(monsters.begin(), monsters.end(), std::back_inserter(targets),
-                        [&](const auto &monster) { return pos == monster->getPosition(); });
+    targets.clear();
+    Players.forEachAliveCharacterInRangeOf(pos, range, [&targets](Player *player) { targets.push_back(player); });
+    Monsters.forEachAliveCharacterInRangeOf(pos, range, [&pos, &targets](Monster *monster) {
+        if (!(pos == monster->getPosition())) {
+            targets.push_back(monster);
+        }
+    });
+}
 
-    return targets;
+void World::perceive(Monster &monster, MonsterPerception &perception) const {
+    perception.from = monster.getPosition();
+    perception.playerNearby = isPlayerNearby(monster);
+
+    if (monster.isAlive()) {
+        perception.reach = weaponRange(monster);
+        const auto &from = perception.from;
+        const auto distance = [&from](const Character *target) {
+            const auto &pos = target->getPosition();
+            return std::max(std::abs(pos.x - from.x), std::abs(pos.y - from.y));
+        };
+
+        // one query for both radii, sorted by distance both subsets are prefixes of it
+        auto &view = perception.targetsInView;
+        getTargetsInRange(from, std::max<int>(perception.reach, MONSTERVIEWRANGE), view);
+        std::stable_sort(view.begin(), view.end(),
+                         [&distance](const Character *a, const Character *b) { return distance(a) < distance(b); });
+
+        const auto beyond = [&distance](int radius) {
+            return [&distance, radius](const Character *target) { return distance(target) > radius; };
+        };
+
+        auto &reach = perception.targetsInReach;
+        reach.assign(view.begin(), std::find_if(view.begin(), view.end(), beyond(perception.reach)));
+        view.erase(std::find_if(view.begin(), view.end(), beyond(MONSTERVIEWRANGE)), view.end());
+    } else {
+        perception.targetsInReach.clear();
+        perception.targetsInView.clear();
+    }
+}
+
+void World::chooseTargetsInBatches() {
+    // monsters of a type are batched together, types in order so outcomes do not depend on the container layout
+    std::map<TYPE_OF_CHARACTER_ID, std::vector<size_t>> batches;
+
+    for (size_t i = 0; i < awakeMonsters.size(); ++i) {
+        auto &perception = monsterPerceptions[i];
+        perception.batched = false;
+        const auto &monster = *awakeMonsters[i];
+
+        if (!monster.isAlive() || (perception.targetsInReach.empty() && perception.targetsInView.empty())) {
+            continue;
+        }
+
+        const auto type = monster.getMonsterType();
+
+        if (monsterDescriptions->exists(type)) {
+            const auto &script = (*monsterDescriptions)[type].script;
+
+            if (script && script->existsEntrypoint("setTargets")) {
+                batches[type].push_back(i);
+            }
+        }
+    }
+
+    std::vector<LuaMonsterScript::TargetQuery> queries;
+    std::vector<LuaMonsterScript::TargetChoice> choices;
+
+    for (const auto &[type, members] : batches) {
+        queries.clear();
+
+        for (const auto i : members) {
+            const auto &perception = monsterPerceptions[i];
+            queries.push_back({awakeMonsters[i], &perception.targetsInReach, &perception.targetsInView});
+        }
+
+        if (!(*monsterDescriptions)[type].script->setTargets(queries, choices)) {
+            continue;
+        }
+
+        for (size_t j = 0; j < members.size(); ++j) {
+            auto &perception = monsterPerceptions[members[j]];
+            perception.batched = true;
+            perception.choice = choices[j];
+        }
+    }
+}
+
+void World::refresh(Monster &monster, MonsterPerception &perception) const {
+    if (!(monster.getPosition() == perception.from) || weaponRange(monster) != perception.reach) {
+        perceive(monster, perception);
+        return;
+    }
+
+    // targets that came into range since are only noticed next tick
+    const auto &from = perception.from;
+
+    const auto lost = [&from](int radius) {
+        return [&from, radius](const Character *target) {
+            const auto &pos = target->getPosition();
+            return !target->isAlive() || pos.z != from.z || std::abs(pos.x - from.x) > radius ||
+                   std::abs(pos.y - from.y) > radius;
+        };
+    };
+
+    auto &reach = perception.targetsInReach;
+    reach.erase(std::remove_if(reach.begin(), reach.end(), lost(perception.reach)), reach.end());
+    auto &view = perception.targetsInView;
+    view.erase(std::remove_if(view.begin(), view.end(), lost(MONSTERVIEWRANGE)), view.end());
 }
 
 void World::checkNPC() {
     deleteAllLostNPC();
 
-    Npc.for_each([this](NPC *npc) {
+    deferredNpcTicks = 0;
+
+    auto dormantNpcs = frame::makeVector<TYPE_OF_CHARACTER_ID>();
+
+    Npc.for_each_awake([this, &dormantNpcs](NPC *npc) {
         if (npc->isAlive()) {
             npc->increaseActionPoints(ap);
-            npc->effects.checkEffects();
 
-            if (!isPlayerNearby(*npc) && !npc->getOnRoute()) {
+            const bool observed = isPlayerNearby(*npc);
+
+            if (!observed && !npc->getOnRoute()) {
+                // with full action points there is nothing to catch up on when it wakes
+                if (npc->canAct()) {
+                    dormantNpcs.push_back(npc->getId());
+                }
+
                 return;
             }
 
+            // routes nobody watches are followed without touching the fields on the way
+            npc->waypoints.setObserved(observed);
+
             std::shared_ptr<LuaNPCScript> npcScript = npc->getScript();
 
             if (npc->canAct() && npcScript) {
@@ -584,15 +953,21 @@ void World::checkNPC() {
                 }
             }
         } else {
-            npc->increaseAttrib("hitpoints", MAXHPS);
+            npc->increaseAttrib(Character::hitpoints, MAXHPS);
             sendSpinToAllVisiblePlayers(npc);
         }
     });
+
+    for (const auto id : dormantNpcs) {
+        sleep(Npc, id);
+    }
 }
 
 // Init method for NPC's
 void World::initNPC() {
     Npc.for_each([this](NPC *npc) {
+        npc->waypoints.setObserved(true);
+
         try {
             fieldAt(npc->getPosition()).removeChar();
         } catch (FieldNotFound &) {
@@ -651,25 +1026,77 @@ void World::initScheduler() {
                                "check_scheduled_scripts");
     scheduler.addRecurringTask([&] { ageInventory(); }, wearReductionInterval, "age_inventory");
     scheduler.addRecurringTask([&] { ageMaps(); }, wearReductionInterval, "age_maps");
+    scheduler.addRecurringTask([&] { estimateMemory(); }, memoryEstimateInterval, "estimate_memory");
+    // starts right away to clear the players a previous run left in the table
+    scheduler.addRecurringTask([&] { updatePlayerList(); }, playerListReconcileInterval, "update_player_list", true);
     scheduler.addRecurringTask([&] { turntheworld(); }, gameLoopInterval, "turntheworld");
     scheduler.addRecurringTask([&] { sendIGTimeToAllPlayers(); }, ingameTimeUpdateInterval, getNextIGDayTime(),
                                "update_ig_day");
+
+    if (const auto interval = Config::instance().lua_profile_interval(); interval > 0) {
+        scheduler.addRecurringTask(
+                [] {
+                    LuaProfiler::get().dump();
+                    LuaCollector::get().dump(LuaScript::getLuaState());
+                },
+                std::chrono::seconds(interval), "dump_lua_profile");
+    }
+
+    if (const auto interval = Config::instance().postgres_pool_log_interval(); interval > 0) {
+        scheduler.addRecurringTask([] { Database::ConnectionManager::getInstance().logStats(); },
+                                   std::chrono::seconds(interval), "log_database_pool");
+    }
+
+    if (const auto interval = Config::instance().object_pool_log_interval(); interval > 0) {
+        scheduler.addRecurringTask([] { ObjectPool::logStats(); }, std::chrono::seconds(interval),
+                                   "log_object_pools");
+    }
+
+    if (const auto interval = Config::instance().script_variables_save_interval(); interval > 0) {
+        scheduler.addRecurringTask([] { Data::scriptVariables().flush(); }, std::chrono::seconds(interval),
+                                   "save_script_variables");
+    }
+
+    if (const auto interval = Config::instance().map_checkpoint_interval(); interval > 0) {
+        scheduler.addRecurringTask([this] { saveWhileRunning(); }, std::chrono::seconds(interval), "checkpoint_maps");
+    }
+
+    if (const auto interval = Config::instance().backup_interval();
+        interval > 0 && !Config::instance().backup_dir().empty()) {
+        scheduler.addRecurringTask([this] { backup(); }, std::chrono::seconds(interval), "backup");
+    }
+
+    if (const auto interval = Config::instance().script_reload_interval(); interval > 0) {
+        scheduler.addRecurringTask([this] { reloadChangedScripts(); }, std::chrono::seconds(interval),
+                                   "reload_changed_scripts");
+    }
 }
 
 auto World::executeUserCommand(Player *user, const std::string &input, const CommandMap &commands) -> bool {
-    bool found = false;
+    // most chat is no command at all
+    if (input.size() < 2 || input.front() != '!') {
+        return false;
+    }
 
-    static const std::regex pattern("^!([^ ]+) ?(.*)?$");
-    std::smatch match;
+    // !<name> <arguments>, where the arguments are a single line
+    const auto nameEnd = std::min(input.find(' '), input.size());
 
-    if (std::regex_match(input, match, pattern)) {
-        auto it = commands.find(match[1].str());
+    if (nameEnd == 1) {
+        return false;
+    }
 
-        if (it != commands.end()) {
-            (it->second)(this, user, match[2].str());
-            found = true;
-        }
+    const auto argumentsBegin = std::min(nameEnd + 1, input.size());
+
+    if (input.find_first_of("\r\n", argumentsBegin) != std::string::npos) {
+        return false;
+    }
+
+    const auto *command = commands.find(std::string_view(input).substr(1, nameEnd - 1));
+
+    if (command == nullptr) {
+        return false;
     }
 
-    return found;
+    (*command)(this, user, input.substr(argumentsBegin));
+    return true;
 }
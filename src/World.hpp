@@ -25,8 +25,11 @@
 
 #include "Character.hpp"
 #include "CharacterContainer.hpp"
+#include "CommandTable.hpp"
+#include "InterestGrid.hpp"
 #include "Language.hpp"
 #include "MonitoringClients.hpp"
+#include "MpscQueue.hpp"
 #include "NewClientView.hpp"
 #include "Scheduler.hpp"
 #include "SpawnPoint.hpp"
@@ -37,10 +40,14 @@
 #include "data/MonsterAttackTable.hpp"
 #include "data/MonsterTable.hpp"
 #include "map/WorldMap.hpp"
+#include "script/LuaMonsterScript.hpp"
 
 #include <chrono>
+#include <functional>
 #include <list>
 #include <memory>
+#include <optional>
+#include <queue>
 #include <unordered_map>
 
 class Player;
@@ -48,11 +55,6 @@ class Monster;
 class NPC;
 class LuaScript;
 
-/**
- * a class for holding gm or player commands
- */
-using CommandType = std::function<bool(World *, Player *, const std::string &)>;
-
 /**
  * a struct for holding Weather informations
  */
@@ -124,6 +126,11 @@ public:
      */
     PLAYERVECTOR Players;
 
+    /**
+     *subscriptions of all players in Players to the cells in their screen, used for broadcasts
+     */
+    InterestGrid Observers;
+
     /**
      *sets a new tile on the map
      */
@@ -140,6 +147,9 @@ public:
      * new Monsters which should be spawned so the server didn't crash on creating monsters from monsters
      */
     std::vector<Monster *> newMonsters;
+    // newMonsters by id, so that findCharacter resolves them without a scan
+    std::unordered_map<TYPE_OF_CHARACTER_ID, Monster *> newMonstersById;
+    void addNewMonster(Monster *monster);
 
     /**
      *holds all npc's on the world
@@ -163,6 +173,25 @@ public:
 
     int ap{}; /**< actionpoints since the last loop call **/
 
+    // time spent in each phase of the last game loop tick
+    struct TickTimes {
+        std::chrono::nanoseconds players{0};
+        std::chrono::nanoseconds commands{0};
+        std::chrono::nanoseconds monsters{0};
+        std::chrono::nanoseconds npcs{0};
+        std::chrono::nanoseconds worldView{0};
+        std::chrono::nanoseconds total{0};
+        // Lua collection done while idle since the previous tick, and the Lua heap after the tick
+        std::chrono::nanoseconds luaCollection{0};
+        uint32_t luaHeapKilobytes = 0;
+        bool idleMonstersShed = false;
+        bool npcsDeferred = false;
+    };
+
+    [[nodiscard]] auto getLastTickTimes() const -> const TickTimes & { return lastTickTimes; }
+    // whether the last tick overran its budget, low priority work waits then
+    [[nodiscard]] auto isOverloaded() const -> bool { return overloaded; }
+
     ClockBasedScheduler<std::chrono::steady_clock> scheduler;
 
     WeatherStruct weather; /**< a struct to the weather @see WeatherStruct */
@@ -197,6 +226,9 @@ public:
      */
     void checkPlayers();
 
+    // estimated bytes held by the major owners of memory, also published as metrics
+    auto estimateMemory() const -> std::vector<std::pair<std::string, size_t>>;
+
     void invalidatePlayerDialogs() const;
 
     /**
@@ -233,6 +265,8 @@ public:
 
     void enableSpawn(bool enable) { _is_spawn_enabled = enable; }
     auto isSpawnEnabled() const -> bool { return _is_spawn_enabled; }
+    // the spawn point spawns when monstertimer has fired the given number of further times
+    void scheduleSpawn(SpawnPoint &spawn, uint32_t cycles);
 
     static auto create() -> World *;
     static auto get() -> World *;
@@ -253,6 +287,10 @@ public:
      *saves all online players a table in the db
      */
     void updatePlayerList() const;
+    // adds a player who logged in to the online player table
+    static void addToPlayerList(TYPE_OF_CHARACTER_ID id);
+    // removes players who logged out from the online player table
+    static void removeFromPlayerList(const std::vector<TYPE_OF_CHARACTER_ID> &ids);
 
     /**
      * finds all warpfields in a given range
@@ -265,6 +303,8 @@ public:
 
     auto blockingLineOfSight(const position &startingpos, const position &endingpos) const
             -> std::list<BlockingObject> override;
+    // true if no character or large item lies between both positions, stops at the first blocker
+    auto hasLineOfSight(const position &startingpos, const position &endingpos) const -> bool override;
 
     auto findTargetsInSight(const position &pos, Coordinate range, std::vector<Character *> &ret,
                             Character::face_to direction) const -> bool;
@@ -280,6 +320,8 @@ public:
      * @todo has to be changed for only one charactervetor
      */
     virtual auto findCharacter(TYPE_OF_CHARACTER_ID id) -> Character *;
+    // O(1) if handle is still valid, falls back to findCharacter otherwise
+    auto findCharacterByHandle(TYPE_OF_CHARACTER_ID id, SlotHandle handle) -> Character *;
 
     /**
      *deletes all monsters and npcs from the map and emptys the lists
@@ -298,6 +340,8 @@ public:
 
     auto fieldAt(const position &pos) -> map::Field & override;
     auto fieldAt(const position &pos) const -> const map::Field & override;
+    // length fields from start on, stepping x by xStep and y by one, null where there is none
+    void fieldsAlong(const position &start, int16_t xStep, Coordinate length, const map::Field **fields) const;
     auto fieldAtOrBelow(position &pos) -> map::Field &;
     auto walkableFieldNear(const position &pos) -> map::Field &;
     void makePersistentAt(const position &pos) override;
@@ -308,16 +352,36 @@ public:
 
     void Load();
     void Save() const;
+    // saves the maps without the players standing on them, in the background with background_map_save
+    void saveWhileRunning();
+    // copies maps and script variables as of now to a new directory below backup_dir, see Config
+    void backup();
     void import();
     auto createMap(const std::string &name, const position &origin, uint16_t width, uint16_t height, uint16_t tile)
             -> bool {
-        return maps.createMap(name, origin, width, height, tile);
+        if (!maps.createMap(name, origin, width, height, tile)) {
+            return false;
+        }
+
+        markTriggerFields();
+        return true;
     }
+    // marks the fields of all trigger positions, needed whenever maps or the trigger table were loaded
+    void markTriggerFields();
 
     void sendRemoveCharToVisiblePlayers(TYPE_OF_CHARACTER_ID id, const position &pos) const;
 
     void sendHealthToAllVisiblePlayers(Character *cc, Attribute::attribute_t health) const;
 
+    // character has attribute updates waiting for flushAttributeUpdates
+    void attributesChanged(const Character &character);
+    // sends the attribute updates collected since the last call, at the end of each tick
+    void flushAttributeUpdates();
+    // player has moves of other characters waiting for flushCharacterMoves
+    void characterMovesQueued(const Player &player);
+    // sends the moves queued since the last call, at the end of each tick
+    void flushCharacterMoves();
+
     /**============in WorldIMPLCharacterMoves.cpp==================*/
 
     /**
@@ -381,6 +445,8 @@ public:
      *@param true if the char is moving to the field, false if he is moving away from the field
      */
     static void triggerFieldMove(Character *cc, bool moveto);
+    // skips the trigger table for a field without a trigger mark the character still stands on
+    static void triggerFieldMove(Character *cc, bool moveto, const map::Field &field);
 
     /**
      * update the character container about the position change
@@ -427,7 +493,11 @@ public:
     void lookAtMapItem(Player *player, const position &pos, uint8_t stackPos);
 
 private:
+    // runs save while the fields do not carry the players standing on them
+    void withoutPlayersOnFields(const std::function<void()> &save);
     static void lookAtTile(Player *cp, unsigned short int tile, const position &pos);
+    // nothing if the player looked at too many items lately and no cached result is at hand
+    static auto lookAtItem(Player *player, const ScriptItem &item) -> std::optional<ItemLookAt>;
 
 public:
     //! sendet an den Spieler den Namen des Item an einer Position im showcase
@@ -465,6 +535,10 @@ public:
 
     void sendMessageToAllPlayers(const std::string &message) const;
     void broadcast(const std::string &german, const std::string &english) const override;
+    // queues the same command to every player, it is encoded only once
+    void sendToAllPlayers(const ServerCommandPointer &command) const;
+    // queues to every player the command of their language
+    void sendToAllPlayers(const ServerCommandPointer &german, const ServerCommandPointer &english) const;
 
     void sendMessageToAdmin(const std::string &message) const;
 
@@ -483,6 +557,7 @@ public:
 
     void sendIGTimeToAllPlayers();
     void sendIGTime(Player *cp) const;
+    [[nodiscard]] auto igTimeCommand() const -> ServerCommandPointer;
 
     ////////// in WorldIMPLAdmin.cpp /////////////
 
@@ -532,6 +607,12 @@ public:
     // \param cp is the GM performing this full reload
     void reload_command(Player *cp);
 
+    //! reloads only the script modules whose files changed, tables and unchanged scripts stay as they are
+    // \param cp is the GM asking for the reload
+    void reloadscripts_command(Player *cp);
+    // returns the number of changed modules
+    auto reloadChangedScripts() -> size_t;
+
     //! substitutes #j <name>, jump to a player of a given name
     // \param cp is the jumping GM
     // \param ts name of the player to jump to
@@ -640,7 +721,23 @@ public:
     auto getPlayersInRangeOf(const position &pos, uint8_t radius) const -> std::vector<Player *> override;
     auto getMonstersInRangeOf(const position &pos, uint8_t radius) const -> std::vector<Monster *> override;
     auto getNPCSInRangeOf(const position &pos, uint8_t radius) const -> std::vector<NPC *> override;
+    // like the lists above without building them
+    [[nodiscard]] auto countCharactersInRangeOf(const position &pos, uint8_t radius) const -> size_t;
+    [[nodiscard]] auto countPlayersInRangeOf(const position &pos, uint8_t radius) const -> size_t;
+    [[nodiscard]] auto countMonstersInRangeOf(const position &pos, uint8_t radius) const -> size_t;
+    [[nodiscard]] auto countNPCSInRangeOf(const position &pos, uint8_t radius) const -> size_t;
+
+    // visits players, monsters and npcs in range in turn, visitors must not insert, erase or move characters
+    template <class Visitor>
+    void forEachCharacterInRangeOf(const position &pos, const Range &range, Visitor &&visit) const {
+        Players.forEachCharacterInRangeOf(pos, range, visit);
+        Monsters.forEachCharacterInRangeOf(pos, range, visit);
+        Npc.forEachCharacterInRangeOf(pos, range, visit);
+    }
+
     auto isPlayerNearby(const Character &character) const -> bool;
+    // a dormant monster or NPC acts again from the next tick on, for when a script gave it something to do
+    void wakeCreature(Character &creature);
 
     auto getItemStats(const ScriptItem &item) const -> ItemStruct override;
     auto getItemStatsFromId(TYPE_OF_ITEM_ID id) const -> ItemStruct override;
@@ -667,6 +764,9 @@ public:
 
     auto isItemOnField(const position &pos) -> bool override;
     auto getItemOnField(const position &pos) -> ScriptItem override;
+    auto getFieldsInArea(const position &pos, uint8_t radius) -> std::vector<map::Field *> override;
+    [[nodiscard]] auto findItemsInArea(const position &pos, uint8_t radius, TYPE_OF_ITEM_ID id) const
+            -> std::vector<ScriptItem> override;
 
     void changeTile(short int tileid, const position &pos) override;
 
@@ -677,6 +777,9 @@ public:
     //\width: breite der neuen Karte
     //\return true wenn das einfgen klappte, ansonsten false wenns zu berlagerungen kommt.
     auto createSavedArea(uint16_t tile, const position &origin, uint16_t height, uint16_t width) -> bool override;
+    auto saveMapTemplate(const position &pos, const std::string &templateName) -> bool override;
+    auto createMapInstance(const std::string &templateName, const position &origin) -> bool override;
+    auto removeMapInstance(const position &pos) -> bool override;
 
     auto getArmorStruct(TYPE_OF_ITEM_ID id, ArmorStruct &ret) -> bool override;
     auto getWeaponStruct(TYPE_OF_ITEM_ID id, WeaponStruct &ret) -> bool override;
@@ -723,18 +826,52 @@ private:
 
     Timer monstertimer{std::chrono::minutes(1)};
 
+    // ticks of the monster and NPC loops, dormant creatures are caught up on the ticks they skipped when woken
+    uint32_t creatureTick = 0;
+    std::vector<TYPE_OF_CHARACTER_ID> creaturesToWake;
+
+    // wakes creatures that got a player nearby or were passed to wakeCreature
+    void wakeCreatures();
+    template <class T> void sleep(CharacterContainer<T> &creatures, TYPE_OF_CHARACTER_ID id);
+    template <class T> void wake(CharacterContainer<T> &creatures, TYPE_OF_CHARACTER_ID id);
+    void catchUp(Character &creature, uint32_t &since) const;
+
     void ageMaps();
-    void ageInventory() const;
+    void ageInventory();
+
+    // NPC cycles are deferred for at most this many ticks in a row, ageing for as many seconds
+    static constexpr int maxDeferrals = 10;
+    static constexpr auto overloadLogInterval = std::chrono::minutes(1);
+    TickTimes lastTickTimes;
+    bool overloaded = false;
+    bool shedIdleMonsters = false;
+    int deferredNpcTicks = 0;
+    int deferredNpcAP = 0;
+    int deferredAgeings = 0;
+    std::chrono::steady_clock::time_point lastOverloadLog;
+    static constexpr auto traceDumpInterval = std::chrono::minutes(1);
+    // set by a slow tick, the trace is written at the start of the next one so it contains all of the slow tick
+    bool traceDumpDue = false;
+    std::chrono::steady_clock::time_point lastTraceDump;
+
+    // defers work if the world is overloaded and it was not deferred too often yet
+    auto deferAgeing() -> bool;
 
     std::string scriptDir;
 
     // spawnplaces...
     std::list<SpawnPoint> SpawnList;
 
+    // only armed spawn points are queued, i.e. those missing monsters, so spawning scales with the spawns due
+    using DueSpawn = std::pair<uint64_t, SpawnPoint *>;
+    uint64_t spawnCycle = 0;
+    std::priority_queue<DueSpawn, std::vector<DueSpawn>, std::greater<>> dueSpawns;
+    void spawnDueMonsters();
+
     // initmethod for spawn places...
     auto initRespawns() -> bool;
 
-    using CommandMap = std::map<std::string, CommandType>;
+    using CommandMap = CommandTable;
     CommandMap GMCommands;
     CommandMap PlayerCommands;
 
@@ -758,6 +895,27 @@ private:
     // Save all online players
     void playersave_command(Player *cp) const;
 
+    // List the scheduled scripts taking the most time
+    static void scriptstats_command(Player *cp);
+
+    // List the Lua entrypoints taking the most time, or control the profiler
+    static void luaprofile_command(Player *cp, const std::string &text);
+    // writes the recent trace zones to trace_dir and returns the file name, empty if it could not be written
+    static auto dumpTrace(const std::string &reason) -> std::string;
+    static void trace_command(Player *cp);
+
+    // List the queueing and performing time of client commands
+    static void latency_command(Player *cp);
+
+    // Write the samples of the sampling profiler, or start or stop it
+    static void profile_command(Player *cp, const std::string &text);
+
+    // List the commands and players taking the most bandwidth
+    void traffic_command(Player *cp) const;
+
+    // List the estimated memory per owner
+    void memory_command(Player *cp) const;
+
     // Create telport warp on current tile to x, y, z
     void teleport_command(Player *cp, const std::string &text);
 
@@ -777,6 +935,31 @@ private:
     map::WorldMap maps;
 
     auto getTargetsInRange(const position &pos, int radius) const -> std::vector<Character *>;
+    // replaces the content of targets, so the monster loop can reuse its buffers
+    void getTargetsInRange(const position &pos, int radius, std::vector<Character *> &targets) const;
+
+    // what an awake monster sees at the start of the monster phase, gathered in parallel since it only reads
+    struct MonsterPerception {
+        position from;
+        bool playerNearby = false;
+        uint16_t reach = 1;
+        // both nearest first
+        std::vector<Character *> targetsInReach;
+        std::vector<Character *> targetsInView;
+        // set if the monster script chose from both lists in its batched setTargets call
+        bool batched = false;
+        LuaMonsterScript::TargetChoice choice;
+    };
+
+    // buffers of checkMonsters, kept to avoid reallocating them every tick
+    std::vector<Monster *> awakeMonsters;
+    std::vector<MonsterPerception> monsterPerceptions;
+
+    void perceive(Monster &monster, MonsterPerception &perception) const;
+    // asks the monster scripts with a setTargets entrypoint once per monster type instead of once per monster
+    void chooseTargetsInBatches();
+    // brings a perception up to date with the moves and deaths of the monster phase so far
+    void refresh(Monster &monster, MonsterPerception &perception) const;
 
     static auto active_language_command(Player *cp, const std::string &language) -> bool;
 
@@ -786,8 +969,8 @@ private:
     void InitPlayerCommands();
     auto executeUserCommand(Player *user, const std::string &input, const CommandMap &commands) -> bool;
 
-    // export maps to mapdir/export
-    auto exportMaps(Player *cp) const -> bool;
+    // export maps to mapdir/export in the background, progress is reported to the player
+    auto exportMaps(Player *cp) -> bool;
 
     void ignoreComments(std::ifstream &inputStream);
 
@@ -796,8 +979,15 @@ private:
 
     static void version_command(Player *player);
 
-    std::mutex immediatePlayerCommandsMutex;
-    std::queue<Player *> immediatePlayerCommands;
+    // players with new commands, announced by the io threads; if it ever overflows checkPlayers still gets them
+    static constexpr size_t maxAnnouncedPlayers = 4096;
+    MpscQueue<TYPE_OF_CHARACTER_ID, maxAnnouncedPlayers> immediatePlayerCommands;
+
+    // looked up by id when flushed, a character may be gone by then
+    std::vector<TYPE_OF_CHARACTER_ID> charactersWithChangedAttributes;
+    std::vector<TYPE_OF_CHARACTER_ID> flushedAttributeUpdates;
+    std::vector<TYPE_OF_CHARACTER_ID> playersWithQueuedMoves;
+    std::vector<TYPE_OF_CHARACTER_ID> flushedCharacterMoves;
 };
 
 #endif
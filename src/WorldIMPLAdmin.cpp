@@ -21,6 +21,8 @@
 #include "Monster.hpp"
 #include "Player.hpp"
 #include "PlayerManager.hpp"
+#include "SamplingProfiler.hpp"
+#include "Tracer.hpp"
 #include "World.hpp"
 #include "constants.hpp"
 #include "data/Data.hpp"
@@ -29,12 +31,18 @@
 #include "data/RaceTypeTable.hpp"
 #include "data/ScheduledScriptsTable.hpp"
 #include "globals.hpp"
+#include "map/ChunkVersions.hpp"
 #include "map/Field.hpp"
 #include "netinterface/NetInterface.hpp"
 #include "netinterface/protocol/ServerCommands.hpp"
+#include "script/LuaChunkCache.hpp"
+#include "script/LuaProfiler.hpp"
 #include "script/LuaReloadScript.hpp"
 #include "script/server.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
 #include <iostream>
 #include <limits>
 #include <list>
@@ -118,6 +126,41 @@ void World::InitGMCommands() {
     };
     GMCommands["ps"] = GMCommands["playersave"];
 
+    GMCommands["scriptstats"] = [](World *world, Player *player, const std::string & /*unused*/) -> bool {
+        scriptstats_command(player);
+        return true;
+    };
+
+    GMCommands["luaprofile"] = [](World *world, Player *player, const std::string &text) -> bool {
+        luaprofile_command(player, text);
+        return true;
+    };
+
+    GMCommands["trace"] = [](World *world, Player *player, const std::string & /*unused*/) -> bool {
+        trace_command(player);
+        return true;
+    };
+
+    GMCommands["latency"] = [](World *world, Player *player, const std::string & /*unused*/) -> bool {
+        latency_command(player);
+        return true;
+    };
+
+    GMCommands["profile"] = [](World *world, Player *player, const std::string &text) -> bool {
+        profile_command(player, text);
+        return true;
+    };
+
+    GMCommands["traffic"] = [](World *world, Player *player, const std::string & /*unused*/) -> bool {
+        world->traffic_command(player);
+        return true;
+    };
+
+    GMCommands["memory"] = [](World *world, Player *player, const std::string & /*unused*/) -> bool {
+        world->memory_command(player);
+        return true;
+    };
+
     GMCommands["add_teleport"] = [](World *world, Player *player, const std::string &text) -> bool {
         world->teleport_command(player, text);
         return true;
@@ -192,6 +235,12 @@ void World::InitGMCommands() {
     };
     GMCommands["fr"] = GMCommands["fullreload"];
 
+    GMCommands["reloadscripts"] = [](World *world, Player *player, const std::string & /*unused*/) -> bool {
+        world->reloadscripts_command(player);
+        return true;
+    };
+    GMCommands["rs"] = GMCommands["reloadscripts"];
+
     GMCommands["mapsave"] = [](World *world, Player *player, const std::string & /*unused*/) -> bool {
         world->save_command(player);
         return true;
@@ -234,6 +283,8 @@ void World::InitGMCommands() {
         world->spawn_command(player, text);
         return true;
     };
+
+    GMCommands.build();
 }
 
 void World::spawn_command(Player *cp, const std::string &monsterId) {
@@ -316,6 +367,41 @@ void World::reload_command(Player *cp) {
     }
 }
 
+void World::reloadscripts_command(Player *cp) {
+    if (cp->hasGMRight(gmr_reload)) {
+        Logger::info(LogFacility::Admin) << *cp << " reloads changed scripts" << Log::end;
+        const auto count = reloadChangedScripts();
+        cp->inform(std::to_string(count) + " changed script modules reloaded");
+    }
+}
+
+auto World::reloadChangedScripts() -> size_t {
+    const auto modules = LuaChunkCache::get().changedModules(Config::instance().scriptdir());
+
+    if (modules.empty()) {
+        return 0;
+    }
+
+    for (const auto &module : modules) {
+        Logger::info(LogFacility::Script) << "reloading changed script " << module << Log::end;
+    }
+
+    // modules only required by others are run again on their next require
+    LuaScript::unloadModules(modules);
+    Data::reloadChangedScripts(modules);
+
+    if (monsterDescriptions) {
+        monsterDescriptions->reloadChangedScripts(modules);
+    }
+
+    if (scheduledScripts) {
+        scheduledScripts->reloadChangedScripts(modules);
+    }
+
+    script::server::reloadChanged(modules);
+    return modules.size();
+}
+
 void World::broadcast_command(Player *cp, const std::string &message) const {
     if (cp->hasGMRight(gmr_broadcast)) {
         std::string logMsg = cp->to_string() + " broadcasts: " + message;
@@ -365,22 +451,7 @@ void World::save_command(Player *cp) {
     }
 
     Logger::info(LogFacility::Admin) << *cp << " saves all maps" << Log::end;
-
-    Players.for_each([this](Player *player) {
-        try {
-            fieldAt(player->getPosition()).removePlayer();
-        } catch (FieldNotFound &) {
-        }
-    });
-
-    Save();
-
-    Players.for_each([this](Player *player) {
-        try {
-            fieldAt(player->getPosition()).setPlayer();
-        } catch (FieldNotFound &) {
-        }
-    });
+    saveWhileRunning();
 
     std::string tmessage = "*** Maps saved! ***";
     cp->inform(tmessage);
@@ -491,10 +562,12 @@ void World::forceLogoutOfAllPlayers() {
         sendMonitoringMessage(message);
         ServerCommandPointer cmd = std::make_shared<LogOutTC>(SERVERSHUTDOWN);
         player->Connection->shutdownSend(cmd);
-        PlayerManager::get().getLogOutPlayers().push_back(player);
+        PlayerManager::get().addLogOutPlayer(player);
     });
 
     Players.clear();
+    Observers.clear();
+    PlayerManager::get().expireSessions();
 }
 
 auto World::forceLogoutOfPlayer(const std::string &name) const -> bool {
@@ -816,12 +889,227 @@ void World::playersave_command(Player *cp) const {
 
     Logger::info(LogFacility::Admin) << *cp << " saves all players" << Log::end;
 
-    Players.for_each(&Player::save);
+    Players.for_each([](Player *player) { PlayerManager::get().savePlayer(*player); });
 
-    std::string tmessage = "*** All online players saved! ***";
+    std::string tmessage = "*** All online players queued for saving! ***";
     cp->inform(tmessage);
 }
 
+void World::scriptstats_command(Player *cp) {
+    if (!cp->hasGMRight(gmr_reload)) {
+        return;
+    }
+
+    constexpr size_t listed = 10;
+    std::vector<const ScriptData *> scripts;
+
+    for (const auto &script : scheduledScripts->getScripts()) {
+        scripts.push_back(&script);
+    }
+
+    const auto count = std::min(listed, scripts.size());
+    std::partial_sort(scripts.begin(), scripts.begin() + count, scripts.end(),
+                      [](const auto *lhs, const auto *rhs) { return lhs->totalTime > rhs->totalTime; });
+
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    for (size_t i = 0; i < count; ++i) {
+        const auto &script = *scripts[i];
+        std::stringstream message;
+        message << script.scriptName << "." << script.functionName << ": " << script.calls << " calls, "
+                << duration_cast<microseconds>(script.totalTime).count() << " us total, "
+                << duration_cast<microseconds>(script.maxTime).count() << " us max";
+        cp->inform(message.str());
+    }
+
+    cp->inform("scripts carried over last cycle: " + std::to_string(scheduledScripts->getCarriedOver()));
+}
+
+auto World::dumpTrace(const std::string &reason) -> std::string {
+    const auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    const auto file = Config::instance().trace_dir() + reason + "_" + std::to_string(now) + ".json";
+
+    if (!Tracer::get().dump(file)) {
+        Logger::error(LogFacility::World) << "could not write trace to " << file << Log::end;
+        return {};
+    }
+
+    return file;
+}
+
+// !trace
+void World::trace_command(Player *cp) {
+    if (!cp->hasGMRight(gmr_reload)) {
+        return;
+    }
+
+    const auto file = dumpTrace("trace");
+    cp->inform(file.empty() ? "Trace could not be written" : "Trace written to " + file);
+}
+
+// !latency
+void World::latency_command(Player *cp) {
+    if (!cp->hasGMRight(gmr_reload)) {
+        return;
+    }
+
+    const auto lines = Player::commandLatencies();
+
+    if (lines.empty()) {
+        cp->inform("No client commands performed yet");
+    }
+
+    for (const auto &line : lines) {
+        cp->inform(line);
+    }
+}
+
+// !profile [start <samples per second>|stop]
+void World::profile_command(Player *cp, const std::string &text) {
+    if (!cp->hasGMRight(gmr_reload)) {
+        return;
+    }
+
+    auto &profiler = SamplingProfiler::get();
+
+    if (text == "stop") {
+        profiler.stop();
+        cp->inform("Sampling profiler stopped");
+        return;
+    }
+
+    static const std::regex startPattern("^start ([0-9]{1,4})$");
+    std::smatch match;
+
+    if (std::regex_match(text, match, startPattern)) {
+        constexpr unsigned long maxFrequency = 1000;
+        const auto frequency = static_cast<uint16_t>(std::min(std::stoul(match[1].str()), maxFrequency));
+        profiler.start(frequency);
+        cp->inform(frequency == 0 ? "Sampling profiler stopped"
+                                  : "Sampling " + std::to_string(frequency) + " times per second");
+        return;
+    }
+
+    const auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    const auto file = Config::instance().trace_dir() + "profile_" + std::to_string(now) + ".folded";
+
+    if (!profiler.dump(file)) {
+        Logger::error(LogFacility::World) << "could not write profile to " << file << Log::end;
+        cp->inform("Profile could not be written");
+        return;
+    }
+
+    cp->inform("Folded stacks written to " + file);
+}
+
+// !traffic
+void World::traffic_command(Player *cp) const {
+    if (!cp->hasGMRight(gmr_reload)) {
+        return;
+    }
+
+    constexpr size_t listed = 10;
+    constexpr size_t bytesPerKilobyte = 1024;
+
+    const auto listCommands = [cp, listed](const std::string &direction, const auto &traffic) {
+        for (size_t i = 0; i < std::min(listed, traffic.size()); ++i) {
+            std::stringstream message;
+            message << direction << " 0x" << std::hex << std::setw(2) << std::setfill('0')
+                    << static_cast<int>(traffic[i].id) << std::dec << ": " << traffic[i].commands << " commands, "
+                    << traffic[i].bytes / bytesPerKilobyte << " kB";
+            cp->inform(message.str());
+        }
+    };
+
+    listCommands("sent", NetInterface::serverCommandTraffic());
+    listCommands("received", NetInterface::clientCommandTraffic());
+
+    std::vector<Player *> talkers;
+    Players.for_each([&talkers](Player *player) { talkers.push_back(player); });
+    const auto count = std::min(listed, talkers.size());
+    const auto received = [](const Player *player) { return player->Connection->getTraffic().getReceivedBytes(); };
+    std::partial_sort(talkers.begin(), talkers.begin() + count, talkers.end(),
+                      [&received](const auto *lhs, const auto *rhs) { return received(lhs) > received(rhs); });
+
+    for (size_t i = 0; i < count; ++i) {
+        const auto &traffic = talkers[i]->Connection->getTraffic();
+        unsigned char topCommand = 0;
+
+        for (unsigned char id = 1; id != 0; ++id) {
+            if (traffic.getReceived(id) > traffic.getReceived(topCommand)) {
+                topCommand = id;
+            }
+        }
+
+        std::stringstream message;
+        message << talkers[i]->to_string() << ": received " << traffic.getReceivedCommands() << " commands, "
+                << traffic.getReceivedBytes() / bytesPerKilobyte << " kB, mostly 0x" << std::hex << std::setw(2)
+                << std::setfill('0') << static_cast<int>(topCommand) << std::dec << ", sent "
+                << traffic.getQueuedCommands() << " commands, " << traffic.getQueuedBytes() / bytesPerKilobyte
+                << " kB";
+        cp->inform(message.str());
+    }
+}
+
+// !memory
+void World::memory_command(Player *cp) const {
+    if (!cp->hasGMRight(gmr_reload)) {
+        return;
+    }
+
+    constexpr size_t bytesPerKilobyte = 1024;
+
+    for (const auto &[owner, bytes] : estimateMemory()) {
+        cp->inform(owner + ": " + std::to_string(bytes / bytesPerKilobyte) + " kB");
+    }
+}
+
+// !luaprofile [reset|sample <instructions>|sample off]
+void World::luaprofile_command(Player *cp, const std::string &text) {
+    if (!cp->hasGMRight(gmr_reload)) {
+        return;
+    }
+
+    auto &profiler = LuaProfiler::get();
+
+    if (text == "reset") {
+        profiler.reset();
+        cp->inform("Lua profile reset");
+        return;
+    }
+
+    static const std::regex samplePattern("^sample (off|[0-9]{1,9})$");
+    std::smatch match;
+
+    if (std::regex_match(text, match, samplePattern)) {
+        // lua_sethook takes the count as int
+        constexpr unsigned long maxInstructions = std::numeric_limits<int32_t>::max();
+        const auto instructions = match[1] == "off" ? 0 : std::min(std::stoul(match[1].str()), maxInstructions);
+        profiler.setSampling(static_cast<uint32_t>(instructions));
+        cp->inform(instructions == 0 ? "Lua sampling stopped"
+                                     : "Lua sampling every " + std::to_string(instructions) + " instructions");
+        return;
+    }
+
+    constexpr size_t listed = 10;
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    for (const auto *entry : profiler.slowest(listed)) {
+        std::stringstream message;
+        message << entry->getScript() << "." << entry->getEntrypoint() << ": " << entry->getCalls() << " calls, "
+                << duration_cast<microseconds>(entry->getTotal()).count() << " us total, "
+                << duration_cast<microseconds>(entry->percentile(0.99)).count() << " us p99, "
+                << duration_cast<microseconds>(entry->getMax()).count() << " us max";
+        cp->inform(message.str());
+    }
+
+    for (const auto &[line, count] : profiler.hottestLines(listed)) {
+        cp->inform(line + ": " + std::to_string(count) + " samples");
+    }
+}
+
 // !teleport X<,| >Y[<,| >Z]
 void World::teleport_command(Player *cp, const std::string &text) {
     if (!cp->hasGMRight(gmr_warp)) {
@@ -947,6 +1235,27 @@ void World::gmhelp_command(Player *cp) {
         cp->inform(tmessage);
         tmessage = "!fullreload - (!fr) reloads all database tables";
         cp->inform(tmessage);
+        tmessage = "!reloadscripts - (!rs) reloads only the scripts whose files changed, without a server freeze.";
+        cp->inform(tmessage);
+        tmessage = "!scriptstats - lists the scheduled scripts taking the most time.";
+        cp->inform(tmessage);
+        tmessage = "!luaprofile [reset|sample <instructions>|sample off] - lists the Lua entrypoints taking the most "
+                   "time and the most sampled lines, resets the profile or samples the running line every "
+                   "<instructions> Lua instructions.";
+        cp->inform(tmessage);
+        tmessage = "!trace - writes the recent game loop tasks and tick phases as Chrome trace to the trace_dir.";
+        cp->inform(tmessage);
+        tmessage = "!latency - lists how long client commands waited to be performed and how long performing took.";
+        cp->inform(tmessage);
+        tmessage = "!profile [start <samples per second>|stop] - writes the stack samples of the game thread as folded "
+                   "stacks for flame graphs to the trace_dir, or starts or stops sampling.";
+        cp->inform(tmessage);
+        tmessage = "!traffic - lists the client and server commands taking the most bandwidth and the players "
+                   "sending the most.";
+        cp->inform(tmessage);
+        tmessage = "!memory - lists the estimated memory held by maps, characters, depots, send queues, tables and "
+                   "Lua.";
+        cp->inform(tmessage);
     }
 
     if (cp->hasGMRight(gmr_import)) {
@@ -1074,6 +1383,11 @@ auto World::reload_tables(Player *cp) -> bool {
     bool ok = reload_defs(cp);
 
     if (ok) {
+        // cached costs and stripes may still reflect the old tables
+        maps.updateMovementCosts();
+        map::ChunkVersions::get().bumpAll();
+        markTriggerFields();
+
         // reload respawns
         initRespawns();
 
@@ -1168,12 +1482,39 @@ void World::set_login(Player *player, const std::string &text) {
     player->inform(message);
 }
 
-auto World::exportMaps(Player *cp) const -> bool {
+auto World::exportMaps(Player *cp) -> bool {
     if (!cp->hasGMRight(gmr_import)) {
         return false;
     }
 
-    return maps.exportTo();
+    const auto gm = cp->getId();
+
+    // progress arrives on worker threads, the scheduler hands it to the game thread
+    const bool started = maps.exportInBackground([this, gm](const map::WorldMap::ExportProgress &progress) {
+        scheduler.addOneshotTask(
+                [this, gm, progress] {
+                    auto *player = Players.find(gm);
+
+                    if (player == nullptr) {
+                        return;
+                    }
+
+                    if (progress.isComplete()) {
+                        player->inform("Map export finished: " + std::to_string(progress.written) + " maps written, " +
+                                       std::to_string(progress.failed) + " failed.");
+                    } else {
+                        player->inform("Map export: " + std::to_string(progress.written + progress.failed) + " of " +
+                                       std::to_string(progress.total) + " maps done.");
+                    }
+                },
+                std::chrono::nanoseconds::zero(), "map_export_progress");
+    });
+
+    if (started) {
+        cp->inform("Map export started.");
+    }
+
+    return started;
 }
 
 void World::removeTeleporter(Player *cp, const std::string &text) {
@@ -16,6 +16,7 @@
 //  You should have received a copy of the GNU Affero General Public License
 //  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
 
+#include "Config.hpp"
 #include "Logger.hpp"
 #include "Monster.hpp"
 #include "NPC.hpp"
@@ -29,6 +30,9 @@
 #include "netinterface/protocol/ServerCommands.hpp"
 #include "script/LuaItemScript.hpp"
 
+#include <algorithm>
+#include <cstdlib>
+
 void World::checkFieldAfterMove(Character *character, const map::Field &field) {
     if (character == nullptr) {
         return;
@@ -51,7 +55,10 @@ void World::checkFieldAfterMove(Character *character, const map::Field &field) {
         }
     }
 
-    if (character->isAlive() && Data::triggers().exists(character->getPosition())) {
+    // a script above may have moved the character away from field
+    const bool mayHaveTrigger = field.mayHaveTrigger() || field.getPosition() != character->getPosition();
+
+    if (character->isAlive() && mayHaveTrigger && Data::triggers().exists(character->getPosition())) {
         const auto &script = Data::triggers().script(character->getPosition());
 
         if (script) {
@@ -60,6 +67,14 @@ void World::checkFieldAfterMove(Character *character, const map::Field &field) {
     }
 }
 
+void World::triggerFieldMove(Character *cc, bool moveto, const map::Field &field) {
+    if (cc != nullptr && field.getPosition() == cc->getPosition() && !field.mayHaveTrigger()) {
+        return;
+    }
+
+    triggerFieldMove(cc, moveto);
+}
+
 void World::triggerFieldMove(Character *cc, bool moveto) {
     if ((cc != nullptr) && cc->isAlive() && Data::triggers().exists(cc->getPosition())) {
         const auto &script = Data::triggers().script(cc->getPosition());
@@ -75,40 +90,50 @@ void World::triggerFieldMove(Character *cc, bool moveto) {
 }
 
 void World::moveTo(Character *cc, const position &to) {
+    // the type tag tells the concrete class, no RTTI needed
     switch (cc->getType()) {
     case Character::player:
-        Players.update(dynamic_cast<Player *>(cc), to);
+        Players.update(static_cast<Player *>(cc), to);
+        Observers.update(static_cast<Player *>(cc), to);
         break;
     case Character::monster:
-        Monsters.update(dynamic_cast<Monster *>(cc), to);
+        Monsters.update(static_cast<Monster *>(cc), to);
         break;
     case Character::npc:
-        Npc.update(dynamic_cast<NPC *>(cc), to);
+        Npc.update(static_cast<NPC *>(cc), to);
         break;
     }
+
+    // a script moved a dormant creature next to a player
+    if (cc->getType() != Character::player && Observers.isPlayerNear(to)) {
+        wakeCreature(*cc);
+    }
 }
 
 void World::sendSpinToAllVisiblePlayers(Character *cc) const {
-    for (const auto &p : Players.findAllCharactersInScreen(cc->getPosition())) {
-        ServerCommandPointer cmd = std::make_shared<PlayerSpinTC>(cc->getFaceTo(), cc->getId());
-        p->Connection->addCommand(cmd);
-    }
+    ServerCommandPointer cmd = std::make_shared<PlayerSpinTC>(cc->getFaceTo(), cc->getId());
+    Observers.forEachObserverOf(cc->getPosition(), [&cmd](Player *p) { p->Connection->addCommand(cmd); });
 }
 
 void World::sendPassiveMoveToAllVisiblePlayers(Character *ccp) const {
     const auto &charPos = ccp->getPosition();
+    ServerCommandPointer cmd;
 
-    for (const auto &p : Players.findAllCharactersInScreen(charPos)) {
+    Observers.forEachObserverOf(charPos, [ccp, &charPos, &cmd](Player *p) {
         const auto &playerPos = p->getPosition();
         Coordinate xoffs = charPos.x - playerPos.x;
         Coordinate yoffs = charPos.y - playerPos.y;
         Coordinate zoffs = charPos.z - playerPos.z + RANGEDOWN;
 
-        if ((xoffs != 0) || (yoffs != 0) || (zoffs != RANGEDOWN)) {
-            ServerCommandPointer cmd = std::make_shared<MoveAckTC>(ccp->getId(), charPos, PUSH, 0);
+        if (((xoffs != 0) || (yoffs != 0) || (zoffs != RANGEDOWN)) &&
+            !p->queueCharacterMove({ccp->getId(), charPos, PUSH, 0}, false)) {
+            if (!cmd) {
+                cmd = std::make_shared<MoveAckTC>(ccp->getId(), charPos, PUSH, 0);
+            }
+
             p->Connection->addCommand(cmd);
         }
-    }
+    });
 }
 
 void World::sendCharacterMoveToAllVisibleChars(Character *cc, TYPE_OF_WALKINGCOST duration) const {
@@ -119,18 +144,30 @@ void World::sendCharacterMoveToAllVisiblePlayers(Character *cc, unsigned char mo
                                                  TYPE_OF_WALKINGCOST duration) const {
     if (!cc->isInvisible()) {
         const auto &charPos = cc->getPosition();
+        const Coordinate farRadius = Config::instance().far_update_radius;
+        ServerCommandPointer cmd;
 
-        for (const auto &p : Players.findAllCharactersInScreen(charPos)) {
+        Observers.forEachObserverOf(charPos, [cc, &charPos, moveType, duration, farRadius, &cmd](Player *p) {
             const auto &playerPos = p->getPosition();
             Coordinate xoffs = charPos.x - playerPos.x;
             Coordinate yoffs = charPos.y - playerPos.y;
             Coordinate zoffs = charPos.z - playerPos.z + RANGEDOWN;
 
             if ((xoffs != 0) || (yoffs != 0) || (zoffs != RANGEDOWN)) {
-                ServerCommandPointer cmd = std::make_shared<MoveAckTC>(cc->getId(), charPos, moveType, duration);
+                const bool far = farRadius > 0 && std::max(std::abs(xoffs), std::abs(yoffs)) > farRadius &&
+                                 p->enemyid != cc->getId() && cc->enemyid != p->getId();
+
+                if (p->queueCharacterMove({cc->getId(), charPos, moveType, duration}, far)) {
+                    return;
+                }
+
+                if (!cmd) {
+                    cmd = std::make_shared<MoveAckTC>(cc->getId(), charPos, moveType, duration);
+                }
+
                 p->Connection->addCommand(cmd);
             }
-        }
+        });
     }
 }
 
@@ -139,19 +176,24 @@ void World::sendCharacterWarpToAllVisiblePlayers(Character *cc, const position &
         {
             ServerCommandPointer cmd = std::make_shared<RemoveCharTC>(cc->getId());
 
-            for (const auto &player : Players.findAllCharactersInScreen(oldpos)) {
+            Observers.forEachObserverOf(oldpos, [cc, &cmd](Player *player) {
                 if (!player->isInScreen(cc->getPosition())) {
                     player->sendCharRemove(cc->getId(), cmd);
                 }
-            }
+            });
         }
 
-        for (const auto &p : Players.findAllCharactersInScreen(cc->getPosition())) {
-            if (cc != p) {
-                ServerCommandPointer cmd = std::make_shared<MoveAckTC>(cc->getId(), cc->getPosition(), PUSH, 0);
+        ServerCommandPointer cmd;
+
+        Observers.forEachObserverOf(cc->getPosition(), [cc, &cmd](Player *p) {
+            if (cc != p && !p->queueCharacterMove({cc->getId(), cc->getPosition(), PUSH, 0}, false)) {
+                if (!cmd) {
+                    cmd = std::make_shared<MoveAckTC>(cc->getId(), cc->getPosition(), PUSH, 0);
+                }
+
                 p->Connection->addCommand(cmd);
             }
-        }
+        });
     }
 }
 
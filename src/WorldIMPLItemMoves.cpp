@@ -20,6 +20,7 @@
 #include "Monster.hpp"
 #include "NPC.hpp"
 #include "Player.hpp"
+#include "Showcase.hpp"
 #include "World.hpp"
 #include "data/Data.hpp"
 #include "map/Field.hpp"
@@ -28,6 +29,7 @@
 #include "tuningConstants.hpp"
 
 #include <cmath>
+#include <utility>
 
 // TODO find a better place for the constants
 static const std::string message_overweight_german{"Du kannst nicht so viel tragen!"};
@@ -39,11 +41,11 @@ auto World::putItemOnInvPos(Character *cc, unsigned char pos) -> bool {
     if (pos == BACKPACK) {
         if (cc->items.at(BACKPACK).getId() == 0) {
             if (g_item.isContainer()) {
-                cc->items.at(BACKPACK) = g_item;
+                cc->items.at(BACKPACK) = std::move(g_item);
                 cc->items.at(BACKPACK).setNumber(1);
 
                 if (g_cont == nullptr) {
-                    g_cont = new Container(g_item.getId());
+                    g_cont = new Container(cc->items.at(BACKPACK).getId());
                 } else {
                     auto *temp = dynamic_cast<Player *>(cc);
 
@@ -70,7 +72,7 @@ auto World::putItemOnInvPos(Character *cc, unsigned char pos) -> bool {
                         if (weapon.isTwoHanded()) {
                             if ((pos == RIGHT_TOOL) && (cc->items.at(LEFT_TOOL).getId() == 0)) {
                                 if (cc->items.at(pos).getId() == 0 && g_item.getNumber() == 1) {
-                                    cc->items.at(pos) = g_item;
+                                    cc->items.at(pos) = std::move(g_item);
                                     cc->items.at(LEFT_TOOL).setId(BLOCKEDITEM);
                                     cc->items.at(LEFT_TOOL).makePermanent();
                                     cc->items.at(LEFT_TOOL).setNumber(1);
@@ -83,7 +85,7 @@ auto World::putItemOnInvPos(Character *cc, unsigned char pos) -> bool {
                             }
                             if ((pos == LEFT_TOOL) && (cc->items.at(RIGHT_TOOL).getId() == 0)) {
                                 if (cc->items.at(pos).getId() == 0 && g_item.getNumber() == 1) {
-                                    cc->items.at(pos) = g_item;
+                                    cc->items.at(pos) = std::move(g_item);
 
                                     cc->items.at(RIGHT_TOOL).setId(BLOCKEDITEM);
 
@@ -113,7 +115,7 @@ auto World::putItemOnInvPos(Character *cc, unsigned char pos) -> bool {
                             }
                         }
 
-                        cc->items.at(pos) = g_item;
+                        cc->items.at(pos) = std::move(g_item);
                         g_item.reset();
 
                         cc->updateAppearanceForAll(true);
@@ -177,7 +179,7 @@ auto World::putItemOnInvPos(Character *cc, unsigned char pos) -> bool {
                         }();
 
                         if ((armor.BodyParts & flag) != 0) {
-                            cc->items.at(pos) = g_item;
+                            cc->items.at(pos) = std::move(g_item);
 
                             g_item.reset();
 
@@ -196,7 +198,7 @@ auto World::putItemOnInvPos(Character *cc, unsigned char pos) -> bool {
                     }
                 }
 
-                cc->items.at(pos) = g_item;
+                cc->items.at(pos) = std::move(g_item);
                 g_item.reset();
                 cc->updateAppearanceForAll(true);
                 return true;
@@ -250,7 +252,7 @@ auto World::putItemOnInvPos(Player *cc, unsigned char pos) -> bool {
 auto World::takeItemFromInvPos(Character *cc, unsigned char pos, Item::number_type count) -> bool {
     if (pos == BACKPACK) {
         if (cc->items.at(BACKPACK).getId() != 0) {
-            g_item = cc->items.at(BACKPACK);
+            g_item = std::move(cc->items.at(BACKPACK));
             g_cont = cc->backPackContents;
 
             if (g_cont == nullptr) {
@@ -268,21 +270,22 @@ auto World::takeItemFromInvPos(Character *cc, unsigned char pos, Item::number_ty
                 const auto weaponId = cc->items.at(pos).getId();
 
                 if (Data::weaponItems().exists(weaponId)) {
-                    g_item = cc->items.at(pos);
+                    auto &slot = cc->items.at(pos);
                     g_cont = nullptr;
 
-                    if (!g_item.isStackable() && !g_item.isContainer()) {
-                        if (g_item.getNumber() > 1 && count > 1) {
+                    if (!slot.isStackable() && !slot.isContainer()) {
+                        if (slot.getNumber() > 1 && count > 1) {
                             g_item.reset();
-                            g_cont = nullptr;
                             return false;
                         }
                     }
 
-                    if (g_item.getNumber() > count) {
-                        cc->items.at(pos).setNumber(cc->items.at(pos).getNumber() - count);
+                    if (slot.getNumber() > count) {
+                        g_item = slot;
                         g_item.setNumber(count);
+                        slot.setNumber(slot.getNumber() - count);
                     } else {
+                        g_item = std::move(slot);
                         const auto &weapon = Data::weaponItems()[weaponId];
 
                         if (weapon.isTwoHanded()) {
@@ -298,27 +301,18 @@ auto World::takeItemFromInvPos(Character *cc, unsigned char pos, Item::number_ty
                 }
             }
 
-            g_item = cc->items.at(pos);
+            auto &slot = cc->items.at(pos);
             g_cont = nullptr;
+            const Item::number_type taken = slot.isStackable() && count > 1 && !slot.isContainer() ? count : 1;
 
-            if (g_item.isStackable() && count > 1 && !g_item.isContainer()) {
-                if (g_item.getNumber() > count) {
-                    cc->items.at(pos).setNumber(cc->items.at(pos).getNumber() - count);
-                    g_item.setNumber(count);
-                } else {
-                    cc->items.at(pos).reset();
-                }
-
-                cc->updateAppearanceForAll(true);
-                return true;
-            }
-            if (g_item.getNumber() > 1) {
-                cc->items.at(pos).setNumber(cc->items.at(pos).getNumber() - 1);
-
-                g_item.setNumber(1);
-
+            // only a part of the stack needs a copy
+            if (slot.getNumber() > taken) {
+                g_item = slot;
+                g_item.setNumber(taken);
+                slot.setNumber(slot.getNumber() - taken);
             } else {
-                cc->items.at(pos).reset();
+                g_item = std::move(slot);
+                slot.reset();
             }
 
             cc->updateAppearanceForAll(true);
@@ -428,8 +422,8 @@ auto World::takeItemFromMap(Character *cc, const position &itemPosition) -> bool
     try {
         map::Field &field = fieldAt(itemPosition);
 
-        if (field.viewItemOnStack(g_item)) {
-            if (g_item.isMovable()) {
+        if (const auto &stack = field.getItemStack(); !stack.empty()) {
+            if (stack.back().isMovable()) {
                 field.takeItemFromStack(g_item);
 
                 if (!g_item.isStackable() && !g_item.isContainer()) {
@@ -440,7 +434,7 @@ auto World::takeItemFromMap(Character *cc, const position &itemPosition) -> bool
                     }
                 }
 
-                if (Data::triggers().exists(itemPosition)) {
+                if (field.mayHaveTrigger() && Data::triggers().exists(itemPosition)) {
                     const auto &script = Data::triggers().script(itemPosition);
 
                     if (script) {
@@ -454,13 +448,10 @@ auto World::takeItemFromMap(Character *cc, const position &itemPosition) -> bool
                 g_item.resetWear();
 
                 if (g_item.isContainer()) {
-                    auto it = field.containers.find(g_item.getNumber());
+                    g_cont = field.takeContainer(g_item.getNumber());
 
-                    if (it != field.containers.end()) {
-                        g_cont = it->second;
+                    if (g_cont != nullptr) {
                         g_cont->resetWear();
-
-                        field.containers.erase(it);
                     } else {
                         g_cont = new Container(g_item.getId());
                     }
@@ -517,7 +508,7 @@ auto World::putItemOnMap(Character *cc, const position &itemPosition) -> bool {
             if (field.addContainerOnStackIfWalkable(g_item, g_cont)) {
                 sendPutItemOnMapToAllVisibleCharacters(itemPosition, g_item);
 
-                if ((cc != nullptr) && Data::triggers().exists(itemPosition)) {
+                if ((cc != nullptr) && field.mayHaveTrigger() && Data::triggers().exists(itemPosition)) {
                     const auto &script = Data::triggers().script(itemPosition);
 
                     if (script) {
@@ -538,7 +529,7 @@ auto World::putItemOnMap(Character *cc, const position &itemPosition) -> bool {
             if (field.addItemOnStackIfWalkable(g_item)) {
                 sendPutItemOnMapToAllVisibleCharacters(itemPosition, g_item);
 
-                if ((cc != nullptr) && Data::triggers().exists(itemPosition)) {
+                if ((cc != nullptr) && field.mayHaveTrigger() && Data::triggers().exists(itemPosition)) {
                     const auto &script = Data::triggers().script(itemPosition);
 
                     if (script) {
@@ -575,7 +566,7 @@ auto World::putItemAlwaysOnMap(Character *cc, const position &itemPosition) -> b
             if (field.addContainerOnStack(g_item, g_cont)) {
                 sendPutItemOnMapToAllVisibleCharacters(itemPosition, g_item);
 
-                if ((cc != nullptr) && Data::triggers().exists(itemPosition)) {
+                if ((cc != nullptr) && field.mayHaveTrigger() && Data::triggers().exists(itemPosition)) {
                     const auto &script = Data::triggers().script(itemPosition);
 
                     if (script) {
@@ -596,7 +587,7 @@ auto World::putItemAlwaysOnMap(Character *cc, const position &itemPosition) -> b
             if (field.addItemOnStack(g_item)) {
                 sendPutItemOnMapToAllVisibleCharacters(itemPosition, g_item);
 
-                if ((cc != nullptr) && Data::triggers().exists(itemPosition)) {
+                if ((cc != nullptr) && field.mayHaveTrigger() && Data::triggers().exists(itemPosition)) {
                     const auto &script = Data::triggers().script(itemPosition);
 
                     if (script) {
@@ -1404,37 +1395,40 @@ void World::sendPutItemOnMapToAllVisibleCharacters(const position &itemPosition,
 
 void World::sendContainerSlotChange(Container *cc, TYPE_OF_CONTAINERSLOTS slot, Container *moved) const {
     if ((cc != nullptr) && (moved != nullptr)) {
-        Players.for_each([cc, slot, moved](Player *player) {
-            player->updateShowcaseSlot(cc, slot);
+        sendContainerSlotChange(cc, slot);
+
+        for (auto *player : Showcase::viewersOf(moved)) {
             player->closeShowcase(moved);
-        });
+        }
     }
 }
 
 void World::sendContainerSlotChange(Container *cc, TYPE_OF_CONTAINERSLOTS slot) const {
     if (cc != nullptr) {
-        Players.for_each([cc, slot](Player *player) { player->updateShowcaseSlot(cc, slot); });
+        for (auto *player : Showcase::viewersOf(cc)) {
+            player->updateShowcaseSlot(cc, slot);
+        }
     }
 }
 
 void World::closeShowcaseForOthers(Player *target, Container *moved) const {
     if (moved != nullptr) {
-        Players.for_each([target, moved](Player *player) {
+        for (auto *player : Showcase::viewersOf(moved)) {
             if (target != player) {
                 player->closeShowcase(moved);
             }
-        });
+        }
     }
 }
 
 void World::closeShowcaseIfNotInRange(Container *moved, const position &showcasePosition) const {
     if (moved != nullptr) {
-        Players.for_each([&showcasePosition, moved](Player *player) {
+        for (auto *player : Showcase::viewersOf(moved)) {
             const auto &pos = player->getPosition();
             if (std::abs(showcasePosition.x - pos.x) > 1 || std::abs(showcasePosition.y - pos.y) > 1 ||
                 showcasePosition.z != pos.z) {
                 player->closeShowcase(moved);
             }
-        });
+        }
     }
 }
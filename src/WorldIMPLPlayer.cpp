@@ -21,6 +21,7 @@
 #include "MonitoringClients.hpp"
 #include "Player.hpp"
 #include "World.hpp"
+#include "db/AsyncExecutor.hpp"
 #include "db/InsertQuery.hpp"
 #include "netinterface/protocol/BBIWIServerCommands.hpp"
 #include "netinterface/protocol/ServerCommands.hpp"
@@ -42,6 +43,7 @@ void World::InitPlayerCommands() {
         return true;
     };
     PlayerCommands["v"] = PlayerCommands["version"];
+    PlayerCommands.build();
 }
 
 //! parse PlayerCommands of the form !<string1> <string2> and process them
@@ -65,14 +67,17 @@ auto World::gmpage_command(Player *player, const std::string &ticket) const -> b
 void World::logGMTicket(Player *player, const std::string &ticket, bool automatic) const {
     using namespace Database;
 
-    InsertQuery insQuery;
-    insQuery.setServerTable("gmpager");
-    const InsertQuery::columnIndex userColumn = insQuery.addColumn("pager_user");
-    const InsertQuery::columnIndex textColumn = insQuery.addColumn("pager_text");
-    insQuery.addValue(userColumn, player->getId());
-    insQuery.addValue(textColumn, ticket);
-
-    insQuery.execute();
+    const auto id = player->getId();
+
+    AsyncExecutor::getInstance().write("logging a gm ticket", [id, ticket](const PConnection &connection) {
+        InsertQuery insQuery(connection);
+        insQuery.setServerTable("gmpager");
+        const InsertQuery::columnIndex userColumn = insQuery.addColumn("pager_user");
+        const InsertQuery::columnIndex textColumn = insQuery.addColumn("pager_text");
+        insQuery.addValue(userColumn, id);
+        insQuery.addValue(textColumn, ticket);
+        insQuery.execute();
+    });
 
     std::string message;
 
@@ -31,6 +31,8 @@
 #include "netinterface/protocol/ServerCommands.hpp"
 #include "script/LuaNPCScript.hpp"
 
+#include <algorithm>
+
 auto World::deleteNPC(unsigned int npcid) -> bool {
     LostNpcs.push_back(npcid);
     return true;
@@ -89,16 +91,7 @@ auto World::getCharactersInRangeOf(const position &pos, uint8_t radius) const ->
     std::vector<Character *> list;
     Range range;
     range.radius = radius;
-
-    std::vector<Player *> tempP = Players.findAllCharactersInRangeOf(pos, range);
-    list.insert(list.end(), tempP.begin(), tempP.end());
-
-    std::vector<Monster *> tempM = Monsters.findAllCharactersInRangeOf(pos, range);
-    list.insert(list.end(), tempM.begin(), tempM.end());
-
-    std::vector<NPC *> tempN = Npc.findAllCharactersInRangeOf(pos, range);
-    list.insert(list.end(), tempN.begin(), tempN.end());
-
+    forEachCharacterInRangeOf(pos, range, [&list](Character *character) { list.push_back(character); });
     return list;
 }
 
@@ -120,6 +113,35 @@ auto World::getNPCSInRangeOf(const position &pos, uint8_t radius) const -> std::
     return Npc.findAllCharactersInRangeOf(pos, range);
 }
 
+namespace {
+
+template <typename Container>
+auto countInRangeOf(const Container &container, const position &pos, uint8_t radius) -> size_t {
+    Range range;
+    range.radius = radius;
+    size_t count = 0;
+    container.forEachCharacterInRangeOf(pos, range, [&count](const auto * /*character*/) { ++count; });
+    return count;
+}
+
+} // namespace
+
+auto World::countCharactersInRangeOf(const position &pos, uint8_t radius) const -> size_t {
+    return countPlayersInRangeOf(pos, radius) + countMonstersInRangeOf(pos, radius) + countNPCSInRangeOf(pos, radius);
+}
+
+auto World::countPlayersInRangeOf(const position &pos, uint8_t radius) const -> size_t {
+    return countInRangeOf(Players, pos, radius);
+}
+
+auto World::countMonstersInRangeOf(const position &pos, uint8_t radius) const -> size_t {
+    return countInRangeOf(Monsters, pos, radius);
+}
+
+auto World::countNPCSInRangeOf(const position &pos, uint8_t radius) const -> size_t {
+    return countInRangeOf(Npc, pos, radius);
+}
+
 void World::itemInform(Character *user, const ScriptItem &item, const ItemLookAt &lookAt) {
     if (user->getType() != Character::player) {
         return;
@@ -414,7 +436,7 @@ auto World::createMonster(unsigned short id, const position &pos, short movepoin
         try {
             auto *newMonster = new Monster(id, pos);
             newMonster->setActionPoints(movepoints);
-            newMonsters.push_back(newMonster);
+            addNewMonster(newMonster);
             field.setChar();
             return character_ptr(newMonster);
 
@@ -473,6 +495,54 @@ auto World::getItemOnField(const position &pos) -> ScriptItem {
     return item;
 }
 
+auto World::getFieldsInArea(const position &pos, uint8_t radius) -> std::vector<map::Field *> {
+    const auto side = static_cast<Coordinate>(2 * radius + 1);
+    std::vector<const map::Field *> column(side);
+    std::vector<map::Field *> fields;
+
+    for (int x = pos.x - radius; x <= pos.x + radius; ++x) {
+        const position top(static_cast<Coordinate>(x), static_cast<Coordinate>(pos.y - radius), pos.z);
+        fieldsAlong(top, 0, side, column.data());
+
+        for (Coordinate i = 0; i < side; ++i) {
+            // through the mutable access, so that changes made by the script are saved
+            if (column[i] != nullptr) {
+                fields.push_back(&fieldAt(column[i]->getPosition()));
+            }
+        }
+    }
+
+    return fields;
+}
+
+auto World::findItemsInArea(const position &pos, uint8_t radius, TYPE_OF_ITEM_ID id) const
+        -> std::vector<ScriptItem> {
+    const auto side = static_cast<Coordinate>(2 * radius + 1);
+    std::vector<const map::Field *> column(side);
+    std::vector<ScriptItem> items;
+
+    for (int x = pos.x - radius; x <= pos.x + radius; ++x) {
+        const position top(static_cast<Coordinate>(x), static_cast<Coordinate>(pos.y - radius), pos.z);
+        fieldsAlong(top, 0, side, column.data());
+
+        for (const auto *field : column) {
+            if (field == nullptr) {
+                continue;
+            }
+
+            const auto &stack = field->getItemStack();
+
+            for (size_t i = 0; i < stack.size(); ++i) {
+                if (stack[i].getId() == id) {
+                    items.push_back(field->getStackItem(static_cast<uint8_t>(i)));
+                }
+            }
+        }
+    }
+
+    return items;
+}
+
 void World::changeTile(short int tileid, const position &pos) {
     try {
         map::Field &field = fieldAt(pos);
@@ -483,7 +553,7 @@ void World::changeTile(short int tileid, const position &pos) {
 }
 
 auto World::createSavedArea(uint16_t tile, const position &origin, uint16_t height, uint16_t width) -> bool {
-    if (maps.createMap("by createSavedArea", origin, width, height, tile)) {
+    if (createMap("by createSavedArea", origin, width, height, tile)) {
         Logger::info(LogFacility::World) << "Map created by createSavedArea command at " << origin
                                          << " height: " << height << " width: " << width << " standard tile: " << tile
                                          << "!" << Log::end;
@@ -492,6 +562,56 @@ auto World::createSavedArea(uint16_t tile, const position &origin, uint16_t heig
     return false;
 }
 
+auto World::saveMapTemplate(const position &pos, const std::string &templateName) -> bool {
+    if (maps.saveTemplate(pos, templateName)) {
+        Logger::info(LogFacility::World) << "Map at " << pos << " saved as template " << templateName << Log::end;
+        return true;
+    }
+
+    return false;
+}
+
+auto World::createMapInstance(const std::string &templateName, const position &origin) -> bool {
+    if (!maps.createInstance(templateName, origin)) {
+        return false;
+    }
+
+    markTriggerFields();
+    return true;
+}
+
+namespace {
+
+template <typename Container> auto anyCharacterOn(const Container &container, const map::Map &map) -> bool {
+    const position center(static_cast<Coordinate>((map.getMinX() + map.getMaxX()) / 2),
+                          static_cast<Coordinate>((map.getMinY() + map.getMaxY()) / 2), map.getLevel());
+    Range range;
+    range.radius = static_cast<Coordinate>(std::max(map.getWidth(), map.getHeight()) / 2 + 1);
+    range.zRadius = 0;
+    bool found = false;
+
+    container.forEachCharacterInRangeOf(center, range, [&found, &map](const auto *character) {
+        const auto &pos = character->getPosition();
+        found = found || (pos.x >= map.getMinX() && pos.x <= map.getMaxX() && pos.y >= map.getMinY() &&
+                          pos.y <= map.getMaxY());
+    });
+
+    return found;
+}
+
+} // namespace
+
+auto World::removeMapInstance(const position &pos) -> bool {
+    const auto *instance = maps.instanceAt(pos);
+
+    if (instance == nullptr || anyCharacterOn(Players, *instance) || anyCharacterOn(Monsters, *instance) ||
+        anyCharacterOn(Npc, *instance)) {
+        return false;
+    }
+
+    return maps.removeInstance(pos);
+}
+
 auto World::getArmorStruct(TYPE_OF_ITEM_ID id, ArmorStruct &ret) -> bool {
     // Has to be an own function cant give a pointer of Armor items to the script
 
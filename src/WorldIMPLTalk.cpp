@@ -26,6 +26,7 @@
 #include "data/TilesTable.hpp"
 #include "map/Field.hpp"
 #include "netinterface/protocol/ServerCommands.hpp"
+#include "script/server.hpp"
 
 void World::sendMessageToAdmin(const std::string &message) const {
     Players.for_each([&message](Player *player) {
@@ -135,31 +136,53 @@ auto World::getTalkRange(Character::talk_type tt) -> Range {
 }
 
 void World::sendMessageToAllPlayers(const std::string &message) const {
-    Players.for_each([&message](Player *player) { player->inform(message, Player::informBroadcast); });
+    sendToAllPlayers(std::make_shared<InformTC>(Player::informBroadcast, message));
 }
 
 void World::broadcast(const std::string &german, const std::string &english) const {
-    Players.for_each([&german, &english](Player *player) { player->inform(german, english, Player::informBroadcast); });
+    sendToAllPlayers(std::make_shared<InformTC>(Player::informBroadcast, german),
+                     std::make_shared<InformTC>(Player::informBroadcast, english));
+}
+
+void World::sendToAllPlayers(const ServerCommandPointer &command) const {
+    Players.for_each([&command](Player *player) { player->Connection->addCommand(command); });
+}
+
+void World::sendToAllPlayers(const ServerCommandPointer &german, const ServerCommandPointer &english) const {
+    Players.for_each([&german, &english](Player *player) {
+        player->Connection->addCommand(player->getPlayerLanguage() == Language::german ? german : english);
+    });
 }
 
 void World::sendMessageToAllCharsInRange(const std::string &german, const std::string &english, Character::talk_type tt,
                                          Character *cc) const {
     auto range = getTalkRange(tt);
-    bool is_action = german.substr(0, 3) == "#me";
-
-    std::string prefix = languagePrefix(cc->getActiveLanguage());
-
-    for (const auto &player : Players.findAllCharactersInRangeOf(cc->getPosition(), range)) {
-        if (is_action) {
-            player->receiveText(tt, player->nls(german, english), cc);
-        } else {
-            player->receiveText(tt, prefix + player->nls(german, english), cc);
+    const bool is_action = german.compare(0, 3, "#me") == 0;
+    const bool bilingual = german != english;
+    const auto &pos = cc->getPosition();
+
+    const std::string prefix = languagePrefix(cc->getActiveLanguage());
+    // encoded once per language when the first player needs it, all players hearing it share the command
+    ServerCommandPointer germanCommand;
+    ServerCommandPointer englishCommand;
+
+    Players.forEachCharacterInRangeOf(pos, range, [&](Player *player) {
+        auto &command =
+                bilingual && player->getPlayerLanguage() == Language::german ? germanCommand : englishCommand;
+
+        if (!command) {
+            const auto &text = player->nls(german, english);
+            command = Player::talkCommand(tt, pos, is_action ? text : prefix + text);
         }
-    }
+
+        player->Connection->addCommand(command);
+    });
 
     if (cc->getType() == Character::player) {
-        for (const auto &npc : Npc.findAllCharactersInRangeOf(cc->getPosition(), range)) {
-            npc->receiveText(tt, prefix + english, cc);
+        const auto npcText = prefix + english;
+
+        for (const auto &npc : Npc.findAllCharactersInRangeOf(pos, range)) {
+            npc->receiveText(tt, npcText, cc);
         }
 
         for (const auto &monster : Monsters.findAllCharactersInRangeOf(cc->getPosition(), range)) {
@@ -176,23 +199,23 @@ void World::sendLanguageMessageToAllCharsInRange(const std::string &message, Cha
     std::vector<NPC *> npcs = Npc.findAllCharactersInRangeOf(cc->getPosition(), range);
     std::vector<Monster *> monsters = Monsters.findAllCharactersInRangeOf(cc->getPosition(), range);
 
-    if (message.substr(0, 3) == "#me") {
-        for (const auto &player : players) {
-            if (player->getPlayerLanguage() == lang) {
-                player->receiveText(tt, message, cc);
-            }
-        }
-    } else {
-        for (const auto &player : players) {
-            if (player->getPlayerLanguage() == lang) {
-                player->receiveText(tt, languagePrefix(cc->getActiveLanguage()) + message, cc);
+    const std::string prefixed = languagePrefix(cc->getActiveLanguage()) + message;
+    ServerCommandPointer command;
+
+    for (const auto &player : players) {
+        if (player->getPlayerLanguage() == lang) {
+            if (!command) {
+                const bool is_action = message.compare(0, 3, "#me") == 0;
+                command = Player::talkCommand(tt, cc->getPosition(), is_action ? message : prefixed);
             }
+
+            player->Connection->addCommand(command);
         }
     }
 
     if (cc->getType() == Character::player) {
         for (const auto &npc : npcs) {
-            npc->receiveText(tt, languagePrefix(cc->getActiveLanguage()) + message, cc);
+            npc->receiveText(tt, prefixed, cc);
         }
 
         for (const auto &monster : monsters) {
@@ -209,20 +232,16 @@ void World::makeGFXForAllPlayersInRange(const position &pos, int radius, unsigne
     Range range;
     range.radius = radius;
 
-    for (const auto &player : Players.findAllCharactersInRangeOf(pos, range)) {
-        ServerCommandPointer cmd = std::make_shared<GraphicEffectTC>(pos, gfx);
-        player->Connection->addCommand(cmd);
-    }
+    ServerCommandPointer cmd = std::make_shared<GraphicEffectTC>(pos, gfx);
+    Players.forEachCharacterInRangeOf(pos, range, [&cmd](Player *player) { player->Connection->addCommand(cmd); });
 }
 
 void World::makeSoundForAllPlayersInRange(const position &pos, int radius, unsigned short int sound) const {
     Range range;
     range.radius = radius;
 
-    for (const auto &player : Players.findAllCharactersInRangeOf(pos, range)) {
-        ServerCommandPointer cmd = std::make_shared<SoundTC>(pos, sound);
-        player->Connection->addCommand(cmd);
-    }
+    ServerCommandPointer cmd = std::make_shared<SoundTC>(pos, sound);
+    Players.forEachCharacterInRangeOf(pos, range, [&cmd](Player *player) { player->Connection->addCommand(cmd); });
 }
 
 void World::lookAtMapItem(Player *player, const position &pos, uint8_t stackPos) {
@@ -236,10 +255,14 @@ void World::lookAtMapItem(Player *player, const position &pos, uint8_t stackPos)
             item.itempos = stackPos;
             item.owner = player;
 
-            ItemLookAt lookAt = item.getLookAt(player);
+            const auto lookAt = lookAtItem(player, item);
+
+            if (!lookAt) {
+                return;
+            }
 
-            if (lookAt.isValid()) {
-                itemInform(player, item, lookAt);
+            if (lookAt->isValid()) {
+                itemInform(player, item, *lookAt);
             } else {
                 lookAtTile(player, field.getTileId(), pos);
             }
@@ -256,6 +279,20 @@ void World::lookAtTile(Player *cp, unsigned short int tile, const position &pos)
     cp->Connection->addCommand(cmd);
 }
 
+auto World::lookAtItem(Player *player, const ScriptItem &item) -> std::optional<ItemLookAt> {
+    if (player->mayRunLookAtScript()) {
+        return item.getLookAt(player);
+    }
+
+    const auto script = Data::items().script(item.getId());
+
+    if (script && script->existsEntrypoint("LookAtItem")) {
+        return std::nullopt;
+    }
+
+    return script::server::lookAtItem().cachedLookAt(player, item);
+}
+
 void World::lookAtShowcaseItem(Player *cp, uint8_t showcase, unsigned char position) {
     ScriptItem titem;
 
@@ -274,10 +311,10 @@ void World::lookAtShowcaseItem(Player *cp, uint8_t showcase, unsigned char posit
                 n_item.itempos = position;
                 n_item.inside = ps;
 
-                ItemLookAt lookAt = n_item.getLookAt(cp);
+                const auto lookAt = lookAtItem(cp, n_item);
 
-                if (lookAt.isValid()) {
-                    itemInform(cp, n_item, lookAt);
+                if (lookAt && lookAt->isValid()) {
+                    itemInform(cp, n_item, *lookAt);
                 }
             }
         }
@@ -298,10 +335,10 @@ void World::lookAtInventoryItem(Player *cp, unsigned char position) {
         item.pos = cp->getPosition();
         item.owner = cp;
 
-        ItemLookAt lookAt = item.getLookAt(cp);
+        const auto lookAt = lookAtItem(cp, item);
 
-        if (lookAt.isValid()) {
-            itemInform(cp, item, lookAt);
+        if (lookAt && lookAt->isValid()) {
+            itemInform(cp, item, *lookAt);
         }
     }
 }
@@ -320,18 +357,15 @@ void World::introduceMyself(Player *cp) const {
 
 void World::sendWeather(Player *cp) const { cp->sendWeather(weather); }
 
-void World::sendIGTime(Player *cp) const {
-    ServerCommandPointer cmd = std::make_shared<UpdateTimeTC>(
+void World::sendIGTime(Player *cp) const { cp->Connection->addCommand(igTimeCommand()); }
+
+auto World::igTimeCommand() const -> ServerCommandPointer {
+    return std::make_shared<UpdateTimeTC>(
             static_cast<unsigned char>(getTime("hour")), static_cast<unsigned char>(getTime("minute")),
             static_cast<unsigned char>(getTime("day")), static_cast<unsigned char>(getTime("month")),
             static_cast<short int>(getTime("year")));
-    cp->Connection->addCommand(cmd);
 }
 
-void World::sendIGTimeToAllPlayers() {
-    Players.for_each([this](Player *player) { sendIGTime(player); });
-}
+void World::sendIGTimeToAllPlayers() { sendToAllPlayers(igTimeCommand()); }
 
-void World::sendWeatherToAllPlayers() {
-    Players.for_each([this](Player *player) { player->sendWeather(weather); });
-}
+void World::sendWeatherToAllPlayers() { sendToAllPlayers(std::make_shared<UpdateWeatherTC>(weather)); }
@@ -18,9 +18,12 @@
  * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "Config.hpp"
 #include "Monster.hpp"
 #include "NPC.hpp"
+#include "Parallel.hpp"
 #include "Player.hpp"
+#include "PlayerManager.hpp"
 #include "World.hpp"
 #include "data/ArmorObjectTable.hpp"
 #include "data/ContainerObjectTable.hpp"
@@ -28,25 +31,92 @@
 #include "data/MonsterTable.hpp"
 #include "data/TilesModificatorTable.hpp"
 #include "data/WeaponObjectTable.hpp"
+#include "db/AsyncExecutor.hpp"
 #include "db/Connection.hpp"
-#include "db/ConnectionManager.hpp"
 #include "db/DeleteQuery.hpp"
 #include "db/InsertQuery.hpp"
 #include "map/Field.hpp"
+#include "map/FieldIndex.hpp"
 #include "netinterface/protocol/ServerCommands.hpp"
 #include "script/server.hpp"
 
 #include <algorithm>
+#include <array>
+#include <ctime>
 #include <list>
 #include <range/v3/all.hpp>
 
 extern MonsterTable *monsterDescriptions;
 
+namespace {
+
+// ageing a single inventory is quick, fewer per worker cost more in threads than they save
+constexpr size_t inventoriesPerWorker = 64;
+
+// Bresenham walk over the fields strictly between start and end on the level of start, stops and returns false as
+// soon as visit does
+template <class Visitor> auto walkLineOfSight(const position &start, const position &end, Visitor &&visit) -> bool {
+    const bool steep = std::abs(start.y - end.y) > std::abs(start.x - end.x);
+    short int startx = start.x;
+    short int starty = start.y;
+    short int endx = end.x;
+    short int endy = end.y;
+
+    if (steep) {
+        // swap x,y values for correct execution in negative range
+        std::swap(startx, starty);
+        std::swap(endx, endy);
+    }
+
+    if (startx > endx) {
+        std::swap(startx, endx);
+        std::swap(starty, endy);
+    }
+
+    Coordinate deltax = endx - startx;
+    Coordinate deltay = std::abs(endy - starty);
+    Coordinate error = 0;
+    Coordinate ystep = 1;
+    Coordinate y = starty;
+
+    if (starty > endy) {
+        ystep = -1;
+    }
+
+    for (Coordinate x = startx; x <= endx; ++x) {
+        if (!(x == startx && y == starty) && !(x == endx && y == endy)) {
+            position pos{x, y, start.z};
+
+            if (steep) {
+                pos.x = y;
+                pos.y = x;
+            }
+
+            if (!visit(pos)) {
+                return false;
+            }
+        }
+
+        error += deltay;
+
+        if (2 * error >= deltax) {
+            y += ystep;
+            error -= deltax;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
 void World::deleteAllLostNPC() {
     for (const TYPE_OF_CHARACTER_ID &npcToDelete : LostNpcs) {
         const auto &npc = Npc.find(npcToDelete);
 
         if (npc != nullptr) {
+            npc->waypoints.setObserved(true);
+
             try {
                 fieldAt(npc->getPosition()).removeChar();
             } catch (FieldNotFound &) {
@@ -139,9 +209,7 @@ auto World::findTargetsInSight(const position &pos, Coordinate range, std::vecto
         }
 
         if (indir) {
-            std::list<BlockingObject> objects = blockingLineOfSight(pos, candidate->getPosition());
-
-            if (objects.empty()) {
+            if (hasLineOfSight(pos, candidate->getPosition())) {
                 ret.push_back(candidate);
                 found = true;
             }
@@ -154,125 +222,106 @@ auto World::findTargetsInSight(const position &pos, Coordinate range, std::vecto
 auto World::blockingLineOfSight(const position &startingpos, const position &endingpos) const
         -> std::list<BlockingObject> {
     std::list<BlockingObject> ret;
-    ret.clear();
-    bool steep = std::abs(startingpos.y - endingpos.y) > std::abs(startingpos.x - endingpos.x);
-    short int startx = startingpos.x;
-    short int starty = startingpos.y;
-    short int endx = endingpos.x;
-    short int endy = endingpos.y;
+    const bool steep = std::abs(startingpos.y - endingpos.y) > std::abs(startingpos.x - endingpos.x);
+    const bool swapped = steep ? startingpos.y > endingpos.y : startingpos.x > endingpos.x;
 
-    if (steep) {
-        // swap x,y values for correct execution in negative range
-        std::swap(startx, starty);
-        std::swap(endx, endy);
-    }
-
-    bool swapped = startx > endx;
-
-    if (swapped) {
-        std::swap(startx, endx);
-        std::swap(starty, endy);
-    }
-
-    Coordinate deltax = endx - startx;
-    Coordinate deltay = std::abs(endy - starty);
-    Coordinate error = 0;
-    Coordinate ystep = 1;
-    Coordinate y = starty;
-
-    if (starty > endy) {
-        ystep = -1;
-    }
-
-    for (Coordinate x = startx; x <= endx; ++x) {
-        if (!(x == startx && y == starty) && !(x == endx && y == endy)) {
+    walkLineOfSight(startingpos, endingpos, [this, &ret, swapped](const position &pos) {
+        try {
+            const map::Field &field = fieldAt(pos);
             BlockingObject bo;
-            position pos{x, y, startingpos.z};
 
-            if (steep) {
-                pos.x = y;
-                pos.y = x;
-            }
-
-            try {
-                const map::Field &field = fieldAt(pos);
+            if (field.hasPlayer()) {
+                bo.blockingType = BlockingObject::BT_CHARACTER;
+                bo.blockingChar = findCharacterOnField(pos);
 
-                if (field.hasPlayer()) {
-                    bo.blockingType = BlockingObject::BT_CHARACTER;
-                    bo.blockingChar = findCharacterOnField(pos);
-
-                    if (swapped) {
-                        ret.push_back(bo);
-                    } else {
-                        ret.push_front(bo);
-                    }
+                if (swapped) {
+                    ret.push_back(bo);
                 } else {
-                    ScriptItem it;
+                    ret.push_front(bo);
+                }
+            } else if (field.blocksSight()) {
+                ScriptItem it;
 
-                    for (size_t i = 0; i < field.itemCount(); ++i) {
-                        auto testItem = field.getStackItem(i);
+                for (size_t i = 0; i < field.itemCount(); ++i) {
+                    auto testItem = field.getStackItem(i);
 
-                        if (testItem.getVolume() > it.getVolume()) {
-                            it = testItem;
-                        }
+                    if (testItem.getVolume() > it.getVolume()) {
+                        it = testItem;
                     }
+                }
 
-                    if (it.isLarge()) {
-                        bo.blockingType = BlockingObject::BT_ITEM;
-                        it.pos = pos;
-                        it.type = ScriptItem::it_field;
-                        bo.blockingItem = it;
+                bo.blockingType = BlockingObject::BT_ITEM;
+                it.pos = pos;
+                it.type = ScriptItem::it_field;
+                bo.blockingItem = it;
 
-                        if (swapped) {
-                            ret.push_back(bo);
-                        } else {
-                            ret.push_front(bo);
-                        }
-                    }
+                if (swapped) {
+                    ret.push_back(bo);
+                } else {
+                    ret.push_front(bo);
                 }
-            } catch (FieldNotFound &) {
             }
+        } catch (FieldNotFound &) {
         }
 
-        error += deltay;
-
-        if (2 * error >= deltax) {
-            y += ystep;
-            error -= deltax;
-        }
-    }
+        return true;
+    });
 
     return ret;
 }
 
+auto World::hasLineOfSight(const position &startingpos, const position &endingpos) const -> bool {
+    return walkLineOfSight(startingpos, endingpos, [this](const position &pos) {
+        try {
+            const map::Field &field = fieldAt(pos);
+            return !field.hasPlayer() && !field.blocksSight();
+        } catch (FieldNotFound &) {
+            return true;
+        }
+    });
+}
+
 // function which updates the playerlist.
 void World::updatePlayerList() const {
     using namespace Database;
 
-    PConnection connection = ConnectionManager::getInstance().getConnection();
-
-    try {
-        connection->beginTransaction();
+    std::vector<TYPE_OF_CHARACTER_ID> online;
+    Players.for_each([&online](Player *player) { online.push_back(player->getId()); });
 
+    AsyncExecutor::getInstance().write("saving the online player list", [online](const PConnection &connection) {
         DeleteQuery delQuery(connection);
         delQuery.setServerTable("onlineplayer");
         delQuery.execute();
 
-        if (!Players.empty()) {
-            InsertQuery insQuery(connection);
-            insQuery.setServerTable("onlineplayer");
-            const InsertQuery::columnIndex column = insQuery.addColumn("on_playerid");
+        InsertQuery insQuery(connection);
+        insQuery.setServerTable("onlineplayer");
+        const InsertQuery::columnIndex column = insQuery.addColumn("on_playerid");
+        insQuery.addValues<TYPE_OF_CHARACTER_ID>(column, online);
+        insQuery.execute();
+    });
+}
 
-            Players.for_each([&](Player *player) { insQuery.addValue<TYPE_OF_CHARACTER_ID>(column, player->getId()); });
+void World::addToPlayerList(TYPE_OF_CHARACTER_ID id) {
+    using namespace Database;
 
-            insQuery.execute();
-        }
+    AsyncExecutor::getInstance().write("adding to the online player list", [id](const PConnection &connection) {
+        InsertQuery insQuery(connection);
+        insQuery.setServerTable("onlineplayer");
+        const InsertQuery::columnIndex column = insQuery.addColumn("on_playerid");
+        insQuery.addValue<TYPE_OF_CHARACTER_ID>(column, id);
+        insQuery.execute();
+    });
+}
 
-        connection->commitTransaction();
-    } catch (std::exception &e) {
-        Logger::error(LogFacility::World) << "Exception during saving online player list: " << e.what() << Log::end;
-        connection->rollbackTransaction();
-    }
+void World::removeFromPlayerList(const std::vector<TYPE_OF_CHARACTER_ID> &ids) {
+    using namespace Database;
+
+    AsyncExecutor::getInstance().write("removing from the online player list", [ids](const PConnection &connection) {
+        DeleteQuery delQuery(connection);
+        delQuery.setServerTable("onlineplayer");
+        delQuery.addInCondition<TYPE_OF_CHARACTER_ID>("onlineplayer", "on_playerid", ids);
+        delQuery.execute();
+    });
 }
 
 auto World::findCharacterOnField(const position &pos) const -> Character * {
@@ -299,6 +348,25 @@ auto World::findCharacterOnField(const position &pos) const -> Character * {
 
 auto World::findPlayerOnField(const position &pos) const -> Player * { return Players.find(pos); }
 
+auto World::findCharacterByHandle(TYPE_OF_CHARACTER_ID id, SlotHandle handle) -> Character * {
+    Character *character = nullptr;
+
+    if (id < MONSTER_BASE) {
+        character = Players.find(handle);
+    } else if (id < NPC_BASE) {
+        character = Monsters.find(handle);
+    } else {
+        character = Npc.find(handle);
+    }
+
+    return character != nullptr ? character : findCharacter(id);
+}
+
+void World::addNewMonster(Monster *monster) {
+    newMonsters.push_back(monster);
+    newMonstersById.emplace(monster->getId(), monster);
+}
+
 auto World::findCharacter(TYPE_OF_CHARACTER_ID id) -> Character * {
     if (id < MONSTER_BASE) {
         auto *tmpChr = dynamic_cast<Character *>(Players.find(id));
@@ -312,16 +380,10 @@ auto World::findCharacter(TYPE_OF_CHARACTER_ID id) -> Character * {
         if (tmpChr != nullptr) {
             return tmpChr;
         }
-        using namespace ranges;
 
-        auto idsMatch = [id](const auto &monster) { return monster->getId() == id; };
-
-        auto result = find_if(newMonsters, idsMatch);
-
-        if (result != newMonsters.end()) {
-            return *result;
+        if (const auto spawning = newMonstersById.find(id); spawning != newMonstersById.end()) {
+            return spawning->second;
         }
-
     } else {
         auto *tmpChr = dynamic_cast<Character *>(Npc.find(id));
 
@@ -374,17 +436,17 @@ auto World::characterAttacks(Character *cp) const -> bool {
 
                         // set lasttargetseen to false if the player who was attacked is death
                         if (cp->getType() == Character::monster) {
-                            auto *mon = dynamic_cast<Monster *>(cp);
+                            auto *mon = static_cast<Monster *>(cp);
                             mon->lastTargetSeen = false;
                         }
 
                         if (cp->getType() == Character::player) {
                             ServerCommandPointer cmd = std::make_shared<TargetLostTC>();
-                            dynamic_cast<Player *>(cp)->Connection->addCommand(cmd);
+                            static_cast<Player *>(cp)->Connection->addCommand(cmd);
                         }
 
                         ServerCommandPointer cmd = std::make_shared<TargetLostTC>();
-                        dynamic_cast<Player *>(temppl)->Connection->addCommand(cmd);
+                        temppl->Connection->addCommand(cmd);
                         temppl->setAttackMode(false);
                     }
 
@@ -411,7 +473,7 @@ auto World::characterAttacks(Character *cp) const -> bool {
 
                         if (cp->getType() == Character::player) {
                             ServerCommandPointer cmd = std::make_shared<TargetLostTC>();
-                            dynamic_cast<Player *>(cp)->Connection->addCommand(cmd);
+                            static_cast<Player *>(cp)->Connection->addCommand(cmd);
                         }
                     } else {
                         // check for turning into attackackers direction
@@ -421,7 +483,7 @@ auto World::characterAttacks(Character *cp) const -> bool {
 
                         // add the current attacker to the list
                         if (cp->getType() == Character::player) {
-                            temp.push_back(dynamic_cast<Player *>(cp));
+                            temp.push_back(cp);
                         }
 
                         if (!temp.empty()) {
@@ -443,7 +505,7 @@ auto World::characterAttacks(Character *cp) const -> bool {
 
         if (cp->getType() == Character::player) {
             ServerCommandPointer cmd = std::make_shared<TargetLostTC>();
-            dynamic_cast<Player *>(cp)->Connection->addCommand(cmd);
+            static_cast<Player *>(cp)->Connection->addCommand(cmd);
         }
 
         return false;
@@ -476,6 +538,10 @@ auto World::fieldAt(const position &pos) -> map::Field & { return maps.at(pos);
 
 auto World::fieldAt(const position &pos) const -> const map::Field & { return maps.at(pos); }
 
+void World::fieldsAlong(const position &start, int16_t xStep, Coordinate length, const map::Field **fields) const {
+    maps.fieldsAlong(start, xStep, length, fields);
+}
+
 auto World::fieldAtOrBelow(position &pos) -> map::Field & {
     for (size_t i = 0; i <= RANGEDOWN; ++i) {
         map::Field &field = fieldAt(pos);
@@ -501,20 +567,20 @@ auto World::isPersistentAt(const position &pos) const -> bool { return maps.isPe
 auto World::getItemAttrib(const std::string &s, TYPE_OF_ITEM_ID ItemID) -> int {
     // Armor //
     if (s == "bodyparts") {
-        if (Data::armorItems().exists(ItemID)) {
-            return Data::armorItems()[ItemID].BodyParts;
+        if (const auto *entry = Data::armorItems().find(ItemID); entry != nullptr) {
+            return entry->BodyParts;
         }
     } else if (s == "strokearmor") {
-        if (Data::armorItems().exists(ItemID)) {
-            return Data::armorItems()[ItemID].StrokeArmor;
+        if (const auto *entry = Data::armorItems().find(ItemID); entry != nullptr) {
+            return entry->StrokeArmor;
         }
     } else if (s == "thrustarmor") {
-        if (Data::armorItems().exists(ItemID)) {
-            return Data::armorItems()[ItemID].ThrustArmor;
+        if (const auto *entry = Data::armorItems().find(ItemID); entry != nullptr) {
+            return entry->ThrustArmor;
         }
     } else if (s == "armormagicdisturbance") {
-        if (Data::armorItems().exists(ItemID)) {
-            return Data::armorItems()[ItemID].MagicDisturbance;
+        if (const auto *entry = Data::armorItems().find(ItemID); entry != nullptr) {
+            return entry->MagicDisturbance;
         }
     }
 
@@ -541,35 +607,35 @@ auto World::getItemAttrib(const std::string &s, TYPE_OF_ITEM_ID ItemID) -> int {
 
     // Tiles Modificator //
     else if (s == "modificator") {
-        if (Data::tilesModItems().exists(ItemID)) {
-            return Data::tilesModItems()[ItemID].Modificator;
+        if (const auto *entry = Data::tilesModItems().find(ItemID); entry != nullptr) {
+            return entry->Modificator;
         }
     }
 
     // Weapon //
     else if (s == "accuracy") {
-        if (Data::weaponItems().exists(ItemID)) {
-            return Data::weaponItems()[ItemID].Accuracy;
+        if (const auto *entry = Data::weaponItems().find(ItemID); entry != nullptr) {
+            return entry->Accuracy;
         }
     } else if (s == "attack") {
-        if (Data::weaponItems().exists(ItemID)) {
-            return Data::weaponItems()[ItemID].Attack;
+        if (const auto *entry = Data::weaponItems().find(ItemID); entry != nullptr) {
+            return entry->Attack;
         }
     } else if (s == "defence") {
-        if (Data::weaponItems().exists(ItemID)) {
-            return Data::weaponItems()[ItemID].Defence;
+        if (const auto *entry = Data::weaponItems().find(ItemID); entry != nullptr) {
+            return entry->Defence;
         }
     } else if (s == "range") {
-        if (Data::weaponItems().exists(ItemID)) {
-            return Data::weaponItems()[ItemID].Range;
+        if (const auto *entry = Data::weaponItems().find(ItemID); entry != nullptr) {
+            return entry->Range;
         }
     } else if (s == "weapontype") {
-        if (Data::weaponItems().exists(ItemID)) {
-            return Data::weaponItems()[ItemID].Type;
+        if (const auto *entry = Data::weaponItems().find(ItemID); entry != nullptr) {
+            return entry->Type;
         }
     } else if (s == "weaponmagicdisturbance") {
-        if (Data::weaponItems().exists(ItemID)) {
-            return Data::weaponItems()[ItemID].MagicDisturbance;
+        if (const auto *entry = Data::weaponItems().find(ItemID); entry != nullptr) {
+            return entry->MagicDisturbance;
         }
     }
 
@@ -577,25 +643,111 @@ auto World::getItemAttrib(const std::string &s, TYPE_OF_ITEM_ID ItemID) -> int {
 }
 
 void World::ageMaps() {
-    if (not maps.allMapsAged()) {
+    if (deferAgeing() || not maps.allMapsAged()) {
         scheduler.addOneshotTask([&] { ageMaps(); }, std::chrono::seconds(1), "age_maps");
     }
 }
 
-void World::ageInventory() const {
-    Players.for_each(&Player::ageInventory);
-    Monsters.for_each(&Monster::ageInventory);
+void World::ageInventory() {
+    if (deferAgeing()) {
+        scheduler.addOneshotTask([&] { ageInventory(); }, std::chrono::seconds(1), "age_inventory");
+        return;
+    }
+
+    // characters only touch their own items while ageing, client updates follow on this thread
+    std::vector<Character *> characters;
+    Players.for_each([&characters](Player *player) { characters.push_back(player); });
+    Monsters.for_each([&characters](Monster *monster) { characters.push_back(monster); });
+    std::vector<Character::InventoryAgeing> aged(characters.size());
+
+    runInParallel(
+            characters.size(), [&characters, &aged](size_t i) { aged[i] = characters[i]->ageItems(); },
+            inventoriesPerWorker);
+
+    for (size_t i = 0; i < characters.size(); ++i) {
+        characters[i]->inventoryAged(aged[i]);
+    }
+}
+
+auto World::deferAgeing() -> bool {
+    if (overloaded && Config::instance().shed_overload && deferredAgeings < maxDeferrals) {
+        ++deferredAgeings;
+        return true;
+    }
+
+    deferredAgeings = 0;
+    return false;
 }
 
 void World::Save() const { maps.saveToDisk(); }
 
+void World::withoutPlayersOnFields(const std::function<void()> &save) {
+    Players.for_each([this](Player *player) {
+        try {
+            fieldAt(player->getPosition()).removePlayer();
+        } catch (FieldNotFound &) {
+        }
+    });
+
+    save();
+
+    Players.for_each([this](Player *player) {
+        try {
+            fieldAt(player->getPosition()).setPlayer();
+        } catch (FieldNotFound &) {
+        }
+    });
+}
+
+void World::saveWhileRunning() {
+    withoutPlayersOnFields([this] {
+        if (Config::instance().background_map_save) {
+            maps.saveToDiskInBackground();
+        } else {
+            Save();
+        }
+    });
+}
+
+void World::backup() {
+    // YYYYMMDD-HHMMSS/
+    constexpr size_t backupNameLength = 17;
+    const time_t now = time(nullptr);
+    tm local{};
+    localtime_r(&now, &local);
+    std::array<char, backupNameLength> name{};
+    std::strftime(name.data(), name.size(), "%Y%m%d-%H%M%S/", &local);
+    const auto directory = Config::instance().backup_dir() + name.data();
+
+    Players.for_each([](Player *player) { PlayerManager::get().savePlayer(*player); });
+
+    std::vector<std::pair<std::string, std::string>> files;
+    files.emplace_back("scriptvariables.copy", Data::scriptVariables().copyText());
+
+    withoutPlayersOnFields([this, &directory, &files] { maps.backupInBackground(directory, std::move(files)); });
+}
+
 void World::Load() {
     if (!maps.loadFromDisk()) {
         maps.importFromEditor();
     }
+
+    markTriggerFields();
+}
+
+void World::import() {
+    maps.importFromEditor();
+    markTriggerFields();
 }
 
-void World::import() { maps.importFromEditor(); }
+void World::markTriggerFields() {
+    for (const auto &trigger : Data::triggers()) {
+        try {
+            fieldAt(trigger.first).markTrigger();
+        } catch (FieldNotFound &) {
+        }
+    }
+}
 
 auto World::getTime(const std::string &timeType) const -> int {
     // return unix timestamp if requsted and quit function
@@ -692,44 +844,76 @@ auto World::getTime(const std::string &timeType) const -> int {
 }
 
 auto World::findWarpFieldsInRange(const position &pos, Coordinate range, std::vector<position> &warppositions) -> bool {
-    for (Coordinate x = pos.x - range; x <= pos.x + range; ++x) {
-        for (Coordinate y = pos.y - range; y <= pos.y + range; ++y) {
-            try {
-                const position p(x, y, pos.z);
-
-                if (fieldAt(p).isWarp()) {
-                    warppositions.push_back(p);
-                }
-            } catch (FieldNotFound &) {
+    for (const auto &candidate : map::FieldIndex::get().warpsInRange(pos, range)) {
+        try {
+            if (fieldAt(candidate).isWarp()) {
+                warppositions.push_back(candidate);
             }
+        } catch (FieldNotFound &) {
         }
     }
 
+    std::sort(warppositions.begin(), warppositions.end(), PositionComparison());
     return !warppositions.empty();
 }
 
 void World::sendRemoveCharToVisiblePlayers(TYPE_OF_CHARACTER_ID id, const position &pos) const {
     ServerCommandPointer cmd = std::make_shared<RemoveCharTC>(id);
 
-    for (const auto &player : Players.findAllCharactersInScreen(pos)) {
-        player->sendCharRemove(id, cmd);
+    Observers.forEachObserverOf(pos, [id, &cmd](Player *player) { player->sendCharRemove(id, cmd); });
+}
+
+void World::attributesChanged(const Character &character) {
+    charactersWithChangedAttributes.push_back(character.getId());
+}
+
+void World::flushAttributeUpdates() {
+    // updates sent here may change attributes again, those wait for the next flush
+    std::swap(flushedAttributeUpdates, charactersWithChangedAttributes);
+
+    for (const auto id : flushedAttributeUpdates) {
+        if (auto *character = findCharacter(id); character != nullptr) {
+            character->flushAttributeUpdates();
+        }
+    }
+
+    flushedAttributeUpdates.clear();
+}
+
+void World::characterMovesQueued(const Player &player) { playersWithQueuedMoves.push_back(player.getId()); }
+
+void World::flushCharacterMoves() {
+    // players with far moves not yet due queue themselves again
+    std::swap(flushedCharacterMoves, playersWithQueuedMoves);
+
+    for (const auto id : flushedCharacterMoves) {
+        if (auto *player = Players.find(id); player != nullptr) {
+            player->flushCharacterMoves();
+        }
     }
+
+    flushedCharacterMoves.clear();
 }
 
 void World::sendHealthToAllVisiblePlayers(Character *cc, Attribute::attribute_t health) const {
     if (!cc->isInvisible()) {
         const auto &charPos = cc->getPosition();
 
-        for (const auto &player : Players.findAllCharactersInScreen(cc->getPosition())) {
+        ServerCommandPointer cmd;
+
+        Observers.forEachObserverOf(charPos, [cc, &charPos, health, &cmd](Player *player) {
             const auto &playerPos = player->getPosition();
             Coordinate xoffs = charPos.x - playerPos.x;
             Coordinate yoffs = charPos.y - playerPos.y;
             Coordinate zoffs = charPos.z - playerPos.z + RANGEDOWN;
 
             if ((xoffs != 0) || (yoffs != 0) || (zoffs != RANGEDOWN)) {
-                ServerCommandPointer cmd = std::make_shared<UpdateAttribTC>(cc->getId(), "hitpoints", health);
+                if (!cmd) {
+                    cmd = std::make_shared<UpdateAttribTC>(cc->getId(), "hitpoints", health);
+                }
+
                 player->Connection->addCommand(cmd);
             }
-        }
+        });
     }
 }
@@ -86,14 +86,24 @@ public:
 
     [[nodiscard]] virtual auto blockingLineOfSight(const position &start, const position &end) const
             -> std::list<BlockingObject> = 0;
+    [[nodiscard]] virtual auto hasLineOfSight(const position &start, const position &end) const -> bool = 0;
     virtual void changeTile(short int tileid, const position &pos) = 0;
     virtual auto createSavedArea(uint16_t tile, const position &origin, uint16_t height, uint16_t width) -> bool = 0;
+    // the map at pos becomes a template of that name, from which instances are made at any free origin
+    virtual auto saveMapTemplate(const position &pos, const std::string &templateName) -> bool = 0;
+    virtual auto createMapInstance(const std::string &templateName, const position &origin) -> bool = 0;
+    // fails unless pos is on an instance without characters on it
+    virtual auto removeMapInstance(const position &pos) -> bool = 0;
     virtual auto fieldAt(const position &pos) -> map::Field & = 0;
     [[nodiscard]] virtual auto fieldAt(const position &pos) const -> const map::Field & = 0;
     [[nodiscard]] virtual auto getCharacterOnField(const position &pos) const -> character_ptr = 0;
     [[nodiscard]] virtual auto isCharacterOnField(const position &pos) const -> bool = 0;
     virtual auto getItemOnField(const position &pos) -> ScriptItem = 0;
     virtual auto isItemOnField(const position &pos) -> bool = 0;
+    // the square of fields around pos on its level, column by column, leaving out positions without a field
+    virtual auto getFieldsInArea(const position &pos, uint8_t radius) -> std::vector<map::Field *> = 0;
+    [[nodiscard]] virtual auto findItemsInArea(const position &pos, uint8_t radius, TYPE_OF_ITEM_ID id) const
+            -> std::vector<ScriptItem> = 0;
     virtual void makePersistentAt(const position &pos) = 0;
     virtual void removePersistenceAt(const position &pos) = 0;
     [[nodiscard]] virtual auto isPersistentAt(const position &pos) const -> bool = 0;
@@ -0,0 +1,106 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "WorldView.hpp"
+
+#include "Monster.hpp"
+#include "NPC.hpp"
+#include "Player.hpp"
+#include "World.hpp"
+#include "map/Field.hpp"
+
+#include <atomic>
+#include <utility>
+
+std::shared_ptr<const WorldView> WorldView::published = std::make_shared<const WorldView>();
+
+auto WorldView::current() -> std::shared_ptr<const WorldView> { return std::atomic_load(&published); }
+
+void WorldView::publish(const World &world) {
+    const auto previous = current();
+    auto view = std::make_shared<WorldView>();
+    view->tickNumber = previous->tickNumber + 1;
+    const auto &versions = map::ChunkVersions::get();
+
+    world.Observers.forEachActiveCell([&world, &previous, &view, &versions](const position &origin) {
+        const auto key = map::ChunkVersions::chunkKey(origin);
+        const auto version = versions.of(key);
+        const auto old = previous->chunks.find(key);
+
+        if (old != previous->chunks.end() && old->second->version == version) {
+            view->chunks.emplace(key, old->second);
+        } else {
+            view->chunks.emplace(key, copyChunk(world, origin, version));
+        }
+    });
+
+    const auto addCharacter = [&view](const Character *character) {
+        const CharacterState state{character->getId(), character->getPosition(),
+                                   static_cast<Character::character_type>(character->getType())};
+        view->characters.emplace(state.id, state);
+        view->charactersByChunk[map::ChunkVersions::chunkKey(state.pos)].push_back(state);
+    };
+
+    world.Players.for_each(addCharacter);
+    world.Monsters.for_each(addCharacter);
+    world.Npc.for_each(addCharacter);
+
+    std::atomic_store(&published, std::shared_ptr<const WorldView>(std::move(view)));
+}
+
+auto WorldView::copyChunk(const World &world, const position &origin, map::ChunkVersions::Version version)
+        -> std::shared_ptr<const Chunk> {
+    auto chunk = std::make_shared<Chunk>();
+    chunk->version = version;
+
+    for (int y = 0; y < chunkSize; ++y) {
+        for (int x = 0; x < chunkSize; ++x) {
+            try {
+                const auto &field =
+                        world.fieldAt(position(Coordinate(origin.x + x), Coordinate(origin.y + y), origin.z));
+                chunk->terrain[y * chunkSize + x] = {field.isWalkable(), pathfinding::Cost(field.getMovementCost())};
+            } catch (FieldNotFound &) {
+            }
+        }
+    }
+
+    return chunk;
+}
+
+auto WorldView::chunkAt(map::ChunkVersions::ChunkKey key) const -> std::shared_ptr<const Chunk> {
+    const auto chunk = chunks.find(key);
+    return chunk != chunks.end() ? chunk->second : nullptr;
+}
+
+auto WorldView::terrainAt(const position &pos) const -> pathfinding::Terrain {
+    constexpr int chunkBits = map::ChunkVersions::chunkBits;
+    const auto chunk = chunks.find(map::ChunkVersions::chunkKey(pos));
+
+    if (chunk == chunks.end()) {
+        return {};
+    }
+
+    const int x = pos.x - ((pos.x >> chunkBits) << chunkBits);
+    const int y = pos.y - ((pos.y >> chunkBits) << chunkBits);
+    return chunk->second->terrain[y * chunkSize + x];
+}
+
+auto WorldView::findCharacter(TYPE_OF_CHARACTER_ID id) const -> const CharacterState * {
+    const auto character = characters.find(id);
+    return character != characters.end() ? &character->second : nullptr;
+}
@@ -0,0 +1,108 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef WORLD_VIEW_HPP
+#define WORLD_VIEW_HPP
+
+#include "Character.hpp"
+#include "a_star.hpp"
+#include "globals.hpp"
+#include "map/ChunkVersions.hpp"
+#include "types.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class World;
+
+// Read-only copy of the world as of the end of a tick: the terrain of the chunks within activation range of a
+// player, where creatures act, and the positions of all characters. The game thread publishes a new view once per
+// tick with world_view set, chunks unchanged since the last view are shared with it. Worker threads take the current
+// view and may keep reading it for as long as they like, without locks.
+class WorldView {
+public:
+    static constexpr int chunkSize = 1 << map::ChunkVersions::chunkBits;
+
+    struct Chunk {
+        map::ChunkVersions::Version version = 0;
+        std::array<pathfinding::Terrain, chunkSize * chunkSize> terrain;
+    };
+
+    struct CharacterState {
+        TYPE_OF_CHARACTER_ID id = 0;
+        position pos;
+        Character::character_type type = Character::player;
+    };
+
+    // the last published view, an empty one before the first; any thread
+    static auto current() -> std::shared_ptr<const WorldView>;
+    // builds and publishes the view of the tick just done, game thread only
+    static void publish(const World &world);
+    // copies the terrain of the chunk starting at origin, game thread only
+    static auto copyChunk(const World &world, const position &origin, map::ChunkVersions::Version version)
+            -> std::shared_ptr<const Chunk>;
+
+    // counts the published views, 0 for the empty one
+    [[nodiscard]] auto tick() const -> uint64_t { return tickNumber; }
+    // nullptr if the chunk is not part of the view
+    [[nodiscard]] auto chunkAt(map::ChunkVersions::ChunkKey key) const -> std::shared_ptr<const Chunk>;
+    // not walkable outside the chunks of the view
+    [[nodiscard]] auto terrainAt(const position &pos) const -> pathfinding::Terrain;
+    [[nodiscard]] auto findCharacter(TYPE_OF_CHARACTER_ID id) const -> const CharacterState *;
+
+    // visits the characters on the level of pos at most range fields away from it
+    template <class Visitor>
+    void forEachCharacterInRange(const position &pos, Coordinate range, Visitor &&visit) const {
+        constexpr int chunkBits = map::ChunkVersions::chunkBits;
+
+        for (int y = (pos.y - range) >> chunkBits; y <= (pos.y + range) >> chunkBits; ++y) {
+            for (int x = (pos.x - range) >> chunkBits; x <= (pos.x + range) >> chunkBits; ++x) {
+                const position origin(Coordinate(x << chunkBits), Coordinate(y << chunkBits), pos.z);
+                const auto chunk = charactersByChunk.find(map::ChunkVersions::chunkKey(origin));
+
+                if (chunk == charactersByChunk.end()) {
+                    continue;
+                }
+
+                for (const auto &character : chunk->second) {
+                    const auto dx = std::abs(character.pos.x - pos.x);
+                    const auto dy = std::abs(character.pos.y - pos.y);
+
+                    if (dx <= range && dy <= range) {
+                        visit(character);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    uint64_t tickNumber = 0;
+    std::unordered_map<map::ChunkVersions::ChunkKey, std::shared_ptr<const Chunk>> chunks;
+    std::unordered_map<map::ChunkVersions::ChunkKey, std::vector<CharacterState>> charactersByChunk;
+    std::unordered_map<TYPE_OF_CHARACTER_ID, CharacterState> characters;
+
+    // accessed through std::atomic_load and std::atomic_store only
+    static std::shared_ptr<const WorldView> published;
+};
+
+#endif
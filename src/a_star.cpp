@@ -21,259 +21,201 @@
 #include "a_star.hpp"
 
 #include "World.hpp"
-#include "data/Data.hpp"
-#include "data/TilesTable.hpp"
 #include "map/Field.hpp"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
-#include <utility>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <vector>
 
 namespace pathfinding {
 
-using namespace boost;
+namespace {
 
 constexpr auto maximumNodes = 400;
-
-character_out_edge_iterator::character_out_edge_iterator() = default;
-
-character_out_edge_iterator::character_out_edge_iterator(int i, Position p, const world_map_graph &g)
-        : position(std::move(p)), graph(&g), direction(i) {
-    valid_step();
-}
-
-auto character_out_edge_iterator::operator*() const -> std::pair<Position, Position> {
-    return std::make_pair(position, Position(position.first + character_moves[direction].first,
-                                             position.second + character_moves[direction].second));
-}
-
-void character_out_edge_iterator::operator++() {
-    ++direction;
-    valid_step();
-}
-
-auto character_out_edge_iterator::operator==(const character_out_edge_iterator &iterator) const -> bool {
-    return direction == iterator.direction;
-}
-
-void character_out_edge_iterator::valid_step() {
-    Position new_pos(position.first + character_moves[direction].first,
-                     position.second + character_moves[direction].second);
-    bool moveToPossible = false;
-
-    try {
-        map::Field &field = World::get()->fieldAt(::position(new_pos.first, new_pos.second, graph->level));
-        moveToPossible = field.moveToPossible();
-    } catch (FieldNotFound &) {
-    }
-
-    while (direction <= maxDirection && !moveToPossible && !(new_pos == graph->goal)) {
-        ++direction;
-
-        new_pos = Position(position.first + character_moves[direction].first,
-                           position.second + character_moves[direction].second);
-
-        try {
-            map::Field &field = World::get()->fieldAt(::position(new_pos.first, new_pos.second, graph->level));
-            moveToPossible = field.moveToPossible();
-        } catch (FieldNotFound &) {
+// the search is bound to the rectangle spanned by start and goal, widened by this margin for detours
+constexpr auto windowMargin = 16;
+
+constexpr auto unreached = std::numeric_limits<Cost>::max();
+
+struct Move {
+    int dx;
+    int dy;
+};
+
+// indexed by direction
+constexpr std::array<Move, maxDirection + 1> moves = {
+        {{0, -1}, {1, -1}, {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}}};
+
+struct Node {
+    // search which last looked at the node, everything else is only valid for that search
+    uint32_t generation = 0;
+    bool passable = false;
+    Cost weight = 0;
+    Cost distance = unreached;
+    uint8_t from = 0;
+};
+
+struct Candidate {
+    Cost rank;
+    Cost distance;
+    uint32_t node;
+
+    auto operator>(const Candidate &other) const -> bool { return rank > other.rank; }
+};
+
+// reused by all searches of a thread, generation stamps spare clearing the nodes
+struct Arena {
+    std::vector<Node> nodes;
+    std::vector<Candidate> open;
+    uint32_t generation = 0;
+    uint64_t expanded = 0;
+
+    void prepare(size_t size) {
+        if (nodes.size() < size) {
+            nodes.resize(size);
         }
-    }
-}
 
-world_map_graph::world_map_graph(Position goal, int level) : goal(std::move(goal)), level(level) {}
-
-auto source(const world_map_graph::edge_descriptor &e, const world_map_graph &g) -> world_map_graph::vertex_descriptor {
-    return e.first;
-}
-
-auto target(const world_map_graph::edge_descriptor &e, const world_map_graph &g) -> world_map_graph::vertex_descriptor {
-    return e.second;
-}
-
-auto out_edges(const world_map_graph::vertex_descriptor &v, const world_map_graph &g)
-        -> std::pair<world_map_graph::out_edge_iterator, world_map_graph::out_edge_iterator> {
-    using Iterator = world_map_graph::out_edge_iterator;
-    return std::make_pair(Iterator(0, v, g), Iterator(maxDirection + 1, v, g));
-}
+        if (++generation == 0) {
+            for (auto &node : nodes) {
+                node.generation = 0;
+            }
 
-auto out_degree(const world_map_graph::vertex_descriptor &v, const world_map_graph &g)
-        -> world_map_graph::degree_size_type {
-    using Iterator = world_map_graph::out_edge_iterator;
-    world_map_graph::degree_size_type count = 0;
-    Iterator end(maxDirection + 1, v, g);
+            generation = 1;
+        }
 
-    for (Iterator it(0, v, g); it != end; ++it) {
-        ++count;
+        open.clear();
     }
+};
 
-    return count;
-}
-
-auto num_vertices(const world_map_graph &g) -> int { return numberOfVertices; }
-
-distance_heuristic::distance_heuristic(Vertex goal) : goal(std::move(goal)) {
-    Logger::debug(LogFacility::Other) << "heuristic goal (" << this->goal.first << ", " << this->goal.second << ")"
-                                      << Log::end;
-}
+thread_local Arena arena;
 
-auto distance_heuristic::operator()(const Vertex &u) const -> Cost {
-    Cost dx = goal.first - u.first;
-    Cost dy = goal.second - u.second;
-    Cost d = std::sqrt(dx * dx + dy * dy);
-    Logger::debug(LogFacility::Other) << "from (" << u.first << ", " << u.second << ") to (" << goal.first << ", "
-                                      << goal.second << "): " << d << Log::end;
-    return d;
+auto heuristic(int x, int y, const ::position &goal) -> Cost {
+    const Cost dx = goal.x - x;
+    const Cost dy = goal.y - y;
+    return std::sqrt(dx * dx + dy * dy);
 }
 
-auto edge_hash::operator()(std::pair<Position, Position> const &e) const -> std::size_t {
-    std::size_t seed = 0;
-    boost::hash_combine(seed, e.first.first);
-    boost::hash_combine(seed, e.first.second);
-    boost::hash_combine(seed, e.second.first);
-    boost::hash_combine(seed, e.second.second);
-    return seed;
+void inspect(Node &node, const ::position &pos, bool isGoal, const TerrainLookup &terrainAt) {
+    const auto terrain = terrainAt(pos);
+    node.generation = arena.generation;
+    node.distance = unreached;
+    node.passable = isGoal || terrain.walkable;
+    node.weight = terrain.cost;
 }
 
-weight_calc::weight_calc(int level) : level(level) {}
-
-auto weight_calc::operator[](key_type const &k) -> mapped_type & {
-    if (find(k) == end()) {
-        auto v = k.second;
+} // namespace
 
+auto a_star(const ::position &start_pos, const ::position &goal_pos, std::list<direction> &steps) -> bool {
+    return a_star(start_pos, goal_pos, steps, [](const ::position &pos) -> Terrain {
         try {
-            map::Field &field = World::get()->fieldAt(::position(v.first, v.second, level));
-            auto tileId = field.getTileId();
-            insert(std::make_pair(k, Data::tiles()[tileId].walkingCost));
+            const map::Field &field = World::get()->fieldAt(pos);
+            return {field.moveToPossible(), Cost(field.getMovementCost())};
         } catch (FieldNotFound &) {
-            insert(std::make_pair(k, 1));
+            return {};
         }
-    }
-
-    return at(k);
-}
-
-auto vertex_hash::operator()(Position const &u) const -> std::size_t {
-    std::size_t seed = 0;
-    boost::hash_combine(seed, u.first);
-    boost::hash_combine(seed, u.second);
-    return seed;
+    });
 }
 
-auto vertex_index_hash::operator[](key_type const &k) -> mapped_type & {
-    if (find(k) == end()) {
-        insert(std::make_pair(k, ++discovery_counter));
-    }
-
-    if (discovery_counter > maximumNodes) {
-        Logger::debug(LogFacility::Other) << "[PATH FINDING] No path found in vertex_index_hash!" << Log::end;
-        throw not_found();
-    }
-
-    return at(k);
-}
-
-astar_ex_visitor::astar_ex_visitor(Position goal) : goal(std::move(goal)) {}
-
-void astar_ex_visitor::examine_vertex(const Position &u, const world_map_graph & /*unused*/) {
-    if (u == goal) {
-        Logger::debug(LogFacility::Other) << "[PATH FINDING] Path found in astar_ex_visitor!" << Log::end;
-        throw found_goal();
-    }
-}
-
-void astar_ex_visitor::discover_vertex(const Position &u, const world_map_graph & /*unused*/) {
-    ++node_counter;
-
-    if (node_counter > maximumNodes) {
-        Logger::debug(LogFacility::Other) << "[PATH FINDING] No path found in astar_ex_visitor!" << Log::end;
-        throw not_found();
-    }
-}
-
-auto dist_map::operator[](key_type const &k) -> mapped_type & {
-    if (find(k) == end()) {
-        insert(std::make_pair(k, std::numeric_limits<Cost>::max()));
-    }
-
-    return at(k);
-}
-
-auto pred_map::operator[](key_type const &k) -> mapped_type & {
-    if (find(k) == end()) {
-        insert(std::make_pair(k, k));
-    }
-
-    return at(k);
-}
-
-auto a_star(const ::position &start_pos, const ::position &goal_pos, std::list<direction> &steps) -> bool {
+auto a_star(const ::position &start_pos, const ::position &goal_pos, std::list<direction> &steps,
+            const TerrainLookup &terrainAt) -> bool {
     steps.clear();
 
     if (start_pos.z != goal_pos.z || start_pos == goal_pos) {
         return false;
     }
 
-    using vertex = graph_traits<world_map_graph>::vertex_descriptor;
+    // every step of a path discovers at least one node
+    if (std::max(std::abs(goal_pos.x - start_pos.x), std::abs(goal_pos.y - start_pos.y)) > maximumNodes) {
+        return false;
+    }
+
+    const int left = std::min(start_pos.x, goal_pos.x) - windowMargin;
+    const int top = std::min(start_pos.y, goal_pos.y) - windowMargin;
+    const int width = std::max(start_pos.x, goal_pos.x) + windowMargin - left + 1;
+    const int height = std::max(start_pos.y, goal_pos.y) + windowMargin - top + 1;
+    const auto indexOf = [left, top, width](int x, int y) { return uint32_t((y - top) * width + (x - left)); };
+
+    arena.prepare(size_t(width) * size_t(height));
+    auto &nodes = arena.nodes;
+    auto &open = arena.open;
+
+    const auto startIndex = indexOf(start_pos.x, start_pos.y);
+    const auto goalIndex = indexOf(goal_pos.x, goal_pos.y);
+    inspect(nodes[startIndex], start_pos, false, terrainAt);
+    nodes[startIndex].distance = 0;
+    open.push_back({heuristic(start_pos.x, start_pos.y, goal_pos), 0, startIndex});
+    int discovered = 1;
+
+    while (!open.empty()) {
+        std::pop_heap(open.begin(), open.end(), std::greater<>());
+        const auto current = open.back();
+        open.pop_back();
+
+        if (current.distance > nodes[current.node].distance) {
+            continue;
+        }
 
-    vertex start(start_pos.x, start_pos.y);
-    vertex goal(goal_pos.x, goal_pos.y);
-    world_map_graph g(goal, goal_pos.z);
+        ++arena.expanded;
 
-    distance_heuristic h(goal);
-    h(start);
+        if (current.node == goalIndex) {
+            for (auto index = goalIndex; index != startIndex;) {
+                const auto from = nodes[index].from;
+                steps.push_front(direction(from));
+                const auto x = int(index % width) - moves[from].dx;
+                const auto y = int(index / width) - moves[from].dy;
+                index = uint32_t(y * width + x);
+            }
 
-    weight_calc weights(goal_pos.z);
-    boost::associative_property_map<weight_calc> weight(weights);
+            return true;
+        }
 
-    pred_map predecessor;
-    boost::associative_property_map<pred_map> pred_pmap(predecessor);
+        const int x = left + int(current.node % width);
+        const int y = top + int(current.node / width);
 
-    dist_map distance;
-    distance[start] = 0;
-    boost::associative_property_map<dist_map> dist_pmap(distance);
+        for (uint8_t dir = 0; dir <= maxDirection; ++dir) {
+            const int nextX = x + moves[dir].dx;
+            const int nextY = y + moves[dir].dy;
 
-    dist_map rank;
-    rank[start] = h(start);
-    boost::associative_property_map<dist_map> rank_pmap(rank);
+            if (nextX < left || nextY < top || nextX >= left + width || nextY >= top + height) {
+                continue;
+            }
 
-    vertex_index_hash index_map;
-    boost::associative_property_map<vertex_index_hash> index(index_map);
+            const auto index = indexOf(nextX, nextY);
+            auto &next = nodes[index];
 
-    astar_ex_visitor visitor(goal);
+            if (next.generation != arena.generation) {
+                inspect(next, ::position(nextX, nextY, goal_pos.z), index == goalIndex, terrainAt);
+            }
 
-    using color_map_t = boost::unordered_map<Position, default_color_type, vertex_hash>;
-    color_map_t color_map;
-    boost::associative_property_map<color_map_t> color(color_map);
+            if (!next.passable) {
+                continue;
+            }
 
-    try {
-        astar_search_no_init(g, start, h, visitor, pred_pmap, rank_pmap, dist_pmap, weight, color, index, std::less<>(),
-                             std::plus<>(), std::numeric_limits<Cost>::max(), Cost());
-    } catch (found_goal &fg) {
-        vertex v = goal;
-        vertex pre = predecessor[v];
+            const Cost distance = current.distance + next.weight;
 
-        while (v != pre) {
-            int dx = v.first - pre.first;
-            int dy = v.second - pre.second;
-            vertex dir(dx, dy);
+            if (distance >= next.distance) {
+                continue;
+            }
 
-            try {
-                steps.push_front(character_directions.at(dir));
-            } catch (std::out_of_range &) {
-                Logger::error(LogFacility::Other)
-                        << "direction (" << dir.first << ", " << dir.second << ") is invalid" << Log::end;
+            if (next.distance == unreached && ++discovered > maximumNodes) {
+                return false;
             }
 
-            v = pre;
-            pre = predecessor[v];
+            next.distance = distance;
+            next.from = dir;
+            open.push_back({distance + heuristic(nextX, nextY, goal_pos), distance, index});
+            std::push_heap(open.begin(), open.end(), std::greater<>());
         }
-
-        return true;
-    } catch (not_found &nf) {
-        return false;
     }
 
     return false;
 }
 
+auto expanded_nodes() -> uint64_t { return arena.expanded; }
+
 } // namespace pathfinding
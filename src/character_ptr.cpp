@@ -26,6 +26,7 @@
 character_ptr::character_ptr(Character *p) {
     if (p != nullptr) {
         id = p->getId();
+        handle = p->getHandle();
     } else {
         id = 0;
     }
@@ -49,11 +50,17 @@ auto character_ptr::operator->() const -> Character * { return get(); }
 character_ptr::operator bool() const { return getPointerFromId() != nullptr; }
 
 auto character_ptr::getPointerFromId() const -> Character * {
-    if (id != 0) {
-        return World::get()->findCharacter(id);
+    if (id == 0) {
+        return nullptr;
     }
 
-    return nullptr;
+    auto *character = World::get()->findCharacterByHandle(id, handle);
+
+    if (character != nullptr) {
+        handle = character->getHandle();
+    }
+
+    return character;
 }
 
 auto get_pointer(character_ptr const &p) -> Character * { return p.get(); }
@@ -21,12 +21,15 @@
 #ifndef CHARACTER_PTR_HPP
 #define CHARACTER_PTR_HPP
 
+#include "SlotMap.hpp"
 #include "types.hpp"
 
 class Character;
 
 class character_ptr {
     TYPE_OF_CHARACTER_ID id{0};
+    // refreshed on lookup, monsters only get one once they are spawned
+    mutable SlotHandle handle;
 
 public:
     character_ptr() = default;
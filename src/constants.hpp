@@ -65,6 +65,7 @@ constexpr auto FLAG_MAKEPASSABLE = 8;
 constexpr auto FLAG_MONSTERONFIELD = 16;
 constexpr auto FLAG_NPCONFIELD = 32;
 constexpr auto FLAG_PLAYERONFIELD = 64;
+constexpr auto FLAG_BLOCKSIGHT = 128;
 
 // Verwendung siehe Tabelle:
 // WERT|      tiles        |   tilesmoditems   |       flags        |
@@ -83,7 +84,7 @@ constexpr auto FLAG_PLAYERONFIELD = 64;
 // ----+-------------------+-------------------+--------------------+
 // 064 |                   |                   |FLAG_PLAYERONFIELD  |
 // ----+-------------------+-------------------+--------------------+
-// 128 |                   |                   |                    |
+// 128 |                   |                   |FLAG_BLOCKSIGHT     |
 // ----+-------------------+-------------------+--------------------+
 
 //! das Verzeichnis der Karte, relativ zum DEFAULTMUDDIR
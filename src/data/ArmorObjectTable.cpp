@@ -27,11 +27,11 @@ auto ArmorObjectTable::getColumnNames() -> std::vector<std::string> {
             "arm_magicdisturbance", "arm_absorb",    "arm_stiffness", "arm_type"};
 }
 
-auto ArmorObjectTable::assignId(const Database::ResultTuple &row) -> TYPE_OF_ITEM_ID {
+auto ArmorObjectTable::assignId(const TableRow &row) -> TYPE_OF_ITEM_ID {
     return row["arm_itemid"].as<TYPE_OF_ITEM_ID>();
 }
 
-auto ArmorObjectTable::assignTable(const Database::ResultTuple &row) -> ArmorStruct {
+auto ArmorObjectTable::assignTable(const TableRow &row) -> ArmorStruct {
     ArmorStruct armor;
     armor.BodyParts = TYPE_OF_BODYPARTS(row["arm_bodyparts"].as<int16_t>());
     armor.PunctureArmor = TYPE_OF_PUNCTUREARMOR(row["arm_puncture"].as<int16_t>());
@@ -29,8 +29,8 @@ class ArmorObjectTable : public StructTable<TYPE_OF_ITEM_ID, ArmorStruct> {
 public:
     auto getTableName() const -> std::string override;
     auto getColumnNames() -> std::vector<std::string> override;
-    auto assignId(const Database::ResultTuple &row) -> TYPE_OF_ITEM_ID override;
-    auto assignTable(const Database::ResultTuple &row) -> ArmorStruct override;
+    auto assignId(const TableRow &row) -> TYPE_OF_ITEM_ID override;
+    auto assignTable(const TableRow &row) -> ArmorStruct override;
 };
 
 #endif
@@ -24,10 +24,10 @@ auto ContainerObjectTable::getTableName() const -> std::string { return "contain
 
 auto ContainerObjectTable::getColumnNames() -> std::vector<std::string> { return {"con_itemid", "con_slots"}; }
 
-auto ContainerObjectTable::assignId(const Database::ResultTuple &row) -> TYPE_OF_ITEM_ID {
+auto ContainerObjectTable::assignId(const TableRow &row) -> TYPE_OF_ITEM_ID {
     return row["con_itemid"].as<TYPE_OF_ITEM_ID>();
 }
 
-auto ContainerObjectTable::assignTable(const Database::ResultTuple &row) -> TYPE_OF_CONTAINERSLOTS {
+auto ContainerObjectTable::assignTable(const TableRow &row) -> TYPE_OF_CONTAINERSLOTS {
     return row["con_slots"].as<TYPE_OF_CONTAINERSLOTS>();
 }
@@ -28,8 +28,8 @@ class ContainerObjectTable : public StructTable<TYPE_OF_ITEM_ID, TYPE_OF_CONTAIN
 public:
     auto getTableName() const -> std::string override;
     auto getColumnNames() -> std::vector<std::string> override;
-    auto assignId(const Database::ResultTuple &row) -> TYPE_OF_ITEM_ID override;
-    auto assignTable(const Database::ResultTuple &row) -> TYPE_OF_CONTAINERSLOTS override;
+    auto assignId(const TableRow &row) -> TYPE_OF_ITEM_ID override;
+    auto assignTable(const TableRow &row) -> TYPE_OF_CONTAINERSLOTS override;
 };
 
 #endif
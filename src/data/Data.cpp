@@ -22,8 +22,13 @@
 
 #include "Config.hpp"
 #include "Logger.hpp"
+#include "Parallel.hpp"
+#include "script/LuaChunkCache.hpp"
 #include "script/LuaLongTimeEffectScript.hpp"
 
+#include <algorithm>
+#include <vector>
+
 namespace Data {
 
 namespace {
@@ -80,28 +85,45 @@ auto getTables() -> std::vector<Table *> {
             &Tiles,           &Spells,      &Triggers,   &LongTimeEffects};
 }
 
-auto reloadTables() -> bool {
-    bool success = true;
+auto memoryUsage() -> size_t {
+    auto bytes = Skills.memoryUsage();
 
-    Logger::notice(LogFacility::Script) << "Loading data and scripts ..." << Log::end;
+    for (const auto *table : getTables()) {
+        bytes += table->memoryUsage();
+    }
 
-    for (auto &table : getTables()) {
-        success = table->reloadBuffer();
+    return bytes;
+}
 
-        if (!success) {
-            break;
-        }
-    }
+auto reloadTables() -> bool {
+    Logger::notice(LogFacility::Script) << "Loading data and scripts ..." << Log::end;
+
+    // the tables are independent, each loads on its own pooled connection
+    const auto tables = getTables();
+    std::vector<char> loaded(tables.size(), 0);
+    runInParallel(tables.size(), [&](size_t i) { loaded[i] = static_cast<char>(tables[i]->reloadBuffer()); });
 
-    return success;
+    return std::all_of(loaded.begin(), loaded.end(), [](char success) { return success != 0; });
 }
 
 void reloadScripts() {
+    auto &chunkCache = LuaChunkCache::get();
+    chunkCache.prefetch(Config::instance().scriptdir());
+
     for (auto &table : getTables()) {
         table->reloadScripts();
     }
+
+    chunkCache.dropPrefetched();
+}
+
+void reloadChangedScripts(const std::unordered_set<std::string> &modules) {
+    for (auto &table : getTables()) {
+        table->reloadChangedScripts(modules);
+    }
 }
 
+// each table switches to its new snapshot atomically, login threads need no lock for this
 void activateTables() {
     for (auto &table : getTables()) {
         table->activateBuffer();
@@ -56,8 +56,11 @@ auto triggers() -> TriggerTable &;
 auto longTimeEffects() -> LongTimeEffectTable &;
 
 auto getTables() -> std::vector<Table *>;
+// estimated heap bytes of all tables
+auto memoryUsage() -> size_t;
 auto reloadTables() -> bool;
 void reloadScripts();
+void reloadChangedScripts(const std::unordered_set<std::string> &modules);
 void activateTables();
 auto reload() -> bool;
 void preReload();
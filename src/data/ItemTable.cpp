@@ -43,11 +43,11 @@ auto ItemTable::getColumnNames() -> std::vector<std::string> {
             "itm_level"};
 }
 
-auto ItemTable::assignId(const Database::ResultTuple &row) -> TYPE_OF_ITEM_ID {
+auto ItemTable::assignId(const TableRow &row) -> TYPE_OF_ITEM_ID {
     return row["itm_id"].as<TYPE_OF_ITEM_ID>();
 }
 
-auto ItemTable::assignTable(const Database::ResultTuple &row) -> ItemStruct {
+auto ItemTable::assignTable(const TableRow &row) -> ItemStruct {
     ItemStruct item;
     item.id = assignId(row);
     item.Volume = row["itm_volume"].as<TYPE_OF_VOLUME>();
@@ -69,7 +69,7 @@ auto ItemTable::assignTable(const Database::ResultTuple &row) -> ItemStruct {
     return item;
 }
 
-auto ItemTable::assignScriptName(const Database::ResultTuple &row) -> std::string {
+auto ItemTable::assignScriptName(const TableRow &row) -> std::string {
     return row["itm_script"].as<std::string>("");
 }
 
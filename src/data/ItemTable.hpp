@@ -29,9 +29,9 @@ class ItemTable : public QuestScriptStructTable<TYPE_OF_ITEM_ID, ItemStruct, Lua
 public:
     auto getTableName() const -> std::string override;
     auto getColumnNames() -> std::vector<std::string> override;
-    auto assignId(const Database::ResultTuple &row) -> TYPE_OF_ITEM_ID override;
-    auto assignTable(const Database::ResultTuple &row) -> ItemStruct override;
-    auto assignScriptName(const Database::ResultTuple &row) -> std::string override;
+    auto assignId(const TableRow &row) -> TYPE_OF_ITEM_ID override;
+    auto assignTable(const TableRow &row) -> ItemStruct override;
+    auto assignScriptName(const TableRow &row) -> std::string override;
     auto getQuestScripts() -> NodeRange override;
 
 private:
@@ -26,17 +26,17 @@ auto LongTimeEffectTable::getColumnNames() -> std::vector<std::string> {
     return {"lte_effectid", "lte_effectname", "lte_scriptname"};
 }
 
-auto LongTimeEffectTable::assignId(const Database::ResultTuple &row) -> uint16_t {
+auto LongTimeEffectTable::assignId(const TableRow &row) -> uint16_t {
     return row["lte_effectid"].as<uint16_t>();
 }
 
-auto LongTimeEffectTable::assignTable(const Database::ResultTuple &row) -> LongTimeEffectStruct {
+auto LongTimeEffectTable::assignTable(const TableRow &row) -> LongTimeEffectStruct {
     LongTimeEffectStruct lte;
     lte.effectid = assignId(row);
     lte.effectname = row["lte_effectname"].as<std::string>();
     return lte;
 }
 
-auto LongTimeEffectTable::assignScriptName(const Database::ResultTuple &row) -> std::string {
+auto LongTimeEffectTable::assignScriptName(const TableRow &row) -> std::string {
     return row["lte_scriptname"].as<std::string>("");
 }
@@ -29,9 +29,9 @@ class LongTimeEffectTable : public ScriptStructTable<uint16_t, LongTimeEffectStr
 public:
     auto getTableName() const -> std::string override;
     auto getColumnNames() -> std::vector<std::string> override;
-    auto assignId(const Database::ResultTuple &row) -> uint16_t override;
-    auto assignTable(const Database::ResultTuple &row) -> LongTimeEffectStruct override;
-    auto assignScriptName(const Database::ResultTuple &row) -> std::string override;
+    auto assignId(const TableRow &row) -> uint16_t override;
+    auto assignTable(const TableRow &row) -> LongTimeEffectStruct override;
+    auto assignScriptName(const TableRow &row) -> std::string override;
 };
 
 #endif
@@ -26,11 +26,11 @@ auto MonsterAttackTable::getColumnNames() -> std::vector<std::string> {
     return {"mat_race_type", "mat_attack_type", "mat_attack_value", "mat_actionpointslost"};
 }
 
-auto MonsterAttackTable::assignId(const Database::ResultTuple &row) -> uint16_t {
+auto MonsterAttackTable::assignId(const TableRow &row) -> uint16_t {
     return uint16_t(row["mat_race_type"].as<int16_t>());
 }
 
-auto MonsterAttackTable::assignTable(const Database::ResultTuple &row) -> AttackBoni {
+auto MonsterAttackTable::assignTable(const TableRow &row) -> AttackBoni {
     AttackBoni attack;
     attack.attackType = uint8_t(row["mat_attack_type"].as<int16_t>());
     attack.attackValue = row["mat_attack_value"].as<int16_t>();
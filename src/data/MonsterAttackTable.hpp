@@ -33,8 +33,8 @@ class MonsterAttackTable : public StructTable<uint16_t, AttackBoni> {
 public:
     auto getTableName() const -> std::string override;
     auto getColumnNames() -> std::vector<std::string> override;
-    auto assignId(const Database::ResultTuple &row) -> uint16_t override;
-    auto assignTable(const Database::ResultTuple &row) -> AttackBoni override;
+    auto assignId(const TableRow &row) -> uint16_t override;
+    auto assignTable(const TableRow &row) -> AttackBoni override;
 };
 
 #endif
@@ -35,7 +35,7 @@ MonsterTable::MonsterTable() {
 
     try {
         using namespace Database;
-        PConnection connection = ConnectionManager::getInstance().getConnection();
+        PConnection connection = ConnectionManager::getInstance().getConnection(ConnectionManager::Route::replica);
         connection->beginTransaction();
 
         SelectQuery monquery(connection);
@@ -308,6 +308,33 @@ MonsterTable::MonsterTable() {
     }
 }
 
+void MonsterTable::reloadChangedScripts(const std::unordered_set<std::string> &modules) {
+    const auto questNodes = QuestNodeTable::getInstance().getMonsterNodes();
+
+    for (auto &[id, monster] : table) {
+        if (!monster.script || modules.count(monster.script->getFileName()) == 0) {
+            continue;
+        }
+
+        const auto scriptname = monster.script->getFileName();
+
+        try {
+            auto script = std::make_shared<LuaMonsterScript>(scriptname);
+
+            for (auto it = questNodes.first; it != questNodes.second; ++it) {
+                if (it->first == id) {
+                    script->addQuestScript(it->second.entrypoint, it->second.script);
+                }
+            }
+
+            monster.script = script;
+        } catch (ScriptException &e) {
+            Logger::error(LogFacility::Script)
+                    << "Error while reloading monster script: " << scriptname << ": " << e.what() << Log::end;
+        }
+    }
+}
+
 auto MonsterTable::exists(TYPE_OF_CHARACTER_ID id) const -> bool { return table.count(id) > 0; }
 
 auto MonsterTable::operator[](TYPE_OF_CHARACTER_ID id) -> const MonsterStruct & {
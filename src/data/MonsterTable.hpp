@@ -25,18 +25,25 @@
 
 #include <TableStructs.hpp>
 #include <boost/unordered_map.hpp>
+#include <string>
+#include <unordered_set>
 
 class MonsterTable {
 public:
+    using TABLE = boost::unordered_map<TYPE_OF_CHARACTER_ID, MonsterStruct>;
+
     MonsterTable();
+    // holds the given descriptions instead of loading them from the database
+    explicit MonsterTable(TABLE descriptions) : table(std::move(descriptions)), dataOK(!table.empty()) {}
 
     [[nodiscard]] inline auto isDataOK() const -> bool { return dataOK; }
 
     [[nodiscard]] auto exists(TYPE_OF_CHARACTER_ID id) const -> bool;
     auto operator[](TYPE_OF_CHARACTER_ID id) -> const MonsterStruct &;
+    // replaces only the scripts loaded from the given modules, scripts failing to load stay as they were
+    void reloadChangedScripts(const std::unordered_set<std::string> &modules);
 
 private:
-    using TABLE = boost::unordered_map<TYPE_OF_CHARACTER_ID, MonsterStruct>;
     TABLE table;
     bool dataOK = false;
 };
@@ -26,6 +26,7 @@
 
 #include "Logger.hpp"
 #include "data/QuestNodeTable.hpp"
+#include "db/ConnectionManager.hpp"
 #include "db/Result.hpp"
 #include "db/SelectQuery.hpp"
 #include "script/LuaNPCScript.hpp"
@@ -37,7 +38,8 @@ NPCTable::NPCTable() : _world(World::get()) { reload(); }
 
 void NPCTable::reload() {
     try {
-        Database::SelectQuery query;
+        Database::SelectQuery query(
+                Database::ConnectionManager::getInstance().getConnection(Database::ConnectionManager::Route::replica));
         query.addColumn("npc", "npc_id");
         query.addColumn("npc", "npc_type");
         query.addColumn("npc", "npc_posx");
@@ -28,11 +28,11 @@ auto NaturalArmorTable::getColumnNames() -> std::vector<std::string> {
     return {"nar_race", "nar_strokearmor", "nar_puncturearmor", "nar_thrustarmor"};
 }
 
-auto NaturalArmorTable::assignId(const Database::ResultTuple &row) -> uint16_t {
+auto NaturalArmorTable::assignId(const TableRow &row) -> uint16_t {
     return uint16_t(row["nar_race"].as<int32_t>());
 }
 
-auto NaturalArmorTable::assignTable(const Database::ResultTuple &row) -> MonsterArmor {
+auto NaturalArmorTable::assignTable(const TableRow &row) -> MonsterArmor {
     MonsterArmor armor;
     armor.strokeArmor = TYPE_OF_STROKEARMOR(row["nar_strokearmor"].as<int16_t>());
     armor.punctureArmor = TYPE_OF_PUNCTUREARMOR(row["nar_puncturearmor"].as<int16_t>());
@@ -28,8 +28,8 @@ class NaturalArmorTable : public StructTable<uint16_t, MonsterArmor> {
 public:
     auto getTableName() const -> std::string override;
     auto getColumnNames() -> std::vector<std::string> override;
-    auto assignId(const Database::ResultTuple &row) -> uint16_t override;
-    auto assignTable(const Database::ResultTuple &row) -> MonsterArmor override;
+    auto assignId(const TableRow &row) -> uint16_t override;
+    auto assignTable(const TableRow &row) -> MonsterArmor override;
 };
 
 #endif
@@ -22,6 +22,7 @@
 
 #include "Config.hpp"
 #include "Logger.hpp"
+#include "Parallel.hpp"
 #include "globals.hpp"
 #include "script/LuaScript.hpp"
 
@@ -30,6 +31,8 @@
 #include <fstream>
 #include <memory>
 #include <string>
+#include <system_error>
+#include <utility>
 #include <vector>
 
 std::unique_ptr<QuestNodeTable> QuestNodeTable::instance = nullptr;
@@ -64,27 +67,64 @@ void QuestNodeTable::reload() {
     path filename = path("quest.txt");
 
     directory_iterator end_itr;
-
-    clear();
+    std::vector<path> questPaths;
 
     for (directory_iterator itr(dirPath); itr != end_itr; ++itr) {
-        if (is_directory(itr->status())) {
-            path filePath(itr->path() / filename);
+        if (is_directory(itr->status()) && exists(itr->path() / filename)) {
+            questPaths.push_back(itr->path());
+        }
+    }
+
+    std::unordered_map<std::string, ParsedQuest> quests;
+    std::vector<std::pair<path, ParsedQuest *>> changed;
 
-            if (exists(filePath)) {
-                std::ifstream questFile(filePath);
+    for (const auto &questPath : questPaths) {
+        std::error_code error;
+        const auto filePath = questPath / filename;
+        const auto modified = last_write_time(filePath, error);
+        const auto size = file_size(filePath, error);
+        auto &quest = quests[questPath.string()];
+
+        if (const auto cached = parsedQuests.find(questPath.string());
+            !error && cached != parsedQuests.end() && cached->second.modified == modified &&
+            cached->second.size == size) {
+            quest = std::move(cached->second);
+            continue;
+        }
+
+        quest.modified = error ? file_time_type::min() : modified;
+        quest.size = size;
+        changed.emplace_back(questPath, &quest);
+    }
+
+    // reading and splitting the files needs no Lua, only loading the scripts below has to stay on this thread
+    constexpr size_t minQuestsPerWorker = 16;
+    runInParallel(
+            changed.size(),
+            [&changed, &filename](size_t i) {
+                const auto &[questPath, quest] = changed[i];
+                std::ifstream questFile(questPath / filename);
 
                 if (questFile.is_open()) {
-                    path questPath(itr->path());
-                    readQuest(questFile, questPath);
-                    questFile.close();
+                    readQuest(questFile, questPath, *quest);
                 }
-            }
-        }
+            },
+            minQuestsPerWorker);
+
+    clear();
+    // nodes of one script share its instance, loading it again would only replace it in the Lua state
+    std::unordered_map<std::string, std::shared_ptr<LuaScript>> scripts;
+
+    for (const auto &questPath : questPaths) {
+        addNodes(quests[questPath.string()], scripts);
     }
+
+    parsedQuests = std::move(quests);
+    Logger::info(LogFacility::Script) << "Loaded " << questPaths.size() << " quests, parsed " << changed.size()
+                                      << " of them" << Log::end;
 }
 
-void QuestNodeTable::readQuest(std::ifstream &questFile, std::filesystem::path &questPath) {
+void QuestNodeTable::readQuest(std::ifstream &questFile, const std::filesystem::path &questPath, ParsedQuest &quest) {
     std::string line;
 
     while (std::getline(questFile, line)) {
@@ -98,85 +138,86 @@ void QuestNodeTable::readQuest(std::ifstream &questFile, std::filesystem::path &
 
         if ((type != "triggerfield" && entries.size() != normalEntryCount) ||
             (type == "triggerfield" && entries.size() != triggerfieldEntryCount)) {
-            Logger::error(LogFacility::Script)
-                    << "Syntax error while loading quest file: " << questPath.string() << "/quest.txt" << Log::end;
+            quest.error = "Syntax error while loading quest file: " + questPath.string() + "/quest.txt";
             return;
         }
 
+        QuestEntry entry;
+        entry.type = type;
+
         if (type == "triggerfield") {
-            position pos{};
             const auto &x = entries[triggerCoordinateXPosition];
 
-            if (!stringToNumber(x, pos.x)) {
-                Logger::error(LogFacility::Script)
-                        << "Conversion error while loading quest file: " << x << " is not a map coordinate" << Log::end;
+            if (!stringToNumber(x, entry.pos.x)) {
+                quest.error = "Conversion error while loading quest file: " + x + " is not a map coordinate";
                 return;
             }
 
             const auto &y = entries[triggerCoordinateYPosition];
 
-            if (!stringToNumber(y, pos.y)) {
-                Logger::error(LogFacility::Script)
-                        << "Conversion error while loading quest file: " << y << " is not a map coordinate" << Log::end;
+            if (!stringToNumber(y, entry.pos.y)) {
+                quest.error = "Conversion error while loading quest file: " + y + " is not a map coordinate";
                 return;
             }
 
             const auto &z = entries[triggerCoordinateZPosition];
 
-            if (!stringToNumber(z, pos.z)) {
-                Logger::error(LogFacility::Script)
-                        << "Conversion error while loading quest file: " << z << " is not a map coordinate" << Log::end;
+            if (!stringToNumber(z, entry.pos.z)) {
+                quest.error = "Conversion error while loading quest file: " + z + " is not a map coordinate";
                 return;
             }
 
-            const auto &functionName = entries[triggerFunctionPosition];
-            const auto &scriptName = entries[triggerScriptPosition];
-            NodeStruct node;
-            node.entrypoint = functionName;
-            std::string scriptPath = "questsystem." + questPath.filename().string() + "." + scriptName;
-
-            try {
-                node.script = std::make_shared<LuaScript>(scriptPath);
-            } catch (ScriptException &e) {
-                Logger::error(LogFacility::Script) << "Error while loading quest script: " << e.what() << Log::end;
-                return;
-            }
-
-            triggerNodes.emplace(pos, node);
-
+            entry.entrypoint = entries[triggerFunctionPosition];
+            entry.scriptPath = "questsystem." + questPath.filename().string() + "." + entries[triggerScriptPosition];
         } else {
-            unsigned int id = 0;
-
             const auto &idString = entries[idPosition];
 
-            if (!stringToNumber(idString, id)) {
-                Logger::error(LogFacility::Script)
-                        << "Conversion error while loading quest file: " << idString << " is not an ID" << Log::end;
+            if (!stringToNumber(idString, entry.id)) {
+                quest.error = "Conversion error while loading quest file: " + idString + " is not an ID";
                 return;
             }
 
-            const auto &functionName = entries[functionPosition];
-            const auto &scriptName = entries[scriptPosition];
-            NodeStruct node;
-            node.entrypoint = functionName;
-            std::string scriptPath = "questsystem." + questPath.filename().string() + "." + scriptName;
+            entry.entrypoint = entries[functionPosition];
+            entry.scriptPath = "questsystem." + questPath.filename().string() + "." + entries[scriptPosition];
+        }
+
+        quest.entries.push_back(std::move(entry));
+    }
+}
 
+void QuestNodeTable::addNodes(const ParsedQuest &quest,
+                              std::unordered_map<std::string, std::shared_ptr<LuaScript>> &scripts) {
+    for (const auto &entry : quest.entries) {
+        NodeStruct node;
+        node.entrypoint = entry.entrypoint;
+        auto &script = scripts[entry.scriptPath];
+
+        if (!script) {
             try {
-                node.script = std::make_shared<LuaScript>(scriptPath);
+                script = std::make_shared<LuaScript>(entry.scriptPath);
             } catch (ScriptException &e) {
+                scripts.erase(entry.scriptPath);
                 Logger::error(LogFacility::Script) << "Error while loading quest script: " << e.what() << Log::end;
                 return;
             }
+        }
 
-            if (type == "item") {
-                itemNodes.insert(std::pair<unsigned int, NodeStruct>(id, node));
-            } else if (type == "npc") {
-                npcNodes.insert(std::pair<unsigned int, NodeStruct>(id, node));
-            } else if (type == "monster") {
-                monsterNodes.insert(std::pair<unsigned int, NodeStruct>(id, node));
-            }
+        node.script = script;
+
+        if (entry.type == "triggerfield") {
+            triggerNodes.emplace(entry.pos, node);
+        } else if (entry.type == "item") {
+            itemNodes.emplace(entry.id, node);
+        } else if (entry.type == "npc") {
+            npcNodes.emplace(entry.id, node);
+        } else if (entry.type == "monster") {
+            monsterNodes.emplace(entry.id, node);
         }
     }
+
+    if (!quest.error.empty()) {
+        Logger::error(LogFacility::Script) << quest.error << Log::end;
+    }
 }
 
 void QuestNodeTable::clear() {
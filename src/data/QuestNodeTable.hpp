@@ -29,6 +29,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 class LuaScript;
 
@@ -42,7 +43,26 @@ private:
     template <typename Key> using Table = std::unordered_multimap<Key, NodeStruct>;
     template <typename Key> using TableIterator = typename Table<Key>::const_iterator;
 
+    // a line of a quest file, its script not yet loaded
+    struct QuestEntry {
+        std::string type;
+        unsigned int id = 0;
+        position pos{};
+        std::string entrypoint;
+        std::string scriptPath;
+    };
+
+    // parsing stops at the first bad line, entries before it are kept like before
+    struct ParsedQuest {
+        std::filesystem::file_time_type modified{};
+        uintmax_t size = 0;
+        std::vector<QuestEntry> entries;
+        std::string error;
+    };
+
     static std::unique_ptr<QuestNodeTable> instance;
+    // by quest directory, a quest file with the same time and size is not parsed again on reload
+    std::unordered_map<std::string, ParsedQuest> parsedQuests;
     Table<TYPE_OF_ITEM_ID> itemNodes;
     Table<unsigned int> npcNodes;
     Table<unsigned int> monsterNodes;
@@ -79,7 +99,8 @@ public:
     auto getTriggerNodes() const -> TableRange<position>;
 
 private:
-    void readQuest(std::ifstream &questFile, std::filesystem::path &questPath);
+    static void readQuest(std::ifstream &questFile, const std::filesystem::path &questPath, ParsedQuest &quest);
+    void addNodes(const ParsedQuest &quest, std::unordered_map<std::string, std::shared_ptr<LuaScript>> &scripts);
     void clear();
 };
 
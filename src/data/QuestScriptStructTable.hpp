@@ -32,10 +32,37 @@ public:
 
     void reloadScripts() override {
         Base::reloadScripts();
+        addQuestScripts([](const IdType & /*id*/) { return true; });
+    }
+
+    void reloadChangedScripts(const std::unordered_set<std::string> &modules) override {
+        const auto replaced = this->replaceScripts(modules);
+        // new scripts lack the quest scripts the old ones carried
+        addQuestScripts([&replaced](const IdType &id) { return replaced.count(id) > 0; });
+    }
+
+protected:
+    using NodeRange = QuestNodeTable::TableRange<IdType>;
+
+    using Base::assignId;
+    using Base::assignScriptName;
+    using Base::assignTable;
+    using Base::getColumnNames;
+    using Base::getTableName;
+
+    virtual auto getQuestScripts() -> NodeRange = 0;
+
+private:
+    template <typename Filter> void addQuestScripts(const Filter &filter) {
         auto questNodes = getQuestScripts();
 
         for (auto it = questNodes.first; it != questNodes.second; ++it) {
             const auto &id = it->first;
+
+            if (!filter(id)) {
+                continue;
+            }
+
             const auto &questNode = it->second;
             auto &scriptStack = this->scriptNonConst(id);
 
@@ -52,17 +79,6 @@ public:
             }
         }
     }
-
-protected:
-    using NodeRange = QuestNodeTable::TableRange<IdType>;
-
-    using Base::assignId;
-    using Base::assignScriptName;
-    using Base::assignTable;
-    using Base::getColumnNames;
-    using Base::getTableName;
-
-    virtual auto getQuestScripts() -> NodeRange = 0;
 };
 
 #endif
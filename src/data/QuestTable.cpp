@@ -28,19 +28,27 @@ auto QuestTable::getTableName() const -> std::string { return "quests"; }
 
 auto QuestTable::getColumnNames() -> std::vector<std::string> { return {"qst_id", "qst_script"}; }
 
-auto QuestTable::assignId(const Database::ResultTuple &row) -> TYPE_OF_QUEST_ID {
+auto QuestTable::assignId(const TableRow &row) -> TYPE_OF_QUEST_ID {
     return row["qst_id"].as<TYPE_OF_QUEST_ID>();
 }
 
-auto QuestTable::assignTable(const Database::ResultTuple &row) -> QuestStruct { return QuestStruct(); }
+auto QuestTable::assignTable(const TableRow &row) -> QuestStruct { return QuestStruct(); }
 
-auto QuestTable::assignScriptName(const Database::ResultTuple &row) -> std::string {
+auto QuestTable::assignScriptName(const TableRow &row) -> std::string {
     return row["qst_script"].as<std::string>("");
 }
 
 void QuestTable::reloadScripts() {
     Base::reloadScripts();
+    indexQuestStarts();
+}
+
+void QuestTable::reloadChangedScripts(const std::unordered_set<std::string> &modules) {
+    Base::reloadChangedScripts(modules);
+    indexQuestStarts();
+}
 
+void QuestTable::indexQuestStarts() {
     questStarts.clear();
 
     for (const auto &quest : *this) {
@@ -37,15 +37,18 @@ private:
 public:
     auto getTableName() const -> std::string override;
     auto getColumnNames() -> std::vector<std::string> override;
-    auto assignId(const Database::ResultTuple &row) -> TYPE_OF_QUEST_ID override;
-    auto assignTable(const Database::ResultTuple &row) -> QuestStruct override;
-    auto assignScriptName(const Database::ResultTuple &row) -> std::string override;
+    auto assignId(const TableRow &row) -> TYPE_OF_QUEST_ID override;
+    auto assignTable(const TableRow &row) -> QuestStruct override;
+    auto assignScriptName(const TableRow &row) -> std::string override;
     void reloadScripts() override;
+    void reloadChangedScripts(const std::unordered_set<std::string> &modules) override;
 
     using QuestStartMap = std::map<TYPE_OF_QUEST_ID, position>;
     auto getQuestsInRange(const position &pos, Coordinate radius) const -> QuestStartMap;
 
 private:
+    void indexQuestStarts();
+
     quest_starts_type questStarts;
 };
 
@@ -46,11 +46,11 @@ auto RaceTable::getColumnNames() -> std::vector<std::string> {
             "race_attribute_points_max"};
 }
 
-auto RaceTable::assignId(const Database::ResultTuple &row) -> TYPE_OF_ITEM_ID {
+auto RaceTable::assignId(const TableRow &row) -> TYPE_OF_ITEM_ID {
     return uint16_t(row["race_id"].as<int32_t>());
 }
 
-auto RaceTable::assignTable(const Database::ResultTuple &row) -> RaceStruct {
+auto RaceTable::assignTable(const TableRow &row) -> RaceStruct {
     RaceStruct race;
     race.serverName = row["race_name"].as<std::string>("unknown");
     race.minSize = uint16_t(row["race_height_min"].as<int32_t>(RaceStruct::defaultMinHeight));
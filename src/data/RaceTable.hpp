@@ -29,8 +29,8 @@ class RaceTable : public StructTable<uint16_t, RaceStruct> {
 public:
     auto getTableName() const -> std::string override;
     auto getColumnNames() -> std::vector<std::string> override;
-    auto assignId(const Database::ResultTuple &row) -> uint16_t override;
-    auto assignTable(const Database::ResultTuple &row) -> RaceStruct override;
+    auto assignId(const TableRow &row) -> uint16_t override;
+    auto assignTable(const TableRow &row) -> RaceStruct override;
     auto getRelativeSize(TYPE_OF_RACE_ID race, uint16_t size) const -> uint8_t;
     auto isBaseAttributeInLimits(TYPE_OF_RACE_ID race, Character::attributeIndex attribute,
                                  Attribute::attribute_t value) const -> bool;
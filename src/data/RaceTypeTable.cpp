@@ -34,7 +34,7 @@ RaceTypeTable::RaceTypeTable() {
 
     try {
         using namespace Database;
-        PConnection connection = ConnectionManager::getInstance().getConnection();
+        PConnection connection = ConnectionManager::getInstance().getConnection(ConnectionManager::Route::replica);
         connection->beginTransaction();
 
         {
@@ -22,58 +22,93 @@
 
 #include "Logger.hpp"
 #include "Random.hpp"
+#include "db/ConnectionManager.hpp"
 #include "db/Result.hpp"
 #include "db/SelectQuery.hpp"
 
+#include <algorithm>
 #include <iostream>
 
+namespace {
+constexpr auto laterDue = [](const auto &lhs, const auto &rhs) { return lhs.cycle > rhs.cycle; };
+}
+
 ScheduledScriptsTable::ScheduledScriptsTable() { reload(); }
 
 void ScheduledScriptsTable::nextCycle() {
     currentCycle++;
-    ScriptData data; /**< holds the current task*/
-    constexpr auto scriptLimit = 200;
-    int emexit = 0; /**< emergency counter which breaks the loop if too much execution*/
+    int executed = 0;
+
+    while (!m_due.empty() && m_due.front().cycle <= currentCycle) {
+        if (executed++ == scriptLimit) {
+            // the remaining due scripts stay in the heap and run first next cycle
+            const bool wasOverBudget = carriedOver > 0;
+            carriedOver = std::count_if(m_due.begin(), m_due.end(),
+                                        [this](const auto &due) { return due.cycle <= currentCycle; });
+
+            if (!wasOverBudget) {
+                Logger::warn(LogFacility::Script) << "Scheduled scripts over budget, " << carriedOver
+                                                  << " carried over to the next cycle" << Log::end;
+            }
 
-    while (!m_table.empty() && (emexit++ < scriptLimit) && (m_table.front().nextCycleTime <= currentCycle)) {
-        data = m_table.front(); /**< copy the first data in data*/
-        m_table.pop_front();    /**< deletes the first task */
+            return;
+        }
 
-        if (data.scriptptr) {
-            /**calculate the next time when the script is invoked */
-            data.nextCycleTime += Random::uniform(data.minCycleTime, data.maxCycleTime);
+        std::pop_heap(m_due.begin(), m_due.end(), laterDue);
+        auto &due = m_due.back();
+        auto &data = m_scripts[due.script];
 
-            /**call the script function */
-            data.scriptptr->callFunction(data.functionName, currentCycle, data.lastCycleTime, data.nextCycleTime);
+        if (!data.scriptptr) {
+            m_due.pop_back();
+            continue;
+        }
 
-            data.lastCycleTime = currentCycle; /**< script was run so we can change lastCycleTime*/
+        /**calculate the next time when the script is invoked */
+        data.nextCycleTime += Random::uniform(data.minCycleTime, data.maxCycleTime);
 
-            addData(data); /**< insert the script in the list again*/
-        }
+        const auto start = std::chrono::steady_clock::now();
+        data.scriptptr->callFunction(data.functionName, currentCycle, data.lastCycleTime, data.nextCycleTime);
+        const auto runtime = std::chrono::steady_clock::now() - start;
+
+        ++data.calls;
+        data.totalTime += runtime;
+        data.maxTime = std::max<std::chrono::nanoseconds>(data.maxTime, runtime);
+        data.lastCycleTime = currentCycle; /**< script was run so we can change lastCycleTime*/
+
+        due.cycle = data.nextCycleTime;
+        std::push_heap(m_due.begin(), m_due.end(), laterDue);
     }
+
+    carriedOver = 0;
 }
 
-void ScheduledScriptsTable::addData(const ScriptData &data) {
+void ScheduledScriptsTable::addData(ScriptData data) {
     Logger::debug(LogFacility::Script) << "insert new Task task.nextCycle: " << data.nextCycleTime
                                        << " current Cycle: " << currentCycle << Log::end;
-    bool inserted = false;
+    m_due.push_back({data.nextCycleTime, m_scripts.size()});
+    std::push_heap(m_due.begin(), m_due.end(), laterDue);
+    m_scripts.push_back(std::move(data));
+}
 
-    for (auto it = m_table.begin(); it != m_table.end(); ++it) {
-        if (it->nextCycleTime > data.nextCycleTime) {
-            m_table.insert(it, data);
-            inserted = true;
-            break;
+void ScheduledScriptsTable::reloadChangedScripts(const std::unordered_set<std::string> &modules) {
+    for (auto &data : m_scripts) {
+        if (modules.count(data.scriptName) == 0) {
+            continue;
         }
-    }
 
-    if (!inserted) {
-        m_table.push_back(data);
+        try {
+            data.scriptptr = std::make_shared<LuaScheduledScript>(data.scriptName);
+        } catch (const ScriptException &e) {
+            Logger::error(LogFacility::Script)
+                    << "Error while reloading scheduled script: " << data.scriptName << ": " << e.what() << Log::end;
+        }
     }
 }
 
 void ScheduledScriptsTable::reload() {
     try {
-        Database::SelectQuery query;
+        Database::SelectQuery query(
+                Database::ConnectionManager::getInstance().getConnection(Database::ConnectionManager::Route::replica));
         query.addColumn("scheduledscripts", "sc_scriptname");
         query.addColumn("scheduledscripts", "sc_mincycletime");
         query.addColumn("scheduledscripts", "sc_maxcycletime");
@@ -116,4 +151,7 @@ void ScheduledScriptsTable::reload() {
     }
 }
 
-void ScheduledScriptsTable::clearOldTable() { m_table.clear(); }
+void ScheduledScriptsTable::clearOldTable() {
+    m_scripts.clear();
+    m_due.clear();
+}
@@ -23,12 +23,12 @@
 
 #include "script/LuaScheduledScript.hpp"
 
-#include <boost/unordered_map.hpp>
-#include <list>
-#include <map>
+#include <chrono>
 #include <memory>
 #include <string>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 class World;
 
@@ -41,6 +41,11 @@ struct ScriptData {
     std::string scriptName;
     std::shared_ptr<LuaScheduledScript> scriptptr;
 
+    // time spent in the script function so far
+    uint32_t calls = 0;
+    std::chrono::nanoseconds totalTime{0};
+    std::chrono::nanoseconds maxTime{0};
+
     ScriptData() = default;
     ScriptData(uint32_t minCT, uint32_t maxCT, uint32_t nextCT, uint32_t lastCT, std::string fname, std::string sname)
             : minCycleTime(minCT), maxCycleTime(maxCT), nextCycleTime(nextCT), lastCycleTime(lastCT),
@@ -55,13 +60,30 @@ public:
 
     void nextCycle();
 
-    void addData(const ScriptData &data);
+    void addData(ScriptData data);
+    // replaces only the scripts loaded from the given modules, scripts failing to load stay as they were
+    void reloadChangedScripts(const std::unordered_set<std::string> &modules);
+
+    [[nodiscard]] auto getScripts() const -> const std::vector<ScriptData> & { return m_scripts; }
+    // due scripts the last cycle left to the next one because it reached scriptLimit
+    [[nodiscard]] auto getCarriedOver() const -> size_t { return carriedOver; }
 
 private:
+    static constexpr int scriptLimit = 200;
+
+    struct DueScript {
+        uint32_t cycle;
+        size_t script;
+    };
+
     void reload();
 
-    std::list<ScriptData> m_table;
+    // scripts keep their place, only the due heap is reordered
+    std::vector<ScriptData> m_scripts;
+    // min-heap on the cycle a script is due
+    std::vector<DueScript> m_due;
     uint32_t currentCycle{0};
+    size_t carriedOver{0};
     bool m_dataOk{false};
 
     void clearOldTable();
@@ -27,6 +27,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace detail {
@@ -34,13 +35,13 @@ namespace detail {
 template <typename IdType, typename StructType, typename ScriptType>
 void detailAssign(std::unordered_map<IdType, std::shared_ptr<ScriptType>> &scripts, const IdType &id,
                   const std::string &name, const StructType &data, const StructType &dummy) {
-    scripts.emplace(id, std::make_shared<ScriptType>(name, data));
+    scripts.insert_or_assign(id, std::make_shared<ScriptType>(name, data));
 }
 
 template <typename IdType, typename StructType, typename ScriptType>
 void detailAssign(std::unordered_map<IdType, std::shared_ptr<ScriptType>> &scripts, const IdType &id,
                   const std::string &name, const StructType &data, const IdType &dummy) {
-    scripts.emplace(id, std::make_shared<ScriptType>(name, id));
+    scripts.insert_or_assign(id, std::make_shared<ScriptType>(name, id));
 }
 
 } // namespace detail
@@ -69,6 +70,8 @@ public:
         scriptNames.clear();
     }
 
+    void reloadChangedScripts(const std::unordered_set<std::string> &modules) override { replaceScripts(modules); }
+
     auto script(IdType id) const -> std::shared_ptr<ScriptType> {
         auto it = scripts.find(id);
 
@@ -83,9 +86,9 @@ protected:
     using Base::assignTable;
     using Base::getColumnNames;
     using Base::getTableName;
-    virtual auto assignScriptName(const Database::ResultTuple &row) -> std::string = 0;
+    virtual auto assignScriptName(const TableRow &row) -> std::string = 0;
 
-    void evaluateRow(const Database::ResultTuple &row) override {
+    void evaluateRow(const TableRow &row) override {
         Base::evaluateRow(row);
         std::string scriptName = assignScriptName(row);
 
@@ -96,6 +99,32 @@ protected:
 
     auto scriptNonConst(IdType id) -> std::shared_ptr<ScriptType> & { return scripts[id]; }
 
+    // returns the ids which got a new script
+    auto replaceScripts(const std::unordered_set<std::string> &modules) -> std::unordered_set<IdType> {
+        std::vector<std::pair<IdType, std::string>> changed;
+
+        for (const auto &[id, script] : scripts) {
+            if (script && modules.count(script->getFileName()) > 0) {
+                changed.emplace_back(id, script->getFileName());
+            }
+        }
+
+        std::unordered_set<IdType> replaced;
+
+        for (const auto &[id, scriptName] : changed) {
+            try {
+                const auto &data = (*this)[id];
+                internalAssign<ScriptParameter>(id, scriptName, data);
+                replaced.insert(id);
+            } catch (ScriptException &e) {
+                Logger::error(LogFacility::Script) << "Error while reloading " << getTableName()
+                                                   << " script: " << scriptName << ": " << e.what() << Log::end;
+            }
+        }
+
+        return replaced;
+    }
+
 private:
     using ScriptsType = std::unordered_map<IdType, std::shared_ptr<ScriptType>>;
 
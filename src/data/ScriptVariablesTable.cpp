@@ -25,21 +25,31 @@
 #include "db/DeleteQuery.hpp"
 #include "db/InsertQuery.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 
 auto ScriptVariablesTable::getTableName() const -> std::string { return "scriptvariables"; }
 
 auto ScriptVariablesTable::getColumnNames() -> std::vector<std::string> { return {"svt_ids", "svt_string"}; }
 
-auto ScriptVariablesTable::assignId(const Database::ResultTuple &row) -> std::string {
+auto ScriptVariablesTable::assignId(const TableRow &row) -> std::string {
     return row["svt_ids"].as<std::string>();
 }
 
-auto ScriptVariablesTable::assignTable(const Database::ResultTuple &row) -> std::string {
+auto ScriptVariablesTable::assignTable(const TableRow &row) -> std::string {
     return row["svt_string"].as<std::string>();
 }
 
 auto ScriptVariablesTable::find(const std::string &id, std::string &ret) -> bool {
+    if (const auto number = numbers.find(id); number != numbers.end()) {
+        ret = std::to_string(number->second);
+        return true;
+    }
+
     if (exists(id)) {
         ret = this->operator[](id);
         return true;
@@ -49,43 +59,202 @@ auto ScriptVariablesTable::find(const std::string &id, std::string &ret) -> bool
     return false;
 }
 
-void ScriptVariablesTable::set(const std::string &id, const std::string &value) { get(id) = value; }
+auto ScriptVariablesTable::findNumber(const std::string &id, int32_t &ret) -> bool {
+    ret = 0;
+
+    if (const auto number = numbers.find(id); number != numbers.end()) {
+        ret = number->second;
+        return true;
+    }
+
+    if (!exists(id)) {
+        return false;
+    }
+
+    // parsed once, later reads and increments use the number
+    const auto &text = this->operator[](id);
+    int32_t value = 0;
+    const auto *end = text.data() + text.size();
+
+    if (const auto [last, error] = std::from_chars(text.data(), end, value); error != std::errc() || last != end) {
+        return false;
+    }
+
+    numbers.emplace(id, value);
+    ret = value;
+    return true;
+}
+
+void ScriptVariablesTable::set(const std::string &id, const std::string &value) {
+    numbers.erase(id);
+    get(id) = value;
+    dirty.insert(id);
+}
 
 void ScriptVariablesTable::set(const std::string &id, int32_t value) {
-    std::stringstream ss;
-    ss << value;
-    set(id, ss.str());
+    numbers[id] = value;
+    dirty.insert(id);
+}
+
+auto ScriptVariablesTable::increment(const std::string &id, int32_t amount) -> int32_t {
+    int32_t value = 0;
+    findNumber(id, value);
+    const auto sum = std::clamp<int64_t>(int64_t{value} + amount, std::numeric_limits<int32_t>::min(),
+                                         std::numeric_limits<int32_t>::max());
+    set(id, static_cast<int32_t>(sum));
+    return static_cast<int32_t>(sum);
 }
 
-auto ScriptVariablesTable::remove(const std::string &id) -> bool { return erase(id); }
+auto ScriptVariablesTable::remove(const std::string &id) -> bool {
+    const bool wasNumber = numbers.erase(id) > 0;
+
+    if (erase(id) || wasNumber) {
+        dirty.insert(id);
+        return true;
+    }
+
+    return false;
+}
+
+void ScriptVariablesTable::flush() {
+    if (writing.valid()) {
+        if (writing.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
+        }
+
+        collectWrite();
+    }
+
+    if (dirty.empty()) {
+        return;
+    }
+
+    writingKeys.assign(dirty.begin(), dirty.end());
+    writing = std::async(std::launch::async, [changes = takeChanges()] { return write(changes); });
+}
 
 void ScriptVariablesTable::save() {
+    collectWrite();
+
+    if (dirty.empty()) {
+        return;
+    }
+
+    const std::vector<std::string> keys(dirty.begin(), dirty.end());
+
+    if (!write(takeChanges())) {
+        dirty.insert(keys.begin(), keys.end());
+    }
+}
+
+auto ScriptVariablesTable::copyText() const -> std::string {
+    const auto escape = [](std::string &text, const std::string &value) {
+        for (const char c : value) {
+            switch (c) {
+            case '\\':
+                text += "\\\\";
+                break;
+
+            case '\t':
+                text += "\\t";
+                break;
+
+            case '\n':
+                text += "\\n";
+                break;
+
+            case '\r':
+                text += "\\r";
+                break;
+
+            default:
+                text += c;
+            }
+        }
+    };
+
+    std::string text;
+
+    for (const auto &[id, value] : *this) {
+        if (!value.empty() && numbers.count(id) == 0) {
+            escape(text, id);
+            text += '\t';
+            escape(text, value);
+            text += '\n';
+        }
+    }
+
+    for (const auto &[id, number] : numbers) {
+        escape(text, id);
+        text += '\t';
+        text += std::to_string(number);
+        text += '\n';
+    }
+
+    return text;
+}
+
+auto ScriptVariablesTable::takeChanges() -> Changes {
+    Changes changes;
+
+    for (const auto &id : dirty) {
+        std::string value;
+
+        if (find(id, value) && !value.empty()) {
+            changes.upserts.emplace_back(id, std::move(value));
+        } else {
+            changes.deletes.push_back(id);
+        }
+    }
+
+    dirty.clear();
+    return changes;
+}
+
+void ScriptVariablesTable::collectWrite() {
+    if (!writing.valid()) {
+        return;
+    }
+
+    if (!writing.get()) {
+        // values changed meanwhile are dirty anyway, the others are written with their current value next time
+        dirty.insert(writingKeys.begin(), writingKeys.end());
+    }
+
+    writingKeys.clear();
+}
+
+auto ScriptVariablesTable::write(const Changes &changes) -> bool {
     try {
         using namespace Database;
         PConnection connection = ConnectionManager::getInstance().getConnection();
         connection->beginTransaction();
 
-        DeleteQuery delQuery(connection);
-        delQuery.setServerTable("scriptvariables");
-        delQuery.execute();
+        if (!changes.deletes.empty()) {
+            DeleteQuery delQuery(connection);
+            delQuery.setServerTable("scriptvariables");
+            delQuery.addInCondition<std::string>("scriptvariables", "svt_ids", changes.deletes);
+            delQuery.execute();
+        }
 
         InsertQuery insQuery(connection);
         insQuery.setServerTable("scriptvariables");
         const InsertQuery::columnIndex idColumn = insQuery.addColumn("svt_ids");
         const InsertQuery::columnIndex valueColumn = insQuery.addColumn("svt_string");
 
-        for (const auto &var : *this) {
-            if (var.second.length() > 0) {
-                insQuery.addValue<std::string>(idColumn, var.first);
-                insQuery.addValue<std::string>(valueColumn, var.second);
-            }
+        for (const auto &[id, value] : changes.upserts) {
+            insQuery.addValue<std::string>(idColumn, id);
+            insQuery.addValue<std::string>(valueColumn, value);
         }
 
+        insQuery.updateOnConflict({"svt_ids"}, {"svt_string"});
         insQuery.execute();
 
         connection->commitTransaction();
+        return true;
     } catch (std::exception &e) {
-        Logger::error(LogFacility::Other) << "Exception in ScriptVariablesTable::save: " << e.what() << Log::end;
+        Logger::error(LogFacility::Other) << "Exception in ScriptVariablesTable::write: " << e.what() << Log::end;
+        return false;
     }
 }
 
@@ -23,26 +23,63 @@
 
 #include "data/StructTable.hpp"
 
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 class ScriptVariablesTable : public StructTable<std::string, std::string> {
 public:
     auto getTableName() const -> std::string override;
     auto getColumnNames() -> std::vector<std::string> override;
-    auto assignId(const Database::ResultTuple &row) -> std::string override;
-    auto assignTable(const Database::ResultTuple &row) -> std::string override;
+    auto assignId(const TableRow &row) -> std::string override;
+    auto assignTable(const TableRow &row) -> std::string override;
 
     auto find(const std::string &id, std::string &ret) -> bool;
+    // false and 0 if the variable is missing or does not hold a whole number
+    auto findNumber(const std::string &id, int32_t &ret) -> bool;
     void set(const std::string &id, const std::string &value);
     void set(const std::string &id, int32_t value);
+    // adds amount to the number of the variable, a missing one counting as 0, and returns the sum
+    auto increment(const std::string &id, int32_t amount) -> int32_t;
     auto remove(const std::string &id) -> bool;
 
+    // writes the variables changed since the last write in the background, unless the previous write still runs
+    void flush();
+    // writes all changes and waits for them
     void save();
+    // all variables in the text format of PostgreSQL's COPY, to be restored with \copy scriptvariables from
+    [[nodiscard]] auto copyText() const -> std::string;
 
     auto reloadBuffer() -> bool override;
     void activateBuffer() override;
 
+protected:
+    [[nodiscard]] auto isCacheable() const -> bool override { return false; }
+
 private:
     using Base = StructTable<std::string, std::string>;
+
+    struct Changes {
+        std::vector<std::pair<std::string, std::string>> upserts;
+        std::vector<std::string> deletes;
+    };
+
+    auto takeChanges() -> Changes;
+    // marks the variables of a failed write as changed again, blocks until a running write finished
+    void collectWrite();
+    static auto write(const Changes &changes) -> bool;
+
     bool first = true;
+    // variables used as numbers, kept as such and formatted only when written; they take precedence over the text
+    // values of the base table, which fall behind until the next write
+    std::unordered_map<std::string, int32_t> numbers;
+    // set or removed since the last write, empty values count as removed
+    std::unordered_set<std::string> dirty;
+    std::future<bool> writing;
+    std::vector<std::string> writingKeys;
 };
 
 #endif
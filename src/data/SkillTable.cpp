@@ -26,11 +26,11 @@ auto SkillTable::getColumnNames() -> std::vector<std::string> {
     return {"skl_skill_id", "skl_name", "skl_name_english", "skl_name_german"};
 }
 
-auto SkillTable::assignId(const Database::ResultTuple &row) -> TYPE_OF_SKILL_ID {
+auto SkillTable::assignId(const TableRow &row) -> TYPE_OF_SKILL_ID {
     return TYPE_OF_SKILL_ID(row["skl_skill_id"].as<uint16_t>());
 }
 
-auto SkillTable::assignTable(const Database::ResultTuple &row) -> SkillStruct {
+auto SkillTable::assignTable(const TableRow &row) -> SkillStruct {
     SkillStruct skill;
     skill.serverName = row["skl_name"].as<std::string>();
     skill.englishName = row["skl_name_english"].as<std::string>();
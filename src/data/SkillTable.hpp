@@ -29,8 +29,8 @@ class SkillTable : public StructTable<TYPE_OF_SKILL_ID, SkillStruct> {
 public:
     auto getTableName() const -> std::string override;
     auto getColumnNames() -> std::vector<std::string> override;
-    auto assignId(const Database::ResultTuple &row) -> TYPE_OF_SKILL_ID override;
-    auto assignTable(const Database::ResultTuple &row) -> SkillStruct override;
+    auto assignId(const TableRow &row) -> TYPE_OF_SKILL_ID override;
+    auto assignTable(const TableRow &row) -> SkillStruct override;
 };
 
 #endif
@@ -26,15 +26,15 @@ auto SpellTable::getColumnNames() -> std::vector<std::string> {
     return {"spl_spellid", "spl_magictype", "spl_scriptname"};
 }
 
-auto SpellTable::assignId(const Database::ResultTuple &row) -> Spell {
+auto SpellTable::assignId(const TableRow &row) -> Spell {
     Spell spell{};
     spell.magicType = uint8_t(row["spl_magictype"].as<uint16_t>());
     spell.spellId = row["spl_spellid"].as<uint32_t>();
     return spell;
 }
 
-auto SpellTable::assignTable(const Database::ResultTuple &row) -> SpellStruct { return SpellStruct(); }
+auto SpellTable::assignTable(const TableRow &row) -> SpellStruct { return SpellStruct(); }
 
-auto SpellTable::assignScriptName(const Database::ResultTuple &row) -> std::string {
+auto SpellTable::assignScriptName(const TableRow &row) -> std::string {
     return row["spl_scriptname"].as<std::string>("");
 }
@@ -57,9 +57,9 @@ class SpellTable : public ScriptStructTable<Spell, SpellStruct, LuaMagicScript>
 public:
     auto getTableName() const -> std::string override;
     auto getColumnNames() -> std::vector<std::string> override;
-    auto assignId(const Database::ResultTuple &row) -> Spell override;
-    auto assignTable(const Database::ResultTuple &row) -> SpellStruct override;
-    auto assignScriptName(const Database::ResultTuple &row) -> std::string override;
+    auto assignId(const TableRow &row) -> Spell override;
+    auto assignTable(const TableRow &row) -> SpellStruct override;
+    auto assignScriptName(const TableRow &row) -> std::string override;
 };
 
 #endif
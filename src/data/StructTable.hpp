@@ -22,12 +22,18 @@
 #define STRUCT_TABLE_HPP
 
 #include "Logger.hpp"
+#include "MemoryUsage.hpp"
 #include "data/Table.hpp"
-#include "db/Result.hpp"
-#include "db/SelectQuery.hpp"
+#include "data/TableCache.hpp"
+#include "data/TableRows.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
@@ -35,21 +41,33 @@ template <typename IdType, typename StructType> class StructTable : public Table
     using ContainerType = std::unordered_map<IdType, StructType>;
 
 public:
+    StructTable() = default;
+    StructTable(const StructTable &) = delete;
+    auto operator=(const StructTable &) -> StructTable & = delete;
+    // only safe while no other thread reads either table, e.g. when a test swaps in a table of its own
+    StructTable(StructTable &&other) noexcept { *this = std::move(other); }
+    auto operator=(StructTable &&other) noexcept -> StructTable & {
+        Table::operator=(std::move(other));
+        structBuffer = std::move(other.structBuffer);
+        isBufferValid = other.isBufferValid;
+        current = std::move(other.current);
+        retired = std::move(other.retired);
+        other.current = std::make_unique<Snapshot>();
+        published.store(current.get(), std::memory_order_release);
+        other.published.store(other.current.get(), std::memory_order_release);
+        ++generation;
+        return *this;
+    }
+    ~StructTable() override = default;
+
     auto reloadBuffer() -> bool override {
         try {
-            Database::SelectQuery query;
-
-            for (const auto &column : getColumnNames()) {
-                query.addColumn(column);
-            }
-
-            query.setServerTable(getTableName());
-            const auto results = query.execute();
+            const auto rows = TableCache::load(getTableName(), getColumnNames(), isCacheable());
 
             clear();
 
-            for (const auto &row : results) {
-                evaluateRow(row);
+            for (size_t row = 0; row < rows.size(); ++row) {
+                evaluateRow(rows.row(row));
             }
 
             isBufferValid = true;
@@ -63,51 +81,184 @@ public:
     }
 
     void reloadScripts() override {}
+    void reloadChangedScripts(const std::unordered_set<std::string> & /*modules*/) override {}
 
+    // publishes the loaded buffer as the new snapshot, readers on other threads never see a partial table
     void activateBuffer() override {
-        structs.swap(structBuffer);
+        auto next = std::make_unique<Snapshot>();
+        next->entries.swap(structBuffer);
+        buildIndex(*next);
+        published.store(next.get(), std::memory_order_release);
+        retired = std::move(current);
+        current = std::move(next);
+        ++generation;
         isBufferValid = false;
         clear();
     }
 
-    auto exists(const IdType &id) const -> bool { return structs.count(id) > 0; }
+    // changes whenever pointers returned by find may have become invalid
+    [[nodiscard]] auto getGeneration() const -> uint32_t { return generation; }
+
+    // without what the entries own themselves, e.g. their strings
+    [[nodiscard]] auto memoryUsage() const -> size_t override {
+        auto bytes = memory::ofHashed(structBuffer) + memory::ofHashed(current->entries) + memory::of(current->index);
+
+        if (retired) {
+            bytes += memory::ofHashed(retired->entries) + memory::of(retired->index);
+        }
+
+        return bytes;
+    }
+
+    // nullptr if there is no entry for id
+    auto find(const IdType &id) const -> const StructType * {
+        const auto *snapshot = published.load(std::memory_order_acquire);
+
+        if constexpr (std::is_integral_v<IdType>) {
+            if (snapshot->indexed) {
+                const auto &index = snapshot->index;
+                return !isNegative(id) && static_cast<size_t>(id) < index.size() ? index[static_cast<size_t>(id)]
+                                                                                  : nullptr;
+            }
+        }
+
+        const auto entry = snapshot->entries.find(id);
+        return entry != snapshot->entries.end() ? &entry->second : nullptr;
+    }
+
+    auto exists(const IdType &id) const -> bool { return find(id) != nullptr; }
 
     auto operator[](const IdType &id) -> const StructType & {
-        try {
-            return structs.at(id);
-        } catch (std::out_of_range &) {
-            Logger::error(LogFacility::Script)
-                    << "Table " << getTableName() << ": entry " << id << " was not found!" << Log::end;
-            return structs[id];
+        if (const auto *entry = find(id); entry != nullptr) {
+            return *entry;
         }
+
+        Logger::error(LogFacility::Script)
+                << "Table " << getTableName() << ": entry " << id << " was not found!" << Log::end;
+        return get(id);
     }
 
-    auto get(const IdType &id) const -> const StructType & { return structs.at(id); }
+    auto get(const IdType &id) const -> const StructType & { return current->entries.at(id); }
 
-    auto begin() const -> typename ContainerType::const_iterator { return structs.cbegin(); }
+    auto begin() const -> typename ContainerType::const_iterator { return current->entries.cbegin(); }
 
-    auto end() const -> typename ContainerType::const_iterator { return structs.cend(); }
+    auto end() const -> typename ContainerType::const_iterator { return current->entries.cend(); }
 
 protected:
     [[nodiscard]] virtual auto getTableName() const -> std::string = 0;
     virtual auto getColumnNames() -> std::vector<std::string> = 0;
-    virtual auto assignId(const Database::ResultTuple &row) -> IdType = 0;
-    virtual auto assignTable(const Database::ResultTuple &row) -> StructType = 0;
+    virtual auto assignId(const TableRow &row) -> IdType = 0;
+    virtual auto assignTable(const TableRow &row) -> StructType = 0;
+
+    // tables changed by the server itself must not be read from the table cache
+    [[nodiscard]] virtual auto isCacheable() const -> bool { return true; }
 
     virtual void clear() { structBuffer.clear(); }
 
-    virtual void evaluateRow(const Database::ResultTuple &row) { emplace(assignId(row), assignTable(row)); }
+    virtual void evaluateRow(const TableRow &row) { emplace(assignId(row), assignTable(row)); }
 
     virtual void emplace(const IdType &id, const StructType &data) { structBuffer.emplace(id, data); }
 
-    auto erase(const IdType &id) -> bool { return structs.erase(id) > 0; }
+    // changes of the active snapshot, game thread only
+    auto erase(const IdType &id) -> bool {
+        if (current->entries.erase(id) == 0) {
+            return false;
+        }
+
+        setIndexEntry(id, nullptr);
+        ++generation;
+        return true;
+    }
 
-    auto get(const IdType &id) -> StructType & { return structs[id]; }
+    auto get(const IdType &id) -> StructType & {
+        auto &entry = current->entries[id];
+        setIndexEntry(id, &entry);
+        return entry;
+    }
 
 private:
-    ContainerType structs;
+    // ids beyond this many slots per entry are looked up through the hash map
+    static constexpr size_t maxIndexSlotsPerEntry = 4;
+    static constexpr size_t minIndexSlots = 1U << 16U;
+
+    struct Snapshot {
+        ContainerType entries;
+        // dense integer ids are looked up directly, pointing into the nodes of entries
+        std::vector<const StructType *> index;
+        bool indexed = false;
+    };
+
     ContainerType structBuffer;
     bool isBufferValid = false;
+    uint32_t generation = 0;
+    std::unique_ptr<Snapshot> current = std::make_unique<Snapshot>();
+    // the snapshot replaced by the last activation stays alive until the next one, so that a reader on another
+    // thread which loaded it just before the switch can finish its lookup
+    std::unique_ptr<Snapshot> retired;
+    std::atomic<const Snapshot *> published{current.get()};
+
+    static auto maxIndexSlots(size_t entries) -> size_t {
+        return std::max(minIndexSlots, maxIndexSlotsPerEntry * entries);
+    }
+
+    static auto isNegative(const IdType &id) -> bool {
+        if constexpr (std::is_signed_v<IdType>) {
+            return id < 0;
+        } else {
+            return false;
+        }
+    }
+
+    static void buildIndex(Snapshot &snapshot) {
+        if constexpr (std::is_integral_v<IdType>) {
+            size_t slots = 0;
+
+            for (const auto &[id, data] : snapshot.entries) {
+                if (isNegative(id)) {
+                    return;
+                }
+
+                slots = std::max(slots, static_cast<size_t>(id) + 1);
+            }
+
+            if (slots > maxIndexSlots(snapshot.entries.size())) {
+                return;
+            }
+
+            snapshot.index.resize(slots, nullptr);
+
+            for (const auto &[id, data] : snapshot.entries) {
+                snapshot.index[static_cast<size_t>(id)] = &data;
+            }
+
+            snapshot.indexed = true;
+        }
+    }
+
+    void setIndexEntry(const IdType &id, const StructType *entry) {
+        if constexpr (std::is_integral_v<IdType>) {
+            auto &snapshot = *current;
+
+            if (!snapshot.indexed) {
+                return;
+            }
+
+            const auto slot = static_cast<size_t>(id);
+
+            if (slot < snapshot.index.size() && !isNegative(id)) {
+                snapshot.index[slot] = entry;
+            } else if (entry != nullptr) {
+                if (isNegative(id) || slot >= maxIndexSlots(snapshot.entries.size())) {
+                    snapshot.indexed = false;
+                    snapshot.index.clear();
+                    return;
+                }
+
+                snapshot.index.resize(slot + 1, nullptr);
+                snapshot.index[slot] = entry;
+            }
+        }
+    }
 };
 
 #endif
@@ -21,11 +21,19 @@
 #ifndef TABLE_HPP
 #define TABLE_HPP
 
+#include <cstddef>
+#include <string>
+#include <unordered_set>
+
 class Table {
 public:
     virtual auto reloadBuffer() -> bool = 0;
     virtual void reloadScripts() = 0;
+    // replaces only the scripts loaded from the given modules, scripts failing to load stay as they were
+    virtual void reloadChangedScripts(const std::unordered_set<std::string> &modules) = 0;
     virtual void activateBuffer() = 0;
+    // estimated heap bytes of the active entries and the buffer of the next reload
+    [[nodiscard]] virtual auto memoryUsage() const -> size_t = 0;
     Table() = default;
     virtual ~Table() = default;
     Table(const Table &) = default;
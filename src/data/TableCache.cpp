@@ -0,0 +1,264 @@
+/*
+ * Illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of Illarionserver.
+ *
+ * Illarionserver  is  free  software:  you can redistribute it and/or modify it
+ * under the terms of the  GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Illarionserver is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY;  without  even  the  implied  warranty  of  MERCHANTABILITY  or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "data/TableCache.hpp"
+
+#include "Config.hpp"
+#include "Logger.hpp"
+#include "db/ConnectionManager.hpp"
+#include "db/Query.hpp"
+#include "db/SchemaHelper.hpp"
+#include "db/SelectQuery.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <optional>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace TableCache {
+
+namespace {
+
+// Layout: Header, the checksum, every column name and then all cells row by row. Strings are prefixed with their
+// uint32_t length, nullLength marks a null cell.
+struct Header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t columns;
+    uint32_t rows;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(Header) == 16, "cache header layout must not depend on padding");
+
+constexpr uint32_t magic = 0x43544c49; // "ILTC"
+constexpr uint16_t currentVersion = 1;
+constexpr uint32_t nullLength = UINT32_MAX;
+
+auto cacheFile(const std::string &table) -> std::string {
+    const auto &dir = Config::instance().table_cache_dir();
+    return dir + (dir.empty() || dir.back() == '/' ? "" : "/") + table + ".cache";
+}
+
+// tables are content, reloads may lag behind the primary
+auto replicaConnection() -> Database::PConnection {
+    return Database::ConnectionManager::getInstance().getConnection(Database::ConnectionManager::Route::replica);
+}
+
+auto fetchChecksum(const std::string &table) -> std::string {
+    const auto qualifiedTable = Database::Query::escapeAndChainKeys(Database::SchemaHelper::getServerSchema(), table);
+    Database::Query query(replicaConnection(),
+                          "SELECT md5(string_agg(md5(t::text), '' ORDER BY md5(t::text))) AS checksum FROM " +
+                                  qualifiedTable + " t");
+    const auto result = query.execute();
+    return result.empty() ? "" : result.front()["checksum"].as<std::string>("");
+}
+
+auto select(const std::string &table, const std::vector<std::string> &columns) -> TableRows {
+    Database::SelectQuery query(replicaConnection());
+
+    for (const auto &column : columns) {
+        query.addColumn(column);
+    }
+
+    query.setServerTable(table);
+    return TableRows::fromResult(query.execute(), columns);
+}
+
+class Reader {
+public:
+    Reader(const char *data, size_t size) : data(data), size(size) {}
+
+    auto bytes(void *target, size_t count) -> bool {
+        if (size - offset < count) {
+            return false;
+        }
+
+        std::memcpy(target, data + offset, count);
+        offset += count;
+        return true;
+    }
+
+    auto string() -> std::optional<std::optional<std::string>> {
+        uint32_t length = 0;
+
+        if (!bytes(&length, sizeof(length))) {
+            return std::nullopt;
+        }
+
+        if (length == nullLength) {
+            return std::optional<std::string>();
+        }
+
+        if (size - offset < length) {
+            return std::nullopt;
+        }
+
+        std::string value(data + offset, length);
+        offset += length;
+        return std::optional<std::string>(std::move(value));
+    }
+
+private:
+    const char *data;
+    size_t size;
+    size_t offset = 0;
+};
+
+auto parse(const char *data, size_t size, const std::string &checksum, const std::vector<std::string> &columns)
+        -> std::optional<TableRows> {
+    Reader reader(data, size);
+    Header header{};
+
+    if (!reader.bytes(&header, sizeof(header)) || header.magic != magic || header.version != currentVersion ||
+        header.columns != columns.size()) {
+        return std::nullopt;
+    }
+
+    if (const auto cachedChecksum = reader.string(); !cachedChecksum || *cachedChecksum != checksum) {
+        return std::nullopt;
+    }
+
+    for (const auto &column : columns) {
+        if (const auto cachedColumn = reader.string(); !cachedColumn || *cachedColumn != column) {
+            return std::nullopt;
+        }
+    }
+
+    TableRows rows(columns);
+    std::vector<std::optional<std::string>> values;
+
+    for (uint32_t row = 0; row < header.rows; ++row) {
+        values.clear();
+
+        for (size_t column = 0; column < columns.size(); ++column) {
+            auto value = reader.string();
+
+            if (!value) {
+                return std::nullopt;
+            }
+
+            values.push_back(std::move(*value));
+        }
+
+        rows.addRow(std::move(values));
+        values = {};
+    }
+
+    return rows;
+}
+
+auto read(const std::string &fileName, const std::string &checksum, const std::vector<std::string> &columns)
+        -> std::optional<TableRows> {
+    const int fd = open(fileName.c_str(), O_RDONLY); // NOLINT(cppcoreguidelines-pro-type-vararg)
+
+    if (fd == -1) {
+        return std::nullopt;
+    }
+
+    struct stat fileStatus {};
+
+    if (fstat(fd, &fileStatus) == -1 || static_cast<size_t>(fileStatus.st_size) < sizeof(Header)) {
+        close(fd);
+        return std::nullopt;
+    }
+
+    const auto size = static_cast<size_t>(fileStatus.st_size);
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+        return std::nullopt;
+    }
+
+    auto rows = parse(static_cast<const char *>(mapping), size, checksum, columns);
+    munmap(mapping, size);
+    return rows;
+}
+
+void writeString(std::ofstream &stream, const std::optional<std::string> &value) {
+    const uint32_t length = value ? static_cast<uint32_t>(value->size()) : nullLength;
+    stream.write(reinterpret_cast<const char *>(&length), sizeof(length)); // NOLINT
+
+    if (value) {
+        stream.write(value->data(), static_cast<std::streamsize>(value->size()));
+    }
+}
+
+void write(const std::string &fileName, const std::string &checksum, const TableRows &rows) {
+    const auto temporary = fileName + ".tmp";
+
+    {
+        std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+        const auto &columns = rows.getColumns();
+        const Header header{magic, currentVersion, static_cast<uint16_t>(columns.size()),
+                            static_cast<uint32_t>(rows.size()), 0};
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(header)); // NOLINT
+        writeString(stream, checksum);
+
+        for (const auto &column : columns) {
+            writeString(stream, column);
+        }
+
+        for (size_t row = 0; row < rows.size(); ++row) {
+            for (size_t column = 0; column < columns.size(); ++column) {
+                writeString(stream, rows.cell(row, column));
+            }
+        }
+
+        if (!stream) {
+            Logger::warn(LogFacility::Database) << "Could not write table cache " << temporary << Log::end;
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+
+    if (std::rename(temporary.c_str(), fileName.c_str()) != 0) {
+        Logger::warn(LogFacility::Database) << "Could not replace table cache " << fileName << Log::end;
+        std::remove(temporary.c_str());
+    }
+}
+
+} // namespace
+
+auto load(const std::string &table, const std::vector<std::string> &columns, bool cacheable) -> TableRows {
+    if (!cacheable || Config::instance().table_cache_dir().empty()) {
+        return select(table, columns);
+    }
+
+    const auto checksum = fetchChecksum(table);
+    const auto fileName = cacheFile(table);
+
+    if (auto cached = read(fileName, checksum, columns)) {
+        Logger::info(LogFacility::Database) << "Table " << table << " loaded from cache" << Log::end;
+        return std::move(*cached);
+    }
+
+    auto rows = select(table, columns);
+    write(fileName, checksum, rows);
+    return rows;
+}
+
+} // namespace TableCache
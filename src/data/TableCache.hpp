@@ -0,0 +1,38 @@
+/*
+ * Illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of Illarionserver.
+ *
+ * Illarionserver  is  free  software:  you can redistribute it and/or modify it
+ * under the terms of the  GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Illarionserver is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY;  without  even  the  implied  warranty  of  MERCHANTABILITY  or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TABLE_CACHE_HPP
+#define TABLE_CACHE_HPP
+
+#include "data/TableRows.hpp"
+
+#include <string>
+#include <vector>
+
+// Optional binary cache of data tables in table_cache_dir. A cached table is used as long as the checksum of the
+// table in the database matches the one it was written with, so only the checksum has to be fetched.
+namespace TableCache {
+
+// the rows of the given columns in table, from the cache if cacheable and still valid
+auto load(const std::string &table, const std::vector<std::string> &columns, bool cacheable) -> TableRows;
+
+} // namespace TableCache
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * Illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of Illarionserver.
+ *
+ * Illarionserver  is  free  software:  you can redistribute it and/or modify it
+ * under the terms of the  GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Illarionserver is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY;  without  even  the  implied  warranty  of  MERCHANTABILITY  or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "data/TableRows.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+auto TableRows::Row::operator[](const std::string &column) const -> Field {
+    const auto index = rows.columnIndex.find(column);
+
+    if (index == rows.columnIndex.end()) {
+        throw std::invalid_argument("Unknown column " + column);
+    }
+
+    return Field(rows.cell(row, index->second));
+}
+
+TableRows::TableRows(std::vector<std::string> columns) : columns(std::move(columns)) {
+    for (size_t i = 0; i < this->columns.size(); ++i) {
+        columnIndex.emplace(this->columns[i], i);
+    }
+}
+
+auto TableRows::fromResult(const Database::Result &result, const std::vector<std::string> &columns) -> TableRows {
+    TableRows rows(columns);
+    rows.cells.reserve(result.size() * columns.size());
+
+    for (const auto &row : result) {
+        for (const auto &column : columns) {
+            const auto field = row[column];
+            rows.cells.push_back(field.is_null() ? std::nullopt : std::optional<std::string>(field.c_str()));
+        }
+    }
+
+    return rows;
+}
+
+void TableRows::addRow(std::vector<std::optional<std::string>> values) {
+    if (values.size() != columns.size()) {
+        throw std::invalid_argument("Row does not match the columns");
+    }
+
+    std::move(values.begin(), values.end(), std::back_inserter(cells));
+}
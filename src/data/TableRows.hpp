@@ -0,0 +1,93 @@
+/*
+ * Illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of Illarionserver.
+ *
+ * Illarionserver  is  free  software:  you can redistribute it and/or modify it
+ * under the terms of the  GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Illarionserver is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY;  without  even  the  implied  warranty  of  MERCHANTABILITY  or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TABLE_ROWS_HPP
+#define TABLE_ROWS_HPP
+
+#include "db/Result.hpp"
+
+#include <optional>
+#include <pqxx/strconv.hxx>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Rows of a data table in text form, as selected from the database or read back from the table cache. Fields
+// convert like pqxx fields do.
+class TableRows {
+public:
+    class Field {
+    public:
+        explicit Field(const std::optional<std::string> &value) : value(value) {}
+
+        [[nodiscard]] auto is_null() const -> bool { return !value; } // NOLINT(readability-identifier-naming)
+
+        template <typename T> [[nodiscard]] auto as() const -> T {
+            if (!value) {
+                throw std::domain_error("Attempt to read null field");
+            }
+
+            T result{};
+            pqxx::from_string(*value, result);
+            return result;
+        }
+
+        template <typename T> [[nodiscard]] auto as(const T &fallback) const -> T {
+            return value ? as<T>() : fallback;
+        }
+
+    private:
+        const std::optional<std::string> &value;
+    };
+
+    class Row {
+    public:
+        Row(const TableRows &rows, size_t row) : rows(rows), row(row) {}
+
+        auto operator[](const std::string &column) const -> Field;
+
+    private:
+        const TableRows &rows;
+        size_t row;
+    };
+
+    explicit TableRows(std::vector<std::string> columns);
+
+    static auto fromResult(const Database::Result &result, const std::vector<std::string> &columns) -> TableRows;
+
+    void addRow(std::vector<std::optional<std::string>> values);
+
+    [[nodiscard]] auto getColumns() const -> const std::vector<std::string> & { return columns; }
+    [[nodiscard]] auto size() const -> size_t { return columns.empty() ? 0 : cells.size() / columns.size(); }
+    [[nodiscard]] auto row(size_t row) const -> Row { return {*this, row}; }
+    [[nodiscard]] auto cell(size_t row, size_t column) const -> const std::optional<std::string> & {
+        return cells[row * columns.size() + column];
+    }
+
+private:
+    std::vector<std::string> columns;
+    std::unordered_map<std::string, size_t> columnIndex;
+    std::vector<std::optional<std::string>> cells;
+};
+
+using TableRow = TableRows::Row;
+
+#endif
@@ -32,11 +32,11 @@ auto TilesModificatorTable::getColumnNames() -> std::vector<std::string> {
     return {"tim_itemid", "tim_isnotpassable", "tim_specialitem", "tim_makepassable"};
 }
 
-auto TilesModificatorTable::assignId(const Database::ResultTuple &row) -> TYPE_OF_ITEM_ID {
+auto TilesModificatorTable::assignId(const TableRow &row) -> TYPE_OF_ITEM_ID {
     return row["tim_itemid"].as<TYPE_OF_ITEM_ID>();
 }
 
-auto TilesModificatorTable::assignTable(const Database::ResultTuple &row) -> TilesModificatorStruct {
+auto TilesModificatorTable::assignTable(const TableRow &row) -> TilesModificatorStruct {
     TilesModificatorStruct modStruct{};
     modStruct.Modificator = 0;
     modStruct.Modificator |= row["tim_isnotpassable"].as<bool>() ? FLAG_BLOCKPATH : 0;
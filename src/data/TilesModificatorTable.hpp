@@ -29,8 +29,8 @@ class TilesModificatorTable : public StructTable<TYPE_OF_ITEM_ID, TilesModificat
 public:
     auto getTableName() const -> std::string override;
     auto getColumnNames() -> std::vector<std::string> override;
-    auto assignId(const Database::ResultTuple &row) -> TYPE_OF_ITEM_ID override;
-    auto assignTable(const Database::ResultTuple &row) -> TilesModificatorStruct override;
+    auto assignId(const TableRow &row) -> TYPE_OF_ITEM_ID override;
+    auto assignTable(const TableRow &row) -> TilesModificatorStruct override;
     auto passable(TYPE_OF_ITEM_ID id) -> bool;
 };
 
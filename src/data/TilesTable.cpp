@@ -28,11 +28,11 @@ auto TilesTable::getColumnNames() -> std::vector<std::string> {
     return {"til_id", "til_isnotpassable", "til_german", "til_english", "til_walkingcost", "til_script"};
 }
 
-auto TilesTable::assignId(const Database::ResultTuple &row) -> TYPE_OF_TILE_ID {
+auto TilesTable::assignId(const TableRow &row) -> TYPE_OF_TILE_ID {
     return row["til_id"].as<TYPE_OF_TILE_ID>();
 }
 
-auto TilesTable::assignTable(const Database::ResultTuple &row) -> TilesStruct {
+auto TilesTable::assignTable(const TableRow &row) -> TilesStruct {
     TilesStruct tile;
     tile.flags = row["til_isnotpassable"].as<bool>() ? FLAG_BLOCKPATH : 0;
     tile.German = row["til_german"].as<std::string>();
@@ -41,6 +41,6 @@ auto TilesTable::assignTable(const Database::ResultTuple &row) -> TilesStruct {
     return tile;
 }
 
-auto TilesTable::assignScriptName(const Database::ResultTuple &row) -> std::string {
+auto TilesTable::assignScriptName(const TableRow &row) -> std::string {
     return row["til_script"].as<std::string>("");
 }
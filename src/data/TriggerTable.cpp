@@ -26,17 +26,17 @@ auto TriggerTable::getColumnNames() -> std::vector<std::string> {
     return {"tgf_posx", "tgf_posy", "tgf_posz", "tgf_script"};
 }
 
-auto TriggerTable::assignId(const Database::ResultTuple &row) -> position {
+auto TriggerTable::assignId(const TableRow &row) -> position {
     return position(row["tgf_posx"].as<int16_t>(), row["tgf_posy"].as<int16_t>(), row["tgf_posz"].as<int16_t>());
 }
 
-auto TriggerTable::assignTable(const Database::ResultTuple &row) -> TriggerStruct {
+auto TriggerTable::assignTable(const TableRow &row) -> TriggerStruct {
     TriggerStruct trigger;
     trigger.pos = assignId(row);
     return trigger;
 }
 
-auto TriggerTable::assignScriptName(const Database::ResultTuple &row) -> std::string {
+auto TriggerTable::assignScriptName(const TableRow &row) -> std::string {
     return row["tgf_script"].as<std::string>("");
 }
 
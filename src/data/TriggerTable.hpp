@@ -34,9 +34,9 @@ class TriggerTable : public QuestScriptStructTable<position, TriggerStruct, LuaT
 public:
     auto getTableName() const -> std::string override;
     auto getColumnNames() -> std::vector<std::string> override;
-    auto assignId(const Database::ResultTuple &row) -> position override;
-    auto assignTable(const Database::ResultTuple &row) -> TriggerStruct override;
-    auto assignScriptName(const Database::ResultTuple &row) -> std::string override;
+    auto assignId(const TableRow &row) -> position override;
+    auto assignTable(const TableRow &row) -> TriggerStruct override;
+    auto assignScriptName(const TableRow &row) -> std::string override;
     auto getQuestScripts() -> NodeRange override;
 };
 
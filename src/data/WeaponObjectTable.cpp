@@ -28,11 +28,11 @@ auto WeaponObjectTable::getColumnNames() -> std::vector<std::string> {
             "wp_fightingscript"};
 }
 
-auto WeaponObjectTable::assignId(const Database::ResultTuple &row) -> TYPE_OF_ITEM_ID {
+auto WeaponObjectTable::assignId(const TableRow &row) -> TYPE_OF_ITEM_ID {
     return row["wp_itemid"].as<TYPE_OF_ITEM_ID>();
 }
 
-auto WeaponObjectTable::assignTable(const Database::ResultTuple &row) -> WeaponStruct {
+auto WeaponObjectTable::assignTable(const TableRow &row) -> WeaponStruct {
     WeaponStruct weapon;
     weapon.Attack = TYPE_OF_ATTACK(row["wp_attack"].as<uint16_t>());
     weapon.Defence = TYPE_OF_DEFENCE(row["wp_defence"].as<uint16_t>());
@@ -46,6 +46,6 @@ auto WeaponObjectTable::assignTable(const Database::ResultTuple &row) -> WeaponS
     return weapon;
 }
 
-auto WeaponObjectTable::assignScriptName(const Database::ResultTuple &row) -> std::string {
+auto WeaponObjectTable::assignScriptName(const TableRow &row) -> std::string {
     return row["wp_fightingscript"].as<std::string>("");
 }
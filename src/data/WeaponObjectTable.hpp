@@ -30,9 +30,9 @@ class WeaponObjectTable : public ScriptStructTable<TYPE_OF_ITEM_ID, WeaponStruct
 public:
     auto getTableName() const -> std::string override;
     auto getColumnNames() -> std::vector<std::string> override;
-    auto assignId(const Database::ResultTuple &row) -> TYPE_OF_ITEM_ID override;
-    auto assignTable(const Database::ResultTuple &row) -> WeaponStruct override;
-    auto assignScriptName(const Database::ResultTuple &row) -> std::string override;
+    auto assignId(const TableRow &row) -> TYPE_OF_ITEM_ID override;
+    auto assignTable(const TableRow &row) -> WeaponStruct override;
+    auto assignScriptName(const TableRow &row) -> std::string override;
 };
 
 #endif
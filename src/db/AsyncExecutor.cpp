@@ -0,0 +1,199 @@
+/*
+ * Illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of Illarionserver.
+ *
+ * Illarionserver  is  free  software:  you can redistribute it and/or modify it
+ * under the terms of the  GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Illarionserver is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY;  without  even  the  implied  warranty  of  MERCHANTABILITY  or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "db/AsyncExecutor.hpp"
+
+#include "Config.hpp"
+#include "Logger.hpp"
+#include "ThreadAffinity.hpp"
+#include "db/ConnectionManager.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace Database {
+
+auto AsyncExecutor::getInstance() -> AsyncExecutor & {
+    static AsyncExecutor instance;
+    return instance;
+}
+
+AsyncExecutor::~AsyncExecutor() { stop(); }
+
+void AsyncExecutor::write(std::string description, Job job) {
+    std::lock_guard<std::mutex> lock(mutex);
+    writes.push_back({std::move(description), std::move(job)});
+    ++queued;
+    startWorkers();
+    wakeWriter.notify_one();
+}
+
+void AsyncExecutor::enqueueRead(Job job) {
+    std::lock_guard<std::mutex> lock(mutex);
+    reads.push_back(std::move(job));
+    startWorkers();
+    wakeReaders.notify_one();
+}
+
+void AsyncExecutor::startWorkers() {
+    if (writer.joinable()) {
+        return;
+    }
+
+    stopping = false;
+    writer = std::thread([this] { runWriter(); });
+    const auto readerCount = std::max<uint16_t>(Config::instance().postgres_async_readers(), 1);
+
+    for (uint16_t i = 0; i < readerCount; ++i) {
+        readers.emplace_back([this] { runReader(); });
+    }
+}
+
+void AsyncExecutor::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    if (!writer.joinable()) {
+        return;
+    }
+
+    const auto target = queued;
+    writesDone.wait(lock, [this, target] { return written >= target; });
+}
+
+void AsyncExecutor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (!writer.joinable()) {
+            return;
+        }
+
+        stopping = true;
+        wakeWriter.notify_one();
+        wakeReaders.notify_all();
+    }
+
+    writer.join();
+
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    readers.clear();
+}
+
+void AsyncExecutor::runWriter() {
+    affinity::pinCurrentThread(Config::instance().database_thread_cores(), "database");
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        wakeWriter.wait(lock, [this] { return !writes.empty() || stopping; });
+
+        if (writes.empty()) {
+            break;
+        }
+
+        const auto batchSize = std::min(writes.size(), maxBatchSize);
+        std::vector<Write> batch(std::make_move_iterator(writes.begin()),
+                                 std::make_move_iterator(writes.begin() + batchSize));
+        writes.erase(writes.begin(), writes.begin() + batchSize);
+
+        lock.unlock();
+        execute(batch);
+        lock.lock();
+
+        written += batchSize;
+        writesDone.notify_all();
+    }
+}
+
+void AsyncExecutor::runReader() {
+    affinity::pinCurrentThread(Config::instance().database_thread_cores(), "database");
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        wakeReaders.wait(lock, [this] { return !reads.empty() || stopping; });
+
+        if (reads.empty()) {
+            break;
+        }
+
+        auto job = std::move(reads.front());
+        reads.pop_front();
+        lock.unlock();
+
+        try {
+            auto connection = ConnectionManager::getInstance().getConnection();
+            connection->beginTransaction();
+            // a failing read stores its exception in the future, so the transaction is never committed
+            job(connection);
+            connection->rollbackTransaction();
+        } catch (std::exception &e) {
+            Logger::error(LogFacility::Database) << "Error while running a database read: " << e.what() << Log::end;
+        }
+
+        lock.lock();
+    }
+}
+
+void AsyncExecutor::execute(const std::vector<Write> &batch) {
+    try {
+        auto connection = ConnectionManager::getInstance().getConnection();
+
+        try {
+            connection->beginTransaction();
+
+            for (const auto &write : batch) {
+                write.job(connection);
+            }
+
+            connection->commitTransaction();
+            return;
+        } catch (std::exception &e) {
+            if (batch.size() == 1) {
+                Logger::error(LogFacility::Database)
+                        << "Error while " << batch.front().description << ": " << e.what() << Log::end;
+                connection->rollbackTransaction();
+                return;
+            }
+
+            Logger::error(LogFacility::Database) << "Error while writing " << batch.size()
+                                                 << " queued jobs, retrying one by one: " << e.what() << Log::end;
+            connection->rollbackTransaction();
+        }
+
+        // one broken write must not take the rest of the batch with it
+        for (const auto &write : batch) {
+            try {
+                connection->beginTransaction();
+                write.job(connection);
+                connection->commitTransaction();
+            } catch (std::exception &e) {
+                Logger::error(LogFacility::Database)
+                        << "Error while " << write.description << ": " << e.what() << Log::end;
+                connection->rollbackTransaction();
+            }
+        }
+    } catch (std::exception &e) {
+        Logger::error(LogFacility::Database) << "Error while writing queued jobs: " << e.what() << Log::end;
+    }
+}
+
+} // namespace Database
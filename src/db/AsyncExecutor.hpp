@@ -0,0 +1,105 @@
+/*
+ * Illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of Illarionserver.
+ *
+ * Illarionserver  is  free  software:  you can redistribute it and/or modify it
+ * under the terms of the  GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Illarionserver is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY;  without  even  the  implied  warranty  of  MERCHANTABILITY  or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DB_ASYNC_EXECUTOR_HPP
+#define DB_ASYNC_EXECUTOR_HPP
+
+#include "db/Connection.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Database {
+
+/* Runs database jobs on worker threads with their own connections, so the calling thread never waits for a round
+ * trip. Writes are executed in the order they were queued by a single writer, everything queued together is
+ * committed in one transaction. Reads are spread over postgres_async_readers further workers. Jobs get a connection
+ * with an active transaction and must neither commit nor roll it back.
+ */
+class AsyncExecutor {
+public:
+    using Job = std::function<void(const PConnection &)>;
+
+    static auto getInstance() -> AsyncExecutor &;
+
+    AsyncExecutor(const AsyncExecutor &) = delete;
+    auto operator=(const AsyncExecutor &) -> AsyncExecutor & = delete;
+    AsyncExecutor(AsyncExecutor &&) = delete;
+    auto operator=(AsyncExecutor &&) -> AsyncExecutor & = delete;
+    ~AsyncExecutor();
+
+    // fire and forget, failures are logged with the description
+    void write(std::string description, Job job);
+
+    template <typename Read>
+    auto read(Read read) -> std::future<std::invoke_result_t<Read, const PConnection &>> {
+        using Value = std::invoke_result_t<Read, const PConnection &>;
+        auto task = std::make_shared<std::packaged_task<Value(const PConnection &)>>(std::move(read));
+        auto result = task->get_future();
+        enqueueRead([task](const PConnection &connection) { (*task)(connection); });
+        return result;
+    }
+
+    // blocks until all writes queued so far are committed
+    void flush();
+    // flushes and terminates the workers, later jobs start them again
+    void stop();
+
+private:
+    struct Write {
+        std::string description;
+        Job job;
+    };
+
+    static constexpr size_t maxBatchSize = 256;
+
+    std::mutex mutex;
+    std::condition_variable wakeWriter;
+    std::condition_variable wakeReaders;
+    std::condition_variable writesDone;
+    std::thread writer;
+    std::vector<std::thread> readers;
+    bool stopping = false;
+    std::deque<Write> writes;
+    std::deque<Job> reads;
+    uint64_t queued = 0;
+    uint64_t written = 0;
+
+    AsyncExecutor() = default;
+
+    void startWorkers();
+    void enqueueRead(Job job);
+    void runWriter();
+    void runReader();
+    static void execute(const std::vector<Write> &batch);
+};
+
+} // namespace Database
+
+#endif
@@ -21,8 +21,15 @@
 #include "Connection.hpp"
 
 #include <memory>
+#include <array>
 #include <pqxx/connection.hxx>
 #include <pqxx/transaction.hxx>
+#include <pqxx/version.hxx>
+#if PQXX_VERSION_MAJOR < 7
+#include <pqxx/tablewriter.hxx>
+#else
+#include <pqxx/stream_to.hxx>
+#endif
 #include <stdexcept>
 
 using namespace Database;
@@ -53,6 +60,54 @@ void Connection::rollbackTransaction() {
     }
 }
 
+auto Connection::isOpen() const -> bool { return internalConnection && internalConnection->is_open(); }
+
+void Connection::copyRows(const std::string &table, const std::string &columns,
+                          const std::vector<std::vector<std::optional<std::string>>> &rows) {
+    if (!transaction) {
+        throw std::domain_error("No active transaction");
+    }
+
+    std::vector<std::string> values;
+#if PQXX_VERSION_MAJOR < 7
+    // an empty string would be written as NULL by the default null representation
+    static const std::string nullValue = "\\N";
+    const std::array<std::string, 1> columnList{columns};
+    pqxx::tablewriter stream(*transaction, table, columnList.begin(), columnList.end(), nullValue);
+#else
+    auto stream = pqxx::stream_to::raw_table(*transaction, table, columns);
+#endif
+
+    for (const auto &row : rows) {
+        values.clear();
+
+        for (const auto &value : row) {
+            values.push_back(value.value());
+        }
+
+#if PQXX_VERSION_MAJOR < 7
+        stream.insert(values);
+#else
+        stream.write_row(values);
+#endif
+    }
+
+    stream.complete();
+}
+
+void Connection::prepare(const std::string &name, const std::string &sql) {
+    if (!prepared.insert(name).second) {
+        return;
+    }
+
+    try {
+        internalConnection->prepare(name, sql);
+    } catch (...) {
+        prepared.erase(name);
+        throw;
+    }
+}
+
 auto Connection::query(const std::string &query) -> pqxx::result {
     if (transaction) {
         return transaction->exec(query);
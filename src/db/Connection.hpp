@@ -22,9 +22,13 @@
 #define DB_CONNECTION_HPP
 
 #include <memory>
+#include <optional>
 #include <pqxx/connection.hxx>
 #include <pqxx/transaction.hxx>
+#include <stdexcept>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
 namespace Database {
 class Connection;
@@ -36,6 +40,8 @@ private:
     /* The libpgxx representation of the connection to the database. */
     std::unique_ptr<pqxx::connection> internalConnection = nullptr;
     std::unique_ptr<pqxx::transaction_base> transaction = nullptr;
+    /* Names of the statements already prepared on this connection. */
+    std::unordered_set<std::string> prepared;
 
 public:
     explicit Connection(const std::string &connectionString);
@@ -47,6 +53,18 @@ public:
 
     void beginTransaction();
     auto query(const std::string &query) -> pqxx::result;
+    template <typename... Args>
+    auto execPrepared(const std::string &name, const std::string &sql, const Args &...args) -> pqxx::result {
+        if (!transaction) {
+            throw std::domain_error("No active transaction");
+        }
+
+        prepare(name, sql);
+        return transaction->exec_prepared(name, args...);
+    }
+    // streams rows into table through COPY, columns is the escaped column list
+    void copyRows(const std::string &table, const std::string &columns,
+                  const std::vector<std::vector<std::optional<std::string>>> &rows);
     void commitTransaction();
     void rollbackTransaction();
 
@@ -55,6 +73,10 @@ public:
     }
 
     [[nodiscard]] inline auto transactionActive() const -> bool { return bool(transaction); }
+    [[nodiscard]] auto isOpen() const -> bool;
+
+private:
+    void prepare(const std::string &name, const std::string &sql);
 };
 
 } // namespace Database
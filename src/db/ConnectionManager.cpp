@@ -21,8 +21,10 @@
 #include "db/ConnectionManager.hpp"
 
 #include "Config.hpp"
+#include "Logger.hpp"
 #include "db/Connection.hpp"
 
+#include <algorithm>
 #include <boost/cstdint.hpp>
 #include <pqxx/connection.hxx>
 #include <sstream>
@@ -36,25 +38,156 @@ ConnectionManager ConnectionManager::instance;
 auto ConnectionManager::getInstance() -> ConnectionManager & { return ConnectionManager::instance; }
 
 void ConnectionManager::setupManager() {
-    connectionString = "";
-    addConnectionParameterIfValid("user", Config::instance().postgres_user);
-    addConnectionParameterIfValid("password", Config::instance().postgres_pwd);
-    addConnectionParameterIfValid("dbname", Config::instance().postgres_db);
-    addConnectionParameterIfValid("host", Config::instance().postgres_host);
-    addConnectionParameterIfValid("port", std::to_string(Config::instance().postgres_port));
+    const auto &config = Config::instance();
+    string common;
+    addConnectionParameterIfValid(common, "user", config.postgres_user);
+    addConnectionParameterIfValid(common, "password", config.postgres_pwd);
+    addConnectionParameterIfValid(common, "dbname", config.postgres_db);
+
+    string primaryString = common;
+    addConnectionParameterIfValid(primaryString, "host", config.postgres_host);
+    addConnectionParameterIfValid(primaryString, "port", std::to_string(config.postgres_port));
+    open(primary, primaryString, config.postgres_pool_size);
+
+    hasReplica = !config.postgres_replica_host().empty();
+
+    if (hasReplica) {
+        string replicaString = common;
+        addConnectionParameterIfValid(replicaString, "host", config.postgres_replica_host);
+        addConnectionParameterIfValid(replicaString, "port", std::to_string(config.postgres_replica_port));
+        open(replica, replicaString, config.postgres_replica_pool_size);
+    }
+
     isOperational = true;
 }
 
-auto ConnectionManager::getConnection() -> PConnection {
+void ConnectionManager::open(Pool &pool, const string &connectionString, size_t size) {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    pool.connectionString = connectionString;
+    pool.size = std::max<size_t>(size, 1);
+
+    // opened up front, so the first saves do not pay for the handshakes
+    try {
+        while (pool.stats.open < pool.size) {
+            pool.idle.push_back(std::make_unique<Connection>(pool.connectionString));
+            ++pool.stats.open;
+        }
+    } catch (std::exception &e) {
+        Logger::warn(LogFacility::Database) << "Opened only " << pool.stats.open << " of " << pool.size
+                                            << " pooled database connections: " << e.what() << Log::end;
+    }
+}
+
+auto ConnectionManager::poolOf(Route route) -> Pool & {
+    return route == Route::replica && hasReplica ? replica : primary;
+}
+
+auto ConnectionManager::getConnection(Route route) -> PConnection {
     if (!isOperational) {
         throw std::logic_error("Connection Manager is not set up yet");
     }
 
-    auto connPtr = std::make_shared<Connection>(connectionString);
-    return connPtr;
+    auto &pool = poolOf(route);
+    return {checkout(pool).release(), [&pool](Connection *connection) { giveBack(pool, connection); }};
+}
+
+auto ConnectionManager::checkout(Pool &pool) -> std::unique_ptr<Connection> {
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    auto &stats = pool.stats;
+    ++stats.checkouts;
+
+    if (pool.idle.empty() && stats.open >= pool.size) {
+        // a thread holding a connection while asking for another one must not wait forever
+        const std::chrono::milliseconds maxWait{Config::instance().postgres_pool_wait};
+        const auto start = std::chrono::steady_clock::now();
+        ++stats.waits;
+        pool.connectionReturned.wait_for(lock, maxWait,
+                                         [&pool] { return !pool.idle.empty() || pool.stats.open < pool.size; });
+        const auto waited = std::chrono::steady_clock::now() - start;
+        stats.waitTime += waited;
+        stats.maxWait = std::max<std::chrono::nanoseconds>(stats.maxWait, waited);
+
+        if (pool.idle.empty() && stats.open >= pool.size) {
+            ++stats.overflows;
+        }
+    }
+
+    while (!pool.idle.empty()) {
+        auto connection = std::move(pool.idle.back());
+        pool.idle.pop_back();
+
+        if (connection->isOpen()) {
+            return connection;
+        }
+
+        --stats.open;
+        ++stats.reconnects;
+    }
+
+    ++stats.open;
+    lock.unlock();
+
+    try {
+        return std::make_unique<Connection>(pool.connectionString);
+    } catch (...) {
+        lock.lock();
+        --stats.open;
+        pool.connectionReturned.notify_one();
+        throw;
+    }
+}
+
+void ConnectionManager::giveBack(Pool &pool, Connection *connection) {
+    std::unique_ptr<Connection> returned(connection);
+
+    // left over by an exception between begin and commit
+    try {
+        returned->rollbackTransaction();
+    } catch (std::exception &) {
+        returned.reset();
+    }
+
+    std::lock_guard<std::mutex> lock(pool.mutex);
+
+    if (returned && returned->isOpen() && pool.stats.open <= pool.size) {
+        pool.idle.push_back(std::move(returned));
+    } else {
+        --pool.stats.open;
+    }
+
+    pool.connectionReturned.notify_one();
+}
+
+auto ConnectionManager::getStats(Route route) -> PoolStats {
+    auto &pool = poolOf(route);
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    auto result = pool.stats;
+    result.idle = pool.idle.size();
+    return result;
+}
+
+void ConnectionManager::logStats() {
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    for (const auto route : {Route::primary, Route::replica}) {
+        if (route == Route::replica && !hasReplica) {
+            continue;
+        }
+
+        const auto current = getStats(route);
+
+        Logger::info(LogFacility::Database)
+                << (route == Route::primary ? "database pool: " : "replica pool: ") << current.open << " open, "
+                << current.idle << " idle, " << current.checkouts << " checkouts, " << current.waits << " waits, "
+                << duration_cast<microseconds>(current.waitTime).count() << " us waited, "
+                << duration_cast<microseconds>(current.maxWait).count() << " us longest wait, " << current.overflows
+                << " overflows, " << current.reconnects << " reconnects" << Log::end;
+    }
 }
 
-void ConnectionManager::addConnectionParameterIfValid(const string &param, const string &value) {
+void ConnectionManager::addConnectionParameterIfValid(string &connectionString, const string &param,
+                                                      const string &value) {
     if (!value.empty()) {
         connectionString += " " + param + "=" + value;
     }
@@ -24,17 +24,56 @@
 #include "db/Connection.hpp"
 
 #include <boost/cstdint.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 using std::string;
 
 namespace Database {
+// Hands out connections from a pool of postgres_pool_size open connections. A connection returns to the pool when the
+// last copy of its PConnection is gone; broken connections are replaced by new ones. Reads which may lag behind can
+// ask for a connection of the read replica instead, which has a pool of its own and falls back to the primary.
 class ConnectionManager {
+public:
+    enum class Route {
+        primary,
+        // read only use, served by the replica if there is one
+        replica
+    };
+
+    struct PoolStats {
+        uint64_t checkouts = 0;
+        uint64_t waits = 0;
+        // connections opened beyond the pool size because a checkout waited too long
+        uint64_t overflows = 0;
+        uint64_t reconnects = 0;
+        std::chrono::nanoseconds waitTime{0};
+        std::chrono::nanoseconds maxWait{0};
+        size_t open = 0;
+        size_t idle = 0;
+    };
+
 private:
+    struct Pool {
+        string connectionString;
+        std::mutex mutex;
+        std::condition_variable connectionReturned;
+        std::vector<std::unique_ptr<Connection>> idle;
+        size_t size = 1;
+        PoolStats stats;
+    };
+
     static ConnectionManager instance;
-    string connectionString;
     bool isOperational{false};
+    bool hasReplica{false};
+    Pool primary;
+    Pool replica;
 
 public:
     ConnectionManager(const ConnectionManager &org) = delete;
@@ -45,11 +84,18 @@ public:
     ~ConnectionManager() = default;
 
     void setupManager();
-    auto getConnection() -> PConnection;
+    // waits for a free connection if all are in use
+    auto getConnection(Route route = Route::primary) -> PConnection;
+    [[nodiscard]] auto getStats(Route route = Route::primary) -> PoolStats;
+    void logStats();
 
 private:
     ConnectionManager() = default;
-    void addConnectionParameterIfValid(const string &param, const string &value);
+    static void addConnectionParameterIfValid(string &connectionString, const string &param, const string &value);
+    static void open(Pool &pool, const string &connectionString, size_t size);
+    auto poolOf(Route route) -> Pool &;
+    static auto checkout(Pool &pool) -> std::unique_ptr<Connection>;
+    static void giveBack(Pool &pool, Connection *connection);
 };
 } // namespace Database
 
@@ -22,6 +22,7 @@
 
 #include "db/ConnectionManager.hpp"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace Database;
@@ -36,12 +37,52 @@ InsertQuery::InsertQuery(const PConnection &connection) : Query(connection) {
     setHideTable(true);
 }
 
+void InsertQuery::updateOnConflict(const std::vector<std::string> &keyColumns,
+                                   const std::vector<std::string> &updatedColumns) {
+    std::stringstream ss;
+    ss << " ON CONFLICT (";
+
+    for (size_t i = 0; i < keyColumns.size(); ++i) {
+        ss << (i > 0 ? ", " : "") << escapeKey(keyColumns[i]);
+    }
+
+    ss << ")";
+
+    if (updatedColumns.empty()) {
+        ss << " DO NOTHING";
+    } else {
+        ss << " DO UPDATE SET ";
+
+        for (size_t i = 0; i < updatedColumns.size(); ++i) {
+            const auto column = escapeKey(updatedColumns[i]);
+            ss << (i > 0 ? ", " : "") << column << " = EXCLUDED." << column;
+        }
+    }
+
+    conflictClause = ss.str();
+}
+
 auto InsertQuery::execute() -> Result {
     if (dataStorage.empty()) {
         Result result;
         return result;
     }
 
+    uint32_t columns = getColumnCount();
+
+    for (const auto &dataRow : dataStorage) {
+        if (columns != dataRow.size() || !std::all_of(dataRow.begin(), dataRow.end(), [](const auto &value) {
+                return value.has_value();
+            })) {
+            throw std::invalid_argument("Incorrect amount of data supplied.");
+        }
+    }
+
+    if (conflictClause.empty() && dataStorage.size() >= copyThreshold) {
+        copy();
+        return {};
+    }
+
     std::stringstream ss;
     ss << "INSERT INTO ";
     ss << QueryTables::buildQuerySegment();
@@ -49,7 +90,6 @@ auto InsertQuery::execute() -> Result {
     ss << QueryColumns::buildQuerySegment();
     ss << ") VALUES ";
     ss << "(";
-    uint32_t columns = getColumnCount();
     bool firstDone = false;
 
     for (const auto &dataRow : dataStorage) {
@@ -59,12 +99,8 @@ auto InsertQuery::execute() -> Result {
             firstDone = true;
         }
 
-        if (columns != dataRow.size()) {
-            throw std::invalid_argument("Incorrect amount of data supplied.");
-        }
-
         for (uint32_t column = 0; column < columns; column++) {
-            ss << *(dataRow.at(column));
+            ss << quote<std::string>(*(dataRow.at(column)));
 
             if (column < columns - 1) {
                 ss << ", ";
@@ -74,8 +110,24 @@ auto InsertQuery::execute() -> Result {
 
     dataStorage.clear();
 
-    ss << ");";
+    ss << ")" << conflictClause << ";";
 
     setQuery(ss.str());
     return Query::execute();
 }
+
+void InsertQuery::copy() {
+    auto connection = getConnection();
+    bool ownTransaction = !connection->transactionActive();
+
+    if (ownTransaction) {
+        connection->beginTransaction();
+    }
+
+    connection->copyRows(QueryTables::buildQuerySegment(), QueryColumns::buildQuerySegment(), dataStorage);
+    dataStorage.clear();
+
+    if (ownTransaction) {
+        connection->commitTransaction();
+    }
+}
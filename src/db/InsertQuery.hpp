@@ -30,6 +30,7 @@
 #include <boost/cstdint.hpp>
 #include <map>
 #include <optional>
+#include <pqxx/strconv.hxx>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -38,6 +39,10 @@ namespace Database {
 class InsertQuery : Query, public QueryColumns, public QueryTables {
 private:
     std::vector<std::vector<std::optional<std::string>>> dataStorage;
+    std::string conflictClause;
+
+    // plain inserts of at least this many rows are streamed through COPY
+    static constexpr size_t copyThreshold = 500;
 
 public:
     enum MapInsertMode { onlyKeys, onlyValues, keysAndValues };
@@ -67,7 +72,7 @@ public:
             throw std::invalid_argument("Column index out of range.");
         }
 
-        std::string strValue = quote<T>(value);
+        std::string strValue = pqxx::to_string(value);
 
         if (!dataStorage.empty()) {
             for (auto &dataRow : dataStorage) {
@@ -135,7 +140,13 @@ public:
         }
     }
 
+    // rows colliding with existing ones on keyColumns update updatedColumns instead, or are skipped if there are none
+    void updateOnConflict(const std::vector<std::string> &keyColumns, const std::vector<std::string> &updatedColumns);
+
     auto execute() -> Result override;
+
+private:
+    void copy();
 };
 } // namespace Database
 
@@ -0,0 +1,38 @@
+/*
+ * Illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of Illarionserver.
+ *
+ * Illarionserver  is  free  software:  you can redistribute it and/or modify it
+ * under the terms of the  GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Illarionserver is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY;  without  even  the  implied  warranty  of  MERCHANTABILITY  or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "db/PreparedQuery.hpp"
+
+#include "db/SchemaHelper.hpp"
+
+#include <utility>
+
+using namespace Database;
+
+PreparedQuery::PreparedQuery(std::string name, const std::string &statement) : name(std::move(name)) {
+    static const std::string schemaPlaceholder = "{server}";
+    const auto &schema = SchemaHelper::getServerSchema();
+    this->statement = statement;
+
+    for (auto pos = this->statement.find(schemaPlaceholder); pos != std::string::npos;
+         pos = this->statement.find(schemaPlaceholder, pos + schema.length())) {
+        this->statement.replace(pos, schemaPlaceholder.length(), schema);
+    }
+}
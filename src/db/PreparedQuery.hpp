@@ -0,0 +1,60 @@
+/*
+ * Illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of Illarionserver.
+ *
+ * Illarionserver  is  free  software:  you can redistribute it and/or modify it
+ * under the terms of the  GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Illarionserver is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY;  without  even  the  implied  warranty  of  MERCHANTABILITY  or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PREPARED_QUERY_HPP
+#define PREPARED_QUERY_HPP
+
+#include "db/Connection.hpp"
+#include "db/Result.hpp"
+
+#include <string>
+
+namespace Database {
+/* A query of fixed shape with its values passed as $1, $2, ... parameters. The statement is parsed and planned
+ * once per connection, later executions only send the values. "{server}" in the statement stands for the server
+ * schema.
+ */
+class PreparedQuery {
+private:
+    std::string name;
+    std::string statement;
+
+public:
+    PreparedQuery(std::string name, const std::string &statement);
+
+    template <typename... Args> auto execute(const PConnection &connection, const Args &...args) const -> Result {
+        bool ownTransaction = !connection->transactionActive();
+
+        if (ownTransaction) {
+            connection->beginTransaction();
+        }
+
+        auto result = connection->execPrepared(name, statement, args...);
+
+        if (ownTransaction) {
+            connection->commitTransaction();
+        }
+
+        return result;
+    }
+};
+} // namespace Database
+
+#endif
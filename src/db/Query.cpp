@@ -20,12 +20,18 @@
 
 #include "db/Query.hpp"
 
+#include "Metrics.hpp"
 #include "db/ConnectionManager.hpp"
 
 #include <stdexcept>
 
 using namespace Database;
 
+namespace {
+auto &queryDuration = metrics::Registry::get().histogram("illarion_db_query_duration_seconds",
+                                                         "Database queries including their own transaction");
+} // namespace
+
 Query::Query() : dbConnection(ConnectionManager::getInstance().getConnection()) {}
 
 Query::Query(PConnection connection) : dbConnection(std::move(connection)) {}
@@ -40,6 +46,8 @@ auto Query::execute() -> Result {
         throw std::domain_error("Connection and query string are required to execute the query.");
     }
 
+    const metrics::Timer timer(queryDuration);
+
     bool ownTransaction = !dbConnection->transactionActive();
 
     if (ownTransaction) {
@@ -27,6 +27,7 @@
 #include <boost/cstdint.hpp>
 #include <stack>
 #include <string>
+#include <vector>
 
 namespace Database {
 class QueryWhere {
@@ -61,6 +62,19 @@ public:
                 std::string(Query::escapeAndChainKeys(table, column) + " != " + connection.quote<T>(value)));
     }
 
+    // values must not be empty
+    template <typename T>
+    void addInCondition(const std::string &table, const std::string &column, const std::vector<T> &values) {
+        conditionsStack.push(std::string(Query::escapeAndChainKeys(table, column) + " IN (" + quoteList(values) + ")"));
+    }
+
+    // values must not be empty
+    template <typename T>
+    void addNotInCondition(const std::string &table, const std::string &column, const std::vector<T> &values) {
+        conditionsStack.push(
+                std::string(Query::escapeAndChainKeys(table, column) + " NOT IN (" + quoteList(values) + ")"));
+    }
+
     void andConditions();
     void orConditions();
 
@@ -71,6 +85,20 @@ protected:
 
 private:
     void mergeConditions(const std::string &operation);
+
+    template <typename T> auto quoteList(const std::vector<T> &values) const -> std::string {
+        std::string list;
+
+        for (const auto &value : values) {
+            if (!list.empty()) {
+                list += ", ";
+            }
+
+            list += connection.quote<T>(value);
+        }
+
+        return list;
+    }
 };
 } // namespace Database
 
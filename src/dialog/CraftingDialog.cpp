@@ -23,37 +23,42 @@
 CraftingDialog::CraftingDialog(const string &title, uint16_t sfx, uint16_t sfxDuration, const luabind::object &callback)
         : Dialog(title, "CraftingDialog", callback), sfx(sfx), sfxDuration(sfxDuration) {}
 
+CraftingDialog::CraftingDialog(const CraftingDialog &dialog, const luabind::object &callback)
+        : Dialog(dialog, callback), sfx(dialog.sfx), sfxDuration(dialog.sfxDuration), content(dialog.content),
+          lastAddedCraftableId(dialog.lastAddedCraftableId) {}
+
 auto CraftingDialog::getSfx() const -> uint16_t { return sfx; }
 
 auto CraftingDialog::getSfxDuration() const -> uint16_t { return sfxDuration; }
 
 void CraftingDialog::clearGroupsAndProducts() {
-    groups.clear();
-    craftables.clear();
+    auto &edited = editContent();
+    edited.groups.clear();
+    edited.craftables.clear();
 }
 
-auto CraftingDialog::getGroupsSize() const -> index_t { return groups.size(); }
+auto CraftingDialog::getGroupsSize() const -> index_t { return content->groups.size(); }
 
-auto CraftingDialog::getGroupsBegin() const -> group_iterator { return groups.cbegin(); }
+auto CraftingDialog::getGroupsBegin() const -> group_iterator { return content->groups.cbegin(); }
 
-auto CraftingDialog::getGroupsEnd() const -> group_iterator { return groups.cend(); }
+auto CraftingDialog::getGroupsEnd() const -> group_iterator { return content->groups.cend(); }
 
 void CraftingDialog::addGroup(const string &name) {
-    if (groups.size() < maximumGroups) {
-        groups.push_back(name);
+    if (content->groups.size() < maximumGroups) {
+        editContent().groups.push_back(name);
     }
 }
 
-auto CraftingDialog::getCraftablesSize() const -> index_t { return craftables.size(); }
+auto CraftingDialog::getCraftablesSize() const -> index_t { return content->craftables.size(); }
 
-auto CraftingDialog::getCraftablesBegin() const -> craftable_iterator { return craftables.cbegin(); }
+auto CraftingDialog::getCraftablesBegin() const -> craftable_iterator { return content->craftables.cbegin(); }
 
-auto CraftingDialog::getCraftablesEnd() const -> craftable_iterator { return craftables.cend(); }
+auto CraftingDialog::getCraftablesEnd() const -> craftable_iterator { return content->craftables.cend(); }
 
 void CraftingDialog::addCraftable(uint8_t id, uint8_t group, TYPE_OF_ITEM_ID item, const string &name,
                                   uint16_t decisecondsToCraft) {
     if (canAddCraftable(group)) {
-        craftables.insert(std::make_pair(id, Craftable(group, item, name, decisecondsToCraft)));
+        editContent().craftables.insert(std::make_pair(id, Craftable(group, item, name, decisecondsToCraft)));
         lastAddedCraftableId = id;
     }
 }
@@ -61,24 +66,25 @@ void CraftingDialog::addCraftable(uint8_t id, uint8_t group, TYPE_OF_ITEM_ID ite
 void CraftingDialog::addCraftable(uint8_t id, uint8_t group, TYPE_OF_ITEM_ID item, const string &name,
                                   uint16_t decisecondsToCraft, uint8_t craftedStackSize) {
     if (canAddCraftable(group)) {
-        craftables.insert(std::make_pair(id, Craftable(group, item, name, decisecondsToCraft, craftedStackSize)));
+        editContent().craftables.insert(
+                std::make_pair(id, Craftable(group, item, name, decisecondsToCraft, craftedStackSize)));
         lastAddedCraftableId = id;
     }
 }
 
 void CraftingDialog::addCraftableIngredient(TYPE_OF_ITEM_ID item) {
-    if (!craftables.empty()) {
+    if (!content->craftables.empty()) {
         try {
-            craftables.at(lastAddedCraftableId).addIngredient(item);
+            editContent().craftables.at(lastAddedCraftableId).addIngredient(item);
         } catch (std::out_of_range &) {
         }
     }
 }
 
 void CraftingDialog::addCraftableIngredient(TYPE_OF_ITEM_ID item, uint8_t number) {
-    if (!craftables.empty()) {
+    if (!content->craftables.empty()) {
         try {
-            craftables.at(lastAddedCraftableId).addIngredient(item, number);
+            editContent().craftables.at(lastAddedCraftableId).addIngredient(item, number);
         } catch (std::out_of_range &) {
         }
     }
@@ -91,7 +97,7 @@ void CraftingDialog::setResult(Result result) { this->result = result; }
 auto CraftingDialog::getCraftableId() const -> uint8_t { return craftableId; }
 
 void CraftingDialog::setCraftableId(uint8_t index) {
-    if (craftables.find(index) != craftables.end()) {
+    if (content->craftables.find(index) != content->craftables.end()) {
         craftableId = index;
     } else {
         craftableId = 0;
@@ -108,7 +114,7 @@ void CraftingDialog::setIngredientIndex(index_t index) { ingredientIndex = index
 
 auto CraftingDialog::getCraftableTime() const -> uint16_t {
     try {
-        return craftables.at(craftableId).getDecisecondsToCraft();
+        return content->craftables.at(craftableId).getDecisecondsToCraft();
     } catch (std::out_of_range &) {
         return 0;
     }
@@ -116,6 +122,17 @@ auto CraftingDialog::getCraftableTime() const -> uint16_t {
 
 auto CraftingDialog::closeOnMove() const -> bool { return true; }
 
+auto CraftingDialog::getPayload() const -> vector<char> & { return content->payload; }
+
+auto CraftingDialog::editContent() -> Content & {
+    if (content.use_count() > 1) {
+        content = std::make_shared<Content>(*content);
+    }
+
+    content->payload.clear();
+    return *content;
+}
+
 auto CraftingDialog::canAddCraftable(uint8_t group) const -> bool {
-    return (groups.size() - 1 >= group) && (craftables.size() < maximumCraftables);
+    return (content->groups.size() - 1 >= group) && (content->craftables.size() < maximumCraftables);
 }
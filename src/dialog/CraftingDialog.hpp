@@ -25,6 +25,7 @@
 #include "dialog/Dialog.hpp"
 
 #include <map>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -106,8 +107,15 @@ private:
     static constexpr auto maximumGroups = 256;
     uint16_t sfx{};
     uint16_t sfxDuration{};
-    groups_t groups;
-    craftables_t craftables;
+
+    // shared by all copies of a dialog until one of them is changed
+    struct Content {
+        groups_t groups;
+        craftables_t craftables;
+        vector<char> payload;
+    };
+
+    std::shared_ptr<Content> content = std::make_shared<Content>();
 
     Result result{playerAborts};
 
@@ -119,6 +127,8 @@ private:
 
 public:
     CraftingDialog(const string &title, uint16_t sfx, uint16_t sfxDuration, const luabind::object &callback);
+    // opens the craftables of a dialog built once, without copying or encoding them again
+    CraftingDialog(const CraftingDialog &dialog, const luabind::object &callback);
 
     [[nodiscard]] auto getSfx() const -> uint16_t;
     [[nodiscard]] auto getSfxDuration() const -> uint16_t;
@@ -152,7 +162,11 @@ public:
 
     [[nodiscard]] auto closeOnMove() const -> bool override;
 
+    // groups and craftables as encoded for the client, empty until the first send fills it
+    [[nodiscard]] auto getPayload() const -> vector<char> &;
+
 private:
+    auto editContent() -> Content &;
     [[nodiscard]] auto canAddCraftable(uint8_t group) const -> bool;
 };
 
@@ -35,6 +35,9 @@ Dialog::Dialog(string title, string className, const luabind::object &callback)
     }
 }
 
+Dialog::Dialog(const Dialog &dialog, const luabind::object &callback)
+        : Dialog(dialog.title, dialog.className, callback) {}
+
 auto Dialog::getClassName() const -> const string & { return className; }
 
 auto Dialog::getTitle() const -> const string & { return title; }
@@ -34,6 +34,8 @@ private:
 
 public:
     Dialog(string title, string className, const luabind::object &callback);
+    // same dialog answered by another callback
+    Dialog(const Dialog &dialog, const luabind::object &callback);
     Dialog(const Dialog &dialog) = default;
     auto operator=(const Dialog &) -> Dialog & = default;
     Dialog(Dialog &&) = default;
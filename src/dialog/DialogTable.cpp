@@ -0,0 +1,86 @@
+/*
+ * Illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of Illarionserver.
+ *
+ * Illarionserver  is  free  software:  you can redistribute it and/or modify it
+ * under the terms of the  GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Illarionserver is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY;  without  even  the  implied  warranty  of  MERCHANTABILITY  or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dialog/DialogTable.hpp"
+
+#include <utility>
+
+auto DialogTable::open(std::shared_ptr<Dialog> dialog) -> Opened {
+    Opened opened;
+    Slot *free = nullptr;
+    Slot *oldest = nullptr;
+
+    for (auto &slot : slots) {
+        if (!slot.dialog) {
+            free = &slot;
+            break;
+        }
+
+        if (oldest == nullptr || slot.opened < oldest->opened) {
+            oldest = &slot;
+        }
+    }
+
+    if (free == nullptr) {
+        opened.expired = true;
+        opened.expiredId = idOf(oldest - slots.data(), *oldest);
+        release(*oldest);
+        free = oldest;
+    }
+
+    free->dialog = std::move(dialog);
+    free->opened = ++openings;
+    ++openCount;
+    opened.id = idOf(free - slots.data(), *free);
+    return opened;
+}
+
+auto DialogTable::get(Id id) const -> std::shared_ptr<Dialog> {
+    const auto *slot = find(id);
+    return slot != nullptr ? slot->dialog : nullptr;
+}
+
+void DialogTable::close(Id id) {
+    if (const auto *slot = find(id); slot != nullptr) {
+        release(slots[slot - slots.data()]);
+    }
+}
+
+auto DialogTable::idOf(size_t index, const Slot &slot) -> Id {
+    return static_cast<Id>(slot.generation << slotBits | index);
+}
+
+auto DialogTable::find(Id id) const -> const Slot * {
+    const auto index = id & ((1U << slotBits) - 1);
+
+    if (index >= capacity) {
+        return nullptr;
+    }
+
+    const auto &slot = slots[index];
+    return slot.dialog && idOf(index, slot) == id ? &slot : nullptr;
+}
+
+void DialogTable::release(Slot &slot) {
+    slot.dialog.reset();
+    // ids are sent as signed 32 bit integers
+    slot.generation = (slot.generation + 1) & ((1U << (31 - slotBits)) - 1);
+    --openCount;
+}
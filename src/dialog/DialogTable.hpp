@@ -0,0 +1,91 @@
+/*
+ * Illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of Illarionserver.
+ *
+ * Illarionserver  is  free  software:  you can redistribute it and/or modify it
+ * under the terms of the  GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Illarionserver is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY;  without  even  the  implied  warranty  of  MERCHANTABILITY  or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DIALOG_TABLE_HPP
+#define DIALOG_TABLE_HPP
+
+#include "dialog/Dialog.hpp"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// The dialogs a player has open, in a fixed number of slots. An id carries the generation of its slot, so that an
+// answer to a closed dialog never reaches a later dialog in the same slot. Once all slots are taken, the dialog
+// opened first expires to make room.
+class DialogTable {
+public:
+    using Id = unsigned int;
+    static constexpr size_t capacity = 100;
+
+    struct Opened {
+        Id id = 0;
+        // the expired dialog, if there was one
+        bool expired = false;
+        Id expiredId = 0;
+    };
+
+    auto open(std::shared_ptr<Dialog> dialog) -> Opened;
+    // null if the dialog is closed
+    [[nodiscard]] auto get(Id id) const -> std::shared_ptr<Dialog>;
+    void close(Id id);
+    // closes the dialogs for which shouldClose holds and returns their ids
+    template <typename Predicate> auto closeIf(Predicate shouldClose) -> std::vector<Id>;
+    [[nodiscard]] auto size() const -> size_t { return openCount; }
+
+private:
+    static constexpr unsigned int slotBits = 7;
+    static_assert(capacity <= (1U << slotBits));
+
+    struct Slot {
+        std::shared_ptr<Dialog> dialog;
+        uint32_t generation = 0;
+        uint64_t opened = 0;
+    };
+
+    std::array<Slot, capacity> slots{};
+    size_t openCount = 0;
+    uint64_t openings = 0;
+
+    [[nodiscard]] static auto idOf(size_t index, const Slot &slot) -> Id;
+    [[nodiscard]] auto find(Id id) const -> const Slot *;
+    void release(Slot &slot);
+};
+
+template <typename Predicate> auto DialogTable::closeIf(Predicate shouldClose) -> std::vector<Id> {
+    std::vector<Id> closed;
+
+    for (size_t index = 0; index < capacity && closed.size() < openCount; ++index) {
+        auto &slot = slots[index];
+
+        if (slot.dialog && shouldClose(*slot.dialog)) {
+            closed.push_back(idOf(index, slot));
+        }
+    }
+
+    for (const auto id : closed) {
+        close(id);
+    }
+
+    return closed;
+}
+
+#endif
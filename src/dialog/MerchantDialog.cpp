@@ -25,11 +25,14 @@
 MerchantDialog::MerchantDialog(const string &title, const luabind::object &callback)
         : Dialog(title, "MerchantDialog", callback) {}
 
-auto MerchantDialog::getOffersSize() const -> index_type { return offers.size(); }
+MerchantDialog::MerchantDialog(const MerchantDialog &dialog, const luabind::object &callback)
+        : Dialog(dialog, callback), content(dialog.content) {}
 
-auto MerchantDialog::getOffersBegin() const -> offer_iterator { return offers.cbegin(); }
+auto MerchantDialog::getOffersSize() const -> index_type { return content->offers.size(); }
 
-auto MerchantDialog::getOffersEnd() const -> offer_iterator { return offers.cend(); }
+auto MerchantDialog::getOffersBegin() const -> offer_iterator { return content->offers.cbegin(); }
+
+auto MerchantDialog::getOffersEnd() const -> offer_iterator { return content->offers.cend(); }
 
 void MerchantDialog::addOffer(TYPE_OF_ITEM_ID item, const string &name, TYPE_OF_WORTH price) {
     const auto &itemStruct = Data::items()[item];
@@ -38,30 +41,38 @@ void MerchantDialog::addOffer(TYPE_OF_ITEM_ID item, const string &name, TYPE_OF_
 
 void MerchantDialog::addOffer(TYPE_OF_ITEM_ID item, const string &name, TYPE_OF_WORTH price, TYPE_OF_BUY_STACK stack) {
     if (canAddOffer()) {
-        offers.emplace_back(item, name, price, stack);
+        editContent().offers.emplace_back(item, name, price, stack);
     }
 }
 
-auto MerchantDialog::getPrimaryRequestsSize() const -> index_type { return getProductsSize(primaryRequests); }
+auto MerchantDialog::getPrimaryRequestsSize() const -> index_type { return getProductsSize(content->primaryRequests); }
 
-auto MerchantDialog::getPrimaryRequestsBegin() const -> product_iterator { return getProductsBegin(primaryRequests); }
+auto MerchantDialog::getPrimaryRequestsBegin() const -> product_iterator {
+    return getProductsBegin(content->primaryRequests);
+}
 
-auto MerchantDialog::getPrimaryRequestsEnd() const -> product_iterator { return getProductsEnd(primaryRequests); }
+auto MerchantDialog::getPrimaryRequestsEnd() const -> product_iterator {
+    return getProductsEnd(content->primaryRequests);
+}
 
 void MerchantDialog::addPrimaryRequest(TYPE_OF_ITEM_ID item, const string &name, TYPE_OF_WORTH price) {
-    addProduct(primaryRequests, item, name, price);
+    addProduct(editContent().primaryRequests, item, name, price);
 }
 
-auto MerchantDialog::getSecondaryRequestsSize() const -> index_type { return getProductsSize(secondaryRequests); }
+auto MerchantDialog::getSecondaryRequestsSize() const -> index_type {
+    return getProductsSize(content->secondaryRequests);
+}
 
 auto MerchantDialog::getSecondaryRequestsBegin() const -> product_iterator {
-    return getProductsBegin(secondaryRequests);
+    return getProductsBegin(content->secondaryRequests);
 }
 
-auto MerchantDialog::getSecondaryRequestsEnd() const -> product_iterator { return getProductsEnd(secondaryRequests); }
+auto MerchantDialog::getSecondaryRequestsEnd() const -> product_iterator {
+    return getProductsEnd(content->secondaryRequests);
+}
 
 void MerchantDialog::addSecondaryRequest(TYPE_OF_ITEM_ID item, const string &name, TYPE_OF_WORTH price) {
-    addProduct(secondaryRequests, item, name, price);
+    addProduct(editContent().secondaryRequests, item, name, price);
 }
 
 auto MerchantDialog::getResult() const -> Result { return result; }
@@ -86,6 +97,17 @@ void MerchantDialog::setLookAtList(ListType list) { lookAtList = list; }
 
 auto MerchantDialog::closeOnMove() const -> bool { return true; }
 
+auto MerchantDialog::getPayload() const -> vector<char> & { return content->payload; }
+
+auto MerchantDialog::editContent() -> Content & {
+    if (content.use_count() > 1) {
+        content = std::make_shared<Content>(*content);
+    }
+
+    content->payload.clear();
+    return *content;
+}
+
 auto MerchantDialog::getProductsSize(const product_list &products) -> index_type { return products.size(); }
 
 auto MerchantDialog::getProductsBegin(const product_list &products) -> product_iterator { return products.cbegin(); }
@@ -98,6 +120,6 @@ void MerchantDialog::addProduct(product_list &products, TYPE_OF_ITEM_ID item, co
     }
 }
 
-auto MerchantDialog::canAddOffer() const -> bool { return offers.size() < MAXPRODUCTS; }
+auto MerchantDialog::canAddOffer() const -> bool { return content->offers.size() < MAXPRODUCTS; }
 
 auto MerchantDialog::canAddProduct(const product_list &products) -> bool { return products.size() < MAXPRODUCTS; }
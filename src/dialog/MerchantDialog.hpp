@@ -24,6 +24,7 @@
 #include "Item.hpp"
 #include "dialog/Dialog.hpp"
 
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -66,9 +67,16 @@ public:
 
 private:
     static const uint32_t MAXPRODUCTS = 256;
-    offer_list offers;
-    product_list primaryRequests;
-    product_list secondaryRequests;
+
+    // shared by all copies of a dialog until one of them is changed
+    struct Content {
+        offer_list offers;
+        product_list primaryRequests;
+        product_list secondaryRequests;
+        vector<char> payload;
+    };
+
+    std::shared_ptr<Content> content = std::make_shared<Content>();
 
     Result result{playerAborts};
 
@@ -81,6 +89,8 @@ private:
 
 public:
     MerchantDialog(const string &title, const luabind::object &callback);
+    // opens the products of a dialog built once, without copying or encoding them again
+    MerchantDialog(const MerchantDialog &dialog, const luabind::object &callback);
 
     auto getOffersSize() const -> index_type;
     auto getOffersBegin() const -> offer_iterator;
@@ -114,7 +124,11 @@ public:
 
     auto closeOnMove() const -> bool override;
 
+    // the products as encoded for the client, empty until the first send fills it
+    [[nodiscard]] auto getPayload() const -> vector<char> &;
+
 private:
+    auto editContent() -> Content &;
     static auto getProductsSize(const product_list &products) -> index_type;
     static auto getProductsBegin(const product_list &products) -> product_iterator;
     static auto getProductsEnd(const product_list &products) -> product_iterator;
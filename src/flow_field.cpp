@@ -0,0 +1,190 @@
+/*
+ * Illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of Illarionserver.
+ *
+ * Illarionserver  is  free  software:  you can redistribute it and/or modify it
+ * under the terms of the  GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Illarionserver is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY;  without  even  the  implied  warranty  of  MERCHANTABILITY  or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "flow_field.hpp"
+
+#include "World.hpp"
+#include "map/Field.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace pathfinding {
+
+namespace {
+
+using Cost = float;
+using Clock = std::chrono::steady_clock;
+
+constexpr int flowRadius = 12;
+constexpr int flowWidth = 2 * flowRadius + 1;
+constexpr int flowArea = flowWidth * flowWidth;
+// a moving goal gets a new field anyway, changes of the map are picked up after this
+constexpr auto flowLifetime = std::chrono::seconds(1);
+constexpr auto unreached = std::numeric_limits<Cost>::max();
+
+struct Move {
+    int dx;
+    int dy;
+};
+
+// indexed by direction
+constexpr std::array<Move, maxDirection + 1> moves = {
+        {{0, -1}, {1, -1}, {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}}};
+
+struct FlowField {
+    Clock::time_point built;
+    // cost of walking from a field of the window centred on the goal to the goal
+    std::array<Cost, flowArea> distances;
+};
+
+auto indexOf(int dx, int dy) -> int { return (dy + flowRadius) * flowWidth + dx + flowRadius; }
+
+auto buildField(const ::position &goal) -> FlowField {
+    FlowField field;
+    field.built = Clock::now();
+    field.distances.fill(unreached);
+
+    std::array<Cost, flowArea> costs{};
+    std::array<bool, flowArea> walkable{};
+
+    for (int dy = -flowRadius; dy <= flowRadius; ++dy) {
+        for (int dx = -flowRadius; dx <= flowRadius; ++dx) {
+            try {
+                const auto &mapField = World::get()->fieldAt(::position(goal.x + dx, goal.y + dy, goal.z));
+                walkable[indexOf(dx, dy)] = mapField.isWalkable();
+                costs[indexOf(dx, dy)] = mapField.getMovementCost();
+            } catch (FieldNotFound &) {
+            }
+        }
+    }
+
+    // walking from a field into the next one costs what entering the next one does
+    using Candidate = std::pair<Cost, int>;
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<>> open;
+    const auto goalIndex = indexOf(0, 0);
+    field.distances[goalIndex] = 0;
+    open.emplace(0, goalIndex);
+
+    while (!open.empty()) {
+        const auto [distance, index] = open.top();
+        open.pop();
+
+        if (distance > field.distances[index]) {
+            continue;
+        }
+
+        const int x = index % flowWidth - flowRadius;
+        const int y = index / flowWidth - flowRadius;
+        const Cost entering = index == goalIndex ? 1 : costs[index];
+
+        for (const auto &move : moves) {
+            const int nextX = x + move.dx;
+            const int nextY = y + move.dy;
+
+            if (std::abs(nextX) > flowRadius || std::abs(nextY) > flowRadius) {
+                continue;
+            }
+
+            const auto next = indexOf(nextX, nextY);
+
+            if (walkable[next] && distance + entering < field.distances[next]) {
+                field.distances[next] = distance + entering;
+                open.emplace(field.distances[next], next);
+            }
+        }
+    }
+
+    return field;
+}
+
+auto fieldFor(const ::position &goal) -> const FlowField & {
+    static std::unordered_map<::position, FlowField> fields;
+    const auto now = Clock::now();
+    auto field = fields.find(goal);
+
+    if (field != fields.end() && now - field->second.built < flowLifetime) {
+        return field->second;
+    }
+
+    for (auto it = fields.begin(); it != fields.end();) {
+        if (now - it->second.built >= flowLifetime) {
+            it = fields.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    return fields.insert_or_assign(goal, buildField(goal)).first->second;
+}
+
+auto moveToPossible(const ::position &pos) -> bool {
+    try {
+        return World::get()->fieldAt(pos).moveToPossible();
+    } catch (FieldNotFound &) {
+        return false;
+    }
+}
+
+} // namespace
+
+auto flow_direction(const ::position &start_pos, const ::position &goal_pos, direction &dir) -> bool {
+    const int dx = start_pos.x - goal_pos.x;
+    const int dy = start_pos.y - goal_pos.y;
+
+    if (start_pos.z != goal_pos.z || std::max(std::abs(dx), std::abs(dy)) <= 1 || std::abs(dx) > flowRadius ||
+        std::abs(dy) > flowRadius) {
+        return false;
+    }
+
+    const auto &field = fieldFor(goal_pos);
+    Cost best = field.distances[indexOf(dx, dy)];
+    bool found = false;
+
+    for (int i = minDirection; i <= maxDirection; ++i) {
+        const int nextX = dx + moves[i].dx;
+        const int nextY = dy + moves[i].dy;
+
+        if (std::abs(nextX) > flowRadius || std::abs(nextY) > flowRadius) {
+            continue;
+        }
+
+        const auto distance = field.distances[indexOf(nextX, nextY)];
+
+        // other characters are not part of the field, so they are only avoided here
+        if (distance < best && moveToPossible(::position(goal_pos.x + nextX, goal_pos.y + nextY, goal_pos.z))) {
+            best = distance;
+            dir = direction(i);
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+} // namespace pathfinding
@@ -0,0 +1,36 @@
+/*
+ * Illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of Illarionserver.
+ *
+ * Illarionserver  is  free  software:  you can redistribute it and/or modify it
+ * under the terms of the  GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Illarionserver is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY;  without  even  the  implied  warranty  of  MERCHANTABILITY  or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FLOW_FIELD_HPP
+#define FLOW_FIELD_HPP
+
+#include "globals.hpp"
+#include "types.hpp"
+
+namespace pathfinding {
+
+// first step from start towards a goal close by, read from a map of distances to the goal that is shared by all
+// characters heading there and kept for a short while; fails if the goal is out of range, already adjacent or every
+// step towards it is blocked, game thread only
+auto flow_direction(const ::position &start_pos, const ::position &goal_pos, direction &dir) -> bool;
+
+} // namespace pathfinding
+
+#endif
@@ -31,15 +31,32 @@
 struct FieldNotFound : std::exception {};
 struct MapError : std::exception {};
 
-struct position {
-    Coordinate x;
-    Coordinate y;
-    Coordinate z;
+// packed into eight bytes, so that hashing and comparing work on a single integer
+struct alignas(uint64_t) position {
+    int16_t x;
+    int16_t y;
+    int16_t z;
 
     position() = default;
-    position(Coordinate x, Coordinate y, Coordinate z) : x(x), y(y), z(z) {}
+    position(Coordinate x, Coordinate y, Coordinate z)
+            : x(static_cast<int16_t>(x)), y(static_cast<int16_t>(y)), z(static_cast<int16_t>(z)) {}
+
+    // ordered by x, then y, then z
+    [[nodiscard]] auto key() const -> uint64_t {
+        constexpr uint16_t signBit = 0x8000;
+        constexpr int yShift = 16;
+        constexpr int xShift = 32;
+        return uint64_t(uint16_t(x) ^ signBit) << xShift | uint64_t(uint16_t(y) ^ signBit) << yShift |
+               (uint16_t(z) ^ signBit);
+    }
 
-    auto operator==(const position &pos) const -> bool { return (x == pos.x && y == pos.y && z == pos.z); }
+    auto operator==(const position &pos) const -> bool { return key() == pos.key(); }
+    auto operator!=(const position &pos) const -> bool { return key() != pos.key(); }
+
+    // negative, zero or positive like strcmp
+    friend auto compare(const position &lhs, const position &rhs) -> int {
+        return lhs.key() < rhs.key() ? -1 : (lhs.key() == rhs.key() ? 0 : 1);
+    }
 
     void move(direction dir) {
         switch (dir) {
@@ -91,26 +108,19 @@ struct position {
         return out;
     }
 
+    // Fibonacci hashing spreads neighbouring positions, which differ only in their low bits
     friend auto hash_value(const position &p) -> std::size_t {
-        std::size_t seed = 0;
-        boost::hash_combine(seed, p.x);
-        boost::hash_combine(seed, p.y);
-        boost::hash_combine(seed, p.z);
-
-        return seed;
+        constexpr uint64_t golden = 0x9e3779b97f4a7c15;
+        constexpr int halfShift = 32;
+        const uint64_t hash = p.key() * golden;
+        return static_cast<std::size_t>(hash ^ (hash >> halfShift));
     }
 };
 
+static_assert(sizeof(position) == sizeof(uint64_t));
+
 struct PositionComparison {
-    auto operator()(const position &pos1, const position &pos2) const -> bool {
-        if (pos1.x == pos2.x) {
-            if (pos1.y == pos2.y) {
-                return pos1.z < pos2.z;
-            }
-            return pos1.y < pos2.y;
-        }
-        return pos1.x < pos2.x;
-    }
+    auto operator()(const position &pos1, const position &pos2) const -> bool { return pos1.key() < pos2.key(); }
 };
 
 namespace std {
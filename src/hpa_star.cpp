@@ -0,0 +1,393 @@
+/*
+ * Illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of Illarionserver.
+ *
+ * Illarionserver  is  free  software:  you can redistribute it and/or modify it
+ * under the terms of the  GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Illarionserver is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY;  without  even  the  implied  warranty  of  MERCHANTABILITY  or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "hpa_star.hpp"
+
+#include "World.hpp"
+#include "a_star.hpp"
+#include "map/ChunkVersions.hpp"
+#include "map/Field.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace pathfinding {
+
+namespace {
+
+using map::ChunkVersions;
+
+// clusters are the chunks of ChunkVersions, so their versions tell when a cluster has to be rebuilt
+constexpr int clusterBits = ChunkVersions::chunkBits;
+constexpr int clusterSize = 1 << clusterBits;
+constexpr int clusterArea = clusterSize * clusterSize;
+// routes within this distance are searched directly, longer ones are refined up to this distance
+constexpr int refineRadius = 24;
+constexpr auto maximumAbstractNodes = 4096;
+constexpr auto unreached = std::numeric_limits<Cost>::max();
+
+struct Entrance {
+    ::position pos;
+    // entrance of the neighbouring cluster on the other side of the border
+    ::position across;
+    Cost crossing;
+    // other entrances of the cluster and the cost of reaching them
+    std::vector<std::pair<size_t, Cost>> paths;
+};
+
+struct Cluster {
+    // of the cluster itself and its four neighbours, whose border fields decide the entrances as well
+    std::array<ChunkVersions::Version, 5> versions;
+    std::vector<Entrance> entrances;
+};
+
+struct Cell {
+    bool walkable = false;
+    Cost cost = 1;
+};
+
+using Cells = std::array<Cell, clusterArea>;
+
+auto originOf(const ::position &pos) -> ::position {
+    return {Coordinate((pos.x >> clusterBits) << clusterBits), Coordinate((pos.y >> clusterBits) << clusterBits),
+            pos.z};
+}
+
+auto cellAt(const ::position &pos) -> Cell {
+    try {
+        const auto &field = World::get()->fieldAt(pos);
+        return {field.isWalkable(), Cost(field.getMovementCost())};
+    } catch (FieldNotFound &) {
+        return {};
+    }
+}
+
+auto versionsAround(const ::position &origin) -> std::array<ChunkVersions::Version, 5> {
+    const auto &versions = ChunkVersions::get();
+    const auto versionAt = [&versions, &origin](int dx, int dy) {
+        return versions.of(ChunkVersions::chunkKey(::position(Coordinate(origin.x + dx * clusterSize),
+                                                              Coordinate(origin.y + dy * clusterSize), origin.z)));
+    };
+
+    return {versionAt(0, 0), versionAt(0, -1), versionAt(1, 0), versionAt(0, 1), versionAt(-1, 0)};
+}
+
+// cheapest costs from the local cell to every cell of the cluster, the start need not be walkable
+auto distancesFrom(const Cells &cells, int start) -> std::array<Cost, clusterArea> {
+    std::array<Cost, clusterArea> distances;
+    distances.fill(unreached);
+    distances[start] = 0;
+
+    using Candidate = std::pair<Cost, int>;
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<>> open;
+    open.emplace(0, start);
+
+    while (!open.empty()) {
+        const auto [distance, cell] = open.top();
+        open.pop();
+
+        if (distance > distances[cell]) {
+            continue;
+        }
+
+        const int x = cell % clusterSize;
+        const int y = cell / clusterSize;
+
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                const int nextX = x + dx;
+                const int nextY = y + dy;
+
+                if ((dx == 0 && dy == 0) || nextX < 0 || nextY < 0 || nextX >= clusterSize || nextY >= clusterSize) {
+                    continue;
+                }
+
+                const int next = nextY * clusterSize + nextX;
+
+                if (!cells[next].walkable) {
+                    continue;
+                }
+
+                const Cost nextDistance = distance + cells[next].cost;
+
+                if (nextDistance < distances[next]) {
+                    distances[next] = nextDistance;
+                    open.emplace(nextDistance, next);
+                }
+            }
+        }
+    }
+
+    return distances;
+}
+
+auto localIndex(const ::position &origin, const ::position &pos) -> int {
+    return (pos.y - origin.y) * clusterSize + (pos.x - origin.x);
+}
+
+auto cellsOf(const ::position &origin) -> Cells {
+    Cells cells;
+
+    for (int y = 0; y < clusterSize; ++y) {
+        for (int x = 0; x < clusterSize; ++x) {
+            cells[y * clusterSize + x] =
+                    cellAt(::position(Coordinate(origin.x + x), Coordinate(origin.y + y), origin.z));
+        }
+    }
+
+    return cells;
+}
+
+// each run of fields walkable on both sides of a border gets one entrance in its middle, the neighbour finds the
+// same runs, so entrances always come in pairs
+auto buildCluster(const ::position &origin, const std::array<ChunkVersions::Version, 5> &versions) -> Cluster {
+    Cluster cluster;
+    cluster.versions = versions;
+    const auto cells = cellsOf(origin);
+
+    struct Side {
+        int x, y, stepX, stepY, outX, outY;
+    };
+
+    constexpr int last = clusterSize - 1;
+    constexpr std::array<Side, 4> sides = {{{0, 0, 1, 0, 0, -1},
+                                            {last, 0, 0, 1, 1, 0},
+                                            {0, last, 1, 0, 0, 1},
+                                            {0, 0, 0, 1, -1, 0}}};
+
+    for (const auto &side : sides) {
+        int runStart = -1;
+
+        for (int i = 0; i <= clusterSize; ++i) {
+            bool open = false;
+            const int x = side.x + i * side.stepX;
+            const int y = side.y + i * side.stepY;
+
+            if (i < clusterSize && cells[y * clusterSize + x].walkable) {
+                open = cellAt(::position(Coordinate(origin.x + x + side.outX), Coordinate(origin.y + y + side.outY),
+                                         origin.z))
+                               .walkable;
+            }
+
+            if (open && runStart < 0) {
+                runStart = i;
+            } else if (!open && runStart >= 0) {
+                const int middle = (runStart + i - 1) / 2;
+                const ::position pos(Coordinate(origin.x + side.x + middle * side.stepX),
+                                     Coordinate(origin.y + side.y + middle * side.stepY), origin.z);
+                const ::position across(Coordinate(pos.x + side.outX), Coordinate(pos.y + side.outY), origin.z);
+                cluster.entrances.push_back({pos, across, cellAt(across).cost, {}});
+                runStart = -1;
+            }
+        }
+    }
+
+    for (auto &entrance : cluster.entrances) {
+        const auto distances = distancesFrom(cells, localIndex(origin, entrance.pos));
+
+        for (size_t other = 0; other < cluster.entrances.size(); ++other) {
+            const auto distance = distances[localIndex(origin, cluster.entrances[other].pos)];
+
+            if (&cluster.entrances[other] != &entrance && distance != unreached) {
+                entrance.paths.emplace_back(other, distance);
+            }
+        }
+    }
+
+    return cluster;
+}
+
+// clusters are only rebuilt between searches, so references stay valid during one
+auto clusterAt(const ::position &pos) -> const Cluster & {
+    static std::unordered_map<ChunkVersions::ChunkKey, Cluster> clusters;
+    const auto origin = originOf(pos);
+    const auto key = ChunkVersions::chunkKey(origin);
+    auto versions = versionsAround(origin);
+    auto cluster = clusters.find(key);
+
+    if (cluster == clusters.end() || cluster->second.versions != versions) {
+        cluster = clusters.insert_or_assign(key, buildCluster(origin, versions)).first;
+    }
+
+    return cluster->second;
+}
+
+auto distanceBetween(const ::position &from, const ::position &to) -> int {
+    return std::max(std::abs(to.x - from.x), std::abs(to.y - from.y));
+}
+
+auto heuristic(const ::position &from, const ::position &to) -> Cost {
+    const Cost dx = to.x - from.x;
+    const Cost dy = to.y - from.y;
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+// costs from pos to the entrances of its cluster
+auto entranceDistances(const ::position &pos, const Cluster &cluster) -> std::vector<Cost> {
+    const auto origin = originOf(pos);
+    const auto distances = distancesFrom(cellsOf(origin), localIndex(origin, pos));
+    std::vector<Cost> result;
+    result.reserve(cluster.entrances.size());
+
+    for (const auto &entrance : cluster.entrances) {
+        result.push_back(distances[localIndex(origin, entrance.pos)]);
+    }
+
+    return result;
+}
+
+// the abstract route from start to goal, start excluded and goal included
+auto abstractRoute(const ::position &start, const ::position &goal) -> std::vector<::position> {
+    using NodeKey = uint64_t;
+    constexpr int indexBits = 8;
+    constexpr NodeKey goalKey = std::numeric_limits<NodeKey>::max();
+    constexpr NodeKey noParent = goalKey - 1;
+    const auto keyOf = [](const ::position &pos, size_t index) {
+        return (ChunkVersions::chunkKey(originOf(pos)) << indexBits) | index;
+    };
+
+    struct Node {
+        ::position pos;
+        Cost distance;
+        NodeKey parent;
+        const Entrance *entrance;
+    };
+
+    const auto &startCluster = clusterAt(start);
+    const auto goalOrigin = originOf(goal);
+    const auto startDistances = entranceDistances(start, startCluster);
+    const auto goalDistances = entranceDistances(goal, clusterAt(goal));
+
+    std::unordered_map<NodeKey, Node> nodes;
+    using Candidate = std::pair<Cost, NodeKey>;
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<>> open;
+
+    const auto reach = [&](NodeKey key, const ::position &pos, const Entrance *entrance, Cost distance,
+                           NodeKey parent) {
+        const auto node = nodes.find(key);
+
+        if (node == nodes.end() || distance < node->second.distance) {
+            nodes.insert_or_assign(key, Node{pos, distance, parent, entrance});
+            open.emplace(distance + heuristic(pos, goal), key);
+        }
+    };
+
+    for (size_t i = 0; i < startCluster.entrances.size(); ++i) {
+        if (startDistances[i] != unreached) {
+            const auto &entrance = startCluster.entrances[i];
+            reach(keyOf(entrance.pos, i), entrance.pos, &entrance, startDistances[i], noParent);
+        }
+    }
+
+    while (!open.empty() && nodes.size() <= maximumAbstractNodes) {
+        const auto [rank, key] = open.top();
+        open.pop();
+        const auto node = nodes.at(key);
+
+        if (rank > node.distance + heuristic(node.pos, goal)) {
+            continue;
+        }
+
+        if (key == goalKey) {
+            std::vector<::position> route;
+
+            for (auto step = key; step != noParent; step = nodes.at(step).parent) {
+                route.push_back(nodes.at(step).pos);
+            }
+
+            std::reverse(route.begin(), route.end());
+            return route;
+        }
+
+        const auto &cluster = clusterAt(node.pos);
+        const auto index = size_t(key & ((NodeKey(1) << indexBits) - 1));
+
+        if (originOf(node.pos) == goalOrigin && goalDistances[index] != unreached) {
+            reach(goalKey, goal, nullptr, node.distance + goalDistances[index], key);
+        }
+
+        for (const auto &[other, cost] : node.entrance->paths) {
+            const auto &entrance = cluster.entrances[other];
+            reach(keyOf(entrance.pos, other), entrance.pos, &entrance, node.distance + cost, key);
+        }
+
+        const auto &neighbour = clusterAt(node.entrance->across);
+
+        for (size_t other = 0; other < neighbour.entrances.size(); ++other) {
+            const auto &entrance = neighbour.entrances[other];
+
+            if (entrance.pos == node.entrance->across && entrance.across == node.pos) {
+                reach(keyOf(entrance.pos, other), entrance.pos, &entrance, node.distance + node.entrance->crossing,
+                      key);
+            }
+        }
+    }
+
+    return {};
+}
+
+} // namespace
+
+auto route_target(const ::position &start_pos, const ::position &goal_pos, ::position &target) -> bool {
+    if (start_pos.z != goal_pos.z || distanceBetween(start_pos, goal_pos) <= refineRadius) {
+        target = goal_pos;
+        return true;
+    }
+
+    const auto route = abstractRoute(start_pos, goal_pos);
+
+    if (route.empty()) {
+        return false;
+    }
+
+    target = route.front();
+
+    for (const auto &pos : route) {
+        if (distanceBetween(start_pos, pos) > refineRadius) {
+            break;
+        }
+
+        target = pos;
+    }
+
+    return true;
+}
+
+auto hpa_star(const ::position &start_pos, const ::position &goal_pos, std::list<direction> &steps) -> bool {
+    ::position target;
+
+    if (!route_target(start_pos, goal_pos, target)) {
+        steps.clear();
+        return false;
+    }
+
+    return a_star(start_pos, target, steps);
+}
+
+} // namespace pathfinding
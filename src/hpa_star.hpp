@@ -0,0 +1,39 @@
+/*
+ * Illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of Illarionserver.
+ *
+ * Illarionserver  is  free  software:  you can redistribute it and/or modify it
+ * under the terms of the  GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Illarionserver is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY;  without  even  the  implied  warranty  of  MERCHANTABILITY  or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HPA_STAR_HPP
+#define HPA_STAR_HPP
+
+#include "globals.hpp"
+#include "types.hpp"
+
+#include <list>
+
+namespace pathfinding {
+
+// like a_star, but routes beyond the reach of a plain search over a graph of map chunks joined where their borders
+// are walkable; steps then only lead to a point of that route near the start, game thread only
+// the point up to which hpa_star refines the route, the goal itself for short routes
+auto route_target(const ::position &start_pos, const ::position &goal_pos, ::position &target) -> bool;
+auto hpa_star(const ::position &start_pos, const ::position &goal_pos, std::list<direction> &steps) -> bool;
+
+} // namespace pathfinding
+
+#endif
@@ -19,26 +19,41 @@
  */
 
 #include "Config.hpp"
+#include "HugePages.hpp"
 #include "InitialConnection.hpp"
 #include "Logger.hpp"
+#include "Metrics.hpp"
 #include "MonitoringClients.hpp"
 #include "Player.hpp"
 #include "PlayerManager.hpp"
+#include "Random.hpp"
+#include "SamplingProfiler.hpp"
+#include "StartupGraph.hpp"
+#include "ThreadAffinity.hpp"
+#include "TickClock.hpp"
+#include "Watchdog.hpp"
 #include "World.hpp"
 #include "constants.hpp"
 #include "data/Data.hpp"
 #include "data/ScriptVariablesTable.hpp"
+#include "db/AsyncExecutor.hpp"
 #include "db/ConnectionManager.hpp"
 #include "db/SchemaHelper.hpp"
 #include "main_help.hpp"
+#include "map/FieldWriteQueue.hpp"
+#include "netinterface/SessionRecording.hpp"
 #include "netinterface/protocol/BBIWIServerCommands.hpp"
 #include "netinterface/protocol/ServerCommands.hpp"
+#include "path_service.hpp"
+#include "script/LuaCollector.hpp"
 #include "script/LuaReloadScript.hpp"
 #include "script/server.hpp"
 #include "tuningConstants.hpp"
 #include "version.hpp"
 
+#include <chrono>
 #include <memory>
+#include <random>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -61,40 +76,91 @@ auto main(int argc, char *argv[]) -> int {
         return 1;
     }
 
+    if (!Logger::setLevels(Config::instance().log_levels)) {
+        Logger::warn(LogFacility::Other) << "main: invalid log_levels: " << Config::instance().log_levels() << Log::end;
+    }
+
     Logger::info(LogFacility::Other) << "main: server requires clientversion: " << Config::instance().clientversion
                                      << Log::end;
     Logger::info(LogFacility::Other) << "main: listen port: " << Config::instance().port << Log::end;
     Logger::info(LogFacility::Other) << "main: data directory: " << Config::instance().datadir() << Log::end;
     Logger::notice(LogFacility::Script) << "Initialising script log ..." << Log::end;
 
-    // initialise DB Manager
-    Database::ConnectionManager::getInstance().setupManager();
-    Database::SchemaHelper::setSchemata();
+    // before anything is loaded, so that the world is allocated on the node of the game thread; the startup threads
+    // inherit both settings
+    affinity::pinCurrentThread(Config::instance().game_thread_cores(), "game");
 
-    std::unique_ptr<World> world(World::create());
-
-    Data::preReload();
+    if (Config::instance().numa_local_world) {
+        affinity::preferLocalMemory();
+    }
 
-    if (!Data::skills().reloadBuffer()) {
-        Logger::critical(LogFacility::Other) << "failed to initialise skills" << Log::end;
-        return 1;
+    if (!hugepages::configure(Config::instance().huge_pages)) {
+        Logger::warn(LogFacility::Other) << "main: invalid huge_pages: " << Config::instance().huge_pages() << Log::end;
     }
 
-    Data::skills().activateBuffer();
+    // the listener opens right away, logins wait in a queue until the server is running
+    PlayerManager::get().startLogins();
 
-    if (!Data::reloadTables()) {
-        Logger::critical(LogFacility::Other) << "failed to initialise tables" << Log::end;
-        return 1;
-    }
+    std::unique_ptr<World> world;
+    StartupGraph startup;
 
-    Data::activateTables();
-    loadData();
+    startup.add("database", {}, [] {
+        Database::ConnectionManager::getInstance().setupManager();
+        Database::SchemaHelper::setSchemata();
+        return true;
+    });
+
+    startup.add("world", {"database"}, [&world] {
+        world.reset(World::create());
+        return true;
+    });
+
+    startup.add("pre-reload", {}, [] {
+        Data::preReload();
+        return true;
+    });
+
+    startup.add("skills", {"database", "pre-reload"}, [] {
+        if (!Data::skills().reloadBuffer()) {
+            Logger::critical(LogFacility::Other) << "failed to initialise skills" << Log::end;
+            return false;
+        }
+
+        Data::skills().activateBuffer();
+        return true;
+    });
+
+    startup.add("tables", {"database", "pre-reload"}, [] {
+        if (!Data::reloadTables()) {
+            Logger::critical(LogFacility::Other) << "failed to initialise tables" << Log::end;
+            return false;
+        }
 
-    world->Load();
+        Data::activateTables();
+        return true;
+    });
+
+    // fields only read the table rows, while scripts are kept apart from them, so maps and scripts load side by side
+    startup.add("maps", {"world", "tables"}, [&world] {
+        world->Load();
+        return true;
+    });
+
+    // compiles the scripts without running any entry point, the only stage using Lua
+    startup.add("scripts", {"world", "skills", "tables"}, [] {
+        loadData();
+        Data::reloadScripts();
+        return true;
+    });
+
+    if (!startup.run()) {
+        Logger::critical(LogFacility::Other) << "failed to start the server" << Log::end;
+        PlayerManager::get().stop();
+        return 1;
+    }
 
-    Data::reloadScripts();
+    metrics::startExporter(Config::instance().metrics_port);
 
-    Logger::info(LogFacility::Other) << "create PlayerManager" << Log::end;
     PlayerManager::get().activate();
     Logger::info(LogFacility::Other) << "PlayerManager activated" << Log::end;
     PlayerManager::TPLAYERVECTOR &newplayers = PlayerManager::get().getLogInPlayers();
@@ -111,17 +177,33 @@ auto main(int argc, char *argv[]) -> int {
     world->initScheduler();
 
     running = true;
+    PlayerManager::get().openLogins();
+    Watchdog::get().start(std::chrono::seconds(Config::instance().watchdog_threshold()),
+                          Config::instance().watchdog_monitoring);
+    SamplingProfiler::get().start(Config::instance().profile_frequency);
+
+    if (const std::string recording = Config::instance().session_recording; !recording.empty()) {
+        const auto seed = std::random_device{}();
+        Random::seed(seed);
+
+        if (!SessionRecorder::get().start(recording, seed)) {
+            Logger::error(LogFacility::Other) << "could not record sessions to " << recording << Log::end;
+        }
+    }
 
     Logger::info(LogFacility::Other) << "Illarion is operational!" << Log::end;
 
     while (running) {
+        Watchdog::get().heartbeat();
+        PlayerManager::get().admitWaitingLogins();
         // make sure we don't block the server with processing new players...
         int new_players_processed = 0;
 
         // process new players from connection thread
-        while (!newplayers.empty() && new_players_processed < MAXPLAYERSPROCESSED) {
+        Player *newPlayer = nullptr;
+
+        while (new_players_processed < MAXPLAYERSPROCESSED && newplayers.tryPop(newPlayer)) {
             new_players_processed++;
-            Player *newPlayer = newplayers.pop_front();
 
             if (newPlayer != nullptr) {
                 login_save(newPlayer);
@@ -131,23 +213,41 @@ auto main(int argc, char *argv[]) -> int {
                 } else {
                     try {
                         world->Players.insert(newPlayer);
+                        world->Observers.add(newPlayer);
                         newPlayer->login();
+                        SessionRecorder::get().login(newPlayer->getId(), newPlayer->getPosition());
                         script::server::login().onLogin(newPlayer);
-                        world->updatePlayerList();
+                        World::addToPlayerList(newPlayer->getId());
                     } catch (Player::LogoutException &e) {
                         ServerCommandPointer cmd = std::make_shared<LogOutTC>(e.getReason());
                         newPlayer->Connection->shutdownSend(cmd);
-                        PlayerManager::get().getLogOutPlayers().push_back(newPlayer);
+                        PlayerManager::get().addLogOutPlayer(newPlayer);
                     }
                 }
             }
         }
 
-        // run scheduler until next task or for 25ms
-        world->scheduler.run_once(std::chrono::seconds(1));
+        // logins left over for the next round must not wait for the next task
+        if (!newplayers.empty()) {
+            world->scheduler.signal();
+        }
+
+        // idle time before the next task goes to the Lua collector, unless logins are still waiting
+        if (newplayers.empty()) {
+            LuaCollector::get().step(LuaScript::getLuaState(), world->scheduler.getNextTaskTime());
+        }
+
+        // sleeps until the next task is due or logins or player commands signal the scheduler
+        world->scheduler.run_once(maxIdleWait);
+        TickClock::update();
         world->checkPlayerImmediateCommands();
+        world->flushAttributeUpdates();
+        world->flushCharacterMoves();
     }
 
+    Watchdog::get().stop();
+    SamplingProfiler::get().stop();
+    SessionRecorder::get().stop();
     Logger::info(LogFacility::Other) << "Stopping Illarion!" << Log::end;
 
     Data::scriptVariables().save();
@@ -156,12 +256,22 @@ auto main(int argc, char *argv[]) -> int {
     world->forceLogoutOfAllPlayers();
     PlayerManager::get().stop();
     world->takeMonsterAndNPCFromMap();
+    pathfinding::PathService::get().stop();
 
     world->Save();
 
+    map::FieldWriteQueue::get().stop();
+    Logger::info(LogFacility::Other) << "Persistent fields saved!" << Log::end;
+
+    Database::AsyncExecutor::getInstance().stop();
+    Logger::info(LogFacility::Other) << "Queued database writes done!" << Log::end;
+
+    metrics::stopExporter();
+
     reset_sighandlers();
 
     Logger::info(LogFacility::Other) << "Illarion has been terminated! " << Log::end;
+    Logger::stop();
 
     return 0;
 }
@@ -128,6 +128,7 @@ void sig_term(int /*unused*/) {
 void sig_segv(int /*unused*/) {
     Logger::error(LogFacility::Other) << "SIGSEGV received! Last Script: " << World::get()->currentScript->getFileName()
                                       << Log::end;
+    Logger::stop();
     std::terminate();
 }
 
@@ -0,0 +1,60 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "map/ChunkVersions.hpp"
+
+namespace map {
+
+auto ChunkVersions::get() -> ChunkVersions & {
+    static ChunkVersions instance;
+    return instance;
+}
+
+void ChunkVersions::bump(const position &pos) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++versions[chunkKey(pos)];
+}
+
+void ChunkVersions::bumpAll() {
+    std::lock_guard<std::mutex> lock(mutex);
+    versions.clear();
+    ++epoch;
+}
+
+// the epoch occupies the upper half, so versions handed out before bumpAll never repeat
+auto ChunkVersions::of(ChunkKey chunk) const -> Version {
+    constexpr auto epochShift = 32;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (const auto version = versions.find(chunk); version != versions.end()) {
+        return (epoch << epochShift) + version->second;
+    }
+
+    return epoch << epochShift;
+}
+
+auto ChunkVersions::chunkKey(const position &pos) -> ChunkKey {
+    constexpr auto zShift = 32;
+    constexpr auto xShift = 16;
+    const auto chunkX = static_cast<uint16_t>(pos.x >> chunkBits);
+    const auto chunkY = static_cast<uint16_t>(pos.y >> chunkBits);
+    return (static_cast<ChunkKey>(static_cast<uint16_t>(pos.z)) << zShift) |
+           (static_cast<ChunkKey>(chunkX) << xShift) | chunkY;
+}
+
+} // namespace map
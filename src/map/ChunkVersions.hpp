@@ -0,0 +1,55 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef CHUNK_VERSIONS_HPP
+#define CHUNK_VERSIONS_HPP
+
+#include "globals.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+
+namespace map {
+
+// Change counters for square chunks of fields, bumped whenever a field changes what clients are shown of it. Data
+// derived from fields can be cached together with the versions of the chunks it was built from.
+class ChunkVersions {
+public:
+    using ChunkKey = uint64_t;
+    using Version = uint64_t;
+    static constexpr int chunkBits = 4;
+
+    static auto get() -> ChunkVersions &;
+
+    void bump(const position &pos);
+    // invalidates every chunk at once, e.g. after maps were added or tables reloaded
+    void bumpAll();
+    [[nodiscard]] auto of(ChunkKey chunk) const -> Version;
+
+    [[nodiscard]] static auto chunkKey(const position &pos) -> ChunkKey;
+
+private:
+    mutable std::mutex mutex; // maps are filled concurrently while loading
+    std::unordered_map<ChunkKey, Version> versions;
+    Version epoch = 0;
+};
+
+} // namespace map
+
+#endif
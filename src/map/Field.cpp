@@ -18,29 +18,34 @@
 
 #include "map/Field.hpp"
 
+#include "MemoryUsage.hpp"
 #include "Player.hpp"
 #include "World.hpp"
 #include "data/Data.hpp"
 #include "db/ConnectionManager.hpp"
-#include "db/DeleteQuery.hpp"
-#include "db/InsertQuery.hpp"
 #include "db/Result.hpp"
 #include "db/SelectQuery.hpp"
-#include "db/UpdateQuery.hpp"
 #include "globals.hpp"
+#include "map/ChunkVersions.hpp"
+#include "map/FieldIndex.hpp"
+#include "map/FieldWriteQueue.hpp"
 #include "netinterface/protocol/ServerCommands.hpp"
 #include "stream.hpp"
 
 #include <algorithm>
-#include <range/v3/all.hpp>
+#include <iterator>
+#include <optional>
+#include <utility>
 
 namespace map {
 
 Field::Field(uint16_t tile, uint16_t music, const position &here, bool persistent)
-        : tile(tile), music(music), here(here), persistent(persistent) {
+        : tile(tile), music(music), persistent(persistent), here(here) {
     if (persistent) {
         loadDatabaseWarp();
         loadDatabaseItems();
+    } else {
+        updateFlags();
     }
 }
 
@@ -48,6 +53,7 @@ void Field::setTileId(uint16_t id) {
     tile = id;
     updateDatabaseField();
     updateFlags();
+    contentChanged();
     updateFieldToPlayersInScreen(here);
 }
 
@@ -70,6 +76,7 @@ auto Field::getSecondaryTileId() const -> uint16_t {
 void Field::setMusicId(uint16_t id) {
     music = id;
     updateDatabaseField();
+    contentChanged();
     updateFieldToPlayersInScreen(here);
 }
 
@@ -79,20 +86,9 @@ auto Field::isTransparent() const -> bool { return getTileId() == TRANSPARENT; }
 
 auto Field::getMovementCost() const -> TYPE_OF_WALKINGCOST {
     if (isWalkable()) {
-        auto tileId = getTileId();
-        const auto &primaryTile = Data::tiles()[tileId];
-        TYPE_OF_WALKINGCOST tileWalkingCost = primaryTile.walkingCost;
-
-        tileId = getSecondaryTileId();
-        const auto &secondaryTile = Data::tiles()[tileId];
-        uint16_t secondaryWalkingCost = secondaryTile.walkingCost;
-
-        if (secondaryWalkingCost < tileWalkingCost) {
-            tileWalkingCost = secondaryWalkingCost;
-        }
-
-        return tileWalkingCost;
+        return movementCost;
     }
+
     return std::numeric_limits<TYPE_OF_WALKINGCOST>::max();
 }
 
@@ -108,13 +104,14 @@ auto Field::getStackItem(uint8_t pos) const -> ScriptItem {
     return {};
 }
 
-auto Field::getItemStack() const -> const std::vector<Item> & { return items; }
+auto Field::getItemStack() const -> const ItemStack & { return items; }
 
 auto Field::addItemOnStack(const Item &item) -> bool {
     if (items.size() < MAXITEMS) {
         items.push_back(item);
         updateDatabaseItems();
-        updateFlags();
+        itemPushed(items.back());
+        contentChanged();
 
         return true;
     }
@@ -135,10 +132,11 @@ auto Field::takeItemFromStack(Item &item) -> bool {
         return false;
     }
 
-    item = items.back();
+    item = std::move(items.back());
     items.pop_back();
     updateDatabaseItems();
-    updateFlags();
+    itemRemoved(item);
+    contentChanged();
 
     return true;
 }
@@ -157,8 +155,13 @@ auto Field::increaseItemOnStack(int count, bool &erased) -> int {
         count -= maxStack;
         erased = false;
     } else if (count <= 0) {
+        const bool refresh = affectsFlags(item);
         items.pop_back();
-        updateFlags();
+
+        if (refresh) {
+            updateFlags();
+        }
+
         erased = true;
     } else {
         item.setNumber(count);
@@ -167,6 +170,7 @@ auto Field::increaseItemOnStack(int count, bool &erased) -> int {
     }
 
     updateDatabaseItems();
+    contentChanged();
     return count;
 }
 
@@ -176,6 +180,7 @@ auto Field::swapItemOnStack(TYPE_OF_ITEM_ID newId, uint16_t newQuality) -> bool
     }
 
     Item &item = items.back();
+    const bool refresh = affectsFlags(item);
     item.setId(newId);
 
     if (newQuality > 0) {
@@ -189,7 +194,14 @@ auto Field::swapItemOnStack(TYPE_OF_ITEM_ID newId, uint16_t newQuality) -> bool
     }
 
     updateDatabaseItems();
-    updateFlags();
+
+    if (refresh) {
+        updateFlags();
+    } else {
+        itemPushed(item);
+    }
+
+    contentChanged();
     return true;
 }
 
@@ -210,6 +222,7 @@ auto Field::addContainerOnStackIfWalkable(Item item, Container *container) -> bo
         if (items.size() < MAXITEMS - 1) {
             if (item.isContainer()) {
                 MAXCOUNTTYPE count = 0;
+                auto &containers = extended().containers;
 
                 auto iterat = containers.find(count);
 
@@ -223,7 +236,7 @@ auto Field::addContainerOnStackIfWalkable(Item item, Container *container) -> bo
                         container = new Container(item.getId());
                     }
 
-                    containers.insert(iterat, Container::CONTAINERMAP::value_type(count, container));
+                    containers.insert(iterat, CONTAINERMAP::value_type(count, container));
                 } else {
                     return false;
                 }
@@ -232,6 +245,7 @@ auto Field::addContainerOnStackIfWalkable(Item item, Container *container) -> bo
 
                 if (!addItemOnStackIfWalkable(item)) {
                     containers.erase(count);
+                    releaseUnusedExtension();
                 } else {
                     return true;
                 }
@@ -245,6 +259,7 @@ auto Field::addContainerOnStackIfWalkable(Item item, Container *container) -> bo
 auto Field::addContainerOnStack(Item item, Container *container) -> bool {
     if (item.isContainer()) {
         MAXCOUNTTYPE count = 0;
+        auto &containers = extended().containers;
 
         auto iterat = containers.find(count);
 
@@ -258,7 +273,7 @@ auto Field::addContainerOnStack(Item item, Container *container) -> bool {
                 container = new Container(item.getId());
             }
 
-            containers.insert(iterat, Container::CONTAINERMAP::value_type(count, container));
+            containers.insert(iterat, CONTAINERMAP::value_type(count, container));
         } else {
             return false;
         }
@@ -267,6 +282,7 @@ auto Field::addContainerOnStack(Item item, Container *container) -> bool {
 
         if (!addItemOnStack(item)) {
             containers.erase(count);
+            releaseUnusedExtension();
         } else {
             return true;
         }
@@ -275,37 +291,160 @@ auto Field::addContainerOnStack(Item item, Container *container) -> bool {
     return false;
 }
 
-void Field::save(std::ofstream &mapStream, std::ofstream &itemStream, std::ofstream &warpStream,
-                 std::ofstream &containerStream) const {
-    writeToStream(mapStream, tile);
-    writeToStream(mapStream, music);
-    writeToStream(mapStream, flags);
+auto Field::getContainer(MAXCOUNTTYPE number) const -> Container * {
+    const auto &containers = containerMap();
+    const auto it = containers.find(number);
+
+    if (it != containers.end()) {
+        return it->second;
+    }
+
+    return nullptr;
+}
+
+auto Field::takeContainer(MAXCOUNTTYPE number) -> Container * {
+    auto *container = getContainer(number);
+
+    if (container != nullptr) {
+        extension->containers.erase(number);
+        releaseUnusedExtension();
+    }
+
+    return container;
+}
+
+auto Field::extended() -> Extension & {
+    if (!extension) {
+        extension = std::make_unique<Extension>();
+    }
+
+    return *extension;
+}
+
+auto Field::containerMap() const -> const CONTAINERMAP & {
+    static const CONTAINERMAP noContainers;
+
+    if (extension) {
+        return extension->containers;
+    }
+
+    return noContainers;
+}
+
+void Field::clearContainers() {
+    if (extension) {
+        for (auto &container : extension->containers) {
+            delete container.second;
+            container.second = nullptr;
+        }
+
+        extension->containers.clear();
+    }
+}
+
+void Field::releaseUnusedExtension() {
+    if (extension && !isWarp() && extension->containers.empty()) {
+        extension.reset();
+    }
+}
+
+auto Field::getTileRecord() const -> TileRecord {
+    constexpr uint8_t characterFlags = FLAG_NPCONFIELD | FLAG_MONSTERONFIELD | FLAG_PLAYERONFIELD;
+    return {tile, music, static_cast<uint8_t>(flags & ~characterFlags), 0};
+}
+
+void Field::restore(const TileRecord &record) {
+    const auto before = flags;
+    tile = record.tile;
+    music = record.music;
+    flags = record.flags;
+    unsetBits(FLAG_NPCONFIELD | FLAG_MONSTERONFIELD | FLAG_PLAYERONFIELD | FLAG_WARPFIELD);
+    updateMovementCost();
+    // the warp itself arrives with the payload, but the index already knows about it
+    reindex(before, record.flags);
+}
+
+auto Field::hasPayload() const -> bool { return !items.empty() || isWarp() || !containerMap().empty(); }
 
+void Field::savePayload(std::ostream &stream) const {
     const uint8_t itemsSize = items.size();
-    writeToStream(itemStream, itemsSize);
+    writeToStream(stream, itemsSize);
 
     for (const auto &item : items) {
-        item.save(itemStream);
+        item.save(stream);
     }
 
+    const uint8_t warp = isWarp() ? 1 : 0;
+    writeToStream(stream, warp);
+
     if (isWarp()) {
-        const char b = 1;
-        writeToStream(warpStream, b);
-        writeToStream(warpStream, warptarget);
-    } else {
-        const char b = 0;
-        writeToStream(warpStream, b);
+        const auto &target = extension->warptarget;
+        writeToStream(stream, static_cast<int16_t>(target.x));
+        writeToStream(stream, static_cast<int16_t>(target.y));
+        writeToStream(stream, static_cast<int16_t>(target.z));
     }
 
+    const auto &containers = containerMap();
     const uint8_t containersSize = containers.size();
-    writeToStream(containerStream, containersSize);
+    writeToStream(stream, containersSize);
 
     for (const auto &container : containers) {
-        writeToStream(containerStream, container.first);
-        container.second->Save(containerStream);
+        writeToStream(stream, container.first);
+        container.second->Save(stream);
     }
 }
 
+void Field::loadPayload(std::istream &stream) {
+    MAXCOUNTTYPE size = 0;
+    readFromStream(stream, size);
+
+    items.clear();
+
+    for (int i = 0; i < size; ++i) {
+        Item item;
+        item.load(stream);
+        items.push_back(item);
+    }
+
+    uint8_t warp = 0;
+    readFromStream(stream, warp);
+
+    if (warp == 1) {
+        int16_t x = 0;
+        int16_t y = 0;
+        int16_t z = 0;
+        readFromStream(stream, x);
+        readFromStream(stream, y);
+        readFromStream(stream, z);
+        setWarp(position(x, y, z));
+    }
+
+    clearContainers();
+    readFromStream(stream, size);
+
+    for (int i = 0; i < size; ++i) {
+        MAXCOUNTTYPE key = 0;
+        readFromStream(stream, key);
+
+        const auto owner = std::find_if(items.begin(), items.end(), [key](const Item &item) {
+            return item.isContainer() && item.getNumber() == key;
+        });
+
+        // always consume the container, otherwise the rest of the payload is misread
+        auto *container = new Container(owner != items.end() ? owner->getId() : 0);
+        container->Load(stream);
+
+        if (owner != items.end()) {
+            extended().containers.insert(CONTAINERMAP::value_type(key, container));
+        } else {
+            delete container;
+        }
+    }
+
+    releaseUnusedExtension();
+    updateFlags();
+}
+
 auto Field::getExportItems() const -> std::vector<Item> {
     std::vector<Item> result;
 
@@ -329,11 +468,12 @@ auto Field::getExportItems() const -> std::vector<Item> {
 
 void Field::load(std::ifstream &mapStream, std::ifstream &itemStream, std::ifstream &warpStream,
                  std::ifstream &containerStream) {
+    const auto before = flags;
     readFromStream(mapStream, tile);
     readFromStream(mapStream, music);
     readFromStream(mapStream, flags);
 
-    unsetBits(FLAG_NPCONFIELD | FLAG_MONSTERONFIELD | FLAG_PLAYERONFIELD);
+    unsetBits(FLAG_NPCONFIELD | FLAG_MONSTERONFIELD | FLAG_PLAYERONFIELD | FLAG_WARPFIELD);
 
     MAXCOUNTTYPE size = 0;
     readFromStream(itemStream, size);
@@ -356,13 +496,7 @@ void Field::load(std::ifstream &mapStream, std::ifstream &itemStream, std::ifstr
     }
 
     readFromStream(containerStream, size);
-
-    for (auto &container : containers) {
-        delete container.second;
-        container.second = nullptr;
-    }
-
-    containers.clear();
+    clearContainers();
 
     for (int i = 0; i < size; ++i) {
         MAXCOUNTTYPE key = 0;
@@ -372,12 +506,14 @@ void Field::load(std::ifstream &mapStream, std::ifstream &itemStream, std::ifstr
             if (item.isContainer() && item.getNumber() == key) {
                 auto *container = new Container(item.getId());
                 container->Load(containerStream);
-                containers.insert(decltype(containers)::value_type(key, container));
+                extended().containers.insert(CONTAINERMAP::value_type(key, container));
             }
         }
     }
 
+    releaseUnusedExtension();
     updateFlags();
+    reindex(before, flags);
 }
 
 auto Field::getPosition() const -> const position & { return here; }
@@ -400,89 +536,158 @@ void Field::removePersistence() {
 
 auto Field::isPersistent() const -> bool { return persistent; }
 
-void Field::age() {
-    for (const auto &container : containers) {
-        if (container.second != nullptr) {
-            container.second->doAge();
+auto Field::memoryUsage() const -> size_t {
+    auto bytes = memory::of(items);
+
+    for (const auto &item : items) {
+        bytes += item.memoryUsage();
+    }
+
+    if (extension) {
+        bytes += sizeof(Extension) + memory::ofTree(extension->containers);
+
+        for (const auto &[slot, container] : extension->containers) {
+            bytes += container->memoryUsage();
         }
     }
 
-    if (!items.empty()) {
-        auto it = items.begin();
-        bool refreshItems = false;
+    return bytes;
+}
+
+auto Field::isPerishable() const -> bool {
+    return !containerMap().empty() ||
+           std::any_of(items.begin(), items.end(), [](const Item &item) { return !item.isPermanent(); });
+}
 
-        while (it < items.end()) {
-            Item &item = *it;
+void Field::age() {
+    if (ageItems()) {
+        itemStackAged();
+    }
+}
 
-            if (!item.survivesAgeing()) {
-                const auto &itemStruct = Data::items()[item.getId()];
-                refreshItems = true;
+auto Field::ageItems() -> bool {
+    for (const auto &container : containerMap()) {
+        if (container.second != nullptr) {
+            container.second->doAge();
+        }
+    }
 
-                if (itemStruct.isValid() && item.getId() != itemStruct.ObjectAfterRot) {
-                    item.setId(itemStruct.ObjectAfterRot);
+    bool refreshItems = false;
+    auto it = items.begin();
 
-                    const auto &afterRotItemStruct = Data::items()[itemStruct.ObjectAfterRot];
+    while (it < items.end()) {
+        Item &item = *it;
 
-                    if (afterRotItemStruct.isValid()) {
-                        item.setWear(afterRotItemStruct.AgeingSpeed);
-                    }
+        if (!item.survivesAgeing()) {
+            const auto &itemStruct = Data::items()[item.getId()];
+            refreshItems = true;
 
-                    ++it;
-                } else {
-                    if (item.isContainer()) {
-                        auto iterat = containers.find(item.getNumber());
+            if (itemStruct.isValid() && item.getId() != itemStruct.ObjectAfterRot) {
+                item.setId(itemStruct.ObjectAfterRot);
 
-                        if (iterat != containers.end()) {
-                            delete iterat->second;
-                            containers.erase(iterat);
-                        }
-                    }
+                const auto &afterRotItemStruct = Data::items()[itemStruct.ObjectAfterRot];
 
-                    it = items.erase(it);
+                if (afterRotItemStruct.isValid()) {
+                    item.setWear(afterRotItemStruct.AgeingSpeed);
                 }
-            } else {
+
                 ++it;
+            } else {
+                if (item.isContainer()) {
+                    delete takeContainer(item.getNumber());
+                }
+
+                it = items.erase(it);
             }
+        } else {
+            ++it;
         }
+    }
 
-        if (refreshItems) {
-            std::vector<Player *> playersinview = World::get()->Players.findAllCharactersInScreen(here);
+    if (refreshItems) {
+        updateFlags();
+    }
 
-            for (const auto &player : playersinview) {
-                ServerCommandPointer cmd = std::make_shared<ItemUpdate_TC>(here, getItemStack());
-                player->Connection->addCommand(cmd);
-            }
+    return refreshItems;
+}
 
-            updateDatabaseItems();
-            updateFlags();
+void Field::itemStackAged() const {
+    contentChanged();
+
+    ServerCommandPointer cmd;
+
+    World::get()->Players.forEachCharacterInScreen(here, [this, &cmd](Player *player) {
+        if (!cmd) {
+            cmd = std::make_shared<ItemUpdate_TC>(here, getItemStack());
         }
-    }
+
+        player->Connection->addCommand(cmd);
+    });
+
+    updateDatabaseItems();
 }
 
 void Field::updateFlags() {
-    unsetBits(FLAG_SPECIALITEM | FLAG_BLOCKPATH | FLAG_MAKEPASSABLE);
+    const auto before = flags;
+    unsetBits(FLAG_SPECIALITEM | FLAG_BLOCKPATH | FLAG_MAKEPASSABLE | FLAG_BLOCKSIGHT);
 
-    if (Data::tiles().exists(tile)) {
-        const TilesStruct &tt = Data::tiles()[tile];
-        setBits(tt.flags & FLAG_BLOCKPATH);
+    if (const auto *tt = Data::tiles().find(tile); tt != nullptr) {
+        setBits(tt->flags & FLAG_BLOCKPATH);
     }
 
     for (const auto &item : items) {
-        if (Data::tilesModItems().exists(item.getId())) {
-            const auto &mod = Data::tilesModItems()[item.getId()];
-            setBits(mod.Modificator & FLAG_SPECIALITEM);
-
-            if ((mod.Modificator & FLAG_MAKEPASSABLE) != 0) {
-                unsetBits(FLAG_BLOCKPATH);
-                setBits(FLAG_MAKEPASSABLE);
-            } else if ((mod.Modificator & FLAG_BLOCKPATH) != 0) {
-                unsetBits(FLAG_MAKEPASSABLE);
-                setBits(FLAG_BLOCKPATH);
-            }
+        applyItemFlags(item);
+    }
+
+    updateMovementCost();
+    reindex(before, flags);
+}
+
+// bottom to top, so an item with a path modifier overrides those below it
+void Field::applyItemFlags(const Item &item) {
+    if (item.isLarge()) {
+        setBits(FLAG_BLOCKSIGHT);
+    }
+
+    if (const auto *mod = Data::tilesModItems().find(item.getId()); mod != nullptr) {
+        setBits(mod->Modificator & FLAG_SPECIALITEM);
+
+        if ((mod->Modificator & FLAG_MAKEPASSABLE) != 0) {
+            unsetBits(FLAG_BLOCKPATH);
+            setBits(FLAG_MAKEPASSABLE);
+        } else if ((mod->Modificator & FLAG_BLOCKPATH) != 0) {
+            unsetBits(FLAG_MAKEPASSABLE);
+            setBits(FLAG_BLOCKPATH);
         }
     }
 }
 
+auto Field::affectsFlags(const Item &item) -> bool {
+    return item.isLarge() || Data::tilesModItems().find(item.getId()) != nullptr;
+}
+
+void Field::itemPushed(const Item &item) {
+    const auto before = flags;
+    applyItemFlags(item);
+    reindex(before, flags);
+}
+
+void Field::itemRemoved(const Item &item) {
+    // an item without modifier left the flags of the stack below it as they were
+    if (affectsFlags(item)) {
+        updateFlags();
+    }
+}
+
+void Field::updateMovementCost() {
+    const auto tileWalkingCost = [](TYPE_OF_TILE_ID tileId) -> TYPE_OF_WALKINGCOST {
+        const auto &tiles = Data::tiles();
+        return tiles.exists(tileId) ? tiles.get(tileId).walkingCost : 0;
+    };
+
+    movementCost = std::min(tileWalkingCost(getTileId()), tileWalkingCost(getSecondaryTileId()));
+}
+
 auto Field::hasMonster() const -> bool { return anyBitSet(FLAG_MONSTERONFIELD); }
 
 void Field::setMonster() { setBits(FLAG_MONSTERONFIELD); }
@@ -504,20 +709,33 @@ void Field::removePlayer() { unsetBits(FLAG_PLAYERONFIELD); }
 auto Field::isWarp() const -> bool { return anyBitSet(FLAG_WARPFIELD); }
 
 void Field::setWarp(const position &pos) {
-    warptarget = pos;
+    const auto before = flags;
+    extended().warptarget = pos;
     setBits(FLAG_WARPFIELD);
+    reindex(before, flags);
     updateDatabaseWarp();
 }
 
 void Field::removeWarp() {
+    const auto before = flags;
     unsetBits(FLAG_WARPFIELD);
+    reindex(before, flags);
     updateDatabaseWarp();
+    releaseUnusedExtension();
 }
 
-void Field::getWarp(position &pos) const { pos = warptarget; }
+void Field::getWarp(position &pos) const {
+    if (isWarp()) {
+        pos = extension->warptarget;
+    } else {
+        pos = {0, 0, 0};
+    }
+}
 
 auto Field::hasSpecialItem() const -> bool { return anyBitSet(FLAG_SPECIALITEM); }
 
+auto Field::blocksSight() const -> bool { return anyBitSet(FLAG_BLOCKSIGHT); }
+
 auto Field::isWalkable() const -> bool { return !anyBitSet(FLAG_BLOCKPATH) || anyBitSet(FLAG_MAKEPASSABLE); }
 
 auto Field::moveToPossible() const -> bool {
@@ -528,6 +746,16 @@ void Field::setChar() { setBits(FLAG_PLAYERONFIELD); }
 
 void Field::removeChar() { unsetBits(FLAG_PLAYERONFIELD); }
 
+void Field::contentChanged() const { ChunkVersions::get().bump(here); }
+
+void Field::reindex(uint8_t before, uint8_t after) const {
+    constexpr uint8_t indexedFlags = FLAG_WARPFIELD | FLAG_SPECIALITEM;
+
+    if (((before ^ after) & indexedFlags) != 0) {
+        FieldIndex::get().update(here, after);
+    }
+}
+
 inline void Field::setBits(uint8_t bits) { flags |= bits; }
 
 inline void Field::unsetBits(uint8_t bits) { flags &= ~bits; }
@@ -539,33 +767,7 @@ void Field::insertIntoDatabase() const noexcept {
         return;
     }
 
-    using namespace Database;
-    auto connection = ConnectionManager::getInstance().getConnection();
-
-    try {
-        connection->beginTransaction();
-
-        InsertQuery fieldQuery(connection);
-        const auto xColumn = fieldQuery.addColumn("mt_x");
-        const auto yColumn = fieldQuery.addColumn("mt_y");
-        const auto zColumn = fieldQuery.addColumn("mt_z");
-        const auto tileColumn = fieldQuery.addColumn("mt_tile");
-        const auto musicColumn = fieldQuery.addColumn("mt_music");
-        fieldQuery.addServerTable("map_tiles");
-
-        fieldQuery.addValue<int16_t>(xColumn, here.x);
-        fieldQuery.addValue<int16_t>(yColumn, here.y);
-        fieldQuery.addValue<int16_t>(zColumn, here.z);
-        fieldQuery.addValue<uint16_t>(tileColumn, tile);
-        fieldQuery.addValue<uint16_t>(musicColumn, music);
-
-        fieldQuery.execute();
-
-        connection->commitTransaction();
-    } catch (std::exception &e) {
-        Logger::error(LogFacility::World) << "Error while inserting field into database: " << e.what() << Log::end;
-        connection->rollbackTransaction();
-    }
+    FieldWriteQueue::get().insertField(here, tile, music);
 }
 
 void Field::removeFromDatabase() const noexcept {
@@ -573,24 +775,7 @@ void Field::removeFromDatabase() const noexcept {
         return;
     }
 
-    using namespace Database;
-    auto connection = ConnectionManager::getInstance().getConnection();
-
-    try {
-        connection->beginTransaction();
-
-        DeleteQuery fieldQuery(connection);
-        fieldQuery.addEqualCondition<int16_t>("map_tiles", "mt_x", here.x);
-        fieldQuery.addEqualCondition<int16_t>("map_tiles", "mt_y", here.y);
-        fieldQuery.addEqualCondition<int16_t>("map_tiles", "mt_z", here.z);
-        fieldQuery.addServerTable("map_tiles");
-        fieldQuery.execute();
-
-        connection->commitTransaction();
-    } catch (std::exception &e) {
-        Logger::error(LogFacility::World) << "Error while deleting field from database: " << e.what() << Log::end;
-        connection->rollbackTransaction();
-    }
+    FieldWriteQueue::get().removeField(here);
 }
 
 void Field::updateDatabaseField() const noexcept {
@@ -598,26 +783,7 @@ void Field::updateDatabaseField() const noexcept {
         return;
     }
 
-    using namespace Database;
-    auto connection = ConnectionManager::getInstance().getConnection();
-
-    try {
-        connection->beginTransaction();
-
-        UpdateQuery fieldQuery(connection);
-        fieldQuery.addAssignColumn<uint16_t>("mt_tile", tile);
-        fieldQuery.addAssignColumn<uint16_t>("mt_music", music);
-        fieldQuery.addEqualCondition<int16_t>("map_tiles", "mt_x", here.x);
-        fieldQuery.addEqualCondition<int16_t>("map_tiles", "mt_y", here.y);
-        fieldQuery.addEqualCondition<int16_t>("map_tiles", "mt_z", here.z);
-        fieldQuery.addServerTable("map_tiles");
-        fieldQuery.execute();
-
-        connection->commitTransaction();
-    } catch (std::exception &e) {
-        Logger::error(LogFacility::World) << "Error while updating field in database: " << e.what() << Log::end;
-        connection->rollbackTransaction();
-    }
+    FieldWriteQueue::get().updateField(here, tile, music);
 }
 
 void Field::updateDatabaseItems() const noexcept {
@@ -625,77 +791,10 @@ void Field::updateDatabaseItems() const noexcept {
         return;
     }
 
-    using namespace Database;
-    auto connection = ConnectionManager::getInstance().getConnection();
-
-    try {
-        connection->beginTransaction();
-
-        {
-            DeleteQuery itemQuery(connection);
-            itemQuery.addEqualCondition<int16_t>("map_items", "mi_x", here.x);
-            itemQuery.addEqualCondition<int16_t>("map_items", "mi_y", here.y);
-            itemQuery.addEqualCondition<int16_t>("map_items", "mi_z", here.z);
-            itemQuery.addServerTable("map_items");
-            itemQuery.execute();
-        }
-
-        if (itemCount() > 0) {
-            InsertQuery itemQuery(connection);
-            const auto xColumn = itemQuery.addColumn("mi_x");
-            const auto yColumn = itemQuery.addColumn("mi_y");
-            const auto zColumn = itemQuery.addColumn("mi_z");
-            const auto stackPosColumn = itemQuery.addColumn("mi_stack_pos");
-            const auto itemColumn = itemQuery.addColumn("mi_item");
-            const auto qualityColumn = itemQuery.addColumn("mi_quality");
-            const auto numberColumn = itemQuery.addColumn("mi_number");
-            const auto wearColumn = itemQuery.addColumn("mi_wear");
-            itemQuery.addServerTable("map_items");
-
-            InsertQuery dataQuery(connection);
-            const auto xDataColumn = dataQuery.addColumn("mid_x");
-            const auto yDataColumn = dataQuery.addColumn("mid_y");
-            const auto zDataColumn = dataQuery.addColumn("mid_z");
-            const auto stackPosDataColumn = dataQuery.addColumn("mid_stack_pos");
-            const auto keyDataColumn = dataQuery.addColumn("mid_key");
-            const auto valueDataColumn = dataQuery.addColumn("mid_value");
-            dataQuery.addServerTable("map_item_data");
-
-            uint16_t stackPos = 0;
-            auto nonMovable = ranges::view::filter([](const Item &item) { return not item.isMovable(); });
-
-            ranges::for_each(items | nonMovable, [&](const auto &item) {
-                itemQuery.addValue<int16_t>(xColumn, here.x);
-                itemQuery.addValue<int16_t>(yColumn, here.y);
-                itemQuery.addValue<int16_t>(zColumn, here.z);
-
-                itemQuery.addValue<uint16_t>(stackPosColumn, stackPos);
-                itemQuery.addValue<TYPE_OF_ITEM_ID>(itemColumn, item.getId());
-                itemQuery.addValue<uint16_t>(qualityColumn, item.getQuality());
-                itemQuery.addValue<uint16_t>(numberColumn, item.getNumber());
-                itemQuery.addValue<uint16_t>(wearColumn, item.getWear());
-
-                std::for_each(item.getDataBegin(), item.getDataEnd(), [&](const auto &data) {
-                    dataQuery.addValue<int16_t>(xDataColumn, here.x);
-                    dataQuery.addValue<int16_t>(yDataColumn, here.y);
-                    dataQuery.addValue<int16_t>(zDataColumn, here.z);
-                    dataQuery.addValue<uint16_t>(stackPosDataColumn, stackPos);
-                    dataQuery.addValue<std::string>(keyDataColumn, data.first);
-                    dataQuery.addValue<std::string>(valueDataColumn, data.second);
-                });
-
-                ++stackPos;
-            });
-
-            itemQuery.execute();
-            dataQuery.execute();
-        }
-
-        connection->commitTransaction();
-    } catch (std::exception &e) {
-        Logger::error(LogFacility::World) << "Error while updating items in database: " << e.what() << Log::end;
-        connection->rollbackTransaction();
-    }
+    std::vector<Item> nonMovableItems;
+    std::copy_if(items.begin(), items.end(), std::back_inserter(nonMovableItems),
+                 [](const Item &item) { return not item.isMovable(); });
+    FieldWriteQueue::get().updateItems(here, std::move(nonMovableItems));
 }
 
 void Field::updateDatabaseWarp() const noexcept {
@@ -703,47 +802,13 @@ void Field::updateDatabaseWarp() const noexcept {
         return;
     }
 
-    using namespace Database;
-    auto connection = ConnectionManager::getInstance().getConnection();
-
-    try {
-        connection->beginTransaction();
-
-        {
-            DeleteQuery warpQuery(connection);
-            warpQuery.addEqualCondition<int16_t>("map_warps", "mw_start_x", here.x);
-            warpQuery.addEqualCondition<int16_t>("map_warps", "mw_start_y", here.y);
-            warpQuery.addEqualCondition<int16_t>("map_warps", "mw_start_z", here.z);
-            warpQuery.addServerTable("map_warps");
-            warpQuery.execute();
-        }
-
-        if (isWarp()) {
-            InsertQuery warpQuery(connection);
-            const auto xStartColumn = warpQuery.addColumn("mw_start_x");
-            const auto yStartColumn = warpQuery.addColumn("mw_start_y");
-            const auto zStartColumn = warpQuery.addColumn("mw_start_z");
-            const auto xTargetColumn = warpQuery.addColumn("mw_target_x");
-            const auto yTargetColumn = warpQuery.addColumn("mw_target_y");
-            const auto zTargetColumn = warpQuery.addColumn("mw_target_z");
-
-            warpQuery.addServerTable("map_warps");
-
-            warpQuery.addValue<int16_t>(xStartColumn, here.x);
-            warpQuery.addValue<int16_t>(yStartColumn, here.y);
-            warpQuery.addValue<int16_t>(zStartColumn, here.z);
-            warpQuery.addValue<int16_t>(xTargetColumn, warptarget.x);
-            warpQuery.addValue<int16_t>(yTargetColumn, warptarget.y);
-            warpQuery.addValue<int16_t>(zTargetColumn, warptarget.z);
-
-            warpQuery.execute();
-        }
+    std::optional<position> target;
 
-        connection->commitTransaction();
-    } catch (std::exception &e) {
-        Logger::error(LogFacility::World) << "Error while updating warp in database: " << e.what() << Log::end;
-        connection->rollbackTransaction();
+    if (isWarp()) {
+        target = extension->warptarget;
     }
+
+    FieldWriteQueue::get().updateWarp(here, target);
 }
 
 void Field::loadDatabaseWarp() noexcept {
@@ -763,10 +828,13 @@ void Field::loadDatabaseWarp() noexcept {
 
         if (not result.empty()) {
             const auto &row = result.front();
+            auto &warptarget = extended().warptarget;
             warptarget.x = row["mw_target_x"].as<int16_t>();
             warptarget.y = row["mw_target_y"].as<int16_t>();
             warptarget.z = row["mw_target_z"].as<int16_t>();
+            const auto before = flags;
             setBits(FLAG_WARPFIELD);
+            reindex(before, flags);
         }
     } catch (std::exception &e) {
         Logger::error(LogFacility::World) << "Error while loading warp from database: " << e.what() << Log::end;
@@ -827,11 +895,7 @@ void Field::loadDatabaseItems() noexcept {
 }
 
 void updateFieldToPlayersInScreen(const position &pos) {
-    auto playersInScreen = World::get()->Players.findAllCharactersInScreen(pos);
-
-    for (const auto &player : playersInScreen) {
-        player->sendField(pos);
-    }
+    World::get()->Players.forEachCharacterInScreen(pos, [&pos](Player *player) { player->sendField(pos); });
 }
 
 } // namespace map
@@ -21,14 +21,29 @@
 
 #include "Container.hpp"
 #include "Item.hpp"
+#include "SmallVector.hpp"
 #include "constants.hpp"
 #include "globals.hpp"
 
+#include <map>
+#include <memory>
 #include <vector>
 
 namespace map {
 
+// fixed-size part of a field as stored in map snapshots
+struct TileRecord {
+    uint16_t tile;
+    uint16_t music;
+    uint8_t flags;
+    uint8_t reserved;
+};
+
 class Field {
+public:
+    // ground stacks mostly hold a single item, which then needs no heap memory
+    using ItemStack = SmallVector<Item, 1>;
+
 private:
     static constexpr uint16_t TRANSPARENT = 0;
     static constexpr uint16_t tileIdBits = 10;
@@ -37,18 +52,26 @@ private:
     static constexpr uint16_t secondaryTileBitMask = 0b0000'0011'1110'0000;
     static constexpr uint16_t primaryTileBitMask = 0b0000'0000'0001'1111;
 
+    using CONTAINERMAP = std::map<TYPE_OF_CONTAINERSLOTS, Container *>;
+
+    // data only few fields carry, allocated on demand to keep bare ground small
+    struct Extension {
+        position warptarget{};
+        CONTAINERMAP containers;
+    };
+
     uint16_t tile = 0;
     uint16_t music = 0;
+    TYPE_OF_WALKINGCOST movementCost = 0; // refreshed by updateFlags
     uint8_t flags = 0;
-    position here;
-    position warptarget{};
-    std::vector<Item> items;
     bool persistent = false;
+    bool trigger = false; // set by World::markTriggerFields, may outlive the trigger after a reload
+    position here;
+    ItemStack items;
+    std::unique_ptr<Extension> extension;
 
 public:
-    Container::CONTAINERMAP containers;
-
-    explicit Field(const position &here) : here(here){};
+    explicit Field(const position &here) : here(here) { updateFlags(); };
     Field(uint16_t tile, uint16_t music, const position &here, bool persistent = false);
     Field(const Field &) = delete;
     auto operator=(const Field &) -> Field & = delete;
@@ -68,7 +91,11 @@ public:
     [[nodiscard]] auto isWalkable() const -> bool;
     [[nodiscard]] auto moveToPossible() const -> bool;
     [[nodiscard]] auto getMovementCost() const -> TYPE_OF_WALKINGCOST;
+    // refreshes the cached cost from the tiles table, needed after the table was reloaded
+    void updateMovementCost();
     [[nodiscard]] auto hasSpecialItem() const -> bool;
+    // whether a large item on the field blocks the line of sight
+    [[nodiscard]] auto blocksSight() const -> bool;
 
     auto addItemOnStack(const Item &item) -> bool;
     auto addItemOnStackIfWalkable(const Item &item) -> bool;
@@ -77,13 +104,21 @@ public:
     auto swapItemOnStack(TYPE_OF_ITEM_ID newId, uint16_t newQuality = 0) -> bool;
     auto viewItemOnStack(Item &item) const -> bool;
     [[nodiscard]] auto getStackItem(uint8_t pos) const -> ScriptItem;
-    [[nodiscard]] auto getItemStack() const -> const std::vector<Item> &;
+    [[nodiscard]] auto getItemStack() const -> const ItemStack &;
     [[nodiscard]] auto itemCount() const -> MAXCOUNTTYPE;
 
     auto addContainerOnStackIfWalkable(Item item, Container *container) -> bool;
     auto addContainerOnStack(Item item, Container *container) -> bool;
+    [[nodiscard]] auto getContainer(MAXCOUNTTYPE number) const -> Container *;
+    auto takeContainer(MAXCOUNTTYPE number) -> Container *;
 
     void age();
+    // whether ageing can alter the field, i.e. it holds containers or non-permanent items
+    [[nodiscard]] auto isPerishable() const -> bool;
+    // ageing of the field alone, safe to run concurrently for distinct fields; returns whether the stack changed
+    auto ageItems() -> bool;
+    // sends a stack changed by ageItems to players in view and the database, game thread only
+    void itemStackAged() const;
 
     void setPlayer();
     void setNPC();
@@ -103,8 +138,11 @@ public:
     [[nodiscard]] auto isWarp() const -> bool;
 
     [[nodiscard]] auto getExportItems() const -> std::vector<Item>;
-    void save(std::ofstream &mapStream, std::ofstream &itemStream, std::ofstream &warpStream,
-              std::ofstream &containerStream) const;
+    [[nodiscard]] auto getTileRecord() const -> TileRecord;
+    void restore(const TileRecord &record);
+    [[nodiscard]] auto hasPayload() const -> bool;
+    void savePayload(std::ostream &stream) const;
+    void loadPayload(std::istream &stream);
     void load(std::ifstream &mapStream, std::ifstream &itemStream, std::ifstream &warpStream,
               std::ifstream &containerStream);
 
@@ -114,8 +152,27 @@ public:
     void removePersistence();
     [[nodiscard]] auto isPersistent() const -> bool;
 
+    // the trigger table needs to be asked only for fields with this mark
+    void markTrigger() { trigger = true; }
+    [[nodiscard]] auto mayHaveTrigger() const -> bool { return trigger; }
+
+    // estimated heap bytes owned by the field, items and containers included
+    [[nodiscard]] auto memoryUsage() const -> size_t;
+
 private:
+    auto extended() -> Extension &;
+    [[nodiscard]] auto containerMap() const -> const CONTAINERMAP &;
+    void releaseUnusedExtension();
+
+    void contentChanged() const;
+    void reindex(uint8_t before, uint8_t after) const;
     void updateFlags();
+    // keep the flags of a change at the top of the stack without going over the whole stack again
+    void applyItemFlags(const Item &item);
+    [[nodiscard]] static auto affectsFlags(const Item &item) -> bool;
+    void itemPushed(const Item &item);
+    void itemRemoved(const Item &item);
+    void clearContainers();
     inline void setBits(uint8_t /*bits*/);
     inline void unsetBits(uint8_t /*bits*/);
     [[nodiscard]] inline auto anyBitSet(uint8_t /*bits*/) const -> bool;
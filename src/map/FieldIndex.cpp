@@ -0,0 +1,143 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "map/FieldIndex.hpp"
+
+#include "constants.hpp"
+#include "map/ChunkVersions.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace map {
+
+auto FieldIndex::get() -> FieldIndex & {
+    static FieldIndex instance;
+    return instance;
+}
+
+void FieldIndex::update(const position &pos, uint8_t flags) {
+    std::lock_guard<std::mutex> lock(mutex);
+    set(warps, pos, (flags & FLAG_WARPFIELD) != 0);
+    set(specialItems, pos, (flags & FLAG_SPECIALITEM) != 0);
+}
+
+void FieldIndex::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    warps.clear();
+    specialItems.clear();
+}
+
+void FieldIndex::clearArea(const position &min, const position &max) {
+    std::lock_guard<std::mutex> lock(mutex);
+    clearArea(warps, min, max);
+    clearArea(specialItems, min, max);
+}
+
+auto FieldIndex::warpsInRange(const position &pos, Coordinate range) const -> std::vector<position> {
+    return inRange(warps, pos, range);
+}
+
+auto FieldIndex::specialItemsInRange(const position &pos, Coordinate range) const -> std::vector<position> {
+    return inRange(specialItems, pos, range);
+}
+
+void FieldIndex::set(Chunks &chunks, const position &pos, bool isSet) {
+    const auto key = ChunkVersions::chunkKey(pos);
+    auto chunk = chunks.find(key);
+
+    if (chunk == chunks.end()) {
+        if (isSet) {
+            chunks[key].push_back(pos);
+        }
+
+        return;
+    }
+
+    auto &positions = chunk->second;
+    const auto it = std::find(positions.begin(), positions.end(), pos);
+
+    if (isSet && it == positions.end()) {
+        positions.push_back(pos);
+    } else if (!isSet && it != positions.end()) {
+        *it = positions.back();
+        positions.pop_back();
+
+        if (positions.empty()) {
+            chunks.erase(chunk);
+        }
+    }
+}
+
+void FieldIndex::clearArea(Chunks &chunks, const position &min, const position &max) {
+    constexpr auto chunkBits = ChunkVersions::chunkBits;
+    constexpr Coordinate chunkSize = 1 << chunkBits;
+
+    for (int x = min.x >> chunkBits; x <= max.x >> chunkBits; ++x) {
+        for (int y = min.y >> chunkBits; y <= max.y >> chunkBits; ++y) {
+            const position corner(static_cast<Coordinate>(x * chunkSize), static_cast<Coordinate>(y * chunkSize),
+                                  min.z);
+            const auto chunk = chunks.find(ChunkVersions::chunkKey(corner));
+
+            if (chunk == chunks.end()) {
+                continue;
+            }
+
+            auto &positions = chunk->second;
+            positions.erase(std::remove_if(positions.begin(), positions.end(),
+                                           [&min, &max](const position &pos) {
+                                               return pos.x >= min.x && pos.x <= max.x && pos.y >= min.y &&
+                                                      pos.y <= max.y;
+                                           }),
+                            positions.end());
+
+            if (positions.empty()) {
+                chunks.erase(chunk);
+            }
+        }
+    }
+}
+
+auto FieldIndex::inRange(const Chunks &chunks, const position &pos, Coordinate range) const
+        -> std::vector<position> {
+    constexpr auto chunkBits = ChunkVersions::chunkBits;
+    constexpr Coordinate chunkSize = 1 << chunkBits;
+    std::vector<position> result;
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (Coordinate x = (pos.x - range) >> chunkBits; x <= (pos.x + range) >> chunkBits; ++x) {
+        for (Coordinate y = (pos.y - range) >> chunkBits; y <= (pos.y + range) >> chunkBits; ++y) {
+            const position corner(x * chunkSize, y * chunkSize, pos.z);
+            const auto chunk = chunks.find(ChunkVersions::chunkKey(corner));
+
+            if (chunk == chunks.end()) {
+                continue;
+            }
+
+            for (const auto &candidate : chunk->second) {
+                if (std::abs(candidate.x - pos.x) <= range && std::abs(candidate.y - pos.y) <= range) {
+                    result.push_back(candidate);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+} // namespace map
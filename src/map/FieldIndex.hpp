@@ -0,0 +1,62 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FIELD_INDEX_HPP
+#define FIELD_INDEX_HPP
+
+#include "globals.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace map {
+
+// Positions of warp fields and fields with special items, bucketed by chunk. Fields report flag changes, so the
+// entries are candidates that callers confirm on the field itself.
+class FieldIndex {
+public:
+    static auto get() -> FieldIndex &;
+
+    // records which of FLAG_WARPFIELD and FLAG_SPECIALITEM are set in flags for the field at pos
+    void update(const position &pos, uint8_t flags);
+    void clear();
+    // forgets all fields from min to max on the level of min, for maps that are removed
+    void clearArea(const position &min, const position &max);
+
+    // positions on the level of pos within range in x and y
+    [[nodiscard]] auto warpsInRange(const position &pos, Coordinate range) const -> std::vector<position>;
+    [[nodiscard]] auto specialItemsInRange(const position &pos, Coordinate range) const -> std::vector<position>;
+
+private:
+    using Chunks = std::unordered_map<uint64_t, std::vector<position>>;
+
+    mutable std::mutex mutex; // maps are filled concurrently while loading
+    Chunks warps;
+    Chunks specialItems;
+
+    static void set(Chunks &chunks, const position &pos, bool isSet);
+    static void clearArea(Chunks &chunks, const position &min, const position &max);
+    [[nodiscard]] auto inRange(const Chunks &chunks, const position &pos, Coordinate range) const
+            -> std::vector<position>;
+};
+
+} // namespace map
+
+#endif
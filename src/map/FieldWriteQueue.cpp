@@ -0,0 +1,270 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "map/FieldWriteQueue.hpp"
+
+#include "Config.hpp"
+#include "Logger.hpp"
+#include "ThreadAffinity.hpp"
+#include "db/ConnectionManager.hpp"
+#include "db/InsertQuery.hpp"
+#include "db/PreparedQuery.hpp"
+#include "tuningConstants.hpp"
+
+#include <algorithm>
+
+namespace map {
+
+auto FieldWriteQueue::get() -> FieldWriteQueue & {
+    static FieldWriteQueue instance;
+    return instance;
+}
+
+FieldWriteQueue::~FieldWriteQueue() { stop(); }
+
+void FieldWriteQueue::insertField(const position &pos, uint16_t tile, uint16_t music) {
+    enqueue(pos, [tile, music](PendingWrite &entry) {
+        entry.insertRow = true;
+        entry.tile = Tile{tile, music};
+    });
+}
+
+void FieldWriteQueue::removeField(const position &pos) {
+    enqueue(pos, [](PendingWrite &entry) {
+        entry = PendingWrite{};
+        entry.removeRow = true;
+    });
+}
+
+void FieldWriteQueue::updateField(const position &pos, uint16_t tile, uint16_t music) {
+    enqueue(pos, [tile, music](PendingWrite &entry) { entry.tile = Tile{tile, music}; });
+}
+
+void FieldWriteQueue::updateItems(const position &pos, std::vector<Item> items) {
+    enqueue(pos, [&items](PendingWrite &entry) { entry.items = std::move(items); });
+}
+
+void FieldWriteQueue::updateWarp(const position &pos, const std::optional<position> &target) {
+    enqueue(pos, [&target](PendingWrite &entry) { entry.warp = target; });
+}
+
+template <typename Update> void FieldWriteQueue::enqueue(const position &pos, Update update) {
+    std::lock_guard<std::mutex> lock(mutex);
+    update(pending[pos]);
+    ++queued;
+
+    if (!worker.joinable()) {
+        stopping = false;
+        worker = std::thread([this] { run(); });
+    }
+
+    wakeWorker.notify_one();
+}
+
+void FieldWriteQueue::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    if (!worker.joinable()) {
+        return;
+    }
+
+    flushTarget = queued;
+    wakeWorker.notify_one();
+    batchWritten.wait(lock, [this] { return written >= flushTarget; });
+}
+
+void FieldWriteQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (!worker.joinable()) {
+            return;
+        }
+
+        stopping = true;
+        wakeWorker.notify_one();
+    }
+
+    worker.join();
+}
+
+void FieldWriteQueue::run() {
+    affinity::pinCurrentThread(Config::instance().database_thread_cores(), "database");
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        wakeWorker.wait(lock, [this] { return !pending.empty() || stopping; });
+
+        if (pending.empty()) {
+            break;
+        }
+
+        // give further updates of the same fields the chance to be coalesced into this batch
+        wakeWorker.wait_for(lock, persistentFieldWriteDelay, [this] { return stopping || flushTarget > written; });
+
+        Batch batch;
+        std::swap(batch, pending);
+        const auto batchEnd = queued;
+
+        lock.unlock();
+        write(batch);
+        lock.lock();
+
+        written = batchEnd;
+        batchWritten.notify_all();
+    }
+}
+
+void FieldWriteQueue::write(const Batch &batch) {
+    using namespace Database;
+
+    try {
+        auto connection = ConnectionManager::getInstance().getConnection();
+
+        try {
+            connection->beginTransaction();
+
+            for (const auto &[pos, entry] : batch) {
+                write(pos, entry, connection);
+            }
+
+            connection->commitTransaction();
+            return;
+        } catch (std::exception &e) {
+            Logger::error(LogFacility::World)
+                    << "Error while writing " << batch.size() << " persistent fields, retrying one by one: " << e.what()
+                    << Log::end;
+            connection->rollbackTransaction();
+        }
+
+        // one broken field must not take the rest of the batch with it
+        for (const auto &[pos, entry] : batch) {
+            try {
+                connection->beginTransaction();
+                write(pos, entry, connection);
+                connection->commitTransaction();
+            } catch (std::exception &e) {
+                Logger::error(LogFacility::World)
+                        << "Error while writing persistent field " << pos << ": " << e.what() << Log::end;
+                connection->rollbackTransaction();
+            }
+        }
+    } catch (std::exception &e) {
+        Logger::error(LogFacility::World) << "Error while writing persistent fields: " << e.what() << Log::end;
+    }
+}
+
+void FieldWriteQueue::write(const position &pos, const PendingWrite &entry, const Database::PConnection &connection) {
+    using namespace Database;
+
+    if (entry.removeRow) {
+        static const PreparedQuery fieldQuery(
+                "delete_map_tile", "DELETE FROM {server}.map_tiles WHERE mt_x = $1 AND mt_y = $2 AND mt_z = $3");
+        fieldQuery.execute(connection, pos.x, pos.y, pos.z);
+    }
+
+    if (entry.insertRow && entry.tile) {
+        static const PreparedQuery fieldQuery(
+                "insert_map_tile",
+                "INSERT INTO {server}.map_tiles (mt_x, mt_y, mt_z, mt_tile, mt_music) VALUES ($1, $2, $3, $4, $5)");
+        fieldQuery.execute(connection, pos.x, pos.y, pos.z, entry.tile->tile, entry.tile->music);
+    } else if (entry.tile) {
+        static const PreparedQuery fieldQuery(
+                "update_map_tile",
+                "UPDATE {server}.map_tiles SET mt_tile = $1, mt_music = $2 "
+                "WHERE mt_x = $3 AND mt_y = $4 AND mt_z = $5");
+        fieldQuery.execute(connection, entry.tile->tile, entry.tile->music, pos.x, pos.y, pos.z);
+    }
+
+    if (entry.items) {
+        {
+            static const PreparedQuery itemQuery(
+                    "delete_map_items", "DELETE FROM {server}.map_items WHERE mi_x = $1 AND mi_y = $2 AND mi_z = $3");
+            itemQuery.execute(connection, pos.x, pos.y, pos.z);
+        }
+
+        if (!entry.items->empty()) {
+            InsertQuery itemQuery(connection);
+            const auto xColumn = itemQuery.addColumn("mi_x");
+            const auto yColumn = itemQuery.addColumn("mi_y");
+            const auto zColumn = itemQuery.addColumn("mi_z");
+            const auto stackPosColumn = itemQuery.addColumn("mi_stack_pos");
+            const auto itemColumn = itemQuery.addColumn("mi_item");
+            const auto qualityColumn = itemQuery.addColumn("mi_quality");
+            const auto numberColumn = itemQuery.addColumn("mi_number");
+            const auto wearColumn = itemQuery.addColumn("mi_wear");
+            itemQuery.addServerTable("map_items");
+
+            InsertQuery dataQuery(connection);
+            const auto xDataColumn = dataQuery.addColumn("mid_x");
+            const auto yDataColumn = dataQuery.addColumn("mid_y");
+            const auto zDataColumn = dataQuery.addColumn("mid_z");
+            const auto stackPosDataColumn = dataQuery.addColumn("mid_stack_pos");
+            const auto keyDataColumn = dataQuery.addColumn("mid_key");
+            const auto valueDataColumn = dataQuery.addColumn("mid_value");
+            dataQuery.addServerTable("map_item_data");
+
+            uint16_t stackPos = 0;
+
+            for (const auto &item : *entry.items) {
+                itemQuery.addValue<int16_t>(xColumn, pos.x);
+                itemQuery.addValue<int16_t>(yColumn, pos.y);
+                itemQuery.addValue<int16_t>(zColumn, pos.z);
+
+                itemQuery.addValue<uint16_t>(stackPosColumn, stackPos);
+                itemQuery.addValue<TYPE_OF_ITEM_ID>(itemColumn, item.getId());
+                itemQuery.addValue<uint16_t>(qualityColumn, item.getQuality());
+                itemQuery.addValue<uint16_t>(numberColumn, item.getNumber());
+                itemQuery.addValue<uint16_t>(wearColumn, item.getWear());
+
+                std::for_each(item.getDataBegin(), item.getDataEnd(), [&](const auto &data) {
+                    dataQuery.addValue<int16_t>(xDataColumn, pos.x);
+                    dataQuery.addValue<int16_t>(yDataColumn, pos.y);
+                    dataQuery.addValue<int16_t>(zDataColumn, pos.z);
+                    dataQuery.addValue<uint16_t>(stackPosDataColumn, stackPos);
+                    dataQuery.addValue<std::string>(keyDataColumn, data.first);
+                    dataQuery.addValue<std::string>(valueDataColumn, data.second);
+                });
+
+                ++stackPos;
+            }
+
+            itemQuery.execute();
+            dataQuery.execute();
+        }
+    }
+
+    if (entry.warp) {
+        {
+            static const PreparedQuery warpQuery(
+                    "delete_map_warp",
+                    "DELETE FROM {server}.map_warps WHERE mw_start_x = $1 AND mw_start_y = $2 AND mw_start_z = $3");
+            warpQuery.execute(connection, pos.x, pos.y, pos.z);
+        }
+
+        if (const auto &target = *entry.warp; target) {
+            static const PreparedQuery warpQuery(
+                    "insert_map_warp",
+                    "INSERT INTO {server}.map_warps (mw_start_x, mw_start_y, mw_start_z, mw_target_x, mw_target_y, "
+                    "mw_target_z) VALUES ($1, $2, $3, $4, $5, $6)");
+            warpQuery.execute(connection, pos.x, pos.y, pos.z, target->x, target->y, target->z);
+        }
+    }
+}
+
+} // namespace map
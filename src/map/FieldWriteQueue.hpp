@@ -0,0 +1,95 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FIELD_WRITE_QUEUE_HPP
+#define FIELD_WRITE_QUEUE_HPP
+
+#include "Item.hpp"
+#include "db/Connection.hpp"
+#include "globals.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace map {
+
+// Write-behind queue for the database rows of persistent fields. Updates to the same field are coalesced for
+// persistentFieldWriteDelay and then written by a worker thread in a single transaction.
+class FieldWriteQueue {
+public:
+    static auto get() -> FieldWriteQueue &;
+
+    FieldWriteQueue(const FieldWriteQueue &) = delete;
+    auto operator=(const FieldWriteQueue &) -> FieldWriteQueue & = delete;
+    FieldWriteQueue(FieldWriteQueue &&) = delete;
+    auto operator=(FieldWriteQueue &&) -> FieldWriteQueue & = delete;
+    ~FieldWriteQueue();
+
+    void insertField(const position &pos, uint16_t tile, uint16_t music);
+    void removeField(const position &pos);
+    void updateField(const position &pos, uint16_t tile, uint16_t music);
+    void updateItems(const position &pos, std::vector<Item> items);
+    void updateWarp(const position &pos, const std::optional<position> &target);
+
+    // blocks until everything queued so far has been written
+    void flush();
+    // flushes and terminates the worker, later updates start it again
+    void stop();
+
+private:
+    struct Tile {
+        uint16_t tile;
+        uint16_t music;
+    };
+
+    struct PendingWrite {
+        bool removeRow = false;
+        bool insertRow = false;
+        std::optional<Tile> tile;
+        std::optional<std::vector<Item>> items;
+        std::optional<std::optional<position>> warp;
+    };
+
+    using Batch = std::unordered_map<position, PendingWrite>;
+
+    std::mutex mutex;
+    std::condition_variable wakeWorker;
+    std::condition_variable batchWritten;
+    std::thread worker;
+    bool stopping = false;
+    Batch pending;
+    uint64_t queued = 0;
+    uint64_t written = 0;
+    uint64_t flushTarget = 0;
+
+    FieldWriteQueue() = default;
+
+    template <typename Update> void enqueue(const position &pos, Update update);
+    void run();
+    static void write(const Batch &batch);
+    static void write(const position &pos, const PendingWrite &entry, const Database::PConnection &connection);
+};
+
+} // namespace map
+
+#endif
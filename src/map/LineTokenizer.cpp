@@ -0,0 +1,88 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "map/LineTokenizer.hpp"
+
+namespace map {
+
+auto LineTokenizer::separator(char expected) -> bool {
+    if (atEnd() || line[offset] != expected) {
+        return false;
+    }
+
+    ++offset;
+    return true;
+}
+
+auto LineTokenizer::literal(std::string_view expected) -> bool {
+    if (line.substr(offset, expected.length()) != expected) {
+        return false;
+    }
+
+    offset += expected.length();
+    return true;
+}
+
+auto LineTokenizer::anyOf(std::string_view candidates, char &found) -> bool {
+    if (atEnd() || candidates.find(line[offset]) == std::string_view::npos) {
+        return false;
+    }
+
+    found = line[offset++];
+    return true;
+}
+
+auto LineTokenizer::escaped(std::string &token) -> bool {
+    token.clear();
+
+    while (!atEnd()) {
+        const char current = line[offset];
+
+        if (current == ';' || current == '=') {
+            return true;
+        }
+
+        if (current == '\\') {
+            if (offset + 1 == line.length()) {
+                return false;
+            }
+
+            const char escapedChar = line[offset + 1];
+
+            if (escapedChar != '\\' && escapedChar != ';' && escapedChar != '=') {
+                return false;
+            }
+
+            token += escapedChar;
+            offset += 2;
+        } else {
+            token += current;
+            ++offset;
+        }
+    }
+
+    return true;
+}
+
+auto LineTokenizer::atEnd() const -> bool { return offset == line.length(); }
+
+auto LineTokenizer::peek() const -> char { return atEnd() ? '\0' : line[offset]; }
+
+auto LineTokenizer::rest() const -> std::string_view { return line.substr(offset); }
+
+} // namespace map
@@ -0,0 +1,71 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LINE_TOKENIZER_HPP
+#define LINE_TOKENIZER_HPP
+
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace map {
+
+// Sequential reader for the lines of map editor files, e.g. "12;7;3;0;key=value"
+class LineTokenizer {
+    std::string_view line;
+    size_t offset = 0;
+
+public:
+    explicit LineTokenizer(std::string_view line) : line(line) {}
+
+    // reads a decimal number, a leading minus sign is only accepted for signed types
+    template <typename T> auto number(T &n) -> bool {
+        static_assert(std::is_integral_v<T>);
+        const auto *begin = line.data() + offset;
+        const auto *end = line.data() + line.length();
+
+        if (begin == end || (*begin == '-' && !std::is_signed_v<T>)) {
+            return false;
+        }
+
+        auto [next, error] = std::from_chars(begin, end, n);
+
+        if (error != std::errc()) {
+            return false;
+        }
+
+        offset = next - line.data();
+        return true;
+    }
+
+    auto separator(char expected) -> bool;
+    auto literal(std::string_view expected) -> bool;
+    auto anyOf(std::string_view candidates, char &found) -> bool;
+
+    // reads up to the next unescaped ';' or '=', resolving the escapes \\, \; and \=
+    auto escaped(std::string &token) -> bool;
+
+    [[nodiscard]] auto atEnd() const -> bool;
+    [[nodiscard]] auto peek() const -> char;
+    [[nodiscard]] auto rest() const -> std::string_view;
+};
+
+} // namespace map
+
+#endif
@@ -19,12 +19,16 @@
 #include "map/Map.hpp"
 
 #include "Logger.hpp"
+#include "MemoryUsage.hpp"
 #include "globals.hpp"
+#include "map/LineTokenizer.hpp"
 #include "stream.hpp"
 
-#include <boost/algorithm/string/replace.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
 #include <limits>
-#include <regex>
+#include <sstream>
 #include <vector>
 
 namespace map {
@@ -33,76 +37,154 @@ Map::Map(std::string name, position origin, uint16_t width, uint16_t height)
         : origin(origin), width(width), height(height),
 
           name(std::move(name)) {
-    for (auto x = origin.x; x < origin.x + width; ++x) {
-        std::vector<Field> column;
+    fields.reserve(static_cast<size_t>(width) * height);
 
+    for (auto x = origin.x; x < origin.x + width; ++x) {
         for (auto y = origin.y; y < origin.y + height; ++y) {
-            column.emplace_back(position(x, y, origin.z));
+            fields.emplace_back(position(x, y, origin.z));
         }
-
-        fields.push_back(std::move(column));
     }
+
+    ageingCandidate.assign(fields.size(), false);
 }
 
 Map::Map(std::string name, position origin, uint16_t width, uint16_t height, uint16_t tile)
         : Map(std::move(name), origin, width, height) {
-    for (auto &column : fields) {
-        for (auto &field : column) {
-            field.setTileId(tile);
-        }
+    for (auto &field : fields) {
+        field.setTileId(tile);
     }
 }
 
-auto Map::at(int16_t x, int16_t y) -> Field & { return fields[convertWorldXToMap(x)][convertWorldYToMap(y)]; }
+auto Map::instantiate(std::string name, position origin, std::shared_ptr<const MapSnapshot> mapTemplate) -> Map {
+    const auto &header = mapTemplate->getHeader();
+    Map map{std::move(name), origin, header.width, header.height};
+    map.instance = true;
+    map.restore(std::move(mapTemplate));
+    return map;
+}
+
+auto Map::isInstance() const -> bool { return instance; }
+
+auto Map::at(int16_t x, int16_t y) -> Field & {
+    const auto index = localIndex(convertWorldXToMap(x), convertWorldYToMap(y));
+    hydrate(index);
+    dirty = true;
+    addAgeingCandidate(index);
+    return fields[index];
+}
 
 auto Map::at(int16_t x, int16_t y) const -> const Field & {
-    return fields[convertWorldXToMap(x)][convertWorldYToMap(y)];
+    const auto index = localIndex(convertWorldXToMap(x), convertWorldYToMap(y));
+    hydrate(index);
+    return fields[index];
+}
+
+auto Map::fieldsAlong(int16_t x, int16_t y, int16_t xStep, Coordinate length, const Field **out) const
+        -> Coordinate {
+    const auto mapX = convertWorldXToMap(x);
+    const auto mapY = convertWorldYToMap(y);
+    const auto columnsLeft = xStep > 0 ? width - mapX : xStep < 0 ? mapX + 1 : length;
+    const Coordinate count = std::min<Coordinate>({length, height - mapY, columnsLeft});
+    // column-major, so the fields lie at a fixed distance from each other
+    const auto stride = static_cast<ptrdiff_t>(height) * xStep + 1;
+    auto index = static_cast<ptrdiff_t>(localIndex(mapX, mapY));
+
+    for (Coordinate i = 0; i < count; ++i, index += stride) {
+        if (i + 1 < count) {
+            __builtin_prefetch(&fields[index + stride]);
+        }
+
+        hydrate(index);
+        out[i] = &fields[index];
+    }
+
+    return count;
 }
 
 auto Map::at(const MapPosition &pos) -> Field & { return at(pos.x, pos.y); }
 
 auto Map::at(const MapPosition &pos) const -> const Field & { return at(pos.x, pos.y); }
 
-void Map::save(const std::string &name) const {
-    Logger::debug(LogFacility::World) << "Saving map " << name << Log::end;
+auto Map::isDirty() const -> bool { return dirty; }
 
-    std::ofstream map{name + "_map", std::ios::binary | std::ios::out};
-    std::ofstream items{name + "_item", std::ios::binary | std::ios::out};
-    std::ofstream warps{name + "_warp", std::ios::binary | std::ios::out};
-    std::ofstream containers{name + "_container", std::ios::binary | std::ios::out};
+auto Map::takeSnapshotImage(bool markSaved) const -> std::string {
+    hydrateAll();
 
-    if (map.good() && items.good() && warps.good() && containers.good()) {
-        writeToStream(map, width);
-        writeToStream(map, height);
-        writeToStream(map, origin);
+    std::ostringstream payload{std::ios::binary | std::ios::out};
+    std::vector<MapSnapshot::PayloadEntry> index;
 
-        for (const auto &column : fields) {
-            for (const auto &field : column) {
-                field.save(map, items, warps, containers);
-            }
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (fields[i].hasPayload()) {
+            index.push_back({static_cast<uint32_t>(i), static_cast<uint32_t>(payload.tellp())});
+            fields[i].savePayload(payload);
         }
-    } else {
-        Logger::error(LogFacility::World) << "Saving map failed: " << name << Log::end;
     }
+
+    MapSnapshot::Header header{};
+    header.magic = MapSnapshot::magic;
+    header.version = MapSnapshot::currentVersion;
+    header.width = width;
+    header.height = height;
+    header.originX = static_cast<int16_t>(origin.x);
+    header.originY = static_cast<int16_t>(origin.y);
+    header.originZ = static_cast<int16_t>(origin.z);
+    header.payloadCount = index.size();
+    header.payloadOffset = sizeof(MapSnapshot::Header) + fields.size() * sizeof(TileRecord) +
+                           index.size() * sizeof(MapSnapshot::PayloadEntry);
+
+    std::ostringstream image{std::ios::binary | std::ios::out};
+    writeToStream(image, header);
+
+    for (const auto &field : fields) {
+        writeToStream(image, field.getTileRecord());
+    }
+
+    for (const auto &entry : index) {
+        writeToStream(image, entry);
+    }
+
+    image << payload.str();
+
+    if (markSaved) {
+        dirty = false;
+    }
+
+    return image.str();
 }
 
-const std::regex headerExpression{R"(^[VLXYWH]: -?\d+$)"};
-const std::regex tileExpression{R"(^(\d+);(\d+);(\d+);(\d+)$)"};
-const std::regex itemExpression{R"(^(\d+);(\d+);(\d+);(\d+)(;.*)?$)"};
-const std::regex warpExpression{R"(^(\d+);(\d+);(-?\d+);(-?\d+);(-?\d+)$)"};
-const std::regex dataExpression{R"(;([^\\;=]*(?:\\[\\;=][^\\;=]*)*)=([^\\;=]*(?:\\[\\;=][^\\;=]*)*)(?:;.*)?)"};
+auto Map::writeSnapshot(const std::string &name, const std::string &image) -> bool {
+    Logger::debug(LogFacility::World) << "Saving map " << name << Log::end;
+
+    const auto fileName = name + "_snapshot";
+    const auto temporaryFileName = fileName + ".tmp";
+    std::ofstream file{temporaryFileName, std::ios::binary | std::ios::out | std::ios::trunc};
+    file << image;
+    file.close();
+
+    if (!file.good() || std::rename(temporaryFileName.c_str(), fileName.c_str()) != 0) {
+        Logger::error(LogFacility::World) << "Saving map failed: " << name << Log::end;
+        return false;
+    }
+
+    return true;
+}
 
 auto Map::import(const std::string &importDir, const std::string &mapName) -> bool {
     bool success = importFields(importDir, mapName);
     success and_eq importWarps(importDir, mapName);
     success and_eq importItems(importDir, mapName);
+    indexAgeingCandidates();
     return success;
 }
 
-auto Map::importFields(const std::string &importDir, const std::string &mapName) -> bool {
-    using std::regex_match;
-    using std::smatch;
+auto Map::isHeaderLine(const std::string &line) -> bool {
+    LineTokenizer tokens{line};
+    char header = 0;
+    int16_t value = 0;
+    return tokens.anyOf("VLXYWH", header) && tokens.literal(": ") && tokens.number(value) && tokens.atEnd();
+}
 
+auto Map::importFields(const std::string &importDir, const std::string &mapName) -> bool {
     const std::string fileName = mapName + ".tiles.txt";
     std::ifstream mapFile(importDir + fileName);
 
@@ -121,41 +203,33 @@ auto Map::importFields(const std::string &importDir, const std::string &mapName)
         ++lineNumber;
 
         if (line.length() != 0 && line[0] != '#') {
-            if (headerLinesSkipped < headerLines && regex_match(line, headerExpression)) {
+            if (headerLinesSkipped < headerLines && isHeaderLine(line)) {
                 ++headerLinesSkipped;
                 continue;
             }
 
-            if (smatch fieldMatch; regex_match(line, fieldMatch, tileExpression)) {
-                const auto xPosition = 1;
-                auto x = std::numeric_limits<uint16_t>::max();
-                stringToNumber(fieldMatch[xPosition].str(), x);
+            LineTokenizer tokens{line};
+            auto x = std::numeric_limits<uint16_t>::max();
+            auto y = std::numeric_limits<uint16_t>::max();
+            uint16_t tile = 0;
+            uint16_t music = 0;
 
+            if (tokens.number(x) && tokens.separator(';') && tokens.number(y) && tokens.separator(';') &&
+                tokens.number(tile) && tokens.separator(';') && tokens.number(music) && tokens.atEnd()) {
                 if (x >= width) {
                     Logger::error(LogFacility::Script)
                             << fileName << ": x must be less than width in line " << lineNumber << Log::end;
                     success = false;
                 }
 
-                const auto yPosition = 2;
-                auto y = std::numeric_limits<uint16_t>::max();
-                stringToNumber(fieldMatch[yPosition].str(), y);
-
                 if (y >= height) {
                     Logger::error(LogFacility::Script)
                             << fileName << ": y must be less than height in line " << lineNumber << Log::end;
                     success = false;
                 }
 
-                const auto tilePosition = 3;
-                const auto musicPosition = 4;
-                auto tile = 0;
-                auto music = 0;
-                stringToNumber(fieldMatch[tilePosition].str(), tile);
-                stringToNumber(fieldMatch[musicPosition].str(), music);
-
                 if (success) {
-                    auto &field = fields[x][y];
+                    auto &field = fields[localIndex(x, y)];
 
                     if ((field.getTileCode() != 0) || (field.getMusicId() != 0)) {
                         Logger::warn(LogFacility::Script)
@@ -180,9 +254,6 @@ auto Map::importFields(const std::string &importDir, const std::string &mapName)
 }
 
 auto Map::importItems(const std::string &importDir, const std::string &mapName) -> bool {
-    using std::regex_match;
-    using std::smatch;
-
     const std::string fileName = mapName + ".items.txt";
     std::ifstream itemFile(importDir + fileName);
 
@@ -199,34 +270,27 @@ auto Map::importItems(const std::string &importDir, const std::string &mapName)
         ++lineNumber;
 
         if (line.length() != 0 && line[0] != '#') {
-            if (smatch itemMatch; regex_match(line, itemMatch, itemExpression)) {
-                const auto xPosition = 1;
-                auto x = std::numeric_limits<uint16_t>::max();
-                stringToNumber(itemMatch[xPosition].str(), x);
-
+            LineTokenizer tokens{line};
+            auto x = std::numeric_limits<uint16_t>::max();
+            auto y = std::numeric_limits<uint16_t>::max();
+            TYPE_OF_ITEM_ID itemId = 0;
+            uint16_t quality = 0;
+
+            if (tokens.number(x) && tokens.separator(';') && tokens.number(y) && tokens.separator(';') &&
+                tokens.number(itemId) && tokens.separator(';') && tokens.number(quality) &&
+                (tokens.atEnd() || tokens.peek() == ';')) {
                 if (x >= width) {
                     Logger::error(LogFacility::Script)
                             << fileName << ": x must be less than width in line " << lineNumber << Log::end;
                     success = false;
                 }
 
-                const auto yPosition = 2;
-                auto y = std::numeric_limits<uint16_t>::max();
-                stringToNumber(itemMatch[yPosition].str(), y);
-
                 if (y >= height) {
                     Logger::error(LogFacility::Script)
                             << fileName << ": y must be less than height in line " << lineNumber << Log::end;
                     success = false;
                 }
 
-                const auto idPosition = 3;
-                const auto qualityPosition = 4;
-                auto itemId = 0;
-                stringToNumber(itemMatch[idPosition].str(), itemId);
-                auto quality = 0;
-                stringToNumber(itemMatch[qualityPosition].str(), quality);
-
                 if (quality > Item::maximumQuality) {
                     Logger::error(LogFacility::Script) << fileName << ": quality must not exceed "
                                                        << Item::maximumQuality << " in line " << lineNumber << Log::end;
@@ -239,16 +303,14 @@ auto Map::importItems(const std::string &importDir, const std::string &mapName)
                 item.setNumber(1);
                 item.makePermanent();
 
-                const auto dataPosition = 5;
-                std::string data = itemMatch[dataPosition];
+                std::string key;
+                std::string value;
 
-                while (data.length() > 0) {
-                    if (smatch dataMatch; regex_match(data, dataMatch, dataExpression)) {
-                        const auto keyPosition = 1;
-                        const auto valuePosition = 2;
-                        std::string key = dataMatch[keyPosition];
-                        std::string value = dataMatch[valuePosition];
+                while (!tokens.atEnd()) {
+                    const auto sequence = tokens.rest();
 
+                    if (tokens.separator(';') && tokens.escaped(key) && tokens.separator('=') &&
+                        tokens.escaped(value) && (tokens.atEnd() || tokens.peek() == ';')) {
                         if (key.length() == 0) {
                             Logger::error(LogFacility::Script) << fileName
                                                                << ": data key must not have "
@@ -279,14 +341,9 @@ auto Map::importItems(const std::string &importDir, const std::string &mapName)
                             success = false;
                         }
 
-                        data.erase(0, key.length() + value.length() + 2);
-
-                        unescape(key);
-                        unescape(value);
-
                         item.setData(key, value);
                     } else {
-                        Logger::error(LogFacility::Script) << fileName << ": invalid data sequence '" << data
+                        Logger::error(LogFacility::Script) << fileName << ": invalid data sequence '" << sequence
                                                            << "' in line " << lineNumber << Log::end;
                         success = false;
                         break;
@@ -294,7 +351,7 @@ auto Map::importItems(const std::string &importDir, const std::string &mapName)
                 }
 
                 if (success) {
-                    auto &field = fields[x][y];
+                    auto &field = fields[localIndex(x, y)];
 
                     if (item.isContainer()) {
                         field.addContainerOnStack(item, nullptr);
@@ -316,18 +373,7 @@ auto Map::importItems(const std::string &importDir, const std::string &mapName)
     return success;
 }
 
-void Map::unescape(std::string &input) {
-    using boost::algorithm::replace_all;
-
-    replace_all(input, "\\\\", "\\");
-    replace_all(input, "\\=", "=");
-    replace_all(input, "\\;", ";");
-}
-
 auto Map::importWarps(const std::string &importDir, const std::string &mapName) -> bool {
-    using std::regex_match;
-    using std::smatch;
-
     const std::string fileName = mapName + ".warps.txt";
     std::ifstream warpFile(importDir + fileName);
 
@@ -344,44 +390,37 @@ auto Map::importWarps(const std::string &importDir, const std::string &mapName)
         ++lineNumber;
 
         if (line.length() != 0 && line[0] != '#') {
-            if (smatch warpMatch; regex_match(line, warpMatch, warpExpression)) {
-                const auto warpXPosition = 1;
-                auto x = std::numeric_limits<uint16_t>::max();
-                stringToNumber(warpMatch[warpXPosition].str(), x);
-
+            LineTokenizer tokens{line};
+            auto x = std::numeric_limits<uint16_t>::max();
+            auto y = std::numeric_limits<uint16_t>::max();
+            int16_t targetX = 0;
+            int16_t targetY = 0;
+            int16_t targetZ = 0;
+
+            if (tokens.number(x) && tokens.separator(';') && tokens.number(y) && tokens.separator(';') &&
+                tokens.number(targetX) && tokens.separator(';') && tokens.number(targetY) && tokens.separator(';') &&
+                tokens.number(targetZ) && tokens.atEnd()) {
                 if (x >= width) {
                     Logger::error(LogFacility::Script)
                             << fileName << ": x must be less than width in line " << lineNumber << Log::end;
                     success = false;
                 }
 
-                const auto warpYPosition = 2;
-                auto y = std::numeric_limits<uint16_t>::max();
-                stringToNumber(warpMatch[warpYPosition].str(), y);
-
                 if (y >= height) {
                     Logger::error(LogFacility::Script)
                             << fileName << ": y must be less than height in line " << lineNumber << Log::end;
                     success = false;
                 }
 
-                const auto targetXPosition = 3;
-                const auto targetYPosition = 4;
-                const auto targetZPosition = 5;
-                position target{};
-                stringToNumber(warpMatch[targetXPosition].str(), target.x);
-                stringToNumber(warpMatch[targetYPosition].str(), target.y);
-                stringToNumber(warpMatch[targetZPosition].str(), target.z);
-
                 if (success) {
-                    auto &field = fields[x][y];
+                    auto &field = fields[localIndex(x, y)];
 
                     if (field.isWarp()) {
                         Logger::warn(LogFacility::Script)
                                 << fileName << ": warp on (" << x << ", " << y << ") is already present, ignoring line "
                                 << lineNumber << Log::end;
                     } else {
-                        field.setWarp(target);
+                        field.setWarp(position(targetX, targetY, targetZ));
                     }
                 }
             } else {
@@ -403,6 +442,65 @@ auto Map::load(const std::string &name) -> bool {
 
     this->name = name;
 
+    if (std::ifstream{name + "_snapshot"}.good()) {
+        if (loadSnapshot(name + "_snapshot")) {
+            return true;
+        }
+    } else if (loadLegacy(name)) {
+        return true;
+    }
+
+    Logger::error(LogFacility::World) << "Map: ERROR LOADING FILES: " << name << Log::end;
+
+    return false;
+}
+
+auto Map::loadSnapshot(const std::string &fileName) -> bool {
+    std::shared_ptr<const MapSnapshot> newSnapshot;
+
+    try {
+        newSnapshot = std::make_shared<const MapSnapshot>(fileName);
+    } catch (const MapError &) {
+        return false;
+    }
+
+    const auto &header = newSnapshot->getHeader();
+
+    if (header.width != width || header.height != height) {
+        return false;
+    }
+
+    origin = position(header.originX, header.originY, header.originZ);
+    restore(std::move(newSnapshot));
+    return true;
+}
+
+void Map::restore(std::shared_ptr<const MapSnapshot> source) {
+    for (size_t i = 0; i < fields.size(); ++i) {
+        fields[i].restore(source->tileAt(i));
+    }
+
+    const auto payloadCount = source->getHeader().payloadCount;
+    pendingPayload.assign(fields.size(), false);
+
+    for (size_t i = 0; i < payloadCount; ++i) {
+        const auto field = source->payloadEntryAt(i).field;
+
+        if (field < fields.size() && !pendingPayload[field]) {
+            pendingPayload[field] = true;
+            ++pendingPayloads;
+        }
+    }
+
+    if (pendingPayloads > 0) {
+        snapshot = std::move(source);
+    }
+
+    dirty = false;
+    indexAgeingCandidates();
+}
+
+auto Map::loadLegacy(const std::string &name) -> bool {
     std::ifstream map{name + "_map", std::ios::binary | std::ios::in};
     std::ifstream items{name + "_item", std::ios::binary | std::ios::in};
     std::ifstream warps{name + "_warp", std::ios::binary | std::ios::in};
@@ -417,29 +515,103 @@ auto Map::load(const std::string &name) -> bool {
         readFromStream(map, origin);
 
         if (newWidth == width && newHeight == height) {
-            for (auto &column : fields) {
-                for (auto &field : column) {
-                    field.load(map, items, warps, containers);
-                }
+            for (auto &field : fields) {
+                field.load(map, items, warps, containers);
             }
 
+            indexAgeingCandidates();
             return true;
         }
     }
 
-    Logger::error(LogFacility::World) << "Map: ERROR LOADING FILES: " << name << Log::end;
-
     return false;
 }
 
-void Map::age() {
-    for (auto &row : fields) {
-        for (auto &field : row) {
-            field.age();
+void Map::hydrate(size_t index) const {
+    if (pendingPayloads == 0 || !pendingPayload[index]) {
+        return;
+    }
+
+    pendingPayload[index] = false;
+    --pendingPayloads;
+
+    if (const auto payload = snapshot->payloadOf(index); payload) {
+        MemoryInputBuffer buffer{payload->first, payload->second};
+        std::istream stream{&buffer};
+        fields[index].loadPayload(stream);
+    }
+
+    if (pendingPayloads == 0) {
+        snapshot.reset();
+        pendingPayload.clear();
+    }
+}
+
+void Map::hydrateAll() const {
+    for (size_t i = 0; pendingPayloads > 0 && i < fields.size(); ++i) {
+        hydrate(i);
+    }
+}
+
+void Map::addAgeingCandidate(size_t index) {
+    if (!ageingCandidate[index]) {
+        ageingCandidate[index] = true;
+        ageingFields.push_back(static_cast<uint32_t>(index));
+    }
+}
+
+void Map::indexAgeingCandidates() {
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if ((pendingPayloads > 0 && pendingPayload[i]) || fields[i].hasPayload()) {
+            addAgeingCandidate(i);
         }
     }
 }
 
+void Map::updateMovementCosts() {
+    for (auto &field : fields) {
+        field.updateMovementCost();
+    }
+}
+
+void Map::age() { publishAgedFields(ageFields()); }
+
+auto Map::ageFields() -> std::vector<uint32_t> {
+    std::vector<uint32_t> changed;
+    std::vector<uint32_t> remaining;
+
+    for (const auto index : ageingFields) {
+        hydrate(index);
+        auto &field = fields[index];
+
+        if (!field.isPerishable()) {
+            ageingCandidate[index] = false;
+            continue;
+        }
+
+        dirty = true;
+
+        if (field.ageItems()) {
+            changed.push_back(index);
+        }
+
+        if (field.isPerishable()) {
+            remaining.push_back(index);
+        } else {
+            ageingCandidate[index] = false;
+        }
+    }
+
+    ageingFields = std::move(remaining);
+    return changed;
+}
+
+void Map::publishAgedFields(const std::vector<uint32_t> &changed) const {
+    for (const auto index : changed) {
+        fields[index].itemStackAged();
+    }
+}
+
 auto Map::getHeight() const -> uint16_t { return height; }
 
 auto Map::getWidth() const -> uint16_t { return width; }
@@ -456,6 +628,24 @@ auto Map::getLevel() const -> int16_t { return origin.z; }
 
 auto Map::getName() const -> const std::string & { return name; }
 
+auto Map::memoryUsage() const -> size_t {
+    auto bytes = memory::of(fields) + memory::of(pendingPayload) + memory::of(ageingCandidate) +
+                 memory::of(ageingFields) + memory::of(name);
+
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (pendingPayloads == 0 || !pendingPayload[i]) {
+            bytes += fields[i].memoryUsage();
+        }
+    }
+
+    return bytes;
+}
+
+// templates are counted once by the world map, not by each of their instances
+auto Map::mappedBytes() const -> size_t { return snapshot && !instance ? snapshot->getSize() : 0; }
+
+inline auto Map::localIndex(uint16_t x, uint16_t y) const -> size_t { return static_cast<size_t>(x) * height + y; }
+
 inline auto Map::convertWorldXToMap(int16_t x) const -> uint16_t {
     uint16_t temp = x - origin.x;
 
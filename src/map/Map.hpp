@@ -20,9 +20,12 @@
 #define MAP_HPP
 
 #include "Container.hpp"
+#include "HugePages.hpp"
 #include "globals.hpp"
 #include "map/Field.hpp"
+#include "map/MapSnapshot.hpp"
 
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -32,7 +35,17 @@ class Map {
     position origin;
     uint16_t width;
     uint16_t height;
-    std::vector<std::vector<Field>> fields;
+    // fields restored from a snapshot decode their items lazily on first access, hence mutable
+    mutable std::vector<Field, hugepages::Allocator<Field>> fields; // column-major, see localIndex
+    mutable std::vector<bool> pendingPayload;
+    mutable size_t pendingPayloads = 0;
+    // shared by all instances of a template, see instantiate
+    mutable std::shared_ptr<const MapSnapshot> snapshot;
+    mutable bool dirty = true; // set on mutable field access, cleared when a snapshot image is taken
+    bool instance = false;     // made from a template, never saved
+    // fields which may hold perishable items; every mutable field access adds to it, ageing prunes it
+    std::vector<bool> ageingCandidate;
+    std::vector<uint32_t> ageingFields;
     std::string name;
 
 public:
@@ -44,16 +57,31 @@ public:
     auto operator=(Map &&) -> Map & = default;
     ~Map() = default;
 
+    // a map at origin with the fields of the template, whose items are copied from it only once a field is accessed
+    static auto instantiate(std::string name, position origin, std::shared_ptr<const MapSnapshot> mapTemplate)
+            -> Map;
+    [[nodiscard]] auto isInstance() const -> bool;
+
     auto import(const std::string &importDir, const std::string &mapName) -> bool;
     auto load(const std::string &name) -> bool;
-    void save(const std::string &name) const;
+    [[nodiscard]] auto isDirty() const -> bool;
+    // a backup leaves the map dirty, so that the next save still writes it
+    [[nodiscard]] auto takeSnapshotImage(bool markSaved = true) const -> std::string;
+    static auto writeSnapshot(const std::string &name, const std::string &image) -> bool;
 
     auto at(int16_t x, int16_t y) -> Field &;
     [[nodiscard]] auto at(int16_t x, int16_t y) const -> const Field &;
     auto at(const MapPosition & /*pos*/) -> Field &;
     [[nodiscard]] auto at(const MapPosition & /*pos*/) const -> const Field &;
+    // fields from (x, y) on, stepping x by xStep and y by one, until length fields are read or the map ends;
+    // returns the number of fields written to out
+    auto fieldsAlong(int16_t x, int16_t y, int16_t xStep, Coordinate length, const Field **out) const -> Coordinate;
 
     void age();
+    void updateMovementCosts();
+    // ages the field data only and returns the fields whose item stack changed, see publishAgedFields
+    [[nodiscard]] auto ageFields() -> std::vector<uint32_t>;
+    void publishAgedFields(const std::vector<uint32_t> &changed) const;
 
     [[nodiscard]] auto getMinX() const -> int16_t;
     [[nodiscard]] auto getMinY() const -> int16_t;
@@ -66,12 +94,26 @@ public:
 
     [[nodiscard]] auto intersects(const Map &map) const -> bool;
 
+    // estimated heap bytes of the map and its fields, fields not yet restored from the snapshot are left to
+    // mappedBytes
+    [[nodiscard]] auto memoryUsage() const -> size_t;
+    [[nodiscard]] auto mappedBytes() const -> size_t;
+
 private:
     auto importFields(const std::string &importDir, const std::string &mapName) -> bool;
     auto importItems(const std::string &importDir, const std::string &mapName) -> bool;
     auto importWarps(const std::string &importDir, const std::string &mapName) -> bool;
-    static void unescape(std::string &input);
+    static auto isHeaderLine(const std::string &line) -> bool;
+
+    auto loadSnapshot(const std::string &fileName) -> bool;
+    void restore(std::shared_ptr<const MapSnapshot> source);
+    auto loadLegacy(const std::string &name) -> bool;
+    void hydrate(size_t index) const;
+    void hydrateAll() const;
+    void addAgeingCandidate(size_t index);
+    void indexAgeingCandidates();
 
+    [[nodiscard]] inline auto localIndex(uint16_t x, uint16_t y) const -> size_t;
     [[nodiscard]] inline auto convertWorldXToMap(int16_t x) const -> uint16_t;
     [[nodiscard]] inline auto convertWorldYToMap(int16_t y) const -> uint16_t;
 };
@@ -0,0 +1,128 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "map/MapSnapshot.hpp"
+
+#include "Logger.hpp"
+#include "globals.hpp"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace map {
+
+MapSnapshot::MapSnapshot(const std::string &fileName) {
+    const int fd = open(fileName.c_str(), O_RDONLY); // NOLINT(cppcoreguidelines-pro-type-vararg)
+
+    if (fd == -1) {
+        throw MapError();
+    }
+
+    struct stat fileStatus {};
+
+    if (fstat(fd, &fileStatus) == -1 || static_cast<size_t>(fileStatus.st_size) < sizeof(Header)) {
+        close(fd);
+        throw MapError();
+    }
+
+    size = fileStatus.st_size;
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+        throw MapError();
+    }
+
+    data = static_cast<const char *>(mapping);
+    std::memcpy(&header, data, sizeof(Header));
+
+    const auto fields = static_cast<size_t>(header.width) * header.height;
+    const bool valid = header.magic == magic && header.version == currentVersion &&
+                       tilesOffset() + fields * sizeof(TileRecord) <= indexOffset() &&
+                       indexOffset() + header.payloadCount * sizeof(PayloadEntry) <= header.payloadOffset &&
+                       header.payloadOffset <= size;
+
+    if (!valid) {
+        Logger::error(LogFacility::World) << "Invalid map snapshot: " << fileName << Log::end;
+        munmap(const_cast<char *>(data), size); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+        throw MapError();
+    }
+}
+
+MapSnapshot::~MapSnapshot() {
+    munmap(const_cast<char *>(data), size); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+}
+
+auto MapSnapshot::getHeader() const -> const Header & { return header; }
+
+auto MapSnapshot::tileAt(size_t field) const -> TileRecord {
+    TileRecord record{};
+    std::memcpy(&record, data + tilesOffset() + field * sizeof(TileRecord), sizeof(TileRecord));
+    return record;
+}
+
+auto MapSnapshot::payloadEntryAt(size_t entry) const -> PayloadEntry {
+    PayloadEntry payloadEntry{};
+    std::memcpy(&payloadEntry, data + indexOffset() + entry * sizeof(PayloadEntry), sizeof(PayloadEntry));
+    return payloadEntry;
+}
+
+auto MapSnapshot::payloadOf(size_t field) const -> std::optional<Payload> {
+    size_t first = 0;
+    size_t last = header.payloadCount;
+
+    while (first < last) {
+        const auto middle = first + (last - first) / 2;
+
+        if (payloadEntryAt(middle).field < field) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+
+    if (first == header.payloadCount) {
+        return {};
+    }
+
+    const auto entry = payloadEntryAt(first);
+
+    if (entry.field != field) {
+        return {};
+    }
+
+    const auto end = first + 1 < header.payloadCount ? header.payloadOffset + payloadEntryAt(first + 1).offset : size;
+    const auto begin = header.payloadOffset + entry.offset;
+
+    if (begin > end || end > size) {
+        return {};
+    }
+
+    return Payload{data + begin, data + end};
+}
+
+auto MapSnapshot::tilesOffset() const -> size_t { return sizeof(Header); }
+
+auto MapSnapshot::indexOffset() const -> size_t {
+    return tilesOffset() + static_cast<size_t>(header.width) * header.height * sizeof(TileRecord);
+}
+
+} // namespace map
@@ -0,0 +1,87 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MAP_SNAPSHOT_HPP
+#define MAP_SNAPSHOT_HPP
+
+#include "map/Field.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace map {
+
+// Read-only view of a map snapshot file mapped into memory.
+//
+// Layout: Header, one TileRecord per field in column-major order, payloadCount PayloadEntry records sorted by
+// field index and finally the payload section with items, warp and containers of every field that has any.
+class MapSnapshot {
+public:
+    static constexpr uint32_t magic = 0x504d4c49; // "ILMP"
+    static constexpr uint16_t currentVersion = 1;
+
+    struct Header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t width;
+        uint16_t height;
+        int16_t originX;
+        int16_t originY;
+        int16_t originZ;
+        uint32_t payloadCount;
+        uint32_t reserved;
+        uint64_t payloadOffset;
+    };
+
+    struct PayloadEntry {
+        uint32_t field;
+        uint32_t offset; // relative to Header::payloadOffset
+    };
+
+    static_assert(sizeof(Header) == 32, "snapshot header layout must not depend on padding");
+
+    using Payload = std::pair<const char *, const char *>;
+
+    explicit MapSnapshot(const std::string &fileName);
+    MapSnapshot(const MapSnapshot &) = delete;
+    auto operator=(const MapSnapshot &) -> MapSnapshot & = delete;
+    MapSnapshot(MapSnapshot &&) = delete;
+    auto operator=(MapSnapshot &&) -> MapSnapshot & = delete;
+    ~MapSnapshot();
+
+    [[nodiscard]] auto getHeader() const -> const Header &;
+    [[nodiscard]] auto tileAt(size_t field) const -> TileRecord;
+    [[nodiscard]] auto payloadEntryAt(size_t entry) const -> PayloadEntry;
+    [[nodiscard]] auto payloadOf(size_t field) const -> std::optional<Payload>;
+    // bytes of the mapped file
+    [[nodiscard]] auto getSize() const -> size_t { return size; }
+
+private:
+    const char *data = nullptr;
+    size_t size = 0;
+    Header header{};
+
+    [[nodiscard]] auto tilesOffset() const -> size_t;
+    [[nodiscard]] auto indexOffset() const -> size_t;
+};
+
+} // namespace map
+
+#endif
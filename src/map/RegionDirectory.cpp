@@ -0,0 +1,103 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "map/RegionDirectory.hpp"
+
+#include "map/Map.hpp"
+
+#include <algorithm>
+
+namespace map {
+
+void RegionDirectory::insert(const Map &map, size_t index) {
+    const Region region{map.getMinX(), map.getMinY(), map.getMaxX(), map.getMaxY(), index};
+    const auto z = map.getLevel();
+
+    for (auto cx = chunkCoordinate(region.minX); cx <= chunkCoordinate(region.maxX); ++cx) {
+        for (auto cy = chunkCoordinate(region.minY); cy <= chunkCoordinate(region.maxY); ++cy) {
+            chunks[chunkKey(cx, cy, z)].regions.push_back(region);
+        }
+    }
+}
+
+void RegionDirectory::erase(const Map &map, size_t index) {
+    const auto z = map.getLevel();
+
+    for (auto cx = chunkCoordinate(map.getMinX()); cx <= chunkCoordinate(map.getMaxX()); ++cx) {
+        for (auto cy = chunkCoordinate(map.getMinY()); cy <= chunkCoordinate(map.getMaxY()); ++cy) {
+            const auto chunk = chunks.find(chunkKey(cx, cy, z));
+
+            if (chunk == chunks.end()) {
+                continue;
+            }
+
+            auto &regions = chunk->second.regions;
+            regions.erase(std::remove_if(regions.begin(), regions.end(),
+                                         [index](const Region &region) { return region.index == index; }),
+                          regions.end());
+
+            if (regions.empty() && !chunk->second.persistent) {
+                chunks.erase(chunk);
+            }
+        }
+    }
+}
+
+void RegionDirectory::markPersistent(ChunkKey chunk) { chunks[chunk].persistent = true; }
+
+void RegionDirectory::clear() { chunks.clear(); }
+
+auto RegionDirectory::find(const position &pos) const -> std::optional<size_t> { return lookUp(pos).index; }
+
+auto RegionDirectory::lookUp(const position &pos) const -> Lookup {
+    const auto chunk = chunks.find(chunkKey(pos));
+
+    if (chunk == chunks.end()) {
+        return {};
+    }
+
+    Lookup lookup;
+    lookup.mayBePersistent = chunk->second.persistent;
+
+    for (const auto &region : chunk->second.regions) {
+        if (region.contains(pos.x, pos.y)) {
+            lookup.index = region.index;
+            break;
+        }
+    }
+
+    return lookup;
+}
+
+auto RegionDirectory::chunkCoordinate(Coordinate coordinate) -> int32_t {
+    return static_cast<int32_t>(coordinate) >> chunkBits;
+}
+
+auto RegionDirectory::chunkKey(int32_t chunkX, int32_t chunkY, Coordinate z) -> ChunkKey {
+    constexpr auto levelShift = 32;
+    constexpr auto xShift = 16;
+    return static_cast<ChunkKey>(static_cast<uint16_t>(z)) << levelShift |
+           static_cast<ChunkKey>(static_cast<uint16_t>(chunkX)) << xShift |
+           static_cast<ChunkKey>(static_cast<uint16_t>(chunkY));
+}
+
+auto RegionDirectory::chunkKey(const position &pos) -> ChunkKey {
+    return chunkKey(chunkCoordinate(pos.x), chunkCoordinate(pos.y), pos.z);
+}
+
+} // namespace map
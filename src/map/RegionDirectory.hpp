@@ -0,0 +1,82 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef REGION_DIRECTORY_HPP
+#define REGION_DIRECTORY_HPP
+
+#include "globals.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace map {
+
+class Map;
+
+// Resolves a world position to the index of the map covering it. Every level is split into square chunks and each
+// chunk only lists the bounds of the maps overlapping it, so the directory grows with the number of chunks instead
+// of the number of tiles and a lookup costs a single hash probe. Chunks also carry whether persistent fields may lie
+// in them, so that the same probe tells whether the persistent fields need to be asked first.
+class RegionDirectory {
+public:
+    using ChunkKey = uint64_t;
+    static constexpr int chunkBits = 6;
+
+    struct Lookup {
+        std::optional<size_t> index;
+        bool mayBePersistent = false;
+    };
+
+    void insert(const Map &map, size_t index);
+    void erase(const Map &map, size_t index);
+    // the mark stays until clear, also after the persistent field is gone
+    void markPersistent(ChunkKey chunk);
+    void clear();
+    [[nodiscard]] auto find(const position &pos) const -> std::optional<size_t>;
+    [[nodiscard]] auto lookUp(const position &pos) const -> Lookup;
+
+    [[nodiscard]] static auto chunkCoordinate(Coordinate coordinate) -> int32_t;
+    [[nodiscard]] static auto chunkKey(int32_t chunkX, int32_t chunkY, Coordinate z) -> ChunkKey;
+    [[nodiscard]] static auto chunkKey(const position &pos) -> ChunkKey;
+
+private:
+    struct Region {
+        Coordinate minX;
+        Coordinate minY;
+        Coordinate maxX;
+        Coordinate maxY;
+        size_t index;
+
+        [[nodiscard]] auto contains(Coordinate x, Coordinate y) const -> bool {
+            return x >= minX && x <= maxX && y >= minY && y <= maxY;
+        }
+    };
+
+    struct Chunk {
+        std::vector<Region> regions;
+        bool persistent = false;
+    };
+
+    std::unordered_map<ChunkKey, Chunk> chunks;
+};
+
+} // namespace map
+
+#endif
@@ -21,29 +21,103 @@
 #include "Config.hpp"
 #include "Logger.hpp"
 #include "Map.hpp"
+#include "MemoryUsage.hpp"
 #include "Monster.hpp"
 #include "NPC.hpp"
+#include "Parallel.hpp"
 #include "Player.hpp"
+#include "ThreadAffinity.hpp"
 #include "World.hpp"
 #include "db/Result.hpp"
 #include "db/SelectQuery.hpp"
+#include "map/ChunkVersions.hpp"
+#include "map/FieldIndex.hpp"
+#include "map/LineTokenizer.hpp"
 #include "stream.hpp"
 
 #include <algorithm>
-#include <boost/algorithm/string/replace.hpp>
-#include <chrono>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstdio>
 #include <filesystem>
+#include <fstream>
+#include <limits>
 #include <iomanip>
+#include <optional>
 #include <range/v3/all.hpp>
 #include <regex>
+#include <set>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
 
 namespace map {
 
+namespace {
+
+// levels of shard_levels, empty if all levels are owned
+auto shardLevels() -> std::set<int16_t> {
+    std::set<int16_t> levels;
+    std::istringstream list(Config::instance().shard_levels());
+    std::string level;
+
+    while (std::getline(list, level, ',')) {
+        try {
+            levels.insert(static_cast<int16_t>(std::stoi(level)));
+        } catch (std::logic_error &) {
+            Logger::warn(LogFacility::World) << "Ignoring invalid level in shard_levels: " << level << Log::end;
+        }
+    }
+
+    return levels;
+}
+
+auto owns(const std::set<int16_t> &levels, int16_t level) -> bool { return levels.empty() || levels.count(level) > 0; }
+
+// export lines are formatted by hand, iostreams would dominate the time of writing a map
+template <typename Number> void appendNumber(std::string &out, Number number) {
+    std::array<char, std::numeric_limits<Number>::digits10 + 3> buffer{};
+    const auto result = std::to_chars(buffer.data(), buffer.data() + buffer.size(), number);
+    out.append(buffer.data(), result.ptr);
+}
+
+void appendEscaped(std::string &out, const std::string &text) {
+    for (const char c : text) {
+        if (c == '\\' || c == '=' || c == ';') {
+            out += '\\';
+        }
+
+        out += c;
+    }
+}
+
+auto writeFile(const std::string &name, const std::string &content) -> bool {
+    std::ofstream file(name, std::ios::binary | std::ios::out | std::ios::trunc);
+    file << content;
+    file.close();
+    return file.good();
+}
+
+} // namespace
+
 void WorldMap::clear() {
-    world_map.clear();
+    waitForBackgroundSave();
+    regions.clear();
     maps.clear();
+    ChunkVersions::get().bumpAll();
+
+    for (const auto chunk : persistentChunks) {
+        regions.markPersistent(chunk);
+    }
+
+    auto &index = FieldIndex::get();
+    index.clear();
+
+    for (const auto &[pos, field] : persistentFields) {
+        const uint8_t flags = (field.isWarp() ? FLAG_WARPFIELD : 0) | (field.hasSpecialItem() ? FLAG_SPECIALITEM : 0);
+        index.update(pos, flags);
+    }
 }
 
 auto WorldMap::intersects(const Map &map) const -> bool {
@@ -66,62 +140,107 @@ auto WorldMap::insert(Map &&newMap) -> bool {
     }
 
     maps.push_back(std::move(newMap));
+    regions.insert(maps.back(), maps.size() - 1);
+    ChunkVersions::get().bumpAll();
 
-    auto &map = maps.back();
-    const auto z = map.getLevel();
+    return true;
+}
 
-    for (auto x = map.getMinX(); x <= map.getMaxX(); ++x) {
-        for (auto y = map.getMinY(); y <= map.getMaxY(); ++y) {
-            position p(x, y, z);
-            world_map[p] = maps.size() - 1;
+void WorldMap::fieldsAlong(const position &start, int16_t xStep, Coordinate length, const Field **out) const {
+    position pos = start;
+
+    for (Coordinate i = 0; i < length;) {
+        Coordinate count = 1;
+
+        if (auto index = regions.find(pos)) {
+            count = maps[*index].fieldsAlong(pos.x, pos.y, xStep, static_cast<Coordinate>(length - i), out + i);
+        } else {
+            out[i] = nullptr;
         }
-    }
 
-    return true;
+        if (!persistentChunks.empty()) {
+            auto lastChunk = RegionDirectory::chunkKey(pos);
+            bool mayBePersistent = persistentChunks.count(lastChunk) > 0;
+            position fieldPos = pos;
+
+            for (Coordinate j = 0; j < count; ++j) {
+                if (const auto chunk = RegionDirectory::chunkKey(fieldPos); chunk != lastChunk) {
+                    lastChunk = chunk;
+                    mayBePersistent = persistentChunks.count(chunk) > 0;
+                }
+
+                if (mayBePersistent) {
+                    if (const auto persistent = persistentFields.find(fieldPos); persistent != persistentFields.end()) {
+                        out[i + j] = &persistent->second;
+                    }
+                }
+
+                fieldPos.x = static_cast<Coordinate>(fieldPos.x + xStep);
+                ++fieldPos.y;
+            }
+        }
+
+        i = static_cast<Coordinate>(i + count);
+        pos.x = static_cast<Coordinate>(pos.x + count * xStep);
+        pos.y = static_cast<Coordinate>(pos.y + count);
+    }
 }
 
 auto WorldMap::insertPersistent(Field &&newField) -> bool {
     newField.makePersistent();
+    persistentChunks.insert(RegionDirectory::chunkKey(newField.getPosition()));
+    regions.markPersistent(RegionDirectory::chunkKey(newField.getPosition()));
     return persistentFields.insert({newField.getPosition(), std::move(newField)}).second;
 }
 
 auto WorldMap::allMapsAged() -> bool {
-    using std::chrono::milliseconds;
-    using std::chrono::steady_clock;
-    constexpr auto ageInterval = milliseconds(10);
+    // maps only touch their own fields while ageing, client and database updates follow on this thread
+    std::vector<std::vector<uint32_t>> changed(maps.size());
 
-    auto startTime = steady_clock::now();
+    runInParallel(maps.size(), [this, &changed](size_t i) { changed[i] = maps[i].ageFields(); });
 
-    while (ageIndex < maps.size() && steady_clock::now() - startTime < ageInterval) {
-        maps[ageIndex++].age();
-    }
-
-    if (ageIndex < maps.size()) {
-        return false;
+    for (size_t i = 0; i < maps.size(); ++i) {
+        maps[i].publishAgedFields(changed[i]);
     }
 
     using namespace ranges;
     for_each(persistentFields | view::values, [](auto &field) { field.age(); });
 
-    ageIndex = 0;
     return true;
 }
 
+void WorldMap::updateMovementCosts() {
+    for (auto &map : maps) {
+        map.updateMovementCosts();
+    }
+
+    for (auto &[pos, field] : persistentFields) {
+        field.updateMovementCost();
+    }
+}
+
 auto WorldMap::import(const std::string &importDir, const std::string &mapName) -> bool {
-    bool success = true;
+    auto map = importMap(importDir, mapName);
+
+    if (map && insert(std::move(*map))) {
+        return true;
+    }
+
+    Logger::alert(LogFacility::Script) << "---> Could not import " << mapName << Log::end;
+    return false;
+}
 
+auto WorldMap::importMap(const std::string &importDir, const std::string &mapName) -> std::optional<Map> {
     try {
         auto map = createMapFromHeaderFile(importDir, mapName);
-        success = map.import(importDir, mapName) && insert(std::move(map));
-    } catch (MapError &) {
-        success = false;
-    }
 
-    if (!success) {
-        Logger::alert(LogFacility::Script) << "---> Could not import " << mapName << Log::end;
+        if (map.import(importDir, mapName)) {
+            return map;
+        }
+    } catch (MapError &) {
     }
 
-    return success;
+    return {};
 }
 
 auto WorldMap::createMapFromHeaderFile(const std::string &importDir, const std::string &mapName) -> Map {
@@ -181,23 +300,18 @@ auto WorldMap::createMapFromHeaderFile(const std::string &importDir, const std::
     return Map(mapName, origin, width, height);
 }
 
-const std::regex headerExpression{R"(^(.): (-?\d+)$)"};
-
 auto WorldMap::readHeaderLine(const std::string &mapName, char header, std::ifstream &headerFile, int &lineNumber)
         -> int16_t {
-    using std::regex_match;
-    using std::smatch;
     std::string line;
 
     while (std::getline(headerFile, line)) {
         ++lineNumber;
 
         if (!isCommentOrEmpty(line)) {
-            smatch matches;
+            LineTokenizer tokens{line};
 
-            if (regex_match(line, matches, headerExpression) && matches[1] == header) {
-                int16_t headerValue = 0;
-                stringToNumber(matches[2].str(), headerValue);
+            if (int16_t headerValue = 0; tokens.separator(header) && tokens.literal(": ") &&
+                                         tokens.number(headerValue) && tokens.atEnd()) {
                 return headerValue;
             }
         }
@@ -210,80 +324,151 @@ auto WorldMap::readHeaderLine(const std::string &mapName, char header, std::ifst
 
 auto WorldMap::isCommentOrEmpty(const std::string &line) -> bool { return line.length() == 0 || line[0] == '#'; }
 
-auto WorldMap::exportTo() const -> bool {
+auto WorldMap::exportInBackground(ExportCallback progress) const -> bool {
     const std::string exportDir = Config::instance().datadir() + std::string(MAPDIR) + "export/";
+    std::error_code error;
+    std::filesystem::create_directories(exportDir, error);
+
+    if (error) {
+        Logger::error(LogFacility::World) << "Could not create export directory " << exportDir << ": "
+                                          << error.message() << Log::end;
+        return false;
+    }
+
+    std::vector<MapExport> exports;
+    exports.reserve(maps.size());
 
     for (const auto &map : maps) {
-        int16_t minX = map.getMinX();
-        int16_t minY = map.getMinY();
-        // create base filename
-        std::string filebase = exportDir + "e_" + std::to_string(minX) + "_" + std::to_string(minY) + "_" +
-                               std::to_string(map.getLevel()) + ".";
-        // export fields file
-        std::ofstream fieldsf(filebase + "tiles.txt");
-        // export items file
-        std::ofstream itemsf(filebase + "items.txt");
-        // export warps file
-        std::ofstream warpsf(filebase + "warps.txt");
-
-        if (!fieldsf.good() || !itemsf.good() || !warpsf.good()) {
-            Logger::error(LogFacility::World)
-                    << "Could not open output files for item export: " << filebase << "*.txt" << Log::end;
-            return false;
+        if (!map.isInstance()) {
+            exports.push_back(takeExport(map, exportDir));
         }
+    }
 
-        // export tiles header
-        fieldsf << "V: 2" << std::endl;
-        fieldsf << "L: " << map.getLevel() << std::endl;
-        fieldsf << "X: " << minX << std::endl;
-        fieldsf << "Y: " << minY << std::endl;
-        fieldsf << "W: " << map.getWidth() << std::endl;
-        fieldsf << "H: " << map.getHeight() << std::endl;
+    waitForBackgroundSave();
+    saveWorker = std::thread([exports = std::move(exports), progress = std::move(progress)] {
+        affinity::pinCurrentThread(Config::instance().worker_thread_cores(), "worker");
+        constexpr size_t reports = 10;
+        const size_t total = exports.size();
+        std::atomic<size_t> written = 0;
+        std::atomic<size_t> failed = 0;
+
+        runInParallel(total, [&](size_t i) {
+            if (writeExport(exports[i])) {
+                ++written;
+            } else {
+                ++failed;
+            }
 
-        // iterate over the map and export...
+            const size_t done = written + failed;
 
-        for (short int y = minY; y <= map.getMaxY(); ++y) {
-            for (short int x = minX; x <= map.getMaxX(); ++x) {
-                const Field &field = map.at(x, y);
+            if (done < total && done * reports / total != (done - 1) * reports / total) {
+                progress({written, failed, total});
+            }
+        });
 
-                fieldsf << x - minX << ";" << y - minY << ";" << field.getTileCode() << ";" << field.getMusicId()
-                        << std::endl;
+        progress({written, failed, total});
+    });
 
-                if (field.isWarp()) {
-                    position target{};
-                    field.getWarp(target);
-                    warpsf << x - minX << ";" << y - minY << ";" << target.x << ";" << target.y << ";" << target.z
-                           << std::endl;
-                }
+    return true;
+}
 
-                for (const auto &item : field.getExportItems()) {
-                    itemsf << x - minX << ";" << y - minY << ";" << item.getId() << ";" << item.getQuality();
+auto WorldMap::takeExport(const Map &map, const std::string &exportDir) -> MapExport {
+    MapExport mapExport;
+    mapExport.level = map.getLevel();
+    mapExport.minX = map.getMinX();
+    mapExport.minY = map.getMinY();
+    mapExport.width = map.getWidth();
+    mapExport.height = map.getHeight();
+    mapExport.fileBase = exportDir + "e_" + std::to_string(mapExport.minX) + "_" + std::to_string(mapExport.minY) +
+                         "_" + std::to_string(mapExport.level) + ".";
+    mapExport.tiles.reserve(static_cast<size_t>(mapExport.width) * mapExport.height);
+
+    for (short int y = mapExport.minY; y <= map.getMaxY(); ++y) {
+        for (short int x = mapExport.minX; x <= map.getMaxX(); ++x) {
+            const Field &field = map.at(x, y);
+            const auto index = static_cast<uint32_t>(mapExport.tiles.size());
+            mapExport.tiles.emplace_back(field.getTileCode(), field.getMusicId());
+
+            if (field.isWarp()) {
+                position target{};
+                field.getWarp(target);
+                mapExport.warps.emplace_back(index, target);
+            }
 
-                    std::for_each(item.getDataBegin(), item.getDataEnd(),
-                                  [&](const std::pair<std::string, std::string> &data) {
-                                      using boost::algorithm::replace_all;
+            for (auto &item : field.getExportItems()) {
+                mapExport.items.emplace_back(index, std::move(item));
+            }
+        }
+    }
 
-                                      std::string key = data.first;
-                                      std::string value = data.second;
+    return mapExport;
+}
 
-                                      replace_all(key, "\\", "\\\\");
-                                      replace_all(key, "=", "\\=");
-                                      replace_all(key, ";", "\\;");
-                                      replace_all(value, "\\", "\\\\");
-                                      replace_all(value, "=", "\\=");
-                                      replace_all(value, ";", "\\;");
+auto WorldMap::writeExport(const MapExport &mapExport) -> bool {
+    const auto width = mapExport.width;
+    std::string tiles;
+    std::string items;
+    std::string warps;
+
+    tiles += "V: 2\nL: ";
+    appendNumber(tiles, mapExport.level);
+    tiles += "\nX: ";
+    appendNumber(tiles, mapExport.minX);
+    tiles += "\nY: ";
+    appendNumber(tiles, mapExport.minY);
+    tiles += "\nW: ";
+    appendNumber(tiles, mapExport.width);
+    tiles += "\nH: ";
+    appendNumber(tiles, mapExport.height);
+    tiles += '\n';
+
+    const auto appendLocation = [width](std::string &out, uint32_t index) {
+        appendNumber(out, index % width);
+        out += ';';
+        appendNumber(out, index / width);
+        out += ';';
+    };
+
+    for (uint32_t index = 0; index < mapExport.tiles.size(); ++index) {
+        const auto &[code, music] = mapExport.tiles[index];
+        appendLocation(tiles, index);
+        appendNumber(tiles, code);
+        tiles += ';';
+        appendNumber(tiles, music);
+        tiles += '\n';
+    }
 
-                                      itemsf << ";" << key << "=" << value;
-                                  });
+    for (const auto &[index, target] : mapExport.warps) {
+        appendLocation(warps, index);
+        appendNumber(warps, target.x);
+        warps += ';';
+        appendNumber(warps, target.y);
+        warps += ';';
+        appendNumber(warps, target.z);
+        warps += '\n';
+    }
 
-                    itemsf << std::endl;
-                }
-            }
-        }
+    for (const auto &[index, item] : mapExport.items) {
+        appendLocation(items, index);
+        appendNumber(items, item.getId());
+        items += ';';
+        appendNumber(items, item.getQuality());
+
+        std::for_each(item.getDataBegin(), item.getDataEnd(), [&items](const auto &data) {
+            items += ';';
+            appendEscaped(items, data.first);
+            items += '=';
+            appendEscaped(items, data.second);
+        });
 
-        fieldsf.close();
-        itemsf.close();
-        warpsf.close();
+        items += '\n';
+    }
+
+    if (!writeFile(mapExport.fileBase + "tiles.txt", tiles) || !writeFile(mapExport.fileBase + "items.txt", items) ||
+        !writeFile(mapExport.fileBase + "warps.txt", warps)) {
+        Logger::error(LogFacility::World) << "Could not write map export: " << mapExport.fileBase << "*.txt"
+                                          << Log::end;
+        return false;
     }
 
     return true;
@@ -310,6 +495,7 @@ auto WorldMap::importFromEditor() -> bool {
     Logger::notice(LogFacility::Script) << "Importing maps..." << Log::end;
 
     std::string importDir = Config::instance().datadir() + std::string(MAPDIR) + "import/";
+    std::vector<std::string> mapNames;
 
     for (std::filesystem::recursive_directory_iterator end, it(importDir); it != end; ++it) {
         if (!std::filesystem::is_regular_file(it->status())) {
@@ -327,12 +513,27 @@ auto WorldMap::importFromEditor() -> bool {
         map.resize(map.length() - suffix.length());
         map.erase(0, importDir.length());
 
-        Logger::debug(LogFacility::World) << "Importing: " << map << Log::end;
+        mapNames.push_back(std::move(map));
+    }
+
+    // maps are independent until inserted, so parse them concurrently and insert in directory order
+    std::vector<std::optional<Map>> importedMaps(mapNames.size());
 
-        if (!import(importDir, map)) {
+    runInParallel(mapNames.size(), [&](size_t i) { importedMaps[i] = importMap(importDir, mapNames[i]); });
+    const auto levels = shardLevels();
+    int skipped = 0;
+
+    for (size_t i = 0; i < mapNames.size(); ++i) {
+        Logger::debug(LogFacility::World) << "Importing: " << mapNames[i] << Log::end;
+
+        if (importedMaps[i] && !owns(levels, importedMaps[i]->getLevel())) {
+            ++skipped;
+        } else if (!importedMaps[i] || !insert(std::move(*importedMaps[i]))) {
+            Logger::alert(LogFacility::Script) << "---> Could not import " << mapNames[i] << Log::end;
             ++errors;
         }
 
+        importedMaps[i].reset();
         ++numfiles;
     }
 
@@ -341,8 +542,8 @@ auto WorldMap::importFromEditor() -> bool {
         return false;
     }
 
-    Logger::notice(LogFacility::Script) << "Imported " << numfiles - errors << " out of " << numfiles << " maps."
-                                        << Log::end;
+    Logger::notice(LogFacility::Script) << "Imported " << numfiles - errors - skipped << " out of " << numfiles
+                                        << " maps, " << skipped << " on levels of other servers." << Log::end;
 
     if (errors != 0) {
         Logger::alert(LogFacility::Script) << "Failed to import " << errors << " maps!" << Log::end;
@@ -353,6 +554,15 @@ auto WorldMap::importFromEditor() -> bool {
 }
 
 auto WorldMap::loadFromDisk() -> bool {
+    if (!loadMapsFromDisk()) {
+        return false;
+    }
+
+    loadPersistentFields();
+    return true;
+}
+
+auto WorldMap::loadMapsFromDisk() -> bool {
     clear();
     const std::string path = Config::instance().datadir() + std::string(MAPDIR) + worldName;
     std::ifstream mapinitfile(path + "_initmaps", std::ios::binary | std::ios::in);
@@ -374,6 +584,11 @@ auto WorldMap::loadFromDisk() -> bool {
     uint16_t width = 0;
     uint16_t height = 0;
     std::ostringstream mapName;
+    std::vector<Map> loadedMaps;
+    std::vector<std::string> mapNames;
+    loadedMaps.reserve(size);
+    mapNames.reserve(size);
+    const auto levels = shardLevels();
 
     for (int i = 0; i < size; ++i) {
         readFromStream(mapinitfile, level);
@@ -382,24 +597,38 @@ auto WorldMap::loadFromDisk() -> bool {
         readFromStream(mapinitfile, width);
         readFromStream(mapinitfile, height);
 
-        auto map = Map{"previously saved map", position{minX, minY, level}, width, height};
+        // saved with other levels, the next save leaves them out and only an import brings them back
+        if (!owns(levels, level)) {
+            continue;
+        }
+
+        loadedMaps.emplace_back("previously saved map", position{minX, minY, level}, width, height);
 
         mapName.str("");
         mapName << path << '_' << std::setw(coordinateChars) << level << '_' << std::setw(coordinateChars) << minX
                 << '_' << std::setw(coordinateChars) << minY;
+        mapNames.push_back(mapName.str());
+    }
+
+    std::vector<char> loaded(loadedMaps.size(), 0); // not vector<bool>, workers write neighbouring entries
+
+    runInParallel(loadedMaps.size(),
+                  [&](size_t i) { loaded[i] = static_cast<char>(loadedMaps[i].load(mapNames[i])); });
 
-        if (map.load(mapName.str())) {
-            insert(std::move(map));
+    for (size_t i = 0; i < loadedMaps.size(); ++i) {
+        if (loaded[i] != 0) {
+            insert(std::move(loadedMaps[i]));
         }
     }
 
-    loadPersistentFields();
+    loadedMaps.clear();
 
     return true;
 }
 
 void WorldMap::loadPersistentFields() {
     persistentFields.clear();
+    persistentChunks.clear();
 
     using namespace Database;
 
@@ -415,50 +644,161 @@ void WorldMap::loadPersistentFields() {
     Logger::info(LogFacility::World) << "Loading " << result.size() << " persistent fields." << Log::end;
 
     const bool isPersistent = true;
+    const auto levels = shardLevels();
 
     for (const auto &row : result) {
         position pos(row["mt_x"].as<int16_t>(), row["mt_y"].as<int16_t>(), row["mt_z"].as<int16_t>());
 
+        if (!owns(levels, static_cast<int16_t>(pos.z))) {
+            continue;
+        }
+
         auto tile = row["mt_tile"].as<uint16_t>();
         auto music = row["mt_music"].as<uint16_t>();
         Field field(tile, music, pos, isPersistent);
 
+        persistentChunks.insert(RegionDirectory::chunkKey(pos));
+        regions.markPersistent(RegionDirectory::chunkKey(pos));
         persistentFields.emplace(pos, std::move(field));
     }
 }
 
-void WorldMap::saveToDisk() const {
-    const std::string path = Config::instance().datadir() + std::string(MAPDIR) + worldName;
-    std::ofstream mapinitfile(path + "_initmaps", std::ios::binary | std::ios::out | std::ios::trunc);
+WorldMap::~WorldMap() { waitForBackgroundSave(); }
 
-    if (!mapinitfile.good()) {
-        Logger::error(LogFacility::World) << "Could not create initmaps!" << Log::end;
-    } else {
-        const uint16_t size = maps.size();
-        Logger::info(LogFacility::World) << "Saving " << size << " maps." << Log::end;
-        writeToStream(mapinitfile, size);
-        std::ostringstream mapName;
-
-        for (const auto &map : maps) {
-            const auto level = map.getLevel();
-            const auto x = map.getMinX();
-            const auto y = map.getMinY();
-            const auto width = map.getWidth();
-            const auto height = map.getHeight();
-            writeToStream(mapinitfile, level);
-            writeToStream(mapinitfile, x);
-            writeToStream(mapinitfile, y);
-            writeToStream(mapinitfile, width);
-            writeToStream(mapinitfile, height);
+auto WorldMap::prepareSave(const std::string &directory, bool backup) const -> PendingSave {
+    const std::string livePath = Config::instance().datadir() + std::string(MAPDIR) + worldName;
+    const std::string path = directory + std::string(MAPDIR) + worldName;
+    PendingSave pendingSave;
+    pendingSave.initMapsFile = path + "_initmaps";
 
+    std::ostringstream initMaps{std::ios::binary | std::ios::out};
+    const uint16_t size = std::count_if(maps.begin(), maps.end(), [](const Map &map) { return !map.isInstance(); });
+    writeToStream(initMaps, size);
+    std::ostringstream mapName;
+
+    for (const auto &map : maps) {
+        if (map.isInstance()) {
+            continue;
+        }
+
+        const auto level = map.getLevel();
+        const auto x = map.getMinX();
+        const auto y = map.getMinY();
+        const auto width = map.getWidth();
+        const auto height = map.getHeight();
+        writeToStream(initMaps, level);
+        writeToStream(initMaps, x);
+        writeToStream(initMaps, y);
+        writeToStream(initMaps, width);
+        writeToStream(initMaps, height);
+
+        if (map.isDirty() || backup) {
             mapName.str("");
-            mapName << path << '_' << std::setw(coordinateChars) << level << '_' << std::setw(coordinateChars) << x
-                    << '_' << std::setw(coordinateChars) << y;
+            mapName << '_' << std::setw(coordinateChars) << level << '_' << std::setw(coordinateChars) << x << '_'
+                    << std::setw(coordinateChars) << y;
+
+            if (map.isDirty()) {
+                pendingSave.maps.emplace_back(path + mapName.str(), map.takeSnapshotImage(!backup));
+            } else {
+                // the last save wrote the same image, and no save replaces it while the backup runs
+                pendingSave.copies.emplace_back(livePath + mapName.str() + "_snapshot",
+                                                path + mapName.str() + "_snapshot");
+            }
+        }
+    }
 
-            map.save(mapName.str());
+    pendingSave.initMaps = initMaps.str();
+    Logger::info(LogFacility::World) << "Saving " << pendingSave.maps.size() << " of " << size << " maps."
+                                     << Log::end;
+
+    return pendingSave;
+}
+
+auto WorldMap::writeSave(const PendingSave &pendingSave) -> bool {
+    bool success = true;
+
+    for (const auto &[name, image] : pendingSave.maps) {
+        success = Map::writeSnapshot(name, image) && success;
+    }
+
+    for (const auto &[from, to] : pendingSave.copies) {
+        std::error_code error;
+
+        if (!std::filesystem::copy_file(from, to, std::filesystem::copy_options::overwrite_existing, error)) {
+            Logger::error(LogFacility::World) << "Copying map " << from << " failed: " << error.message() << Log::end;
+            success = false;
         }
+    }
+
+    for (const auto &[name, content] : pendingSave.files) {
+        std::ofstream file(name, std::ios::binary | std::ios::out | std::ios::trunc);
+        file << content;
+        file.close();
 
-        mapinitfile.close();
+        if (!file.good()) {
+            Logger::error(LogFacility::World) << "Could not write " << name << Log::end;
+            success = false;
+        }
+    }
+
+    // replaced at once, a crash while saving must not leave a list that fails to load
+    const auto temporaryFileName = pendingSave.initMapsFile + ".tmp";
+    std::ofstream mapinitfile(temporaryFileName, std::ios::binary | std::ios::out | std::ios::trunc);
+    mapinitfile << pendingSave.initMaps;
+    mapinitfile.close();
+
+    if (!mapinitfile.good() || std::rename(temporaryFileName.c_str(), pendingSave.initMapsFile.c_str()) != 0) {
+        Logger::error(LogFacility::World) << "Could not create initmaps!" << Log::end;
+        return false;
+    }
+
+    return success;
+}
+
+void WorldMap::saveToDisk() const {
+    waitForBackgroundSave();
+    writeSave(prepareSave(Config::instance().datadir(), false));
+}
+
+void WorldMap::saveToDiskInBackground() const {
+    waitForBackgroundSave();
+    saveWorker = std::thread([pendingSave = prepareSave(Config::instance().datadir(), false)] {
+        affinity::pinCurrentThread(Config::instance().worker_thread_cores(), "worker");
+        writeSave(pendingSave);
+    });
+}
+
+void WorldMap::backupInBackground(const std::string &directory,
+                                  std::vector<std::pair<std::string, std::string>> files) const {
+    waitForBackgroundSave();
+    std::error_code error;
+    std::filesystem::create_directories(directory + MAPDIR, error);
+
+    if (error) {
+        Logger::error(LogFacility::World) << "Could not create backup directory " << directory << ": "
+                                          << error.message() << Log::end;
+        return;
+    }
+
+    auto pendingSave = prepareSave(directory, true);
+
+    for (auto &[name, content] : files) {
+        pendingSave.files.emplace_back(directory + name, std::move(content));
+    }
+
+    saveWorker = std::thread([pendingSave = std::move(pendingSave), directory] {
+        affinity::pinCurrentThread(Config::instance().worker_thread_cores(), "worker");
+        if (writeSave(pendingSave)) {
+            Logger::notice(LogFacility::World) << "Backup written to " << directory << Log::end;
+        } else {
+            Logger::error(LogFacility::World) << "Backup to " << directory << " is incomplete" << Log::end;
+        }
+    });
+}
+
+void WorldMap::waitForBackgroundSave() const {
+    if (saveWorker.joinable()) {
+        saveWorker.join();
     }
 }
 
@@ -467,6 +807,86 @@ auto WorldMap::createMap(const std::string &name, const position &origin, uint16
     return insert({name, origin, width, height, tile});
 }
 
+auto WorldMap::templatePath(const std::string &templateName) -> std::string {
+    return Config::instance().datadir() + MAPDIR + "templates/" + templateName;
+}
+
+auto WorldMap::findTemplate(const std::string &templateName) -> std::shared_ptr<const MapSnapshot> {
+    if (const auto found = templates.find(templateName); found != templates.end()) {
+        return found->second;
+    }
+
+    try {
+        auto mapTemplate = std::make_shared<const MapSnapshot>(templatePath(templateName) + "_snapshot");
+        templates.emplace(templateName, mapTemplate);
+        return mapTemplate;
+    } catch (const MapError &) {
+        Logger::error(LogFacility::World) << "Could not load map template " << templateName << Log::end;
+        return {};
+    }
+}
+
+auto WorldMap::saveTemplate(const position &pos, const std::string &templateName) -> bool {
+    const auto index = regions.find(pos);
+
+    if (!index) {
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(Config::instance().datadir() + MAPDIR + "templates", error);
+
+    if (error || !Map::writeSnapshot(templatePath(templateName), maps[*index].takeSnapshotImage(false))) {
+        return false;
+    }
+
+    templates.erase(templateName);
+    return true;
+}
+
+auto WorldMap::createInstance(const std::string &templateName, const position &origin) -> bool {
+    auto mapTemplate = findTemplate(templateName);
+
+    if (!mapTemplate) {
+        return false;
+    }
+
+    return insert(Map::instantiate(templateName + " instance", origin, std::move(mapTemplate)));
+}
+
+auto WorldMap::instanceAt(const position &pos) const -> const Map * {
+    if (const auto index = regions.find(pos); index && maps[*index].isInstance()) {
+        return &maps[*index];
+    }
+
+    return nullptr;
+}
+
+auto WorldMap::removeInstance(const position &pos) -> bool {
+    const auto index = regions.find(pos);
+
+    if (!index || !maps[*index].isInstance()) {
+        return false;
+    }
+
+    // the last map takes the place of the removed one, so only the regions of these two change
+    auto &removed = maps[*index];
+    const auto last = maps.size() - 1;
+    regions.erase(removed, *index);
+    FieldIndex::get().clearArea(position(removed.getMinX(), removed.getMinY(), removed.getLevel()),
+                                position(removed.getMaxX(), removed.getMaxY(), removed.getLevel()));
+
+    if (*index != last) {
+        regions.erase(maps[last], last);
+        removed = std::move(maps[last]);
+        regions.insert(removed, *index);
+    }
+
+    maps.pop_back();
+    ChunkVersions::get().bumpAll();
+    return true;
+}
+
 void WorldMap::makePersistentAt(const position &pos) {
     try {
         Field &field = persistentFields.at(pos);
@@ -485,7 +905,7 @@ void WorldMap::makePersistentAt(const position &pos) {
 }
 
 void WorldMap::removePersistenceAt(const position &pos) {
-    bool existsInMap = world_map.count(pos) > 0;
+    bool existsInMap = regions.find(pos).has_value();
     bool existsPersistent = persistentFields.count(pos) > 0;
 
     if (!existsInMap && existsPersistent) {
@@ -543,6 +963,34 @@ auto WorldMap::isPersistentAt(const position &pos) const -> bool {
     return persistent;
 }
 
+auto WorldMap::memoryUsage() const -> size_t {
+    auto bytes = memory::of(maps) + memory::ofHashed(persistentFields);
+
+    for (const auto &map : maps) {
+        bytes += map.memoryUsage();
+    }
+
+    for (const auto &[pos, field] : persistentFields) {
+        bytes += field.memoryUsage();
+    }
+
+    return bytes;
+}
+
+auto WorldMap::mappedBytes() const -> size_t {
+    size_t bytes = 0;
+
+    for (const auto &[name, mapTemplate] : templates) {
+        bytes += mapTemplate->getSize();
+    }
+
+    for (const auto &map : maps) {
+        bytes += map.mappedBytes();
+    }
+
+    return bytes;
+}
+
 auto walkableNear(WorldMap &worldMap, const position &pos) -> Field & {
     auto start = pos;
     auto testPos = pos;
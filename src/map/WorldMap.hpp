@@ -21,8 +21,16 @@
 
 #include "globals.hpp"
 #include "map/Map.hpp"
+#include "map/RegionDirectory.hpp"
 
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace map {
@@ -31,51 +39,134 @@ class Field;
 
 class WorldMap {
     std::vector<Map> maps;
-    std::unordered_map<position, int> world_map;
+    RegionDirectory regions;
     std::unordered_map<position, Field> persistentFields;
-    size_t ageIndex = 0;
+    // region chunks that hold or held a persistent field, the others need no lookup in persistentFields
+    std::unordered_set<RegionDirectory::ChunkKey> persistentChunks;
+    // map templates by name, mapped once and shared by all their instances
+    std::unordered_map<std::string, std::shared_ptr<const MapSnapshot>> templates;
+    mutable std::thread saveWorker; // writes snapshot images taken by saveToDiskInBackground
+
+    // everything a save writes, taken on the game thread so that writing needs no access to maps
+    struct PendingSave {
+        std::string initMapsFile;
+        std::string initMaps;
+        std::vector<std::pair<std::string, std::string>> maps;
+        // snapshot files of unchanged maps copied by a backup, from and to
+        std::vector<std::pair<std::string, std::string>> copies;
+        // further files of a backup, name and content
+        std::vector<std::pair<std::string, std::string>> files;
+    };
+
+    // what the export of a map writes, copied on the game thread so that formatting needs no access to maps
+    struct MapExport {
+        std::string fileBase;
+        int16_t level = 0;
+        int16_t minX = 0;
+        int16_t minY = 0;
+        uint16_t width = 0;
+        uint16_t height = 0;
+        // tile code and music in the order of the tiles file, row by row
+        std::vector<std::pair<uint16_t, uint16_t>> tiles;
+        std::vector<std::pair<uint32_t, position>> warps;
+        std::vector<std::pair<uint32_t, Item>> items;
+    };
 
 public:
+    struct ExportProgress {
+        size_t written = 0;
+        size_t failed = 0;
+        size_t total = 0;
+
+        [[nodiscard]] auto isComplete() const -> bool { return written + failed == total; }
+    };
+
+    // called on worker threads, after every tenth of the maps and once the export is complete
+    using ExportCallback = std::function<void(const ExportProgress &)>;
+
+    WorldMap() = default;
+    WorldMap(const WorldMap &) = delete;
+    auto operator=(const WorldMap &) -> WorldMap & = delete;
+    WorldMap(WorldMap &&) = delete;
+    auto operator=(WorldMap &&) -> WorldMap & = delete;
+    ~WorldMap();
+
     auto at(const position &pos) -> Field & { return atImpl(*this, pos); }
     auto at(const position &pos) const -> const Field & { return atImpl(*this, pos); }
+    // the fields from start on, stepping x by xStep and y by one, resolving each map once for all its fields on the
+    // way; out receives length pointers, null where there is no field
+    void fieldsAlong(const position &start, int16_t xStep, Coordinate length, const Field **out) const;
     auto intersects(const Map &map) const -> bool;
 
     auto allMapsAged() -> bool;
+    void updateMovementCosts();
 
     auto import(const std::string &importDir, const std::string &mapName) -> bool;
-    auto exportTo() const -> bool;
+    // writes all maps in the format of the editor on a worker pool, returns false if nothing could be written
+    auto exportInBackground(ExportCallback progress) const -> bool;
     auto importFromEditor() -> bool;
     auto loadFromDisk() -> bool;
+    // the maps of the last save without the persistent fields of the database
+    auto loadMapsFromDisk() -> bool;
+    // only maps changed since they were loaded or last saved are written
     void saveToDisk() const;
+    void saveToDiskInBackground() const;
+    // writes all maps below directory in the layout of the data directory, together with the given files by name
+    void backupInBackground(const std::string &directory,
+                            std::vector<std::pair<std::string, std::string>> files) const;
     auto createMap(const std::string &name, const position &origin, uint16_t width, uint16_t height, uint16_t tile)
             -> bool;
+    // writes the map at pos as template, instances made from it before keep the previous version
+    auto saveTemplate(const position &pos, const std::string &templateName) -> bool;
+    // instances are neither saved nor exported and hold only the fields changed since they were made
+    auto createInstance(const std::string &templateName, const position &origin) -> bool;
+    [[nodiscard]] auto instanceAt(const position &pos) const -> const Map *;
+    auto removeInstance(const position &pos) -> bool;
 
     void makePersistentAt(const position &pos);
     void removePersistenceAt(const position &pos);
     auto isPersistentAt(const position &pos) const -> bool;
 
+    // estimated heap bytes of all maps and persistent fields
+    [[nodiscard]] auto memoryUsage() const -> size_t;
+    // bytes of map snapshots still mapped for fields that were not accessed yet
+    [[nodiscard]] auto mappedBytes() const -> size_t;
+
 private:
     const std::string worldName{"Illarion"};
     static constexpr auto coordinateChars = 6;
     auto insert(Map &&newMap) -> bool;
     auto insertPersistent(Field &&newField) -> bool;
+    auto findTemplate(const std::string &templateName) -> std::shared_ptr<const MapSnapshot>;
+    static auto templatePath(const std::string &templateName) -> std::string;
     void loadPersistentFields();
     void clear();
+    [[nodiscard]] auto prepareSave(const std::string &directory, bool backup) const -> PendingSave;
+    static auto writeSave(const PendingSave &pendingSave) -> bool;
+    static auto takeExport(const Map &map, const std::string &exportDir) -> MapExport;
+    static auto writeExport(const MapExport &mapExport) -> bool;
+    void waitForBackgroundSave() const;
+    static auto importMap(const std::string &importDir, const std::string &mapName) -> std::optional<Map>;
     static auto createMapFromHeaderFile(const std::string &importDir, const std::string &mapName) -> Map;
     static auto readHeaderLine(const std::string &mapName, char header, std::ifstream &headerFile, int &lineNumber)
             -> int16_t;
     static auto isCommentOrEmpty(const std::string &line) -> bool;
 
     template <class T> static auto atImpl(T &t, const position &pos) -> decltype(t.at(pos)) {
-        if (t.persistentFields.count(pos) > 0) {
-            return t.persistentFields.at(pos);
+        // one probe of the directory, the persistent fields are only asked in chunks that hold or held one
+        const auto lookup = t.regions.lookUp(pos);
+
+        if (lookup.mayBePersistent) {
+            if (auto persistent = t.persistentFields.find(pos); persistent != t.persistentFields.end()) {
+                return persistent->second;
+            }
         }
-        try {
-            return t.maps.at(t.world_map.at(pos)).at(pos.x, pos.y);
 
-        } catch (std::out_of_range &) {
-            throw FieldNotFound();
+        if (lookup.index) {
+            return t.maps[*lookup.index].at(pos.x, pos.y);
         }
+
+        throw FieldNotFound();
     }
 };
 
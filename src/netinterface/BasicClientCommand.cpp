@@ -20,7 +20,94 @@
 
 #include "BasicCommand.hpp"
 
+#include <array>
 #include <climits>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace {
+
+// Recycles command memory in size classes of 64 bytes. Commands are made on the io threads and mostly released on
+// the game thread, so the free lists are shared behind a mutex.
+class CommandMemoryPool {
+public:
+    static auto get() -> CommandMemoryPool & {
+        static CommandMemoryPool pool;
+        return pool;
+    }
+
+    CommandMemoryPool(const CommandMemoryPool &) = delete;
+    auto operator=(const CommandMemoryPool &) -> CommandMemoryPool & = delete;
+    CommandMemoryPool(CommandMemoryPool &&) = delete;
+    auto operator=(CommandMemoryPool &&) -> CommandMemoryPool & = delete;
+
+    ~CommandMemoryPool() {
+        for (auto &blocks : free) {
+            for (auto *block : blocks) {
+                ::operator delete(block);
+            }
+        }
+    }
+
+    auto acquire(size_t size) -> void * {
+        const auto sizeClass = sizeClassOf(size);
+
+        if (sizeClass >= classCount) {
+            return ::operator new(size);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto &blocks = free[sizeClass];
+
+            if (!blocks.empty()) {
+                auto *block = blocks.back();
+                blocks.pop_back();
+                return block;
+            }
+        }
+
+        return ::operator new((sizeClass + 1) * granularity);
+    }
+
+    void release(void *block, size_t size) noexcept {
+        const auto sizeClass = sizeClassOf(size);
+
+        if (sizeClass < classCount) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto &blocks = free[sizeClass];
+
+            if (blocks.size() < maxPooledPerClass) {
+                try {
+                    blocks.push_back(block);
+                    return;
+                } catch (std::bad_alloc &) {
+                }
+            }
+        }
+
+        ::operator delete(block);
+    }
+
+private:
+    static constexpr size_t granularity = 64;
+    static constexpr size_t classCount = 16; // up to 1 KiB, far more than any command needs
+    static constexpr size_t maxPooledPerClass = 4096;
+
+    std::mutex mutex;
+    std::array<std::vector<void *>, classCount> free;
+
+    CommandMemoryPool() = default;
+
+    static auto sizeClassOf(size_t size) -> size_t { return (size + granularity - 1) / granularity - 1; }
+};
+
+} // namespace
+
+auto allocateCommandMemory(size_t size) -> void * { return CommandMemoryPool::get().acquire(size); }
+
+void releaseCommandMemory(void *memory, size_t size) noexcept { CommandMemoryPool::get().release(memory, size); }
 
 BasicClientCommand::BasicClientCommand(unsigned char defByte, uint16_t minAP) : BasicCommand(defByte), minAP(minAP) {}
 
@@ -32,55 +119,77 @@ void BasicClientCommand::setHeaderData(uint16_t mlength, uint16_t mcheckSum) {
 
 auto BasicClientCommand::msg_data() -> std::vector<unsigned char> & { return msg_buffer; }
 
-auto BasicClientCommand::getUnsignedCharFromBuffer() -> unsigned char {
-    unsigned char ret = 0;
-
+auto BasicClientCommand::takeFromBuffer(uint16_t count) -> const unsigned char * {
     // no buffer available but we want to read from it
     if (length == 0) {
         dataOk = false;
+        return nullptr;
     }
+
     // we want to read more data than there is in the buffer
-    else if (bytesRetrieved > length) {
+    if (bytesRetrieved + count > length) {
         dataOk = false;
         throw OverflowException();
     }
+
     // all went well
-    else {
-        ret = msg_buffer.at(bytesRetrieved++);
-    }
+    const auto *data = msg_buffer.data() + bytesRetrieved;
+    bytesRetrieved += count;
+    return data;
+}
 
-    crc += ret;
-    return ret;
+auto BasicClientCommand::getUnsignedCharFromBuffer() -> unsigned char {
+    const auto *data = takeFromBuffer(1);
+    return data != nullptr ? data[0] : 0;
 }
 
 auto BasicClientCommand::getStringFromBuffer() -> std::string {
-    unsigned short int len = getShortIntFromBuffer();
+    const uint16_t len = getShortIntFromBuffer();
+
+    if (len == 0) {
+        return {};
+    }
 
-    std::string ret;
+    const auto *data = takeFromBuffer(len);
 
-    for (int i = 0; i < len; ++i) {
-        ret.append(1, getUnsignedCharFromBuffer());
+    if (data == nullptr) {
+        return {};
     }
 
-    return ret;
+    return {data, data + len};
 }
 
 auto BasicClientCommand::getIntFromBuffer() -> int {
-    int ret = getUnsignedCharFromBuffer() << 3 * CHAR_BIT;
-    ret = ret | (getUnsignedCharFromBuffer() << 2 * CHAR_BIT);
-    ret = ret | (getUnsignedCharFromBuffer() << CHAR_BIT);
-    ret = ret | getUnsignedCharFromBuffer();
-    return ret;
+    const auto *data = takeFromBuffer(4);
+
+    if (data == nullptr) {
+        return 0;
+    }
+
+    auto ret = static_cast<uint32_t>(data[0]) << 3 * CHAR_BIT;
+    ret = ret | static_cast<uint32_t>(data[1]) << 2 * CHAR_BIT;
+    ret = ret | static_cast<uint32_t>(data[2]) << CHAR_BIT;
+    ret = ret | data[3];
+    return static_cast<int>(ret);
 }
 
 auto BasicClientCommand::getShortIntFromBuffer() -> short int {
-    auto ret = static_cast<short int>(getUnsignedCharFromBuffer() << CHAR_BIT);
-    ret = static_cast<short int>(ret | getUnsignedCharFromBuffer());
-    return ret;
+    const auto *data = takeFromBuffer(2);
+
+    if (data == nullptr) {
+        return 0;
+    }
+
+    return static_cast<short int>((data[0] << CHAR_BIT) | data[1]);
 }
 
 auto BasicClientCommand::isDataOk() const -> bool {
     constexpr auto allBitsSet = 0xFFFF;
-    auto crcCheck = static_cast<uint16_t>(crc % allBitsSet);
-    return (dataOk && (length == bytesRetrieved) && (crcCheck == checkSum));
+
+    if (!dataOk || length != bytesRetrieved) {
+        return false;
+    }
+
+    auto crcCheck = static_cast<uint16_t>(byteSum(msg_buffer.data(), length) % allBitsSet);
+    return crcCheck == checkSum;
 }
@@ -22,6 +22,7 @@
 #include "netinterface/BasicCommand.hpp"
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -33,6 +34,29 @@ class OverflowException {};
 class BasicClientCommand;
 using ClientCommandPointer = std::shared_ptr<BasicClientCommand>;
 
+// memory of client commands is recycled, since every packet makes a new command
+auto allocateCommandMemory(size_t size) -> void *;
+void releaseCommandMemory(void *memory, size_t size) noexcept;
+
+template <class T> class ClientCommandAllocator {
+public:
+    using value_type = T;
+
+    ClientCommandAllocator() = default;
+    template <class U> ClientCommandAllocator(const ClientCommandAllocator<U> & /*other*/) noexcept {}
+
+    auto allocate(size_t n) -> T * { return static_cast<T *>(allocateCommandMemory(n * sizeof(T))); }
+    void deallocate(T *p, size_t n) noexcept { releaseCommandMemory(p, n * sizeof(T)); }
+
+    template <class U> auto operator==(const ClientCommandAllocator<U> & /*other*/) const -> bool { return true; }
+    template <class U> auto operator!=(const ClientCommandAllocator<U> & /*other*/) const -> bool { return false; }
+};
+
+// makes an empty command, object and control block come from recycled memory
+template <class Command> auto makeClientCommand() -> ClientCommandPointer {
+    return std::allocate_shared<Command>(ClientCommandAllocator<Command>{});
+}
+
 class BasicClientCommand : public BasicCommand {
 public:
     /**
@@ -67,12 +91,6 @@ public:
      */
     virtual void performAction(Player *player) = 0;
 
-    /**
-     * a copy function which returns an empty version of the command
-     * (for usage of the commandFactory class
-     */
-    virtual auto clone() -> ClientCommandPointer = 0;
-
     /**
      * returns if the receiving of the command was sucessfull
      * @return true if the command was receuved complete and without problems
@@ -121,10 +139,12 @@ protected:
     uint16_t length = 0;                     /*< the length of this command */
     uint16_t bytesRetrieved = 0;             /*< how much bytes are currently decoded */
     uint16_t checkSum = 0;                   /*< the checksum transmitted in the header*/
-    uint32_t crc = 0;                        /*< the checksum of the data*/
 
     uint16_t minAP; /*< number of ap necessary to perform command */
     std::chrono::steady_clock::time_point incomingTime;
+private:
+    // returns count bytes at the read position in one go
+    auto takeFromBuffer(uint16_t count) -> const unsigned char *;
 };
 
 #endif
@@ -18,4 +18,39 @@
 
 #include "BasicCommand.hpp"
 
+#include <climits>
+#include <cstring>
+
 BasicCommand::BasicCommand(unsigned char defByte) : definitionByte(defByte) {}
+
+auto byteSum(const unsigned char *data, size_t size) -> uint32_t {
+    constexpr uint64_t everySecondByte = 0x00FF00FF00FF00FFULL;
+    constexpr uint64_t everySecondShort = 0x0000FFFF0000FFFFULL;
+    constexpr auto shortBits = 2 * CHAR_BIT;
+    constexpr auto intBits = 4 * CHAR_BIT;
+    // a 16 bit lane grows by at most 2 * 255 per word, so lanes are added up before they can overflow
+    constexpr size_t wordsPerFold = 128;
+
+    uint32_t sum = 0;
+    size_t pos = 0;
+
+    while (size - pos >= sizeof(uint64_t)) {
+        uint64_t lanes = 0;
+
+        for (size_t words = 0; words < wordsPerFold && size - pos >= sizeof(uint64_t); ++words) {
+            uint64_t word = 0;
+            std::memcpy(&word, data + pos, sizeof(word));
+            lanes += (word & everySecondByte) + ((word >> CHAR_BIT) & everySecondByte);
+            pos += sizeof(word);
+        }
+
+        lanes = (lanes & everySecondShort) + ((lanes >> shortBits) & everySecondShort);
+        sum += static_cast<uint32_t>(lanes + (lanes >> intBits));
+    }
+
+    for (; pos < size; ++pos) {
+        sum += data[pos];
+    }
+
+    return sum;
+}
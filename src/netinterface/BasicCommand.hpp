@@ -19,6 +19,9 @@
 #ifndef CBASICCOMMAND_HPP
 #define CBASICCOMMAND_HPP
 
+#include <cstddef>
+#include <cstdint>
+
 /**
  *@ingroup Netinterface
  *Basic class for commands which can be sent to a client or received by the server,
@@ -41,4 +44,7 @@ public:
     [[nodiscard]] auto getDefinitionByte() const -> unsigned char { return definitionByte; };
 };
 
+// sum of all bytes, which the header checksum is derived from; reads eight bytes at a time
+[[nodiscard]] auto byteSum(const unsigned char *data, size_t size) -> uint32_t;
+
 #endif
@@ -23,34 +23,132 @@
 #include "netinterface/NetInterface.hpp"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <climits>
 #include <iostream>
+#include <mutex>
 
-BasicServerCommand::BasicServerCommand(unsigned char defByte) : BasicCommand(defByte) {
-    buffer.resize(baseBufferSize);
+namespace {
+
+// Recycles command buffers in power of two size classes. Commands are built on the game thread and released by
+// the io threads once written, so the free lists are shared behind a mutex.
+class BufferPool {
+public:
+    static auto get() -> BufferPool & {
+        static BufferPool pool;
+        return pool;
+    }
+
+    auto acquire(size_t size) -> std::vector<char> {
+        const auto sizeClass = sizeClassOf(size);
+
+        if (sizeClass < classCount) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto &buffers = free[sizeClass];
+
+            if (!buffers.empty()) {
+                auto buffer = std::move(buffers.back());
+                buffers.pop_back();
+                return buffer;
+            }
+        }
+
+        return std::vector<char>(std::max(size, smallestSize << sizeClass));
+    }
+
+    void release(std::vector<char> &&buffer) {
+        const auto sizeClass = sizeClassOf(buffer.size());
+
+        if (sizeClass >= classCount || (smallestSize << sizeClass) != buffer.size()) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto &buffers = free[sizeClass];
+
+        if (buffers.size() < maxPooledPerClass) {
+            buffers.push_back(std::move(buffer));
+        }
+    }
+
+private:
+    static constexpr size_t smallestSize = 64;
+    static constexpr size_t classCount = 11; // up to 64 KiB, the most a command can hold
+    static constexpr size_t maxPooledPerClass = 1024;
+
+    std::mutex mutex;
+    std::array<std::vector<std::vector<char>>, classCount> free;
+
+    static auto sizeClassOf(size_t size) -> size_t {
+        size_t sizeClass = 0;
+
+        while ((smallestSize << sizeClass) < size) {
+            ++sizeClass;
+        }
+
+        return sizeClass;
+    }
+};
+
+constexpr size_t firstBufferSize = 1000;
+
+// largest length seen per command id, so later commands of the same kind rarely need to grow
+std::array<std::atomic<uint16_t>, UCHAR_MAX + 1> highWaterMarks{};
+
+auto initialBufferSize(unsigned char defByte) -> size_t {
+    const auto highWaterMark = highWaterMarks[defByte].load(std::memory_order_relaxed);
+
+    // commands grow when only one byte is left
+    return highWaterMark == 0 ? firstBufferSize : highWaterMark + 2;
+}
+
+} // namespace
+
+BasicServerCommand::BasicServerCommand(unsigned char defByte)
+        : BasicCommand(defByte), buffer(BufferPool::get().acquire(initialBufferSize(defByte))) {
     initHeader();
 }
 
 BasicServerCommand::BasicServerCommand(unsigned char defByte, uint16_t bsize)
-        : BasicCommand(defByte), baseBufferSize(bsize) {
-    buffer.resize(baseBufferSize);
+        : BasicCommand(defByte), buffer(BufferPool::get().acquire(bsize)) {
     initHeader();
 }
 
+BasicServerCommand::~BasicServerCommand() {
+    if (buffer.empty()) {
+        return;
+    }
+
+    auto &highWaterMark = highWaterMarks[getDefinitionByte()];
+
+    if (bufferPos > highWaterMark.load(std::memory_order_relaxed)) {
+        highWaterMark.store(bufferPos, std::memory_order_relaxed);
+    }
+
+    BufferPool::get().release(std::move(buffer));
+}
+
 void BasicServerCommand::initHeader() {
     addUnsignedCharToBuffer(getDefinitionByte());
     addUnsignedCharToBuffer(getDefinitionByte() xor UCHAR_MAX);
     addShortIntToBuffer(0); // dummy for the length
     addShortIntToBuffer(0); // dummy for the checksum
-    checkSum = 0;           // reset checksum to 0, since the header is not included in checksum calculation
 }
 
 void BasicServerCommand::addHeader() {
+    if (headerAdded) {
+        return;
+    }
+
+    headerAdded = true;
+
     if (bufferPos >= headerSize) { // check if the buffer is large enough to add the data
         constexpr auto twoBytesSet = 0xFFFF;
-        const auto crc = static_cast<int16_t>(checkSum % twoBytesSet);
         const auto dataSize = bufferPos - headerSize;
+        const auto checkSum = byteSum(reinterpret_cast<const unsigned char *>(buffer.data()) + headerSize, dataSize);
+        const auto crc = static_cast<int16_t>(checkSum % twoBytesSet);
 
         buffer.at(lengthPosition) = (dataSize >> CHAR_BIT);
         buffer.at(lengthPosition + 1) = (dataSize & UCHAR_MAX);
@@ -62,50 +160,56 @@ void BasicServerCommand::addHeader() {
 
 auto BasicServerCommand::getLength() const -> int { return bufferPos; }
 
+auto BasicServerCommand::supersedes(const BasicServerCommand &other) const -> bool {
+    return hasSupersedeKey() && getDefinitionByte() == other.getDefinitionByte() &&
+           supersedeKeyEnd == other.supersedeKeyEnd &&
+           std::equal(buffer.begin() + headerSize, buffer.begin() + supersedeKeyEnd,
+                      other.buffer.begin() + headerSize);
+}
+
+void BasicServerCommand::markSupersedeKey() { supersedeKeyEnd = bufferPos; }
+
 auto BasicServerCommand::cmdData() const -> const std::vector<char> & { return buffer; }
 
-void BasicServerCommand::addStringToBuffer(const std::string &data) {
-    auto count = static_cast<short int>(data.length());
-    addShortIntToBuffer(count);
-    std::for_each(data.cbegin(), data.cend(), [this](auto c) { addUnsignedCharToBuffer(c); });
-}
+void BasicServerCommand::addStringToBuffer(const std::string &data) { addFields(data); }
 
-void BasicServerCommand::addIntToBuffer(int data) {
-    addUnsignedCharToBuffer((data >> 3 * CHAR_BIT));
-    addUnsignedCharToBuffer(((data >> 2 * CHAR_BIT) & UCHAR_MAX));
-    addUnsignedCharToBuffer(((data >> CHAR_BIT) & UCHAR_MAX));
-    addUnsignedCharToBuffer((data & UCHAR_MAX));
-}
+void BasicServerCommand::addIntToBuffer(int data) { addFields(static_cast<int32_t>(data)); }
 
-void BasicServerCommand::addShortIntToBuffer(short int data) {
-    addUnsignedCharToBuffer((data >> CHAR_BIT));
-    addUnsignedCharToBuffer((data & UCHAR_MAX));
-}
+void BasicServerCommand::addShortIntToBuffer(short int data) { addFields(static_cast<int16_t>(data)); }
 
 void BasicServerCommand::addUnsignedCharToBuffer(unsigned char data) {
     // resize the buffer if there is not enough place to store
-    if ((bufferPos + 1) >= (bufferSizeMod * baseBufferSize)) {
+    if (bufferPos + size_t{1} >= buffer.size()) {
         resizeBuffer();
     }
 
-    assert(bufferPos < (bufferSizeMod * baseBufferSize));
+    assert(bufferPos < buffer.size());
+    assert(!headerAdded);
     buffer.at(bufferPos) = data;
-    checkSum += data; // add the data to the checksum
     bufferPos++;
 }
 
-void BasicServerCommand::resizeBuffer() {
-    Logger::info(LogFacility::Other) << "Not enough memory. Resizing the send buffer. Current size: "
-                                     << bufferSizeMod * baseBufferSize << " bytes." << Log::end;
-    bufferSizeMod *= 2;
-    buffer.resize(bufferSizeMod * baseBufferSize);
-    Logger::info(LogFacility::Other) << "Resizing the send buffer successful. New size: "
-                                     << bufferSizeMod * baseBufferSize << " bytes." << Log::end;
+void BasicServerCommand::addBytesToBuffer(const std::vector<char> &data) {
+    reserve(data.size());
+    std::copy(data.begin(), data.end(), buffer.begin() + bufferPos);
+    bufferPos += data.size();
+}
+
+void BasicServerCommand::reserve(size_t size) {
+    assert(!headerAdded);
+
+    while ((bufferPos + size) >= buffer.size()) {
+        resizeBuffer();
+    }
 }
 
-void BasicServerCommand::addColourToBuffer(const Colour &c) {
-    addUnsignedCharToBuffer(c.red);
-    addUnsignedCharToBuffer(c.green);
-    addUnsignedCharToBuffer(c.blue);
-    addUnsignedCharToBuffer(c.alpha);
+void BasicServerCommand::resizeBuffer() {
+    Logger::debug(LogFacility::Other) << "Not enough memory. Resizing the send buffer. Current size: "
+                                      << buffer.size() << " bytes." << Log::end;
+    auto larger = BufferPool::get().acquire(2 * buffer.size());
+    std::copy(buffer.begin(), buffer.begin() + bufferPos, larger.begin());
+    BufferPool::get().release(std::move(buffer));
+    buffer = std::move(larger);
 }
+
+void BasicServerCommand::addColourToBuffer(const Colour &c) { addFields(c); }
@@ -20,6 +20,7 @@
 #define CBASICSERVERCOMMAND_HPP
 
 #include "netinterface/BasicCommand.hpp"
+#include "netinterface/CommandSchema.hpp"
 
 #include <cstdint>
 #include <memory>
@@ -39,13 +40,15 @@ using ServerCommandPointer = std::shared_ptr<BasicServerCommand>;
  *- Byte 2+3: Length of the following data segment
  *- Byte 4+5: Checksum consisting of the sum of all data bytes mod 0xFFFF
  *
- *Once all data has been added to the command, the header needs to be finalized with addHeader()
+ *Once all data has been added to the command, the header needs to be finalized with addHeader().
+ *From then on the command is immutable, so one instance can be queued for any number of recipients.
  */
 class BasicServerCommand : public BasicCommand {
 public:
     /**
      * Constructor which creates the server command.
-     * In this case the internal data buffer is 1000 bytes large.
+     * In this case the internal data buffer is sized after the largest command with this id so far,
+     * or 1000 bytes large for the first one.
      * @param defByte The id of this command
      */
     explicit BasicServerCommand(unsigned char defByte);
@@ -61,7 +64,8 @@ public:
     BasicServerCommand(const BasicServerCommand &) = delete;
     BasicServerCommand(BasicServerCommand &&) = default;
     auto operator=(BasicServerCommand &&) -> BasicServerCommand & = default;
-    ~BasicServerCommand() = default;
+    // hands the buffer back to the pool
+    ~BasicServerCommand();
 
     /**
      * Function which returns the data buffer of the command.
@@ -80,29 +84,48 @@ public:
     void addShortIntToBuffer(short int data);
     void addUnsignedCharToBuffer(unsigned char data);
     void addColourToBuffer(const Colour &c);
+    void addBytesToBuffer(const std::vector<char> &data);
+
+    // appends all fields in one go, the space for them is reserved once from their schema::Codec
+    template <class... Fields> void addFields(const Fields &...fields) {
+        const auto size = schema::encodedSize(fields...);
+        reserve(size);
+        schema::encode(reinterpret_cast<unsigned char *>(buffer.data()) + bufferPos, fields...);
+        bufferPos = static_cast<uint16_t>(bufferPos + size);
+    }
 
     /**
      * Adds all the header information to the top of the buffer
-     * which depends on the commands data, like length and checksum
+     * which depends on the commands data, like length and checksum.
+     * Only the first call does anything, later ones come from queueing a shared command again.
      */
     void addHeader();
     void initHeader();
 
-private:
+    [[nodiscard]] auto hasSupersedeKey() const -> bool { return supersedeKeyEnd != 0; }
+    // whether this command makes other, which was not sent yet, obsolete
+    [[nodiscard]] auto supersedes(const BasicServerCommand &other) const -> bool;
+
+protected:
     static constexpr uint16_t headerSize = 6;
+
+    // the data added so far identifies what the command updates, a newer command with equal key replaces it
+    void markSupersedeKey();
+
+private:
     static constexpr uint16_t lengthPosition = 2;
     static constexpr uint16_t crcPosition = 4;
-    static constexpr uint16_t defaultBufferSize = 1000;
-    uint16_t baseBufferSize = defaultBufferSize;
-
+    // drawn from a pool of power of two sizes
     std::vector<char> buffer;
-    uint32_t checkSum = 0;
 
-    uint16_t bufferPos = 0;     // stores the current buffer position and the size of the used buffer
-    uint16_t bufferSizeMod = 1; // bufferSizeMod * baseBufferSize = current buffer size
+    uint16_t bufferPos = 0; // stores the current buffer position and the size of the used buffer
+    bool headerAdded = false;
+    uint16_t supersedeKeyEnd = 0; // end of the key data, 0 if the command cannot be superseded
 
     // if there is a buffer overflow this function doubles buffer size
     void resizeBuffer();
+    // makes room for size more bytes
+    void reserve(size_t size);
 };
 
 #endif
@@ -21,69 +21,75 @@
 #include "netinterface/protocol/BBIWIClientCommands.hpp"
 #include "netinterface/protocol/ClientCommands.hpp"
 
-#include <memory>
+namespace {
 
-CommandFactory::CommandFactory() {
-    templateList[C_MESSAGEDIALOG_TS] = std::make_unique<MessageDialogTS>();
-    templateList[C_INPUTDIALOG_TS] = std::make_unique<InputDialogTS>();
-    templateList[C_MERCHANTDIALOG_TS] = std::make_unique<MerchantDialogTS>();
-    templateList[C_SELECTIONDIALOG_TS] = std::make_unique<SelectionDialogTS>();
-    templateList[C_CRAFTINGDIALOG_TS] = std::make_unique<CraftingDialogTS>();
-    templateList[C_LOGIN_TS] = std::make_unique<LoginCommandTS>();
-    templateList[C_SCREENSIZE_TS] = std::make_unique<ScreenSizeCommandTS>();
-    templateList[C_LOOKATMAPITEM_TS] = std::make_unique<LookAtMapItemTS>();
-    templateList[C_USE_TS] = std::make_unique<UseTS>();
-    templateList[C_CAST_TS] = std::make_unique<CastTS>();
-    templateList[C_ATTACKPLAYER_TS] = std::make_unique<AttackPlayerTS>();
-    templateList[C_CUSTOMNAME_TS] = std::make_unique<CustomNameTS>();
-    templateList[C_INTRODUCE_TS] = std::make_unique<IntroduceTS>();
-    templateList[C_SAY_TS] = std::make_unique<SayTS>();
-    templateList[C_SHOUT_TS] = std::make_unique<ShoutTS>();
-    templateList[C_WHISPER_TS] = std::make_unique<WhisperTS>();
-    templateList[C_REFRESH_TS] = std::make_unique<RefreshTS>();
-    templateList[C_LOGOUT_TS] = std::make_unique<LogOutTS>();
-    templateList[C_PICKUPITEM_TS] = std::make_unique<PickUpItemTS>();
-    templateList[C_PICKUPALLITEMS_TS] = std::make_unique<PickUpAllItemsTS>();
-    templateList[C_LOOKINTOCONTAINERONFIELD_TS] = std::make_unique<LookIntoContainerOnFieldTS>();
-    templateList[C_LOOKINTOINVENTORY_TS] = std::make_unique<LookIntoInventoryTS>();
-    templateList[C_LOOKINTOSHOWCASECONTAINER_TS] = std::make_unique<LookIntoShowCaseContainerTS>();
-    templateList[C_CLOSECONTAINERINSHOWCASE_TS] = std::make_unique<CloseContainerInShowCaseTS>();
-    templateList[C_DROPITEMFROMSHOWCASEONMAP_TS] = std::make_unique<DropItemFromShowCaseOnMapTS>();
-    templateList[C_MOVEITEMBETWEENSHOWCASES_TS] = std::make_unique<MoveItemBetweenShowCasesTS>();
-    templateList[C_MOVEITEMFROMMAPINTOSHOWCASE_TS] = std::make_unique<MoveItemFromMapIntoShowCaseTS>();
-    templateList[C_MOVEITEMFROMMAPTOPLAYER_TS] = std::make_unique<MoveItemFromMapToPlayerTS>();
-    templateList[C_MOVEITEMFROMMAPTOMAP_TS] = std::make_unique<MoveItemFromMapToMapTS>();
-    templateList[C_DROPITEMFROMPLAYERONMAP_TS] = std::make_unique<DropItemFromInventoryOnMapTS>();
-    templateList[C_MOVEITEMINSIDEINVENTORY_TS] = std::make_unique<MoveItemInsideInventoryTS>();
-    templateList[C_MOVEITEMFROMSHOWCASETOPLAYER_TS] = std::make_unique<MoveItemFromShowCaseToPlayerTS>();
-    templateList[C_MOVEITEMFROMPLAYERTOSHOWCASE_TS] = std::make_unique<MoveItemFromPlayerToShowCaseTS>();
-    templateList[C_LOOKATSHOWCASEITEM_TS] = std::make_unique<LookAtShowCaseItemTS>();
-    templateList[C_LOOKATINVENTORYITEM_TS] = std::make_unique<LookAtInventoryItemTS>();
-    templateList[C_ATTACKSTOP_TS] = std::make_unique<AttackStopTS>();
-    templateList[C_REQUESTSKILLS_TS] = std::make_unique<RequestSkillsTS>();
-    templateList[C_KEEPALIVE_TS] = std::make_unique<KeepAliveTS>();
-    templateList[BB_KEEPALIVE_TS] = std::make_unique<BBKeepAliveTS>();
-    templateList[BB_BROADCAST_TS] = std::make_unique<BBBroadCastTS>();
-    templateList[BB_DISCONNECT_TS] = std::make_unique<BBDisconnectTS>();
-    templateList[BB_BAN_TS] = std::make_unique<BBBanTS>();
-    templateList[BB_TALKTO_TS] = std::make_unique<BBTalktoTS>();
-    templateList[BB_CHANGEATTRIB_TS] = std::make_unique<BBChangeAttribTS>();
-    templateList[BB_CHANGESKILL_TS] = std::make_unique<BBChangeSkillTS>();
-    templateList[BB_SERVERCOMMAND_TS] = std::make_unique<BBServerCommandTS>();
-    templateList[BB_WARPPLAYER_TS] = std::make_unique<BBWarpPlayerTS>();
-    templateList[BB_SPEAKAS_TS] = std::make_unique<BBSpeakAsTS>();
-    templateList[C_CHARMOVE_TS] = std::make_unique<CharMoveTS>();
-    templateList[C_PLAYERSPIN_TS] = std::make_unique<PlayerSpinTS>();
-    templateList[C_LOOKATCHARACTER_TS] = std::make_unique<LookAtCharacterTS>();
-    templateList[C_REQUESTAPPEARANCE_TS] = std::make_unique<RequestAppearanceTS>();
-}
+using CommandMaker = auto (*)() -> ClientCommandPointer;
+
+constexpr auto commandTable = [] {
+    std::array<CommandMaker, UCHAR_MAX + 1> table{};
+    table[C_MESSAGEDIALOG_TS] = &makeClientCommand<MessageDialogTS>;
+    table[C_INPUTDIALOG_TS] = &makeClientCommand<InputDialogTS>;
+    table[C_MERCHANTDIALOG_TS] = &makeClientCommand<MerchantDialogTS>;
+    table[C_SELECTIONDIALOG_TS] = &makeClientCommand<SelectionDialogTS>;
+    table[C_CRAFTINGDIALOG_TS] = &makeClientCommand<CraftingDialogTS>;
+    table[C_LOGIN_TS] = &makeClientCommand<LoginCommandTS>;
+    table[C_SCREENSIZE_TS] = &makeClientCommand<ScreenSizeCommandTS>;
+    table[C_LOOKATMAPITEM_TS] = &makeClientCommand<LookAtMapItemTS>;
+    table[C_USE_TS] = &makeClientCommand<UseTS>;
+    table[C_CAST_TS] = &makeClientCommand<CastTS>;
+    table[C_ATTACKPLAYER_TS] = &makeClientCommand<AttackPlayerTS>;
+    table[C_CUSTOMNAME_TS] = &makeClientCommand<CustomNameTS>;
+    table[C_INTRODUCE_TS] = &makeClientCommand<IntroduceTS>;
+    table[C_SAY_TS] = &makeClientCommand<SayTS>;
+    table[C_SHOUT_TS] = &makeClientCommand<ShoutTS>;
+    table[C_WHISPER_TS] = &makeClientCommand<WhisperTS>;
+    table[C_REFRESH_TS] = &makeClientCommand<RefreshTS>;
+    table[C_LOGOUT_TS] = &makeClientCommand<LogOutTS>;
+    table[C_PICKUPITEM_TS] = &makeClientCommand<PickUpItemTS>;
+    table[C_PICKUPALLITEMS_TS] = &makeClientCommand<PickUpAllItemsTS>;
+    table[C_LOOKINTOCONTAINERONFIELD_TS] = &makeClientCommand<LookIntoContainerOnFieldTS>;
+    table[C_LOOKINTOINVENTORY_TS] = &makeClientCommand<LookIntoInventoryTS>;
+    table[C_LOOKINTOSHOWCASECONTAINER_TS] = &makeClientCommand<LookIntoShowCaseContainerTS>;
+    table[C_CLOSECONTAINERINSHOWCASE_TS] = &makeClientCommand<CloseContainerInShowCaseTS>;
+    table[C_DROPITEMFROMSHOWCASEONMAP_TS] = &makeClientCommand<DropItemFromShowCaseOnMapTS>;
+    table[C_MOVEITEMBETWEENSHOWCASES_TS] = &makeClientCommand<MoveItemBetweenShowCasesTS>;
+    table[C_MOVEITEMFROMMAPINTOSHOWCASE_TS] = &makeClientCommand<MoveItemFromMapIntoShowCaseTS>;
+    table[C_MOVEITEMFROMMAPTOPLAYER_TS] = &makeClientCommand<MoveItemFromMapToPlayerTS>;
+    table[C_MOVEITEMFROMMAPTOMAP_TS] = &makeClientCommand<MoveItemFromMapToMapTS>;
+    table[C_DROPITEMFROMPLAYERONMAP_TS] = &makeClientCommand<DropItemFromInventoryOnMapTS>;
+    table[C_MOVEITEMINSIDEINVENTORY_TS] = &makeClientCommand<MoveItemInsideInventoryTS>;
+    table[C_MOVEITEMFROMSHOWCASETOPLAYER_TS] = &makeClientCommand<MoveItemFromShowCaseToPlayerTS>;
+    table[C_MOVEITEMFROMPLAYERTOSHOWCASE_TS] = &makeClientCommand<MoveItemFromPlayerToShowCaseTS>;
+    table[C_LOOKATSHOWCASEITEM_TS] = &makeClientCommand<LookAtShowCaseItemTS>;
+    table[C_LOOKATINVENTORYITEM_TS] = &makeClientCommand<LookAtInventoryItemTS>;
+    table[C_ATTACKSTOP_TS] = &makeClientCommand<AttackStopTS>;
+    table[C_REQUESTSKILLS_TS] = &makeClientCommand<RequestSkillsTS>;
+    table[C_KEEPALIVE_TS] = &makeClientCommand<KeepAliveTS>;
+    table[C_COMPRESSION_TS] = &makeClientCommand<CompressionTS>;
+    table[BB_KEEPALIVE_TS] = &makeClientCommand<BBKeepAliveTS>;
+    table[BB_BROADCAST_TS] = &makeClientCommand<BBBroadCastTS>;
+    table[BB_DISCONNECT_TS] = &makeClientCommand<BBDisconnectTS>;
+    table[BB_BAN_TS] = &makeClientCommand<BBBanTS>;
+    table[BB_TALKTO_TS] = &makeClientCommand<BBTalktoTS>;
+    table[BB_CHANGEATTRIB_TS] = &makeClientCommand<BBChangeAttribTS>;
+    table[BB_CHANGESKILL_TS] = &makeClientCommand<BBChangeSkillTS>;
+    table[BB_SERVERCOMMAND_TS] = &makeClientCommand<BBServerCommandTS>;
+    table[BB_WARPPLAYER_TS] = &makeClientCommand<BBWarpPlayerTS>;
+    table[BB_SPEAKAS_TS] = &makeClientCommand<BBSpeakAsTS>;
+    table[C_CHARMOVE_TS] = &makeClientCommand<CharMoveTS>;
+    table[C_PLAYERSPIN_TS] = &makeClientCommand<PlayerSpinTS>;
+    table[C_LOOKATCHARACTER_TS] = &makeClientCommand<LookAtCharacterTS>;
+    table[C_REQUESTAPPEARANCE_TS] = &makeClientCommand<RequestAppearanceTS>;
+    return table;
+}();
+
+} // namespace
 
 auto CommandFactory::getCommand(unsigned char commandId) -> ClientCommandPointer {
-    COMMANDLIST::iterator it;
-    it = templateList.find(commandId);
+    const auto make = commandTable[commandId];
 
-    if (it != templateList.end()) {
-        return it->second->clone();
+    if (make != nullptr) {
+        return make();
     }
 
     return ClientCommandPointer();
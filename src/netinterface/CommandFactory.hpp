@@ -21,27 +21,20 @@
 
 #include "netinterface/BasicClientCommand.hpp"
 
-#include <memory>
-#include <unordered_map>
+#include <array>
+#include <climits>
 
 /**
- *factory class which holds templates of BasicServerCommand classes
- *an returns an empty command given by an id
+ *factory class which returns empty client commands by id, looked up in a table filled at compile time
  */
 class CommandFactory {
 public:
-    CommandFactory();
-
     /**
-     *returns a pointer to an emtpy Server Command
+     *returns a pointer to an emtpy client command
      *@param commandId the id of the command which we want to use
-     *@return a pointer to an empty command with the given commandId
+     *@return a pointer to an empty command with the given commandId or nullptr for unknown ids
      */
-    auto getCommand(unsigned char commandId) -> ClientCommandPointer;
-
-private:
-    using COMMANDLIST = std::unordered_map<unsigned char, std::unique_ptr<BasicClientCommand>>;
-    COMMANDLIST templateList;
+    static auto getCommand(unsigned char commandId) -> ClientCommandPointer;
 };
 
 #endif
@@ -0,0 +1,210 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef COMMAND_SCHEMA_HPP
+#define COMMAND_SCHEMA_HPP
+
+#include "globals.hpp"
+#include "types.hpp"
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+/**
+ *@ingroup Netinterface
+ * Wire encoding of the field types commands are made of. Each codec knows the exact size of an encoded value, so a
+ * command can reserve space for all of its fields once and write them without further checks. Only the types
+ * listed here can be used, so a field of the wrong width does not compile.
+ */
+namespace schema {
+
+template <class T> struct Codec;
+
+// big endian, as the client expects
+template <class T> struct IntegerCodec {
+    static constexpr auto size(T /*value*/) -> size_t { return sizeof(T); }
+
+    static void encode(unsigned char *&out, T value) {
+        auto bits = static_cast<std::make_unsigned_t<T>>(value);
+
+        for (size_t i = sizeof(T); i > 0; --i) {
+            out[i - 1] = static_cast<unsigned char>(bits & UCHAR_MAX);
+            bits = static_cast<std::make_unsigned_t<T>>(bits >> CHAR_BIT);
+        }
+
+        out += sizeof(T);
+    }
+
+    static auto decode(const unsigned char *&in) -> T {
+        std::make_unsigned_t<T> bits = 0;
+
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            bits = static_cast<std::make_unsigned_t<T>>((bits << CHAR_BIT) | in[i]);
+        }
+
+        in += sizeof(T);
+        return static_cast<T>(bits);
+    }
+};
+
+template <> struct Codec<int8_t> : IntegerCodec<int8_t> {};
+template <> struct Codec<uint8_t> : IntegerCodec<uint8_t> {};
+template <> struct Codec<int16_t> : IntegerCodec<int16_t> {};
+template <> struct Codec<uint16_t> : IntegerCodec<uint16_t> {};
+template <> struct Codec<int32_t> : IntegerCodec<int32_t> {};
+template <> struct Codec<uint32_t> : IntegerCodec<uint32_t> {};
+
+// unsigned LEB128 as used by compact_protocol, values below 128 take a single byte
+struct VarUint {
+    uint32_t value;
+};
+
+// zigzag mapped onto VarUint, so that small negative values are short as well
+struct VarInt {
+    int32_t value;
+};
+
+template <> struct Codec<VarUint> {
+    static constexpr unsigned payloadBits = 7;
+    static constexpr uint32_t payloadMask = 0x7F;
+    static constexpr unsigned char more = 0x80;
+
+    static constexpr auto size(VarUint value) -> size_t {
+        size_t bytes = 1;
+
+        while ((value.value >>= payloadBits) != 0) {
+            ++bytes;
+        }
+
+        return bytes;
+    }
+
+    static void encode(unsigned char *&out, VarUint value) {
+        while (value.value > payloadMask) {
+            *out++ = static_cast<unsigned char>((value.value & payloadMask) | more);
+            value.value >>= payloadBits;
+        }
+
+        *out++ = static_cast<unsigned char>(value.value);
+    }
+
+    static auto decode(const unsigned char *&in) -> VarUint {
+        uint32_t value = 0;
+        unsigned shift = 0;
+
+        while ((*in & more) != 0) {
+            value |= (static_cast<uint32_t>(*in++) & payloadMask) << shift;
+            shift += payloadBits;
+        }
+
+        value |= static_cast<uint32_t>(*in++) << shift;
+        return {value};
+    }
+};
+
+template <> struct Codec<VarInt> {
+    static constexpr auto zigzag(int32_t value) -> VarUint {
+        return {(static_cast<uint32_t>(value) << 1U) ^ static_cast<uint32_t>(value < 0 ? -1 : 0)};
+    }
+
+    static constexpr auto size(VarInt value) -> size_t { return Codec<VarUint>::size(zigzag(value.value)); }
+
+    static void encode(unsigned char *&out, VarInt value) { Codec<VarUint>::encode(out, zigzag(value.value)); }
+
+    static auto decode(const unsigned char *&in) -> VarInt {
+        const auto bits = Codec<VarUint>::decode(in).value;
+        return {static_cast<int32_t>((bits >> 1U) ^ (0U - (bits & 1U)))};
+    }
+};
+
+// 16 bit length followed by the bytes
+template <> struct Codec<std::string> {
+    static auto size(const std::string &value) -> size_t { return sizeof(uint16_t) + value.size(); }
+
+    static void encode(unsigned char *&out, const std::string &value) {
+        Codec<uint16_t>::encode(out, static_cast<uint16_t>(value.size()));
+        std::memcpy(out, value.data(), value.size());
+        out += value.size();
+    }
+
+    static auto decode(const unsigned char *&in) -> std::string {
+        const auto length = Codec<uint16_t>::decode(in);
+        std::string value(reinterpret_cast<const char *>(in), length);
+        in += length;
+        return value;
+    }
+};
+
+// x, y and z as 16 bit each
+template <> struct Codec<position> {
+    static constexpr auto size(const position & /*value*/) -> size_t { return 3 * sizeof(int16_t); }
+
+    static void encode(unsigned char *&out, const position &value) {
+        Codec<int16_t>::encode(out, static_cast<int16_t>(value.x));
+        Codec<int16_t>::encode(out, static_cast<int16_t>(value.y));
+        Codec<int16_t>::encode(out, static_cast<int16_t>(value.z));
+    }
+
+    static auto decode(const unsigned char *&in) -> position {
+        const Coordinate x = Codec<int16_t>::decode(in);
+        const Coordinate y = Codec<int16_t>::decode(in);
+        const Coordinate z = Codec<int16_t>::decode(in);
+        return {x, y, z};
+    }
+};
+
+template <> struct Codec<Colour> {
+    static constexpr auto size(const Colour & /*value*/) -> size_t { return 4; }
+
+    static void encode(unsigned char *&out, const Colour &value) {
+        *out++ = value.red;
+        *out++ = value.green;
+        *out++ = value.blue;
+        *out++ = value.alpha;
+    }
+
+    static auto decode(const unsigned char *&in) -> Colour {
+        Colour value(in[0], in[1], in[2]);
+        value.alpha = in[3];
+        in += 4;
+        return value;
+    }
+};
+
+template <class... Fields> auto encodedSize(const Fields &...fields) -> size_t {
+    return (Codec<Fields>::size(fields) + ... + 0);
+}
+
+template <class... Fields> void encode(unsigned char *out, const Fields &...fields) {
+    (Codec<Fields>::encode(out, fields), ...);
+}
+
+// reads fields in the order they were encoded, for checking commands in tests
+template <class... Fields> auto decode(const unsigned char *in) -> std::tuple<Fields...> {
+    // braced initialisation evaluates the decoders left to right
+    return std::tuple<Fields...>{Codec<Fields>::decode(in)...};
+}
+
+} // namespace schema
+
+#endif
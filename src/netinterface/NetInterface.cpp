@@ -19,15 +19,81 @@
 #include "netinterface/NetInterface.hpp"
 
 #include "CommandFactory.hpp"
+#include "Config.hpp"
+#include "Metrics.hpp"
 #include "Player.hpp"
 #include "netinterface/BasicClientCommand.hpp"
+#include "netinterface/SessionRecording.hpp"
 #include "netinterface/protocol/ClientCommands.hpp"
+#include "netinterface/protocol/ServerCommands.hpp"
 
+#include <algorithm>
 #include <climits>
 #include <iomanip>
 
+namespace {
+auto &bytesReceived =
+        metrics::Registry::get().counter("illarion_network_received_bytes_total", "Bytes read from clients");
+auto &bytesSent = metrics::Registry::get().counter("illarion_network_sent_bytes_total", "Bytes written to clients");
+auto &queuedSendBytes =
+        metrics::Registry::get().gauge("illarion_send_queue_bytes", "Bytes queued for clients and not yet written");
+
+// one counter per command id, registered when the id is first seen
+class CommandCounters {
+public:
+    CommandCounters(const char *name, const char *help) : name(name), help(help) {}
+
+    auto operator[](unsigned char id) -> metrics::Counter & {
+        auto *counter = counters[id].load(std::memory_order_acquire);
+
+        if (counter == nullptr) {
+            counter = &metrics::Registry::get().counter(name, help, "id=\"" + std::to_string(id) + '"');
+            counters[id].store(counter, std::memory_order_release);
+        }
+
+        return *counter;
+    }
+
+    [[nodiscard]] auto get(unsigned char id) const -> uint64_t {
+        const auto *counter = counters[id].load(std::memory_order_acquire);
+        return counter != nullptr ? counter->get() : 0;
+    }
+
+private:
+    const char *name;
+    const char *help;
+    std::array<std::atomic<metrics::Counter *>, UCHAR_MAX + 1> counters{};
+};
+
+CommandCounters commandsReceived{"illarion_client_commands_total", "Commands received from clients"};
+CommandCounters commandBytesReceived{"illarion_client_command_bytes_total",
+                                     "Bytes of the commands received from clients, headers included"};
+CommandCounters commandsQueued{"illarion_server_commands_total", "Commands queued for clients"};
+CommandCounters commandBytesQueued{"illarion_server_command_bytes_total",
+                                   "Bytes of the commands queued for clients, before compression"};
+
+auto trafficOf(const CommandCounters &commands, const CommandCounters &bytes)
+        -> std::vector<NetInterface::CommandTraffic> {
+    std::vector<NetInterface::CommandTraffic> traffic;
+
+    for (unsigned id = 0; id <= UCHAR_MAX; ++id) {
+        const auto count = commands.get(static_cast<unsigned char>(id));
+
+        if (count > 0) {
+            traffic.push_back({static_cast<unsigned char>(id), count, bytes.get(static_cast<unsigned char>(id))});
+        }
+    }
+
+    std::sort(traffic.begin(), traffic.end(), [](const auto &lhs, const auto &rhs) { return lhs.bytes > rhs.bytes; });
+    return traffic;
+}
+} // namespace
+
 NetInterface::NetInterface(boost::asio::io_service &io_servicen)
-        : online(false), headerBuffer{0}, socket(io_servicen), inactive(0), owner(nullptr) {
+        : online(false), headerBuffer{0}, sendBatchBytes(Config::instance().send_batch_bytes),
+          sendOncePerTick(Config::instance().send_once_per_tick), sendQueueBytes(Config::instance().send_queue_bytes),
+          compressionThreshold(Config::instance().compression_threshold), socket(io_servicen), strand(io_servicen),
+          loginTimeout(Config::instance().login_timeout), loginTimer(io_servicen), owner(nullptr) {
     cmd.reset();
 }
 
@@ -36,7 +102,12 @@ auto NetInterface::getIPAdress() -> std::string { return ipadress; }
 NetInterface::~NetInterface() {
     try {
         online = false;
-        sendQueue.clear();
+        for (auto &queue : sendQueues) {
+            queue.clear();
+        }
+
+        queuedSendBytes.add(-static_cast<int64_t>(queuedBytes));
+
         socket.close();
     } catch (std::exception &e) {
         Logger::error(LogFacility::Other) << "Error in NetInterface destructor: " << e.what() << Log::end;
@@ -49,10 +120,7 @@ void NetInterface::closeConnection() { online = false; }
 auto NetInterface::activate(Player *player) -> bool {
     try {
         owner = player;
-        boost::asio::async_read(socket, boost::asio::buffer(headerBuffer),
-                                [shared_this = shared_from_this()](const auto &error, auto bytes_transferred) {
-                                    shared_this->handle_read_header(error);
-                                });
+        readHeader();
         ipadress = socket.remote_endpoint().address().to_string();
         online = true;
         return true;
@@ -68,6 +136,115 @@ auto NetInterface::activate(Player *player) -> bool {
     }
 }
 
+auto NetInterface::laneOf(const BasicServerCommand &command) -> SendLane {
+    switch (command.getDefinitionByte()) {
+    case SC_KEEPALIVE_TC:
+    case SC_ID_TC:
+    case SC_SETCOORDINATE_TC:
+    case SC_MOVEACK_TC:
+    case SC_MULTIMOVE_TC:
+    case SC_PLAYERSPIN_TC:
+    case SC_APPEARANCE_TC:
+    case SC_REMOVECHAR_TC:
+    case SC_ATTACKACKNOWLEDGED_TC:
+    case SC_TARGETLOST_TC:
+    case SC_UPDATEATTRIB_TC:
+        return movementLane;
+
+    case SC_SAY_TC:
+    case SC_WHISPER_TC:
+    case SC_SHOUT_TC:
+    case SC_INFORM_TC:
+    case SC_INTRODUCE_TC:
+    case SC_LOOKATMAPITEM_TC:
+    case SC_LOOKATTILE_TC:
+    case SC_LOOKATSHOWCASEITEM_TC:
+    case SC_LOOKATINVENTORYITEM_TC:
+    case SC_LOOKATDIALOGITEM_TC:
+    case SC_LOOKATCHARRESULT_TC:
+        return chatLane;
+
+    case SC_GRAPHICEFFECT_TC:
+    case SC_SOUND_TC:
+    case SC_ANIMATION_TC:
+        return effectsLane;
+
+    default:
+        return worldLane;
+    }
+}
+
+void NetInterface::readHeader(size_t start) {
+    boost::asio::async_read(socket, boost::asio::buffer(&headerBuffer.at(start), headerSize - start),
+                            strand.wrap([shared_this = shared_from_this()](const auto &error,
+                                                                           auto bytes_transferred) {
+                                bytesReceived.increment(bytes_transferred);
+                                shared_this->handle_read_header(error);
+                            }));
+}
+
+void NetInterface::readData() {
+    boost::asio::async_read(socket, boost::asio::buffer(cmd->msg_data(), cmd->getLength()),
+                            strand.wrap([shared_this = shared_from_this()](const auto &error,
+                                                                           auto bytes_transferred) {
+                                bytesReceived.increment(bytes_transferred);
+                                shared_this->handle_read_data(error);
+                            }));
+}
+
+void NetInterface::writeQueued() {
+    writeBuffers.clear();
+    size_t bytes = 0;
+
+    for (auto &queue : sendQueues) {
+        while (!queue.empty()) {
+            auto length = static_cast<size_t>(queue.front()->getLength());
+
+            if (!commandsInFlight.empty() && bytes + length > sendBatchBytes) {
+                break;
+            }
+
+            auto command = std::move(queue.front());
+            queue.pop_front();
+            queuedBytes -= length;
+            queuedSendBytes.add(-static_cast<int64_t>(length));
+
+            // compressing in send order keeps the stream in sync with the client's
+            if (compressor && length >= compressionThreshold && length <= maxCompressedLength) {
+                command = std::make_shared<CompressedTC>(compressor->compress(command->cmdData().data(), length));
+                command->addHeader();
+                length = command->getLength();
+            }
+
+            writeBuffers.push_back(boost::asio::buffer(command->cmdData(), length));
+            bytes += length;
+            commandsInFlight.push_back(std::move(command));
+        }
+    }
+
+    if (sink) {
+        for (const auto &command : commandsInFlight) {
+            sink(*command);
+            bytesSent.increment(command->getLength());
+        }
+
+        commandsInFlight.clear();
+
+        if (queuedBytes > 0) {
+            writeQueued();
+        }
+
+        return;
+    }
+
+    boost::asio::async_write(socket, writeBuffers,
+                             strand.wrap([shared_this = shared_from_this()](const auto &error,
+                                                                            auto bytes_transferred) {
+                                 bytesSent.increment(bytes_transferred);
+                                 shared_this->handle_write(error);
+                             }));
+}
+
 void NetInterface::handle_read_data(const boost::system::error_code &error) {
     if (!error) {
         if (online) {
@@ -76,6 +253,11 @@ void NetInterface::handle_read_data(const boost::system::error_code &error) {
 
                 if (cmd->isDataOk()) {
                     cmd->setReceivedTime();
+                    const auto id = cmd->getDefinitionByte();
+                    const auto bytes = uint64_t{headerSize} + cmd->getLength();
+                    commandsReceived[id].increment();
+                    commandBytesReceived[id].increment(bytes);
+                    traffic.received(id, bytes);
 
                     if (owner == nullptr) {
                         auto login = std::dynamic_pointer_cast<LoginCommandTS>(cmd);
@@ -86,8 +268,15 @@ void NetInterface::handle_read_data(const boost::system::error_code &error) {
                         }
 
                         loginData = login;
+                        loginTimer.cancel();
+
+                        if (auto handler = std::exchange(loginHandler, nullptr)) {
+                            handler(shared_from_this());
+                        }
+
                         return;
                     }
+                    SessionRecorder::get().command(owner->getId(), *cmd);
                     owner->receiveCommand(cmd);
                 }
             } catch (OverflowException &e) {
@@ -109,23 +298,28 @@ void NetInterface::handle_read_data(const boost::system::error_code &error) {
             }
 
             cmd.reset();
-            boost::asio::async_read(socket, boost::asio::buffer(headerBuffer),
-                                    [shared_this = shared_from_this()](const auto &error, auto bytes_transferred) {
-                                        shared_this->handle_read_header(error);
-                                    });
+            readHeader();
         }
     } else {
         closeConnection();
-        boost::asio::async_read(socket, boost::asio::buffer(headerBuffer),
-                                [shared_this = shared_from_this()](const auto &error, auto bytes_transferred) {
-                                    shared_this->handle_read_header(error);
-                                });
+        readHeader();
     }
 }
 
-auto NetInterface::nextInactive() -> bool {
-    inactive++;
-    return (inactive > maxInactive);
+void NetInterface::awaitLogin(LoginHandler handler, TimeoutHandler onTimeout) {
+    loginHandler = std::move(handler);
+    loginTimer.expires_after(loginTimeout);
+    loginTimer.async_wait(strand.wrap([shared_this = shared_from_this(), onTimeout = std::move(onTimeout)](
+                                              const boost::system::error_code &error) {
+        if (!error && shared_this->online && !shared_this->loginData) {
+            shared_this->loginHandler = nullptr;
+            shared_this->shutdownSend(std::make_shared<LogOutTC>(UNSTABLECONNECTION));
+
+            if (onTimeout) {
+                onTimeout();
+            }
+        }
+    }));
 }
 
 void NetInterface::handle_read_header(const boost::system::error_code &error) {
@@ -136,14 +330,11 @@ void NetInterface::handle_read_header(const boost::system::error_code &error) {
             length = length | headerBuffer[lengthPosition + 1];
             uint16_t checkSum = headerBuffer[crcPosition] << CHAR_BIT;
             checkSum = checkSum | headerBuffer[crcPosition + 1];
-            cmd = commandFactory.getCommand(headerBuffer[commandPosition]);
+            cmd = CommandFactory::getCommand(headerBuffer[commandPosition]);
 
             if (cmd) {
                 cmd->setHeaderData(length, checkSum);
-                boost::asio::async_read(socket, boost::asio::buffer(cmd->msg_data(), cmd->getLength()),
-                                        [shared_this = shared_from_this()](const auto &error, auto bytes_transferred) {
-                                            shared_this->handle_read_data(error);
-                                        });
+                readData();
 
                 return;
             }
@@ -163,20 +354,14 @@ void NetInterface::handle_read_header(const boost::system::error_code &error) {
                 }
 
                 // restheader empfangen
-                boost::asio::async_read(socket, boost::asio::buffer(&headerBuffer.at(start), headerSize - start),
-                                        [shared_this = shared_from_this()](const auto &error, auto bytes_transferred) {
-                                            shared_this->handle_read_header(error);
-                                        });
+                readHeader(start);
 
                 return;
             }
         }
 
         // Keine Command Signature gefunden wieder 6 Byte Header auslesen
-        boost::asio::async_read(socket, boost::asio::buffer(headerBuffer),
-                                [shared_this = shared_from_this()](const auto &error, auto bytes_transferred) {
-                                    shared_this->handle_read_header(error);
-                                });
+        readHeader();
 
     } else {
         if (online) {
@@ -198,16 +383,47 @@ void NetInterface::addCommand(const ServerCommandPointer &command) {
     if (online) {
         command->addHeader();
         std::lock_guard<std::mutex> lock(sendQueueMutex);
-        bool write_in_progress = !sendQueue.empty();
-        sendQueue.push_back(command);
+        const auto lane = laneOf(*command);
+
+        if (queuedBytes > sendQueueBytes) {
+            if (queuedBytes > disconnectFactor * sendQueueBytes) {
+                Logger::warn(LogFacility::Other) << "Closing connection to " << getIPAdress() << " with "
+                                                 << queuedBytes << " bytes waiting to be sent" << Log::end;
+                closeConnection();
+                return;
+            }
+
+            if (lane == effectsLane) {
+                return;
+            }
+        }
+
+        bool write_in_progress = !commandsInFlight.empty();
+        auto &queue = sendQueues[lane];
+        auto superseded = queue.end();
+
+        if (command->hasSupersedeKey()) {
+            superseded = std::find_if(queue.begin(), queue.end(),
+                                      [&command](const auto &queued) { return command->supersedes(*queued); });
+        }
+
+        if (superseded != queue.end()) {
+            queuedBytes -= (*superseded)->getLength();
+            queuedSendBytes.add(-(*superseded)->getLength());
+            *superseded = command;
+        } else {
+            queue.push_back(command);
+        }
+
+        queuedBytes += command->getLength();
+        queuedSendBytes.add(command->getLength());
+        commandsQueued[command->getDefinitionByte()].increment();
+        commandBytesQueued[command->getDefinitionByte()].increment(command->getLength());
+        traffic.queued(command->getLength());
 
         try {
-            if (!write_in_progress && online) {
-                boost::asio::async_write(
-                        socket, boost::asio::buffer(sendQueue.front()->cmdData(), sendQueue.front()->getLength()),
-                        [shared_this = shared_from_this()](const auto &error, auto bytes_transferred) {
-                            shared_this->handle_write(error);
-                        });
+            if (!write_in_progress && !sendOncePerTick && online) {
+                writeQueued();
             }
         } catch (std::exception &e) {
             Logger::error(LogFacility::Other) << "Exception in NetInterface::addCommand: " << e.what() << Log::end;
@@ -216,14 +432,51 @@ void NetInterface::addCommand(const ServerCommandPointer &command) {
     }
 }
 
+auto NetInterface::serverCommandTraffic() -> std::vector<CommandTraffic> {
+    return trafficOf(commandsQueued, commandBytesQueued);
+}
+
+auto NetInterface::clientCommandTraffic() -> std::vector<CommandTraffic> {
+    return trafficOf(commandsReceived, commandBytesReceived);
+}
+
+void NetInterface::flush() {
+    if (online) {
+        std::lock_guard<std::mutex> lock(sendQueueMutex);
+
+        try {
+            if (commandsInFlight.empty() && queuedBytes > 0 && online) {
+                writeQueued();
+            }
+        } catch (std::exception &e) {
+            Logger::error(LogFacility::Other) << "Exception in NetInterface::flush: " << e.what() << Log::end;
+            closeConnection();
+        }
+    }
+}
+
+void NetInterface::enableCompression() {
+    if (compressionThreshold == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(sendQueueMutex);
+
+    if (!compressor) {
+        compressor = std::make_unique<StreamCompressor>();
+    }
+}
+
 void NetInterface::shutdownSend(const ServerCommandPointer &command) {
     try {
         command->addHeader();
         shutdownCmd = command;
         boost::asio::async_write(socket, boost::asio::buffer(shutdownCmd->cmdData(), shutdownCmd->getLength()),
-                                 [shared_this = shared_from_this()](const auto &error, auto bytes_transferred) {
+                                 strand.wrap([shared_this = shared_from_this()](const auto &error,
+                                                                                auto bytes_transferred) {
+                                     bytesSent.increment(bytes_transferred);
                                      shared_this->handle_write_shutdown(error);
-                                 });
+                                 }));
     } catch (std::exception &e) {
         Logger::error(LogFacility::Other) << "Exception in NetInterface::shutownSend: " << e.what() << Log::end;
         closeConnection();
@@ -235,14 +488,11 @@ void NetInterface::handle_write(const boost::system::error_code &error) {
         if (!error) {
             if (online) {
                 std::lock_guard<std::mutex> lock(sendQueueMutex);
-                sendQueue.pop_front();
-
-                if (!sendQueue.empty() && online) {
-                    boost::asio::async_write(
-                            socket, boost::asio::buffer(sendQueue.front()->cmdData(), sendQueue.front()->getLength()),
-                            [shared_this = shared_from_this()](const auto &error, auto bytes_transferred) {
-                                shared_this->handle_write(error);
-                            });
+                commandsInFlight.clear();
+
+                // what did not fit the batch or was queued meanwhile goes out right away, also with send_once_per_tick
+                if (queuedBytes > 0 && online) {
+                    writeQueued();
                 }
             }
         } else {
@@ -27,14 +27,17 @@
 #include "netinterface/BasicClientCommand.hpp"
 #include "netinterface/BasicServerCommand.hpp"
 #include "netinterface/CommandFactory.hpp"
-#include "thread_safe_vector.hpp"
-
+#include "netinterface/StreamCompressor.hpp"
 #include <array>
 #include <atomic>
 #include <boost/asio.hpp>
+#include <chrono>
+#include <climits>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 class LoginCommandTS;
 
@@ -69,7 +72,12 @@ public:
     auto activate(Player * /*player*/ = nullptr)
             -> bool; /*<activates the connection starts the sending and receiving threads, if player == nullptr only
                         login command is accepted and processing stops afterwards*/
-    auto nextInactive() -> bool;
+
+    using LoginHandler = std::function<void(const std::shared_ptr<NetInterface> &)>;
+    using TimeoutHandler = std::function<void()>;
+    // handler runs on an io thread once the login command arrived, without one within login_timeout the connection
+    // is closed and onTimeout runs instead
+    void awaitLogin(LoginHandler handler, TimeoutHandler onTimeout = nullptr);
 
     /**
      * adds a command to the send queue so it will be sended correctly to the connection
@@ -77,8 +85,14 @@ public:
      */
     void addCommand(const ServerCommandPointer &command);
 
+    // writes the queued commands now, needed with send_once_per_tick
+    void flush();
+
     void shutdownSend(const ServerCommandPointer &command);
 
+    // large commands queued from now on are sent compressed, unless compression_threshold is 0
+    void enableCompression();
+
     auto getIPAdress() -> std::string;
 
     std::atomic_bool online; /*< if connection is active*/
@@ -89,7 +103,62 @@ public:
 
     auto getLoginData() const -> std::shared_ptr<LoginCommandTS> { return loginData; }
 
+    // written commands go to the sink instead of the socket, for headless runs like benchmarks
+    using Sink = std::function<void(const BasicServerCommand &)>;
+    void setSink(Sink commandSink) { sink = std::move(commandSink); }
+
+    // commands and bytes of this connection, updated by the io threads and read by anyone
+    class Traffic {
+    public:
+        void received(unsigned char id, uint64_t bytes) {
+            receivedCommands.fetch_add(1, std::memory_order_relaxed);
+            receivedBytes.fetch_add(bytes, std::memory_order_relaxed);
+            receivedById[id].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void queued(uint64_t bytes) {
+            queuedCommands.fetch_add(1, std::memory_order_relaxed);
+            queuedBytes.fetch_add(bytes, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] auto getReceivedCommands() const -> uint64_t { return receivedCommands.load(); }
+        [[nodiscard]] auto getReceivedBytes() const -> uint64_t { return receivedBytes.load(); }
+        [[nodiscard]] auto getReceived(unsigned char id) const -> uint32_t { return receivedById[id].load(); }
+        [[nodiscard]] auto getQueuedCommands() const -> uint64_t { return queuedCommands.load(); }
+        [[nodiscard]] auto getQueuedBytes() const -> uint64_t { return queuedBytes.load(); }
+
+    private:
+        std::atomic<uint64_t> receivedCommands{0};
+        std::atomic<uint64_t> receivedBytes{0};
+        std::array<std::atomic<uint32_t>, UCHAR_MAX + 1> receivedById{};
+        std::atomic<uint64_t> queuedCommands{0};
+        std::atomic<uint64_t> queuedBytes{0};
+    };
+
+    [[nodiscard]] auto getTraffic() const -> const Traffic & { return traffic; }
+
+    struct CommandTraffic {
+        unsigned char id;
+        uint64_t commands;
+        uint64_t bytes;
+    };
+
+    // totals per command id over all connections, by bytes in descending order
+    static auto serverCommandTraffic() -> std::vector<CommandTraffic>;
+    static auto clientCommandTraffic() -> std::vector<CommandTraffic>;
+
 private:
+    // commands are sent lane by lane, so movement is not held up by map data and map data not by chat
+    enum SendLane : uint8_t { movementLane, worldLane, chatLane, effectsLane, laneCount };
+    static auto laneOf(const BasicServerCommand &command) -> SendLane;
+
+    // start asynchronous operations whose handlers run on strand
+    void readHeader(size_t start = 0);
+    void readData();
+    // writes as many queued commands as fit the batch size in one go, sendQueueMutex has to be held
+    // and there must be queued commands
+    void writeQueued();
+
     void handle_read_header(const boost::system::error_code &error);
     void handle_read_data(const boost::system::error_code &error);
 
@@ -107,20 +176,35 @@ private:
     ServerCommandPointer shutdownCmd;
     ServerCommandPointer cmdToWrite;
 
-    SERVERCOMMANDLIST sendQueue;
+    std::array<SERVERCOMMANDLIST, laneCount> sendQueues;
+    size_t queuedBytes = 0;
+    // the commands which are being written from writeBuffers
+    std::vector<ServerCommandPointer> commandsInFlight;
+    std::vector<boost::asio::const_buffer> writeBuffers;
+    size_t sendBatchBytes;
+    bool sendOncePerTick;
+    size_t sendQueueBytes;
+    static constexpr size_t disconnectFactor = 4;
+    std::unique_ptr<StreamCompressor> compressor;
+    size_t compressionThreshold;
+    // compressed commands still have to fit the 16 bit length of a command
+    static constexpr size_t maxCompressedLength = 60000;
 
     std::string ipadress;
 
     boost::asio::ip::tcp::socket socket;
+    // serializes the handlers of this connection when several threads run the io service
+    boost::asio::io_service::strand strand;
 
-    // Factory für Commands vom Client
-    CommandFactory commandFactory;
-    static constexpr auto maxInactive = 1000;
-    uint16_t inactive;
+    std::chrono::seconds loginTimeout;
+    boost::asio::steady_timer loginTimer;
+    LoginHandler loginHandler;
     std::mutex sendQueueMutex;
     std::shared_ptr<LoginCommandTS> loginData;
 
     Player *owner;
+    Traffic traffic;
+    Sink sink;
 };
 
 #endif
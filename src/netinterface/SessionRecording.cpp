@@ -0,0 +1,151 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "netinterface/SessionRecording.hpp"
+
+#include "netinterface/BasicClientCommand.hpp"
+#include "stream.hpp"
+
+#include <array>
+
+namespace {
+constexpr std::array<char, 4> magic{'I', 'L', 'S', 'R'};
+constexpr uint8_t version = 1;
+} // namespace
+
+auto SessionRecorder::get() -> SessionRecorder & {
+    static SessionRecorder recorder;
+    return recorder;
+}
+
+auto SessionRecorder::start(const std::string &path, uint32_t seed) -> bool {
+    std::lock_guard<std::mutex> lock(mutex);
+    log = std::ofstream(path, std::ios::binary | std::ios::out | std::ios::trunc);
+
+    if (!log) {
+        return false;
+    }
+
+    writeToStream(log, magic.data(), magic.size());
+    writeToStream(log, version);
+    writeToStream(log, seed);
+    startTime = Clock::now();
+    recording = true;
+    return true;
+}
+
+void SessionRecorder::stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    recording = false;
+    log.close();
+}
+
+void SessionRecorder::header(uint8_t kind, TYPE_OF_CHARACTER_ID player) {
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+    const auto time = static_cast<uint32_t>(duration_cast<milliseconds>(Clock::now() - startTime).count());
+    writeToStream(log, kind);
+    writeToStream(log, time);
+    writeToStream(log, player);
+}
+
+void SessionRecorder::login(TYPE_OF_CHARACTER_ID player, const position &pos) {
+    if (!isRecording()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    header(SessionRecording::login, player);
+    writeToStream(log, static_cast<int16_t>(pos.x));
+    writeToStream(log, static_cast<int16_t>(pos.y));
+    writeToStream(log, static_cast<int16_t>(pos.z));
+}
+
+void SessionRecorder::command(TYPE_OF_CHARACTER_ID player, BasicClientCommand &command) {
+    if (!isRecording()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    header(SessionRecording::command, player);
+    writeToStream(log, command.getDefinitionByte());
+    writeToStream(log, command.getLength());
+    writeToStream(log, reinterpret_cast<const char *>(command.msg_data().data()), command.getLength());
+}
+
+void SessionRecorder::logout(TYPE_OF_CHARACTER_ID player) {
+    if (!isRecording()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    header(SessionRecording::logout, player);
+}
+
+auto SessionRecording::read(const std::string &path) -> std::optional<SessionRecording> {
+    std::ifstream log(path, std::ios::binary | std::ios::in);
+    std::array<char, magic.size()> fileMagic{};
+    uint8_t fileVersion = 0;
+    SessionRecording recording;
+
+    readFromStream(log, fileMagic.data(), fileMagic.size());
+    readFromStream(log, fileVersion);
+    readFromStream(log, recording.seed);
+
+    if (!log || fileMagic != magic || fileVersion != version) {
+        return std::nullopt;
+    }
+
+    uint8_t kind = 0;
+    readFromStream(log, kind);
+
+    while (log) {
+        Record record;
+        uint32_t time = 0;
+        record.kind = static_cast<Kind>(kind);
+        readFromStream(log, time);
+        readFromStream(log, record.player);
+        record.time = std::chrono::milliseconds(time);
+
+        if (record.kind == login) {
+            int16_t x = 0;
+            int16_t y = 0;
+            int16_t z = 0;
+            readFromStream(log, x);
+            readFromStream(log, y);
+            readFromStream(log, z);
+            record.pos = position(x, y, z);
+        } else if (record.kind == command) {
+            uint16_t length = 0;
+            readFromStream(log, record.definition);
+            readFromStream(log, length);
+            record.payload.resize(length);
+            readFromStream(log, reinterpret_cast<char *>(record.payload.data()), length);
+        }
+
+        // a record cut off by a crash ends the recording
+        if (!log) {
+            break;
+        }
+
+        recording.records.push_back(std::move(record));
+        readFromStream(log, kind);
+    }
+
+    return recording;
+}
@@ -0,0 +1,85 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SESSION_RECORDING_HPP
+#define SESSION_RECORDING_HPP
+
+#include "globals.hpp"
+#include "types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+class BasicClientCommand;
+
+// Client commands of logged in players with the time they arrived, written to a compact log that can be replayed
+// against a snapshot world. Login commands are never recorded, so passwords stay out of the log. Commands are
+// recorded from the io threads, logins and logouts from the game thread.
+class SessionRecorder {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static auto get() -> SessionRecorder &;
+
+    // the seed Random was given, a replay seeds Random with it; returns false if the file could not be opened
+    auto start(const std::string &path, uint32_t seed) -> bool;
+    void stop();
+    [[nodiscard]] auto isRecording() const -> bool { return recording.load(std::memory_order_relaxed); }
+
+    void login(TYPE_OF_CHARACTER_ID player, const position &pos);
+    void command(TYPE_OF_CHARACTER_ID player, BasicClientCommand &command);
+    void logout(TYPE_OF_CHARACTER_ID player);
+
+private:
+    std::atomic_bool recording{false};
+    std::mutex mutex;
+    std::ofstream log;
+    Clock::time_point startTime;
+
+    void header(uint8_t kind, TYPE_OF_CHARACTER_ID player);
+
+    SessionRecorder() = default;
+};
+
+// a log written by SessionRecorder
+struct SessionRecording {
+    enum Kind : uint8_t { login, command, logout };
+
+    struct Record {
+        Kind kind = command;
+        std::chrono::milliseconds time{0};  // since the recording started
+        TYPE_OF_CHARACTER_ID player = 0;
+        position pos{};                     // of logins
+        unsigned char definition = 0;       // of commands
+        std::vector<unsigned char> payload; // of commands, without header
+    };
+
+    uint32_t seed = 0;
+    std::vector<Record> records;
+
+    // empty if the file could not be read or is no session recording
+    static auto read(const std::string &path) -> std::optional<SessionRecording>;
+};
+
+#endif
@@ -0,0 +1,62 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "netinterface/StreamCompressor.hpp"
+
+#include <stdexcept>
+
+StreamCompressor::StreamCompressor() {
+    constexpr int rawDeflateWindowBits = -15;
+    constexpr int memoryLevel = 8;
+
+    if (deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, rawDeflateWindowBits, memoryLevel, Z_DEFAULT_STRATEGY) !=
+        Z_OK) {
+        throw std::runtime_error("could not initialise deflate stream");
+    }
+}
+
+StreamCompressor::~StreamCompressor() { deflateEnd(&stream); }
+
+auto StreamCompressor::compress(const char *data, size_t size) -> std::vector<char> {
+    constexpr size_t flushReserve = 64;
+    std::vector<char> result(size + flushReserve);
+    size_t written = 0;
+
+    // zlib does not modify the input, its interface just lacks the const
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    stream.avail_in = static_cast<uInt>(size);
+
+    // a full output buffer means deflate may have more to flush
+    do {
+        if (written == result.size()) {
+            result.resize(2 * result.size());
+        }
+
+        stream.next_out = reinterpret_cast<Bytef *>(result.data() + written);
+        stream.avail_out = static_cast<uInt>(result.size() - written);
+
+        if (deflate(&stream, Z_SYNC_FLUSH) != Z_OK) {
+            throw std::runtime_error("deflate failed");
+        }
+
+        written = result.size() - stream.avail_out;
+    } while (stream.avail_out == 0);
+
+    result.resize(written);
+    return result;
+}
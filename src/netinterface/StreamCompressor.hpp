@@ -0,0 +1,47 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef STREAM_COMPRESSOR_HPP
+#define STREAM_COMPRESSOR_HPP
+
+#include <cstddef>
+#include <vector>
+#include <zlib.h>
+
+/**
+ *@ingroup Netinterface
+ * deflate stream of one connection. All data compressed by one instance forms a single raw deflate stream,
+ * so the window carries over and later commands are compressed against earlier ones.
+ */
+class StreamCompressor {
+public:
+    StreamCompressor();
+    StreamCompressor(const StreamCompressor &) = delete;
+    auto operator=(const StreamCompressor &) -> StreamCompressor & = delete;
+    StreamCompressor(StreamCompressor &&) = delete;
+    auto operator=(StreamCompressor &&) -> StreamCompressor & = delete;
+    ~StreamCompressor();
+
+    // compresses and flushes data, the client can decode the result as soon as it arrives
+    auto compress(const char *data, size_t size) -> std::vector<char>;
+
+private:
+    z_stream stream{};
+};
+
+#endif
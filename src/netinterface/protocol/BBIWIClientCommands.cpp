@@ -21,6 +21,7 @@
 #include "Logger.hpp"
 #include "MonitoringClients.hpp"
 #include "Player.hpp"
+#include "TickClock.hpp"
 #include "World.hpp"
 #include "netinterface/protocol/BBIWIServerCommands.hpp"
 
@@ -30,11 +31,6 @@ void BBBroadCastTS::decodeData() { msg = getStringFromBuffer(); }
 
 void BBBroadCastTS::performAction(Player *player) { World::get()->broadcast_command(player, msg); }
 
-auto BBBroadCastTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<BBBroadCastTS>();
-    return cmd;
-}
-
 BBSpeakAsTS::BBSpeakAsTS() : BasicClientCommand(BB_SPEAKAS_TS) {}
 
 void BBSpeakAsTS::decodeData() {
@@ -51,11 +47,6 @@ void BBSpeakAsTS::performAction(Player *player) {
     }
 }
 
-auto BBSpeakAsTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<BBSpeakAsTS>();
-    return cmd;
-}
-
 BBWarpPlayerTS::BBWarpPlayerTS() : BasicClientCommand(BB_WARPPLAYER_TS) {}
 
 void BBWarpPlayerTS::decodeData() {
@@ -73,11 +64,6 @@ void BBWarpPlayerTS::performAction(Player *player) {
     }
 }
 
-auto BBWarpPlayerTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<BBWarpPlayerTS>();
-    return cmd;
-}
-
 BBServerCommandTS::BBServerCommandTS() : BasicClientCommand(BB_SERVERCOMMAND_TS) {}
 
 void BBServerCommandTS::decodeData() { _command = getStringFromBuffer(); }
@@ -104,11 +90,6 @@ void BBServerCommandTS::performAction(Player *player) {
     }
 }
 
-auto BBServerCommandTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<BBServerCommandTS>();
-    return cmd;
-}
-
 BBChangeAttribTS::BBChangeAttribTS() : BasicClientCommand(BB_CHANGEATTRIB_TS) {}
 
 void BBChangeAttribTS::decodeData() {
@@ -129,11 +110,6 @@ void BBChangeAttribTS::performAction(Player *player) {
     }
 }
 
-auto BBChangeAttribTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<BBChangeAttribTS>();
-    return cmd;
-}
-
 BBChangeSkillTS::BBChangeSkillTS() : BasicClientCommand(BB_CHANGEATTRIB_TS) {}
 
 void BBChangeSkillTS::decodeData() {
@@ -153,11 +129,6 @@ void BBChangeSkillTS::performAction(Player *player) {
     }
 }
 
-auto BBChangeSkillTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<BBChangeSkillTS>();
-    return cmd;
-}
-
 BBTalktoTS::BBTalktoTS() : BasicClientCommand(BB_TALKTO_TS) {}
 
 void BBTalktoTS::decodeData() {
@@ -167,32 +138,17 @@ void BBTalktoTS::decodeData() {
 
 void BBTalktoTS::performAction(Player *player) { World::get()->talkto_command(player, std::to_string(id) + "," + msg); }
 
-auto BBTalktoTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<BBTalktoTS>();
-    return cmd;
-}
-
 BBDisconnectTS::BBDisconnectTS() : BasicClientCommand(BB_DISCONNECT_TS) {}
 
 void BBDisconnectTS::decodeData() {}
 
 void BBDisconnectTS::performAction(Player *player) { player->Connection->closeConnection(); }
 
-auto BBDisconnectTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<BBDisconnectTS>();
-    return cmd;
-}
-
 BBKeepAliveTS::BBKeepAliveTS() : BasicClientCommand(BB_KEEPALIVE_TS) {}
 
 void BBKeepAliveTS::decodeData() {}
 
-void BBKeepAliveTS::performAction(Player *player) { time(&(player->lastkeepalive)); }
-
-auto BBKeepAliveTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<BBKeepAliveTS>();
-    return cmd;
-}
+void BBKeepAliveTS::performAction(Player *player) { player->lastkeepalive = TickClock::wallNow(); }
 
 BBBanTS::BBBanTS() : BasicClientCommand(BB_BAN_TS) {}
 
@@ -212,8 +168,3 @@ void BBBanTS::performAction(Player *player) {
 
     World::get()->ban_command(player, banString);
 }
-
-auto BBBanTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<BBBanTS>();
-    return cmd;
-}
@@ -45,7 +45,6 @@ public:
 
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class BBSpeakAsTS : public BasicClientCommand {
@@ -57,7 +56,6 @@ public:
 
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class BBWarpPlayerTS : public BasicClientCommand {
@@ -69,7 +67,6 @@ public:
 
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class BBServerCommandTS : public BasicClientCommand {
@@ -80,7 +77,6 @@ public:
 
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class BBChangeAttribTS : public BasicClientCommand {
@@ -93,7 +89,6 @@ public:
 
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class BBChangeSkillTS : public BasicClientCommand {
@@ -106,7 +101,6 @@ public:
 
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class BBTalktoTS : public BasicClientCommand {
@@ -118,7 +112,6 @@ public:
 
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class BBDisconnectTS : public BasicClientCommand {
@@ -127,7 +120,6 @@ public:
 
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class BBKeepAliveTS : public BasicClientCommand {
@@ -136,7 +128,6 @@ public:
 
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class BBBanTS : public BasicClientCommand {
@@ -148,7 +139,6 @@ public:
 
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 #endif
@@ -25,6 +25,7 @@
 #include "Monster.hpp"
 #include "NPC.hpp"
 #include "Player.hpp"
+#include "TickClock.hpp"
 #include "World.hpp"
 #include "data/Data.hpp"
 #include "data/MonsterTable.hpp"
@@ -54,29 +55,19 @@ void InputDialogTS::decodeData() {
 }
 
 void InputDialogTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->executeInputDialog(dialogId, success, input);
 }
 
-auto InputDialogTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<InputDialogTS>();
-    return cmd;
-}
-
 MessageDialogTS::MessageDialogTS() : BasicClientCommand(C_MESSAGEDIALOG_TS) {}
 
 void MessageDialogTS::decodeData() { dialogId = getIntFromBuffer(); }
 
 void MessageDialogTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->executeMessageDialog(dialogId);
 }
 
-auto MessageDialogTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<MessageDialogTS>();
-    return cmd;
-}
-
 MerchantDialogTS::MerchantDialogTS() : BasicClientCommand(C_MERCHANTDIALOG_TS) {}
 
 void MerchantDialogTS::decodeData() {
@@ -106,7 +97,7 @@ void MerchantDialogTS::decodeData() {
 }
 
 void MerchantDialogTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
 
     switch (result) {
     case 0:
@@ -127,11 +118,6 @@ void MerchantDialogTS::performAction(Player *player) {
     }
 }
 
-auto MerchantDialogTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<MerchantDialogTS>();
-    return cmd;
-}
-
 SelectionDialogTS::SelectionDialogTS() : BasicClientCommand(C_SELECTIONDIALOG_TS) {}
 
 void SelectionDialogTS::decodeData() {
@@ -141,15 +127,10 @@ void SelectionDialogTS::decodeData() {
 }
 
 void SelectionDialogTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->executeSelectionDialog(dialogId, success, selectedIndex);
 }
 
-auto SelectionDialogTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<SelectionDialogTS>();
-    return cmd;
-}
-
 CraftingDialogTS::CraftingDialogTS() : BasicClientCommand(C_CRAFTINGDIALOG_TS) {}
 
 void CraftingDialogTS::decodeData() {
@@ -177,7 +158,7 @@ void CraftingDialogTS::decodeData() {
 }
 
 void CraftingDialogTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
 
     switch (result) {
     case 0:
@@ -198,11 +179,6 @@ void CraftingDialogTS::performAction(Player *player) {
     }
 }
 
-auto CraftingDialogTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<CraftingDialogTS>();
-    return cmd;
-}
-
 RequestAppearanceTS::RequestAppearanceTS() : BasicClientCommand(C_REQUESTAPPEARANCE_TS) {}
 
 void RequestAppearanceTS::decodeData() { id = getIntFromBuffer(); }
@@ -224,11 +200,6 @@ void RequestAppearanceTS::performAction(Player *player) {
     }
 }
 
-auto RequestAppearanceTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<RequestAppearanceTS>();
-    return cmd;
-}
-
 LookAtCharacterTS::LookAtCharacterTS() : BasicClientCommand(C_LOOKATCHARACTER_TS, P_LOOK_COST) {}
 
 void LookAtCharacterTS::decodeData() {
@@ -284,11 +255,6 @@ void LookAtCharacterTS::performAction(Player *player) {
     }
 }
 
-auto LookAtCharacterTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<LookAtCharacterTS>();
-    return cmd;
-}
-
 CastTS::CastTS() : BasicClientCommand(C_CAST_TS) {}
 
 void CastTS::decodeData() {
@@ -317,7 +283,7 @@ void CastTS::decodeData() {
 }
 
 void CastTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
 
     bool paramOK = true;
@@ -559,11 +525,6 @@ void CastTS::performAction(Player *player) {
     }
 }
 
-auto CastTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<CastTS>();
-    return cmd;
-}
-
 UseTS::UseTS() : BasicClientCommand(C_USE_TS, P_MIN_AP) {}
 
 void UseTS::decodeData() {
@@ -588,7 +549,7 @@ void UseTS::decodeData() {
 }
 
 void UseTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
 
     Logger::debug(LogFacility::Script) << *player << " uses something" << Log::end;
@@ -703,7 +664,7 @@ void UseTS::performAction(Player *player) {
                 Container *tempc = nullptr;
 
                 if (ps->viewItemNr(pos, tempi, tempc)) {
-                    Logger::debug(LogFacility::Script) << "pos found item id: " << tempi.getId() << Log::end;
+                    LOG(debug, LogFacility::Script) << "pos found item id: " << tempi.getId() << Log::end;
 
                     LuaScript = Data::items().script(tempi.getId());
 
@@ -821,25 +782,25 @@ void UseTS::performAction(Player *player) {
     World::get()->monitoringClientList->sendCommand(cmd);
 }
 
-auto UseTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<UseTS>();
-    return cmd;
-}
-
 KeepAliveTS::KeepAliveTS() : BasicClientCommand(C_KEEPALIVE_TS) {}
 
 void KeepAliveTS::decodeData() {}
 
 void KeepAliveTS::performAction(Player *player) {
     Logger::debug(LogFacility::Player) << "KEEPALIVE_TS from player " << *player << Log::end;
-    time(&(player->lastkeepalive));
+    player->lastkeepalive = TickClock::wallNow();
     ServerCommandPointer cmd = std::make_shared<KeepAliveTC>();
     player->Connection->addCommand(cmd);
 }
 
-auto KeepAliveTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<KeepAliveTS>();
-    return cmd;
+CompressionTS::CompressionTS() : BasicClientCommand(C_COMPRESSION_TS) {}
+
+void CompressionTS::decodeData() { mode = getUnsignedCharFromBuffer(); }
+
+void CompressionTS::performAction(Player *player) {
+    if (mode == deflateMode) {
+        player->Connection->enableCompression();
+    }
 }
 
 RequestSkillsTS::RequestSkillsTS() : BasicClientCommand(C_REQUESTSKILLS_TS) {}
@@ -847,32 +808,22 @@ RequestSkillsTS::RequestSkillsTS() : BasicClientCommand(C_REQUESTSKILLS_TS) {}
 void RequestSkillsTS::decodeData() {}
 
 void RequestSkillsTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->sendAllSkills();
 }
 
-auto RequestSkillsTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<RequestSkillsTS>();
-    return cmd;
-}
-
 AttackStopTS::AttackStopTS() : BasicClientCommand(C_ATTACKSTOP_TS) {}
 
 void AttackStopTS::decodeData() {}
 
 void AttackStopTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
     player->setAttackMode(false);
     ServerCommandPointer cmd = std::make_shared<TargetLostTC>();
     player->Connection->addCommand(cmd);
 }
 
-auto AttackStopTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<AttackStopTS>();
-    return cmd;
-}
-
 LookAtInventoryItemTS::LookAtInventoryItemTS() : BasicClientCommand(C_LOOKATINVENTORYITEM_TS, P_LOOK_COST) {}
 
 void LookAtInventoryItemTS::decodeData() { pos = getUnsignedCharFromBuffer(); }
@@ -886,11 +837,6 @@ void LookAtInventoryItemTS::performAction(Player *player) {
     }
 }
 
-auto LookAtInventoryItemTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<LookAtInventoryItemTS>();
-    return cmd;
-}
-
 LookAtShowCaseItemTS::LookAtShowCaseItemTS() : BasicClientCommand(C_LOOKATSHOWCASEITEM_TS, P_LOOK_COST) {}
 
 void LookAtShowCaseItemTS::decodeData() {
@@ -907,11 +853,6 @@ void LookAtShowCaseItemTS::performAction(Player *player) {
     }
 }
 
-auto LookAtShowCaseItemTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<LookAtShowCaseItemTS>();
-    return cmd;
-}
-
 MoveItemFromPlayerToShowCaseTS::MoveItemFromPlayerToShowCaseTS()
         : BasicClientCommand(C_MOVEITEMFROMPLAYERTOSHOWCASE_TS, P_ITEMMOVE_COST) {}
 
@@ -923,7 +864,7 @@ void MoveItemFromPlayerToShowCaseTS::decodeData() {
 }
 
 void MoveItemFromPlayerToShowCaseTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
     Logger::debug(LogFacility::World) << *player << "moves an item from the inventory to showcase!" << Log::end;
 
@@ -933,11 +874,6 @@ void MoveItemFromPlayerToShowCaseTS::performAction(Player *player) {
     }
 }
 
-auto MoveItemFromPlayerToShowCaseTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<MoveItemFromPlayerToShowCaseTS>();
-    return cmd;
-}
-
 MoveItemFromShowCaseToPlayerTS::MoveItemFromShowCaseToPlayerTS()
         : BasicClientCommand(C_MOVEITEMFROMSHOWCASETOPLAYER_TS, P_ITEMMOVE_COST) {}
 
@@ -949,7 +885,7 @@ void MoveItemFromShowCaseToPlayerTS::decodeData() {
 }
 
 void MoveItemFromShowCaseToPlayerTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
     Logger::debug(LogFacility::World) << *player << " moves an item from the shocase to the inventory!" << Log::end;
 
@@ -959,11 +895,6 @@ void MoveItemFromShowCaseToPlayerTS::performAction(Player *player) {
     }
 }
 
-auto MoveItemFromShowCaseToPlayerTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<MoveItemFromShowCaseToPlayerTS>();
-    return cmd;
-}
-
 MoveItemInsideInventoryTS::MoveItemInsideInventoryTS()
         : BasicClientCommand(C_MOVEITEMINSIDEINVENTORY_TS, P_ITEMMOVE_COST) {}
 
@@ -974,7 +905,7 @@ void MoveItemInsideInventoryTS::decodeData() {
 }
 
 void MoveItemInsideInventoryTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
     Logger::debug(LogFacility::World) << *player << "moves an item inside the inventory!" << Log::end;
 
@@ -984,11 +915,6 @@ void MoveItemInsideInventoryTS::performAction(Player *player) {
     }
 }
 
-auto MoveItemInsideInventoryTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<MoveItemInsideInventoryTS>();
-    return cmd;
-}
-
 DropItemFromInventoryOnMapTS::DropItemFromInventoryOnMapTS()
         : BasicClientCommand(C_DROPITEMFROMPLAYERONMAP_TS, P_ITEMMOVE_COST) {}
 
@@ -1001,18 +927,13 @@ void DropItemFromInventoryOnMapTS::decodeData() {
 }
 
 void DropItemFromInventoryOnMapTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
     Logger::debug(LogFacility::World) << *player << " throws an item from inventory on the map!" << Log::end;
     World::get()->dropItemFromPlayerOnMap(player, pos, mapPosition, count);
     player->increaseActionPoints(-P_ITEMMOVE_COST);
 }
 
-auto DropItemFromInventoryOnMapTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<DropItemFromInventoryOnMapTS>();
-    return cmd;
-}
-
 MoveItemFromMapToPlayerTS::MoveItemFromMapToPlayerTS()
         : BasicClientCommand(C_MOVEITEMFROMMAPTOPLAYER_TS, P_ITEMMOVE_COST) {}
 
@@ -1025,7 +946,7 @@ void MoveItemFromMapToPlayerTS::decodeData() {
 }
 
 void MoveItemFromMapToPlayerTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
     Logger::debug(LogFacility::World) << *player << " moves an item from map " << sourcePosition
                                       << " to inventory slot " << inventorySlot << Log::end;
@@ -1036,11 +957,6 @@ void MoveItemFromMapToPlayerTS::performAction(Player *player) {
     }
 }
 
-auto MoveItemFromMapToPlayerTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<MoveItemFromMapToPlayerTS>();
-    return cmd;
-}
-
 MoveItemFromMapIntoShowCaseTS::MoveItemFromMapIntoShowCaseTS()
         : BasicClientCommand(C_MOVEITEMFROMMAPINTOSHOWCASE_TS, P_ITEMMOVE_COST) {}
 
@@ -1054,7 +970,7 @@ void MoveItemFromMapIntoShowCaseTS::decodeData() {
 }
 
 void MoveItemFromMapIntoShowCaseTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
     Logger::debug(LogFacility::World) << *player << " moves an item from map " << sourcePosition << " to showcase "
                                       << (int)showcase << " slot " << (int)showcaseSlot << Log::end;
@@ -1065,11 +981,6 @@ void MoveItemFromMapIntoShowCaseTS::performAction(Player *player) {
     }
 }
 
-auto MoveItemFromMapIntoShowCaseTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<MoveItemFromMapIntoShowCaseTS>();
-    return cmd;
-}
-
 MoveItemFromMapToMapTS::MoveItemFromMapToMapTS() : BasicClientCommand(C_MOVEITEMFROMMAPTOMAP_TS, P_ITEMMOVE_COST) {}
 
 void MoveItemFromMapToMapTS::decodeData() {
@@ -1083,7 +994,7 @@ void MoveItemFromMapToMapTS::decodeData() {
 }
 
 void MoveItemFromMapToMapTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
     Logger::debug(LogFacility::World) << *player << " moves an item from map " << sourcePosition << " to map "
                                       << targetPosition << Log::end;
@@ -1094,11 +1005,6 @@ void MoveItemFromMapToMapTS::performAction(Player *player) {
     }
 }
 
-auto MoveItemFromMapToMapTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<MoveItemFromMapToMapTS>();
-    return cmd;
-}
-
 MoveItemBetweenShowCasesTS::MoveItemBetweenShowCasesTS()
         : BasicClientCommand(C_MOVEITEMBETWEENSHOWCASES_TS, P_ITEMMOVE_COST) {}
 
@@ -1111,7 +1017,7 @@ void MoveItemBetweenShowCasesTS::decodeData() {
 }
 
 void MoveItemBetweenShowCasesTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
     Logger::debug(LogFacility::World) << *player << " moves an item between showcases!" << Log::end;
 
@@ -1121,11 +1027,6 @@ void MoveItemBetweenShowCasesTS::performAction(Player *player) {
     }
 }
 
-auto MoveItemBetweenShowCasesTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<MoveItemBetweenShowCasesTS>();
-    return cmd;
-}
-
 DropItemFromShowCaseOnMapTS::DropItemFromShowCaseOnMapTS()
         : BasicClientCommand(C_DROPITEMFROMSHOWCASEONMAP_TS, P_ITEMMOVE_COST) {}
 
@@ -1139,24 +1040,19 @@ void DropItemFromShowCaseOnMapTS::decodeData() {
 }
 
 void DropItemFromShowCaseOnMapTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
     Logger::debug(LogFacility::World) << *player << " moves an item from showcase to the map!" << Log::end;
     World::get()->dropItemFromShowcaseOnMap(player, showcase, pos, mapPosition, count);
     player->increaseActionPoints(-P_ITEMMOVE_COST);
 }
 
-auto DropItemFromShowCaseOnMapTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<DropItemFromShowCaseOnMapTS>();
-    return cmd;
-}
-
 CloseContainerInShowCaseTS::CloseContainerInShowCaseTS() : BasicClientCommand(C_CLOSECONTAINERINSHOWCASE_TS) {}
 
 void CloseContainerInShowCaseTS::decodeData() { showcase = getUnsignedCharFromBuffer(); }
 
 void CloseContainerInShowCaseTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
     Logger::debug(LogFacility::World) << *player << " closes a container in the showcase" << Log::end;
 
@@ -1165,11 +1061,6 @@ void CloseContainerInShowCaseTS::performAction(Player *player) {
     }
 }
 
-auto CloseContainerInShowCaseTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<CloseContainerInShowCaseTS>();
-    return cmd;
-}
-
 LookIntoShowCaseContainerTS::LookIntoShowCaseContainerTS()
         : BasicClientCommand(C_LOOKINTOSHOWCASECONTAINER_TS, P_LOOK_COST) {}
 
@@ -1179,42 +1070,32 @@ void LookIntoShowCaseContainerTS::decodeData() {
 }
 
 void LookIntoShowCaseContainerTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
     Logger::debug(LogFacility::World) << *player << " looks into a container in a showcase!" << Log::end;
     player->lookIntoShowcaseContainer(showcase, pos);
     player->increaseActionPoints(-P_LOOK_COST);
 }
 
-auto LookIntoShowCaseContainerTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<LookIntoShowCaseContainerTS>();
-    return cmd;
-}
-
 LookIntoInventoryTS::LookIntoInventoryTS() : BasicClientCommand(C_LOOKINTOINVENTORY_TS, P_LOOK_COST) {}
 
 void LookIntoInventoryTS::decodeData() {}
 
 void LookIntoInventoryTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
     Logger::debug(LogFacility::World) << *player << " looks into his backpack" << Log::end;
     player->lookIntoBackPack();
     player->increaseActionPoints(-P_LOOK_COST);
 }
 
-auto LookIntoInventoryTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<LookIntoInventoryTS>();
-    return cmd;
-}
-
 LookIntoContainerOnFieldTS::LookIntoContainerOnFieldTS()
         : BasicClientCommand(C_LOOKINTOCONTAINERONFIELD_TS, P_LOOK_COST) {}
 
 void LookIntoContainerOnFieldTS::decodeData() { dir = to_direction(getUnsignedCharFromBuffer()); }
 
 void LookIntoContainerOnFieldTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
     Logger::debug(LogFacility::World) << *player << " looks into a container on the map" << Log::end;
 
@@ -1224,11 +1105,6 @@ void LookIntoContainerOnFieldTS::performAction(Player *player) {
     }
 }
 
-auto LookIntoContainerOnFieldTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<LookIntoContainerOnFieldTS>();
-    return cmd;
-}
-
 PickUpItemTS::PickUpItemTS() : BasicClientCommand(C_PICKUPITEM_TS, P_ITEMMOVE_COST) {}
 
 void PickUpItemTS::decodeData() {
@@ -1238,7 +1114,7 @@ void PickUpItemTS::decodeData() {
 }
 
 void PickUpItemTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
     Logger::debug(LogFacility::World) << *player << " tries to pick up item at " << pos << Log::end;
 
@@ -1248,17 +1124,12 @@ void PickUpItemTS::performAction(Player *player) {
     }
 }
 
-auto PickUpItemTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<PickUpItemTS>();
-    return cmd;
-}
-
 PickUpAllItemsTS::PickUpAllItemsTS() : BasicClientCommand(C_PICKUPALLITEMS_TS, P_ITEMMOVE_COST) {}
 
 void PickUpAllItemsTS::decodeData() {}
 
 void PickUpAllItemsTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
     Logger::debug(LogFacility::World) << *player << " tries to pick up all nearby items" << Log::end;
 
@@ -1268,11 +1139,6 @@ void PickUpAllItemsTS::performAction(Player *player) {
     }
 }
 
-auto PickUpAllItemsTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<PickUpAllItemsTS>();
-    return cmd;
-}
-
 LogOutTS::LogOutTS() : BasicClientCommand(C_LOGOUT_TS) {}
 
 void LogOutTS::decodeData() {}
@@ -1283,46 +1149,31 @@ void LogOutTS::performAction(Player *player) {
     player->Connection->closeConnection();
 }
 
-auto LogOutTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<LogOutTS>();
-    return cmd;
-}
-
 WhisperTS::WhisperTS() : BasicClientCommand(C_WHISPER_TS) {}
 
 void WhisperTS::decodeData() { text = getStringFromBuffer(); }
 
 void WhisperTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     Logger::debug(LogFacility::World) << *player << " whispers something!" << Log::end;
     player->talk(Character::tt_whisper, text);
 }
 
-auto WhisperTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<WhisperTS>();
-    return cmd;
-}
-
 ShoutTS::ShoutTS() : BasicClientCommand(C_SHOUT_TS) {}
 
 void ShoutTS::decodeData() { text = getStringFromBuffer(); }
 
 void ShoutTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->talk(Character::tt_yell, text);
 }
 
-auto ShoutTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<ShoutTS>();
-    return cmd;
-}
-
 SayTS::SayTS() : BasicClientCommand(C_SAY_TS) {}
 
 void SayTS::decodeData() { text = getStringFromBuffer(); }
 
 void SayTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     Logger::debug(LogFacility::World) << *player << " whispers something!" << Log::end;
 
     if (!World::get()->parseGMCommands(player, text)) {
@@ -1332,11 +1183,6 @@ void SayTS::performAction(Player *player) {
     }
 }
 
-auto SayTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<SayTS>();
-    return cmd;
-}
-
 RefreshTS::RefreshTS() : BasicClientCommand(C_REFRESH_TS) {}
 
 void RefreshTS::decodeData() {}
@@ -1347,17 +1193,12 @@ void RefreshTS::performAction(Player *player) {
     World::get()->sendAllVisibleCharactersToPlayer(player, true);
 }
 
-auto RefreshTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<RefreshTS>();
-    return cmd;
-}
-
 IntroduceTS::IntroduceTS() : BasicClientCommand(C_INTRODUCE_TS) {}
 
 void IntroduceTS::decodeData() {}
 
 void IntroduceTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     Logger::debug(LogFacility::World) << *player << " introduces himself!" << Log::end;
 
     if (player->isAlive()) {
@@ -1365,11 +1206,6 @@ void IntroduceTS::performAction(Player *player) {
     }
 }
 
-auto IntroduceTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<IntroduceTS>();
-    return cmd;
-}
-
 CustomNameTS::CustomNameTS() : BasicClientCommand(C_CUSTOMNAME_TS) {}
 
 void CustomNameTS::decodeData() {
@@ -1378,23 +1214,18 @@ void CustomNameTS::decodeData() {
 }
 
 void CustomNameTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     Logger::debug(LogFacility::Player) << *player << " names " << playerId << " as " << playerName << Log::end;
 
     player->namePlayer(playerId, playerName);
 }
 
-auto CustomNameTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<CustomNameTS>();
-    return cmd;
-}
-
 AttackPlayerTS::AttackPlayerTS() : BasicClientCommand(C_ATTACKPLAYER_TS) {}
 
 void AttackPlayerTS::decodeData() { enemyid = getIntFromBuffer(); }
 
 void AttackPlayerTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
 
     if (player->isAlive()) {
         player->ltAction->abortAction();
@@ -1421,11 +1252,6 @@ void AttackPlayerTS::performAction(Player *player) {
     }
 }
 
-auto AttackPlayerTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<AttackPlayerTS>();
-    return cmd;
-}
-
 LookAtMapItemTS::LookAtMapItemTS() : BasicClientCommand(C_LOOKATMAPITEM_TS, P_LOOK_COST) {}
 
 void LookAtMapItemTS::decodeData() {
@@ -1444,28 +1270,18 @@ void LookAtMapItemTS::performAction(Player *player) {
     }
 }
 
-auto LookAtMapItemTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<LookAtMapItemTS>();
-    return cmd;
-}
-
 PlayerSpinTS::PlayerSpinTS() : BasicClientCommand(C_PLAYERSPIN_TS, P_SPIN_COST) {}
 
 void PlayerSpinTS::decodeData() { dir = to_direction(getUnsignedCharFromBuffer()); }
 
 void PlayerSpinTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
     player->ltAction->abortAction();
     Logger::debug(LogFacility::World) << *player << " changes his dircetion to " << (int)dir << Log::end;
 
     player->turn(dir);
 }
 
-auto PlayerSpinTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<PlayerSpinTS>();
-    return cmd;
-}
-
 CharMoveTS::CharMoveTS() : BasicClientCommand(C_CHARMOVE_TS, P_MIN_AP) {}
 
 void CharMoveTS::decodeData() {
@@ -1475,7 +1291,7 @@ void CharMoveTS::decodeData() {
 }
 
 void CharMoveTS::performAction(Player *player) {
-    time(&(player->lastaction));
+    player->lastaction = TickClock::wallNow();
 
     if (charid == player->getId() && (mode == NORMALMOVE || mode == RUNNING)) {
         player->ltAction->abortAction();
@@ -1493,11 +1309,6 @@ void CharMoveTS::performAction(Player *player) {
     }
 }
 
-auto CharMoveTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<CharMoveTS>();
-    return cmd;
-}
-
 LoginCommandTS::LoginCommandTS() : BasicClientCommand(C_LOGIN_TS) {}
 
 void LoginCommandTS::decodeData() {
@@ -1508,11 +1319,6 @@ void LoginCommandTS::decodeData() {
 
 void LoginCommandTS::performAction(Player *player) { time(&(player->lastaction)); }
 
-auto LoginCommandTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<LoginCommandTS>();
-    return cmd;
-}
-
 auto LoginCommandTS::getClientVersion() const -> unsigned short { return clientVersion; }
 
 auto LoginCommandTS::getLoginName() const -> const std::string & { return loginName; }
@@ -1529,11 +1335,7 @@ void ScreenSizeCommandTS::decodeData() {
 void ScreenSizeCommandTS::performAction(Player *player) {
     player->screenwidth = width;
     player->screenheight = height;
+    World::get()->Observers.refresh(player);
     player->sendFullMap();
     player->sendCharacters();
 }
-
-auto ScreenSizeCommandTS::clone() -> ClientCommandPointer {
-    ClientCommandPointer cmd = std::make_shared<ScreenSizeCommandTS>();
-    return cmd;
-}
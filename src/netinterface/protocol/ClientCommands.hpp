@@ -69,7 +69,8 @@ enum clientcommands {
     C_MESSAGEDIALOG_TS = 0x51,
     C_MERCHANTDIALOG_TS = 0x52,
     C_SELECTIONDIALOG_TS = 0x53,
-    C_CRAFTINGDIALOG_TS = 0x54
+    C_CRAFTINGDIALOG_TS = 0x54,
+    C_COMPRESSION_TS = 0x0F
 };
 
 class InputDialogTS : public BasicClientCommand {
@@ -82,7 +83,6 @@ public:
     InputDialogTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class MessageDialogTS : public BasicClientCommand {
@@ -93,7 +93,6 @@ public:
     MessageDialogTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class MerchantDialogTS : public BasicClientCommand {
@@ -112,7 +111,6 @@ public:
     MerchantDialogTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class SelectionDialogTS : public BasicClientCommand {
@@ -125,7 +123,6 @@ public:
     SelectionDialogTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class CraftingDialogTS : public BasicClientCommand {
@@ -140,7 +137,6 @@ public:
     CraftingDialogTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class RequestAppearanceTS : public BasicClientCommand {
@@ -151,7 +147,6 @@ public:
     RequestAppearanceTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class LookAtCharacterTS : public BasicClientCommand {
@@ -163,7 +158,6 @@ public:
     LookAtCharacterTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class CastTS : public BasicClientCommand {
@@ -178,7 +172,6 @@ public:
     CastTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class UseTS : public BasicClientCommand {
@@ -192,7 +185,6 @@ public:
     UseTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class KeepAliveTS : public BasicClientCommand {
@@ -200,7 +192,18 @@ public:
     KeepAliveTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
+};
+
+// the client asks for large commands to be compressed from now on
+class CompressionTS : public BasicClientCommand {
+private:
+    static constexpr uint8_t deflateMode = 1;
+    uint8_t mode = 0;
+
+public:
+    CompressionTS();
+    void decodeData() override;
+    void performAction(Player *player) override;
 };
 
 class RequestSkillsTS : public BasicClientCommand {
@@ -208,7 +211,6 @@ public:
     RequestSkillsTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class AttackStopTS : public BasicClientCommand {
@@ -216,7 +218,6 @@ public:
     AttackStopTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class LookAtInventoryItemTS : public BasicClientCommand {
@@ -227,7 +228,6 @@ public:
     LookAtInventoryItemTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class LookAtShowCaseItemTS : public BasicClientCommand {
@@ -239,7 +239,6 @@ public:
     LookAtShowCaseItemTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class MoveItemFromPlayerToShowCaseTS : public BasicClientCommand {
@@ -253,7 +252,6 @@ public:
     MoveItemFromPlayerToShowCaseTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class MoveItemFromShowCaseToPlayerTS : public BasicClientCommand {
@@ -267,7 +265,6 @@ public:
     MoveItemFromShowCaseToPlayerTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class MoveItemInsideInventoryTS : public BasicClientCommand {
@@ -280,7 +277,6 @@ public:
     MoveItemInsideInventoryTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class DropItemFromInventoryOnMapTS : public BasicClientCommand {
@@ -293,7 +289,6 @@ public:
     DropItemFromInventoryOnMapTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class MoveItemFromMapToPlayerTS : public BasicClientCommand {
@@ -306,7 +301,6 @@ public:
     MoveItemFromMapToPlayerTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class MoveItemFromMapIntoShowCaseTS : public BasicClientCommand {
@@ -320,7 +314,6 @@ public:
     MoveItemFromMapIntoShowCaseTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class MoveItemFromMapToMapTS : public BasicClientCommand {
@@ -333,7 +326,6 @@ public:
     MoveItemFromMapToMapTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class MoveItemBetweenShowCasesTS : public BasicClientCommand {
@@ -348,7 +340,6 @@ public:
     MoveItemBetweenShowCasesTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class DropItemFromShowCaseOnMapTS : public BasicClientCommand {
@@ -362,7 +353,6 @@ public:
     DropItemFromShowCaseOnMapTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class CloseContainerInShowCaseTS : public BasicClientCommand {
@@ -373,7 +363,6 @@ public:
     CloseContainerInShowCaseTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class LookIntoShowCaseContainerTS : public BasicClientCommand {
@@ -384,7 +373,6 @@ public:
     LookIntoShowCaseContainerTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class LookIntoInventoryTS : public BasicClientCommand {
@@ -392,7 +380,6 @@ public:
     LookIntoInventoryTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class LookIntoContainerOnFieldTS : public BasicClientCommand {
@@ -403,7 +390,6 @@ public:
     LookIntoContainerOnFieldTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class PickUpItemTS : public BasicClientCommand {
@@ -414,7 +400,6 @@ public:
     PickUpItemTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class PickUpAllItemsTS : public BasicClientCommand {
@@ -422,7 +407,6 @@ public:
     PickUpAllItemsTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class LogOutTS : public BasicClientCommand {
@@ -430,7 +414,6 @@ public:
     LogOutTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class WhisperTS : public BasicClientCommand {
@@ -441,7 +424,6 @@ public:
     WhisperTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class ShoutTS : public BasicClientCommand {
@@ -452,7 +434,6 @@ public:
     ShoutTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class SayTS : public BasicClientCommand {
@@ -463,7 +444,6 @@ public:
     SayTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class RefreshTS : public BasicClientCommand {
@@ -471,7 +451,6 @@ public:
     RefreshTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class IntroduceTS : public BasicClientCommand {
@@ -479,7 +458,6 @@ public:
     IntroduceTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class CustomNameTS : public BasicClientCommand {
@@ -491,7 +469,6 @@ public:
     CustomNameTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class AttackPlayerTS : public BasicClientCommand {
@@ -502,7 +479,6 @@ public:
     AttackPlayerTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class LookAtMapItemTS : public BasicClientCommand {
@@ -514,7 +490,6 @@ public:
     LookAtMapItemTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class PlayerSpinTS : public BasicClientCommand {
@@ -525,7 +500,6 @@ public:
     PlayerSpinTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class CharMoveTS : public BasicClientCommand {
@@ -538,7 +512,6 @@ public:
     CharMoveTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 class LoginCommandTS : public BasicClientCommand {
@@ -551,7 +524,6 @@ public:
     LoginCommandTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 
     [[nodiscard]] auto getClientVersion() const -> unsigned short;
     [[nodiscard]] auto getLoginName() const -> const std::string &;
@@ -567,7 +539,6 @@ public:
     ScreenSizeCommandTS();
     void decodeData() override;
     void performAction(Player *player) override;
-    auto clone() -> ClientCommandPointer override;
 };
 
 #endif
@@ -35,7 +35,6 @@
 #include "netinterface/NetInterface.hpp"
 
 #include <limits>
-#include <range/v3/all.hpp>
 
 KeepAliveTC::KeepAliveTC() : BasicServerCommand(SC_KEEPALIVE_TC) {}
 
@@ -95,6 +94,14 @@ MessageDialogTC::MessageDialogTC(const MessageDialog &messageDialog, unsigned in
 
 MerchantDialogTC::MerchantDialogTC(const MerchantDialog &merchantDialog, unsigned int dialogId)
         : BasicServerCommand(SC_MERCHANTDIALOG_TC) {
+    auto &payload = merchantDialog.getPayload();
+
+    if (!payload.empty()) {
+        addBytesToBuffer(payload);
+        addIntToBuffer(static_cast<int>(dialogId));
+        return;
+    }
+
     addStringToBuffer(merchantDialog.getTitle());
     MerchantDialog::index_type size = merchantDialog.getOffersSize();
     addUnsignedCharToBuffer(size);
@@ -125,6 +132,7 @@ MerchantDialogTC::MerchantDialogTC(const MerchantDialog &merchantDialog, unsigne
         addIntToBuffer(it->getPrice());
     }
 
+    payload.assign(cmdData().begin() + headerSize, cmdData().begin() + getLength());
     addIntToBuffer(static_cast<int>(dialogId));
 }
 
@@ -145,6 +153,14 @@ SelectionDialogTC::SelectionDialogTC(const SelectionDialog &selectionDialog, uns
 
 CraftingDialogTC::CraftingDialogTC(const CraftingDialog &craftingDialog, unsigned int dialogId)
         : BasicServerCommand(SC_CRAFTINGDIALOG_TC) {
+    auto &payload = craftingDialog.getPayload();
+
+    if (!payload.empty()) {
+        addBytesToBuffer(payload);
+        addIntToBuffer(static_cast<int>(dialogId));
+        return;
+    }
+
     addStringToBuffer(craftingDialog.getTitle());
     CraftingDialog::index_t numberOfGroups = craftingDialog.getGroupsSize();
     addUnsignedCharToBuffer(numberOfGroups);
@@ -175,6 +191,7 @@ CraftingDialogTC::CraftingDialogTC(const CraftingDialog &craftingDialog, unsigne
         }
     }
 
+    payload.assign(cmdData().begin() + headerSize, cmdData().begin() + getLength());
     addIntToBuffer(static_cast<int>(dialogId));
 }
 
@@ -211,14 +228,11 @@ void addMovementCostToBuffer(BasicServerCommand *cmd, const position &pos) {
     }
 }
 
-ItemUpdate_TC::ItemUpdate_TC(const position &pos, const std::vector<Item> &items)
+ItemUpdate_TC::ItemUpdate_TC(const position &pos, const map::Field::ItemStack &items)
         : BasicServerCommand(SC_ITEMUPDATE_TC) {
     Logger::debug(LogFacility::World) << "sending new itemstack for pos " << pos << Log::end;
-    addShortIntToBuffer(pos.x);
-    addShortIntToBuffer(pos.y);
-    addShortIntToBuffer(pos.z);
     auto size = static_cast<uint8_t>(items.size());
-    addUnsignedCharToBuffer(size);
+    addFields(pos, size);
 
     for (const auto &item : items) {
         // we added MAXITEMS items
@@ -247,7 +261,7 @@ AppearanceTC::AppearanceTC(Character *cc, const Player *receivingPlayer) : Basic
     addIntToBuffer(cc->getId());
 
     if (cc->getType() == Character::player) {
-        auto *player = dynamic_cast<Player *>(cc);
+        auto *player = static_cast<Player *>(cc);
 
         height = Data::races().getRelativeSize(cc->getRace(), cc->getAttribute(Character::height));
 
@@ -259,7 +273,7 @@ AppearanceTC::AppearanceTC(Character *cc, const Player *receivingPlayer) : Basic
 
         addStringToBuffer(receivingPlayer->getCustomNameOf(player));
     } else if (cc->getType() == Character::monster) {
-        auto *monster = dynamic_cast<Monster *>(cc);
+        auto *monster = static_cast<Monster *>(cc);
 
         // monsters store height in percent already
         height = cc->getAttribute(Character::height);
@@ -290,9 +304,13 @@ AppearanceTC::AppearanceTC(Character *cc, const Player *receivingPlayer) : Basic
     addUnsignedCharToBuffer(deathflag);
 }
 
+CompressedTC::CompressedTC(const std::vector<char> &data)
+        : BasicServerCommand(SC_COMPRESSED_TC, static_cast<uint16_t>(data.size() + headerSize)) {
+    addBytesToBuffer(data);
+}
+
 AnimationTC::AnimationTC(TYPE_OF_CHARACTER_ID id, uint8_t animID) : BasicServerCommand(SC_ANIMATION_TC) {
-    addIntToBuffer(id);
-    addUnsignedCharToBuffer(animID);
+    addFields(static_cast<int32_t>(id), animID);
 }
 
 BookTC::BookTC(uint16_t bookID) : BasicServerCommand(SC_BOOK_TC) { addShortIntToBuffer(bookID); }
@@ -302,6 +320,7 @@ RemoveCharTC::RemoveCharTC(TYPE_OF_CHARACTER_ID id) : BasicServerCommand(SC_REMO
 UpdateTimeTC::UpdateTimeTC(unsigned char hour, unsigned char minute, unsigned char day, unsigned char month,
                            short int year)
         : BasicServerCommand(SC_UPDATETIME_TC) {
+    markSupersedeKey();
     addUnsignedCharToBuffer(hour);
     addUnsignedCharToBuffer(minute);
     addUnsignedCharToBuffer(day);
@@ -435,17 +454,11 @@ AdminViewPlayersTC::AdminViewPlayersTC() : BasicServerCommand(SC_ADMINVIEWPLAYER
 }
 
 SoundTC::SoundTC(const position &pos, unsigned short int id) : BasicServerCommand(SC_SOUND_TC) {
-    addShortIntToBuffer(pos.x);
-    addShortIntToBuffer(pos.y);
-    addShortIntToBuffer(pos.z);
-    addShortIntToBuffer(static_cast<short>(id));
+    addFields(pos, static_cast<int16_t>(id));
 }
 
 GraphicEffectTC::GraphicEffectTC(const position &pos, unsigned short int id) : BasicServerCommand(SC_GRAPHICEFFECT_TC) {
-    addShortIntToBuffer(pos.x);
-    addShortIntToBuffer(pos.y);
-    addShortIntToBuffer(pos.z);
-    addShortIntToBuffer(static_cast<short>(id));
+    addFields(pos, static_cast<int16_t>(id));
 }
 
 UpdateShowcaseTC::UpdateShowcaseTC(unsigned char showcase, const ItemLookAt &lookAt, TYPE_OF_CONTAINERSLOTS volume,
@@ -493,82 +506,88 @@ UpdateShowcaseSlotTC::UpdateShowcaseSlotTC(unsigned char showcase, TYPE_OF_CONTA
     }
 }
 
-MapStripeTC::MapStripeTC(const position &pos, NewClientView::stripedirection dir)
+MapStripeTC::MapStripeTC(const NewClientView::Stripe &stripe, const position &recipient, CommandEncoding encoding)
         : BasicServerCommand(SC_MAPSTRIPE_TC) {
-    addShortIntToBuffer(pos.x);
-    addShortIntToBuffer(pos.y);
-    addShortIntToBuffer(pos.z);
-    addUnsignedCharToBuffer(static_cast<unsigned char>(dir));
-    const auto &fields = World::get()->clientview.mapStripe;
-    const uint8_t numberOfTiles = World::get()->clientview.getMaxTiles();
-    addUnsignedCharToBuffer(numberOfTiles);
-
-    ranges::for_each(fields | ranges::view::take(numberOfTiles), [&](const auto &field) {
-        if (field != nullptr) {
-            addShortIntToBuffer(field->getTileCode());
-            addUnsignedCharToBuffer(field->getMovementCost());
-            addShortIntToBuffer(field->getMusicId());
-            addUnsignedCharToBuffer(static_cast<unsigned char>(field->itemCount()));
-
-            for (const auto &item : field->getItemStack()) {
-                addShortIntToBuffer(item.getId());
-
-                if (item.isContainer()) {
-                    addShortIntToBuffer(1);
-                } else {
-                    addShortIntToBuffer(item.getNumber());
-                }
-            }
-        } else {
-            addShortIntToBuffer(-1);
-            addUnsignedCharToBuffer(0);
-            addShortIntToBuffer(0);
-            addUnsignedCharToBuffer(0);
-        }
-    });
+    if (encoding == CommandEncoding::compact) {
+        addFields(schema::VarInt{static_cast<int32_t>(stripe.start.x - recipient.x)},
+                  schema::VarInt{static_cast<int32_t>(stripe.start.y - recipient.y)},
+                  schema::VarInt{static_cast<int32_t>(stripe.start.z - recipient.z)});
+    } else {
+        addFields(stripe.start);
+    }
+
+    addFields(static_cast<uint8_t>(stripe.dir));
+    addBytesToBuffer(stripe.payload);
 }
 
 MapCompleteTC::MapCompleteTC() : BasicServerCommand(SC_MAPCOMPLETE_TC) {}
 
 MoveAckTC::MoveAckTC(TYPE_OF_CHARACTER_ID id, const position &pos, unsigned char mode, TYPE_OF_WALKINGCOST duration)
         : BasicServerCommand(SC_MOVEACK_TC) {
-    addIntToBuffer(id);
-    addShortIntToBuffer(pos.x);
-    addShortIntToBuffer(pos.y);
-    addShortIntToBuffer(pos.z);
-    addUnsignedCharToBuffer(mode);
-    addShortIntToBuffer(static_cast<short>((duration / Character::actionPointUnit) * Character::actionPointUnit));
+    const auto roundedDuration = (duration / Character::actionPointUnit) * Character::actionPointUnit;
+    addFields(static_cast<int32_t>(id), pos, static_cast<uint8_t>(mode), static_cast<int16_t>(roundedDuration));
+}
+
+auto MultiMoveTC::fits(const position &origin, const position &pos) -> bool {
+    const auto fitsOffset = [](Coordinate offset) {
+        return offset >= std::numeric_limits<int8_t>::min() && offset <= std::numeric_limits<int8_t>::max();
+    };
+
+    return fitsOffset(pos.x - origin.x) && fitsOffset(pos.y - origin.y) && fitsOffset(pos.z - origin.z);
+}
+
+MultiMoveTC::MultiMoveTC(const position &origin, const std::vector<Move> &moves, CommandEncoding encoding)
+        : BasicServerCommand(SC_MULTIMOVE_TC) {
+    const bool compact = encoding == CommandEncoding::compact;
+
+    if (compact) {
+        // the recipient knows where it is
+        addFields(schema::VarUint{static_cast<uint32_t>(moves.size())});
+    } else {
+        addFields(origin, static_cast<uint16_t>(moves.size()));
+    }
+
+    TYPE_OF_CHARACTER_ID previousId = 0;
+
+    for (const auto &move : moves) {
+        const auto actionPoints = move.duration / Character::actionPointUnit;
+
+        if (compact) {
+            addFields(schema::VarInt{static_cast<int32_t>(move.id - previousId)});
+            previousId = move.id;
+        } else {
+            addFields(static_cast<int32_t>(move.id));
+        }
+
+        addFields(static_cast<int8_t>(move.pos.x - origin.x), static_cast<int8_t>(move.pos.y - origin.y),
+                  static_cast<int8_t>(move.pos.z - origin.z), static_cast<uint8_t>(move.mode));
+
+        if (compact) {
+            addFields(schema::VarUint{static_cast<uint32_t>(actionPoints)});
+        } else {
+            addFields(static_cast<int16_t>(actionPoints * Character::actionPointUnit));
+        }
+    }
 }
 
 IntroduceTC::IntroduceTC(TYPE_OF_CHARACTER_ID id, const std::string &name) : BasicServerCommand(SC_INTRODUCE_TC) {
-    addIntToBuffer(id);
-    addStringToBuffer(name);
+    addFields(static_cast<int32_t>(id), name);
 }
 
 ShoutTC::ShoutTC(const position &pos, const std::string &text) : BasicServerCommand(SC_SHOUT_TC) {
-    addShortIntToBuffer(pos.x);
-    addShortIntToBuffer(pos.y);
-    addShortIntToBuffer(pos.z);
-    addStringToBuffer(text);
+    addFields(pos, text);
 }
 
 WhisperTC::WhisperTC(const position &pos, const std::string &text) : BasicServerCommand(SC_WHISPER_TC) {
-    addShortIntToBuffer(pos.x);
-    addShortIntToBuffer(pos.y);
-    addShortIntToBuffer(pos.z);
-    addStringToBuffer(text);
+    addFields(pos, text);
 }
 
 SayTC::SayTC(const position &pos, const std::string &text) : BasicServerCommand(SC_SAY_TC) {
-    addShortIntToBuffer(pos.x);
-    addShortIntToBuffer(pos.y);
-    addShortIntToBuffer(pos.z);
-    addStringToBuffer(text);
+    addFields(pos, text);
 }
 
 InformTC::InformTC(Character::informType type, const std::string &text) : BasicServerCommand(SC_INFORM_TC) {
-    addUnsignedCharToBuffer(type);
-    addStringToBuffer(text);
+    addFields(static_cast<uint8_t>(type), text);
 }
 
 MusicTC::MusicTC(short int title) : BasicServerCommand(SC_MUSIC_TC) { addShortIntToBuffer(title); }
@@ -577,12 +596,13 @@ MusicDefaultTC::MusicDefaultTC() : BasicServerCommand(SC_MUSICDEFAULT_TC) {}
 
 UpdateAttribTC::UpdateAttribTC(TYPE_OF_CHARACTER_ID id, const std::string &name, unsigned short int value)
         : BasicServerCommand(SC_UPDATEATTRIB_TC) {
-    addIntToBuffer(id);
-    addStringToBuffer(name);
-    addShortIntToBuffer(static_cast<short>(value));
+    addFields(static_cast<int32_t>(id), name);
+    markSupersedeKey();
+    addFields(static_cast<int16_t>(value));
 }
 
 UpdateLoadTC::UpdateLoadTC(uint16_t currentLoad, uint16_t maxLoad) : BasicServerCommand(SC_UPDATELOAD_TC) {
+    markSupersedeKey();
     addShortIntToBuffer(currentLoad);
     addShortIntToBuffer(maxLoad);
 }
@@ -590,6 +610,7 @@ UpdateLoadTC::UpdateLoadTC(uint16_t currentLoad, uint16_t maxLoad) : BasicServer
 UpdateMagicFlagsTC::UpdateMagicFlagsTC(unsigned char type, uint32_t flags)
         : BasicServerCommand(SC_UPDATEMAGICFLAGS_TC) {
     addUnsignedCharToBuffer(type);
+    markSupersedeKey();
     addIntToBuffer(flags);
 }
 
@@ -599,11 +620,13 @@ ClearShowCaseTC::ClearShowCaseTC(unsigned char id) : BasicServerCommand(SC_CLEAR
 
 UpdateSkillTC::UpdateSkillTC(TYPE_OF_SKILL_ID skill, int major, int minor) : BasicServerCommand(SC_UPDATESKILL_TC) {
     addUnsignedCharToBuffer(skill);
+    markSupersedeKey();
     addShortIntToBuffer(static_cast<short>(major));
     addShortIntToBuffer(static_cast<short>(minor));
 }
 
 UpdateWeatherTC::UpdateWeatherTC(const WeatherStruct &weather) : BasicServerCommand(SC_UPDATEWEATHER_TC) {
+    markSupersedeKey();
     addUnsignedCharToBuffer(weather.cloud_density);
     addUnsignedCharToBuffer(weather.fog_density);
     addUnsignedCharToBuffer(weather.wind_dir);
@@ -630,6 +653,5 @@ SetCoordinateTC::SetCoordinateTC(const position &pos) : BasicServerCommand(SC_SE
 }
 
 PlayerSpinTC::PlayerSpinTC(unsigned char faceto, TYPE_OF_CHARACTER_ID id) : BasicServerCommand(SC_PLAYERSPIN_TC) {
-    addUnsignedCharToBuffer(faceto);
-    addIntToBuffer(id);
+    addFields(static_cast<uint8_t>(faceto), static_cast<int32_t>(id));
 }
@@ -24,6 +24,7 @@
 #include "Character.hpp"
 #include "Container.hpp"
 #include "NewClientView.hpp"
+#include "map/Field.hpp"
 #include "netinterface/BasicServerCommand.hpp"
 
 #include <vector>
@@ -76,6 +77,7 @@ enum ServerCommands {
     SC_UPDATETIME_TC = 0xB6,
     SC_APPEARANCE_TC = 0xE1,
     SC_REMOVECHAR_TC = 0xE2,
+    SC_MULTIMOVE_TC = 0xE3,
     SC_LOOKATCHARRESULT_TC = 0x18,
     SC_ITEMUPDATE_TC = 0x19,
     SC_INPUTDIALOG_TC = 0x50,
@@ -87,9 +89,14 @@ enum ServerCommands {
     SC_CLOSEDIALOG_TC = 0x5F,
     SC_QUESTPROGRESS_TC = 0x40,
     SC_ABORTQUEST_TC = 0x41,
-    SC_AVAILABLEQUESTS_TC = 0x42
+    SC_AVAILABLEQUESTS_TC = 0x42,
+    SC_COMPRESSED_TC = 0x20
 };
 
+// layout of the commands a recipient gets for itself alone; compact, see compact_protocol, writes positions relative
+// to the recipient and ids and counts as varints
+enum class CommandEncoding { standard, compact };
+
 class KeepAliveTC : public BasicServerCommand {
 public:
     KeepAliveTC();
@@ -160,7 +167,7 @@ public:
 
 class ItemUpdate_TC : public BasicServerCommand {
 public:
-    ItemUpdate_TC(const position &pos, const std::vector<Item> &items);
+    ItemUpdate_TC(const position &pos, const map::Field::ItemStack &items);
 };
 
 class CharDescription : public BasicServerCommand {
@@ -174,6 +181,12 @@ public:
     AppearanceTC(Character *cc, const Player *receivingPlayer);
 };
 
+// a command with header, deflated as part of the connection's compression stream
+class CompressedTC : public BasicServerCommand {
+public:
+    explicit CompressedTC(const std::vector<char> &data);
+};
+
 class AnimationTC : public BasicServerCommand {
 public:
     AnimationTC(TYPE_OF_CHARACTER_ID id, uint8_t animID);
@@ -285,7 +298,7 @@ public:
 
 class MapStripeTC : public BasicServerCommand {
 public:
-    MapStripeTC(const position &pos, NewClientView::stripedirection dir);
+    MapStripeTC(const NewClientView::Stripe &stripe, const position &recipient, CommandEncoding encoding);
 };
 
 class MapCompleteTC : public BasicServerCommand {
@@ -298,6 +311,22 @@ public:
     MoveAckTC(TYPE_OF_CHARACTER_ID id, const position &pos, unsigned char mode, TYPE_OF_WALKINGCOST duration);
 };
 
+// moves one player saw within a tick, each position relative to origin, see multi_move_updates
+class MultiMoveTC : public BasicServerCommand {
+public:
+    struct Move {
+        TYPE_OF_CHARACTER_ID id;
+        position pos;
+        unsigned char mode;
+        TYPE_OF_WALKINGCOST duration;
+    };
+
+    // whether pos is close enough to origin for the encoding
+    static auto fits(const position &origin, const position &pos) -> bool;
+    // compact encodes each id as the difference to the one before, so moves should be sorted by id
+    MultiMoveTC(const position &origin, const std::vector<Move> &moves, CommandEncoding encoding);
+};
+
 class IntroduceTC : public BasicServerCommand {
 public:
     IntroduceTC(TYPE_OF_CHARACTER_ID id, const std::string &name);
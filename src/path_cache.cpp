@@ -0,0 +1,158 @@
+/*
+ * Illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of Illarionserver.
+ *
+ * Illarionserver  is  free  software:  you can redistribute it and/or modify it
+ * under the terms of the  GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Illarionserver is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY;  without  even  the  implied  warranty  of  MERCHANTABILITY  or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "path_cache.hpp"
+
+#include "hpa_star.hpp"
+#include "map/ChunkVersions.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace pathfinding {
+
+namespace {
+
+using map::ChunkVersions;
+
+constexpr size_t maxCachedPaths = 4096;
+
+struct PathKey {
+    ::position start;
+    ::position goal;
+
+    auto operator==(const PathKey &other) const -> bool { return start == other.start && goal == other.goal; }
+};
+
+struct PathKeyHash {
+    auto operator()(const PathKey &key) const -> size_t {
+        size_t seed = hash_value(key.start);
+        boost::hash_combine(seed, hash_value(key.goal));
+        return seed;
+    }
+};
+
+struct CachedPath {
+    PathKey key;
+    std::list<direction> steps;
+    // versions of the chunks the steps cross when the path was found
+    std::vector<std::pair<ChunkVersions::ChunkKey, ChunkVersions::Version>> chunks;
+};
+
+// most recently used first
+using Paths = std::list<CachedPath>;
+
+struct PathCache {
+    Paths paths;
+    std::unordered_map<PathKey, Paths::iterator, PathKeyHash> index;
+
+    void erase(const PathKey &key) {
+        if (const auto entry = index.find(key); entry != index.end()) {
+            paths.erase(entry->second);
+            index.erase(entry);
+        }
+    }
+};
+
+auto cache() -> PathCache & {
+    static PathCache instance;
+    return instance;
+}
+
+auto isCurrent(const CachedPath &path) -> bool {
+    const auto &versions = ChunkVersions::get();
+    return std::all_of(path.chunks.begin(), path.chunks.end(),
+                       [&versions](const auto &chunk) { return versions.of(chunk.first) == chunk.second; });
+}
+
+auto chunksOf(const ::position &start, const std::list<direction> &steps)
+        -> std::vector<std::pair<ChunkVersions::ChunkKey, ChunkVersions::Version>> {
+    const auto &versions = ChunkVersions::get();
+    std::vector<std::pair<ChunkVersions::ChunkKey, ChunkVersions::Version>> chunks;
+    auto pos = start;
+    const auto add = [&chunks, &versions](const ::position &pos) {
+        const auto chunk = ChunkVersions::chunkKey(pos);
+
+        if (std::none_of(chunks.begin(), chunks.end(), [chunk](const auto &known) { return known.first == chunk; })) {
+            chunks.emplace_back(chunk, versions.of(chunk));
+        }
+    };
+
+    add(pos);
+
+    for (const auto step : steps) {
+        pos.move(step);
+        add(pos);
+    }
+
+    return chunks;
+}
+
+} // namespace
+
+auto lookup_path(const ::position &start_pos, const ::position &goal_pos, std::list<direction> &steps) -> bool {
+    auto &cache = pathfinding::cache();
+    const PathKey key{start_pos, goal_pos};
+
+    if (const auto entry = cache.index.find(key); entry != cache.index.end()) {
+        if (isCurrent(*entry->second)) {
+            cache.paths.splice(cache.paths.begin(), cache.paths, entry->second);
+            steps = entry->second->steps;
+            return true;
+        }
+
+        cache.erase(key);
+    }
+
+    return false;
+}
+
+void remember_path(const ::position &start_pos, const ::position &goal_pos, const std::list<direction> &steps) {
+    auto &cache = pathfinding::cache();
+    const PathKey key{start_pos, goal_pos};
+    cache.erase(key);
+    cache.paths.push_front({key, steps, chunksOf(start_pos, steps)});
+    cache.index.emplace(key, cache.paths.begin());
+
+    if (cache.paths.size() > maxCachedPaths) {
+        cache.index.erase(cache.paths.back().key);
+        cache.paths.pop_back();
+    }
+}
+
+auto cached_path(const ::position &start_pos, const ::position &goal_pos, std::list<direction> &steps) -> bool {
+    if (lookup_path(start_pos, goal_pos, steps)) {
+        return true;
+    }
+
+    if (!hpa_star(start_pos, goal_pos, steps)) {
+        return false;
+    }
+
+    remember_path(start_pos, goal_pos, steps);
+    return true;
+}
+
+void forget_path(const ::position &start_pos, const ::position &goal_pos) { cache().erase({start_pos, goal_pos}); }
+
+} // namespace pathfinding
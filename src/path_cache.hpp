@@ -0,0 +1,42 @@
+/*
+ * Illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of Illarionserver.
+ *
+ * Illarionserver  is  free  software:  you can redistribute it and/or modify it
+ * under the terms of the  GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Illarionserver is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY;  without  even  the  implied  warranty  of  MERCHANTABILITY  or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PATH_CACHE_HPP
+#define PATH_CACHE_HPP
+
+#include "globals.hpp"
+#include "types.hpp"
+
+#include <list>
+
+namespace pathfinding {
+
+// hpa_star with the results kept until a chunk the steps cross changes, least recently used ones are dropped first;
+// game thread only
+auto cached_path(const ::position &start_pos, const ::position &goal_pos, std::list<direction> &steps) -> bool;
+// only the cache part of cached_path, for results found elsewhere
+auto lookup_path(const ::position &start_pos, const ::position &goal_pos, std::list<direction> &steps) -> bool;
+void remember_path(const ::position &start_pos, const ::position &goal_pos, const std::list<direction> &steps);
+// drops a cached result, e.g. after its steps turned out to be blocked by characters, which the cache cannot see
+void forget_path(const ::position &start_pos, const ::position &goal_pos);
+
+} // namespace pathfinding
+
+#endif
@@ -0,0 +1,171 @@
+/*
+ * Illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of Illarionserver.
+ *
+ * Illarionserver  is  free  software:  you can redistribute it and/or modify it
+ * under the terms of the  GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Illarionserver is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY;  without  even  the  implied  warranty  of  MERCHANTABILITY  or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "path_service.hpp"
+
+#include "Config.hpp"
+#include "ThreadAffinity.hpp"
+#include "World.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace pathfinding {
+
+namespace {
+
+// like the window a_star searches in
+constexpr auto snapshotMargin = 16;
+
+} // namespace
+
+auto PathService::get() -> PathService & {
+    static PathService instance;
+    return instance;
+}
+
+PathService::~PathService() { stop(); }
+
+auto PathService::isEnabled() -> bool { return Config::instance().pathfinding_threads() > 0; }
+
+void PathService::request(const ::position &start, const ::position &goal, Callback callback) {
+    Search search{start, goal, {}, std::move(callback)};
+
+    if (start.z == goal.z) {
+        constexpr int chunkBits = map::ChunkVersions::chunkBits;
+        const int left = (std::min(start.x, goal.x) - snapshotMargin) >> chunkBits;
+        const int right = (std::max(start.x, goal.x) + snapshotMargin) >> chunkBits;
+        const int top = (std::min(start.y, goal.y) - snapshotMargin) >> chunkBits;
+        const int bottom = (std::max(start.y, goal.y) + snapshotMargin) >> chunkBits;
+
+        for (int y = top; y <= bottom; ++y) {
+            for (int x = left; x <= right; ++x) {
+                const ::position origin(Coordinate(x << chunkBits), Coordinate(y << chunkBits), start.z);
+                const auto key = map::ChunkVersions::chunkKey(origin);
+                search.chunks.emplace(key, chunkAt(key, origin));
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back(std::move(search));
+    startWorkers();
+    wakeWorkers.notify_one();
+}
+
+auto PathService::chunkAt(map::ChunkVersions::ChunkKey key, const ::position &origin)
+        -> std::shared_ptr<const Chunk> {
+    const auto version = map::ChunkVersions::get().of(key);
+
+    if (const auto cached = chunkCache.find(key); cached != chunkCache.end() && cached->second->version == version) {
+        return cached->second;
+    }
+
+    auto chunk = WorldView::current()->chunkAt(key);
+
+    if (chunk == nullptr || chunk->version != version) {
+        chunk = WorldView::copyChunk(*World::get(), origin, version);
+    }
+
+    if (chunkCache.size() >= maxCachedChunks) {
+        chunkCache.clear();
+    }
+
+    chunkCache.insert_or_assign(key, chunk);
+    return chunk;
+}
+
+void PathService::deliver() {
+    std::deque<Search> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done.swap(finished);
+    }
+
+    for (auto &search : done) {
+        search.callback(search.found, search.steps);
+    }
+}
+
+void PathService::startWorkers() {
+    if (!workers.empty()) {
+        return;
+    }
+
+    stopping = false;
+    const auto workerCount = std::max<uint16_t>(Config::instance().pathfinding_threads(), 1);
+
+    for (uint16_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back([this] { runWorker(); });
+    }
+}
+
+void PathService::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    wakeWorkers.notify_all();
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    workers.clear();
+}
+
+void PathService::runWorker() {
+    affinity::pinCurrentThread(Config::instance().worker_thread_cores(), "worker");
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+        wakeWorkers.wait(lock, [this] { return stopping || !pending.empty(); });
+
+        if (stopping) {
+            return;
+        }
+
+        auto current = std::move(pending.front());
+        pending.pop_front();
+        lock.unlock();
+        search(current);
+        lock.lock();
+        finished.push_back(std::move(current));
+    }
+}
+
+void PathService::search(Search &search) {
+    const auto &chunks = search.chunks;
+    search.found = a_star(search.start, search.goal, search.steps, [&chunks](const ::position &pos) -> Terrain {
+        constexpr int chunkBits = map::ChunkVersions::chunkBits;
+        const auto chunk = chunks.find(map::ChunkVersions::chunkKey(pos));
+
+        if (chunk == chunks.end()) {
+            return {};
+        }
+
+        const int x = pos.x - ((pos.x >> chunkBits) << chunkBits);
+        const int y = pos.y - ((pos.y >> chunkBits) << chunkBits);
+        return chunk->second->terrain[y * chunkSize + x];
+    });
+}
+
+} // namespace pathfinding
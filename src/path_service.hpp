@@ -0,0 +1,103 @@
+/*
+ * Illarionserver - server for the game Illarion
+ * Copyright 2011 Illarion e.V.
+ *
+ * This file is part of Illarionserver.
+ *
+ * Illarionserver  is  free  software:  you can redistribute it and/or modify it
+ * under the terms of the  GNU Affero General Public License as published by the Free
+ * Software Foundation, either version 3 of the License, or (at your option) any
+ * later version.
+ *
+ * Illarionserver is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY;  without  even  the  implied  warranty  of  MERCHANTABILITY  or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU Affero General Public License along with
+ * Illarionserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PATH_SERVICE_HPP
+#define PATH_SERVICE_HPP
+
+#include "WorldView.hpp"
+#include "a_star.hpp"
+#include "globals.hpp"
+#include "map/ChunkVersions.hpp"
+#include "types.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace pathfinding {
+
+/* Searches paths on pathfinding_threads workers, so bursts of searches do not stretch the tick. Workers only see
+ * copies of the chunks around start and goal, taken when the search is requested and shared by later searches while
+ * the chunks stay unchanged, and with the chunks of the world view if it has them. Other characters are not part of
+ * these copies, steps into them fail when walked.
+ */
+class PathService {
+public:
+    using Callback = std::function<void(bool found, const std::list<direction> &steps)>;
+
+    static auto get() -> PathService &;
+
+    PathService(const PathService &) = delete;
+    auto operator=(const PathService &) -> PathService & = delete;
+    PathService(PathService &&) = delete;
+    auto operator=(PathService &&) -> PathService & = delete;
+    ~PathService();
+
+    // whether there are workers at all, otherwise searches belong on the game thread
+    [[nodiscard]] static auto isEnabled() -> bool;
+    // game thread only, the callback runs in a later deliver; goals should be close, see route_target
+    void request(const ::position &start, const ::position &goal, Callback callback);
+    // runs the callbacks of finished searches, game thread only
+    void deliver();
+    void stop();
+
+private:
+    static constexpr int chunkSize = WorldView::chunkSize;
+    static constexpr size_t maxCachedChunks = 8192;
+
+    using Chunk = WorldView::Chunk;
+
+    using Chunks = std::unordered_map<map::ChunkVersions::ChunkKey, std::shared_ptr<const Chunk>>;
+
+    struct Search {
+        ::position start;
+        ::position goal;
+        Chunks chunks;
+        Callback callback;
+        bool found = false;
+        std::list<direction> steps;
+    };
+
+    std::mutex mutex;
+    std::condition_variable wakeWorkers;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+    std::deque<Search> pending;
+    std::deque<Search> finished;
+    // game thread only
+    Chunks chunkCache;
+
+    PathService() = default;
+
+    void startWorkers();
+    void runWorker();
+    auto chunkAt(map::ChunkVersions::ChunkKey key, const ::position &origin) -> std::shared_ptr<const Chunk>;
+    static void search(Search &search);
+};
+
+} // namespace pathfinding
+
+#endif
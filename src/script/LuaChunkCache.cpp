@@ -0,0 +1,308 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "script/LuaChunkCache.hpp"
+
+extern "C" {
+#include <lauxlib.h>
+}
+
+#include "Config.hpp"
+#include "Logger.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+constexpr uint64_t fnvOffset = 14695981039346656037ULL;
+constexpr uint64_t fnvPrime = 1099511628211ULL;
+
+auto fnv1a(uint64_t hash, const std::string &data) -> uint64_t {
+    for (const unsigned char c : data) {
+        hash ^= c;
+        hash *= fnvPrime;
+    }
+
+    return hash;
+}
+
+auto readFile(const std::string &file, std::string &content) -> bool {
+    std::ifstream stream(file, std::ios::binary);
+
+    if (!stream) {
+        return false;
+    }
+
+    std::ostringstream buffer;
+    buffer << stream.rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+// empty if compiled chunks are kept in memory only
+auto cacheFileOf(uint64_t hash) -> std::string {
+    const std::string directory = Config::instance().lua_bytecode_cache();
+
+    if (directory.empty()) {
+        return {};
+    }
+
+    std::ostringstream name;
+    name << directory << '/' << std::hex << std::setw(16) << std::setfill('0') << hash << ".luac";
+    return name.str();
+}
+
+auto readCompiled(uint64_t hash, std::string &chunk) -> bool {
+    const auto file = cacheFileOf(hash);
+    return !file.empty() && readFile(file, chunk);
+}
+
+auto appendChunk(lua_State * /*state*/, const void *data, size_t size, void *chunk) -> int {
+    static_cast<std::string *>(chunk)->append(static_cast<const char *>(data), size);
+    return 0;
+}
+
+} // namespace
+
+auto LuaChunkCache::get() -> LuaChunkCache & {
+    static LuaChunkCache instance;
+    return instance;
+}
+
+void LuaChunkCache::prefetch(const std::string &directory) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> files;
+    std::error_code error;
+
+    for (fs::recursive_directory_iterator it(directory, fs::directory_options::skip_permission_denied, error), end;
+         !error && it != end; it.increment(error)) {
+        if (it->path().extension() == ".lua" && it->is_regular_file(error)) {
+            files.push_back(it->path().string());
+        }
+    }
+
+    std::vector<Source> sources(files.size());
+    std::vector<std::string> compiled(files.size());
+    std::vector<char> found(files.size(), 0);
+
+    runInParallel(files.size(), [&](size_t index) {
+        found[index] = read(files[index], sources[index]) ? 1 : 0;
+
+        if (found[index] != 0) {
+            const auto known = chunks.find(files[index]);
+
+            if (known == chunks.end() || known->second.hash != sources[index].hash) {
+                readCompiled(sources[index].hash, compiled[index]);
+            }
+        }
+    });
+
+    for (size_t index = 0; index < files.size(); ++index) {
+        if (found[index] == 0) {
+            continue;
+        }
+
+        if (!compiled[index].empty()) {
+            chunks[files[index]] = {sources[index].hash, std::move(compiled[index]), {}};
+        }
+
+        prefetched[files[index]] = std::move(sources[index]);
+    }
+}
+
+void LuaChunkCache::dropPrefetched() { prefetched.clear(); }
+
+auto LuaChunkCache::load(lua_State *state, const std::string &file) -> int {
+    Source unprefetched;
+    const Source *source = &unprefetched;
+
+    if (const auto it = prefetched.find(file); it != prefetched.end()) {
+        source = &it->second;
+    } else if (!read(file, unprefetched)) {
+        lua_pushfstring(state, "cannot open %s", file.c_str());
+        return LUA_ERRFILE;
+    }
+
+    const auto chunkname = "@" + file;
+
+    if (loadCompiled(state, file, source->hash, chunkname)) {
+        chunks[file].modified = source->modified;
+        return LUA_OK;
+    }
+
+    const int result = luaL_loadbuffer(state, source->text.data(), source->text.size(), chunkname.c_str());
+
+    if (result == LUA_OK) {
+        std::string chunk;
+
+        if (lua_dump(state, appendChunk, &chunk) == 0) {
+            store(file, source->hash, std::move(chunk));
+            chunks[file].modified = source->modified;
+        }
+    }
+
+    return result;
+}
+
+auto LuaChunkCache::changedModules(const std::string &scriptDirectory) -> std::unordered_set<std::string> {
+    static const std::string extension = ".lua";
+    std::unordered_set<std::string> modules;
+
+    for (auto &[file, compiled] : chunks) {
+        std::error_code error;
+        const auto modified = std::filesystem::last_write_time(file, error);
+
+        if (error || modified == compiled.modified) {
+            continue;
+        }
+
+        Source source;
+
+        // a deleted file keeps its last version loaded
+        if (!read(file, source)) {
+            continue;
+        }
+
+        compiled.modified = source.modified;
+
+        const bool inDirectory = file.size() > scriptDirectory.size() + extension.size() &&
+                                 file.compare(0, scriptDirectory.size(), scriptDirectory) == 0 &&
+                                 file.compare(file.size() - extension.size(), extension.size(), extension) == 0;
+
+        if (source.hash != compiled.hash && inDirectory) {
+            auto module = file.substr(scriptDirectory.size(), file.size() - scriptDirectory.size() - extension.size());
+            std::replace(module.begin(), module.end(), '/', '.');
+            modules.insert(std::move(module));
+        }
+    }
+
+    return modules;
+}
+
+void LuaChunkCache::installSearcher(lua_State *state) {
+    lua_getglobal(state, "package");
+    lua_getfield(state, -1, "searchers");
+
+    // behind the searcher for preloaded modules, ahead of the one reading package.path
+    for (auto index = static_cast<int>(lua_rawlen(state, -1)); index >= 2; --index) {
+        lua_rawgeti(state, -1, index);
+        lua_rawseti(state, -2, index + 1);
+    }
+
+    lua_pushcfunction(state, search);
+    lua_rawseti(state, -2, 2);
+    lua_pop(state, 2);
+}
+
+auto LuaChunkCache::read(const std::string &file, Source &source) -> bool {
+    // taken before reading, so a change during the read shows up in the next check
+    std::error_code error;
+    source.modified = std::filesystem::last_write_time(file, error);
+
+    if (!readFile(file, source.text)) {
+        return false;
+    }
+
+    // like luaL_loadfile, a first line starting with # is skipped but still counts for line numbers
+    if (!source.text.empty() && source.text.front() == '#') {
+        source.text.erase(0, source.text.find('\n'));
+    }
+
+    source.hash = fnv1a(fnv1a(fnvOffset, file + '\0'), source.text);
+    return true;
+}
+
+auto LuaChunkCache::loadCompiled(lua_State *state, const std::string &file, uint64_t hash,
+                                 const std::string &chunkname) -> bool {
+    auto it = chunks.find(file);
+
+    if (it == chunks.end() || it->second.hash != hash) {
+        std::string chunk;
+
+        if (!readCompiled(hash, chunk)) {
+            return false;
+        }
+
+        it = chunks.insert_or_assign(file, Compiled{hash, std::move(chunk), {}}).first;
+    }
+
+    if (luaL_loadbuffer(state, it->second.chunk.data(), it->second.chunk.size(), chunkname.c_str()) == LUA_OK) {
+        return true;
+    }
+
+    // compiled by another Lua version or damaged, the source is compiled again
+    lua_pop(state, 1);
+    chunks.erase(it);
+    return false;
+}
+
+void LuaChunkCache::store(const std::string &file, uint64_t hash, std::string &&chunk) {
+    const auto &compiled = chunks.insert_or_assign(file, Compiled{hash, std::move(chunk), {}}).first->second;
+    const auto cacheFile = cacheFileOf(hash);
+
+    if (cacheFile.empty()) {
+        return;
+    }
+
+    // written aside and renamed, so a crash never leaves a truncated chunk behind
+    const auto temporary = cacheFile + ".tmp";
+    std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+    stream.write(compiled.chunk.data(), static_cast<std::streamsize>(compiled.chunk.size()));
+    stream.close();
+    std::error_code error;
+
+    if (stream) {
+        std::filesystem::rename(temporary, cacheFile, error);
+    }
+
+    if (!stream || error) {
+        Logger::warn(LogFacility::Script) << "could not write compiled script " << cacheFile << Log::end;
+    }
+}
+
+auto LuaChunkCache::search(lua_State *state) -> int {
+    {
+        std::string name = luaL_checkstring(state, 1);
+        std::replace(name.begin(), name.end(), '.', '/');
+        const auto file = Config::instance().scriptdir() + name + ".lua";
+        const int result = get().load(state, file);
+
+        if (result == LUA_OK) {
+            lua_pushstring(state, file.c_str());
+            return 2;
+        }
+
+        if (result == LUA_ERRFILE) {
+            lua_pop(state, 1);
+            lua_pushfstring(state, "\n\tno file '%s'", file.c_str());
+            return 1;
+        }
+
+        lua_pushfstring(state, "error loading module '%s' from file '%s':\n\t%s", lua_tostring(state, 1),
+                        file.c_str(), lua_tostring(state, -1));
+    }
+
+    // raised outside the scope above, the error jumps past destructors
+    return lua_error(state);
+}
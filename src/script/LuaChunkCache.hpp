@@ -0,0 +1,75 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LUA_CHUNK_CACHE_HPP
+#define LUA_CHUNK_CACHE_HPP
+
+extern "C" {
+#include <lua.h>
+}
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+// Compiled Lua chunks by hash of file name and source, so unchanged scripts are not parsed again on reloads or,
+// with lua_bytecode_cache set, on restarts. Loading happens on the game thread only, prefetching uses all cores.
+class LuaChunkCache {
+public:
+    static auto get() -> LuaChunkCache &;
+
+    // reads and hashes all scripts below the directory in parallel, ahead of loading them one by one
+    void prefetch(const std::string &directory);
+    void dropPrefetched();
+
+    // like luaL_loadfile, leaves the chunk or an error message on the stack
+    auto load(lua_State *state, const std::string &file) -> int;
+
+    // modules loaded from below the script directory whose file changed since, as in require("item.id_9_sword");
+    // files are only read again if their modification time changed
+    auto changedModules(const std::string &scriptDirectory) -> std::unordered_set<std::string>;
+
+    // lets require find script modules through the cache as well
+    static void installSearcher(lua_State *state);
+
+private:
+    struct Source {
+        std::string text;
+        uint64_t hash = 0;
+        std::filesystem::file_time_type modified;
+    };
+
+    struct Compiled {
+        uint64_t hash = 0;
+        std::string chunk;
+        std::filesystem::file_time_type modified;
+    };
+
+    static auto read(const std::string &file, Source &source) -> bool;
+    auto loadCompiled(lua_State *state, const std::string &file, uint64_t hash, const std::string &chunkname) -> bool;
+    void store(const std::string &file, uint64_t hash, std::string &&chunk);
+    static auto search(lua_State *state) -> int;
+
+    std::unordered_map<std::string, Source> prefetched;
+    // latest chunk of each file, on disk chunks are kept by hash and outlive changes made in between
+    std::unordered_map<std::string, Compiled> chunks;
+};
+
+#endif
@@ -0,0 +1,113 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "script/LuaCollector.hpp"
+
+#include "Config.hpp"
+#include "Logger.hpp"
+#include "tuningConstants.hpp"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+auto LuaCollector::get() -> LuaCollector & {
+    static LuaCollector instance;
+    return instance;
+}
+
+void LuaCollector::configure(lua_State *state) {
+    const std::string mode = Config::instance().lua_gc_mode();
+
+    if (mode == "generational") {
+#if LUA_VERSION_NUM == 502
+        lua_gc(state, LUA_GCGEN, 0);
+        return;
+#elif LUA_VERSION_NUM >= 504
+        lua_gc(state, LUA_GCGEN, 0, 0);
+        return;
+#else
+        Logger::warn(LogFacility::Script) << "Lua " << LUA_VERSION_NUM
+                                          << " has no generational collector, using incremental collection"
+                                          << Log::end;
+#endif
+    } else if (mode != "incremental") {
+        Logger::warn(LogFacility::Script) << "unknown lua_gc_mode " << mode << ", using incremental collection"
+                                          << Log::end;
+    }
+
+    const int pause = Config::instance().lua_gc_pause;
+    const int stepmul = Config::instance().lua_gc_stepmul;
+#if LUA_VERSION_NUM >= 504
+    lua_gc(state, LUA_GCINC, pause, stepmul, 0);
+#else
+#if LUA_VERSION_NUM == 502
+    lua_gc(state, LUA_GCINC, 0);
+#endif
+    lua_gc(state, LUA_GCSETPAUSE, pause);
+    lua_gc(state, LUA_GCSETSTEPMUL, stepmul);
+#endif
+}
+
+void LuaCollector::step(lua_State *state, std::chrono::nanoseconds idle) {
+    // the other half stays as slack, so the next task does not start late
+    const auto budget = std::min<std::chrono::nanoseconds>(idle / 2, maxIdleCollection);
+
+    if (state == nullptr || budget <= std::chrono::nanoseconds::zero()) {
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + budget;
+    auto now = start;
+
+    while (now < deadline) {
+        const bool cycleComplete = lua_gc(state, LUA_GCSTEP, stepKilobytes) != 0;
+        now = std::chrono::steady_clock::now();
+
+        // starting the next cycle right away would only collect what was just left behind
+        if (cycleComplete) {
+            ++cycles;
+            break;
+        }
+    }
+
+    const auto time = now - start;
+    stepTime += time;
+    totalStepTime += time;
+    maxStep = std::max(maxStep, time);
+}
+
+auto LuaCollector::takeStepTime() -> std::chrono::nanoseconds { return std::exchange(stepTime, {}); }
+
+auto LuaCollector::heapKilobytes(lua_State *state) -> uint32_t {
+    return state == nullptr ? 0 : static_cast<uint32_t>(lua_gc(state, LUA_GCCOUNT, 0));
+}
+
+void LuaCollector::dump(lua_State *state) {
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    Logger::info(LogFacility::Script) << "lua heap " << heapKilobytes(state) << " kB, "
+                                      << duration_cast<microseconds>(totalStepTime).count()
+                                      << " us collecting while idle, " << duration_cast<microseconds>(maxStep).count()
+                                      << " us longest step, " << cycles << " cycles completed" << Log::end;
+    totalStepTime = {};
+    maxStep = {};
+    cycles = 0;
+}
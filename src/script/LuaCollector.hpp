@@ -0,0 +1,56 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LUA_COLLECTOR_HPP
+#define LUA_COLLECTOR_HPP
+
+extern "C" {
+#include <lua.h>
+}
+
+#include <chrono>
+#include <cstdint>
+
+// Steers the garbage collector of the Lua state. Collection work is done in steps while the game loop waits for its
+// next task, so the allocator rarely has to finish a long cycle in the middle of a tick.
+class LuaCollector {
+public:
+    // Lua heap collected per step, small enough to check the time often
+    static constexpr int stepKilobytes = 16;
+
+    static auto get() -> LuaCollector &;
+
+    // applies the configured mode and parameters, needed for every new Lua state
+    static void configure(lua_State *state);
+
+    // steps until the current cycle is complete or about half the idle time is used up
+    void step(lua_State *state, std::chrono::nanoseconds idle);
+    // time spent stepping since the last call
+    auto takeStepTime() -> std::chrono::nanoseconds;
+    [[nodiscard]] static auto heapKilobytes(lua_State *state) -> uint32_t;
+
+    void dump(lua_State *state);
+
+private:
+    std::chrono::nanoseconds stepTime{0};
+    std::chrono::nanoseconds totalStepTime{0};
+    std::chrono::nanoseconds maxStep{0};
+    uint64_t cycles = 0;
+};
+
+#endif
@@ -0,0 +1,217 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "script/LuaCoroutines.hpp"
+
+extern "C" {
+#include <lauxlib.h>
+}
+
+#include "Logger.hpp"
+#include "World.hpp"
+#include "script/LuaScript.hpp"
+#include "script/LuaWatchdog.hpp"
+
+#include <utility>
+
+auto LuaCoroutines::get() -> LuaCoroutines & {
+    static LuaCoroutines instance;
+    return instance;
+}
+
+auto LuaCoroutines::start(const luabind::object &function, const std::vector<luabind::object> &args,
+                          LuaProfiler::Entry &profile) -> Id {
+    auto *state = LuaScript::getLuaState();
+    auto *thread = lua_newthread(state);
+    const auto ref = luaL_ref(state, LUA_REGISTRYINDEX);
+
+    function.push(thread);
+
+    for (const auto &arg : args) {
+        arg.push(thread);
+    }
+
+    const auto id = nextId++;
+    coroutines.emplace(id, Coroutine{thread, ref, &profile});
+    resume(id, static_cast<int>(args.size()));
+
+    return isAlive(id) ? id : 0;
+}
+
+auto LuaCoroutines::isAlive(Id id) const -> bool { return coroutines.find(id) != coroutines.end(); }
+
+auto LuaCoroutines::notify(const std::string &event, const luabind::object &value) -> size_t {
+    const auto it = waiting.find(event);
+
+    if (it == waiting.end()) {
+        return 0;
+    }
+
+    const auto ids = std::move(it->second);
+    waiting.erase(it);
+
+    for (const auto id : ids) {
+        const auto coroutine = coroutines.find(id);
+
+        if (coroutine != coroutines.end()) {
+            value.push(coroutine->second.thread);
+            resume(id, 1);
+        }
+    }
+
+    return ids.size();
+}
+
+void LuaCoroutines::clear() {
+    for (const auto &[id, coroutine] : coroutines) {
+        World::get()->scheduler.cancel(coroutine.wakeup);
+    }
+
+    coroutines.clear();
+    waiting.clear();
+}
+
+void LuaCoroutines::registerFunctions(lua_State *state) {
+    lua_register(state, "async", &LuaCoroutines::luaAsync);
+    lua_register(state, "wait", &LuaCoroutines::luaWait);
+    lua_register(state, "waitFor", &LuaCoroutines::luaWaitFor);
+    lua_register(state, "notify", &LuaCoroutines::luaNotify);
+}
+
+void LuaCoroutines::resume(Id id, int arguments) {
+    const auto it = coroutines.find(id);
+
+    if (it == coroutines.end()) {
+        return;
+    }
+
+    const auto coroutine = it->second;
+    auto *previous = std::exchange(running, coroutine.thread);
+    int status = LUA_OK;
+
+    {
+        const LuaProfiler::Measurement measurement(*coroutine.profile);
+        const LuaWatchdog::Call call(*coroutine.profile, slice);
+        status = lua_resume(coroutine.thread, nullptr, arguments);
+    }
+
+    running = previous;
+    // reset right away, so that a coroutine continuing after resuming this one is not mistaken for waiting
+    const auto reason = std::exchange(suspension, Suspension::preempted);
+
+    // the coroutine may have started others, moving it in the map
+    const auto resumed = coroutines.find(id);
+
+    if (resumed == coroutines.end()) {
+        return;
+    }
+
+    if (status == LUA_YIELD) {
+        // values passed to yield are of no use to anyone
+        lua_settop(coroutine.thread, 0);
+        auto &scheduler = World::get()->scheduler;
+        const auto wake = [this, id] { resume(id, 0); };
+
+        switch (reason) {
+        case Suspension::preempted:
+            resumed->second.wakeup = scheduler.addOneshotTask(wake, pause, "resume_lua_coroutine");
+            break;
+        case Suspension::sleeping:
+            resumed->second.wakeup = scheduler.addOneshotTask(wake, sleepTime, "resume_lua_wait");
+            break;
+        case Suspension::waiting:
+            waiting[awaitedEvent].push_back(id);
+            break;
+        }
+
+        return;
+    }
+
+    if (status != LUA_OK) {
+        auto *state = LuaScript::getLuaState();
+        luaL_traceback(state, coroutine.thread, lua_tostring(coroutine.thread, -1), 0);
+        Logger::error(LogFacility::Script) << "Error in coroutine of " << coroutine.profile->getScript() << "."
+                                           << coroutine.profile->getEntrypoint() << ": " << lua_tostring(state, -1)
+                                           << Log::end;
+        lua_pop(state, 1);
+    }
+
+    finish(id);
+}
+
+void LuaCoroutines::finish(Id id) {
+    const auto it = coroutines.find(id);
+
+    if (it != coroutines.end()) {
+        luaL_unref(LuaScript::getLuaState(), LUA_REGISTRYINDEX, it->second.ref);
+        coroutines.erase(it);
+    }
+}
+
+auto LuaCoroutines::luaAsync(lua_State *state) -> int {
+    luaL_checktype(state, 1, LUA_TFUNCTION);
+
+    // named after where the function was defined, as it has no entrypoint
+    lua_Debug debug;
+    lua_pushvalue(state, 1);
+    lua_getinfo(state, ">S", &debug);
+    auto &profile = LuaProfiler::get().entry(debug.short_src, "async:" + std::to_string(debug.linedefined));
+
+    const luabind::object function(luabind::from_stack(state, 1));
+    std::vector<luabind::object> args;
+
+    for (int index = 2; index <= lua_gettop(state); ++index) {
+        args.emplace_back(luabind::from_stack(state, index));
+    }
+
+    get().start(function, args, profile);
+    return 0;
+}
+
+auto LuaCoroutines::luaWait(lua_State *state) -> int {
+    const auto milliseconds = luaL_checkunsigned(state, 1);
+    auto &coroutines = get();
+
+    if (coroutines.current() != state) {
+        return luaL_error(state, "wait can only be called within async");
+    }
+
+    coroutines.suspension = Suspension::sleeping;
+    coroutines.sleepTime = std::chrono::milliseconds(milliseconds);
+    return lua_yield(state, 0);
+}
+
+auto LuaCoroutines::luaWaitFor(lua_State *state) -> int {
+    const auto *event = luaL_checkstring(state, 1);
+    auto &coroutines = get();
+
+    if (coroutines.current() != state) {
+        return luaL_error(state, "waitFor can only be called within async");
+    }
+
+    coroutines.suspension = Suspension::waiting;
+    coroutines.awaitedEvent = event;
+    return lua_yield(state, 0);
+}
+
+auto LuaCoroutines::luaNotify(lua_State *state) -> int {
+    const std::string event = luaL_checkstring(state, 1);
+    const luabind::object value(luabind::from_stack(state, 2));
+    lua_pushinteger(state, static_cast<lua_Integer>(get().notify(event, value)));
+    return 1;
+}
@@ -0,0 +1,100 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LUA_COROUTINES_HPP
+#define LUA_COROUTINES_HPP
+
+extern "C" {
+#include <lua.h>
+}
+
+#include "Scheduler.hpp"
+#include "script/LuaProfiler.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <luabind/object.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Scripts running as Lua coroutines on the game thread. The watchdog suspends a coroutine once it used up its time
+// slice, it continues shortly after so that the game loop and other tasks get their turn. Coroutines can also wait
+// for some time or for an event, the scheduler or notify resumes them then and not earlier:
+//
+//   async(function()
+//       wait(5000)
+//       local value = waitFor("bridge_repaired")
+//   end)
+//   notify("bridge_repaired", value)
+class LuaCoroutines {
+public:
+    using Id = uint64_t;
+
+    static constexpr std::chrono::milliseconds slice{5};
+    // time between a suspension and the next slice
+    static constexpr std::chrono::milliseconds pause{5};
+
+    static auto get() -> LuaCoroutines &;
+
+    // runs function(args...) in a new coroutine until it finishes or is suspended, 0 if it finished right away
+    auto start(const luabind::object &function, const std::vector<luabind::object> &args,
+               LuaProfiler::Entry &profile) -> Id;
+    [[nodiscard]] auto isAlive(Id id) const -> bool;
+
+    // the coroutine being resumed, nullptr if none
+    [[nodiscard]] auto current() const -> lua_State * { return running; }
+
+    // resumes the coroutines waiting for the event in the order they started waiting, returns how many there were
+    auto notify(const std::string &event, const luabind::object &value) -> size_t;
+
+    // forgets all coroutines, for when their Lua state is closed
+    void clear();
+
+    // makes async, wait, waitFor and notify available to scripts
+    static void registerFunctions(lua_State *state);
+
+private:
+    enum class Suspension { preempted, sleeping, waiting };
+
+    struct Coroutine {
+        lua_State *thread = nullptr;
+        int ref = 0;
+        LuaProfiler::Entry *profile = nullptr;
+        TaskHandle wakeup;
+    };
+
+    void resume(Id id, int arguments);
+    void finish(Id id);
+
+    static auto luaAsync(lua_State *state) -> int;
+    static auto luaWait(lua_State *state) -> int;
+    static auto luaWaitFor(lua_State *state) -> int;
+    static auto luaNotify(lua_State *state) -> int;
+
+    std::unordered_map<Id, Coroutine> coroutines;
+    std::unordered_map<std::string, std::vector<Id>> waiting;
+    Id nextId = 1;
+    lua_State *running = nullptr;
+    // set by wait and waitFor before yielding, the watchdog yields without
+    Suspension suspension = Suspension::preempted;
+    std::chrono::milliseconds sleepTime{0};
+    std::string awaitedEvent;
+};
+
+#endif
@@ -21,12 +21,86 @@
 #include "LuaLookAtItemScript.hpp"
 
 #include "Character.hpp"
+#include "Config.hpp"
 #include "Item.hpp"
 #include "character_ptr.hpp"
 
+#include <functional>
+
 LuaLookAtItemScript::LuaLookAtItemScript(const std::string &filename) : LuaScript(filename) {}
 
 auto LuaLookAtItemScript::lookAtItem(Character *character, const ScriptItem &item) -> ItemLookAt {
+    const auto cacheSize = Config::instance().look_at_cache_size();
+
+    if (cacheSize == 0 || character == nullptr) {
+        character_ptr fuse_character(character);
+        return callEntrypoint<ItemLookAt>("lookAtItem", fuse_character, item);
+    }
+
+    const auto key = cacheKey(character, item);
+
+    if (const auto cached = cache.find(key); cached != cache.end()) {
+        return cached->second;
+    }
+
     character_ptr fuse_character(character);
-    return callEntrypoint<ItemLookAt>("lookAtItem", fuse_character, item);
+    auto lookAt = callEntrypoint<ItemLookAt>("lookAtItem", fuse_character, item);
+
+    if (lookAt.isValid()) {
+        if (cache.size() >= cacheSize) {
+            cache.clear();
+        }
+
+        cache.emplace(key, lookAt);
+    }
+
+    return lookAt;
+}
+
+auto LuaLookAtItemScript::cachedLookAt(const Character *character, const ScriptItem &item) const
+        -> std::optional<ItemLookAt> {
+    if (character == nullptr) {
+        return std::nullopt;
+    }
+
+    if (const auto cached = cache.find(cacheKey(character, item)); cached != cache.end()) {
+        return cached->second;
+    }
+
+    return std::nullopt;
+}
+
+auto LuaLookAtItemScript::CacheKey::operator==(const CacheKey &other) const -> bool {
+    return id == other.id && quality == other.quality && number == other.number && type == other.type &&
+           language == other.language && admin == other.admin && data == other.data;
+}
+
+auto LuaLookAtItemScript::CacheKeyHash::operator()(const CacheKey &key) const -> size_t {
+    size_t hash = key.data;
+
+    for (const size_t value : {size_t(key.id), size_t(key.quality), size_t(key.number), size_t(key.type),
+                               size_t(key.language), size_t(key.admin)}) {
+        hash = hash * 31 + value;
+    }
+
+    return hash;
+}
+
+auto LuaLookAtItemScript::cacheKey(const Character *character, const ScriptItem &item) -> CacheKey {
+    // data is kept sorted by key, so equal data hashes equally
+    size_t data = 0;
+    const std::hash<std::string> hashText;
+
+    for (auto entry = item.getDataBegin(); entry != item.getDataEnd(); ++entry) {
+        data = data * 31 + hashText(entry->first);
+        data = data * 31 + hashText(entry->second);
+    }
+
+    return {item.getId(),
+            item.getQuality(),
+            item.getNumber(),
+            item.type,
+            character->getPlayerLanguage(),
+            character->isAdmin(),
+            data};
 }
@@ -21,11 +21,15 @@
 #ifndef LUA_LOOK_AT_ITEM_SCRIPT_HPP
 #define LUA_LOOK_AT_ITEM_SCRIPT_HPP
 
+#include "Item.hpp"
 #include "ItemLookAt.hpp"
+#include "Language.hpp"
 #include "LuaScript.hpp"
 
+#include <optional>
+#include <unordered_map>
+
 class Character;
-class ScriptItem;
 
 class LuaLookAtItemScript : public LuaScript {
 public:
@@ -36,7 +40,33 @@ public:
     LuaLookAtItemScript(LuaLookAtItemScript &&) = default;
     auto operator=(LuaLookAtItemScript &&) -> LuaLookAtItemScript & = default;
 
+    // Results depend on the item and the language of the character only, so they are cached until the script is
+    // replaced, which a reload of the tables also does.
     auto lookAtItem(Character *character, const ScriptItem &item) -> ItemLookAt;
+    // a cached result, never runs the script
+    [[nodiscard]] auto cachedLookAt(const Character *character, const ScriptItem &item) const
+            -> std::optional<ItemLookAt>;
+
+private:
+    struct CacheKey {
+        Item::id_type id;
+        Item::quality_type quality;
+        Item::number_type number;
+        ScriptItem::itemtype type;
+        Language language;
+        bool admin;
+        size_t data;
+
+        auto operator==(const CacheKey &other) const -> bool;
+    };
+
+    struct CacheKeyHash {
+        auto operator()(const CacheKey &key) const -> size_t;
+    };
+
+    static auto cacheKey(const Character *character, const ScriptItem &item) -> CacheKey;
+
+    std::unordered_map<CacheKey, ItemLookAt, CacheKeyHash> cache;
 };
 
 #endif
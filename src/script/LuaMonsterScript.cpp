@@ -27,6 +27,8 @@
 
 LuaMonsterScript::LuaMonsterScript(const std::string &filename) : LuaScript(filename) {}
 
+LuaMonsterScript::LuaMonsterScript(const std::string &code, const std::string &codename) : LuaScript(code, codename) {}
+
 void LuaMonsterScript::onDeath(Character *Monster) {
     character_ptr fuse_Monster(Monster);
     callEntrypoint("onDeath", fuse_Monster);
@@ -75,19 +77,33 @@ void LuaMonsterScript::onAttack(Character *Monster, Character *target) {
     callEntrypoint("onAttack", fuse_Monster, fuse_target);
 }
 
+// the hooks of every step are optional, a missing one is not worth raising and logging a script error each time
+
 auto LuaMonsterScript::enemyOnSight(Character *Monster, Character *enemy) -> bool {
+    if (!existsEntrypoint("enemyOnSight")) {
+        return false;
+    }
+
     character_ptr fuse_Monster(Monster);
     character_ptr fuse_enemy(enemy);
     return callEntrypoint<bool>("enemyOnSight", fuse_Monster, fuse_enemy);
 }
 
 auto LuaMonsterScript::enemyNear(Character *Monster, Character *enemy) -> bool {
+    if (!existsEntrypoint("enemyNear")) {
+        return false;
+    }
+
     character_ptr fuse_Monster(Monster);
     character_ptr fuse_enemy(enemy);
     return callEntrypoint<bool>("enemyNear", fuse_Monster, fuse_enemy);
 }
 
 void LuaMonsterScript::abortRoute(Character *Monster) {
+    if (!existsEntrypoint("abortRoute")) {
+        return;
+    }
+
     character_ptr fuse_Monster(Monster);
     callEntrypoint("abortRoute", fuse_Monster);
 }
@@ -105,19 +121,75 @@ auto LuaMonsterScript::setTarget(Character *Monster, const std::vector<Character
         return false;
     }
 
-    luabind::object luaCandidateList = luabind::newtable(_luaState);
+    const auto &luaCandidateList = candidateTable(CandidateList);
+    character_ptr fuse_Monster(Monster);
+    const int index = callEntrypoint<int>("setTarget", fuse_Monster, luaCandidateList) - 1;
+
+    if (index >= 0 && index < (int)CandidateList.size()) {
+        Target = CandidateList[index];
+    }
+
+    return true;
+}
+
+auto LuaMonsterScript::setTargets(const std::vector<TargetQuery> &queries, std::vector<TargetChoice> &choices)
+        -> bool {
+    choices.assign(queries.size(), {});
+
+    if (!existsEntrypoint("setTargets")) {
+        return false;
+    }
+
+    const auto toTable = [](const std::vector<Character *> &candidates) {
+        luabind::object table = luabind::newtable(_luaState);
+        int index = 1;
+
+        for (const auto &candidate : candidates) {
+            table[index++] = character_ptr(candidate);
+        }
+
+        return table;
+    };
+
+    luabind::object luaQueries = luabind::newtable(_luaState);
     int index = 1;
 
-    for (const auto &candidate : CandidateList) {
-        character_ptr fuse_it(candidate);
-        luaCandidateList[index++] = fuse_it;
+    for (const auto &query : queries) {
+        luabind::object luaQuery = luabind::newtable(_luaState);
+        luaQuery["monster"] = character_ptr(query.monster);
+        luaQuery["inReach"] = toTable(*query.inReach);
+        luaQuery["inView"] = toTable(*query.inView);
+        luaQueries[index++] = luaQuery;
     }
 
-    character_ptr fuse_Monster(Monster);
-    index = callEntrypoint<int>("setTarget", fuse_Monster, luaCandidateList) - 1;
+    const auto decisions = callEntrypoint<luabind::object, luabind::object>("setTargets", luaQueries);
 
-    if (index >= 0 && index < (int)CandidateList.size()) {
-        Target = CandidateList[index];
+    if (luabind::type(decisions) != LUA_TTABLE) {
+        return false;
+    }
+
+    // a missing or out of range index means no target, as for setTarget
+    const auto pick = [](const luabind::object &choice, const std::vector<Character *> &candidates) -> Character * {
+        if (luabind::type(choice) != LUA_TNUMBER) {
+            return nullptr;
+        }
+
+        const auto candidate = luabind::object_cast<int>(choice) - 1;
+
+        if (candidate >= 0 && candidate < (int)candidates.size()) {
+            return candidates[candidate];
+        }
+
+        return nullptr;
+    };
+
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const luabind::object decision = decisions[i + 1];
+
+        if (luabind::type(decision) == LUA_TTABLE) {
+            choices[i].inReach = pick(decision["inReach"], *queries[i].inReach);
+            choices[i].inView = pick(decision["inView"], *queries[i].inView);
+        }
     }
 
     return true;
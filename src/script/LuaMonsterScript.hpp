@@ -29,8 +29,21 @@ class World;
 
 class LuaMonsterScript : public LuaScript {
 public:
+    // what one monster of a batched setTargets call chooses from, both lists nearest first
+    struct TargetQuery {
+        Character *monster = nullptr;
+        const std::vector<Character *> *inReach = nullptr;
+        const std::vector<Character *> *inView = nullptr;
+    };
+
+    struct TargetChoice {
+        Character *inReach = nullptr;
+        Character *inView = nullptr;
+    };
+
     LuaMonsterScript() = default;
     explicit LuaMonsterScript(const std::string &filename);
+    LuaMonsterScript(const std::string &code, const std::string &codename);
     LuaMonsterScript(const LuaMonsterScript &) = delete;
     auto operator=(const LuaMonsterScript &) -> LuaMonsterScript & = delete;
     LuaMonsterScript(LuaMonsterScript &&) = default;
@@ -50,6 +63,9 @@ public:
     void abortRoute(Character *Monster);
     void onSpawn(Character *Monster);
     auto setTarget(Character *Monster, const std::vector<Character *> &CandidateList, Character *&Target) -> bool;
+    // opt-in alternative to setTarget choosing for all queries in one call, false if the script has no setTargets
+    // entrypoint or its result is unusable
+    auto setTargets(const std::vector<TargetQuery> &queries, std::vector<TargetChoice> &choices) -> bool;
 };
 
 #endif
@@ -26,6 +26,11 @@
 LuaNPCScript::LuaNPCScript(const std::string &filename, NPC *thisnpc) : LuaScript(filename), _thisnpc(thisnpc) {}
 
 void LuaNPCScript::nextCycle() {
+    // optional, a missing entrypoint is not worth raising and logging a script error every cycle
+    if (!existsEntrypoint("nextCycle")) {
+        return;
+    }
+
     character_ptr fuse_thisnpc(_thisnpc);
     callEntrypoint("nextCycle", fuse_thisnpc);
 }
@@ -42,6 +47,32 @@ void LuaNPCScript::receiveText(Character::talk_type tt, const std::string &messa
     callEntrypoint("receiveText", fuse_thisnpc, (int)tt, message, fuse_cc);
 }
 
+auto LuaNPCScript::hearsText(const std::string &message) const -> bool {
+    // quests may listen for anything
+    if (existsQuestEntrypoint("receiveText")) {
+        return true;
+    }
+
+    auto &triggers = textTriggers()[getFileName()];
+
+    if (triggers.state != stateGeneration || triggers.loads != loadGeneration) {
+        triggers.state = stateGeneration;
+        triggers.loads = loadGeneration;
+        triggers.matcher.reset();
+
+        if (auto keywords = stringList("textTriggers")) {
+            triggers.matcher.emplace(*keywords);
+        }
+    }
+
+    return !triggers.matcher || triggers.matcher->matches(message);
+}
+
+auto LuaNPCScript::textTriggers() -> std::unordered_map<std::string, TextTriggers> & {
+    static std::unordered_map<std::string, TextTriggers> triggers;
+    return triggers;
+}
+
 void LuaNPCScript::useNPC(Character *user, unsigned char ltastate) {
     character_ptr fuse_thisnpc(_thisnpc);
     character_ptr fuse_user(user);
@@ -23,8 +23,13 @@
 
 #include "Character.hpp"
 #include "Item.hpp"
+#include "KeywordMatcher.hpp"
 #include "LuaScript.hpp"
 
+#include <optional>
+#include <string>
+#include <unordered_map>
+
 class NPC;
 class World;
 
@@ -39,6 +44,8 @@ public:
 
     void nextCycle();
     void receiveText(Character::talk_type tt, const std::string &message, Character *cc);
+    // false if the module lists textTriggers and the message contains none of them, so receiveText can be skipped
+    [[nodiscard]] auto hearsText(const std::string &message) const -> bool;
     void useNPC(Character *user, unsigned char ltastate);
     void lookAtNpc(Character *source, unsigned char mode);
     auto actionDisturbed(Character *performer, Character *disturber) -> bool;
@@ -50,6 +57,16 @@ public:
 private:
     NPC *_thisnpc;
 
+    struct TextTriggers {
+        uint32_t state = 0;
+        uint32_t loads = 0;
+        // nothing if the module hears every text
+        std::optional<KeywordMatcher> matcher;
+    };
+
+    // one automaton for every NPC running the same script
+    static auto textTriggers() -> std::unordered_map<std::string, TextTriggers> &;
+
     void init_functions();
 };
 
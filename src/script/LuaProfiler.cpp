@@ -0,0 +1,159 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "script/LuaProfiler.hpp"
+
+#include "Logger.hpp"
+#include "script/LuaScript.hpp"
+#include "script/LuaWatchdog.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+void LuaProfiler::Entry::record(std::chrono::nanoseconds time) {
+    ++calls;
+    total += time;
+    max = std::max(max, time);
+    ++histogram[bucketOf(std::max<int64_t>(time.count(), 0))];
+}
+
+void LuaProfiler::Entry::reset() {
+    calls = 0;
+    total = std::chrono::nanoseconds::zero();
+    max = std::chrono::nanoseconds::zero();
+    histogram.fill(0);
+}
+
+auto LuaProfiler::Entry::percentile(double fraction) const -> std::chrono::nanoseconds {
+    const auto rank = static_cast<uint64_t>(std::ceil(static_cast<double>(calls) * fraction));
+    uint64_t seen = 0;
+
+    for (size_t bucket = 0; bucket < bucketCount; ++bucket) {
+        seen += histogram[bucket];
+
+        if (seen >= rank && seen > 0) {
+            return std::min(max, std::chrono::nanoseconds(upperBoundOf(bucket)));
+        }
+    }
+
+    return max;
+}
+
+auto LuaProfiler::Entry::bucketOf(uint64_t nanoseconds) -> size_t {
+    if (nanoseconds < 4) {
+        return nanoseconds;
+    }
+
+    const int highest = 63 - __builtin_clzll(nanoseconds);
+    const auto quarter = (nanoseconds >> (highest - 2)) & 3U;
+    return 4 * (highest - 1) + quarter;
+}
+
+auto LuaProfiler::Entry::upperBoundOf(size_t bucket) -> uint64_t {
+    if (bucket < 4) {
+        return bucket;
+    }
+
+    const auto highest = bucket / 4 + 1;
+    const auto quarter = bucket % 4;
+    return ((5 + quarter) << (highest - 2)) - 1;
+}
+
+auto LuaProfiler::get() -> LuaProfiler & {
+    static LuaProfiler profiler;
+    return profiler;
+}
+
+auto LuaProfiler::entry(const std::string &script, const std::string &entrypoint) -> Entry & {
+    auto key = std::make_pair(script, entrypoint);
+    auto it = entries.find(key);
+
+    if (it == entries.end()) {
+        it = entries.emplace(std::move(key), Entry(script, entrypoint)).first;
+    }
+
+    return it->second;
+}
+
+auto LuaProfiler::slowest(size_t count) const -> std::vector<const Entry *> {
+    std::vector<const Entry *> result;
+
+    for (const auto &[key, entry] : entries) {
+        if (entry.getCalls() > 0) {
+            result.push_back(&entry);
+        }
+    }
+
+    count = std::min(count, result.size());
+    std::partial_sort(result.begin(), result.begin() + count, result.end(),
+                      [](const auto *lhs, const auto *rhs) { return lhs->getTotal() > rhs->getTotal(); });
+    result.resize(count);
+    return result;
+}
+
+auto LuaProfiler::hottestLines(size_t count) const -> std::vector<std::pair<std::string, uint64_t>> {
+    std::vector<std::pair<std::string, uint64_t>> result(samples.begin(), samples.end());
+    count = std::min(count, result.size());
+    std::partial_sort(result.begin(), result.begin() + count, result.end(),
+                      [](const auto &lhs, const auto &rhs) { return lhs.second > rhs.second; });
+    result.resize(count);
+    return result;
+}
+
+void LuaProfiler::reset() {
+    for (auto &[key, entry] : entries) {
+        entry.reset();
+    }
+
+    samples.clear();
+}
+
+void LuaProfiler::setSampling(uint32_t instructions) {
+    sampleInterval = instructions;
+
+    if (auto *state = LuaScript::getLuaState(); state != nullptr) {
+        LuaWatchdog::install(state);
+    }
+}
+
+void LuaProfiler::sample(lua_State *state, lua_Debug *debug) {
+    if (lua_getinfo(state, "Sl", debug) == 0) {
+        return;
+    }
+
+    ++get().samples[std::string(debug->short_src) + ":" + std::to_string(debug->currentline)];
+}
+
+void LuaProfiler::dump() const {
+    constexpr size_t listed = 20;
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    for (const auto *entry : slowest(listed)) {
+        Logger::info(LogFacility::Script) << "lua profile " << entry->getScript() << "." << entry->getEntrypoint()
+                                          << ": " << entry->getCalls() << " calls, "
+                                          << duration_cast<microseconds>(entry->getTotal()).count() << " us total, "
+                                          << duration_cast<microseconds>(entry->percentile(0.99)).count()
+                                          << " us p99, " << duration_cast<microseconds>(entry->getMax()).count()
+                                          << " us max" << Log::end;
+    }
+
+    for (const auto &[line, count] : hottestLines(listed)) {
+        Logger::info(LogFacility::Script) << "lua samples " << line << ": " << count << Log::end;
+    }
+}
@@ -0,0 +1,107 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LUA_PROFILER_HPP
+#define LUA_PROFILER_HPP
+
+extern "C" {
+#include <lua.h>
+}
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Wall time spent in Lua, per script and entrypoint, and optionally the Lua lines a count hook lands on.
+// Lua runs on the game thread only, so does the profiler.
+class LuaProfiler {
+public:
+    class Entry {
+    public:
+        Entry(std::string script, std::string entrypoint)
+                : script(std::move(script)), entrypoint(std::move(entrypoint)) {}
+
+        void record(std::chrono::nanoseconds time);
+        void reset();
+
+        [[nodiscard]] auto getScript() const -> const std::string & { return script; }
+        [[nodiscard]] auto getEntrypoint() const -> const std::string & { return entrypoint; }
+        [[nodiscard]] auto getCalls() const -> uint64_t { return calls; }
+        [[nodiscard]] auto getTotal() const -> std::chrono::nanoseconds { return total; }
+        [[nodiscard]] auto getMax() const -> std::chrono::nanoseconds { return max; }
+        // upper bound of the bucket holding the given fraction of calls, at most a quarter octave too high
+        [[nodiscard]] auto percentile(double fraction) const -> std::chrono::nanoseconds;
+
+    private:
+        // four buckets per power of two of nanoseconds
+        static constexpr size_t bucketCount = 256;
+        static auto bucketOf(uint64_t nanoseconds) -> size_t;
+        static auto upperBoundOf(size_t bucket) -> uint64_t;
+
+        std::string script;
+        std::string entrypoint;
+        uint64_t calls = 0;
+        std::chrono::nanoseconds total{0};
+        std::chrono::nanoseconds max{0};
+        std::array<uint32_t, bucketCount> histogram{};
+    };
+
+    // records the time from construction to destruction, also when unwinding a script error
+    class Measurement {
+    public:
+        explicit Measurement(Entry &entry) : entry(entry), start(std::chrono::steady_clock::now()) {}
+        Measurement(const Measurement &) = delete;
+        auto operator=(const Measurement &) -> Measurement & = delete;
+        Measurement(Measurement &&) = delete;
+        auto operator=(Measurement &&) -> Measurement & = delete;
+        ~Measurement() { entry.record(std::chrono::steady_clock::now() - start); }
+
+    private:
+        Entry &entry;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    static auto get() -> LuaProfiler &;
+
+    // entries stay where they are until shutdown, so scripts may keep pointers to them
+    auto entry(const std::string &script, const std::string &entrypoint) -> Entry &;
+    [[nodiscard]] auto slowest(size_t count) const -> std::vector<const Entry *>;
+    [[nodiscard]] auto hottestLines(size_t count) const -> std::vector<std::pair<std::string, uint64_t>>;
+    void reset();
+
+    // samples the executing line about every given number of Lua instructions, 0 stops sampling
+    void setSampling(uint32_t instructions);
+    [[nodiscard]] auto getSampling() const -> uint32_t { return sampleInterval; }
+    // counts the line the hook of the watchdog stopped at
+    static void sample(lua_State *state, lua_Debug *debug);
+
+    void dump() const;
+
+private:
+
+    std::map<std::pair<std::string, std::string>, Entry> entries;
+    std::unordered_map<std::string, uint64_t> samples;
+    uint32_t sampleInterval = 0;
+};
+
+#endif
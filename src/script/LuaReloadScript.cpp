@@ -28,4 +28,8 @@
 
 LuaReloadScript::LuaReloadScript(const std::string &filename) : LuaScript(filename) {}
 
-void LuaReloadScript::onReload() { callEntrypoint("onReload"); }
+void LuaReloadScript::onReload() {
+    // reloading may take as long as it needs
+    const LuaWatchdog::Unlimited unlimited;
+    callEntrypoint("onReload");
+}
@@ -24,5 +24,12 @@ LuaScheduledScript::LuaScheduledScript(const std::string &filename) : LuaScript(
 
 void LuaScheduledScript::callFunction(const std::string &name, uint32_t currentCycle, uint32_t lastCycle,
                                       uint32_t nextCycle) {
-    callEntrypoint(name, currentCycle, lastCycle, nextCycle);
+    if (!isFlagSet("preemptible")) {
+        callEntrypoint(name, currentCycle, lastCycle, nextCycle);
+        return;
+    }
+
+    if (!LuaCoroutines::get().isAlive(running)) {
+        running = startCoroutine(name, currentCycle, lastCycle, nextCycle);
+    }
 }
@@ -34,7 +34,11 @@ public:
     LuaScheduledScript(LuaScheduledScript &&) = default;
     auto operator=(LuaScheduledScript &&) -> LuaScheduledScript & = default;
 
+    // modules setting preemptible = true run as coroutines, a new run is skipped while the last one is suspended
     void callFunction(const std::string &name, uint32_t currentCycle, uint32_t lastCycle, uint32_t nextCycle);
+
+private:
+    LuaCoroutines::Id running = 0;
 };
 
 #endif
@@ -32,6 +32,10 @@ extern "C" {
 #include "Player.hpp"
 #include "World.hpp"
 #include "data/Data.hpp"
+#include "script/LuaChunkCache.hpp"
+#include "script/LuaCollector.hpp"
+#include "script/LuaCoroutines.hpp"
+#include "script/LuaWatchdog.hpp"
 #include "script/binding/binding.hpp"
 #include "script/forwarder.hpp"
 
@@ -40,9 +44,13 @@ extern "C" {
 #include <iostream>
 #include <luabind/luabind.hpp>
 #include <luabind/raw_policy.hpp>
+#include <utility>
 
 lua_State *LuaScript::_luaState = nullptr;
 bool LuaScript::initialized = false;
+uint32_t LuaScript::stateGeneration = 0;
+uint32_t LuaScript::loadGeneration = 0;
+luabind::object candidates;
 
 LuaScript::LuaScript() { initialize(); }
 
@@ -69,12 +77,16 @@ LuaScript::LuaScript(const std::string &code, const std::string &scriptname) {
 
     lua_setfield(_luaState, -2, _filename.c_str());
     lua_pop(_luaState, 1);
+    ++loadGeneration;
 }
 
 void LuaScript::initialize() {
     if (!initialized) {
         initialized = true;
         _luaState = luaL_newstate();
+        ++stateGeneration;
+        LuaWatchdog::install(_luaState);
+        LuaCollector::configure(_luaState);
         luabind::open(_luaState);
 
         // use another error function to surpress errors from
@@ -92,13 +104,15 @@ void LuaScript::initialize() {
         lua_pushstring(_luaState, "path");
         lua_pushstring(_luaState, path.c_str());
         lua_settable(_luaState, -3);
+
+        LuaChunkCache::installSearcher(_luaState);
     }
 }
 
 void LuaScript::loadIntoLuaState() {
     luaL_getsubtable(_luaState, LUA_REGISTRYINDEX, "_LOADED");
 
-    int errorCode = luaL_loadfile(_luaState, luafile.c_str());
+    int errorCode = LuaChunkCache::get().load(_luaState, luafile);
     handleLuaLoadError(errorCode);
 
     if (errorCode != 0) {
@@ -114,6 +128,7 @@ void LuaScript::loadIntoLuaState() {
 
     lua_setfield(_luaState, -2, _filename.c_str());
     lua_pop(_luaState, 1);
+    ++loadGeneration;
 }
 
 void LuaScript::handleLuaLoadError(int errorCode) {
@@ -163,11 +178,55 @@ void LuaScript::shutdownLua() {
 
     if (initialized) {
         initialized = false;
+        LuaCoroutines::get().clear();
+        candidates = luabind::object();
         lua_close(_luaState);
         _luaState = nullptr;
     }
 }
 
+auto LuaScript::callDuration() -> metrics::Histogram & {
+    static auto &histogram =
+            metrics::Registry::get().histogram("illarion_lua_call_duration_seconds", "Calls of script entrypoints");
+    return histogram;
+}
+
+auto LuaScript::candidateTable(const std::vector<Character *> &characters) -> const luabind::object & {
+    if (!candidates.is_valid()) {
+        candidates = luabind::newtable(_luaState);
+    }
+
+    auto &table = candidates;
+    int index = 1;
+
+    for (const auto &candidate : characters) {
+        table[index++] = character_ptr(candidate);
+    }
+
+    // entries left over from a longer list
+    while (luabind::type(table[index]) != LUA_TNIL) {
+        table[index++] = luabind::nil;
+    }
+
+    return table;
+}
+
+void LuaScript::unloadModules(const std::unordered_set<std::string> &modules) {
+    if (!initialized) {
+        return;
+    }
+
+    luaL_getsubtable(_luaState, LUA_REGISTRYINDEX, "_LOADED");
+
+    for (const auto &module : modules) {
+        lua_pushnil(_luaState);
+        lua_setfield(_luaState, -2, module.c_str());
+    }
+
+    lua_pop(_luaState, 1);
+    ++loadGeneration;
+}
+
 auto LuaScript::add_backtrace(lua_State *L) -> int {
     lua_Debug d;
     std::stringstream msg;
@@ -258,21 +317,126 @@ void LuaScript::writeDeprecatedMsg(const std::string &deprecatedEntity) {
     }
 }
 
-auto LuaScript::buildEntrypoint(const std::string &entrypoint) -> luabind::object {
-    luabind::object obj = luabind::registry(_luaState);
-    obj = obj["_LOADED"][_filename];
+LuaScript::EntrypointRef::EntrypointRef(EntrypointRef &&other) noexcept
+        : ref(std::exchange(other.ref, LUA_NOREF)), state(other.state), loads(other.loads) {}
+
+auto LuaScript::EntrypointRef::operator=(EntrypointRef &&other) noexcept -> EntrypointRef & {
+    if (this != &other) {
+        reset();
+        ref = std::exchange(other.ref, LUA_NOREF);
+        state = other.state;
+        loads = other.loads;
+    }
+
+    return *this;
+}
+
+LuaScript::EntrypointRef::~EntrypointRef() { reset(); }
+
+auto LuaScript::EntrypointRef::isCurrent() const -> bool {
+    return state == stateGeneration && loads == loadGeneration;
+}
+
+void LuaScript::EntrypointRef::reset(int newRef) {
+    // references into a closed state are gone with it
+    if (_luaState != nullptr && state == stateGeneration) {
+        luaL_unref(_luaState, LUA_REGISTRYINDEX, ref);
+    }
+
+    ref = newRef;
+    state = stateGeneration;
+    loads = loadGeneration;
+}
+
+auto LuaScript::resolve(const std::string &entrypoint) const -> CachedEntrypoint & {
+    auto &cached = entrypoints[entrypoint];
+
+    if (cached.profile == nullptr) {
+        cached.profile = &LuaProfiler::get().entry(_filename, entrypoint);
+    }
+
+    if (cached.ref.get() != LUA_NOREF && cached.ref.isCurrent()) {
+        return cached;
+    }
+
+    lua_getfield(_luaState, LUA_REGISTRYINDEX, "_LOADED");
+    lua_getfield(_luaState, -1, _filename.c_str());
+
+    if (!lua_istable(_luaState, -1)) {
+        lua_pop(_luaState, 2);
+        cached.ref.reset();
+        return cached;
+    }
+
+    lua_getfield(_luaState, -1, entrypoint.c_str());
+    cached.ref.reset(luaL_ref(_luaState, LUA_REGISTRYINDEX));
+    lua_pop(_luaState, 2);
+
+    return cached;
+}
+
+auto LuaScript::buildEntrypoint(const std::string &entrypoint) -> CallTarget {
+    auto &cached = resolve(entrypoint);
+    const auto ref = cached.ref.get();
 
-    if (luabind::type(obj) != LUA_TTABLE) {
+    if (ref == LUA_NOREF) {
         triggerScriptError("Error while loading entrypoint '" + entrypoint + "' from module " + _filename +
                            ". Check if the script returns its module as table.");
     }
 
-    luabind::object callee = obj[entrypoint];
-    return callee;
+    lua_rawgeti(_luaState, LUA_REGISTRYINDEX, ref);
+    luabind::object callee(luabind::from_stack(_luaState, -1));
+    lua_pop(_luaState, 1);
+    return {callee, *cached.profile};
+}
+
+auto LuaScript::isFlagSet(const std::string &field) const -> bool {
+    const auto ref = resolve(field).ref.get();
+
+    if (ref == LUA_NOREF) {
+        return false;
+    }
+
+    lua_rawgeti(_luaState, LUA_REGISTRYINDEX, ref);
+    const bool isSet = lua_toboolean(_luaState, -1) != 0;
+    lua_pop(_luaState, 1);
+
+    return isSet;
+}
+
+auto LuaScript::stringList(const std::string &field) const -> std::optional<std::vector<std::string>> {
+    const auto ref = resolve(field).ref.get();
+
+    if (ref == LUA_NOREF) {
+        return {};
+    }
+
+    lua_rawgeti(_luaState, LUA_REGISTRYINDEX, ref);
+
+    if (!lua_istable(_luaState, -1)) {
+        lua_pop(_luaState, 1);
+        return {};
+    }
+
+    std::vector<std::string> strings;
+    const auto length = static_cast<int>(lua_rawlen(_luaState, -1));
+
+    for (int i = 1; i <= length; ++i) {
+        lua_rawgeti(_luaState, -1, i);
+
+        if (lua_type(_luaState, -1) == LUA_TSTRING) {
+            strings.emplace_back(lua_tostring(_luaState, -1));
+        }
+
+        lua_pop(_luaState, 1);
+    }
+
+    lua_pop(_luaState, 1);
+    return strings;
 }
 
 void LuaScript::addQuestScript(const std::string &entrypoint, const std::shared_ptr<LuaScript> &script) {
-    questScripts.insert(std::pair<const std::string, std::shared_ptr<LuaScript>>(entrypoint, script));
+    questScripts[entrypoint].push_back(script);
 }
 
 void LuaScript::setCurrentWorldScript() { World::get()->setCurrentScript(this); }
@@ -282,20 +446,17 @@ auto LuaScript::existsQuestEntrypoint(const std::string &entrypoint) const -> bo
 }
 
 auto LuaScript::existsEntrypoint(const std::string &entrypoint) const -> bool {
-    luabind::object obj = luabind::registry(_luaState);
-    obj = obj["_LOADED"][_filename];
+    const auto ref = resolve(entrypoint).ref.get();
 
-    if (luabind::type(obj) != LUA_TTABLE) {
+    if (ref == LUA_NOREF) {
         return existsQuestEntrypoint(entrypoint);
     }
 
-    obj = obj[entrypoint];
-
-    if (luabind::type(obj) != LUA_TFUNCTION) {
-        return existsQuestEntrypoint(entrypoint);
-    }
+    lua_rawgeti(_luaState, LUA_REGISTRYINDEX, ref);
+    const bool isFunction = lua_type(_luaState, -1) == LUA_TFUNCTION;
+    lua_pop(_luaState, 1);
 
-    return true;
+    return isFunction || existsQuestEntrypoint(entrypoint);
 }
 
 static auto dofile(lua_State *L, const char *fname) -> int {
@@ -358,6 +519,8 @@ void LuaScript::init_base_functions() {
                        luabind::def("isValidChar", &isValid), luabind::def("debug", &LuaScript::writeDebugMsg),
                        luabind::def("log", log_lua)];
 
+    LuaCoroutines::registerFunctions(_luaState);
+
     const luabind::object &globals = luabind::globals(_luaState);
     globals["world"] = World::get();
     globals["ScriptVars"] = &Data::scriptVariables();
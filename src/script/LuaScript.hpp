@@ -22,18 +22,28 @@
 #define LUA_SCRIPT_HPP
 
 extern "C" {
+#include <lauxlib.h>
 #include <lua.h>
 }
 
 #include "Item.hpp"
 #include "Logger.hpp"
+#include "Metrics.hpp"
 #include "character_ptr.hpp"
 #include "globals.hpp"
+#include "script/LuaCoroutines.hpp"
+#include "script/LuaProfiler.hpp"
+#include "script/LuaWatchdog.hpp"
 
 #include <luabind/luabind.hpp>
 #include <luabind/object.hpp>
 #include <map>
+#include <optional>
 #include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 class Character;
 class World;
@@ -82,6 +92,8 @@ public:
     static auto getLuaState() -> lua_State * { return _luaState; }
 
     static void shutdownLua();
+    // lets the next require run the modules again, scripts holding them keep the loaded version
+    static void unloadModules(const std::unordered_set<std::string> &modules);
     [[nodiscard]] auto existsEntrypoint(const std::string &entrypoint) const -> bool;
     void addQuestScript(const std::string &entrypoint, const std::shared_ptr<LuaScript> &script);
 
@@ -93,6 +105,9 @@ public:
         }
 
         try {
+            auto &profile = LuaProfiler::get().entry("dialog", dialog.getClassName());
+            const LuaProfiler::Measurement measurement(profile);
+            const LuaWatchdog::Call call(profile);
             callback(dialog);
         } catch (luabind::error &e) {
             lua_State *L = e.state();
@@ -110,6 +125,9 @@ public:
         }
 
         try {
+            auto &profile = LuaProfiler::get().entry("dialog", dialog.getClassName());
+            const LuaProfiler::Measurement measurement(profile);
+            const LuaWatchdog::Call call(profile);
             return luabind::object_cast<U>(callback(dialog));
         } catch (luabind::cast_failed &e) {
             const std::string &expectedType = e.info().name();
@@ -132,6 +150,10 @@ public:
 protected:
     static lua_State *_luaState;
     static bool initialized;
+    // bumped for every new Lua state and every module loaded into it, cached entrypoints of older ones are stale
+    static uint32_t stateGeneration;
+    static uint32_t loadGeneration;
+    static luabind::object candidates;
 
     template <typename... Args> void callEntrypoint(const std::string &entrypoint, const Args &...args) {
         setCurrentWorldScript();
@@ -146,6 +168,30 @@ protected:
         callQuestEntrypoint(entrypoint, args...);
         return safeCall<T, Args...>(entrypoint, args...);
     }
+    // runs the entrypoint as a coroutine that is suspended instead of aborted when it runs over its time slice,
+    // returns 0 if it finished right away
+    template <typename... Args>
+    auto startCoroutine(const std::string &entrypoint, const Args &...args) -> LuaCoroutines::Id {
+        setCurrentWorldScript();
+
+        try {
+            auto target = buildEntrypoint(entrypoint);
+            return LuaCoroutines::get().start(target.function, {luabind::object(_luaState, args)...}, target.profile);
+        } catch (const luabind::error &e) {
+            writeErrorMsg();
+        }
+
+        return 0;
+    }
+    // whether the module sets the field to a value other than false or nil
+    [[nodiscard]] auto isFlagSet(const std::string &field) const -> bool;
+    // the strings of the list the module sets the field to, nothing if it sets no table
+    [[nodiscard]] auto stringList(const std::string &field) const -> std::optional<std::vector<std::string>>;
+    [[nodiscard]] auto existsQuestEntrypoint(const std::string &entrypoint) const -> bool;
+    // one table reused for every candidate list handed to Lua, so scripts have to copy entries they keep
+    static auto candidateTable(const std::vector<Character *> &characters) -> const luabind::object &;
+    // time spent in entrypoints called through safeCall
+    static auto callDuration() -> metrics::Histogram &;
 
 private:
     static void initialize();
@@ -157,32 +203,53 @@ private:
     static void writeErrorMsg();
     void writeCastErrorMsg(const std::string &entryPoint, const luabind::cast_failed &e) const;
     void setCurrentWorldScript();
-    auto buildEntrypoint(const std::string &entrypoint) -> luabind::object;
-    [[nodiscard]] auto existsQuestEntrypoint(const std::string &entrypoint) const -> bool;
+    struct CallTarget {
+        luabind::object function;
+        LuaProfiler::Entry &profile;
+    };
 
+    auto buildEntrypoint(const std::string &entrypoint) -> CallTarget;
+
+    // stops at the first quest handling the call
     template <typename... Args> auto callQuestEntrypoint(const std::string &entrypoint, const Args &...args) -> bool {
-        auto entrypointRange = questScripts.equal_range(entrypoint);
-        bool foundQuest = false;
+        // most objects have no quest hooks at all
+        if (questScripts.empty()) {
+            return false;
+        }
 
-        for (auto it = entrypointRange.first; it != entrypointRange.second; ++it) {
-            foundQuest = foundQuest || it->second->safeCall<bool>(entrypoint, args...);
+        const auto quests = questScripts.find(entrypoint);
+
+        if (quests == questScripts.end()) {
+            return false;
+        }
+
+        for (const auto &quest : quests->second) {
+            if (quest->safeCall<bool>(entrypoint, args...)) {
+                return true;
+            }
         }
 
-        return foundQuest;
+        return false;
     }
 
     template <typename... Args> void safeCall(const std::string &entrypoint, const Args &...args) {
         try {
-            auto luaEntrypoint = buildEntrypoint(entrypoint);
-            luaEntrypoint(args...);
+            auto target = buildEntrypoint(entrypoint);
+            const LuaProfiler::Measurement measurement(target.profile);
+            const LuaWatchdog::Call call(target.profile);
+            const metrics::Timer timer(callDuration());
+            target.function(args...);
         } catch (const luabind::error &e) {
             writeErrorMsg();
         }
     }
     template <typename T, typename... Args> auto safeCall(const std::string &entrypoint, const Args &...args) -> T {
         try {
-            auto luaEntrypoint = buildEntrypoint(entrypoint);
-            auto result = luaEntrypoint(args...);
+            auto target = buildEntrypoint(entrypoint);
+            const LuaProfiler::Measurement measurement(target.profile);
+            const LuaWatchdog::Call call(target.profile);
+            const metrics::Timer timer(callDuration());
+            auto result = target.function(args...);
             return luabind::object_cast<T>(result);
         } catch (luabind::cast_failed &e) {
             writeCastErrorMsg(entrypoint, e);
@@ -193,9 +260,39 @@ private:
         return T();
     }
 
+    // registry reference to the value of an entrypoint, not released if it belongs to a closed Lua state
+    class EntrypointRef {
+    public:
+        EntrypointRef() = default;
+        EntrypointRef(const EntrypointRef &) = delete;
+        auto operator=(const EntrypointRef &) -> EntrypointRef & = delete;
+        EntrypointRef(EntrypointRef &&other) noexcept;
+        auto operator=(EntrypointRef &&other) noexcept -> EntrypointRef &;
+        ~EntrypointRef();
+
+        [[nodiscard]] auto isCurrent() const -> bool;
+        void reset(int newRef = LUA_NOREF);
+        [[nodiscard]] auto get() const -> int { return ref; }
+
+    private:
+        int ref = LUA_NOREF;
+        uint32_t state = 0;
+        uint32_t loads = 0;
+    };
+
+    struct CachedEntrypoint {
+        EntrypointRef ref;
+        LuaProfiler::Entry *profile = nullptr;
+    };
+
+    // the cached entrypoint with a current reference, LUA_NOREF if the module is no table
+    auto resolve(const std::string &entrypoint) const -> CachedEntrypoint &;
+
     std::string _filename{};
     std::string luafile{};
-    using QuestScripts = std::multimap<const std::string, std::shared_ptr<LuaScript>>;
+    mutable std::unordered_map<std::string, CachedEntrypoint> entrypoints;
+    // quest scripts by entrypoint, in the order they were added
+    using QuestScripts = std::unordered_map<std::string, std::vector<std::shared_ptr<LuaScript>>>;
     QuestScripts questScripts;
 };
 
@@ -0,0 +1,99 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "script/LuaWatchdog.hpp"
+
+extern "C" {
+#include <lauxlib.h>
+}
+
+#include "Config.hpp"
+#include "Logger.hpp"
+#include "script/LuaCoroutines.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// state of the outermost running call, Lua only runs on the game thread
+int depth = 0;
+bool unlimited = false;
+bool reported = false;
+std::chrono::steady_clock::time_point deadline;
+const LuaProfiler::Entry *outermost = nullptr;
+
+int samplesEvery = 0;
+int hooksUntilSample = 0;
+
+} // namespace
+
+LuaWatchdog::Call::Call(const LuaProfiler::Entry &entry)
+        : Call(entry, std::chrono::milliseconds(Config::instance().lua_call_budget())) {}
+
+LuaWatchdog::Call::Call(const LuaProfiler::Entry &entry, std::chrono::nanoseconds budget) {
+    if (depth++ == 0) {
+        outermost = &entry;
+        reported = false;
+        deadline = budget > std::chrono::nanoseconds::zero() ? std::chrono::steady_clock::now() + budget
+                                                             : std::chrono::steady_clock::time_point::max();
+    }
+}
+
+LuaWatchdog::Call::~Call() { --depth; }
+
+LuaWatchdog::Unlimited::Unlimited() : previous(std::exchange(unlimited, true)) {}
+
+LuaWatchdog::Unlimited::~Unlimited() { unlimited = previous; }
+
+void LuaWatchdog::install(lua_State *state) {
+    const auto sampling = static_cast<int>(LuaProfiler::get().getSampling());
+    const auto count = sampling > 0 ? std::min(sampling, checkInterval) : checkInterval;
+    samplesEvery = sampling > 0 ? std::max(1, sampling / count) : 0;
+    hooksUntilSample = samplesEvery;
+    lua_sethook(state, &LuaWatchdog::hook, LUA_MASKCOUNT, count);
+}
+
+auto LuaWatchdog::running() -> const LuaProfiler::Entry * { return depth > 0 ? outermost : nullptr; }
+
+void LuaWatchdog::hook(lua_State *state, lua_Debug *debug) {
+    if (samplesEvery > 0 && --hooksUntilSample <= 0) {
+        hooksUntilSample = samplesEvery;
+        LuaProfiler::sample(state, debug);
+    }
+
+    if (depth == 0 || unlimited || std::chrono::steady_clock::now() < deadline) {
+        return;
+    }
+
+    // coroutines are suspended for a while instead, yielding from a hook takes effect once it returns
+    if (LuaCoroutines::get().current() == state) {
+        lua_yield(state, 0);
+        return;
+    }
+
+    if (!reported) {
+        reported = true;
+        Logger::error(LogFacility::Script) << "Aborting " << outermost->getScript() << "."
+                                           << outermost->getEntrypoint() << ", it ran over its time budget"
+                                           << Log::end;
+    }
+
+    // keeps raising on later checks if the script catches the error and carries on
+    luaL_error(state, "script ran over its time budget");
+}
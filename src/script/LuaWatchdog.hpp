@@ -0,0 +1,73 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LUA_WATCHDOG_HPP
+#define LUA_WATCHDOG_HPP
+
+extern "C" {
+#include <lua.h>
+}
+
+#include "script/LuaProfiler.hpp"
+
+#include <chrono>
+
+// Keeps runaway scripts from freezing the game thread. A count hook checks the time taken by the outermost Lua call:
+// calls over their budget are aborted with a script error, preemptible coroutines are suspended instead.
+class LuaWatchdog {
+public:
+    // Lua instructions between two checks
+    static constexpr int checkInterval = 1000;
+
+    // starts the budget if it is the outermost call, nested calls count against the budget of the outermost one
+    class Call {
+    public:
+        explicit Call(const LuaProfiler::Entry &entry);
+        Call(const LuaProfiler::Entry &entry, std::chrono::nanoseconds budget);
+        Call(const Call &) = delete;
+        auto operator=(const Call &) -> Call & = delete;
+        Call(Call &&) = delete;
+        auto operator=(Call &&) -> Call & = delete;
+        ~Call();
+    };
+
+    // lifts the budget, for calls like server.reload that legitimately take long
+    class Unlimited {
+    public:
+        Unlimited();
+        Unlimited(const Unlimited &) = delete;
+        auto operator=(const Unlimited &) -> Unlimited & = delete;
+        Unlimited(Unlimited &&) = delete;
+        auto operator=(Unlimited &&) -> Unlimited & = delete;
+        ~Unlimited();
+
+    private:
+        bool previous;
+    };
+
+    // installs the hook with the configured budget and the sampling interval of the profiler, needed for every new
+    // Lua state and whenever sampling changes
+    static void install(lua_State *state);
+    // entry of the outermost running call, nullptr outside of Lua
+    [[nodiscard]] static auto running() -> const LuaProfiler::Entry *;
+
+private:
+    static void hook(lua_State *state, lua_Debug *debug);
+};
+
+#endif
@@ -34,16 +34,9 @@ void LuaWeaponScript::onAttack(Character *Attacker, Character *Defender) {
 }
 
 auto LuaWeaponScript::setTarget(Character *Monster, const std::vector<Character *> &CandidateList) -> Character * {
-    luabind::object luaCandidateList = luabind::newtable(_luaState);
-    int index = 1;
-
-    for (const auto &candidate : CandidateList) {
-        character_ptr fuse_it(candidate);
-        luaCandidateList[index++] = fuse_it;
-    }
-
+    const auto &luaCandidateList = candidateTable(CandidateList);
     character_ptr fuse_Monster(Monster);
-    index = callEntrypoint<int>("setTarget", fuse_Monster, luaCandidateList) - 1;
+    const int index = callEntrypoint<int>("setTarget", fuse_Monster, luaCandidateList) - 1;
 
     if (index >= 0 && index < (int)CandidateList.size()) {
         return CandidateList[index];
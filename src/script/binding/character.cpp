@@ -47,6 +47,12 @@ auto character() -> Binding<Character> {
         races.push_back(luabind::value(race.second.serverName.c_str(), race.first));
     });
 
+    luabind::value_vector attributes;
+
+    ranges::for_each(Character::attributeStringMap, [&attributes](const auto &attribute) {
+        attributes.push_back(luabind::value(attribute.second.c_str(), attribute.first));
+    });
+
     return luabind::class_<Character>("Character")
             .def("isNewPlayer", &Character::isNewPlayer)
             .def("pageGM", &Character::pageGM)
@@ -88,6 +94,7 @@ auto character() -> Binding<Character> {
             .def("getFaceTo", &Character::getFaceTo)
             .def("getType", &Character::getType)
             .def("createItem", create_item)
+            .def("batchItems", batch_items)
             .def("getLoot", getLoot)
             .def("increasePoisonValue", &Character::increasePoisonValue)
             .def("getPoisonValue", &Character::getPoisonValue)
@@ -106,19 +113,44 @@ auto character() -> Binding<Character> {
             .def("swapAtPos", &Character::swapAtPos)
             .def("createAtPos", &Character::createAtPos)
             .def("getItemAt", &Character::GetItemAt)
+            .def("getItemIdAt", &character_getItemIdAt, luabind::pure_out_value(_3))
+            .def("getWeaponAt", &character_getWeaponAt, luabind::pure_out_value(_3))
+            .def("getArmorAt", &character_getArmorAt, luabind::pure_out_value(_3))
+            .def("getArmorValues", &character_getArmorValues,
+                 luabind::pure_out_value(_2) + luabind::pure_out_value(_3) + luabind::pure_out_value(_4) +
+                         luabind::pure_out_value(_5))
             .enum_("skills")[skills]
             .def("getSkillName", &Character::getSkillName)
             .def("getSkill", &Character::getSkill)
             .def("getMinorSkill", &Character::getMinorSkill)
-            .def("increaseAttrib", &Character::increaseAttrib)
-            .def("setAttrib", &Character::setAttrib)
-            .def("isBaseAttributeValid", &Character::isBaseAttribValid)
+            .enum_("attributes")[attributes]
+            .def("increaseAttrib",
+                 (Attribute::attribute_t(Character::*)(const std::string &, int)) & Character::increaseAttrib)
+            .def("increaseAttrib",
+                 (Attribute::attribute_t(Character::*)(Character::attributeIndex, int)) & Character::increaseAttrib)
+            .def("setAttrib", (void (Character::*)(const std::string &, Attribute::attribute_t)) & Character::setAttrib)
+            .def("setAttrib",
+                 (void (Character::*)(Character::attributeIndex, Attribute::attribute_t)) & Character::setAttrib)
+            .def("isBaseAttributeValid", (bool (Character::*)(const std::string &, Attribute::attribute_t) const) &
+                                                 Character::isBaseAttribValid)
+            .def("isBaseAttributeValid",
+                 (bool (Character::*)(Character::attributeIndex, Attribute::attribute_t) const) &
+                         Character::isBaseAttribValid)
             .def("getBaseAttributeSum", &Character::getBaseAttributeSum)
             .def("getMaxAttributePoints", &Character::getMaxAttributePoints)
             .def("saveBaseAttributes", &Character::saveBaseAttributes)
-            .def("setBaseAttribute", &Character::setBaseAttrib)
-            .def("getBaseAttribute", &Character::getBaseAttrib)
-            .def("increaseBaseAttribute", &Character::increaseBaseAttrib)
+            .def("setBaseAttribute",
+                 (bool (Character::*)(const std::string &, Attribute::attribute_t)) & Character::setBaseAttrib)
+            .def("setBaseAttribute",
+                 (bool (Character::*)(Character::attributeIndex, Attribute::attribute_t)) & Character::setBaseAttrib)
+            .def("getBaseAttribute",
+                 (Attribute::attribute_t(Character::*)(const std::string &) const) & Character::getBaseAttrib)
+            .def("getBaseAttribute",
+                 (Attribute::attribute_t(Character::*)(Character::attributeIndex) const) & Character::getBaseAttrib)
+            .def("increaseBaseAttribute",
+                 (bool (Character::*)(const std::string &, int)) & Character::increaseBaseAttrib)
+            .def("increaseBaseAttribute",
+                 (bool (Character::*)(Character::attributeIndex, int)) & Character::increaseBaseAttrib)
             .def("increaseSkill", &Character::increaseSkill)
             .def("increaseMinorSkill", &Character::increaseMinorSkill)
             .def("setSkill", &Character::setSkill)
@@ -135,6 +167,9 @@ auto character() -> Binding<Character> {
             .def("teachMagic", &Character::teachMagic)
             .def("isInRange", &Character::isInRange)
             .def("isInRangeToPosition", &Character::isInRangeToField)
+            .def("isInRangeToXYZ", &character_isInRangeToXYZ)
+            .def("getPositionXYZ", &character_getPositionXYZ,
+                 luabind::pure_out_value(_2) + luabind::pure_out_value(_3) + luabind::pure_out_value(_4))
             .def("distanceMetric", &Character::distanceMetric)
             .def("distanceMetricToPosition", &Character::distanceMetricToPosition)
             .def("getMagicType", &Character::getMagicType)
@@ -32,6 +32,7 @@ auto crafting_dialog() -> Binding<CraftingDialog> {
                              luabind::value("playerCraftingComplete", CraftingDialog::playerCraftingComplete),
                              luabind::value("playerCraftingAborted", CraftingDialog::playerCraftingAborted)]
             .def(luabind::constructor<std::string, uint16_t, uint16_t, luabind::object>())
+            .def(luabind::constructor<const CraftingDialog &, luabind::object>())
             .def("clearGroupsAndProducts", &CraftingDialog::clearGroupsAndProducts)
             .def("addGroup", &CraftingDialog::addGroup)
             .def("addCraftable",
@@ -33,6 +33,7 @@ auto merchant_dialog() -> Binding<MerchantDialog> {
                                luabind::value("listBuyPrimary", MerchantDialog::listBuyPrimary),
                                luabind::value("listBuySecondary", MerchantDialog::listBuySecondary)]
             .def(luabind::constructor<std::string, luabind::object>())
+            .def(luabind::constructor<const MerchantDialog &, luabind::object>())
             .def("addOffer", (void (MerchantDialog::*)(TYPE_OF_ITEM_ID, const std::string &, TYPE_OF_WORTH)) &
                                      MerchantDialog::addOffer)
             .def("addOffer",
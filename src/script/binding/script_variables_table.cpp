@@ -29,6 +29,8 @@ namespace binding {
 auto script_variables_table() -> Binding<ScriptVariablesTable> {
     return luabind::class_<ScriptVariablesTable>("ScriptVariables")
             .def("find", &ScriptVariablesTable::find, luabind::pure_out_value(_3))
+            .def("findNumber", &ScriptVariablesTable::findNumber, luabind::pure_out_value(_3))
+            .def("increment", &ScriptVariablesTable::increment)
             .def("set",
                  (void (ScriptVariablesTable::*)(const std::string &, const std::string &)) & ScriptVariablesTable::set)
             .def("set", (void (ScriptVariablesTable::*)(const std::string &, int32_t)) & ScriptVariablesTable::set)
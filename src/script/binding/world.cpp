@@ -31,6 +31,7 @@ namespace binding {
 auto world() -> Binding<World> {
     return luabind::class_<World>("World")
             .def("LoS", &world_LuaLoS)
+            .def("hasLineOfSight", &World::hasLineOfSight)
             .def("deleteNPC", &World::deleteNPC)
             .def("createDynamicNPC", &World::createDynamicNPC)
             .def("getPlayersOnline", &world_getPlayersOnline)
@@ -39,6 +40,14 @@ auto world() -> Binding<World> {
             .def("getPlayersInRangeOf", &world_getPlayersInRangeOf)
             .def("getMonstersInRangeOf", &world_getMonstersInRangeOf)
             .def("getNPCSInRangeOf", &world_getNPCSInRangeOf)
+            .def("countCharactersInRangeOf", &World::countCharactersInRangeOf)
+            .def("countPlayersInRangeOf", &World::countPlayersInRangeOf)
+            .def("countMonstersInRangeOf", &World::countMonstersInRangeOf)
+            .def("countNPCSInRangeOf", &World::countNPCSInRangeOf)
+            .def("findCharacterInRangeOf", &world_findCharacterInRangeOf)
+            .def("findPlayerInRangeOf", &world_findPlayerInRangeOf)
+            .def("findMonsterInRangeOf", &world_findMonsterInRangeOf)
+            .def("findNPCInRangeOf", &world_findNPCInRangeOf)
             .def("getArmorStruct", &World::getArmorStruct, luabind::pure_out_value(_3))
             .def("getWeaponStruct", &World::getWeaponStruct, luabind::pure_out_value(_3))
             .def("getNaturalArmor", &World::getNaturalArmor, luabind::pure_out_value(_3))
@@ -46,6 +55,7 @@ auto world() -> Binding<World> {
             .def("changeQuality", &World::changeQuality)
             .def("changeItem", &World::changeItem)
             .def("isCharacterOnField", &World::isCharacterOnField)
+            .def("isCharacterOnFieldXYZ", &world_isCharacterOnFieldXYZ)
             .def("getCharacterOnField", &World::getCharacterOnField)
             .def("getField", &world_fieldAt)
             .def("makePersistentAt", &World::makePersistentAt)
@@ -65,9 +75,14 @@ auto world() -> Binding<World> {
             .def("setWeather", &World::setWeather)
             .def("isItemOnField", &World::isItemOnField)
             .def("getItemOnField", &World::getItemOnField)
+            .def("getFieldsInArea", &world_getFieldsInArea)
+            .def("findItemsInArea", &world_findItemsInArea)
             .def("changeTile", &World::changeTile)
             .def("getItemName", &World::getItemName)
             .def("createSavedArea", &World::createSavedArea)
+            .def("saveMapTemplate", &World::saveMapTemplate)
+            .def("createMapInstance", &World::createMapInstance)
+            .def("removeMapInstance", &World::removeMapInstance)
             .def("broadcast", &World::broadcast)
             .def("sendMonitoringMessage", &World::sendMonitoringMessage)
             .def_readwrite("weather", &World::weather);
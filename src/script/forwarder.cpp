@@ -135,6 +135,11 @@ auto create_item(Character *character, Item::id_type id, Item::number_type numbe
     return character->createItem(id, number, quality, convert_to_map(data).get());
 }
 
+void batch_items(Character *character, const luabind::object &operations) {
+    const Character::ItemBatch batch(*character);
+    luabind::call_function<void>(operations);
+}
+
 auto getLoot(const Character *character) -> luabind::object {
     lua_State *_luaState = LuaScript::getLuaState();
     luabind::object lootTable = luabind::newtable(_luaState);
@@ -205,6 +210,10 @@ auto world_fieldAt(World *world, const position &pos) -> map::Field * {
     }
 }
 
+auto world_isCharacterOnFieldXYZ(const World *world, Coordinate x, Coordinate y, Coordinate z) -> bool {
+    return world->isCharacterOnField(position(x, y, z));
+}
+
 auto world_createFromId(World *world, TYPE_OF_ITEM_ID id, unsigned short int count, position pos, bool always,
                         int quali, const luabind::object &data) -> ScriptItem {
     return world->createFromId(id, count, pos, always, quali, convert_to_map(data).get());
@@ -212,6 +221,69 @@ auto world_createFromId(World *world, TYPE_OF_ITEM_ID id, unsigned short int cou
 
 void log_lua(const std::string &message) { Logger::info(LogFacility::Script) << message << Log::end; }
 
+void character_getPositionXYZ(const Character *character, Coordinate &x, Coordinate &y, Coordinate &z) {
+    const auto &pos = character->getPosition();
+    x = pos.x;
+    y = pos.y;
+    z = pos.z;
+}
+
+auto character_isInRangeToXYZ(const Character *character, Coordinate x, Coordinate y, Coordinate z,
+                              Coordinate distance) -> bool {
+    return character->isInRangeToField(position(x, y, z), distance);
+}
+
+auto character_getItemIdAt(const Character *character, unsigned char itempos, Item::number_type &number)
+        -> Item::id_type {
+    if (itempos >= character->items.size()) {
+        number = 0;
+        return 0;
+    }
+
+    const auto &item = character->items[itempos];
+    number = item.getNumber();
+    return item.getId();
+}
+
+auto character_getWeaponAt(const Character *character, unsigned char itempos, WeaponStruct &weapon) -> bool {
+    if (itempos >= MAX_BODY_ITEMS) {
+        return false;
+    }
+
+    const auto *entry = character->getEquipment().weapons[itempos];
+
+    if (entry == nullptr) {
+        return false;
+    }
+
+    weapon = *entry;
+    return true;
+}
+
+auto character_getArmorAt(const Character *character, unsigned char itempos, ArmorStruct &armor) -> bool {
+    if (itempos >= MAX_BODY_ITEMS) {
+        return false;
+    }
+
+    const auto *entry = character->getEquipment().armors[itempos];
+
+    if (entry == nullptr) {
+        return false;
+    }
+
+    armor = *entry;
+    return true;
+}
+
+void character_getArmorValues(const Character *character, int &puncture, int &stroke, int &thrust,
+                              int &magicDisturbance) {
+    const auto &equipment = character->getEquipment();
+    puncture = equipment.punctureArmor;
+    stroke = equipment.strokeArmor;
+    thrust = equipment.thrustArmor;
+    magicDisturbance = equipment.magicDisturbance;
+}
+
 auto character_getItemList(Character *character, TYPE_OF_ITEM_ID id) -> luabind::object {
     auto items = character->getItemList(id);
     lua_State *_luaState = LuaScript::getLuaState();
@@ -329,6 +401,63 @@ auto world_getNPCSInRangeOf(const World *world, const position &posi, uint8_t ra
     return convert_to_fuselist(world->getNPCSInRangeOf(posi, range));
 }
 
+// the candidates are collected first, accept may move characters and with it change the containers
+template <typename Container>
+auto find_first(const Container &candidates, const luabind::object &accept) -> character_ptr {
+    for (auto *candidate : candidates) {
+        character_ptr character(candidate);
+
+        if (luabind::call_function<bool>(accept, character)) {
+            return character;
+        }
+    }
+
+    return {};
+}
+
+auto world_findCharacterInRangeOf(const World *world, const position &posi, uint8_t range,
+                                  const luabind::object &accept) -> character_ptr {
+    return find_first(world->getCharactersInRangeOf(posi, range), accept);
+}
+
+auto world_findPlayerInRangeOf(const World *world, const position &posi, uint8_t range,
+                               const luabind::object &accept) -> character_ptr {
+    return find_first(world->getPlayersInRangeOf(posi, range), accept);
+}
+
+auto world_findMonsterInRangeOf(const World *world, const position &posi, uint8_t range,
+                                const luabind::object &accept) -> character_ptr {
+    return find_first(world->getMonstersInRangeOf(posi, range), accept);
+}
+
+auto world_findNPCInRangeOf(const World *world, const position &posi, uint8_t range, const luabind::object &accept)
+        -> character_ptr {
+    return find_first(world->getNPCSInRangeOf(posi, range), accept);
+}
+
+auto world_getFieldsInArea(World *world, const position &pos, uint8_t radius) -> luabind::object {
+    luabind::object list = luabind::newtable(LuaScript::getLuaState());
+    int index = 1;
+
+    for (auto *field : world->getFieldsInArea(pos, radius)) {
+        list[index++] = field;
+    }
+
+    return list;
+}
+
+auto world_findItemsInArea(const World *world, const position &pos, uint8_t radius, TYPE_OF_ITEM_ID id)
+        -> luabind::object {
+    luabind::object list = luabind::newtable(LuaScript::getLuaState());
+    int index = 1;
+
+    for (const auto &item : world->findItemsInArea(pos, radius, id)) {
+        list[index++] = item;
+    }
+
+    return list;
+}
+
 auto field_isWarp(const map::Field *field, position &target) -> bool {
     field->getWarp(target);
     return field->isWarp();
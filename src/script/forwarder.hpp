@@ -52,6 +52,8 @@ auto create_item(Character * /*character*/, Item::id_type id, Item::number_type
                  const luabind::object & /*data*/) -> int;
 
 auto getLoot(const Character *character) -> luabind::object;
+// calls operations with the item updates of the character held back until it returns
+void batch_items(Character *character, const luabind::object &operations);
 
 auto container_count_item1(Container * /*container*/, Item::id_type /*id*/) -> int;
 auto container_count_item2(Container * /*container*/, Item::id_type /*id*/, const luabind::object &data) -> int;
@@ -61,6 +63,7 @@ auto container_erase_item2(Container * /*container*/, Item::id_type /*id*/, Item
                            const luabind::object &data) -> int;
 
 auto world_fieldAt(World *world, const position &pos) -> map::Field *;
+auto world_isCharacterOnFieldXYZ(const World *world, Coordinate x, Coordinate y, Coordinate z) -> bool;
 auto world_createFromId(World *world, TYPE_OF_ITEM_ID id, unsigned short int count, position pos, bool always,
                         int quali, const luabind::object &data) -> ScriptItem;
 
@@ -68,6 +71,18 @@ void log_lua(const std::string &message);
 
 auto character_getItemList(Character * /*character*/, TYPE_OF_ITEM_ID id) -> luabind::object;
 
+// plain value variants of hot bindings, they return numbers instead of position and item userdata
+void character_getPositionXYZ(const Character *character, Coordinate &x, Coordinate &y, Coordinate &z);
+auto character_isInRangeToXYZ(const Character *character, Coordinate x, Coordinate y, Coordinate z,
+                              Coordinate distance) -> bool;
+auto character_getItemIdAt(const Character *character, unsigned char itempos, Item::number_type &number)
+        -> Item::id_type;
+// copies of the cached entries of the equipped items, false if the item in the slot is no weapon or no armor
+auto character_getWeaponAt(const Character *character, unsigned char itempos, WeaponStruct &weapon) -> bool;
+auto character_getArmorAt(const Character *character, unsigned char itempos, ArmorStruct &armor) -> bool;
+void character_getArmorValues(const Character *character, int &puncture, int &stroke, int &thrust,
+                              int &magicDisturbance);
+
 void waypointlist_addFromList(WaypointList *wpl, const luabind::object &list);
 auto waypointlist_getWaypoints(const WaypointList *wpl) -> luabind::object;
 
@@ -79,6 +94,18 @@ auto world_getCharactersInRangeOf(const World *world, const position &posi, uint
 auto world_getPlayersInRangeOf(const World *world, const position &posi, uint8_t range) -> luabind::object;
 auto world_getMonstersInRangeOf(const World *world, const position &posi, uint8_t range) -> luabind::object;
 auto world_getNPCSInRangeOf(const World *world, const position &posi, uint8_t range) -> luabind::object;
+// the first character in range for which accept returns true, accept is not called for the ones after it
+auto world_findCharacterInRangeOf(const World *world, const position &posi, uint8_t range,
+                                  const luabind::object &accept) -> character_ptr;
+auto world_findPlayerInRangeOf(const World *world, const position &posi, uint8_t range,
+                               const luabind::object &accept) -> character_ptr;
+auto world_findMonsterInRangeOf(const World *world, const position &posi, uint8_t range,
+                                const luabind::object &accept) -> character_ptr;
+auto world_findNPCInRangeOf(const World *world, const position &posi, uint8_t range, const luabind::object &accept)
+        -> character_ptr;
+auto world_getFieldsInArea(World *world, const position &pos, uint8_t radius) -> luabind::object;
+auto world_findItemsInArea(const World *world, const position &pos, uint8_t radius, TYPE_OF_ITEM_ID id)
+        -> luabind::object;
 
 auto field_isWarp(const map::Field *field, position &target) -> bool;
 #endif
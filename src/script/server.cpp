@@ -77,4 +77,24 @@ auto reload() -> bool {
 
     return success;
 }
+
+template <typename T>
+void reloadIfChanged(std::unique_ptr<T> &script, const std::string &file,
+                     const std::unordered_set<std::string> &modules) {
+    if (modules.count(file) > 0) {
+        loadScript(script, file);
+    }
+}
+
+void reloadChanged(const std::unordered_set<std::string> &modules) {
+    reloadIfChanged(standardFightingScript, "server.standardfighting", modules);
+    reloadIfChanged(lookAtPlayerScript, "server.playerlookat", modules);
+    reloadIfChanged(lookAtItemScript, "server.itemlookat", modules);
+    reloadIfChanged(playerDeathScript, "server.playerdeath", modules);
+    reloadIfChanged(playerTalkScript, "server.playertalk", modules);
+    reloadIfChanged(depotScript, "server.depot", modules);
+    reloadIfChanged(loginScript, "server.login", modules);
+    reloadIfChanged(logoutScript, "server.logout", modules);
+    reloadIfChanged(learnScript, "server.learn", modules);
+}
 } // namespace script::server
@@ -31,6 +31,9 @@
 #include "script/LuaPlayerTalkScript.hpp"
 #include "script/LuaWeaponScript.hpp"
 
+#include <string>
+#include <unordered_set>
+
 namespace script::server {
 auto depot() -> LuaDepotScript &;
 auto lookAtPlayer() -> LuaLookAtPlayerScript &;
@@ -43,6 +46,8 @@ auto learn() -> LuaLearnScript &;
 auto fighting() -> LuaWeaponScript &;
 
 auto reload() -> bool;
+// reloads only the server scripts loaded from the given modules
+void reloadChanged(const std::unordered_set<std::string> &modules);
 } // namespace script::server
 
 #endif
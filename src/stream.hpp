@@ -21,25 +21,39 @@
 
 #include <cstring>
 #include <fstream>
+#include <istream>
+#include <ostream>
+#include <streambuf>
 #include <string>
 #include <type_traits>
 
-inline void readFromStream(std::ifstream &stream, char *output, std::size_t size) { stream.read(output, size); }
+inline void readFromStream(std::istream &stream, char *output, std::size_t size) { stream.read(output, size); }
 
-inline void writeToStream(std::ofstream &stream, const char *input, std::size_t size) { stream.write(input, size); }
+inline void writeToStream(std::ostream &stream, const char *input, std::size_t size) { stream.write(input, size); }
 
-template <typename T> void readFromStream(std::ifstream &stream, T &output) {
+template <typename T> void readFromStream(std::istream &stream, T &output) {
     static_assert(std::is_trivially_copyable_v<T>); // avoid UB with memcpy
     std::string buffer(sizeof(T), '\0');
     readFromStream(stream, buffer.data(), sizeof(T));
     std::memcpy(&output, buffer.data(), sizeof(T));
 }
 
-template <typename T> void writeToStream(std::ofstream &stream, const T &input) {
+template <typename T> void writeToStream(std::ostream &stream, const T &input) {
     static_assert(std::is_trivially_copyable_v<T>); // avoid UB with memcpy
     std::string buffer(sizeof(T), '\0');
     std::memcpy(buffer.data(), &input, sizeof(T));
     writeToStream(stream, buffer.data(), sizeof(T));
 }
 
+// read-only stream buffer over memory owned by someone else, e.g. a mapped file
+class MemoryInputBuffer : public std::streambuf {
+public:
+    MemoryInputBuffer(const char *begin, const char *end) {
+        // std::streambuf only offers a non-const interface, but get areas are never written to
+        auto *first = const_cast<char *>(begin); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+        auto *last = const_cast<char *>(end);    // NOLINT(cppcoreguidelines-pro-type-const-cast)
+        setg(first, first, last);
+    }
+};
+
 #endif
@@ -27,9 +27,14 @@ using namespace std::chrono_literals;
 
 constexpr auto reduceMentalCapacityInterval = 10s;
 constexpr auto checkMonitoringClientsInterval = 250ms;
+constexpr auto monitoringSnapshotInterval = 10s;
 constexpr auto scheduledScriptsInterval = 100ms;
 constexpr auto wearReductionInterval = 3min;
+constexpr auto memoryEstimateInterval = 5min;
+// the online player list is kept up to date row by row, rewriting it as a whole only mends missed updates
+constexpr auto playerListReconcileInterval = 10min;
 constexpr auto gameLoopInterval = 100ms;
+constexpr auto persistentFieldWriteDelay = 500ms;
 constexpr auto ingameTimeUpdateInterval = 8h;
 
 constexpr auto PLAYER_SAVE_INTERVAL = 60;
@@ -37,6 +42,10 @@ constexpr auto CLIENT_TIMEOUT = 50;
 
 // how many players to process each turn (maximum)
 constexpr auto MAXPLAYERSPROCESSED = 5;
+// longest sleep of the main loop, shutdown requested from a signal handler cannot wake it earlier
+constexpr auto maxIdleWait = std::chrono::seconds(1);
+// longest Lua garbage collection done at once while the main loop waits for the next task
+constexpr auto maxIdleCollection = std::chrono::milliseconds(5);
 
 constexpr auto MIN_AP_UPDATE = 100;
 
@@ -94,6 +103,8 @@ constexpr double runningMoveTimeMultiplier = 0.6;
 constexpr double randomMonsterMoveProbability = 0.2;
 constexpr auto monsterSelfHealAmount = 150;
 constexpr uint8_t monsterViewRange = 9;
+// below this many awake monsters per core, spreading their perception over threads costs more than it saves
+constexpr auto minMonstersPerWorker = 64;
 
 constexpr auto screenRange = 14;
 constexpr auto whisperRange = 2;
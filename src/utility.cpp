@@ -32,6 +32,12 @@ auto comparestrings_nocase(const std::string &s1, const std::string &s2) -> bool
     return equal(s1.begin(), s1.end(), s2.begin(), mypred);
 }
 
+auto fold_case(const std::string &s) -> std::string {
+    std::string folded(s);
+    std::transform(folded.begin(), folded.end(), folded.begin(), [](char c) { return static_cast<char>(tolower(c)); });
+    return folded;
+}
+
 auto to_direction(uint8_t dir) -> direction {
     if (dir < dir_none) {
         return static_cast<direction>(dir);
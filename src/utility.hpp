@@ -23,6 +23,8 @@
 
 extern auto mypred(char c1, char c2) -> bool;
 extern auto comparestrings_nocase(const std::string &s1, const std::string &s2) -> bool;
+// strings compare equal with comparestrings_nocase iff their folded copies are equal
+extern auto fold_case(const std::string &s) -> std::string;
 extern auto to_direction(uint8_t dir) -> direction;
 
 template <class T> struct iterator_range {
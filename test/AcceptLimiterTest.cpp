@@ -0,0 +1,65 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AcceptLimiter.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+TEST(AcceptLimiterTest, limitsBurstPerAddress) {
+    AcceptLimiter limiter(0, 1, 3);
+    const auto now = AcceptLimiter::Clock::now();
+
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(limiter.allow("10.0.0.1", now));
+    }
+
+    EXPECT_FALSE(limiter.allow("10.0.0.1", now));
+    EXPECT_TRUE(limiter.allow("10.0.0.2", now));
+    EXPECT_TRUE(limiter.allow("10.0.0.1", now + 1s));
+    EXPECT_EQ(1U, limiter.rejectedPerAddress());
+    EXPECT_EQ(0U, limiter.rejectedGlobally());
+}
+
+TEST(AcceptLimiterTest, limitsGlobally) {
+    AcceptLimiter limiter(2, 0, 0);
+    const auto now = AcceptLimiter::Clock::now();
+
+    EXPECT_TRUE(limiter.allow("10.0.0.1", now));
+    EXPECT_TRUE(limiter.allow("10.0.0.2", now));
+    EXPECT_FALSE(limiter.allow("10.0.0.3", now));
+    EXPECT_TRUE(limiter.allow("10.0.0.3", now + 500ms));
+    EXPECT_EQ(1U, limiter.rejectedGlobally());
+    EXPECT_EQ(0U, limiter.trackedAddresses());
+}
+
+TEST(AcceptLimiterTest, forgetsIdleAddresses) {
+    AcceptLimiter limiter(0, 1, 2);
+    const auto now = AcceptLimiter::Clock::now();
+
+    EXPECT_TRUE(limiter.allow("10.0.0.1", now));
+    EXPECT_EQ(1U, limiter.trackedAddresses());
+    EXPECT_TRUE(limiter.allow("10.0.0.2", now + 2min));
+    EXPECT_EQ(1U, limiter.trackedAddresses());
+}
+
+auto main(int argc, char **argv) -> int {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,60 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AllocationScope.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+// thread local, so that the threads of the server do not disturb the counts of a test
+thread_local uint64_t allocated = 0;
+thread_local uint64_t freed = 0;
+thread_local uint64_t allocatedBytes = 0;
+} // namespace
+
+// the array forms and nothrow forms of the standard library call these
+auto operator new(size_t size) -> void * {
+    ++allocated;
+    allocatedBytes += size;
+
+    if (void *memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    if (memory != nullptr) {
+        ++freed;
+    }
+
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t /*size*/) noexcept { operator delete(memory); }
+
+AllocationScope::AllocationScope()
+        : allocationsBefore(allocated), deallocationsBefore(freed), bytesBefore(allocatedBytes) {}
+
+auto AllocationScope::allocations() const -> uint64_t { return allocated - allocationsBefore; }
+
+auto AllocationScope::deallocations() const -> uint64_t { return freed - deallocationsBefore; }
+
+auto AllocationScope::bytes() const -> uint64_t { return allocatedBytes - bytesBefore; }
@@ -0,0 +1,40 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ALLOCATION_SCOPE_HPP
+#define ALLOCATION_SCOPE_HPP
+
+#include <cstdint>
+
+// Counts what the current thread allocates through operator new while the scope exists, scopes may nest. Tests using
+// it have to link AllocationScope.cpp, which replaces the global operator new and delete, see run_test.
+class AllocationScope {
+public:
+    AllocationScope();
+
+    [[nodiscard]] auto allocations() const -> uint64_t;
+    [[nodiscard]] auto deallocations() const -> uint64_t;
+    [[nodiscard]] auto bytes() const -> uint64_t;
+
+private:
+    uint64_t allocationsBefore;
+    uint64_t deallocationsBefore;
+    uint64_t bytesBefore;
+};
+
+#endif
@@ -0,0 +1,124 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "AllocationScope.hpp"
+#include "CharacterContainer.hpp"
+#include "FrameArena.hpp"
+#include "LongTimeAction.hpp"
+#include "Player.hpp"
+#include "World.hpp"
+#include "map/Field.hpp"
+#include "netinterface/protocol/ServerCommands.hpp"
+
+#include <array>
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+// upper bounds for allocations on hot paths, raise them only together with the reason in the commit
+
+class MockWorld : public World {
+public:
+    MockWorld() { World::_self = this; }
+};
+
+// placed on its own, the world does not know it
+class StandingPlayer : public Player {
+public:
+    StandingPlayer(TYPE_OF_CHARACTER_ID id, const position &pos) {
+        setId(id);
+        setPosition(pos);
+    }
+};
+
+class AllocationTest : public ::testing::Test {
+public:
+    MockWorld world;
+};
+
+TEST_F(AllocationTest, moveAckAllocatesOneBlockAtMost) {
+    const position pos(1, 2, 3);
+    // the first command of an id sizes the pooled buffers
+    std::make_shared<MoveAckTC>(1, pos, NORMALMOVE, 0)->addHeader();
+
+    const AllocationScope scope;
+    ServerCommandPointer command = std::make_shared<MoveAckTC>(1, pos, NORMALMOVE, 0);
+    command->addHeader();
+    command.reset();
+
+    EXPECT_LE(scope.allocations(), 1U);
+}
+
+TEST_F(AllocationTest, visitingCharactersInScreenAllocatesNothing) {
+    std::vector<std::unique_ptr<StandingPlayer>> players;
+    CharacterContainer<Player> container;
+
+    for (TYPE_OF_CHARACTER_ID id = 1; id <= 100; ++id) {
+        const position pos(static_cast<Coordinate>(id % 10 * 3), static_cast<Coordinate>(id / 10 * 3), 0);
+        container.insert(players.emplace_back(std::make_unique<StandingPlayer>(id, pos)).get());
+    }
+
+    int visited = 0;
+    const AllocationScope scope;
+    container.forEachCharacterInScreen(position(10, 10, 0), [&visited](Player * /*player*/) { ++visited; });
+
+    EXPECT_EQ(0U, scope.allocations());
+    EXPECT_LT(0, visited);
+}
+
+TEST_F(AllocationTest, ageingAnEmptyFieldAllocatesNothing) {
+    map::Field field(position(1, 2, 3));
+
+    const AllocationScope scope;
+    field.age();
+
+    EXPECT_EQ(0U, scope.allocations());
+}
+
+TEST_F(AllocationTest, scratchListsOfATickGrownOnceAllocateNothing) {
+    constexpr TYPE_OF_CHARACTER_ID bigTick = 100000;
+    const auto fill = [](TYPE_OF_CHARACTER_ID count) {
+        auto ids = frame::makeVector<TYPE_OF_CHARACTER_ID>();
+
+        for (TYPE_OF_CHARACTER_ID id = 0; id < count; ++id) {
+            ids.push_back(id);
+        }
+
+        return ids.size();
+    };
+
+    fill(bigTick);
+    frame::resetArena();
+
+    const AllocationScope scope;
+    EXPECT_EQ(bigTick, fill(bigTick));
+    frame::resetArena();
+
+    EXPECT_EQ(0U, scope.allocations());
+}
+
+TEST(AllocationScopeTest, countsAllocationsOfTheScope) {
+    auto before = std::make_unique<int>(1);
+    const AllocationScope scope;
+    auto inside = std::make_unique<std::array<int, 4>>();
+    before.reset();
+
+    EXPECT_EQ(1U, scope.allocations());
+    EXPECT_EQ(1U, scope.deallocations());
+    EXPECT_EQ(sizeof(std::array<int, 4>), scope.bytes());
+}
@@ -20,6 +20,7 @@ public:
     MOCK_CONST_METHOD0(getType, short unsigned int());
     MOCK_CONST_METHOD0(getPosition, const position &());
     MOCK_CONST_METHOD0(to_string, std::string());
+    using Character::setName;
 };
 
 
@@ -66,6 +67,59 @@ TEST_F(CharacterContainerTest, find) {
     EXPECT_NE(nullptr, container.find(pos0));
 }
 
+TEST_F(CharacterContainerTest, findByName) {
+    character.setName("Tester");
+    container.insert(&character);
+    EXPECT_EQ(&character, container.find("tESTER"));
+    EXPECT_EQ(nullptr, container.find("Test"));
+    container.erase(42);
+    EXPECT_EQ(nullptr, container.find("Tester"));
+}
+
+TEST_F(CharacterContainerTest, findByHandle) {
+    EXPECT_EQ(nullptr, container.find(character.getHandle()));
+    container.insert(&character);
+    const auto handle = character.getHandle();
+    EXPECT_EQ(&character, container.find(handle));
+    container.erase(42);
+    EXPECT_EQ(nullptr, container.find(handle));
+    container.insert(&character);
+    EXPECT_EQ(nullptr, container.find(handle));
+    EXPECT_EQ(&character, container.find(character.getHandle()));
+}
+
+TEST_F(CharacterContainerTest, findAllCharactersInRangeOf) {
+    container.insert(&character);
+    EXPECT_EQ(1, container.findAllCharactersInRangeOf(position(-1, -1, 0), {1, 0}).size());
+    EXPECT_EQ(1, container.findAllCharactersInRangeOf(position(0, 0, 2), {0, 2}).size());
+    EXPECT_TRUE(container.findAllCharactersInRangeOf(position(-2, 0, 0), {1, 0}).empty());
+    EXPECT_TRUE(container.findAllCharactersInRangeOf(position(0, 0, 1), {5, 0}).empty());
+}
+
+TEST_F(CharacterContainerTest, findAllCharactersInRangeOfAppends) {
+    container.insert(&character);
+    std::vector<Character *> result;
+    container.findAllCharactersInRangeOf(pos0, {1, 0}, result);
+    container.findAllCharactersInRangeOf(pos0, {1, 0}, result);
+    EXPECT_EQ(2, result.size());
+}
+
+TEST_F(CharacterContainerTest, forEachCharacterInRangeOf) {
+    container.insert(&character);
+    int visited = 0;
+    container.forEachCharacterInRangeOf(pos0, {1, 0}, [&visited](Character * /*character*/) { ++visited; });
+    container.forEachCharacterInRangeOf(pos, {1, 0}, [&visited](Character * /*character*/) { ++visited; });
+    EXPECT_EQ(1, visited);
+}
+
+TEST_F(CharacterContainerTest, erase) {
+    container.insert(&character);
+    EXPECT_TRUE(container.erase(42));
+    EXPECT_FALSE(container.erase(42));
+    EXPECT_EQ(nullptr, container.find(pos0));
+    EXPECT_TRUE(container.findAllCharactersInRangeOf(pos0, {1, 0}).empty());
+}
+
 TEST_F(CharacterContainerTest, update) {
     container.update(&character, pos);
     EXPECT_EQ(0, container.size());
@@ -74,6 +128,27 @@ TEST_F(CharacterContainerTest, update) {
     EXPECT_EQ(1, container.size());
 }
 
+TEST_F(CharacterContainerTest, sleepAndWake) {
+    container.insert(&character);
+    EXPECT_EQ(&character, container.sleep(42, 7));
+    EXPECT_EQ(nullptr, container.sleep(42, 8));
+    ASSERT_NE(nullptr, container.findDormancy(42));
+    EXPECT_EQ(7, *container.findDormancy(42));
+
+    int visited = 0;
+    container.for_each_awake([&visited](Character * /*character*/) { ++visited; });
+    EXPECT_EQ(0, visited);
+
+    std::vector<TYPE_OF_CHARACTER_ID> dormant;
+    container.findDormantInRangeOf(pos0, 1, dormant);
+    EXPECT_EQ(std::vector<TYPE_OF_CHARACTER_ID>{42}, dormant);
+
+    EXPECT_EQ(&character, container.wake(42));
+    EXPECT_EQ(nullptr, container.findDormancy(42));
+    container.for_each_awake([&visited](Character * /*character*/) { ++visited; });
+    EXPECT_EQ(1, visited);
+}
+
 
 auto main(int argc, char **argv) -> int {
     ::testing::InitGoogleTest(&argc, argv);
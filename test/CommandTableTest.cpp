@@ -0,0 +1,61 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "CommandTable.hpp"
+
+#include <gtest/gtest.h>
+#include <string>
+
+TEST(CommandTableTest, findsEveryCommandAfterBuilding) {
+    CommandTable table;
+    constexpr int commandCount = 100;
+
+    for (int i = 0; i < commandCount; ++i) {
+        table["command" + std::to_string(i)] = [i](World * /*world*/, Player * /*player*/,
+                                                   const std::string & /*text*/) { return i % 2 == 0; };
+    }
+
+    table["c"] = table["command0"];
+    table.build();
+
+    for (int i = 0; i < commandCount; ++i) {
+        const auto *command = table.find("command" + std::to_string(i));
+        ASSERT_NE(nullptr, command);
+        EXPECT_EQ(i % 2 == 0, (*command)(nullptr, nullptr, ""));
+    }
+
+    ASSERT_NE(nullptr, table.find("c"));
+    EXPECT_TRUE((*table.find("c"))(nullptr, nullptr, ""));
+    EXPECT_EQ(nullptr, table.find("command"));
+    EXPECT_EQ(nullptr, table.find("command100"));
+    EXPECT_EQ(nullptr, table.find(""));
+}
+
+TEST(CommandTableTest, findsCommandsBeforeBuilding) {
+    CommandTable table;
+    table["gm"] = [](World * /*world*/, Player * /*player*/, const std::string & /*text*/) { return true; };
+
+    EXPECT_NE(nullptr, table.find("gm"));
+    EXPECT_EQ(nullptr, table.find("g"));
+}
+
+auto main(int argc, char **argv) -> int {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
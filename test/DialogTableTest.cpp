@@ -0,0 +1,77 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "dialog/DialogTable.hpp"
+
+#include <gtest/gtest.h>
+#include <memory>
+
+namespace {
+auto makeDialog() -> std::shared_ptr<Dialog> { return std::make_shared<Dialog>("title", "Dialog", luabind::object()); }
+} // namespace
+
+TEST(DialogTableTest, idsOfClosedDialogsStayInvalid) {
+    DialogTable table;
+    const auto first = table.open(makeDialog()).id;
+    EXPECT_NE(nullptr, table.get(first));
+
+    table.close(first);
+    EXPECT_EQ(nullptr, table.get(first));
+
+    const auto second = table.open(makeDialog()).id;
+    EXPECT_NE(first, second);
+    EXPECT_EQ(nullptr, table.get(first));
+    EXPECT_NE(nullptr, table.get(second));
+    EXPECT_EQ(1U, table.size());
+}
+
+TEST(DialogTableTest, oldestDialogExpiresWhenFull) {
+    DialogTable table;
+    const auto oldest = table.open(makeDialog());
+    EXPECT_FALSE(oldest.expired);
+
+    for (size_t i = 1; i < DialogTable::capacity; ++i) {
+        EXPECT_FALSE(table.open(makeDialog()).expired);
+    }
+
+    const auto newest = table.open(makeDialog());
+    EXPECT_TRUE(newest.expired);
+    EXPECT_EQ(oldest.id, newest.expiredId);
+    EXPECT_EQ(nullptr, table.get(oldest.id));
+    EXPECT_NE(nullptr, table.get(newest.id));
+    EXPECT_EQ(DialogTable::capacity, table.size());
+}
+
+TEST(DialogTableTest, closeIfReturnsClosedIds) {
+    DialogTable table;
+    const auto first = table.open(makeDialog()).id;
+    const auto second = table.open(makeDialog()).id;
+
+    const auto closed = table.closeIf([](const Dialog & /*dialog*/) { return true; });
+
+    ASSERT_EQ(2U, closed.size());
+    EXPECT_EQ(first, closed[0]);
+    EXPECT_EQ(second, closed[1]);
+    EXPECT_EQ(0U, table.size());
+}
+
+auto main(int argc, char **argv) -> int {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
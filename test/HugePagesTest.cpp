@@ -0,0 +1,43 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "HugePages.hpp"
+
+#include <gtest/gtest.h>
+#include <numeric>
+#include <vector>
+
+TEST(HugePagesTest, largeAndSmallBlocksWorkInEveryMode) {
+    for (const auto *mode : {"off", "transparent", "reserved"}) {
+        ASSERT_TRUE(hugepages::configure(mode));
+
+        std::vector<int, hugepages::Allocator<int>> small(100);
+        std::vector<int, hugepages::Allocator<int>> large(3 * 1024 * 1024);
+        std::iota(large.begin(), large.end(), 0);
+        large.resize(9 * 1024 * 1024, 1);
+
+        EXPECT_EQ(3 * 1024 * 1024 - 1, large[3 * 1024 * 1024 - 1]) << mode;
+        EXPECT_EQ(1, large.back()) << mode;
+        small.assign(large.begin(), large.begin() + 10);
+        EXPECT_EQ(9, small.back()) << mode;
+    }
+
+    EXPECT_FALSE(hugepages::configure("always"));
+    hugepages::configure("off");
+}
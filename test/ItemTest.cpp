@@ -135,6 +135,18 @@ TEST(ItemTest, setDataNumber) {
     EXPECT_EQ("7", item.getData("testKey"));
 }
 
+TEST(ItemTest, equalDataIgnoresOrderOfSetting) {
+    Item itemA;
+    Item itemB;
+    itemA.setData("b", "2");
+    itemA.setData("a", "1");
+    itemB.setData("a", "1");
+    itemB.setData("b", "2");
+    EXPECT_TRUE(itemA.equalData(itemB));
+    itemB.setData("c", "3");
+    EXPECT_FALSE(itemA.equalData(itemB));
+}
+
 TEST(ItemTest, setDataNullptr) {
     Item item;
     item.setData("testKey", "testValue");
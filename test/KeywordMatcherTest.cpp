@@ -0,0 +1,54 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "KeywordMatcher.hpp"
+
+#include <gtest/gtest.h>
+
+TEST(KeywordMatcherTest, findsKeywordsAnywhereIgnoringCase) {
+    const KeywordMatcher matcher({"greetings", "hello", "trade"});
+
+    EXPECT_TRUE(matcher.matches("Greetings, stranger!"));
+    EXPECT_TRUE(matcher.matches("well HELLO there"));
+    EXPECT_TRUE(matcher.matches("do you trade?"));
+    EXPECT_FALSE(matcher.matches("nice weather today"));
+    EXPECT_FALSE(matcher.matches("hell"));
+    EXPECT_FALSE(matcher.matches(""));
+}
+
+TEST(KeywordMatcherTest, followsFailureLinksIntoOverlappingKeywords) {
+    const KeywordMatcher matcher({"she", "hers", "his"});
+
+    EXPECT_TRUE(matcher.matches("ushers"));
+    EXPECT_TRUE(matcher.matches("this"));
+    EXPECT_TRUE(matcher.matches("shhis"));
+    EXPECT_FALSE(matcher.matches("sh hi er"));
+}
+
+TEST(KeywordMatcherTest, matchesNothingWithoutKeywords) {
+    const KeywordMatcher matcher({""});
+
+    EXPECT_TRUE(matcher.empty());
+    EXPECT_FALSE(matcher.matches("anything"));
+}
+
+auto main(int argc, char **argv) -> int {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
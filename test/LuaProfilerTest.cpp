@@ -0,0 +1,61 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "script/LuaProfiler.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+TEST(LuaProfilerTest, percentileIsCloseAboveTheSlowCalls) {
+    LuaProfiler::Entry entry("script", "entrypoint");
+
+    for (int i = 0; i < 990; ++i) {
+        entry.record(10us);
+    }
+
+    for (int i = 0; i < 10; ++i) {
+        entry.record(5ms);
+    }
+
+    EXPECT_EQ(1000U, entry.getCalls());
+    EXPECT_EQ(5ms, entry.getMax());
+    EXPECT_GE(entry.percentile(0.99), 10us);
+    EXPECT_LT(entry.percentile(0.99), 13us);
+    EXPECT_EQ(5ms, entry.percentile(1.0));
+}
+
+TEST(LuaProfilerTest, slowestSortsByTotalTime) {
+    auto &profiler = LuaProfiler::get();
+    profiler.entry("fast", "call").record(1ms);
+    profiler.entry("slow", "call").record(3ms);
+    profiler.entry("unused", "call");
+
+    const auto slowest = profiler.slowest(5);
+    ASSERT_EQ(2U, slowest.size());
+    EXPECT_EQ("slow", slowest[0]->getScript());
+    EXPECT_EQ("fast", slowest[1]->getScript());
+
+    profiler.reset();
+    EXPECT_TRUE(profiler.slowest(5).empty());
+}
+
+auto main(int argc, char **argv) -> int {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,60 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Metrics.hpp"
+
+#include <gmock/gmock.h>
+
+using ::testing::HasSubstr;
+
+TEST(MetricsTest, sameNameAndLabelsGiveSameMetric) {
+    auto &registry = metrics::Registry::get();
+    auto &first = registry.counter("test_events_total", "Events", "kind=\"a\"");
+    auto &second = registry.counter("test_events_total", "Events", "kind=\"a\"");
+    auto &other = registry.counter("test_events_total", "Events", "kind=\"b\"");
+
+    EXPECT_EQ(&first, &second);
+    EXPECT_NE(&first, &other);
+    EXPECT_THROW(registry.gauge("test_events_total", "Events", "kind=\"c\""), std::logic_error);
+}
+
+TEST(MetricsTest, exposesCountersAndCumulativeBuckets) {
+    auto &registry = metrics::Registry::get();
+    registry.counter("test_requests_total", "Requests").increment(3);
+    auto &histogram = registry.histogram("test_duration_seconds", "Durations", "",
+                                         {std::chrono::milliseconds(1), std::chrono::milliseconds(10)});
+    histogram.observe(std::chrono::microseconds(500));
+    histogram.observe(std::chrono::milliseconds(5));
+    histogram.observe(std::chrono::seconds(1));
+
+    const auto text = registry.exposition();
+
+    EXPECT_THAT(text, HasSubstr("# TYPE test_requests_total counter\ntest_requests_total 3\n"));
+    EXPECT_THAT(text, HasSubstr("test_duration_seconds_bucket{le=\"0.001000\"} 1\n"));
+    EXPECT_THAT(text, HasSubstr("test_duration_seconds_bucket{le=\"0.010000\"} 2\n"));
+    EXPECT_THAT(text, HasSubstr("test_duration_seconds_bucket{le=\"+Inf\"} 3\n"));
+    EXPECT_THAT(text, HasSubstr("test_duration_seconds_sum 1.005500\n"));
+    EXPECT_THAT(text, HasSubstr("test_duration_seconds_count 3\n"));
+    EXPECT_EQ(3, histogram.count());
+    EXPECT_EQ(std::chrono::milliseconds(10), histogram.quantile(0.5));
+}
+
+auto main(int argc, char **argv) -> int {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
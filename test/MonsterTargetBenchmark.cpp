@@ -0,0 +1,135 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Character.hpp"
+#include "World.hpp"
+#include "script/LuaMonsterScript.hpp"
+
+#include <array>
+#include <chrono>
+#include <gmock/gmock.h>
+#include <iostream>
+#include <vector>
+
+using ::testing::NiceMock;
+using ::testing::Return;
+
+class MockCharacter : public Character {
+public:
+    MOCK_CONST_METHOD0(getId, TYPE_OF_CHARACTER_ID());
+    MOCK_CONST_METHOD0(getType, unsigned short());
+    MOCK_CONST_METHOD0(to_string, std::string());
+    MOCK_CONST_METHOD2(inform, void(const std::string &, informType));
+    MOCK_CONST_METHOD3(inform, void(const std::string &, const std::string &, informType));
+};
+
+class MockWorld : public World {
+public:
+    MockWorld() { World::_self = this; }
+};
+
+namespace {
+constexpr size_t monsterCount = 200;
+constexpr size_t candidateCount = 8;
+constexpr int rounds = 50;
+
+const std::string script = "function setTarget(monster, candidates)\n"
+                           "    return #candidates\n"
+                           "end\n"
+                           "function setTargets(queries)\n"
+                           "    local decisions = {}\n"
+                           "    for i, query in ipairs(queries) do\n"
+                           "        decisions[i] = {inReach = #query.inReach, inView = #query.inView}\n"
+                           "    end\n"
+                           "    return decisions\n"
+                           "end\n"
+                           "return {setTarget = setTarget, setTargets = setTargets}";
+} // namespace
+
+class MonsterTargetBenchmark : public ::testing::Test {
+public:
+    MockWorld world;
+    std::array<NiceMock<MockCharacter>, monsterCount> monsters;
+    std::array<NiceMock<MockCharacter>, candidateCount> targets;
+    std::vector<Character *> inReach;
+    std::vector<Character *> inView;
+
+    MonsterTargetBenchmark() {
+        TYPE_OF_CHARACTER_ID id = 1;
+
+        for (auto &monster : monsters) {
+            ON_CALL(monster, getId()).WillByDefault(Return(id++));
+        }
+
+        for (auto &target : targets) {
+            ON_CALL(target, getId()).WillByDefault(Return(id++));
+            inView.push_back(&target);
+        }
+
+        inReach.assign(inView.begin(), inView.begin() + candidateCount / 2);
+    }
+
+    ~MonsterTargetBenchmark() override { LuaScript::shutdownLua(); }
+};
+
+TEST_F(MonsterTargetBenchmark, batchedCallChoosesLikeSingleCalls) {
+    LuaMonsterScript monsterScript{script, "monster_target_benchmark"};
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<Character *> single(monsterCount * 2);
+    const auto singleStart = Clock::now();
+
+    for (int round = 0; round < rounds; ++round) {
+        for (size_t i = 0; i < monsterCount; ++i) {
+            ASSERT_TRUE(monsterScript.setTarget(&monsters[i], inReach, single[2 * i]));
+            ASSERT_TRUE(monsterScript.setTarget(&monsters[i], inView, single[2 * i + 1]));
+        }
+    }
+
+    const auto singleTime = Clock::now() - singleStart;
+
+    std::vector<LuaMonsterScript::TargetQuery> queries;
+
+    for (auto &monster : monsters) {
+        queries.push_back({&monster, &inReach, &inView});
+    }
+
+    std::vector<LuaMonsterScript::TargetChoice> choices;
+    const auto batchedStart = Clock::now();
+
+    for (int round = 0; round < rounds; ++round) {
+        ASSERT_TRUE(monsterScript.setTargets(queries, choices));
+    }
+
+    const auto batchedTime = Clock::now() - batchedStart;
+
+    ASSERT_EQ(monsterCount, choices.size());
+
+    for (size_t i = 0; i < monsterCount; ++i) {
+        EXPECT_EQ(single[2 * i], choices[i].inReach);
+        EXPECT_EQ(single[2 * i + 1], choices[i].inView);
+    }
+
+    using std::chrono::microseconds;
+    const auto singleUs = std::chrono::duration_cast<microseconds>(singleTime).count();
+    const auto batchedUs = std::chrono::duration_cast<microseconds>(batchedTime).count();
+    RecordProperty("singleCallsUs", std::to_string(singleUs));
+    RecordProperty("batchedCallsUs", std::to_string(batchedUs));
+    std::cout << monsterCount << " monsters x " << rounds << " rounds: single calls " << singleUs << "us, batched "
+              << batchedUs << "us" << std::endl;
+}
@@ -0,0 +1,50 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ObjectPool.hpp"
+
+#include <gtest/gtest.h>
+
+TEST(ObjectPoolTest, releasedSlotsAreReused) {
+    ObjectPool pool("test", 24, 2);
+
+    auto *first = pool.allocate();
+    auto *second = pool.allocate();
+    EXPECT_NE(first, second);
+    EXPECT_EQ(1U, pool.getStats().slabs);
+
+    pool.deallocate(first);
+    EXPECT_EQ(first, pool.allocate());
+
+    auto *third = pool.allocate();
+    EXPECT_NE(first, third);
+    EXPECT_NE(second, third);
+
+    const auto &stats = pool.getStats();
+    EXPECT_EQ(2U, stats.slabs);
+    EXPECT_EQ(3U, stats.inUse);
+    EXPECT_EQ(3U, stats.peak);
+    EXPECT_EQ(4U, stats.allocations);
+    EXPECT_EQ(1U, stats.reuses);
+    EXPECT_EQ(0U, stats.slotSize % alignof(std::max_align_t));
+}
+
+auto main(int argc, char **argv) -> int {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,132 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "Scheduler.hpp"
+
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+struct TestClock {
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<TestClock>;
+    static constexpr bool is_steady = true;
+
+    static time_point current;
+    static auto now() -> time_point { return current; }
+};
+
+TestClock::time_point TestClock::current{};
+
+class SchedulerTest : public ::testing::Test {
+protected:
+    void advance(std::chrono::nanoseconds time) {
+        TestClock::current += time;
+        scheduler.run_once(0ns);
+    }
+
+    ClockBasedScheduler<TestClock> scheduler{TestClock::now()};
+};
+
+TEST_F(SchedulerTest, runsRecurringTaskEveryInterval) {
+    int runs = 0;
+    scheduler.addRecurringTask([&runs] { ++runs; }, 10ms, "recurring");
+
+    advance(9ms);
+    EXPECT_EQ(0, runs);
+    advance(1ms);
+    EXPECT_EQ(1, runs);
+    advance(25ms);
+    EXPECT_EQ(3, runs);
+}
+
+TEST_F(SchedulerTest, runsDistantTaskOnTime) {
+    int runs = 0;
+    scheduler.addOneshotTask([&runs] { ++runs; }, 70s, "distant");
+
+    advance(69999ms);
+    EXPECT_EQ(0, runs);
+    advance(1ms);
+    EXPECT_EQ(1, runs);
+    EXPECT_EQ(0U, scheduler.taskCount());
+}
+
+TEST_F(SchedulerTest, cancelsAndReschedules) {
+    int runs = 0;
+    auto cancelled = scheduler.addOneshotTask([&runs] { runs += 10; }, 5ms, "cancelled");
+    auto moved = scheduler.addOneshotTask([&runs] { ++runs; }, 5ms, "moved");
+    EXPECT_EQ("moved", scheduler.getName(moved));
+
+    EXPECT_TRUE(scheduler.cancel(cancelled));
+    EXPECT_FALSE(scheduler.cancel(cancelled));
+    EXPECT_TRUE(scheduler.reschedule(moved, 20ms));
+
+    advance(10ms);
+    EXPECT_EQ(0, runs);
+    advance(10ms);
+    EXPECT_EQ(1, runs);
+    EXPECT_FALSE(scheduler.reschedule(moved, 1ms));
+    EXPECT_EQ("", scheduler.getName(moved));
+}
+
+TEST_F(SchedulerTest, taskCancelsItself) {
+    int runs = 0;
+    TaskHandle handle;
+    handle = scheduler.addRecurringTask(
+            [this, &runs, &handle] {
+                ++runs;
+                scheduler.cancel(handle);
+            },
+            1ms, "self");
+
+    advance(5ms);
+    EXPECT_EQ(1, runs);
+    EXPECT_EQ(0U, scheduler.taskCount());
+}
+
+TEST(SchedulerWaitTest, signalBeforeWaitIsNotLost) {
+    ClockBasedScheduler<std::chrono::steady_clock> scheduler;
+    scheduler.signal();
+
+    const auto start = std::chrono::steady_clock::now();
+    scheduler.run_once(10s);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+}
+
+TEST(SchedulerWaitTest, taskAddedByOtherThreadShortensWait) {
+    ClockBasedScheduler<std::chrono::steady_clock> scheduler;
+    scheduler.addOneshotTask([] {}, 1h, "distant");
+
+    std::thread other([&scheduler] {
+        std::this_thread::sleep_for(10ms);
+        scheduler.addOneshotTask([] {}, 1ms, "soon");
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    scheduler.run_once(10s);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+    other.join();
+}
+
+auto main(int argc, char **argv) -> int {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,102 @@
+#include <gmock/gmock.h>
+#include "netinterface/protocol/ServerCommands.hpp"
+
+constexpr unsigned char TESTCOMMAND = 0x42;
+constexpr size_t HEADERSIZE = 6;
+
+auto dataOf(const BasicServerCommand &command) -> const unsigned char * {
+    return reinterpret_cast<const unsigned char *>(command.cmdData().data()) + HEADERSIZE;
+}
+
+TEST(ServerCommandTest, fieldsEncodeLikeSingleAdds) {
+    BasicServerCommand single(TESTCOMMAND);
+    single.addIntToBuffer(-2);
+    single.addShortIntToBuffer(-300);
+    single.addUnsignedCharToBuffer(7);
+    single.addStringToBuffer("hello");
+    single.addColourToBuffer(Colour(1, 2, 3));
+    single.addHeader();
+
+    BasicServerCommand fields(TESTCOMMAND);
+    fields.addFields(int32_t{-2}, int16_t{-300}, uint8_t{7}, std::string("hello"), Colour(1, 2, 3));
+    fields.addHeader();
+
+    ASSERT_EQ(single.getLength(), fields.getLength());
+    EXPECT_TRUE(std::equal(single.cmdData().begin(), single.cmdData().begin() + single.getLength(),
+                           fields.cmdData().begin()));
+}
+
+TEST(ServerCommandTest, decodeMoveAck) {
+    const position pos(-5, 12, 3);
+    MoveAckTC command(0xFE000001, pos, NORMALMOVE, 3 * Character::actionPointUnit + 1);
+
+    const auto [id, decodedPos, mode, duration] = schema::decode<uint32_t, position, uint8_t, int16_t>(dataOf(command));
+    EXPECT_EQ(0xFE000001, id);
+    EXPECT_EQ(pos, decodedPos);
+    EXPECT_EQ(NORMALMOVE, mode);
+    EXPECT_EQ(3 * Character::actionPointUnit, duration);
+    EXPECT_EQ(static_cast<int>(HEADERSIZE + schema::encodedSize(id, decodedPos, mode, duration)), command.getLength());
+}
+
+TEST(ServerCommandTest, decodeMultiMove) {
+    const position origin(100, -20, 0);
+    const std::vector<MultiMoveTC::Move> moves{{7, position(97, -18, 0), NORMALMOVE, 2 * Character::actionPointUnit},
+                                               {0xFE000001, position(110, -30, 1), RUNNING, 0}};
+    ASSERT_TRUE(MultiMoveTC::fits(origin, moves[1].pos));
+    EXPECT_FALSE(MultiMoveTC::fits(origin, position(228, -20, 0)));
+    MultiMoveTC command(origin, moves, CommandEncoding::standard);
+
+    constexpr size_t headerFields = 3 * sizeof(int16_t) + sizeof(uint16_t);
+    constexpr size_t moveFields = sizeof(int32_t) + 3 * sizeof(int8_t) + sizeof(uint8_t) + sizeof(int16_t);
+    const auto [decodedOrigin, count] = schema::decode<position, uint16_t>(dataOf(command));
+    EXPECT_EQ(origin, decodedOrigin);
+    EXPECT_EQ(2, count);
+
+    const auto *second = dataOf(command) + headerFields + moveFields;
+    const auto [id, dx, dy, dz, mode, duration] =
+            schema::decode<uint32_t, int8_t, int8_t, int8_t, uint8_t, int16_t>(second);
+    EXPECT_EQ(0xFE000001, id);
+    EXPECT_EQ(10, dx);
+    EXPECT_EQ(-10, dy);
+    EXPECT_EQ(1, dz);
+    EXPECT_EQ(RUNNING, mode);
+    EXPECT_EQ(0, duration);
+    EXPECT_EQ(static_cast<int>(HEADERSIZE + headerFields + 2 * moveFields), command.getLength());
+}
+
+TEST(ServerCommandTest, decodeCompactMultiMove) {
+    const position origin(100, -20, 0);
+    const std::vector<MultiMoveTC::Move> moves{
+            {0xFE000001, position(97, -18, 0), NORMALMOVE, 0},
+            {0xFE000003, position(101, -21, 0), RUNNING, Character::actionPointUnit}};
+    MultiMoveTC command(origin, moves, CommandEncoding::compact);
+
+    const auto *data = dataOf(command);
+    const auto [count, firstId] = schema::decode<schema::VarUint, schema::VarInt>(data);
+    EXPECT_EQ(2, count.value);
+    EXPECT_EQ(0xFE000001, static_cast<uint32_t>(firstId.value));
+
+    const size_t firstMove = schema::encodedSize(count, firstId) + 3 * sizeof(int8_t) + 2 * sizeof(uint8_t);
+    const auto [idStep, dx, dy, dz, mode, actionPoints] =
+            schema::decode<schema::VarInt, int8_t, int8_t, int8_t, uint8_t, schema::VarUint>(data + firstMove);
+    EXPECT_EQ(2, idStep.value);
+    EXPECT_EQ(1, dx);
+    EXPECT_EQ(-1, dy);
+    EXPECT_EQ(0, dz);
+    EXPECT_EQ(RUNNING, mode);
+    EXPECT_EQ(1, actionPoints.value);
+    EXPECT_EQ(static_cast<int>(HEADERSIZE + firstMove + 6), command.getLength());
+}
+
+TEST(ServerCommandTest, decodeSay) {
+    SayTC command(position(1, 2, 3), "some words");
+
+    const auto [pos, text] = schema::decode<position, std::string>(dataOf(command));
+    EXPECT_EQ(position(1, 2, 3), pos);
+    EXPECT_EQ("some words", text);
+}
+
+auto main(int argc, char **argv) -> int {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,61 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "netinterface/SessionRecording.hpp"
+#include "netinterface/protocol/ClientCommands.hpp"
+
+#include <cstdio>
+#include <gtest/gtest.h>
+
+TEST(SessionRecordingTest, readsWhatWasRecorded) {
+    const std::string path = "session_recording_test.log";
+    auto &recorder = SessionRecorder::get();
+    ASSERT_TRUE(recorder.start(path, 42));
+
+    auto command = makeClientCommand<PlayerSpinTS>();
+    command->setHeaderData(1, 0);
+    command->msg_data() = {dir_west};
+
+    recorder.login(7, position(1, -2, 3));
+    recorder.command(7, *command);
+    recorder.logout(7);
+    recorder.stop();
+    recorder.command(8, *command);
+
+    const auto recording = SessionRecording::read(path);
+    std::remove(path.c_str());
+
+    ASSERT_TRUE(recording);
+    EXPECT_EQ(42U, recording->seed);
+    ASSERT_EQ(3U, recording->records.size());
+
+    const auto &login = recording->records[0];
+    EXPECT_EQ(SessionRecording::login, login.kind);
+    EXPECT_EQ(7U, login.player);
+    EXPECT_EQ(position(1, -2, 3), login.pos);
+
+    const auto &spin = recording->records[1];
+    EXPECT_EQ(SessionRecording::command, spin.kind);
+    EXPECT_EQ(C_PLAYERSPIN_TS, spin.definition);
+    EXPECT_EQ(std::vector<unsigned char>{dir_west}, spin.payload);
+
+    EXPECT_EQ(SessionRecording::logout, recording->records[2].kind);
+    EXPECT_LE(login.time, recording->records[2].time);
+}
+
+TEST(SessionRecordingTest, rejectsOtherFiles) { EXPECT_FALSE(SessionRecording::read("no_such_recording.log")); }
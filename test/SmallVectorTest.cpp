@@ -0,0 +1,70 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "SmallVector.hpp"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <utility>
+
+TEST(SmallVectorTest, keepsElementsInPlaceUpToItsCapacity) {
+    SmallVector<std::string, 2> vector;
+    vector.push_back("one");
+    vector.emplace_back("two");
+
+    EXPECT_TRUE(vector.isInline());
+    EXPECT_EQ(0U, memory::of(vector));
+
+    vector.emplace_back(vector[0]);
+
+    EXPECT_FALSE(vector.isInline());
+    ASSERT_EQ(3U, vector.size());
+    EXPECT_EQ("one", vector[0]);
+    EXPECT_EQ("two", vector[1]);
+    EXPECT_EQ("one", vector.back());
+}
+
+TEST(SmallVectorTest, erasesAndMovesLikeAVector) {
+    SmallVector<std::unique_ptr<int>, 1> vector;
+
+    for (int i = 0; i < 4; ++i) {
+        vector.push_back(std::make_unique<int>(i));
+    }
+
+    auto next = vector.erase(vector.begin() + 1);
+    EXPECT_EQ(2, **next);
+
+    SmallVector<std::unique_ptr<int>, 1> moved(std::move(vector));
+    EXPECT_TRUE(vector.empty());
+    ASSERT_EQ(3U, moved.size());
+    EXPECT_EQ(0, *moved[0]);
+    EXPECT_EQ(3, *moved.back());
+
+    moved.pop_back();
+    moved.pop_back();
+    SmallVector<std::unique_ptr<int>, 1> single;
+    single.push_back(std::make_unique<int>(7));
+    moved = std::move(single);
+
+    ASSERT_EQ(1U, moved.size());
+    EXPECT_EQ(7, *moved.at(0));
+    EXPECT_TRUE(moved.isInline());
+    EXPECT_THROW(moved.at(1), std::out_of_range);
+}
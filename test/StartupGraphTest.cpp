@@ -0,0 +1,75 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "StartupGraph.hpp"
+
+#include <gtest/gtest.h>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+TEST(StartupGraphTest, runsStagesAfterTheirDependencies) {
+    StartupGraph graph;
+    std::mutex mutex;
+    std::vector<std::string> order;
+
+    const auto stage = [&](const std::string &name) {
+        return [&, name] {
+            const std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(name);
+            return true;
+        };
+    };
+
+    graph.add("database", {}, stage("database"));
+    graph.add("tables", {"database"}, stage("tables"));
+    graph.add("maps", {"tables"}, stage("maps"));
+    graph.add("scripts", {"tables"}, stage("scripts"));
+    graph.add("npcs", {"maps", "scripts"}, stage("npcs"));
+
+    ASSERT_TRUE(graph.run());
+    ASSERT_EQ(5, order.size());
+    EXPECT_EQ("database", order[0]);
+    EXPECT_EQ("tables", order[1]);
+    EXPECT_EQ("npcs", order[4]);
+    EXPECT_EQ(5, graph.timings().size());
+}
+
+TEST(StartupGraphTest, skipsStagesAfterAFailure) {
+    StartupGraph graph;
+    bool independentRan = false;
+    bool dependentRan = false;
+
+    graph.add("tables", {}, [] { return false; });
+    graph.add("maps", {}, [] () -> bool { throw std::runtime_error("no maps"); });
+    graph.add("skills", {}, [&independentRan] { return independentRan = true; });
+    graph.add("scripts", {"tables", "skills"}, [&dependentRan] { return dependentRan = true; });
+
+    EXPECT_FALSE(graph.run());
+    EXPECT_TRUE(independentRan);
+    EXPECT_FALSE(dependentRan);
+    EXPECT_EQ(3, graph.timings().size());
+    EXPECT_THROW(graph.add("npcs", {"unknown"}, [] { return true; }), std::logic_error);
+}
+
+auto main(int argc, char **argv) -> int {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,66 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "data/StructTable.hpp"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+template <typename IdType> class TestTable : public StructTable<IdType, int> {
+public:
+    void add(IdType id, int value) { this->emplace(id, value); }
+    void remove(IdType id) { this->erase(id); }
+
+protected:
+    [[nodiscard]] auto getTableName() const -> std::string override { return "test"; }
+    auto getColumnNames() -> std::vector<std::string> override { return {}; }
+    auto assignId(const TableRow & /*row*/) -> IdType override { return {}; }
+    auto assignTable(const TableRow & /*row*/) -> int override { return 0; }
+};
+
+TEST(StructTableTest, findsDenseIds) {
+    TestTable<uint16_t> table;
+    table.add(1, 10);
+    table.add(7, 70);
+    table.activateBuffer();
+
+    ASSERT_NE(nullptr, table.find(7));
+    EXPECT_EQ(70, *table.find(7));
+    EXPECT_EQ(nullptr, table.find(2));
+    EXPECT_EQ(nullptr, table.find(60000));
+
+    table.remove(7);
+    EXPECT_EQ(nullptr, table.find(7));
+    EXPECT_FALSE(table.exists(7));
+}
+
+TEST(StructTableTest, findsSparseAndNegativeIds) {
+    TestTable<int32_t> table;
+    table.add(-3, 30);
+    table.add(5000000, 50);
+    table.activateBuffer();
+
+    ASSERT_NE(nullptr, table.find(-3));
+    EXPECT_EQ(30, *table.find(-3));
+    ASSERT_NE(nullptr, table.find(5000000));
+    EXPECT_EQ(50, *table.find(5000000));
+    EXPECT_EQ(nullptr, table.find(4));
+}
+
+} // namespace
@@ -0,0 +1,37 @@
+//  illarionserver - server for the game Illarion
+//  Copyright 2011 Illarion e.V.
+//
+//  This file is part of illarionserver.
+//
+//  illarionserver is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  illarionserver is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "ThreadAffinity.hpp"
+
+#include <gtest/gtest.h>
+
+TEST(ThreadAffinityTest, parsesCoresAndRanges) {
+    const auto cores = affinity::parseCores("0-2,5,7-7");
+    ASSERT_TRUE(cores);
+    EXPECT_EQ((std::vector<unsigned int>{0, 1, 2, 5, 7}), *cores);
+    EXPECT_TRUE(affinity::parseCores("")->empty());
+}
+
+TEST(ThreadAffinityTest, rejectsMalformedLists) {
+    EXPECT_FALSE(affinity::parseCores("a"));
+    EXPECT_FALSE(affinity::parseCores("3-1"));
+    EXPECT_FALSE(affinity::parseCores("1-"));
+    EXPECT_FALSE(affinity::parseCores("1x"));
+    EXPECT_FALSE(affinity::parseCores("1,,2"));
+    EXPECT_FALSE(affinity::parseCores("100000"));
+}
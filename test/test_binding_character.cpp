@@ -471,6 +471,14 @@ TEST_F(monster_bindings, getMinorSkill) {
     EXPECT_EQ(74, result);
 }
 
+TEST_F(monster_bindings, getBaseAttributeByConstant) {
+    LuaTestSupportScript script {"function test(monster) return monster:getBaseAttribute(Character.strength) "
+                                 "== monster:getBaseAttribute('strength') end"};
+    monster->setBaseAttribute(Character::strength, 7);
+    bool result = script.test<bool, Monster *>(monster);
+    EXPECT_TRUE(result);
+}
+
 auto main(int argc, char **argv) -> int {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -38,14 +38,21 @@ public:
     MOCK_METHOD(bool, increase, (ScriptItem, int), (override));
     MOCK_METHOD(bool, swap, (ScriptItem, TYPE_OF_ITEM_ID, int), (override));
     MOCK_METHOD(std::list<BlockingObject>, blockingLineOfSight, (const position &, const position &), (const override));
+    MOCK_METHOD(bool, hasLineOfSight, (const position &, const position &), (const override));
     MOCK_METHOD(void, changeTile, (short int, const position &), (override));
     MOCK_METHOD(bool, createSavedArea, (uint16_t, const position &, uint16_t, uint16_t), (override));
+    MOCK_METHOD(bool, saveMapTemplate, (const position &, const std::string &), (override));
+    MOCK_METHOD(bool, createMapInstance, (const std::string &, const position &), (override));
+    MOCK_METHOD(bool, removeMapInstance, (const position &), (override));
     MOCK_METHOD(map::Field &, fieldAt, (const position &), (override));
     MOCK_METHOD(const map::Field &, fieldAt, (const position &), (const override));
     MOCK_METHOD(character_ptr, getCharacterOnField, (const position &), (const override));
     MOCK_METHOD(bool, isCharacterOnField, (const position &), (const override));
     MOCK_METHOD(ScriptItem, getItemOnField, (const position &), (override));
     MOCK_METHOD(bool, isItemOnField, (const position &), (override));
+    MOCK_METHOD(std::vector<map::Field *>, getFieldsInArea, (const position &, uint8_t), (override));
+    MOCK_METHOD(std::vector<ScriptItem>, findItemsInArea, (const position &, uint8_t, TYPE_OF_ITEM_ID),
+                (const override));
     MOCK_METHOD(void, makePersistentAt, (const position &), (override));
     MOCK_METHOD(void, removePersistenceAt, (const position &), (override));
     MOCK_METHOD(bool, isPersistentAt, (const position &), (const override));
@@ -142,6 +149,21 @@ TEST_F(world_bindings, getCharactersInRangeOf) {
     EXPECT_EQ(result, m3->getId());
 }
 
+TEST_F(world_bindings, findCharacterInRangeOfStopsAtTheFirstMatch) {
+    std::vector<Character *> chars{m1, m2, m3};
+    LuaTestSupportScript script{"function test(world)\n"
+                                "    local asked = 0\n"
+                                "    local found = world:findCharacterInRangeOf(position(2, 3, 5), 42, function(char)\n"
+                                "        asked = asked + 1\n"
+                                "        return char.id == 2\n"
+                                "    end)\n"
+                                "    return asked * 10 + found.id\n"
+                                "end"};
+    EXPECT_CALL(world, getCharactersInRangeOf(position(2, 3, 5), 42)).WillOnce(Return(chars));
+    auto result = script.test<TYPE_OF_CHARACTER_ID, World *>(&world);
+    EXPECT_EQ(result, 22);
+}
+
 TEST_F(world_bindings, getMonstersInRangeOf) {
     std::vector<Monster *> chars{m1, m2, m3};
     LuaTestSupportScript script{
@@ -347,6 +369,14 @@ TEST_F(world_bindings, blockingLineOfSight) {
     EXPECT_EQ(result, "CHARACTER");
 }
 
+TEST_F(world_bindings, hasLineOfSight) {
+    LuaTestSupportScript script{"function test(world) return world:hasLineOfSight(position(2, 3, 5), position(4, 3, "
+                                "5)) end"};
+    EXPECT_CALL(world, hasLineOfSight(position(2, 3, 5), position(4, 3, 5))).WillOnce(Return(true));
+    auto result = script.test<bool, World *>(&world);
+    EXPECT_TRUE(result);
+}
+
 TEST_F(world_bindings, changeTile) {
     LuaTestSupportScript script{"function test(world) world:changeTile(-7, position(2, 3, 5)) end"};
     EXPECT_CALL(world, changeTile(-7, position(2, 3, 5)));
@@ -398,6 +428,13 @@ TEST_F(world_bindings, isItemOnField) {
     EXPECT_TRUE(result);
 }
 
+TEST_F(world_bindings, findItemsInArea) {
+    LuaTestSupportScript script{"function test(world) return #world:findItemsInArea(position(2, 3, 5), 4, 42) end"};
+    EXPECT_CALL(world, findItemsInArea(position(2, 3, 5), 4, 42)).WillOnce(Return(std::vector<ScriptItem>(3)));
+    auto result = script.test<int, World *>(&world);
+    EXPECT_EQ(3, result);
+}
+
 TEST_F(world_bindings, makePersistentAt) {
     LuaTestSupportScript script{"function test(world) world:makePersistentAt(position(2, 3, 5)) end"};
     EXPECT_CALL(world, makePersistentAt(position(2, 3, 5)));
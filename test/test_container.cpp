@@ -70,6 +70,26 @@ TEST_F(container_tests, eraseItemWithoutDataDoesntDeleteDataItem) {
 	EXPECT_EQ(8, container.eraseItem(itemid_1, 10));
 }
 
+TEST_F(container_tests, countFollowsChangesOfCountedItems) {
+	Item it1{itemid_1, 5, 0};
+	EXPECT_TRUE(container.InsertItem(it1, TYPE_OF_CONTAINERSLOTS(3)));
+	EXPECT_EQ(5, container.countItem(itemid_1));
+	EXPECT_EQ(0, container.getFirstFreeSlot());
+
+	EXPECT_TRUE(container.swapAtPos(3, itemid_2));
+	EXPECT_EQ(0, container.countItem(itemid_1));
+	EXPECT_EQ(5, container.countItem(itemid_2));
+
+	Item taken;
+	Container *inner = nullptr;
+	EXPECT_TRUE(container.TakeItemNr(3, taken, inner, 1));
+	EXPECT_EQ(4, container.countItem(itemid_2));
+
+	EXPECT_EQ(0, container.increaseAtPos(3, -4));
+	EXPECT_EQ(0, container.countItem(itemid_2));
+	EXPECT_TRUE(container.getItems().empty());
+}
+
 auto main(int argc, char **argv) -> int {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
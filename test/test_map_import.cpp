@@ -5,6 +5,7 @@
 #include <vector>
 #include <map>
 #include <sstream>
+#include <utility>
 
 class MockWorld : public World {
 public:
@@ -149,6 +150,34 @@ TEST_F(map_import_tests, importItems) {
     }
 }
 
+TEST_F(map_import_tests, fieldsAlongMatchesFieldAt) {
+    world.import();
+
+    const Coordinate length = 12;
+
+    for (const int16_t xStep : {1, -1}) {
+        const position start(xStep > 0 ? map_x - 2 : map_x + map_w + 1, map_y - 2, map_level);
+        std::vector<const map::Field *> fields(length);
+        world.fieldsAlong(start, xStep, length, fields.data());
+
+        for (Coordinate i = 0; i < length; ++i) {
+            const position pos(start.x + i * xStep, start.y + i, start.z);
+            const map::Field *expected = nullptr;
+
+            try {
+                expected = &std::as_const(world).fieldAt(pos);
+            } catch (FieldNotFound &) {
+            }
+
+            std::ostringstream trace;
+            trace << "step: " << xStep << ", i: " << i;
+            SCOPED_TRACE(trace.str());
+
+            EXPECT_EQ(expected, fields[i]);
+        }
+    }
+}
+
 auto main(int argc, char **argv) -> int {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
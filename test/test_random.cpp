@@ -1,6 +1,7 @@
 #include <gmock/gmock.h>
 #include "Random.hpp"
 #include <stdexcept>
+#include <thread>
 
 TEST(random_tests, uniform_invalid_range) {
     try {
@@ -16,6 +17,50 @@ TEST(random_tests, uniform_invalid_range) {
     }
 }
 
+TEST(random_tests, seed_repeats_numbers) {
+    Random::seed(42);
+    const auto first = Random::uniformBatch(1, 1000, 16);
+    Random::seed(42);
+    EXPECT_EQ(first, Random::uniformBatch(1, 1000, 16));
+}
+
+TEST(random_tests, threads_draw_from_distinct_streams) {
+    Random::seed(7);
+    const auto own = Random::uniformBatch(8);
+    std::vector<double> other;
+    std::thread([&other] { other = Random::uniformBatch(8); }).join();
+
+    Random::seed(7);
+    EXPECT_EQ(own, Random::uniformBatch(8));
+    EXPECT_NE(own, other);
+
+    std::vector<double> again;
+    std::thread([&again] { again = Random::uniformBatch(8); }).join();
+    EXPECT_EQ(other, again);
+}
+
+TEST(random_tests, split_streams_are_reproducible) {
+    Random::seed(3);
+    auto a = Random::split(1);
+    auto b = Random::split(1);
+    auto c = Random::split(2);
+    const auto number = a();
+    EXPECT_EQ(number, b());
+    EXPECT_NE(number, c());
+}
+
+TEST(random_tests, batch_stays_in_range) {
+    for (const auto number : Random::uniformBatch(-3, 3, 1000)) {
+        EXPECT_GE(number, -3);
+        EXPECT_LE(number, 3);
+    }
+
+    for (const auto number : Random::uniformBatch(1000)) {
+        EXPECT_GE(number, 0.0);
+        EXPECT_LT(number, 1.0);
+    }
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
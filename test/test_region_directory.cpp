@@ -0,0 +1,59 @@
+#include "map/Map.hpp"
+#include "map/RegionDirectory.hpp"
+
+#include <gtest/gtest.h>
+
+class region_directory_tests : public ::testing::Test {
+public:
+    region_directory_tests() {
+        directory.insert(first, 0);
+        directory.insert(second, 1);
+        directory.insert(negative, 2);
+    }
+
+    map::Map first{"first", position(0, 0, 0), 100, 50};
+    map::Map second{"second", position(100, 0, 0), 20, 20};
+    map::Map negative{"negative", position(-70, -10, 3), 30, 5};
+    map::RegionDirectory directory;
+};
+
+TEST_F(region_directory_tests, findsMapCoveringPosition) {
+    EXPECT_EQ(0, directory.find(position(0, 0, 0)));
+    EXPECT_EQ(0, directory.find(position(99, 49, 0)));
+    EXPECT_EQ(1, directory.find(position(100, 0, 0)));
+    EXPECT_EQ(1, directory.find(position(119, 19, 0)));
+    EXPECT_EQ(2, directory.find(position(-70, -10, 3)));
+    EXPECT_EQ(2, directory.find(position(-41, -6, 3)));
+}
+
+TEST_F(region_directory_tests, ignoresUncoveredPositions) {
+    EXPECT_FALSE(directory.find(position(120, 0, 0)));
+    EXPECT_FALSE(directory.find(position(100, 20, 0)));
+    EXPECT_FALSE(directory.find(position(0, 0, 1)));
+    EXPECT_FALSE(directory.find(position(-71, -10, 3)));
+    EXPECT_FALSE(directory.find(position(-40, -10, 3)));
+}
+
+TEST_F(region_directory_tests, marksChunksWithPersistentFields) {
+    directory.markPersistent(map::RegionDirectory::chunkKey(position(10, 10, 0)));
+    directory.markPersistent(map::RegionDirectory::chunkKey(position(500, 500, 0)));
+
+    const auto onMap = directory.lookUp(position(20, 20, 0));
+    EXPECT_EQ(0, onMap.index);
+    EXPECT_TRUE(onMap.mayBePersistent);
+    EXPECT_FALSE(directory.lookUp(position(99, 49, 0)).mayBePersistent);
+
+    const auto offMap = directory.lookUp(position(501, 501, 0));
+    EXPECT_FALSE(offMap.index);
+    EXPECT_TRUE(offMap.mayBePersistent);
+}
+
+TEST_F(region_directory_tests, clearRemovesAllMaps) {
+    directory.clear();
+    EXPECT_FALSE(directory.find(position(0, 0, 0)));
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,298 @@
+#!/usr/bin/env python3
+#  illarionserver - server for the game Illarion
+#  Copyright 2011 Illarion e.V.
+#
+#  This file is part of illarionserver.
+#
+#  illarionserver is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU Affero General Public License as published by
+#  the Free Software Foundation, either version 3 of the License, or
+#  (at your option) any later version.
+#
+#  illarionserver is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU Affero General Public License for more details.
+#
+#  You should have received a copy of the GNU Affero General Public License
+#  along with illarionserver.  If not, see <http://www.gnu.org/licenses/>.
+
+# Load generator for a test server: bots log in with the client protocol of
+# src/netinterface/protocol/ClientCommands.hpp and walk, turn, talk, look at and
+# use fields. It reports login, move acknowledge and map stripe latencies and
+# what the server sends. The accounts name-pattern.format(n) for n from 1 to
+# bots have to exist with the given password.
+#
+#   tools/load-generator.py --bots 2000 --ramp 100 --duration 300 --name 'bot{}' --password secret
+
+import argparse
+import asyncio
+import random
+import struct
+import time
+
+# client commands
+C_LOGIN_TS = 0x0D
+C_CHARMOVE_TS = 0x10
+C_PLAYERSPIN_TS = 0x11
+C_LOOKATMAPITEM_TS = 0xFF
+C_USE_TS = 0xFE
+C_SAY_TS = 0xF5
+C_LOGOUT_TS = 0xF1
+C_KEEPALIVE_TS = 0xD8
+
+# server commands
+SC_ID_TC = 0xCA
+SC_SETCOORDINATE_TC = 0xBD
+SC_MAPSTRIPE_TC = 0xA1
+SC_MOVEACK_TC = 0xDF
+SC_LOGOUT_TC = 0xCC
+
+NORMALMOVE = 0x0B
+UID_KOORD = 0x01
+HEADER_SIZE = 6
+# keep alive well within CLIENT_TIMEOUT of the server
+KEEPALIVE_INTERVAL = 10
+
+DIRECTIONS = [(0, -1), (1, -1), (1, 0), (1, 1), (0, 1), (-1, 1), (-1, 0), (-1, -1)]
+ACTIONS = ['walk', 'turn', 'talk', 'look', 'use']
+
+
+def command(definition, payload=b''):
+    checksum = sum(payload) % 0xFFFF
+    return struct.pack('>BBHH', definition, definition ^ 0xFF, len(payload), checksum) + payload
+
+
+def string(text):
+    data = text.encode('utf-8', 'replace')
+    return struct.pack('>H', len(data)) + data
+
+
+class Latencies:
+    def __init__(self):
+        self.samples = []
+
+    def add(self, seconds):
+        self.samples.append(seconds)
+
+    def summary(self):
+        if not self.samples:
+            return 'none'
+
+        ordered = sorted(self.samples)
+
+        def quantile(fraction):
+            return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))] * 1000
+
+        return 'n={} p50={:.1f}ms p90={:.1f}ms p99={:.1f}ms max={:.1f}ms'.format(
+            len(ordered), quantile(0.5), quantile(0.9), quantile(0.99), ordered[-1] * 1000)
+
+
+class Statistics:
+    def __init__(self):
+        self.connected = 0
+        self.online = 0
+        self.failed = 0
+        self.logouts = 0
+        self.login = Latencies()
+        self.move_ack = Latencies()
+        self.map_stripe = Latencies()
+        self.sent_commands = 0
+        self.received_commands = 0
+        self.received_bytes = 0
+        self.received_by_id = {}
+
+    def received(self, definition, length):
+        self.received_commands += 1
+        self.received_bytes += HEADER_SIZE + length
+        self.received_by_id[definition] = self.received_by_id.get(definition, 0) + 1
+
+
+class Bot:
+    def __init__(self, number, options, statistics):
+        self.name = options.name.format(number)
+        self.options = options
+        self.statistics = statistics
+        self.id = None
+        self.position = (0, 0, 0)
+        self.pending_moves = []
+        self.awaiting_stripe = None
+        self.logged_in = asyncio.Event()
+        self.running = True
+
+    async def run(self):
+        started = time.monotonic()
+
+        try:
+            reader, self.writer = await asyncio.open_connection(self.options.host, self.options.port)
+        except OSError:
+            self.statistics.failed += 1
+            return
+
+        self.statistics.connected += 1
+        receiving = asyncio.ensure_future(self.receive(reader))
+        self.send(C_LOGIN_TS, struct.pack('>B', self.options.client_version) + string(self.name) +
+                  string(self.options.password))
+
+        try:
+            await asyncio.wait_for(self.logged_in.wait(), self.options.login_timeout)
+            self.statistics.online += 1
+            self.statistics.login.add(time.monotonic() - started)
+            await self.act()
+        except asyncio.TimeoutError:
+            self.statistics.failed += 1
+        finally:
+            if self.running:
+                self.send(C_LOGOUT_TS)
+
+            self.running = False
+            receiving.cancel()
+            self.writer.close()
+
+    def send(self, definition, payload=b''):
+        self.writer.write(command(definition, payload))
+        self.statistics.sent_commands += 1
+
+    async def act(self):
+        end = time.monotonic() + self.options.duration
+        last_keep_alive = time.monotonic()
+        weights = [self.options.walk, self.options.turn, self.options.talk, self.options.look, self.options.use]
+
+        while self.running and time.monotonic() < end:
+            await asyncio.sleep(random.expovariate(1 / self.options.think))
+
+            if not self.running:
+                break
+
+            if time.monotonic() - last_keep_alive >= KEEPALIVE_INTERVAL:
+                last_keep_alive = time.monotonic()
+                self.send(C_KEEPALIVE_TS)
+
+            action = random.choices(ACTIONS, weights)[0]
+            direction = random.randrange(len(DIRECTIONS))
+            x, y, z = self.position
+            dx, dy = DIRECTIONS[direction]
+
+            if action == 'walk':
+                now = time.monotonic()
+                self.pending_moves.append(now)
+
+                if self.awaiting_stripe is None:
+                    self.awaiting_stripe = now
+
+                self.send(C_CHARMOVE_TS, struct.pack('>iBB', self.id, direction, NORMALMOVE))
+            elif action == 'turn':
+                self.send(C_PLAYERSPIN_TS, struct.pack('>B', direction))
+            elif action == 'talk':
+                self.send(C_SAY_TS, string('{} says hello'.format(self.name)))
+            elif action == 'look':
+                self.send(C_LOOKATMAPITEM_TS, struct.pack('>hhhB', x + dx, y + dy, z, 0))
+            else:
+                self.send(C_USE_TS, struct.pack('>Bhhh', UID_KOORD, x + dx, y + dy, z))
+
+            await self.writer.drain()
+
+    async def receive(self, reader):
+        try:
+            while True:
+                header = await reader.readexactly(HEADER_SIZE)
+                definition, check, length, _ = struct.unpack('>BBHH', header)
+
+                if definition ^ 0xFF != check:
+                    raise ConnectionError('bad header')
+
+                payload = await reader.readexactly(length)
+                self.statistics.received(definition, length)
+                self.handle(definition, payload)
+        except (asyncio.IncompleteReadError, ConnectionError):
+            if self.running:
+                self.statistics.logouts += 1
+
+            self.running = False
+            self.logged_in.set()
+
+    def handle(self, definition, payload):
+        now = time.monotonic()
+
+        if definition == SC_ID_TC:
+            self.id = struct.unpack('>i', payload[:4])[0]
+        elif definition == SC_SETCOORDINATE_TC:
+            self.position = struct.unpack('>hhh', payload[:6])
+
+            if self.id is not None:
+                self.logged_in.set()
+        elif definition == SC_MOVEACK_TC:
+            character_id, x, y, z = struct.unpack('>ihhh', payload[:10])
+
+            if character_id == self.id:
+                self.position = (x, y, z)
+
+                if self.pending_moves:
+                    self.statistics.move_ack.add(now - self.pending_moves.pop(0))
+        elif definition == SC_MAPSTRIPE_TC:
+            if self.awaiting_stripe is not None:
+                self.statistics.map_stripe.add(now - self.awaiting_stripe)
+                self.awaiting_stripe = None
+        elif definition == SC_LOGOUT_TC:
+            self.running = False
+            self.statistics.logouts += 1
+
+
+def report(statistics, elapsed):
+    print('{:.0f}s: {} connected, {} online, {} failed, {} logged out'.format(
+        elapsed, statistics.connected, statistics.online, statistics.failed, statistics.logouts))
+    print('  login      {}'.format(statistics.login.summary()))
+    print('  move ack   {}'.format(statistics.move_ack.summary()))
+    print('  map stripe {}'.format(statistics.map_stripe.summary()))
+
+    if elapsed > 0:
+        print('  sent {:.0f} commands/s, received {:.0f} commands/s and {:.1f} kB/s'.format(
+            statistics.sent_commands / elapsed, statistics.received_commands / elapsed,
+            statistics.received_bytes / elapsed / 1024))
+
+
+async def main(options):
+    statistics = Statistics()
+    started = time.monotonic()
+    bots = []
+
+    async def reporter():
+        while True:
+            await asyncio.sleep(options.report)
+            report(statistics, time.monotonic() - started)
+
+    reporting = asyncio.ensure_future(reporter())
+
+    for number in range(1, options.bots + 1):
+        bots.append(asyncio.ensure_future(Bot(number, options, statistics).run()))
+        await asyncio.sleep(1 / options.ramp)
+
+    await asyncio.gather(*bots)
+    reporting.cancel()
+    report(statistics, time.monotonic() - started)
+
+    print('  received commands by id:')
+
+    for definition, count in sorted(statistics.received_by_id.items(), key=lambda item: -item[1]):
+        print('    0x{:02X} {}'.format(definition, count))
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='Connects scripted bots to an Illarion test server.')
+    parser.add_argument('--host', default='localhost')
+    parser.add_argument('--port', type=int, default=3012)
+    parser.add_argument('--bots', type=int, default=100, help='number of connections')
+    parser.add_argument('--ramp', type=float, default=50, help='new connections per second')
+    parser.add_argument('--duration', type=float, default=60, help='seconds each bot acts after its login')
+    parser.add_argument('--name', default='bot{}', help='account names, {} is replaced by the bot number')
+    parser.add_argument('--password', default='')
+    parser.add_argument('--client-version', type=int, default=122)
+    parser.add_argument('--login-timeout', type=float, default=30)
+    parser.add_argument('--think', type=float, default=0.5, help='mean seconds between two actions of a bot')
+    parser.add_argument('--report', type=float, default=10, help='seconds between reports')
+    parser.add_argument('--walk', type=float, default=6, help='weight of walking among the actions')
+    parser.add_argument('--turn', type=float, default=1)
+    parser.add_argument('--talk', type=float, default=1)
+    parser.add_argument('--look', type=float, default=1)
+    parser.add_argument('--use', type=float, default=1)
+    asyncio.get_event_loop().run_until_complete(main(parser.parse_args()))